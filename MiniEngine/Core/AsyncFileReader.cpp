@@ -0,0 +1,291 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+
+#include "AsyncFileReader.h"
+#include "FileNameEncoding.h"
+#include "IOThreadPool.h"
+#include "MappedFile.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <utility>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace Utility
+{
+    namespace
+    {
+        // Unbuffered reads need buffers, offsets and sizes aligned to the sector size of the device, which no
+        // common device exceeds.
+        const size_t kSectorAlignment = 4096;
+
+        // Size of one unbuffered read.  Large enough to keep a device busy, small enough to stop at a read error
+        // before the whole file has been requested.
+        const size_t kUnbufferedChunkSize = 8 * 1024 * 1024;
+
+        size_t AlignUp(size_t size)
+        {
+            return (size + kSectorAlignment - 1) / kSectorAlignment * kSectorAlignment;
+        }
+
+        FileBuffer ReadMapped(const std::string& fileName)
+        {
+            std::shared_ptr<MappedFile> file = std::make_shared<MappedFile>();
+            if (!file->Open(fileName) || file->GetSize() == 0)
+                return FileBuffer();
+
+            // The read itself happens as the OS pages the file in, so ask for all of it now rather than at the
+            // first touch of each page.
+            file->Prefetch(0, file->GetSize());
+            const size_t size = file->GetSize();
+            return FileBuffer(std::shared_ptr<const uint8_t>(file, file->GetData()), size);
+        }
+
+        FileBuffer ReadBuffered(const std::string& fileName)
+        {
+            FileData data = IOThreadPool::ReadFile(fileName);
+            if (data->empty())
+                return FileBuffer();
+
+            const size_t size = data->size();
+            return FileBuffer(std::shared_ptr<const uint8_t>(data, data->data()), size);
+        }
+
+#ifdef _WIN32
+
+        FileBuffer ReadUnbuffered(const std::string& fileName)
+        {
+            // The flags are fixed at open, so the size has to come first.  It is one metadata query, without a
+            // handle.
+            uint64_t fileSize = 0;
+            if (!QueryFileSize(fileName, fileSize) || fileSize < kMinUnbufferedSize)
+                return ReadBuffered(fileName);
+
+            HANDLE file = CreateFileW(ToWideFileName(fileName).c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                FILE_FLAG_NO_BUFFERING | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+            if (file == INVALID_HANDLE_VALUE)
+                return ReadBuffered(fileName);
+
+            // VirtualAlloc() returns pages, which are aligned to any sector size.  The last read asks for a whole
+            // sector and gets the bytes up to the end of the file.
+            const size_t size = (size_t)fileSize;
+            uint8_t* buffer = (uint8_t*)VirtualAlloc(nullptr, AlignUp(size), MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+            if (buffer == nullptr)
+            {
+                CloseHandle(file);
+                return FileBuffer();
+            }
+            std::shared_ptr<const uint8_t> data(buffer, [](const uint8_t* p) { VirtualFree((void*)p, 0, MEM_RELEASE); });
+
+            size_t offset = 0;
+            DWORD bytesRead = 0;
+            while (offset < size &&
+                ::ReadFile(file, buffer + offset, (DWORD)std::min(AlignUp(size - offset), kUnbufferedChunkSize), &bytesRead, nullptr) && bytesRead > 0)
+            {
+                offset += bytesRead;
+            }
+            CloseHandle(file);
+
+            return offset >= size ? FileBuffer(std::move(data), size) : FileBuffer();
+        }
+
+#else
+
+        FileBuffer ReadUnbuffered(const std::string& fileName)
+        {
+            const int file = open(fileName.c_str(), O_RDONLY | O_CLOEXEC);
+            if (file < 0)
+                return FileBuffer();
+
+            struct stat fileStat = {};
+            if (fstat(file, &fileStat) != 0 || fileStat.st_size == 0)
+            {
+                close(file);
+                return FileBuffer();
+            }
+
+            const size_t size = (size_t)fileStat.st_size;
+            if (size < kMinUnbufferedSize)
+            {
+                close(file);
+                return ReadBuffered(fileName);
+            }
+
+            // Linux takes O_DIRECT on an open file.  File systems without direct I/O refuse it, here or at the first
+            // read, and then the file is read through the cache into the same buffer.
+            bool isDirect = false;
+#ifdef O_DIRECT
+            const int flags = fcntl(file, F_GETFL);
+            isDirect = flags != -1 && fcntl(file, F_SETFL, flags | O_DIRECT) == 0;
+#endif
+            if (!isDirect)
+                posix_fadvise(file, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+            void* buffer = nullptr;
+            if (posix_memalign(&buffer, kSectorAlignment, AlignUp(size)) != 0)
+            {
+                close(file);
+                return FileBuffer();
+            }
+            std::shared_ptr<const uint8_t> data((const uint8_t*)buffer, [](const uint8_t* p) { std::free((void*)p); });
+
+            size_t offset = 0;
+            while (offset < size)
+            {
+                // The last direct read asks for a whole sector and gets the bytes up to the end of the file.
+                const size_t readSize = isDirect ? std::min(AlignUp(size - offset), kUnbufferedChunkSize) : size - offset;
+                const ssize_t bytesRead = read(file, (uint8_t*)buffer + offset, readSize);
+                if (bytesRead < 0 && errno == EINTR)
+                    continue;
+#ifdef O_DIRECT
+                if (bytesRead < 0 && errno == EINVAL && isDirect)
+                {
+                    isDirect = false;
+                    fcntl(file, F_SETFL, fcntl(file, F_GETFL) & ~O_DIRECT);
+                    continue;
+                }
+#endif
+                if (bytesRead <= 0)
+                    break;
+                offset += (size_t)bytesRead;
+
+                // A direct read ends short only at the end of the file.  Any other short read leaves an unaligned
+                // offset, from which the rest has to go through the cache.
+                if (isDirect && offset % kSectorAlignment != 0 && offset < size)
+                {
+                    isDirect = false;
+                    fcntl(file, F_SETFL, fcntl(file, F_GETFL) & ~O_DIRECT);
+                }
+            }
+            close(file);
+
+            return offset >= size ? FileBuffer(std::move(data), size) : FileBuffer();
+        }
+
+#endif
+
+    } // namespace
+
+    FileBuffer ReadFileContents(const std::string& fileName, FileReadMode mode)
+    {
+        switch (mode)
+        {
+        case FileReadMode::kUnbuffered: return ReadUnbuffered(fileName);
+        case FileReadMode::kMapped: return ReadMapped(fileName);
+        default: return ReadBuffered(fileName);
+        }
+    }
+
+#ifdef _WIN32
+
+    bool QueryFileSize(const std::string& fileName, uint64_t& size)
+    {
+        WIN32_FILE_ATTRIBUTE_DATA attributes = {};
+        if (!GetFileAttributesExW(ToWideFileName(fileName).c_str(), GetFileExInfoStandard, &attributes))
+            return false;
+
+        size = ((uint64_t)attributes.nFileSizeHigh << 32) | attributes.nFileSizeLow;
+        return true;
+    }
+
+#else
+
+    bool QueryFileSize(const std::string& fileName, uint64_t& size)
+    {
+        struct stat fileStat = {};
+        if (stat(fileName.c_str(), &fileStat) != 0)
+            return false;
+
+        size = (uint64_t)fileStat.st_size;
+        return true;
+    }
+
+#endif
+
+    AsyncFileReader::AsyncFileReader(uint32_t threadCount)
+    {
+        threadCount = std::max(threadCount, 1u);
+        m_Threads.reserve(threadCount);
+        for (uint32_t i = 0; i < threadCount; ++i)
+            m_Threads.emplace_back([this] { WorkerMain(); });
+    }
+
+    AsyncFileReader::~AsyncFileReader()
+    {
+        {
+            std::lock_guard<std::mutex> guard(m_Mutex);
+            m_Stop = true;
+        }
+        m_WakeUp.notify_all();
+
+        for (std::thread& thread : m_Threads)
+            thread.join();
+    }
+
+    std::vector<std::shared_future<FileBuffer>> AsyncFileReader::Submit(const FileReadRequest* requests, size_t requestCount)
+    {
+        std::vector<std::unique_ptr<Request>> batch;
+        std::vector<std::shared_future<FileBuffer>> results;
+        batch.reserve(requestCount);
+        results.reserve(requestCount);
+        for (size_t i = 0; i < requestCount; ++i)
+        {
+            batch.emplace_back(new Request{ requests[i], {} });
+            results.push_back(batch.back()->Promise.get_future().share());
+        }
+
+        {
+            std::lock_guard<std::mutex> guard(m_Mutex);
+            for (std::unique_ptr<Request>& request : batch)
+                m_Requests.push_back(std::move(request));
+        }
+
+        if (requestCount == 1)
+            m_WakeUp.notify_one();
+        else if (requestCount > 1)
+            m_WakeUp.notify_all();
+        return results;
+    }
+
+    std::shared_future<FileBuffer> AsyncFileReader::Read(const std::string& fileName, FileReadMode mode)
+    {
+        const FileReadRequest request = { fileName, mode };
+        return Submit(&request, 1).front();
+    }
+
+    void AsyncFileReader::WorkerMain()
+    {
+        for (;;)
+        {
+            std::unique_ptr<Request> request;
+            {
+                std::unique_lock<std::mutex> lock(m_Mutex);
+                m_WakeUp.wait(lock, [this] { return m_Stop || !m_Requests.empty(); });
+                if (m_Requests.empty())
+                    return;
+
+                request = std::move(m_Requests.front());
+                m_Requests.pop_front();
+            }
+
+            request->Promise.set_value(ReadFileContents(request->Read.FileName, request->Read.Mode));
+        }
+    }
+
+} // namespace Utility
@@ -0,0 +1,108 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+
+#pragma once
+
+// Portable asynchronous file reads.  A pool of threads serves batches of requests, and each request picks how its
+// file reaches memory: through the OS file cache, around it for large files, or mapped with no copy at all.
+// This header does not depend on pch.h so that it can be shared with portable (non-D3D12) tools.
+// It sticks to C++14 like the rest of Core.
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace Utility
+{
+    enum class FileReadMode
+    {
+        kBuffered,      // Read through the OS file cache into the heap, as IOThreadPool::ReadFile()
+        kUnbuffered,    // Read files of at least kMinUnbufferedSize around the file cache (O_DIRECT, FILE_FLAG_NO_BUFFERING)
+        kMapped,        // Map the file and hint the OS to read it ahead.  Nothing is copied.
+    };
+
+    // Smaller files are read through the file cache even with kUnbuffered.  Bypassing the cache costs a synchronous
+    // device round trip per read and the OS read-ahead, which only pays off for large sequential reads.
+    static const size_t kMinUnbufferedSize = 1024 * 1024;
+
+    // The contents of a file, which own whatever holds them: a heap buffer, an aligned buffer or a file mapping.
+    // Copies share the contents.  Empty if the file cannot be read.
+    class FileBuffer
+    {
+    public:
+        FileBuffer() = default;
+        FileBuffer(std::shared_ptr<const uint8_t> data, size_t size) : m_Data(std::move(data)), m_Size(size) {}
+
+        const uint8_t* GetData() const { return m_Data.get(); }
+        size_t GetSize() const { return m_Size; }
+        bool IsEmpty() const { return m_Size == 0; }
+
+        // Keeps the contents alive as long as the returned pointer, for handing them over without a copy
+        const std::shared_ptr<const uint8_t>& GetOwner() const { return m_Data; }
+
+    private:
+        std::shared_ptr<const uint8_t> m_Data;
+        size_t m_Size = 0;
+    };
+
+    // Blocking read on the calling thread.  fileName is UTF-8.
+    FileBuffer ReadFileContents(const std::string& fileName, FileReadMode mode = FileReadMode::kBuffered);
+
+    // The size of a file without opening it.  fileName is UTF-8.  Returns false if the file does not exist.
+    bool QueryFileSize(const std::string& fileName, uint64_t& size);
+
+    struct FileReadRequest
+    {
+        std::string FileName;   // UTF-8
+        FileReadMode Mode;
+    };
+
+    // Threads that serve file reads in the order of submission.  Unlike IOThreadPool, which reads whole files ahead
+    // for the texture loader, it takes batches: Submit() queues a batch under one lock and wakes every thread once,
+    // so that loading many small files does not pay a lock and a wake-up per file.
+    class AsyncFileReader
+    {
+    public:
+        explicit AsyncFileReader(uint32_t threadCount = 4);
+
+        // Finishes the requests that have been submitted.
+        ~AsyncFileReader();
+
+        AsyncFileReader(const AsyncFileReader&) = delete;
+        AsyncFileReader& operator=(const AsyncFileReader&) = delete;
+
+        // Safe to call from any thread.  Returns one future per request, in order.
+        std::vector<std::shared_future<FileBuffer>> Submit(const FileReadRequest* requests, size_t requestCount);
+        std::shared_future<FileBuffer> Read(const std::string& fileName, FileReadMode mode = FileReadMode::kBuffered);
+
+        uint32_t GetThreadCount() const { return (uint32_t)m_Threads.size(); }
+
+    private:
+        struct Request
+        {
+            FileReadRequest Read;
+            std::promise<FileBuffer> Promise;
+        };
+
+        void WorkerMain();
+
+        std::mutex m_Mutex;
+        std::condition_variable m_WakeUp;
+        std::deque<std::unique_ptr<Request>> m_Requests;
+        bool m_Stop = false;
+        std::vector<std::thread> m_Threads;
+    };
+
+} // namespace Utility
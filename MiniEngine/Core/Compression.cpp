@@ -0,0 +1,304 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+
+#include "Compression.h"
+#include "MappedFile.h"
+
+#include <zlib.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace Utility
+{
+    namespace
+    {
+        // A member: the 10-byte gzip header with FEXTRA set, the extra field, raw deflate data, then the CRC-32 and
+        // the size of the chunk.  The extra field holds one subfield "ME" of 16 bytes: the size of the whole member,
+        // the chunk size, and the total size of the file.  Every chunk but the last is ChunkSize bytes.
+        const uint8_t kGzipMagic[2] = { 0x1F, 0x8B };
+        const uint8_t kDeflate = 8;
+        const uint8_t kFlagExtra = 4;
+        const uint8_t kUnknownOS = 255;
+        const size_t kHeaderSize = 32;
+        const size_t kTrailerSize = 8;
+        const uint16_t kExtraSize = 20;
+        const uint16_t kSubfieldSize = 16;
+
+        // Deflate never expands data more than this, so sizes read from a file that claim more are corrupt.
+        const uint64_t kMaxDeflateRatio = 1032;
+
+        struct MemberHeader
+        {
+            uint32_t MemberSize;
+            uint32_t ChunkSize;
+            uint64_t TotalSize;
+        };
+
+        uint32_t ReadLE32(const uint8_t* p)
+        {
+            return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+        }
+
+        void WriteLE32(uint8_t* p, uint32_t value)
+        {
+            for (int i = 0; i < 4; ++i)
+                p[i] = (uint8_t)(value >> (i * 8));
+        }
+
+        void WriteHeader(uint8_t* p, const MemberHeader& header)
+        {
+            const uint8_t fixed[16] = { kGzipMagic[0], kGzipMagic[1], kDeflate, kFlagExtra, 0, 0, 0, 0, 0, kUnknownOS,
+                (uint8_t)kExtraSize, 0, 'M', 'E', (uint8_t)kSubfieldSize, 0 };
+            std::memcpy(p, fixed, sizeof(fixed));
+            WriteLE32(p + 16, header.MemberSize);
+            WriteLE32(p + 20, header.ChunkSize);
+            WriteLE32(p + 24, (uint32_t)header.TotalSize);
+            WriteLE32(p + 28, (uint32_t)(header.TotalSize >> 32));
+        }
+
+        // Reads the header of the member at offset.  Returns false if it is not a member of the chunked format.
+        bool ReadHeader(const uint8_t* data, size_t size, size_t offset, MemberHeader& header)
+        {
+            if (size - offset < kHeaderSize + kTrailerSize)
+                return false;
+
+            const uint8_t* p = data + offset;
+            if (p[0] != kGzipMagic[0] || p[1] != kGzipMagic[1] || p[2] != kDeflate || p[3] != kFlagExtra ||
+                p[10] != kExtraSize || p[11] != 0 || p[12] != 'M' || p[13] != 'E' || p[14] != kSubfieldSize || p[15] != 0)
+                return false;
+
+            header.MemberSize = ReadLE32(p + 16);
+            header.ChunkSize = ReadLE32(p + 20);
+            header.TotalSize = ReadLE32(p + 24) | (uint64_t)ReadLE32(p + 28) << 32;
+            return header.MemberSize >= kHeaderSize + kTrailerSize && header.MemberSize <= size - offset && header.ChunkSize > 0;
+        }
+
+        uint32_t GetThreadCount(uint32_t threadCount, uint64_t chunkCount)
+        {
+            if (threadCount == 0)
+                threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+            return (uint32_t)std::max<uint64_t>(std::min<uint64_t>(threadCount, chunkCount), 1);
+        }
+
+        // Runs function on threadCount threads, the calling thread being one of them.
+        template <typename Function>
+        void RunOnThreads(uint32_t threadCount, const Function& function)
+        {
+            std::vector<std::thread> threads;
+            for (uint32_t i = 1; i < threadCount; ++i)
+                threads.emplace_back(function);
+
+            function();
+
+            for (std::thread& thread : threads)
+                thread.join();
+        }
+
+        // Any gzip or zlib stream, on the calling thread.  Concatenated gzip members are read one after another as
+        // gzip does.
+        FileData InflateStream(const uint8_t* data, size_t size)
+        {
+            FileData output = std::make_shared<std::vector<uint8_t>>();
+            if (size == 0)
+                return output;
+
+            z_stream stream = {};
+            if (inflateInit2(&stream, 15 + 32) != Z_OK)  // 15 window bits, and +32 detects gzip or zlib headers
+                return output;
+
+            // A gzip file ends with the size of its last member, which is all of it for the usual single member.  It
+            // is only a hint, and one that the input could not inflate to is ignored.
+            size_t capacity = size * 4;
+            if (size >= 18 && data[0] == kGzipMagic[0] && data[1] == kGzipMagic[1])
+                capacity = (size_t)std::min<uint64_t>(std::max<uint32_t>(ReadLE32(data + size - 4), 1), size * kMaxDeflateRatio);
+            output->resize(capacity);
+
+            size_t inputOffset = 0;
+            size_t outputOffset = 0;
+            int result = Z_OK;
+            for (;;)
+            {
+                if (outputOffset == output->size())
+                    output->resize(std::max<size_t>(output->size() * 2, 4096));
+
+                // avail_in and avail_out are 32 bits wide.
+                stream.next_in = const_cast<uint8_t*>(data) + inputOffset;
+                stream.avail_in = (uInt)std::min<size_t>(size - inputOffset, 1u << 30);
+                stream.next_out = output->data() + outputOffset;
+                stream.avail_out = (uInt)std::min<size_t>(output->size() - outputOffset, 1u << 30);
+                const uInt availIn = stream.avail_in;
+                const uInt availOut = stream.avail_out;
+
+                result = inflate(&stream, Z_NO_FLUSH);
+                inputOffset += availIn - stream.avail_in;
+                outputOffset += availOut - stream.avail_out;
+
+                if (result == Z_STREAM_END)
+                {
+                    if (size - inputOffset < 2 || data[inputOffset] != kGzipMagic[0] || data[inputOffset + 1] != kGzipMagic[1])
+                        break;
+                    inflateReset(&stream);
+                }
+                else if (result != Z_OK && !(result == Z_BUF_ERROR && stream.avail_out == 0))
+                {
+                    break;
+                }
+            }
+            inflateEnd(&stream);
+
+            output->resize(result == Z_STREAM_END ? outputOffset : 0);
+            return output;
+        }
+
+    } // namespace
+
+    FileData CompressChunked(const uint8_t* data, size_t size, const CompressionOptions& options)
+    {
+        const uint32_t chunkSize = std::max(options.ChunkSize, 1u);
+        const size_t chunkCount = std::max<size_t>((size + chunkSize - 1) / chunkSize, 1);
+        std::vector<std::vector<uint8_t>> members(chunkCount);
+
+        std::atomic<size_t> nextChunk(0);
+        std::atomic<bool> failed(false);
+        RunOnThreads(GetThreadCount(options.ThreadCount, chunkCount), [&]()
+        {
+            z_stream stream = {};
+            if (deflateInit2(&stream, options.Level, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+            {
+                failed = true;
+                return;
+            }
+
+            for (size_t chunk = nextChunk++; chunk < chunkCount && !failed; chunk = nextChunk++)
+            {
+                const uint8_t* chunkData = data + chunk * chunkSize;
+                const uInt chunkBytes = (uInt)std::min<size_t>(size - chunk * chunkSize, chunkSize);
+
+                std::vector<uint8_t>& member = members[chunk];
+                member.resize(kHeaderSize + deflateBound(&stream, chunkBytes) + kTrailerSize);
+
+                deflateReset(&stream);
+                stream.next_in = const_cast<uint8_t*>(chunkData);
+                stream.avail_in = chunkBytes;
+                stream.next_out = member.data() + kHeaderSize;
+                stream.avail_out = (uInt)(member.size() - kHeaderSize - kTrailerSize);
+                if (deflate(&stream, Z_FINISH) != Z_STREAM_END)
+                {
+                    failed = true;
+                    break;
+                }
+
+                member.resize(kHeaderSize + stream.total_out + kTrailerSize);
+                WriteHeader(member.data(), { (uint32_t)member.size(), chunkSize, (uint64_t)size });
+                WriteLE32(member.data() + member.size() - 8, (uint32_t)crc32(0, chunkData, chunkBytes));
+                WriteLE32(member.data() + member.size() - 4, chunkBytes);
+            }
+            deflateEnd(&stream);
+        });
+
+        FileData output = std::make_shared<std::vector<uint8_t>>();
+        if (failed)
+            return output;
+
+        size_t outputSize = 0;
+        for (const std::vector<uint8_t>& member : members)
+            outputSize += member.size();
+
+        output->reserve(outputSize);
+        for (const std::vector<uint8_t>& member : members)
+            output->insert(output->end(), member.begin(), member.end());
+        return output;
+    }
+
+    FileData Decompress(const uint8_t* data, size_t size, uint32_t threadCount)
+    {
+        MemberHeader first;
+        if (!ReadHeader(data, size, 0, first))
+            return InflateStream(data, size);
+
+        // The sizes come from the file, so the members are walked before anything is allocated.  There must be one
+        // per chunk, the last one ending at the end of the input, and they cannot inflate to more than
+        // kMaxDeflateRatio times their deflate data.
+        // Member i spans memberOffsets[i] to memberOffsets[i + 1].
+        const uint64_t chunkCount = std::max<uint64_t>(first.TotalSize / first.ChunkSize + (first.TotalSize % first.ChunkSize != 0), 1);
+        std::vector<size_t> memberOffsets(1, 0);
+        uint64_t deflatedSize = 0;
+        while (memberOffsets.back() != size)
+        {
+            MemberHeader header;
+            if (memberOffsets.size() > chunkCount || !ReadHeader(data, size, memberOffsets.back(), header) ||
+                header.ChunkSize != first.ChunkSize || header.TotalSize != first.TotalSize)
+            {
+                return std::make_shared<std::vector<uint8_t>>();
+            }
+            deflatedSize += header.MemberSize - kHeaderSize - kTrailerSize;
+            memberOffsets.push_back(memberOffsets.back() + header.MemberSize);
+        }
+        if (memberOffsets.size() != chunkCount + 1 || first.TotalSize > deflatedSize * kMaxDeflateRatio)
+            return std::make_shared<std::vector<uint8_t>>();
+
+        FileData output = std::make_shared<std::vector<uint8_t>>((size_t)first.TotalSize);
+
+        // The chunks are claimed in order from a shared counter and inflated in place.
+        std::atomic<uint64_t> nextChunk(0);
+        std::atomic<bool> failed(false);
+
+        RunOnThreads(GetThreadCount(threadCount, chunkCount), [&]()
+        {
+            z_stream stream = {};
+            if (inflateInit2(&stream, -15) != Z_OK)
+            {
+                failed = true;
+                return;
+            }
+
+            for (uint64_t chunk = nextChunk++; chunk < chunkCount && !failed; chunk = nextChunk++)
+            {
+                const size_t offset = memberOffsets[(size_t)chunk];
+                const size_t memberSize = memberOffsets[(size_t)chunk + 1] - offset;
+                uint8_t* chunkData = output->data() + chunk * first.ChunkSize;
+                const uInt chunkBytes = (uInt)std::min<uint64_t>(first.TotalSize - chunk * first.ChunkSize, first.ChunkSize);
+                const uint8_t* trailer = data + offset + memberSize - kTrailerSize;
+
+                inflateReset(&stream);
+                stream.next_in = const_cast<uint8_t*>(data + offset + kHeaderSize);
+                stream.avail_in = (uInt)(memberSize - kHeaderSize - kTrailerSize);
+                stream.next_out = chunkData;
+                stream.avail_out = chunkBytes;
+                if (inflate(&stream, Z_FINISH) != Z_STREAM_END || stream.avail_out != 0 ||
+                    ReadLE32(trailer + 4) != chunkBytes || ReadLE32(trailer) != (uint32_t)crc32(0, chunkData, chunkBytes))
+                {
+                    failed = true;
+                }
+            }
+            inflateEnd(&stream);
+        });
+
+        if (failed)
+            output->clear();
+        return output;
+    }
+
+    FileData ReadCompressedFile(const std::string& fileName, uint32_t threadCount)
+    {
+        MappedFile file;
+        if (!file.Open(fileName) || file.GetSize() == 0)
+            return std::make_shared<std::vector<uint8_t>>();
+
+        // The hint lets the OS read ahead of the threads, which fault in the members they inflate.
+        file.Prefetch(0, file.GetSize());
+        return Decompress(file.GetData(), file.GetSize(), threadCount);
+    }
+
+} // namespace Utility
@@ -0,0 +1,49 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+
+#pragma once
+
+// Compressed files that decompress in parallel.  A file is cut into chunks that are compressed independently, each
+// as a member of a gzip file, so gzip and zlib still read it as one stream.  Every member carries an extra field with
+// its compressed size, the chunk size and the total size, so the members can be found one after another without
+// inflating them and each chunk decompresses into its own place of the output on its own thread.  Plain gzip files
+// are read as one stream.
+// This header does not depend on pch.h so that it can be shared with portable (non-D3D12) tools.
+// It sticks to C++14 like the rest of Core.
+#include "IOThreadPool.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace Utility
+{
+    // Large enough that each member costs little in ratio and header, small enough that a texture splits into a
+    // few chunks to spread over the threads.
+    static const uint32_t kDefaultCompressionChunkSize = 256 * 1024;
+
+    struct CompressionOptions
+    {
+        uint32_t ChunkSize = kDefaultCompressionChunkSize;
+        int Level = 6;              // zlib level, from 1 (fastest) to 9 (smallest)
+        uint32_t ThreadCount = 0;   // 0 for one per core
+    };
+
+    // Compresses data into the chunked gzip format.  Returns empty data if zlib fails.
+    FileData CompressChunked(const uint8_t* data, size_t size, const CompressionOptions& options = CompressionOptions());
+
+    // Decompresses a chunked gzip file on threadCount threads (0 for one per core), or any other gzip or zlib stream
+    // on the calling thread.  Returns empty data if the data is corrupt or a checksum does not match.
+    FileData Decompress(const uint8_t* data, size_t size, uint32_t threadCount = 0);
+
+    // Decompress() of a mapped file.  The threads fault in the pages of their own chunks, so decompression begins
+    // with the first chunk rather than after the whole file has been read.  fileName is UTF-8.
+    FileData ReadCompressedFile(const std::string& fileName, uint32_t threadCount = 0);
+
+} // namespace Utility
@@ -0,0 +1,208 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+
+#pragma once
+
+// This header does not depend on pch.h so that it can be shared with portable (non-D3D12) tools.
+// It sticks to C++14 like the rest of Core.
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace Utility
+{
+    // A map for lookups that almost always hit, such as the caches of pipeline states and root signatures.  Find()
+    // takes no lock: it probes an open-addressed table of pointers to immutable nodes.  Inserts lock one of
+    // kStripeCount mutexes, chosen by the hash, so that inserts of different keys rarely wait for each other and an
+    // insert never blocks a lookup.  Nothing is erased but by Clear(), so a value stays where it is until then and
+    // the references handed out stay valid.  A full table is replaced by one twice its size under every stripe;
+    // lookups that still read the old one find every key that was there, and the old table is freed by Clear().
+    template <typename Key, typename Value, typename Hasher = std::hash<Key>>
+    class ConcurrentHashMap
+    {
+    public:
+        static const uint32_t kStripeCount = 64;
+
+        // At most kStripeCount inserts run at once, so a table under half full can take them all before it grows.
+        static const size_t kMinCapacity = 4 * kStripeCount;
+
+        explicit ConcurrentHashMap(size_t capacity = kMinCapacity)
+        {
+            size_t roundedCapacity = kMinCapacity;
+            while (roundedCapacity < capacity)
+                roundedCapacity *= 2;
+
+            m_Tables.emplace_back(new Table(roundedCapacity));
+            m_Table.store(m_Tables.back().get(), std::memory_order_release);
+        }
+
+        ~ConcurrentHashMap()
+        {
+            DeleteNodes();
+        }
+
+        ConcurrentHashMap(const ConcurrentHashMap&) = delete;
+        ConcurrentHashMap& operator=(const ConcurrentHashMap&) = delete;
+
+        // The value of key, or nullptr.  Lock-free; a key that another thread is inserting meanwhile may or may not
+        // be found.
+        Value* Find(const Key& key)
+        {
+            const uint64_t hash = GetHash(key);
+            Node* node = FindNode(*m_Table.load(std::memory_order_acquire), hash, key);
+            return node != nullptr ? &node->NodeValue : nullptr;
+        }
+
+        // The value of key and false, or, if there is none, Value(args...) and true.  The value is constructed under
+        // the lock of the key's stripe, so it should be cheap: something slow to make, such as a pipeline state,
+        // should be inserted empty and made after this returns (see DeviceObjectCache).
+        template <typename... Args>
+        std::pair<Value*, bool> FindOrEmplace(const Key& key, Args&&... args)
+        {
+            const uint64_t hash = GetHash(key);
+            if (Node* node = FindNode(*m_Table.load(std::memory_order_acquire), hash, key))
+                return std::make_pair(&node->NodeValue, false);
+
+            for (;;)
+            {
+                Table* table;
+                {
+                    std::lock_guard<std::mutex> guard(m_Stripes[hash >> 58]);
+
+                    // The table cannot be replaced while a stripe is held, and equal keys share a stripe, so a key
+                    // that is not found now is not inserted by anybody else until this returns.
+                    table = m_Table.load(std::memory_order_acquire);
+                    if (Node* node = FindNode(*table, hash, key))
+                        return std::make_pair(&node->NodeValue, false);
+
+                    if ((m_Size.load(std::memory_order_relaxed) + 1) * 2 <= table->Capacity)
+                    {
+                        Node* node = new Node(hash, key, std::forward<Args>(args)...);
+                        InsertNode(*table, node);
+                        m_Size.fetch_add(1, std::memory_order_relaxed);
+                        return std::make_pair(&node->NodeValue, true);
+                    }
+                }
+                Grow(table);
+            }
+        }
+
+        // Deletes every value.  It must not run at the same time as anything else.
+        void Clear()
+        {
+            DeleteNodes();
+            m_Tables.erase(m_Tables.begin(), m_Tables.end() - 1);
+            Table& table = *m_Tables.back();
+            for (size_t i = 0; i < table.Capacity; ++i)
+                table.Slots[i].store(nullptr, std::memory_order_relaxed);
+            m_Size.store(0, std::memory_order_release);
+        }
+
+        size_t GetSize() const
+        {
+            return m_Size.load(std::memory_order_acquire);
+        }
+
+    private:
+        struct Node
+        {
+            template <typename... Args>
+            Node(uint64_t hash, const Key& key, Args&&... args)
+                : Hash(hash), NodeKey(key), NodeValue(std::forward<Args>(args)...) {}
+
+            const uint64_t Hash;
+            const Key NodeKey;
+            Value NodeValue;
+        };
+
+        struct Table
+        {
+            explicit Table(size_t capacity) : Capacity(capacity), Slots(new std::atomic<Node*>[capacity])
+            {
+                for (size_t i = 0; i < capacity; ++i)
+                    Slots[i].store(nullptr, std::memory_order_relaxed);
+            }
+
+            const size_t Capacity;
+            std::unique_ptr<std::atomic<Node*>[]> Slots;
+        };
+
+        static uint64_t GetHash(const Key& key)
+        {
+            // Keys such as the results of HashState() may already be hashes, and std::hash of an integer may be the
+            // integer itself, so the slot and the stripe come from the high bits of a multiplicative rehash.
+            return (uint64_t)Hasher()(key) * 0x9E3779B97F4A7C15ull;
+        }
+
+        static size_t GetSlot(const Table& table, uint64_t hash)
+        {
+            return (size_t)(hash >> 32) & (table.Capacity - 1);
+        }
+
+        // Nothing is erased from a table, so the probe for a key ends at the first empty slot.
+        static Node* FindNode(const Table& table, uint64_t hash, const Key& key)
+        {
+            for (size_t slot = GetSlot(table, hash); ; slot = (slot + 1) & (table.Capacity - 1))
+            {
+                Node* node = table.Slots[slot].load(std::memory_order_acquire);
+                if (node == nullptr || (node->Hash == hash && node->NodeKey == key))
+                    return node;
+            }
+        }
+
+        // Inserts of other stripes may claim the same empty slot, so a slot is taken by compare-and-swap.
+        static void InsertNode(Table& table, Node* node)
+        {
+            for (size_t slot = GetSlot(table, node->Hash); ; slot = (slot + 1) & (table.Capacity - 1))
+            {
+                Node* expected = nullptr;
+                if (table.Slots[slot].compare_exchange_strong(expected, node, std::memory_order_release, std::memory_order_relaxed))
+                    return;
+            }
+        }
+
+        void Grow(Table* full)
+        {
+            std::unique_lock<std::mutex> guards[kStripeCount];
+            for (uint32_t i = 0; i < kStripeCount; ++i)
+                guards[i] = std::unique_lock<std::mutex>(m_Stripes[i]);
+
+            if (m_Table.load(std::memory_order_relaxed) != full)
+                return;
+
+            Table* table = new Table(full->Capacity * 2);
+            m_Tables.emplace_back(table);
+            for (size_t i = 0; i < full->Capacity; ++i)
+            {
+                if (Node* node = full->Slots[i].load(std::memory_order_relaxed))
+                    InsertNode(*table, node);
+            }
+            m_Table.store(table, std::memory_order_release);
+        }
+
+        // The last table holds every node.
+        void DeleteNodes()
+        {
+            Table& table = *m_Tables.back();
+            for (size_t i = 0; i < table.Capacity; ++i)
+                delete table.Slots[i].load(std::memory_order_relaxed);
+        }
+
+        std::atomic<Table*> m_Table;
+        std::vector<std::unique_ptr<Table>> m_Tables;
+        std::atomic<size_t> m_Size{0};
+        std::mutex m_Stripes[kStripeCount];
+    };
+
+} // namespace Utility
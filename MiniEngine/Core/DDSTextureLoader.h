@@ -21,6 +21,7 @@
 #pragma once
 
 #include <d3d12.h>
+#include "DDSFormat.h"
 
 #pragma warning(push)
 #pragma warning(disable : 4005)
@@ -55,4 +56,3 @@ HRESULT __cdecl CreateDDSTextureFromFile( _In_ ID3D12Device* d3dDevice,
                                             _Out_opt_ DDS_ALPHA_MODE* alphaMode = nullptr
                                             );
 
-size_t BitsPerPixel(_In_ DXGI_FORMAT fmt);
@@ -0,0 +1,89 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+
+#pragma once
+
+// This header does not depend on pch.h so that it can be shared with portable (non-D3D12) tools.
+// It sticks to C++14 like the rest of Core.
+#include "ConcurrentHashMap.h"
+
+#include <atomic>
+#include <cstddef>
+#include <thread>
+
+namespace Utility
+{
+    // Device objects, such as pipeline states and root signatures, shared by every description with the same hash
+    // (see HashState()).  The first thread to ask for a hash creates the object, those that ask while it does wait
+    // for it, and every later lookup is a lock-free read.  Interface is anything with a COM-style Release(): the
+    // cache owns one reference to each object and releases it in Clear().  The objects are made by a callable, so
+    // that the cache can run against a mock device where there is no D3D12.
+    template <typename Interface>
+    class DeviceObjectCache
+    {
+    public:
+        // The object of hash.  If there is none, create() is called, on this thread and outside of any lock, and
+        // must return a new object with one reference, which the cache takes.  created tells whether it was called.
+        template <typename Create>
+        Interface* FindOrCreate(size_t hash, Create&& create, bool* created = nullptr)
+        {
+            Entry* entry = m_Map.Find(hash);
+            if (entry == nullptr)
+            {
+                // Reserve the entry so that the next inquiry will find that someone got here first.
+                auto result = m_Map.FindOrEmplace(hash);
+                entry = result.first;
+                if (result.second)
+                {
+                    Interface* object = create();
+                    entry->Object.store(object, std::memory_order_release);
+                    if (created != nullptr)
+                        *created = true;
+                    return object;
+                }
+            }
+
+            if (created != nullptr)
+                *created = false;
+
+            Interface* object;
+            while ((object = entry->Object.load(std::memory_order_acquire)) == nullptr)
+                std::this_thread::yield();
+            return object;
+        }
+
+        // Releases every object.  It must not run at the same time as anything else.
+        void Clear()
+        {
+            m_Map.Clear();
+        }
+
+        size_t GetSize() const
+        {
+            return m_Map.GetSize();
+        }
+
+    private:
+        struct Entry
+        {
+            Entry() : Object(nullptr) {}
+
+            ~Entry()
+            {
+                if (Interface* object = Object.load(std::memory_order_relaxed))
+                    object->Release();
+            }
+
+            std::atomic<Interface*> Object;
+        };
+
+        ConcurrentHashMap<size_t, Entry> m_Map;
+    };
+
+} // namespace Utility
@@ -0,0 +1,153 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+
+#include "FileNameEncoding.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cwchar>
+
+namespace
+{
+    const uint32_t kReplacementCharacter = 0xFFFD;
+
+    bool IsSurrogate(uint32_t codePoint)
+    {
+        return codePoint >= 0xD800 && codePoint < 0xE000;
+    }
+
+    void AppendUTF8(std::string& utf8, uint32_t codePoint)
+    {
+        if (codePoint < 0x80)
+        {
+            utf8 += (char)codePoint;
+        }
+        else if (codePoint < 0x800)
+        {
+            utf8 += (char)(0xC0 | (codePoint >> 6));
+            utf8 += (char)(0x80 | (codePoint & 0x3F));
+        }
+        else if (codePoint < 0x10000)
+        {
+            utf8 += (char)(0xE0 | (codePoint >> 12));
+            utf8 += (char)(0x80 | ((codePoint >> 6) & 0x3F));
+            utf8 += (char)(0x80 | (codePoint & 0x3F));
+        }
+        else
+        {
+            utf8 += (char)(0xF0 | (codePoint >> 18));
+            utf8 += (char)(0x80 | ((codePoint >> 12) & 0x3F));
+            utf8 += (char)(0x80 | ((codePoint >> 6) & 0x3F));
+            utf8 += (char)(0x80 | (codePoint & 0x3F));
+        }
+    }
+
+    void AppendWide(std::wstring& wide, uint32_t codePoint)
+    {
+#if WCHAR_MAX <= 0xFFFF
+        if (codePoint >= 0x10000)
+        {
+            codePoint -= 0x10000;
+            wide += (wchar_t)(0xD800 | (codePoint >> 10));
+            wide += (wchar_t)(0xDC00 | (codePoint & 0x3FF));
+            return;
+        }
+#endif
+        wide += (wchar_t)codePoint;
+    }
+
+    // The code point of the UTF-8 sequence at utf8[i], which is advanced past it.  Overlong encodings, surrogates,
+    // code points past U+10FFFF and truncated sequences are malformed.
+    uint32_t DecodeUTF8(const std::string& utf8, size_t& i)
+    {
+        const uint8_t lead = (uint8_t)utf8[i++];
+        if (lead < 0x80)
+            return lead;
+
+        uint32_t length;
+        uint32_t codePoint;
+        uint32_t minCodePoint;
+        if ((lead & 0xE0) == 0xC0)
+        {
+            length = 2;
+            codePoint = lead & 0x1F;
+            minCodePoint = 0x80;
+        }
+        else if ((lead & 0xF0) == 0xE0)
+        {
+            length = 3;
+            codePoint = lead & 0x0F;
+            minCodePoint = 0x800;
+        }
+        else if ((lead & 0xF8) == 0xF0)
+        {
+            length = 4;
+            codePoint = lead & 0x07;
+            minCodePoint = 0x10000;
+        }
+        else
+        {
+            return kReplacementCharacter;
+        }
+
+        for (uint32_t n = 1; n < length; ++n)
+        {
+            if (i == utf8.size() || ((uint8_t)utf8[i] & 0xC0) != 0x80)
+                return kReplacementCharacter;
+            codePoint = (codePoint << 6) | ((uint8_t)utf8[i++] & 0x3F);
+        }
+
+        if (codePoint < minCodePoint || codePoint > 0x10FFFF || IsSurrogate(codePoint))
+            return kReplacementCharacter;
+        return codePoint;
+    }
+
+    // The code point of the UTF-16 or UTF-32 sequence at wide[i], which is advanced past it
+    uint32_t DecodeWide(const std::wstring& wide, size_t& i)
+    {
+        const uint32_t unit = (uint32_t)wide[i++];
+#if WCHAR_MAX <= 0xFFFF
+        if (unit >= 0xD800 && unit < 0xDC00 && i < wide.size())
+        {
+            const uint32_t low = (uint32_t)wide[i];
+            if (low >= 0xDC00 && low < 0xE000)
+            {
+                ++i;
+                return 0x10000 + ((unit - 0xD800) << 10) + (low - 0xDC00);
+            }
+        }
+#endif
+
+        if (IsSurrogate(unit) || unit > 0x10FFFF)
+            return kReplacementCharacter;
+        return unit;
+    }
+}
+
+namespace Utility
+{
+    std::string ToUTF8FileName(const std::wstring& fileName)
+    {
+        std::string utf8FileName;
+        utf8FileName.reserve(fileName.size());
+        for (size_t i = 0; i < fileName.size(); )
+            AppendUTF8(utf8FileName, DecodeWide(fileName, i));
+        return utf8FileName;
+    }
+
+    std::wstring ToWideFileName(const std::string& fileName)
+    {
+        std::wstring wideFileName;
+        wideFileName.reserve(fileName.size());
+        for (size_t i = 0; i < fileName.size(); )
+            AppendWide(wideFileName, DecodeUTF8(fileName, i));
+        return wideFileName;
+    }
+
+} // namespace Utility
@@ -0,0 +1,25 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+
+#pragma once
+
+// This header does not depend on pch.h so that it can be shared with portable (non-D3D12) tools.
+// It sticks to C++14 like the rest of Core.
+#include <string>
+
+namespace Utility
+{
+    // Conversions between the UTF-8 file names that the portable file code takes and the wide file names of the
+    // engine and of the Win32 API.  Wide strings are UTF-16 where wchar_t has 16 bits (Windows) and UTF-32 where it
+    // has 32 (POSIX).  Malformed sequences, such as unpaired surrogates, become U+FFFD, as they do in
+    // MultiByteToWideChar().
+    std::string ToUTF8FileName(const std::wstring& fileName);
+    std::wstring ToWideFileName(const std::string& fileName);
+
+} // namespace Utility
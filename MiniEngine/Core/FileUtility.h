@@ -13,25 +13,34 @@
 
 #pragma once
 
-#include "pch.h"
+// This header does not depend on pch.h so that it can be shared with portable (non-D3D12) tools.
+// It sticks to C++14 like the rest of Core.
+#include "AsyncFileReader.h"
+#include "FileNameEncoding.h"
+#include "IOThreadPool.h"
+#include <future>
 #include <vector>
 #include <string>
-#include <ppl.h>
 
 namespace Utility
 {
     using namespace std;
-    using namespace concurrency;
 
-    typedef shared_ptr<vector<byte> > ByteArray;
+    typedef FileData ByteArray;
     extern ByteArray NullFile;
 
-    // Reads the entire contents of a binary file.  If the file with the same name except with an additional
-    // ".gz" suffix exists, it will be loaded and decompressed instead.
+    // Reads the entire contents of a binary file.  If the file does not exist but one with the same name except
+    // with an additional ".gz" suffix does, that one is loaded and decompressed instead, in parallel if it is
+    // chunked (Compression.h).  IOThreadPool reads fall back to the .gz file the same way.
     // This operation blocks until the entire file is read.
     ByteArray ReadFileSync(const wstring& fileName);
 
-    // Same as previous except that it does not block but instead returns a task.
-    task<ByteArray> ReadFileAsync(const wstring& fileName);
+    // Same as previous except that it does not block but instead returns a future, served by threads shared by the
+    // process.  The contents can be mapped or read around the file cache (see FileReadMode), so ".gz" files are not
+    // looked for.  Batches of files are better submitted together with GetFileReader().Submit().
+    shared_future<FileBuffer> ReadFileAsync(const wstring& fileName, FileReadMode mode = FileReadMode::kBuffered);
+
+    // The reader behind ReadFileAsync(), started on first use
+    AsyncFileReader& GetFileReader();
 
 } // namespace Utility
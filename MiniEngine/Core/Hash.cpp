@@ -0,0 +1,368 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+
+#include "Hash.h"
+
+#include <cstring>
+
+#if defined(_M_X64) || defined(__x86_64__)
+#define CRC32C_X64 1
+#include <nmmintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define CRC32C_TARGET
+#else
+#define CRC32C_TARGET __attribute__((target("sse4.2")))
+#endif
+#elif defined(_M_ARM64) || defined(__aarch64__)
+#define CRC32C_ARM64 1
+#if defined(_MSC_VER)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
+#include <intrin.h>
+#define CRC32C_TARGET
+#else
+#include <arm_acle.h>
+#if defined(__ARM_FEATURE_CRC32)
+#define CRC32C_TARGET
+#elif defined(__clang__)
+#define CRC32C_TARGET __attribute__((target("crc")))
+#else
+#define CRC32C_TARGET __attribute__((target("+crc")))
+#endif
+#if defined(__linux__)
+#include <asm/hwcap.h>
+#include <sys/auxv.h>
+#endif
+#endif
+#endif
+
+namespace Utility
+{
+    namespace
+    {
+        const uint32_t kCastagnoli = 0x82F63B78;    // The CRC32C polynomial, bit-reversed
+
+        // Large inputs are hashed as three interleaved blocks of this size, since a CRC instruction has a latency of
+        // three cycles but can start every cycle.  The CRCs of the blocks are then combined with kShift.
+        const size_t kInterleaveBlock = 1024;
+
+        inline uint64_t Read64(const uint8_t* p) { uint64_t v; std::memcpy(&v, p, 8); return v; }
+        inline uint32_t Read32(const uint8_t* p) { uint32_t v; std::memcpy(&v, p, 4); return v; }
+
+        // The functions below update a CRC without the inversion before and after, as the CRC instructions do.
+        struct Crc32cTables
+        {
+            uint32_t Slice[8][256];     // Slicing-by-8 for the software path
+            uint32_t Shift[4][256];     // The CRC after kInterleaveBlock zero bytes, by byte of the CRC before
+
+            Crc32cTables()
+            {
+                for (uint32_t i = 0; i < 256; ++i)
+                {
+                    uint32_t crc = i;
+                    for (int bit = 0; bit < 8; ++bit)
+                        crc = (crc >> 1) ^ (kCastagnoli & (0u - (crc & 1)));
+                    Slice[0][i] = crc;
+                }
+                for (uint32_t i = 0; i < 256; ++i)
+                {
+                    for (int k = 1; k < 8; ++k)
+                        Slice[k][i] = (Slice[k - 1][i] >> 8) ^ Slice[0][Slice[k - 1][i] & 0xFF];
+                }
+
+                // Appending zeros is linear in the CRC, so the table of each byte is the sum of the shifted bits.
+                uint32_t shiftedBits[32];
+                for (int bit = 0; bit < 32; ++bit)
+                {
+                    uint32_t crc = 1u << bit;
+                    for (size_t i = 0; i < kInterleaveBlock; ++i)
+                        crc = (crc >> 8) ^ Slice[0][crc & 0xFF];
+                    shiftedBits[bit] = crc;
+                }
+                for (int k = 0; k < 4; ++k)
+                {
+                    for (uint32_t i = 0; i < 256; ++i)
+                    {
+                        uint32_t crc = 0;
+                        for (int bit = 0; bit < 8; ++bit)
+                            crc ^= (i >> bit & 1) != 0 ? shiftedBits[k * 8 + bit] : 0;
+                        Shift[k][i] = crc;
+                    }
+                }
+            }
+        };
+
+        const Crc32cTables& GetTables()
+        {
+            static const Crc32cTables s_Tables;
+            return s_Tables;
+        }
+
+        inline uint32_t ShiftBlock(const Crc32cTables& tables, uint32_t crc)
+        {
+            return tables.Shift[0][crc & 0xFF] ^ tables.Shift[1][(crc >> 8) & 0xFF] ^
+                tables.Shift[2][(crc >> 16) & 0xFF] ^ tables.Shift[3][crc >> 24];
+        }
+
+        uint32_t UpdateSoftware(uint32_t crc, const uint8_t* p, size_t size)
+        {
+            const Crc32cTables& tables = GetTables();
+            for (; size >= 8; p += 8, size -= 8)
+            {
+                const uint32_t low = Read32(p) ^ crc;
+                const uint32_t high = Read32(p + 4);
+                crc = tables.Slice[7][low & 0xFF] ^ tables.Slice[6][(low >> 8) & 0xFF] ^
+                    tables.Slice[5][(low >> 16) & 0xFF] ^ tables.Slice[4][low >> 24] ^
+                    tables.Slice[3][high & 0xFF] ^ tables.Slice[2][(high >> 8) & 0xFF] ^
+                    tables.Slice[1][(high >> 16) & 0xFF] ^ tables.Slice[0][high >> 24];
+            }
+            for (; size > 0; ++p, --size)
+                crc = (crc >> 8) ^ tables.Slice[0][(crc ^ *p) & 0xFF];
+            return crc;
+        }
+
+#if CRC32C_X64
+
+        CRC32C_TARGET uint32_t UpdateHardware(uint32_t crc, const uint8_t* p, size_t size)
+        {
+            uint64_t crc0 = crc;
+            if (size >= 3 * kInterleaveBlock)
+            {
+                const Crc32cTables& tables = GetTables();
+                for (; size >= 3 * kInterleaveBlock; p += 3 * kInterleaveBlock, size -= 3 * kInterleaveBlock)
+                {
+                    uint64_t crc1 = 0, crc2 = 0;
+                    for (size_t i = 0; i < kInterleaveBlock; i += 8)
+                    {
+                        crc0 = _mm_crc32_u64(crc0, Read64(p + i));
+                        crc1 = _mm_crc32_u64(crc1, Read64(p + kInterleaveBlock + i));
+                        crc2 = _mm_crc32_u64(crc2, Read64(p + 2 * kInterleaveBlock + i));
+                    }
+                    crc0 = ShiftBlock(tables, ShiftBlock(tables, (uint32_t)crc0) ^ (uint32_t)crc1) ^ (uint32_t)crc2;
+                }
+            }
+            for (; size >= 8; p += 8, size -= 8)
+                crc0 = _mm_crc32_u64(crc0, Read64(p));
+            for (; size > 0; ++p, --size)
+                crc0 = _mm_crc32_u8((uint32_t)crc0, *p);
+            return (uint32_t)crc0;
+        }
+
+        bool HasHardware()
+        {
+#ifdef _MSC_VER
+            int info[4];
+            __cpuid(info, 1);
+            return (info[2] & (1 << 20)) != 0;
+#else
+            return __builtin_cpu_supports("sse4.2") != 0;
+#endif
+        }
+
+        const char* const kHardwareName = "SSE4.2";
+
+#elif CRC32C_ARM64
+
+        CRC32C_TARGET uint32_t UpdateHardware(uint32_t crc, const uint8_t* p, size_t size)
+        {
+            if (size >= 3 * kInterleaveBlock)
+            {
+                const Crc32cTables& tables = GetTables();
+                for (; size >= 3 * kInterleaveBlock; p += 3 * kInterleaveBlock, size -= 3 * kInterleaveBlock)
+                {
+                    uint32_t crc1 = 0, crc2 = 0;
+                    for (size_t i = 0; i < kInterleaveBlock; i += 8)
+                    {
+                        crc = __crc32cd(crc, Read64(p + i));
+                        crc1 = __crc32cd(crc1, Read64(p + kInterleaveBlock + i));
+                        crc2 = __crc32cd(crc2, Read64(p + 2 * kInterleaveBlock + i));
+                    }
+                    crc = ShiftBlock(tables, ShiftBlock(tables, crc) ^ crc1) ^ crc2;
+                }
+            }
+            for (; size >= 8; p += 8, size -= 8)
+                crc = __crc32cd(crc, Read64(p));
+            for (; size > 0; ++p, --size)
+                crc = __crc32cb(crc, *p);
+            return crc;
+        }
+
+        bool HasHardware()
+        {
+#if defined(_MSC_VER)
+            return IsProcessorFeaturePresent(PF_ARM_V8_CRC32_INSTRUCTIONS_AVAILABLE) != 0;
+#elif defined(__ARM_FEATURE_CRC32) || defined(__APPLE__)
+            return true;
+#elif defined(__linux__) && defined(HWCAP_CRC32)
+            return (getauxval(AT_HWCAP) & HWCAP_CRC32) != 0;
+#else
+            return false;
+#endif
+        }
+
+        const char* const kHardwareName = "ARMv8 CRC";
+
+#else
+
+        uint32_t UpdateHardware(uint32_t crc, const uint8_t* p, size_t size) { return UpdateSoftware(crc, p, size); }
+        bool HasHardware() { return false; }
+        const char* const kHardwareName = "software";
+
+#endif
+
+        struct Crc32cImplementation
+        {
+            uint32_t (*Update)(uint32_t crc, const uint8_t* p, size_t size);
+            const char* Name;
+        };
+
+        // Chosen once, on first use, so that it is ready for hashes computed during static initialization
+        const Crc32cImplementation& GetImplementation()
+        {
+            static const Crc32cImplementation s_Implementation = HasHardware() ?
+                Crc32cImplementation{ UpdateHardware, kHardwareName } : Crc32cImplementation{ UpdateSoftware, "software" };
+            return s_Implementation;
+        }
+
+        const uint64_t kPrime1 = 0x9E3779B185EBCA87ull;
+        const uint64_t kPrime2 = 0xC2B2AE3D27D4EB4Full;
+        const uint64_t kPrime3 = 0x165667B19E3779F9ull;
+        const uint64_t kPrime4 = 0x85EBCA77C2B2AE63ull;
+        const uint64_t kPrime5 = 0x27D4EB2F165667C5ull;
+
+        inline uint64_t RotateLeft(uint64_t x, int bits) { return (x << bits) | (x >> (64 - bits)); }
+
+        inline uint64_t Round(uint64_t acc, uint64_t input)
+        {
+            acc += input * kPrime2;
+            return RotateLeft(acc, 31) * kPrime1;
+        }
+
+        inline uint64_t MergeRound(uint64_t acc, uint64_t value)
+        {
+            acc ^= Round(0, value);
+            return acc * kPrime1 + kPrime4;
+        }
+
+        // Consumes whole 32-byte stripes and returns the number of bytes consumed
+        size_t ConsumeStripes(uint64_t (&acc)[4], const uint8_t* data, size_t size)
+        {
+            const uint8_t* const begin = data;
+            const uint8_t* const end = data + (size & ~size_t(31));
+            uint64_t a0 = acc[0], a1 = acc[1], a2 = acc[2], a3 = acc[3];
+            for (; data < end; data += 32)
+            {
+                a0 = Round(a0, Read64(data));
+                a1 = Round(a1, Read64(data + 8));
+                a2 = Round(a2, Read64(data + 16));
+                a3 = Round(a3, Read64(data + 24));
+            }
+            acc[0] = a0; acc[1] = a1; acc[2] = a2; acc[3] = a3;
+            return size_t(data - begin);
+        }
+
+    } // namespace
+
+    uint32_t Crc32c(const void* data, size_t size, uint32_t crc)
+    {
+        return ~GetImplementation().Update(~crc, static_cast<const uint8_t*>(data), size);
+    }
+
+    uint32_t Crc32cSoftware(const void* data, size_t size, uint32_t crc)
+    {
+        return ~UpdateSoftware(~crc, static_cast<const uint8_t*>(data), size);
+    }
+
+    const char* GetCrc32cImplementation()
+    {
+        return GetImplementation().Name;
+    }
+
+    ContentHash::ContentHash(uint64_t seed)
+        : m_Length(0)
+        , m_BufferSize(0)
+    {
+        m_Acc[0] = seed + kPrime1 + kPrime2;
+        m_Acc[1] = seed + kPrime2;
+        m_Acc[2] = seed;
+        m_Acc[3] = seed - kPrime1;
+    }
+
+    void ContentHash::Update(const void* data, size_t size)
+    {
+        const uint8_t* bytes = static_cast<const uint8_t*>(data);
+        m_Length += size;
+
+        if (m_BufferSize > 0)
+        {
+            const size_t count = size < 32 - m_BufferSize ? size : 32 - m_BufferSize;
+            std::memcpy(m_Buffer + m_BufferSize, bytes, count);
+            m_BufferSize += (uint32_t)count;
+            bytes += count;
+            size -= count;
+
+            if (m_BufferSize < 32)
+                return;
+
+            ConsumeStripes(m_Acc, m_Buffer, 32);
+            m_BufferSize = 0;
+        }
+
+        const size_t consumed = ConsumeStripes(m_Acc, bytes, size);
+        m_BufferSize = (uint32_t)(size - consumed);
+        std::memcpy(m_Buffer, bytes + consumed, m_BufferSize);
+    }
+
+    uint64_t ContentHash::Finish() const
+    {
+        uint64_t hash;
+        if (m_Length >= 32)
+        {
+            hash = RotateLeft(m_Acc[0], 1) + RotateLeft(m_Acc[1], 7) + RotateLeft(m_Acc[2], 12) + RotateLeft(m_Acc[3], 18);
+            for (int i = 0; i < 4; ++i)
+                hash = MergeRound(hash, m_Acc[i]);
+        }
+        else
+        {
+            // m_Acc[2] still holds the seed
+            hash = m_Acc[2] + kPrime5;
+        }
+
+        hash += m_Length;
+
+        const uint8_t* p = m_Buffer;
+        const uint8_t* const end = m_Buffer + m_BufferSize;
+        for (; p + 8 <= end; p += 8)
+            hash = RotateLeft(hash ^ Round(0, Read64(p)), 27) * kPrime1 + kPrime4;
+        if (p + 4 <= end)
+        {
+            hash = RotateLeft(hash ^ (Read32(p) * kPrime1), 23) * kPrime2 + kPrime3;
+            p += 4;
+        }
+        for (; p < end; ++p)
+            hash = RotateLeft(hash ^ (*p * kPrime5), 11) * kPrime1;
+
+        hash ^= hash >> 33;
+        hash *= kPrime2;
+        hash ^= hash >> 29;
+        hash *= kPrime3;
+        hash ^= hash >> 32;
+        return hash;
+    }
+
+    uint64_t HashBytes(const void* data, size_t size, uint64_t seed)
+    {
+        ContentHash hash(seed);
+        hash.Update(data, size);
+        return hash.Finish();
+    }
+
+} // namespace Utility
@@ -8,53 +8,34 @@
 //
 // Developed by Minigraph
 //
-// Author:  James Stanard 
+// Author:  James Stanard
 
 #pragma once
 
-#include "Math/Common.h"
-
-// This requires SSE4.2 which is present on Intel Nehalem (Nov. 2008)
-// and AMD Bulldozer (Oct. 2011) processors.  I could put a runtime
-// check for this, but I'm just going to assume people playing with
-// DirectX 12 on Windows 10 have fairly recent machines.
-#ifdef _M_X64
-#define ENABLE_SSE_CRC32 1
-#else
-#define ENABLE_SSE_CRC32 0
-#endif
-
-#if ENABLE_SSE_CRC32
-#pragma intrinsic(_mm_crc32_u32)
-#pragma intrinsic(_mm_crc32_u64)
-#endif
+// Hashes of two kinds.  CRC32C hashes small state descriptions (PSOs, root signatures, samplers) for in-process
+// caches.  It uses the CRC32C instructions of SSE4.2 or ARMv8 when the CPU reports them at run time, and tables
+// otherwise, so the same binary runs on any CPU and every compiler gets the fast path.  ContentHash (XXH64) hashes
+// larger blobs into 64-bit keys that are stored on disk, such as those of ModelCache.
+// This header does not depend on pch.h so that it can be shared with portable (non-D3D12) tools.
+// It sticks to C++14 like the rest of Core.
+#include <cstddef>
+#include <cstdint>
 
 namespace Utility
 {
-    inline size_t HashRange(const uint32_t* const Begin, const uint32_t* const End, size_t Hash)
-    {
-#if ENABLE_SSE_CRC32
-        const uint64_t* Iter64 = (const uint64_t*)Math::AlignUp(Begin, 8);
-        const uint64_t* const End64 = (const uint64_t* const)Math::AlignDown(End, 8);
+    // The CRC32C (Castagnoli) of data.  Pass the result of the previous call as crc to continue it over more data,
+    // as with zlib's crc32().
+    uint32_t Crc32c(const void* data, size_t size, uint32_t crc = 0);
 
-        // If not 64-bit aligned, start with a single u32
-        if ((uint32_t*)Iter64 > Begin)
-            Hash = _mm_crc32_u32((uint32_t)Hash, *Begin);
+    // The table-driven CRC32C, whatever the CPU supports, for comparison
+    uint32_t Crc32cSoftware(const void* data, size_t size, uint32_t crc = 0);
 
-        // Iterate over consecutive u64 values
-        while (Iter64 < End64)
-            Hash = _mm_crc32_u64((uint64_t)Hash, *Iter64++);
+    // "SSE4.2", "ARMv8 CRC" or "software": the implementation that Crc32c() runs
+    const char* GetCrc32cImplementation();
 
-        // If there is a 32-bit remainder, accumulate that
-        if ((uint32_t*)Iter64 < End)
-            Hash = _mm_crc32_u32((uint32_t)Hash, *(uint32_t*)Iter64);
-#else
-        // An inexpensive hash for CPUs lacking SSE4.2
-        for (const uint32_t* Iter = Begin; Iter < End; ++Iter)
-            Hash = 16777619U * Hash ^ *Iter;
-#endif
-
-        return Hash;
+    inline size_t HashRange(const uint32_t* const Begin, const uint32_t* const End, size_t Hash)
+    {
+        return Crc32c(Begin, (size_t)(End - Begin) * sizeof(uint32_t), (uint32_t)Hash);
     }
 
     template <typename T> inline size_t HashState( const T* StateDesc, size_t Count = 1, size_t Hash = 2166136261U )
@@ -63,4 +44,30 @@ namespace Utility
         return HashRange((uint32_t*)StateDesc, (uint32_t*)(StateDesc + Count), Hash);
     }
 
+    // Streaming 64-bit hash of a byte sequence (XXH64).  It is not cryptographic, but with 64 bits an accidental
+    // collision between the entries of a cache is astronomically unlikely, and it runs at memory bandwidth so that
+    // hashing a source file costs far less than converting it.
+    class ContentHash
+    {
+    public:
+        explicit ContentHash(uint64_t seed = 0);
+
+        void Update(const void* data, size_t size);
+
+        // Hashes the object representation of a value, which must not contain padding
+        template <typename T>
+        void UpdateValue(const T& value) { Update(&value, sizeof(T)); }
+
+        // The hash of everything passed to Update() so far.  More data can still be added afterwards.
+        uint64_t Finish() const;
+
+    private:
+        uint64_t m_Acc[4];
+        uint64_t m_Length;
+        uint8_t m_Buffer[32];
+        uint32_t m_BufferSize;
+    };
+
+    uint64_t HashBytes(const void* data, size_t size, uint64_t seed = 0);
+
 } // namespace Utility
@@ -0,0 +1,212 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+
+#include "IOThreadPool.h"
+#include "Compression.h"
+#include "FileNameEncoding.h"
+
+#include <algorithm>
+#include <utility>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace Utility
+{
+    IOThreadPool::IOThreadPool(uint32_t threadCount, uint32_t maxReadAheads)
+        : m_MaxReadAheads(maxReadAheads)
+    {
+        threadCount = std::max(threadCount, 1u);
+        m_Threads.reserve(threadCount);
+        for (uint32_t i = 0; i < threadCount; ++i)
+            m_Threads.emplace_back([this] { WorkerMain(); });
+    }
+
+    IOThreadPool::~IOThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> guard(m_Mutex);
+            m_Stop = true;
+        }
+        m_WakeUp.notify_all();
+
+        for (std::thread& thread : m_Threads)
+            thread.join();
+    }
+
+    std::shared_future<FileData> IOThreadPool::Read(const std::string& fileName)
+    {
+        std::lock_guard<std::mutex> guard(m_Mutex);
+
+        auto readAhead = m_ReadAheadResults.find(fileName);
+        if (readAhead != m_ReadAheadResults.end())
+        {
+            std::shared_future<FileData> result = std::move(readAhead->second);
+            m_ReadAheadResults.erase(readAhead);
+            m_ReadAheadOrder.erase(std::find(m_ReadAheadOrder.begin(), m_ReadAheadOrder.end(), fileName));
+
+            // Someone waits for it now, so a queued read-ahead moves ahead of the other read-aheads.
+            auto queued = std::find_if(m_ReadAheads.begin(), m_ReadAheads.end(),
+                [&](const std::unique_ptr<Request>& request) { return request->FileName == fileName; });
+            if (queued != m_ReadAheads.end())
+            {
+                m_Reads.push_back(std::move(*queued));
+                m_ReadAheads.erase(queued);
+            }
+            return result;
+        }
+
+        std::unique_ptr<Request> request(new Request{ fileName, {} });
+        std::shared_future<FileData> result = request->Promise.get_future().share();
+        m_Reads.push_back(std::move(request));
+        m_WakeUp.notify_one();
+        return result;
+    }
+
+    void IOThreadPool::ReadAhead(const std::string& fileName)
+    {
+        std::lock_guard<std::mutex> guard(m_Mutex);
+
+        if (m_MaxReadAheads == 0 || m_ReadAheadResults.count(fileName) != 0)
+            return;
+
+        // A read-ahead that is never taken over would otherwise hold its slot for good, so the oldest one expires.
+        // If it has not started, it is not read at all.
+        if (m_ReadAheadResults.size() >= m_MaxReadAheads)
+        {
+            const std::string& oldest = m_ReadAheadOrder.front();
+            m_ReadAheadResults.erase(oldest);
+            auto queued = std::find_if(m_ReadAheads.begin(), m_ReadAheads.end(),
+                [&](const std::unique_ptr<Request>& request) { return request->FileName == oldest; });
+            if (queued != m_ReadAheads.end())
+                m_ReadAheads.erase(queued);
+            m_ReadAheadOrder.pop_front();
+        }
+
+        std::unique_ptr<Request> request(new Request{ fileName, {} });
+        m_ReadAheadResults.emplace(fileName, request->Promise.get_future().share());
+        m_ReadAheadOrder.push_back(fileName);
+        m_ReadAheads.push_back(std::move(request));
+        m_WakeUp.notify_one();
+    }
+
+    void IOThreadPool::WorkerMain()
+    {
+        for (;;)
+        {
+            std::unique_ptr<Request> request;
+            {
+                std::unique_lock<std::mutex> lock(m_Mutex);
+                m_WakeUp.wait(lock, [this] { return m_Stop || !m_Reads.empty() || !m_ReadAheads.empty(); });
+
+                if (!m_Reads.empty())
+                {
+                    request = std::move(m_Reads.front());
+                    m_Reads.pop_front();
+                }
+                else if (!m_Stop)
+                {
+                    request = std::move(m_ReadAheads.front());
+                    m_ReadAheads.pop_front();
+                }
+                else
+                {
+                    return;
+                }
+            }
+
+            request->Promise.set_value(ReadFile(request->FileName));
+        }
+    }
+
+    // Returns false if the file cannot be opened.  data is left empty if it cannot be read.
+    static bool ReadWholeFile(const std::string& fileName, std::vector<uint8_t>& data);
+
+    FileData IOThreadPool::ReadFile(const std::string& fileName)
+    {
+        FileData data = std::make_shared<std::vector<uint8_t>>();
+        if (!ReadWholeFile(fileName, *data))
+            return ReadCompressedFile(fileName + ".gz");
+        return data;
+    }
+
+#ifdef _WIN32
+
+    static bool ReadWholeFile(const std::string& fileName, std::vector<uint8_t>& data)
+    {
+        HANDLE file = CreateFileW(ToWideFileName(fileName).c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (file == INVALID_HANDLE_VALUE)
+            return false;
+
+        // The size comes from the open handle, which saves the separate stat of ReadFileSync().
+        LARGE_INTEGER fileSize = {};
+        if (GetFileSizeEx(file, &fileSize))
+        {
+            data.resize((size_t)fileSize.QuadPart);
+
+            size_t offset = 0;
+            DWORD bytesRead = 0;
+            while (offset < data.size() &&
+                ::ReadFile(file, data.data() + offset, (DWORD)std::min<size_t>(data.size() - offset, 1u << 30), &bytesRead, nullptr) && bytesRead > 0)
+            {
+                offset += bytesRead;
+            }
+
+            if (offset != data.size())
+                data.clear();
+        }
+
+        CloseHandle(file);
+        return true;
+    }
+
+#else
+
+    static bool ReadWholeFile(const std::string& fileName, std::vector<uint8_t>& data)
+    {
+        const int file = open(fileName.c_str(), O_RDONLY | O_CLOEXEC);
+        if (file < 0)
+            return false;
+
+        struct stat fileStat = {};
+        if (fstat(file, &fileStat) == 0)
+        {
+            data.resize((size_t)fileStat.st_size);
+            posix_fadvise(file, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+            size_t offset = 0;
+            while (offset < data.size())
+            {
+                const ssize_t bytesRead = read(file, data.data() + offset, data.size() - offset);
+                if (bytesRead < 0 && errno == EINTR)
+                    continue;
+                if (bytesRead <= 0)
+                    break;
+                offset += (size_t)bytesRead;
+            }
+
+            if (offset != data.size())
+                data.clear();
+        }
+
+        close(file);
+        return true;
+    }
+
+#endif
+
+} // namespace Utility
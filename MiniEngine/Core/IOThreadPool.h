@@ -0,0 +1,79 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+
+#pragma once
+
+// This header does not depend on pch.h so that it can be shared with portable (non-D3D12) tools.
+// It sticks to C++14 like the rest of Core.
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace Utility
+{
+    // The whole contents of a file.  Empty if the file cannot be read.  It is the same type as ByteArray of FileUtility.h.
+    typedef std::shared_ptr<std::vector<uint8_t>> FileData;
+
+    // Threads that read whole files, so that loaders on other threads can overlap file reads with their own work and
+    // with each other.  Reads requested with Read() go first.  Reads requested with ReadAhead() fill the idle time
+    // of the I/O threads, and a later Read() of the same file takes over the read-ahead, finished or not.  A
+    // read-ahead that nobody takes over expires when it is the oldest of maxReadAheads and another one is requested.
+    // A file that does not exist is read from its .gz version if there is one, as ReadFile() does.
+    class IOThreadPool
+    {
+    public:
+        // maxReadAheads bounds the read-aheads that have not been taken over by Read() yet, and thus the memory
+        // that files read ahead but never requested can hold.  The oldest of them is dropped to make room for a new one.
+        explicit IOThreadPool(uint32_t threadCount = 4, uint32_t maxReadAheads = 64);
+
+        // Finishes the reads requested with Read().  Read-aheads that have not started are dropped.
+        ~IOThreadPool();
+
+        IOThreadPool(const IOThreadPool&) = delete;
+        IOThreadPool& operator=(const IOThreadPool&) = delete;
+
+        // fileName is UTF-8.  Safe to call from any thread.
+        std::shared_future<FileData> Read(const std::string& fileName);
+        void ReadAhead(const std::string& fileName);
+
+        // Blocking read on the calling thread.  If the file does not exist, "<fileName>.gz" is decompressed in its
+        // place (see Compression.h), so Read() and ReadAhead() find compressed assets too.
+        static FileData ReadFile(const std::string& fileName);
+
+        uint32_t GetThreadCount() const { return (uint32_t)m_Threads.size(); }
+
+    private:
+        struct Request
+        {
+            std::string FileName;
+            std::promise<FileData> Promise;
+        };
+
+        void WorkerMain();
+
+        const uint32_t m_MaxReadAheads;
+        std::mutex m_Mutex;
+        std::condition_variable m_WakeUp;
+        std::deque<std::unique_ptr<Request>> m_Reads;
+        std::deque<std::unique_ptr<Request>> m_ReadAheads;
+        std::unordered_map<std::string, std::shared_future<FileData>> m_ReadAheadResults; // Not taken over yet
+        std::deque<std::string> m_ReadAheadOrder; // The keys of m_ReadAheadResults, oldest first
+        bool m_Stop = false;
+        std::vector<std::thread> m_Threads;
+    };
+
+} // namespace Utility
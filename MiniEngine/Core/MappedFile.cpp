@@ -0,0 +1,179 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+
+#include "MappedFile.h"
+#include "FileNameEncoding.h"
+
+#include <algorithm>
+#include <utility>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace Utility
+{
+    MappedFile::MappedFile(MappedFile&& other) noexcept
+        : m_Data(std::exchange(other.m_Data, nullptr))
+        , m_Size(std::exchange(other.m_Size, 0))
+        , m_IsOpen(std::exchange(other.m_IsOpen, false))
+    {
+    }
+
+    MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+    {
+        if (this != &other)
+        {
+            Close();
+            m_Data = std::exchange(other.m_Data, nullptr);
+            m_Size = std::exchange(other.m_Size, 0);
+            m_IsOpen = std::exchange(other.m_IsOpen, false);
+        }
+        return *this;
+    }
+
+#ifdef _WIN32
+
+    bool MappedFile::Open(const std::string& fileName)
+    {
+        return Open(ToWideFileName(fileName));
+    }
+
+    bool MappedFile::Open(const std::wstring& fileName)
+    {
+        Close();
+
+        HANDLE file = CreateFileW(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE)
+            return false;
+
+        LARGE_INTEGER fileSize = {};
+        if (!GetFileSizeEx(file, &fileSize))
+        {
+            CloseHandle(file);
+            return false;
+        }
+
+        // An empty file cannot be mapped, but it is still a valid (empty) view.
+        if (fileSize.QuadPart == 0)
+        {
+            CloseHandle(file);
+            m_IsOpen = true;
+            return true;
+        }
+
+        // The view keeps the mapping and the file alive after their handles are closed.
+        HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+        CloseHandle(file);
+        if (mapping == nullptr)
+            return false;
+
+        void* view = MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, 0);
+        CloseHandle(mapping);
+        if (view == nullptr)
+            return false;
+
+        m_Data = static_cast<uint8_t*>(view);
+        m_Size = static_cast<size_t>(fileSize.QuadPart);
+        m_IsOpen = true;
+        return true;
+    }
+
+    void MappedFile::Close()
+    {
+        if (m_Data != nullptr)
+            UnmapViewOfFile(m_Data);
+
+        m_Data = nullptr;
+        m_Size = 0;
+        m_IsOpen = false;
+    }
+
+    void MappedFile::Prefetch(size_t offset, size_t size) const
+    {
+        if (offset >= m_Size)
+            return;
+
+        WIN32_MEMORY_RANGE_ENTRY range = { m_Data + offset, std::min(size, m_Size - offset) };
+        PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+    }
+
+#else
+
+    bool MappedFile::Open(const std::wstring& fileName)
+    {
+        return Open(ToUTF8FileName(fileName));
+    }
+
+    bool MappedFile::Open(const std::string& fileName)
+    {
+        Close();
+
+        const int file = open(fileName.c_str(), O_RDONLY | O_CLOEXEC);
+        if (file < 0)
+            return false;
+
+        struct stat fileStat = {};
+        if (fstat(file, &fileStat) != 0)
+        {
+            close(file);
+            return false;
+        }
+
+        if (fileStat.st_size == 0)
+        {
+            close(file);
+            m_IsOpen = true;
+            return true;
+        }
+
+        // MAP_PRIVATE with write access gives the same copy-on-write semantics as FILE_MAP_COPY.
+        void* view = mmap(nullptr, static_cast<size_t>(fileStat.st_size), PROT_READ | PROT_WRITE, MAP_PRIVATE, file, 0);
+        close(file);
+        if (view == MAP_FAILED)
+            return false;
+
+        m_Data = static_cast<uint8_t*>(view);
+        m_Size = static_cast<size_t>(fileStat.st_size);
+        m_IsOpen = true;
+        return true;
+    }
+
+    void MappedFile::Close()
+    {
+        if (m_Data != nullptr)
+            munmap(m_Data, m_Size);
+
+        m_Data = nullptr;
+        m_Size = 0;
+        m_IsOpen = false;
+    }
+
+    void MappedFile::Prefetch(size_t offset, size_t size) const
+    {
+        if (offset >= m_Size)
+            return;
+
+        // madvise() requires a page-aligned address.
+        const size_t pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+        const size_t begin = offset / pageSize * pageSize;
+        const size_t end = offset + std::min(size, m_Size - offset);
+        madvise(m_Data + begin, end - begin, MADV_WILLNEED);
+    }
+
+#endif
+
+} // namespace Utility
@@ -0,0 +1,51 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+
+#pragma once
+
+// This header does not depend on pch.h so that it can be shared with portable (non-D3D12) tools.
+// It sticks to C++14 like the rest of Core.
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace Utility
+{
+    // A whole file mapped into the address space.  Pages are read lazily on first access and are shared
+    // with the OS file cache, so nothing is copied onto the heap.  The view is copy-on-write: writes through
+    // it stay private to the process and never reach the file.
+    class MappedFile
+    {
+    public:
+        MappedFile() = default;
+        ~MappedFile() { Close(); }
+
+        MappedFile(MappedFile&& other) noexcept;
+        MappedFile& operator=(MappedFile&& other) noexcept;
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        bool Open(const std::wstring& fileName);
+        bool Open(const std::string& fileName); // UTF-8
+        void Close();
+
+        bool IsOpen() const { return m_IsOpen; }
+        uint8_t* GetData() const { return m_Data; }
+        size_t GetSize() const { return m_Size; }
+
+        // Hints that [offset, offset + size) will be accessed soon so that the OS can read it ahead.
+        void Prefetch(size_t offset, size_t size) const;
+
+    private:
+        uint8_t* m_Data = nullptr;
+        size_t m_Size = 0;
+        bool m_IsOpen = false;
+    };
+
+} // namespace Utility
@@ -0,0 +1,114 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+
+#pragma once
+
+// This header does not depend on pch.h so that it can be shared with portable (non-D3D12) tools.
+// It sticks to C++14 like the rest of Core.
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <unordered_map>
+
+namespace Utility
+{
+    // A map split into shards that each have their own lock, so that threads looking up different keys rarely
+    // wait for each other.  The callbacks run under the lock of the key's shard, and must therefore be quick:
+    // a value that takes long to create (e.g. a texture read from disk) should be inserted in a loading state,
+    // finished after FindOrInsert() returns, and waited for outside of any call into the cache.
+    template <typename Key, typename Value, typename Hasher = std::hash<Key>>
+    class ShardedCache
+    {
+    public:
+        static const uint32_t kShardCount = 64;
+
+        // Calls visit(value, inserted) with the value of key, inserting create() first if there is none.
+        template <typename Create, typename Visit>
+        void FindOrInsert(const Key& key, Create&& create, Visit&& visit)
+        {
+            Shard& shard = GetShard(key);
+            std::lock_guard<std::mutex> guard(shard.Mutex);
+
+            auto iter = shard.Map.find(key);
+            const bool inserted = iter == shard.Map.end();
+            if (inserted)
+                iter = shard.Map.emplace(key, create()).first;
+
+            visit(iter->second, inserted);
+        }
+
+        bool Contains(const Key& key) const
+        {
+            const Shard& shard = GetShard(key);
+            std::lock_guard<std::mutex> guard(shard.Mutex);
+            return shard.Map.count(key) != 0;
+        }
+
+        // Erases the value of key if predicate(value) returns true.  Returns whether it was erased.
+        template <typename Predicate>
+        bool EraseIf(const Key& key, Predicate&& predicate)
+        {
+            Shard& shard = GetShard(key);
+            std::lock_guard<std::mutex> guard(shard.Mutex);
+
+            auto iter = shard.Map.find(key);
+            if (iter == shard.Map.end() || !predicate(iter->second))
+                return false;
+
+            shard.Map.erase(iter);
+            return true;
+        }
+
+        void Clear()
+        {
+            for (Shard& shard : m_Shards)
+            {
+                std::lock_guard<std::mutex> guard(shard.Mutex);
+                shard.Map.clear();
+            }
+        }
+
+        size_t GetSize() const
+        {
+            size_t size = 0;
+            for (const Shard& shard : m_Shards)
+            {
+                std::lock_guard<std::mutex> guard(shard.Mutex);
+                size += shard.Map.size();
+            }
+            return size;
+        }
+
+    private:
+        struct Shard
+        {
+            mutable std::mutex Mutex;
+            std::unordered_map<Key, Value, Hasher> Map;
+        };
+
+        Shard& GetShard(const Key& key)
+        {
+            return const_cast<Shard&>(static_cast<const ShardedCache*>(this)->GetShard(key));
+        }
+
+        const Shard& GetShard(const Key& key) const
+        {
+            // The maps of the shards bucket keys by the low bits of the same hash, so the shard is chosen by the
+            // high bits of a multiplicative rehash to keep the keys of a shard spread over its buckets.
+            const uint64_t hash = (uint64_t)Hasher()(key) * 0x9E3779B97F4A7C15ull;
+            return m_Shards[hash >> 58];
+        }
+
+        static_assert(kShardCount == 64, "GetShard() takes 6 bits of the hash");
+
+        Shard m_Shards[kShardCount];
+    };
+
+} // namespace Utility
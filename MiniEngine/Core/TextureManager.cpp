@@ -19,8 +19,10 @@
 #include "FileUtility.h"
 #include "GraphicsCommon.h"
 #include "CommandContext.h"
-#include <map>
-#include <thread>
+#include "IOThreadPool.h"
+#include "ShardedCache.h"
+#include <atomic>
+#include <future>
 
 using namespace std;
 using namespace Graphics;
@@ -42,6 +44,7 @@ public:
 
     void WaitForLoad(void) const;
     void CreateFromMemory(ByteArray memory, eDefaultTexture fallback, bool sRGB);
+    bool IsReferenced(void) const { return m_ReferenceCount > 0; }
 
 private:
 
@@ -50,77 +53,96 @@ private:
 
     std::wstring m_MapKey;		// For deleting from the map later
     bool m_IsValid;
-    bool m_IsLoading;
-    size_t m_ReferenceCount;
+    promise<void> m_Loaded;
+    shared_future<void> m_LoadedFuture;
+    atomic<size_t> m_ReferenceCount;
 };
 
 namespace TextureManager
 {
     wstring s_RootPath = L"";
-    map<wstring, std::unique_ptr<ManagedTexture>> s_TextureCache;
+
+    // Sharded so that threads loading different textures do not contend, and nothing waits for a load
+    // while it holds a shard lock.
+    Utility::ShardedCache<wstring, std::unique_ptr<ManagedTexture>> s_TextureCache;
+
+    // Files are read on these threads, which overlap the reads of concurrent loads and run read-aheads.
+    std::unique_ptr<Utility::IOThreadPool> s_IOThreadPool;
 
     void Initialize( const wstring& TextureLibRoot )
     {
         s_RootPath = TextureLibRoot;
+        s_IOThreadPool.reset(new Utility::IOThreadPool());
     }
 
     void Shutdown( void )
     {
-        s_TextureCache.clear();
+        s_IOThreadPool.reset();
+        s_TextureCache.Clear();
     }
 
-    mutex s_Mutex;
-
-    ManagedTexture* FindOrLoadTexture( const wstring& fileName, eDefaultTexture fallback, bool forceSRGB )
+    // Textures loaded as sRGB are separate entries of the cache
+    wstring GetCacheKey( const wstring& fileName, bool forceSRGB )
     {
-        ManagedTexture* tex = nullptr;
+        return forceSRGB ? fileName + L"_sRGB" : fileName;
+    }
 
-        {
-            lock_guard<mutex> Guard(s_Mutex);
+    void ReadAhead( const wstring& filePath, bool sRGB )
+    {
+        if (s_IOThreadPool && !s_TextureCache.Contains(GetCacheKey(filePath, sRGB)))
+            s_IOThreadPool->ReadAhead(Utility::ToUTF8FileName(s_RootPath + filePath));
+    }
 
-            wstring key = fileName;
-            if (forceSRGB)
-                key += L"_sRGB";
+    TextureRef FindOrLoadTexture( const wstring& fileName, eDefaultTexture fallback, bool forceSRGB )
+    {
+        const wstring key = GetCacheKey(fileName, forceSRGB);
 
-            // Search for an existing managed texture
-            auto iter = s_TextureCache.find(key);
-            if (iter != s_TextureCache.end())
-            {
-                // If a texture was already created make sure it has finished loading before
-                // returning a point to it.
-                tex = iter->second.get();
-                tex->WaitForLoad();
-                return tex;
-            }
-            else
+        // The reference is taken under the shard lock, so that DestroyTexture() cannot free a texture
+        // between finding it and referencing it.
+        ManagedTexture* tex = nullptr;
+        TextureRef ref;
+        bool mustLoad = false;
+        s_TextureCache.FindOrInsert(key,
+            [&] { return std::unique_ptr<ManagedTexture>(new ManagedTexture(key)); },
+            [&](std::unique_ptr<ManagedTexture>& managed, bool inserted)
             {
-                // If it's not found, create a new managed texture and start loading it
-                tex = new ManagedTexture(key);
-                s_TextureCache[key].reset(tex);
-            }
+                tex = managed.get();
+                TextureRef found(tex);
+                ref = found;
+                mustLoad = inserted;
+            });
+
+        if (!mustLoad)
+        {
+            // If a texture was already created make sure it has finished loading before
+            // returning a pointer to it.
+            tex->WaitForLoad();
+            return ref;
         }
 
-        Utility::ByteArray ba = Utility::ReadFileSync( s_RootPath + fileName );
+        // This was the first time it was requested, so this thread loads it
+        Utility::ByteArray ba;
+        if (s_IOThreadPool)
+            ba = s_IOThreadPool->Read(Utility::ToUTF8FileName(s_RootPath + fileName)).get();
+        else
+            ba = Utility::ReadFileSync( s_RootPath + fileName );
         tex->CreateFromMemory(ba, fallback, forceSRGB);
 
-        // This was the first time it was requested, so indicate that the caller must read the file
-        return tex;
+        return ref;
     }
 
     void DestroyTexture(const wstring& key)
     {
-        lock_guard<mutex> Guard(s_Mutex);
-
-        auto iter = s_TextureCache.find(key);
-        if (iter != s_TextureCache.end())
-            s_TextureCache.erase(iter);
+        // The texture may have been referenced again since its count dropped to zero.
+        s_TextureCache.EraseIf(key, [](const std::unique_ptr<ManagedTexture>& tex) { return !tex->IsReferenced(); });
     }
 
 } // namespace TextureManager
 
 ManagedTexture::ManagedTexture( const wstring& FileName )
-    : m_MapKey(FileName), m_IsValid(false), m_IsLoading(true), m_ReferenceCount(0)
+    : m_MapKey(FileName), m_IsValid(false), m_ReferenceCount(0)
 {
+    m_LoadedFuture = m_Loaded.get_future().share();
     m_hCpuDescriptorHandle.ptr = D3D12_GPU_VIRTUAL_ADDRESS_UNKNOWN;
 }
 
@@ -152,13 +174,13 @@ void ManagedTexture::CreateFromMemory(ByteArray ba, eDefaultTexture fallback, bo
         }
     }
 
-    m_IsLoading = false;
+    m_Loaded.set_value();
 }
 
 void ManagedTexture::WaitForLoad( void ) const
 {
-    while ((volatile bool&)m_IsLoading)
-        this_thread::yield();
+    // Blocks without spinning.  The loading thread holds no cache lock, so this never stalls other lookups.
+    m_LoadedFuture.wait();
 }
 
 void ManagedTexture::Unload()
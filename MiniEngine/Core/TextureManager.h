@@ -40,6 +40,11 @@ namespace TextureManager
     // texture cannot be found, ref->IsValid() will return false.
     TextureRef LoadDDSFromFile( const std::wstring& filePath, eDefaultTexture fallback = kMagenta2D, bool sRGB = false );
     TextureRef LoadDDSFromFile( const std::string& filePath, eDefaultTexture fallback = kMagenta2D, bool sRGB = false );
+
+    // Starts reading a DDS file on the I/O threads so that a later LoadDDSFromFile() of it, with the same
+    // sRGB, finds the data in memory.  Does nothing if that texture is already loaded, since the load would
+    // not read the file.  Loads are safe to issue from many threads at once.
+    void ReadAhead( const std::wstring& filePath, bool sRGB = false );
 }
 
 // Forward declaration; private implementation
@@ -0,0 +1,230 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+
+#include "TextureStreamer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+namespace Utility
+{
+    float GetMipForBounds(const float boxMin[3], const float boxMax[3], const StreamingView& view, float texelsPerUnit)
+    {
+        float distanceSquared = 0.0f;
+        for (int i = 0; i < 3; ++i)
+        {
+            const float outside = std::max(std::max(boxMin[i] - view.Eye[i], view.Eye[i] - boxMax[i]), 0.0f);
+            distanceSquared += outside * outside;
+        }
+
+        // A pixel covers distance / PixelsPerUnit world units there, and so texelsPerUnit times as many texels.
+        const float texelsPerPixel = texelsPerUnit * std::sqrt(distanceSquared) / view.PixelsPerUnit;
+        return std::log2(std::max(texelsPerPixel, 1.0f));
+    }
+
+    float GetFootprint(const float boxMin[3], const float boxMax[3], const StreamingView& view)
+    {
+        float radiusSquared = 0.0f;
+        float distanceSquared = 0.0f;
+        for (int i = 0; i < 3; ++i)
+        {
+            const float halfExtent = (boxMax[i] - boxMin[i]) * 0.5f;
+            const float toCenter = boxMin[i] + halfExtent - view.Eye[i];
+            radiusSquared += halfExtent * halfExtent;
+            distanceSquared += toCenter * toCenter;
+        }
+
+        if (distanceSquared <= radiusSquared)
+            return view.ViewportPixels;
+
+        const float footprint = 3.14159265f * radiusSquared / distanceSquared * view.PixelsPerUnit * view.PixelsPerUnit;
+        return std::min(footprint, view.ViewportPixels);
+    }
+
+    TextureStreamer::TextureStreamer(TextureUploadSink& sink, const TextureStreamerOptions& options)
+        : m_Sink(sink), m_Options(options)
+    {
+    }
+
+    uint32_t TextureStreamer::AddTexture(const std::string& fileName)
+    {
+        StreamedTexture texture;
+        DDSTextureInfo& info = texture.Info;
+        if (!texture.File.Open(fileName) || !GetDDSTextureInfo(texture.File.GetData(), texture.File.GetSize(), info))
+            return kInvalidTexture;
+
+        // Lay out every mip, and the mips that the loader would keep with a maxsize of TailSize.  Neither reads the
+        // texels, so only the pages of the header have been touched so far.
+        size_t width, height, depth, skipMip;
+        texture.Subresources.resize((size_t)info.mipCount * info.arraySize);
+        if (!FillDDSSubresourceData(info.width, info.height, info.depth, info.mipCount, info.arraySize, info.format, 0,
+                info.bitSize, info.bitData, width, height, depth, skipMip, texture.Subresources.data()))
+            return kInvalidTexture;
+
+        std::vector<DDSSubresourceData> tail(texture.Subresources.size());
+        FillDDSSubresourceData(info.width, info.height, info.depth, info.mipCount, info.arraySize, info.format,
+            m_Options.TailSize, info.bitSize, info.bitData, width, height, depth, skipMip, tail.data());
+
+        // A texture whose smallest mip is larger than the tail size keeps just that mip.
+        texture.TailMip = std::min((uint32_t)skipMip, info.mipCount - 1);
+        texture.ResidentMip = info.mipCount;
+        texture.RequestedMip = texture.TailMip;
+        texture.Footprint = 0.0f;
+
+        size_t textureBytes = 0;
+        texture.MipBytes.resize(info.mipCount);
+        for (uint32_t mip = 0; mip < info.mipCount; ++mip)
+        {
+            const size_t mipDepth = std::max<size_t>(info.depth >> mip, 1);
+            texture.MipBytes[mip] = texture.Subresources[mip].SlicePitch * mipDepth * info.arraySize;
+            textureBytes += texture.MipBytes[mip];
+        }
+
+        const uint32_t textureIndex = (uint32_t)m_Textures.size();
+        if (!m_Sink.CreateTexture(textureIndex, info))
+            return kInvalidTexture;
+        m_TotalBytes += textureBytes;
+
+        // The mapping does not move with the MappedFile, so Info and Subresources stay valid.
+        m_Textures.push_back(std::move(texture));
+        UploadMips(textureIndex, m_Textures.back().TailMip, info.mipCount - m_Textures.back().TailMip);
+        return textureIndex;
+    }
+
+    void TextureStreamer::Request(uint32_t textureIndex, float mip, float footprint)
+    {
+        StreamedTexture& texture = m_Textures[textureIndex];
+        const uint32_t requestedMip = (uint32_t)std::min(std::max(mip, 0.0f), (float)texture.TailMip);
+        texture.RequestedMip = std::min(texture.RequestedMip, requestedMip);
+        texture.Footprint = std::max(texture.Footprint, footprint);
+    }
+
+    void TextureStreamer::RequestForBounds(uint32_t textureIndex, const float boxMin[3], const float boxMax[3], const StreamingView& view, float texcoordsPerUnit)
+    {
+        const DDSTextureInfo& info = m_Textures[textureIndex].Info;
+        const float texelsPerUnit = texcoordsPerUnit * (float)std::max(info.width, info.height);
+        Request(textureIndex, GetMipForBounds(boxMin, boxMax, view, texelsPerUnit), GetFootprint(boxMin, boxMax, view));
+    }
+
+    size_t TextureStreamer::Update()
+    {
+        std::vector<uint32_t> pending;
+        std::vector<uint32_t> evictable;
+        for (uint32_t textureIndex = 0; textureIndex < (uint32_t)m_Textures.size(); ++textureIndex)
+        {
+            const StreamedTexture& texture = m_Textures[textureIndex];
+            if (texture.ResidentMip > texture.RequestedMip)
+                pending.push_back(textureIndex);
+            else if (texture.ResidentMip < texture.RequestedMip)
+                evictable.push_back(textureIndex);
+        }
+
+        // The largest footprints are uploaded first, and the unneeded mips of the smallest are evicted first.
+        std::stable_sort(pending.begin(), pending.end(),
+            [this](uint32_t a, uint32_t b) { return m_Textures[a].Footprint > m_Textures[b].Footprint; });
+        std::stable_sort(evictable.begin(), evictable.end(),
+            [this](uint32_t a, uint32_t b) { return m_Textures[a].Footprint < m_Textures[b].Footprint; });
+
+        // One mip per texture and pass, so that the textures in front share the bytes of a frame instead of the first
+        // one taking them all for its largest mips.  A mip larger than the bytes per frame is uploaded on its own.
+        size_t uploadedBytes = 0;
+        for (bool uploaded = true; uploaded; )
+        {
+            uploaded = false;
+            for (uint32_t textureIndex : pending)
+            {
+                const StreamedTexture& texture = m_Textures[textureIndex];
+                if (texture.ResidentMip <= texture.RequestedMip)
+                    continue;
+
+                const uint32_t mip = texture.ResidentMip - 1;
+                const size_t bytes = texture.MipBytes[mip];
+                if (uploadedBytes > 0 && uploadedBytes + bytes > m_Options.UploadBytesPerFrame)
+                    continue;
+
+                if (m_Options.MemoryBudget > 0 && m_ResidentBytes + bytes > m_Options.MemoryBudget &&
+                    !EvictUnneeded(m_ResidentBytes + bytes - m_Options.MemoryBudget, evictable))
+                    continue;
+
+                UploadMips(textureIndex, mip, 1);
+                uploadedBytes += bytes;
+                uploaded = true;
+            }
+        }
+
+        // Let the OS read the next mips of what is left while this frame renders.
+        m_IsSettled = true;
+        for (uint32_t textureIndex : pending)
+        {
+            const StreamedTexture& texture = m_Textures[textureIndex];
+            if (texture.ResidentMip <= texture.RequestedMip)
+                continue;
+
+            m_IsSettled = false;
+            const uint32_t mip = texture.ResidentMip - 1;
+            for (uint32_t slice = 0; slice < texture.Info.arraySize; ++slice)
+            {
+                const DDSSubresourceData& subresource = texture.Subresources[(size_t)slice * texture.Info.mipCount + mip];
+                texture.File.Prefetch(subresource.pData - texture.File.GetData(), texture.MipBytes[mip] / texture.Info.arraySize);
+            }
+        }
+
+        for (StreamedTexture& texture : m_Textures)
+        {
+            texture.RequestedMip = texture.TailMip;
+            texture.Footprint = 0.0f;
+        }
+
+        return uploadedBytes;
+    }
+
+    void TextureStreamer::UploadMips(uint32_t textureIndex, uint32_t firstMip, uint32_t mipCount)
+    {
+        StreamedTexture& texture = m_Textures[textureIndex];
+
+        std::vector<DDSSubresourceData> subresources;
+        subresources.reserve((size_t)mipCount * texture.Info.arraySize);
+        for (uint32_t slice = 0; slice < texture.Info.arraySize; ++slice)
+        {
+            const DDSSubresourceData* sliceMips = texture.Subresources.data() + (size_t)slice * texture.Info.mipCount;
+            subresources.insert(subresources.end(), sliceMips + firstMip, sliceMips + firstMip + mipCount);
+        }
+
+        m_Sink.UploadMips(textureIndex, firstMip, mipCount, subresources.data());
+
+        for (uint32_t mip = firstMip; mip < firstMip + mipCount; ++mip)
+            m_ResidentBytes += texture.MipBytes[mip];
+        texture.ResidentMip = firstMip;
+    }
+
+    void TextureStreamer::EvictMips(uint32_t textureIndex, uint32_t firstMip)
+    {
+        StreamedTexture& texture = m_Textures[textureIndex];
+
+        m_Sink.EvictMips(textureIndex, firstMip);
+
+        for (uint32_t mip = texture.ResidentMip; mip < firstMip; ++mip)
+            m_ResidentBytes -= texture.MipBytes[mip];
+        texture.ResidentMip = firstMip;
+    }
+
+    // Evicts the mips above the requested ones of the textures in evictable, in order, until bytes are freed.
+    bool TextureStreamer::EvictUnneeded(size_t bytes, std::vector<uint32_t>& evictable)
+    {
+        const size_t residentBytes = m_ResidentBytes;
+        auto next = evictable.begin();
+        for (; next != evictable.end() && residentBytes - m_ResidentBytes < bytes; ++next)
+            EvictMips(*next, m_Textures[*next].RequestedMip);
+        evictable.erase(evictable.begin(), next);
+
+        return residentBytes - m_ResidentBytes >= bytes;
+    }
+
+} // namespace Utility
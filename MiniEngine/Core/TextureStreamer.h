@@ -0,0 +1,135 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+
+#pragma once
+
+// Streaming of DDS textures.  The mip tails of the textures are uploaded first, so a scene can be drawn once its
+// files are mapped.  The larger mips follow on demand, and the textures that cover the most pixels go first.  Mips
+// are read straight from file mappings in the layout of FillDDSSubresourceData().  A TextureUploadSink copies them
+// wherever the textures live: the GPU, or memory for tools and benchmarks.
+// This header does not depend on pch.h so that it can be shared with portable (non-D3D12) tools.
+// It sticks to C++14 like the rest of Core.
+#include "DDSFormat.h"
+#include "MappedFile.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Utility
+{
+    // Receives the mips that a TextureStreamer makes resident
+    class TextureUploadSink
+    {
+    public:
+        virtual ~TextureUploadSink() {}
+
+        // Creates a texture with every mip of info and none resident.  Returns false if it cannot be created.
+        virtual bool CreateTexture(uint32_t textureIndex, const DDSTextureInfo& info) = 0;
+
+        // Uploads mips [firstMip, firstMip + mipCount) of every array slice.  subresources holds mipCount entries per
+        // array slice, one slice after another.  They point into the file mapping and stay valid only during the call.
+        // Sampling may use firstMip from the next frame on.
+        virtual void UploadMips(uint32_t textureIndex, uint32_t firstMip, uint32_t mipCount, const DDSSubresourceData* subresources) = 0;
+
+        // Stops sampling the mips above firstMip and releases them.
+        virtual void EvictMips(uint32_t textureIndex, uint32_t firstMip) = 0;
+    };
+
+    // Where the textures are seen from, for the mips and footprints of mesh bounds
+    struct StreamingView
+    {
+        float Eye[3];
+        float PixelsPerUnit;    // Pixels that one world unit covers at distance 1: half the viewport height times the projection scale Y
+        float ViewportPixels;   // Width times height, the largest footprint
+    };
+
+    // The mip at which one texel covers about one pixel at the point of the box nearest to the eye, for a surface of
+    // texelsPerUnit texels per world unit.  Not below 0.
+    float GetMipForBounds(const float boxMin[3], const float boxMax[3], const StreamingView& view, float texelsPerUnit);
+
+    // The pixels that the bounding sphere of the box covers, at most the viewport
+    float GetFootprint(const float boxMin[3], const float boxMax[3], const StreamingView& view);
+
+    struct TextureStreamerOptions
+    {
+        uint32_t TailSize = 64;                         // AddTexture() uploads the mips no larger than this
+        size_t UploadBytesPerFrame = 16 * 1024 * 1024;  // Bound of the mips that one Update() uploads
+        size_t MemoryBudget = 0;                        // Resident bytes above which mips that no request needs are evicted; 0 for no bound
+    };
+
+    // Streams the mips of DDS textures through a sink.  The tail of a texture stays resident from AddTexture() on.
+    // Each frame, Request() asks for the mips that the visible textures need, and Update() uploads them.  Not thread
+    // safe: call it from the thread that records the uploads.
+    class TextureStreamer
+    {
+    public:
+        static const uint32_t kInvalidTexture = ~0u;
+
+        explicit TextureStreamer(TextureUploadSink& sink, const TextureStreamerOptions& options = TextureStreamerOptions());
+
+        TextureStreamer(const TextureStreamer&) = delete;
+        TextureStreamer& operator=(const TextureStreamer&) = delete;
+
+        // Maps a DDS file and uploads its mip tail.  Only the header and the tail are read from the file.  fileName is
+        // UTF-8.  Returns kInvalidTexture if the file cannot be read or the sink cannot create the texture.
+        uint32_t AddTexture(const std::string& fileName);
+
+        // Asks for a texture to be resident down to the integer part of mip during this frame.  Uploads go in the
+        // order of footprint, the pixels that the texture covers.  The requests of a frame are combined: the lowest
+        // mip and the largest footprint count.
+        void Request(uint32_t textureIndex, float mip, float footprint);
+
+        // Request() for a mesh with these bounds, mapping the texture at texcoordsPerUnit texture coordinate units per
+        // world unit (H3DData::ComputeTexcoordDensity()).
+        void RequestForBounds(uint32_t textureIndex, const float boxMin[3], const float boxMax[3], const StreamingView& view, float texcoordsPerUnit);
+
+        // Ends a frame.  Evicts mips that no request needs when over the memory budget, uploads requested mips up to
+        // the bytes per frame, and hints the OS to read the mips left for the next frame.  The requests are cleared.
+        // Returns the bytes uploaded.
+        size_t Update();
+
+        uint32_t GetTextureCount() const { return (uint32_t)m_Textures.size(); }
+        const DDSTextureInfo& GetInfo(uint32_t textureIndex) const { return m_Textures[textureIndex].Info; }
+        uint32_t GetResidentMip(uint32_t textureIndex) const { return m_Textures[textureIndex].ResidentMip; }
+
+        // Bytes of the resident mips of every texture, and of all mips of every texture
+        size_t GetResidentBytes() const { return m_ResidentBytes; }
+        size_t GetTotalBytes() const { return m_TotalBytes; }
+
+        // Every request of the last Update() was met.
+        bool IsSettled() const { return m_IsSettled; }
+
+    private:
+        struct StreamedTexture
+        {
+            MappedFile File;
+            DDSTextureInfo Info;
+            std::vector<DDSSubresourceData> Subresources;   // Of every mip, as FillDDSSubresourceData() lays them out
+            std::vector<size_t> MipBytes;                   // Of each mip across the array slices
+            uint32_t TailMip;                               // The first mip of the tail, which is never evicted
+            uint32_t ResidentMip;
+            uint32_t RequestedMip;                          // TailMip when nothing requested more this frame
+            float Footprint;
+        };
+
+        void UploadMips(uint32_t textureIndex, uint32_t firstMip, uint32_t mipCount);
+        void EvictMips(uint32_t textureIndex, uint32_t firstMip);
+        bool EvictUnneeded(size_t bytes, std::vector<uint32_t>& evictable);
+
+        TextureUploadSink& m_Sink;
+        const TextureStreamerOptions m_Options;
+        std::vector<StreamedTexture> m_Textures;
+        size_t m_ResidentBytes = 0;
+        size_t m_TotalBytes = 0;
+        bool m_IsSettled = true;
+    };
+
+} // namespace Utility
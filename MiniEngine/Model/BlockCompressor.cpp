@@ -0,0 +1,1150 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+
+#include "BlockCompressor.h"
+#include "TextureConvert.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <thread>
+#include <vector>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+namespace
+{
+    // Subset 1 of the 2-subset partitions of BC7, one bit per texel
+    const uint16_t kPartitions2[64] =
+    {
+        0xCCCC, 0x8888, 0xEEEE, 0xECC8, 0xC880, 0xFEEC, 0xFEC8, 0xEC80, 0xC800, 0xFFEC, 0xFE80, 0xE800, 0xFFE8, 0xFF00, 0xFFF0, 0xF000,
+        0xF710, 0x008E, 0x7100, 0x08CE, 0x008C, 0x7310, 0x3100, 0x8CCE, 0x088C, 0x3110, 0x6666, 0x366C, 0x17E8, 0x0FF0, 0x718E, 0x399C,
+        0xAAAA, 0xF0F0, 0x5A5A, 0x33CC, 0x3C3C, 0x55AA, 0x9696, 0xA55A, 0x73CE, 0x13C8, 0x324C, 0x3BDC, 0x6996, 0xC33C, 0x9966, 0x0660,
+        0x0272, 0x04E4, 0x4E40, 0x2720, 0xC936, 0x936C, 0x39C6, 0x639C, 0x9336, 0x9CC6, 0x817E, 0xE718, 0xCCF0, 0x0FCC, 0x7744, 0xEE22,
+    };
+
+    // The texel of subset 1 whose index drops its most significant bit.  Texel 0 is the anchor of subset 0.
+    const uint8_t kAnchors2[64] =
+    {
+        15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 2, 8, 2, 2, 8, 8, 15, 2, 8, 2, 2, 8, 8, 2, 2,
+        15, 15, 6, 8, 2, 8, 15, 15, 2, 8, 2, 2, 2, 15, 15, 6, 6, 2, 6, 8, 15, 15, 2, 2, 15, 15, 15, 15, 15, 2, 2, 15,
+    };
+
+    const uint16_t kAllTexels = 0xFFFF;
+
+    // Palettes as weights of the second endpoint, in index order
+    const float kBC1Weights[4] = { 0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f };
+    const float kBC1Weights3[3] = { 0.0f, 1.0f, 0.5f };     // With index 3 transparent black
+    const float kBC7Weights2[4] = { 0.0f, 21 / 64.0f, 43 / 64.0f, 1.0f };
+    const float kBC7Weights3[8] = { 0.0f, 9 / 64.0f, 18 / 64.0f, 27 / 64.0f, 37 / 64.0f, 46 / 64.0f, 55 / 64.0f, 1.0f };
+    const float kBC7Weights4[16] = { 0.0f, 4 / 64.0f, 9 / 64.0f, 13 / 64.0f, 17 / 64.0f, 21 / 64.0f, 26 / 64.0f, 30 / 64.0f,
+        34 / 64.0f, 38 / 64.0f, 43 / 64.0f, 47 / 64.0f, 51 / 64.0f, 55 / 64.0f, 60 / 64.0f, 1.0f };
+
+    struct Palette
+    {
+        const float* weights;
+        uint32_t size;
+    };
+
+    const Palette kBC1Palette = { kBC1Weights, 4 };
+    const Palette kBC1Palette3 = { kBC1Weights3, 3 };
+    const Palette kBC7Palette2 = { kBC7Weights2, 4 };
+    const Palette kBC7Palette3 = { kBC7Weights3, 8 };
+    const Palette kBC7Palette4 = { kBC7Weights4, 16 };
+
+    // Texels of a block as 0-255 values
+    struct Block
+    {
+        float texels[16][4];
+    };
+
+    enum class PBit : uint8_t
+    {
+        kNone,
+        kShared,    // One for both endpoints of a subset (BC7 mode 1)
+        kUnique,    // One per endpoint (BC7 mode 6)
+    };
+
+    // How endpoints are stored.  A channel of 0 bits always decodes to 255.
+    struct EndpointFormat
+    {
+        uint8_t bits[4];
+        PBit pbit;
+    };
+
+    const EndpointFormat kBC1Endpoints = { { 5, 6, 5, 0 }, PBit::kNone };
+    const EndpointFormat kMode1Endpoints = { { 6, 6, 6, 0 }, PBit::kShared };
+    const EndpointFormat kMode5ColorEndpoints = { { 7, 7, 7, 0 }, PBit::kNone };
+    const EndpointFormat kMode5AlphaEndpoints = { { 0, 0, 0, 8 }, PBit::kNone };
+    const EndpointFormat kMode6Endpoints = { { 7, 7, 7, 7 }, PBit::kUnique };
+    const EndpointFormat kMode7Endpoints = { { 5, 5, 5, 5 }, PBit::kUnique };
+
+    struct Endpoints
+    {
+        int code[2][4];
+        int pbit[2];
+        float value[2][4];  // Decoded, 0-255
+    };
+
+    float Expand(int code, int pbit, uint32_t bits, PBit pbitMode)
+    {
+        if (bits == 0)
+            return 255.0f;
+
+        const uint32_t n = bits + (pbitMode != PBit::kNone ? 1 : 0);
+        const uint32_t v = pbitMode != PBit::kNone ? ((uint32_t)code << 1) | (uint32_t)pbit : (uint32_t)code;
+        return (float)(n >= 8 ? v : (v << (8 - n)) | (v >> (2 * n - 8)));
+    }
+
+    void UpdateValues(Endpoints& endpoints, const EndpointFormat& format)
+    {
+        for (uint32_t e = 0; e < 2; ++e)
+            for (uint32_t c = 0; c < 4; ++c)
+                endpoints.value[e][c] = Expand(endpoints.code[e][c], endpoints.pbit[e], format.bits[c], format.pbit);
+    }
+
+    // The code of bits whose expansion with pbit is nearest to value
+    int QuantizeChannel(float value, int pbit, uint32_t bits, PBit pbitMode)
+    {
+        if (bits == 0)
+            return 0;
+
+        const int maxCode = (1 << bits) - 1;
+        const uint32_t n = bits + (pbitMode != PBit::kNone ? 1 : 0);
+        const float scaled = value / 255.0f * (float)((1 << n) - 1);
+        const int guess = (int)std::lround(pbitMode != PBit::kNone ? (scaled - (float)pbit) * 0.5f : scaled);
+
+        int bestCode = 0;
+        float bestError = std::numeric_limits<float>::max();
+        for (int code = std::max(guess - 1, 0); code <= std::min(guess + 1, maxCode); ++code)
+        {
+            const float error = std::abs(Expand(code, pbit, bits, pbitMode) - value);
+            if (error < bestError)
+            {
+                bestError = error;
+                bestCode = code;
+            }
+        }
+        return bestCode;
+    }
+
+    // The quantized endpoints nearest to the float endpoints e, one for every p-bit choice of the format
+    uint32_t QuantizeEndpoints(const float (&e)[2][4], const EndpointFormat& format, Endpoints* candidates)
+    {
+        const uint32_t pbitChoices = format.pbit == PBit::kNone ? 1 : format.pbit == PBit::kShared ? 2 : 4;
+
+        for (uint32_t choice = 0; choice < pbitChoices; ++choice)
+        {
+            Endpoints& candidate = candidates[choice];
+            candidate.pbit[0] = (int)(choice & 1);
+            candidate.pbit[1] = format.pbit == PBit::kShared ? candidate.pbit[0] : (int)(choice >> 1);
+
+            for (uint32_t i = 0; i < 2; ++i)
+                for (uint32_t c = 0; c < 4; ++c)
+                    candidate.code[i][c] = QuantizeChannel(e[i][c], candidate.pbit[i], format.bits[c], format.pbit);
+
+            UpdateValues(candidate, format);
+        }
+
+        return pbitChoices;
+    }
+
+    // Weighted squared error of the texels of mask against the nearest palette entry of each candidate
+    void EvaluateCandidates(const Block& block, uint16_t mask, const float (&channelWeights)[4], const Palette& palette,
+        const Endpoints* candidates, uint32_t count, float* errors)
+    {
+        uint32_t first = 0;
+
+#if defined(__AVX2__)
+        // One candidate per lane, unless too few of the lanes would be used
+        for (; count >= 4 && first < count; first += 8)
+        {
+            alignas(32) float e0[4][8];
+            alignas(32) float delta[4][8];
+            for (uint32_t lane = 0; lane < 8; ++lane)
+            {
+                const Endpoints& candidate = candidates[std::min(first + lane, count - 1)];
+                for (uint32_t c = 0; c < 4; ++c)
+                {
+                    e0[c][lane] = candidate.value[0][c];
+                    delta[c][lane] = candidate.value[1][c] - candidate.value[0][c];
+                }
+            }
+
+            __m256 vE0[4], vDelta[4];
+            for (uint32_t c = 0; c < 4; ++c)
+            {
+                vE0[c] = _mm256_load_ps(e0[c]);
+                vDelta[c] = _mm256_load_ps(delta[c]);
+            }
+
+            __m256 total = _mm256_setzero_ps();
+            for (uint32_t t = 0; t < 16; ++t)
+            {
+                if ((mask & (1u << t)) == 0)
+                    continue;
+
+                __m256 best = _mm256_set1_ps(std::numeric_limits<float>::max());
+                for (uint32_t k = 0; k < palette.size; ++k)
+                {
+                    const __m256 weight = _mm256_set1_ps(palette.weights[k]);
+                    __m256 error = _mm256_setzero_ps();
+                    for (uint32_t c = 0; c < 4; ++c)
+                    {
+                        if (channelWeights[c] == 0.0f)
+                            continue;
+
+                        const __m256 entry = _mm256_fmadd_ps(vDelta[c], weight, vE0[c]);
+                        const __m256 difference = _mm256_sub_ps(_mm256_set1_ps(block.texels[t][c]), entry);
+                        error = _mm256_fmadd_ps(_mm256_mul_ps(difference, _mm256_set1_ps(channelWeights[c])), difference, error);
+                    }
+                    best = _mm256_min_ps(best, error);
+                }
+                total = _mm256_add_ps(total, best);
+            }
+
+            alignas(32) float laneErrors[8];
+            _mm256_store_ps(laneErrors, total);
+            for (uint32_t lane = 0; lane < 8 && first + lane < count; ++lane)
+                errors[first + lane] = laneErrors[lane];
+        }
+#endif
+
+        for (uint32_t i = first; i < count; ++i)
+        {
+            const Endpoints& candidate = candidates[i];
+            float total = 0.0f;
+            for (uint32_t t = 0; t < 16; ++t)
+            {
+                if ((mask & (1u << t)) == 0)
+                    continue;
+
+                float best = std::numeric_limits<float>::max();
+                for (uint32_t k = 0; k < palette.size; ++k)
+                {
+                    float error = 0.0f;
+                    for (uint32_t c = 0; c < 4; ++c)
+                    {
+                        const float entry = candidate.value[0][c] + (candidate.value[1][c] - candidate.value[0][c]) * palette.weights[k];
+                        const float difference = block.texels[t][c] - entry;
+                        error += channelWeights[c] * difference * difference;
+                    }
+                    best = std::min(best, error);
+                }
+                total += best;
+            }
+            errors[i] = total;
+        }
+    }
+
+    // Sets the index of the nearest palette entry of each texel of mask and returns the error
+    float AssignIndices(const Block& block, uint16_t mask, const float (&channelWeights)[4], const Palette& palette,
+        const Endpoints& endpoints, uint8_t (&indices)[16])
+    {
+        float total = 0.0f;
+        for (uint32_t t = 0; t < 16; ++t)
+        {
+            if ((mask & (1u << t)) == 0)
+                continue;
+
+            float best = std::numeric_limits<float>::max();
+            for (uint32_t k = 0; k < palette.size; ++k)
+            {
+                float error = 0.0f;
+                for (uint32_t c = 0; c < 4; ++c)
+                {
+                    const float entry = endpoints.value[0][c] + (endpoints.value[1][c] - endpoints.value[0][c]) * palette.weights[k];
+                    const float difference = block.texels[t][c] - entry;
+                    error += channelWeights[c] * difference * difference;
+                }
+                if (error < best)
+                {
+                    best = error;
+                    indices[t] = (uint8_t)k;
+                }
+            }
+            total += best;
+        }
+        return total;
+    }
+
+    // The endpoints that fit the texels of mask best in the least squares sense for fixed indices.  Returns false if
+    // every texel has the same weight, which leaves the endpoints undetermined.
+    bool FitEndpoints(const Block& block, uint16_t mask, const Palette& palette, const uint8_t (&indices)[16], float (&e)[2][4])
+    {
+        float aa = 0.0f, ab = 0.0f, bb = 0.0f;
+        float ax[4] = {}, bx[4] = {};
+        for (uint32_t t = 0; t < 16; ++t)
+        {
+            if ((mask & (1u << t)) == 0)
+                continue;
+
+            const float b = palette.weights[indices[t]];
+            const float a = 1.0f - b;
+            aa += a * a;
+            ab += a * b;
+            bb += b * b;
+            for (uint32_t c = 0; c < 4; ++c)
+            {
+                ax[c] += a * block.texels[t][c];
+                bx[c] += b * block.texels[t][c];
+            }
+        }
+
+        const float determinant = aa * bb - ab * ab;
+        if (std::abs(determinant) < 1.0e-6f)
+            return false;
+
+        const float invDeterminant = 1.0f / determinant;
+        for (uint32_t c = 0; c < 4; ++c)
+        {
+            e[0][c] = std::min(std::max((ax[c] * bb - bx[c] * ab) * invDeterminant, 0.0f), 255.0f);
+            e[1][c] = std::min(std::max((bx[c] * aa - ax[c] * ab) * invDeterminant, 0.0f), 255.0f);
+        }
+        return true;
+    }
+
+    // Endpoints at the extremes of the texels of mask along their principal axis, in the space scaled by the channel
+    // weights
+    void FitPrincipalAxis(const Block& block, uint16_t mask, const float (&channelWeights)[4], float (&e)[2][4])
+    {
+        float scale[4];
+        for (uint32_t c = 0; c < 4; ++c)
+            scale[c] = std::sqrt(channelWeights[c]);
+
+        float mean[4] = {};
+        uint32_t count = 0;
+        for (uint32_t t = 0; t < 16; ++t)
+        {
+            if ((mask & (1u << t)) == 0)
+                continue;
+
+            for (uint32_t c = 0; c < 4; ++c)
+                mean[c] += block.texels[t][c];
+            ++count;
+        }
+
+        for (uint32_t c = 0; c < 4; ++c)
+            mean[c] /= (float)std::max(count, 1u);
+
+        float covariance[4][4] = {};
+        for (uint32_t t = 0; t < 16; ++t)
+        {
+            if ((mask & (1u << t)) == 0)
+                continue;
+
+            float d[4];
+            for (uint32_t c = 0; c < 4; ++c)
+                d[c] = (block.texels[t][c] - mean[c]) * scale[c];
+            for (uint32_t i = 0; i < 4; ++i)
+                for (uint32_t j = 0; j < 4; ++j)
+                    covariance[i][j] += d[i] * d[j];
+        }
+
+        // Power iteration from the channel of the largest variance
+        float axis[4] = {};
+        uint32_t largest = 0;
+        for (uint32_t c = 1; c < 4; ++c)
+        {
+            if (covariance[c][c] > covariance[largest][largest])
+                largest = c;
+        }
+        axis[largest] = 1.0f;
+
+        for (uint32_t iteration = 0; iteration < 8; ++iteration)
+        {
+            float next[4] = {};
+            float length = 0.0f;
+            for (uint32_t i = 0; i < 4; ++i)
+            {
+                for (uint32_t j = 0; j < 4; ++j)
+                    next[i] += covariance[i][j] * axis[j];
+                length = std::max(length, std::abs(next[i]));
+            }
+
+            if (length < 1.0e-12f)
+                break;
+
+            for (uint32_t i = 0; i < 4; ++i)
+                axis[i] = next[i] / length;
+        }
+
+        float minT = std::numeric_limits<float>::max();
+        float maxT = -std::numeric_limits<float>::max();
+        float axisLengthSq = 0.0f;
+        for (uint32_t c = 0; c < 4; ++c)
+            axisLengthSq += axis[c] * axis[c];
+
+        for (uint32_t t = 0; t < 16; ++t)
+        {
+            if ((mask & (1u << t)) == 0)
+                continue;
+
+            float projection = 0.0f;
+            for (uint32_t c = 0; c < 4; ++c)
+                projection += (block.texels[t][c] - mean[c]) * scale[c] * axis[c];
+            minT = std::min(minT, projection);
+            maxT = std::max(maxT, projection);
+        }
+
+        for (uint32_t c = 0; c < 4; ++c)
+        {
+            // Back from the scaled space.  A channel of weight 0 stays at the mean.
+            const float direction = scale[c] > 0.0f ? axis[c] / scale[c] / axisLengthSq : 0.0f;
+            e[0][c] = std::min(std::max(mean[c] + direction * minT, 0.0f), 255.0f);
+            e[1][c] = std::min(std::max(mean[c] + direction * maxT, 0.0f), 255.0f);
+        }
+    }
+
+    // Fits the endpoints of one subset and returns its error.  indices receives the palette index of the texels of mask.
+    float EncodeSubset(const Block& block, uint16_t mask, const float (&channelWeights)[4], const Palette& palette,
+        const EndpointFormat& format, BCQuality quality, Endpoints& best, uint8_t (&indices)[16])
+    {
+        float e[2][4];
+        FitPrincipalAxis(block, mask, channelWeights, e);
+
+        float bestError = std::numeric_limits<float>::max();
+        const uint32_t refits = quality == BCQuality::kQuality ? 4 : 2;
+
+        for (uint32_t refit = 0; refit < refits; ++refit)
+        {
+            Endpoints candidates[4];
+            float errors[4];
+            const uint32_t count = QuantizeEndpoints(e, format, candidates);
+            EvaluateCandidates(block, mask, channelWeights, palette, candidates, count, errors);
+
+            const uint32_t bestCandidate = (uint32_t)(std::min_element(errors, errors + count) - errors);
+            if (errors[bestCandidate] >= bestError)
+                break;
+
+            bestError = errors[bestCandidate];
+            best = candidates[bestCandidate];
+
+            AssignIndices(block, mask, channelWeights, palette, best, indices);
+            if (!FitEndpoints(block, mask, palette, indices, e))
+                break;
+        }
+
+        if (quality == BCQuality::kQuality)
+        {
+            // Walk to the best neighbor, one code or p-bit away, while there is a better one
+            for (uint32_t step = 0; step < 16 && bestError > 0.0f; ++step)
+            {
+                Endpoints neighbors[20];
+                uint32_t count = 0;
+
+                for (uint32_t i = 0; i < 2; ++i)
+                {
+                    for (uint32_t c = 0; c < 4; ++c)
+                    {
+                        for (int delta = -1; delta <= 1; delta += 2)
+                        {
+                            const int code = best.code[i][c] + delta;
+                            if (format.bits[c] == 0 || code < 0 || code >= (1 << format.bits[c]))
+                                continue;
+
+                            neighbors[count] = best;
+                            neighbors[count].code[i][c] = code;
+                            UpdateValues(neighbors[count++], format);
+                        }
+                    }
+
+                    if (format.pbit == PBit::kUnique || (format.pbit == PBit::kShared && i == 0))
+                    {
+                        neighbors[count] = best;
+                        neighbors[count].pbit[i] ^= 1;
+                        if (format.pbit == PBit::kShared)
+                            neighbors[count].pbit[1] = neighbors[count].pbit[0];
+                        UpdateValues(neighbors[count++], format);
+                    }
+                }
+
+                float errors[20];
+                EvaluateCandidates(block, mask, channelWeights, palette, neighbors, count, errors);
+
+                const uint32_t bestNeighbor = (uint32_t)(std::min_element(errors, errors + count) - errors);
+                if (errors[bestNeighbor] >= bestError)
+                    break;
+
+                bestError = errors[bestNeighbor];
+                best = neighbors[bestNeighbor];
+            }
+        }
+
+        return AssignIndices(block, mask, channelWeights, palette, best, indices);
+    }
+
+    // Writes fields of a block from the least significant bit
+    class BitWriter
+    {
+    public:
+        void Write(uint32_t value, uint32_t count)
+        {
+            for (uint32_t i = 0; i < count; ++i, ++m_Position)
+            {
+                if ((value >> i) & 1)
+                    m_Bits[m_Position >> 6] |= uint64_t(1) << (m_Position & 63);
+            }
+        }
+
+        void Store(uint8_t* block) const { std::memcpy(block, m_Bits, sizeof(m_Bits)); }
+
+    private:
+        uint64_t m_Bits[2] = {};
+        uint32_t m_Position = 0;
+    };
+
+    //
+    // BC1 and BC3
+    //
+
+    // With allowTransparent, texels of alpha below 128 are encoded as transparent black in the 3-color mode, as
+    // DirectXTex does for BC1.  BC3 always decodes its colors in the 4-color mode.
+    void EncodeBC1(const Block& block, const float (&channelWeights)[4], BCQuality quality, bool allowTransparent, uint8_t* output)
+    {
+        uint16_t opaqueMask = 0;
+        for (uint32_t t = 0; t < 16; ++t)
+        {
+            if (!allowTransparent || block.texels[t][3] >= 128.0f)
+                opaqueMask |= (uint16_t)(1u << t);
+        }
+
+        if (opaqueMask == 0)
+        {
+            const uint32_t transparent[2] = { 0, 0xFFFFFFFF };
+            std::memcpy(output, transparent, 8);
+            return;
+        }
+
+        const bool hasTransparent = opaqueMask != kAllTexels;
+        const float colorWeights[4] = { channelWeights[0], channelWeights[1], channelWeights[2], 0.0f };
+        Endpoints endpoints;
+        uint8_t indices[16] = {};
+        EncodeSubset(block, opaqueMask, colorWeights, hasTransparent ? kBC1Palette3 : kBC1Palette, kBC1Endpoints, quality, endpoints, indices);
+
+        uint32_t color[2];
+        for (uint32_t i = 0; i < 2; ++i)
+            color[i] = (uint32_t)((endpoints.code[i][0] << 11) | (endpoints.code[i][1] << 5) | endpoints.code[i][2]);
+
+        if (hasTransparent)
+        {
+            // The first color must not be greater, or the block would decode in 4-color mode
+            if (color[0] > color[1])
+            {
+                std::swap(color[0], color[1]);
+                for (uint8_t& index : indices)
+                    index = index < 2 ? (uint8_t)(index ^ 1) : index;
+            }
+
+            for (uint32_t t = 0; t < 16; ++t)
+            {
+                if ((opaqueMask & (1u << t)) == 0)
+                    indices[t] = 3;
+            }
+        }
+        // The first color must be greater, or the block would decode in 3-color mode
+        else if (color[0] < color[1])
+        {
+            std::swap(color[0], color[1]);
+            for (uint8_t& index : indices)
+                index ^= 1;
+        }
+        else if (color[0] == color[1])
+        {
+            std::memset(indices, 0, sizeof(indices));
+        }
+
+        uint32_t bits = 0;
+        for (uint32_t t = 0; t < 16; ++t)
+            bits |= (uint32_t)indices[t] << (2 * t);
+
+        const uint32_t colors = color[0] | (color[1] << 16);
+        std::memcpy(output, &colors, 4);
+        std::memcpy(output + 4, &bits, 4);
+    }
+
+    //
+    // BC4 and BC5
+    //
+
+    // The BC4 palette of a pair of endpoints, in index order
+    void GetBC4Palette(int e0, int e1, bool isSigned, float (&palette)[8])
+    {
+        palette[0] = (float)e0;
+        palette[1] = (float)e1;
+        if (e0 > e1)
+        {
+            for (uint32_t k = 2; k < 8; ++k)
+                palette[k] = ((float)(8 - k) * e0 + (float)(k - 1) * e1) / 7.0f;
+        }
+        else
+        {
+            for (uint32_t k = 2; k < 6; ++k)
+                palette[k] = ((float)(6 - k) * e0 + (float)(k - 1) * e1) / 5.0f;
+            palette[6] = isSigned ? -127.0f : 0.0f;
+            palette[7] = isSigned ? 127.0f : 255.0f;
+        }
+    }
+
+    float AssignBC4Indices(const float (&values)[16], int e0, int e1, bool isSigned, uint8_t (&indices)[16])
+    {
+        float palette[8];
+        GetBC4Palette(e0, e1, isSigned, palette);
+
+        float total = 0.0f;
+        for (uint32_t t = 0; t < 16; ++t)
+        {
+            float best = std::numeric_limits<float>::max();
+            for (uint32_t k = 0; k < 8; ++k)
+            {
+                const float error = (values[t] - palette[k]) * (values[t] - palette[k]);
+                if (error < best)
+                {
+                    best = error;
+                    indices[t] = (uint8_t)k;
+                }
+            }
+            total += best;
+        }
+        return total;
+    }
+
+    // values are 0-255, or -127-127 for SNORM
+    void EncodeBC4(const float (&values)[16], bool isSigned, BCQuality quality, uint8_t* output)
+    {
+        const float lowest = isSigned ? -127.0f : 0.0f;
+        const float highest = isSigned ? 127.0f : 255.0f;
+
+        float minValue = highest, maxValue = lowest;
+        float innerMin = highest, innerMax = lowest;
+        for (float value : values)
+        {
+            minValue = std::min(minValue, value);
+            maxValue = std::max(maxValue, value);
+            if (value != lowest && value != highest)
+            {
+                innerMin = std::min(innerMin, value);
+                innerMax = std::max(innerMax, value);
+            }
+        }
+
+        // 8 interpolated values between the extremes
+        int bestE0 = (int)std::lround(maxValue);
+        int bestE1 = (int)std::lround(minValue);
+        uint8_t bestIndices[16];
+        float bestError = AssignBC4Indices(values, bestE0, bestE1, isSigned, bestIndices);
+
+        if (quality == BCQuality::kQuality && bestError > 0.0f && bestE0 > bestE1)
+        {
+            // Least squares refits of the 8-value mode
+            uint8_t indices[16];
+            std::memcpy(indices, bestIndices, sizeof(indices));
+            for (uint32_t refit = 0; refit < 2; ++refit)
+            {
+                float aa = 0.0f, ab = 0.0f, bb = 0.0f, ax = 0.0f, bx = 0.0f;
+                for (uint32_t t = 0; t < 16; ++t)
+                {
+                    const float b = indices[t] == 0 ? 0.0f : indices[t] == 1 ? 1.0f : (float)(indices[t] - 1) / 7.0f;
+                    const float a = 1.0f - b;
+                    aa += a * a;
+                    ab += a * b;
+                    bb += b * b;
+                    ax += a * values[t];
+                    bx += b * values[t];
+                }
+
+                const float determinant = aa * bb - ab * ab;
+                if (std::abs(determinant) < 1.0e-6f)
+                    break;
+
+                const int e0 = (int)std::lround(std::min(std::max((ax * bb - bx * ab) / determinant, lowest), highest));
+                const int e1 = (int)std::lround(std::min(std::max((bx * aa - ax * ab) / determinant, lowest), highest));
+                if (e0 <= e1)
+                    break;
+
+                const float error = AssignBC4Indices(values, e0, e1, isSigned, indices);
+                if (error >= bestError)
+                    break;
+
+                bestError = error;
+                bestE0 = e0;
+                bestE1 = e1;
+                std::memcpy(bestIndices, indices, sizeof(indices));
+            }
+        }
+
+        if (quality == BCQuality::kQuality && bestError > 0.0f && innerMin <= innerMax)
+        {
+            // 6 interpolated values between the texels that are not at the ends of the range, which the mode has exactly
+            uint8_t indices[16];
+            const int e0 = (int)std::lround(innerMin);
+            const int e1 = (int)std::lround(innerMax);
+            const float error = AssignBC4Indices(values, e0, e1, isSigned, indices);
+            if (error < bestError)
+            {
+                bestError = error;
+                bestE0 = e0;
+                bestE1 = e1;
+                std::memcpy(bestIndices, indices, sizeof(indices));
+            }
+        }
+
+        // Two's complement for SNORM
+        output[0] = (uint8_t)bestE0;
+        output[1] = (uint8_t)bestE1;
+
+        uint64_t bits = 0;
+        for (uint32_t t = 0; t < 16; ++t)
+            bits |= (uint64_t)bestIndices[t] << (3 * t);
+        std::memcpy(output + 2, &bits, 6);
+    }
+
+    //
+    // BC7
+    //
+
+    // Colors and alpha with separate 2-bit indices, and no rotation of channels
+    void WriteMode5(const Endpoints& colorIn, const uint8_t (&colorIndicesIn)[16], const Endpoints& alphaIn,
+        const uint8_t (&alphaIndicesIn)[16], uint8_t* output)
+    {
+        Endpoints endpoints[2] = { colorIn, alphaIn };
+        uint8_t indices[2][16];
+        std::memcpy(indices[0], colorIndicesIn, sizeof(indices[0]));
+        std::memcpy(indices[1], alphaIndicesIn, sizeof(indices[1]));
+
+        // The anchor index of each set has no most significant bit
+        for (uint32_t set = 0; set < 2; ++set)
+        {
+            if (indices[set][0] < 2)
+                continue;
+
+            std::swap(endpoints[set].code[0], endpoints[set].code[1]);
+            for (uint8_t& index : indices[set])
+                index = (uint8_t)(3 - index);
+        }
+
+        BitWriter writer;
+        writer.Write(1u << 5, 6);
+        writer.Write(0, 2);
+        for (uint32_t c = 0; c < 3; ++c)
+        {
+            writer.Write((uint32_t)endpoints[0].code[0][c], 7);
+            writer.Write((uint32_t)endpoints[0].code[1][c], 7);
+        }
+        writer.Write((uint32_t)endpoints[1].code[0][3], 8);
+        writer.Write((uint32_t)endpoints[1].code[1][3], 8);
+        for (uint32_t set = 0; set < 2; ++set)
+        {
+            for (uint32_t t = 0; t < 16; ++t)
+                writer.Write(indices[set][t], t == 0 ? 1 : 2);
+        }
+        writer.Store(output);
+    }
+
+    void WriteMode6(const Endpoints& endpointsIn, const uint8_t (&indicesIn)[16], uint8_t* output)
+    {
+        Endpoints endpoints = endpointsIn;
+        uint8_t indices[16];
+        std::memcpy(indices, indicesIn, sizeof(indices));
+
+        // The anchor index has no most significant bit
+        if (indices[0] >= 8)
+        {
+            std::swap(endpoints.code[0], endpoints.code[1]);
+            std::swap(endpoints.pbit[0], endpoints.pbit[1]);
+            for (uint8_t& index : indices)
+                index = (uint8_t)(15 - index);
+        }
+
+        BitWriter writer;
+        writer.Write(1u << 6, 7);
+        for (uint32_t c = 0; c < 4; ++c)
+        {
+            writer.Write((uint32_t)endpoints.code[0][c], 7);
+            writer.Write((uint32_t)endpoints.code[1][c], 7);
+        }
+        writer.Write((uint32_t)endpoints.pbit[0], 1);
+        writer.Write((uint32_t)endpoints.pbit[1], 1);
+        for (uint32_t t = 0; t < 16; ++t)
+            writer.Write(indices[t], t == 0 ? 3 : 4);
+        writer.Store(output);
+    }
+
+    // BC7 modes with two subsets: 1 (6-bit colors and a p-bit per subset, 3-bit indices) and 7 (5-bit colors and
+    // alpha and a p-bit per endpoint, 2-bit indices).  Endpoints are stored channel by channel.
+    void WritePartitioned(uint32_t mode, uint32_t partition, const EndpointFormat& format, uint32_t indexBits,
+        const Endpoints (&endpointsIn)[2], const uint8_t (&indicesIn)[16], uint8_t* output)
+    {
+        Endpoints endpoints[2] = { endpointsIn[0], endpointsIn[1] };
+        uint8_t indices[16];
+        std::memcpy(indices, indicesIn, sizeof(indices));
+
+        // The anchor index of each subset has no most significant bit
+        const uint32_t anchors[2] = { 0, kAnchors2[partition] };
+        const uint32_t maxIndex = (1u << indexBits) - 1;
+        for (uint32_t subset = 0; subset < 2; ++subset)
+        {
+            if (indices[anchors[subset]] <= maxIndex / 2)
+                continue;
+
+            std::swap(endpoints[subset].code[0], endpoints[subset].code[1]);
+            std::swap(endpoints[subset].pbit[0], endpoints[subset].pbit[1]);
+            for (uint32_t t = 0; t < 16; ++t)
+            {
+                if (((kPartitions2[partition] >> t) & 1) == subset)
+                    indices[t] = (uint8_t)(maxIndex - indices[t]);
+            }
+        }
+
+        BitWriter writer;
+        writer.Write(1u << mode, mode + 1);
+        writer.Write(partition, 6);
+        for (uint32_t c = 0; c < 4; ++c)
+        {
+            if (format.bits[c] == 0)
+                continue;
+
+            for (uint32_t subset = 0; subset < 2; ++subset)
+            {
+                writer.Write((uint32_t)endpoints[subset].code[0][c], format.bits[c]);
+                writer.Write((uint32_t)endpoints[subset].code[1][c], format.bits[c]);
+            }
+        }
+        for (uint32_t subset = 0; subset < 2; ++subset)
+        {
+            writer.Write((uint32_t)endpoints[subset].pbit[0], 1);
+            if (format.pbit == PBit::kUnique)
+                writer.Write((uint32_t)endpoints[subset].pbit[1], 1);
+        }
+        for (uint32_t t = 0; t < 16; ++t)
+            writer.Write(indices[t], t == anchors[0] || t == anchors[1] ? indexBits - 1 : indexBits);
+        writer.Store(output);
+    }
+
+    // The residual of fitting a line to each subset of a partition, from the covariance of its texels: the variance
+    // off the principal axis.  It ranks the partitions without encoding them.
+    void RankPartitions(const Block& block, const float (&channelWeights)[4], uint32_t (&order)[64])
+    {
+        float x[16][4];
+        for (uint32_t t = 0; t < 16; ++t)
+            for (uint32_t c = 0; c < 4; ++c)
+                x[t][c] = block.texels[t][c] * std::sqrt(channelWeights[c]);
+
+        float residuals[64];
+        for (uint32_t partition = 0; partition < 64; ++partition)
+        {
+            float residual = 0.0f;
+            for (uint32_t subset = 0; subset < 2; ++subset)
+            {
+                float sum[4] = {}, sumSq[4][4] = {};
+                float count = 0.0f;
+                for (uint32_t t = 0; t < 16; ++t)
+                {
+                    if (((kPartitions2[partition] >> t) & 1) != subset)
+                        continue;
+
+                    count += 1.0f;
+                    for (uint32_t i = 0; i < 4; ++i)
+                    {
+                        sum[i] += x[t][i];
+                        for (uint32_t j = 0; j < 4; ++j)
+                            sumSq[i][j] += x[t][i] * x[t][j];
+                    }
+                }
+
+                float covariance[4][4];
+                float trace = 0.0f;
+                for (uint32_t i = 0; i < 4; ++i)
+                {
+                    for (uint32_t j = 0; j < 4; ++j)
+                        covariance[i][j] = sumSq[i][j] - sum[i] * sum[j] / count;
+                    trace += covariance[i][i];
+                }
+
+                float axis[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+                float eigenvalue = 0.0f;
+                for (uint32_t iteration = 0; iteration < 6; ++iteration)
+                {
+                    float next[4] = {};
+                    float lengthSq = 0.0f, axisLengthSq = 0.0f;
+                    for (uint32_t i = 0; i < 4; ++i)
+                    {
+                        for (uint32_t j = 0; j < 4; ++j)
+                            next[i] += covariance[i][j] * axis[j];
+                        lengthSq += next[i] * next[i];
+                        axisLengthSq += axis[i] * axis[i];
+                    }
+
+                    const float length = std::sqrt(lengthSq);
+                    if (length < 1.0e-12f)
+                        break;
+
+                    eigenvalue = length / std::sqrt(axisLengthSq);
+                    for (uint32_t i = 0; i < 4; ++i)
+                        axis[i] = next[i] / length;
+                }
+
+                residual += std::max(trace - eigenvalue, 0.0f);
+            }
+            residuals[partition] = residual;
+            order[partition] = partition;
+        }
+
+        std::sort(order, order + 64, [&](uint32_t a, uint32_t b) { return residuals[a] < residuals[b]; });
+    }
+
+    // Tries the partitions that rank best for a two-subset mode.  Returns the partition that beats bestError, or -1.
+    int EncodePartitioned(const Block& block, const float (&channelWeights)[4], BCQuality quality, const Palette& palette,
+        const EndpointFormat& format, float& bestError, Endpoints (&bestEndpoints)[2], uint8_t (&bestIndices)[16])
+    {
+        uint32_t order[64];
+        RankPartitions(block, channelWeights, order);
+
+        int bestPartition = -1;
+        for (uint32_t rank = 0; rank < 4; ++rank)
+        {
+            const uint32_t partition = order[rank];
+            const uint16_t masks[2] = { (uint16_t)~kPartitions2[partition], kPartitions2[partition] };
+
+            Endpoints endpoints[2];
+            uint8_t indices[16] = {};
+            float error = 0.0f;
+            for (uint32_t subset = 0; subset < 2; ++subset)
+                error += EncodeSubset(block, masks[subset], channelWeights, palette, format, quality, endpoints[subset], indices);
+
+            if (error < bestError)
+            {
+                bestError = error;
+                bestPartition = (int)partition;
+                bestEndpoints[0] = endpoints[0];
+                bestEndpoints[1] = endpoints[1];
+                std::memcpy(bestIndices, indices, sizeof(indices));
+            }
+        }
+        return bestPartition;
+    }
+
+    void EncodeBC7(const Block& block, const float (&channelWeights)[4], BCQuality quality, uint8_t* output)
+    {
+        Endpoints endpoints[2];
+        uint8_t indices[16] = {};
+        float bestError = EncodeSubset(block, kAllTexels, channelWeights, kBC7Palette4, kMode6Endpoints, quality,
+            endpoints[0], indices);
+        WriteMode6(endpoints[0], indices, output);
+
+        if (bestError == 0.0f)
+            return;
+
+        bool isOpaque = true;
+        for (uint32_t t = 0; t < 16; ++t)
+            isOpaque = isOpaque && block.texels[t][3] == 255.0f;
+
+        if (isOpaque)
+        {
+            // Two subsets of 6-bit colors for the blocks that one line does not fit
+            if (quality != BCQuality::kQuality)
+                return;
+
+            const float colorWeights[4] = { channelWeights[0], channelWeights[1], channelWeights[2], 0.0f };
+            const int partition = EncodePartitioned(block, colorWeights, quality, kBC7Palette3, kMode1Endpoints, bestError, endpoints, indices);
+            if (partition >= 0)
+                WritePartitioned(1, (uint32_t)partition, kMode1Endpoints, 3, endpoints, indices, output);
+            return;
+        }
+
+        // Alpha off the line of the colors, as at the edges of cutouts, fits better with indices of its own
+        const float colorWeights[4] = { channelWeights[0], channelWeights[1], channelWeights[2], 0.0f };
+        const float alphaWeights[4] = { 0.0f, 0.0f, 0.0f, channelWeights[3] };
+        uint8_t alphaIndices[16] = {};
+        const float mode5Error =
+            EncodeSubset(block, kAllTexels, colorWeights, kBC7Palette2, kMode5ColorEndpoints, quality, endpoints[0], indices) +
+            EncodeSubset(block, kAllTexels, alphaWeights, kBC7Palette2, kMode5AlphaEndpoints, quality, endpoints[1], alphaIndices);
+
+        if (mode5Error < bestError)
+        {
+            bestError = mode5Error;
+            WriteMode5(endpoints[0], indices, endpoints[1], alphaIndices, output);
+        }
+
+        // Or with two subsets of 5-bit colors and alpha
+        if (quality == BCQuality::kQuality)
+        {
+            const int partition = EncodePartitioned(block, channelWeights, quality, kBC7Palette2, kMode7Endpoints, bestError, endpoints, indices);
+            if (partition >= 0)
+                WritePartitioned(7, (uint32_t)partition, kMode7Endpoints, 2, endpoints, indices, output);
+        }
+    }
+
+    uint32_t GetBlockBytes(DXGI_FORMAT format)
+    {
+        switch (format)
+        {
+        case DXGI_FORMAT_BC1_UNORM:
+        case DXGI_FORMAT_BC1_UNORM_SRGB:
+        case DXGI_FORMAT_BC4_UNORM:
+        case DXGI_FORMAT_BC4_SNORM:
+            return 8;
+        default:
+            return 16;
+        }
+    }
+
+    bool IsSRGB(DXGI_FORMAT format)
+    {
+        return format == DXGI_FORMAT_BC1_UNORM_SRGB || format == DXGI_FORMAT_BC3_UNORM_SRGB || format == DXGI_FORMAT_BC7_UNORM_SRGB;
+    }
+
+} // namespace
+
+DXGI_FORMAT GetBlockCompressedFormat(uint32_t flags)
+{
+    const bool sRGB = (flags & kSRGB) != 0;
+
+    if (flags & kQualityBC)
+        return sRGB ? DXGI_FORMAT_BC7_UNORM_SRGB : DXGI_FORMAT_BC7_UNORM;
+    else if (flags & kPreserveAlpha)
+        return sRGB ? DXGI_FORMAT_BC3_UNORM_SRGB : DXGI_FORMAT_BC3_UNORM;
+    else
+        return sRGB ? DXGI_FORMAT_BC1_UNORM_SRGB : DXGI_FORMAT_BC1_UNORM;
+}
+
+bool IsBlockCompressorFormat(DXGI_FORMAT format)
+{
+    switch (format)
+    {
+    case DXGI_FORMAT_BC1_UNORM:
+    case DXGI_FORMAT_BC1_UNORM_SRGB:
+    case DXGI_FORMAT_BC3_UNORM:
+    case DXGI_FORMAT_BC3_UNORM_SRGB:
+    case DXGI_FORMAT_BC4_UNORM:
+    case DXGI_FORMAT_BC4_SNORM:
+    case DXGI_FORMAT_BC5_UNORM:
+    case DXGI_FORMAT_BC5_SNORM:
+    case DXGI_FORMAT_BC7_UNORM:
+    case DXGI_FORMAT_BC7_UNORM_SRGB:
+        return true;
+    default:
+        return false;
+    }
+}
+
+void CompressBlockRow(DXGI_FORMAT format, const uint8_t* texels, size_t rowPitch, uint32_t width, uint32_t height,
+    BCQuality quality, uint8_t* blocks)
+{
+    // Luma weights for sRGB colors, scaled to the sum of the even weights
+    static const float kEvenWeights[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+    static const float kLumaWeights[4] = { 0.2126f * 3.0f, 0.7152f * 3.0f, 0.0722f * 3.0f, 1.0f };
+    const float (&channelWeights)[4] = IsSRGB(format) ? kLumaWeights : kEvenWeights;
+
+    const bool isSigned = format == DXGI_FORMAT_BC4_SNORM || format == DXGI_FORMAT_BC5_SNORM;
+    const uint32_t blockBytes = GetBlockBytes(format);
+    const uint32_t blockCount = (width + 3) / 4;
+
+    for (uint32_t bx = 0; bx < blockCount; ++bx)
+    {
+        Block block;
+        for (uint32_t y = 0; y < 4; ++y)
+        {
+            const uint8_t* row = texels + std::min(y, height - 1) * rowPitch;
+            for (uint32_t x = 0; x < 4; ++x)
+            {
+                const uint8_t* texel = row + std::min(bx * 4 + x, width - 1) * 4;
+                for (uint32_t c = 0; c < 4; ++c)
+                    block.texels[y * 4 + x][c] = (float)texel[c];
+            }
+        }
+
+        uint8_t* output = blocks + (size_t)bx * blockBytes;
+
+        switch (format)
+        {
+        case DXGI_FORMAT_BC1_UNORM:
+        case DXGI_FORMAT_BC1_UNORM_SRGB:
+            EncodeBC1(block, channelWeights, quality, true, output);
+            break;
+
+        case DXGI_FORMAT_BC3_UNORM:
+        case DXGI_FORMAT_BC3_UNORM_SRGB:
+        {
+            float alpha[16];
+            for (uint32_t t = 0; t < 16; ++t)
+                alpha[t] = block.texels[t][3];
+            EncodeBC4(alpha, false, quality, output);
+            EncodeBC1(block, channelWeights, quality, false, output + 8);
+            break;
+        }
+
+        case DXGI_FORMAT_BC4_UNORM:
+        case DXGI_FORMAT_BC4_SNORM:
+        case DXGI_FORMAT_BC5_UNORM:
+        case DXGI_FORMAT_BC5_SNORM:
+        {
+            const uint32_t channelCount = blockBytes / 8;
+            for (uint32_t c = 0; c < channelCount; ++c)
+            {
+                float values[16];
+                for (uint32_t t = 0; t < 16; ++t)
+                {
+                    // SNORM maps 0-255 to -1-1, which is -127-127 as a signed byte
+                    values[t] = isSigned ? std::round((block.texels[t][c] * 2.0f - 255.0f) * (127.0f / 255.0f)) : block.texels[t][c];
+                }
+                EncodeBC4(values, isSigned, quality, output + 8 * c);
+            }
+            break;
+        }
+
+        case DXGI_FORMAT_BC7_UNORM:
+        case DXGI_FORMAT_BC7_UNORM_SRGB:
+            EncodeBC7(block, channelWeights, quality, output);
+            break;
+
+        default:
+            std::memset(output, 0, blockBytes);
+            break;
+        }
+    }
+}
+
+bool CompressImage(DXGI_FORMAT format, const uint8_t* texels, size_t rowPitch, uint32_t width, uint32_t height,
+    BCQuality quality, uint8_t* blocks, size_t blockRowPitch, uint32_t threadCount)
+{
+    if (!IsBlockCompressorFormat(format))
+        return false;
+
+    const uint32_t blockRowCount = (height + 3) / 4;
+    if (threadCount == 0)
+        threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+    threadCount = std::min(threadCount, blockRowCount);
+
+    // Rows are handed out one at a time, since blocks take very different times to fit
+    std::atomic<uint32_t> nextRow(0);
+    auto compressRows = [&]()
+    {
+        for (uint32_t row = nextRow++; row < blockRowCount; row = nextRow++)
+        {
+            CompressBlockRow(format, texels + (size_t)row * 4 * rowPitch, rowPitch, width, std::min(height - row * 4, 4u),
+                quality, blocks + row * blockRowPitch);
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (uint32_t i = 1; i < threadCount; ++i)
+        threads.emplace_back(compressRows);
+
+    compressRows();
+
+    for (std::thread& thread : threads)
+        thread.join();
+
+    return true;
+}
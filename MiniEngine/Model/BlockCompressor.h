@@ -0,0 +1,51 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+
+#pragma once
+
+// Block compression of 8-bit textures into BC1, BC3, BC4, BC5 and BC7, so that ConvertToDDS() does not need
+// DirectXTex to compress.  Every subset of a block is fitted the same way: endpoints on the principal axis of its
+// texels, then least squares refits of the endpoints to the chosen indices, quantized with every p-bit choice of the
+// format.  The quality mode then walks the quantized endpoints one step at a time while that lowers the error, and
+// the error of up to 8 endpoint candidates is evaluated at once with AVX2.  Errors are weighted per channel: by luma
+// for sRGB formats, which spends the bits where the eye sees them, and evenly otherwise.
+// This header does not depend on pch.h so that it can be shared with portable (non-D3D12) tools.
+
+#include "../Core/DDSFormat.h"
+
+#include <cstddef>
+#include <cstdint>
+
+enum class BCQuality : uint8_t
+{
+    kFast,      // Few refits, and BC7 mode 6, or 5 for blocks with alpha
+    kQuality,   // More refits and the endpoint walk, and the two-subset BC7 modes 1 and 7 as well
+};
+
+// The format ConvertToDDS() compresses an 8-bit texture to for its TexConversionFlags:
+//      kQualityBC      BC7
+//      kPreserveAlpha  BC3
+//      otherwise       BC1
+// kSRGB selects the _SRGB variant.  Normal maps get the same formats as other textures, since DefaultPS.hlsl
+// reads them as UNORM x, y and z.
+DXGI_FORMAT GetBlockCompressedFormat(uint32_t flags);
+
+// Whether CompressBlockRow() writes format: BC1, BC3, BC4, BC5 and BC7, UNORM, SNORM and SRGB.
+bool IsBlockCompressorFormat(DXGI_FORMAT format);
+
+// Compresses the blocks of 4 rows of R8G8B8A8_UNORM texels, rowPitch bytes apart, into consecutive blocks.  Texels
+// are sRGB encoded for the _SRGB formats.  BC4 and BC5 compress red and green, and their SNORM variants map 0 to -1
+// and 255 to 1.  Blocks past width or height repeat the last column or row.
+void CompressBlockRow(DXGI_FORMAT format, const uint8_t* texels, size_t rowPitch, uint32_t width, uint32_t height,
+    BCQuality quality, uint8_t* blocks);
+
+// Compresses a whole image, block rows in parallel on threadCount threads (0 for one per core).  Rows of blocks are
+// blockRowPitch bytes apart.  Returns false, and writes nothing, if !IsBlockCompressorFormat(format).
+bool CompressImage(DXGI_FORMAT format, const uint8_t* texels, size_t rowPitch, uint32_t width, uint32_t height,
+    BCQuality quality, uint8_t* blocks, size_t blockRowPitch, uint32_t threadCount = 0);
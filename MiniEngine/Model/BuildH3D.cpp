@@ -4,6 +4,7 @@
 #include "TextureConvert.h"
 #include "glTF.h"
 #include <map>
+#include <ppl.h>
 #include <vector>
 #include <string>
 #include <locale>
@@ -17,7 +18,18 @@ bool FileExists( const std::wstring& fileName )
     return _wstat64(fileName.c_str(), &fileStat) == 0;
 }
 
-bool ModelH3D::BuildModel(ModelData& model, const std::wstring& basePath) const
+// The glTF stand-in of an H3D mesh.  The primitive points at the other members.
+struct H3DPrimitive
+{
+    glTF::Accessor PosStream;
+    glTF::Accessor UVStream;
+    glTF::Accessor NormalStream;
+    glTF::Accessor IndexStream;
+    glTF::Material material;
+    glTF::Mesh gltfMesh;
+};
+
+bool ModelH3D::BuildModel(ModelData& model, const std::wstring& basePath, const ModelCache* cache) const
 {
     model.m_SceneGraph.resize(1);
 
@@ -57,14 +69,7 @@ bool ModelH3D::BuildModel(ModelData& model, const std::wstring& basePath) const
         textureData.stringIdx[kEmissive] = 0xFFFF;
         textureData.stringIdx[kNormal] = 0xFFFF;
 
-        bool alphaTest = false;
-        const string lowerCaseName = Utility::ToLower(baseColorPath);
-        if (lowerCaseName.find("thorn") != string::npos ||
-            lowerCaseName.find("plant") != string::npos ||
-            lowerCaseName.find("chain") != string::npos)
-        {
-            alphaTest = true;
-        }
+        const bool alphaTest = IsAlphaTested(i);
 
         // Handle base color texture
         auto mapLookup = fileNameMap.find(baseColorPath);
@@ -77,7 +82,7 @@ bool ModelH3D::BuildModel(ModelData& model, const std::wstring& basePath) const
             fileNameMap[baseColorPath] = (uint16_t)model.m_TextureNames.size();
             textureData.stringIdx[kBaseColor] = (uint16_t)model.m_TextureNames.size();
             model.m_TextureNames.push_back(baseColorPath);
-            model.m_TextureOptions.push_back(TextureOptions(true, alphaTest, true));
+            model.m_TextureOptions.push_back(TextureOptions(true, alphaTest, true, alphaTest));
         }
 
         // Handle occlusionMetallicRoughness texture
@@ -140,57 +145,53 @@ bool ModelH3D::BuildModel(ModelData& model, const std::wstring& basePath) const
     }
 
     ASSERT(model.m_TextureOptions.size() == model.m_TextureNames.size());
-    for (size_t ti = 0; ti < model.m_TextureNames.size(); ++ti)
-    {
-        std::wstring fullPath = basePath + Utility::UTF8ToWideString(model.m_TextureNames[ti]);
-        CompileTextureOnDemand(fullPath, model.m_TextureOptions[ti]);
-    }
 
     model.m_BoundingSphere = BoundingSphere(kZero);
     model.m_BoundingBox = AxisAlignedBox(kZero);
 
     // We're going to piggy-back off of the work to compile glTF meshes by pretending that's what
     // we have.
+    std::vector<H3DPrimitive> h3dPrimitives(m_Header.meshCount);
     for (uint32_t i = 0; i < m_Header.meshCount; ++i)
     {
         const Mesh& mesh = GetMesh(i);
+        H3DPrimitive& h3dPrim = h3dPrimitives[i];
 
-        glTF::Accessor PosStream;
+        glTF::Accessor& PosStream = h3dPrim.PosStream;
         PosStream.dataPtr = m_pVertexData + mesh.vertexDataByteOffset;
         PosStream.stride = mesh.vertexStride;
         PosStream.count = mesh.vertexCount;
         PosStream.componentType = glTF::Accessor::kFloat;
         PosStream.type = glTF::Accessor::kVec3;
 
-        glTF::Accessor UVStream;
+        glTF::Accessor& UVStream = h3dPrim.UVStream;
         UVStream.dataPtr = m_pVertexData + mesh.vertexDataByteOffset + 12;
         UVStream.stride = mesh.vertexStride;
         UVStream.count = mesh.vertexCount;
         UVStream.componentType = glTF::Accessor::kFloat;
         UVStream.type = glTF::Accessor::kVec2;
 
-        glTF::Accessor NormalStream;
+        glTF::Accessor& NormalStream = h3dPrim.NormalStream;
         NormalStream.dataPtr = m_pVertexData + mesh.vertexDataByteOffset + 20;
         NormalStream.stride = mesh.vertexStride;
         NormalStream.count = mesh.vertexCount;
         NormalStream.componentType = glTF::Accessor::kFloat;
         NormalStream.type = glTF::Accessor::kVec3;
 
-        glTF::Accessor IndexStream;
+        glTF::Accessor& IndexStream = h3dPrim.IndexStream;
         IndexStream.dataPtr = m_pIndexData + mesh.indexDataByteOffset;
         IndexStream.stride = 2;
         IndexStream.count = mesh.indexCount;
         IndexStream.componentType = glTF::Accessor::kUnsignedShort;
         IndexStream.type = glTF::Accessor::kScalar;
 
-        glTF::Material material;
+        glTF::Material& material = h3dPrim.material;
         material.flags = model.m_MaterialConstants[mesh.materialIndex].flags;
         material.index = mesh.materialIndex;
         
-        glTF::Mesh gltfMesh;
-        gltfMesh.primitives.resize(1);
+        h3dPrim.gltfMesh.primitives.resize(1);
 
-        glTF::Primitive& prim = gltfMesh.primitives[0];
+        glTF::Primitive& prim = h3dPrim.gltfMesh.primitives[0];
         prim.attributes[glTF::Primitive::kPosition] = &PosStream;
         prim.attributes[glTF::Primitive::kTexcoord0] = &UVStream;
         prim.attributes[glTF::Primitive::kNormal] = &NormalStream;
@@ -198,14 +199,24 @@ bool ModelH3D::BuildModel(ModelData& model, const std::wstring& basePath) const
         prim.material = &material;
         prim.attribMask = 0xB;
         prim.mode = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
-        memcpy(prim.minPos, &mesh.boundingBox.GetMin(), 12);
-        memcpy(prim.maxPos, &mesh.boundingBox.GetMax(), 12);
+        memcpy(prim.minPos, mesh.boundingBox.min, 12);
+        memcpy(prim.maxPos, mesh.boundingBox.max, 12);
         prim.minIndex = 0;
         prim.maxIndex = 0;
+    }
+
+    // Every mesh is optimized (or read back from the cache) at once on the worker threads, then packed in order
+    std::vector<Primitive> primitives(m_Header.meshCount);
+    concurrency::parallel_for(uint32_t(0), m_Header.meshCount, [&](uint32_t i)
+    {
+        OptimizeMesh(primitives[i], h3dPrimitives[i].gltfMesh.primitives[0], Matrix4(kIdentity), cache);
+    });
 
+    for (uint32_t i = 0; i < m_Header.meshCount; ++i)
+    {
         BoundingSphere sphereOS;
         AxisAlignedBox boxOS;
-        Renderer::CompileMesh(model.m_Meshes, model.m_GeometryData, gltfMesh, 0, Matrix4(kIdentity), sphereOS, boxOS); 
+        Renderer::CompileMesh(model.m_Meshes, model.m_GeometryData, model.m_Meshlets, h3dPrimitives[i].gltfMesh, 0, &primitives[i], sphereOS, boxOS);
         model.m_BoundingSphere = model.m_BoundingSphere.Union(sphereOS);
         model.m_BoundingBox.AddBoundingBox(boxOS);
     }
@@ -0,0 +1,863 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+
+#include "GeometryCodec.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+#if defined(_M_X64) || defined(__SSE2__)
+#include <emmintrin.h>
+#define GEOMETRY_CODEC_SSE2 1
+#endif
+
+// Each byte plane of a chunk is stored as
+//      uint8_t  mode
+//      uint32_t size                   decoded bytes
+//  kPlaneStored:
+//      uint8_t  bytes[size]
+//  kPlaneConstant:
+//      uint8_t  value                  every byte
+//  kPlaneHuffman:
+//      uint32_t streamSizes[4]         bytes of each bitstream
+//      uint8_t  symbolCount - 1
+//      code lengths                    (symbol, length) pairs when there are few symbols, otherwise 256 lengths
+//                                      in 4-bit nibbles, low nibble first
+//      uint8_t  bitstreams[]           a quarter of the plane each (SegmentSize()), codes packed from the least
+//                                      significant bit as in deflate
+// Vertex chunks have one plane per byte of the vertex and the others a single plane.
+
+namespace
+{
+    enum PlaneMode : uint8_t
+    {
+        kPlaneStored,
+        kPlaneConstant,
+        kPlaneHuffman,
+    };
+
+    // Short enough for the decoding table of a plane to stay in L1 and for five codes to fit in a refilled bit buffer
+    const uint32_t kMaxCodeLength = 11;
+
+    // Above this many symbols the nibble table is smaller than (symbol, length) pairs
+    const uint32_t kMaxSparseSymbols = 85;
+
+    // Independent bitstreams per plane, decoded in lockstep
+    const uint32_t kHuffmanStreams = 4;
+
+    // Smaller planes are stored, as are those that Huffman coding would not shrink by an eighth, which are not worth
+    // the time to decode
+    const size_t kMinHuffmanPlaneSize = 32;
+
+    uint32_t UnitSize(GeometryStreamType type, uint32_t stride)
+    {
+        switch (type)
+        {
+        case GeometryStreamType::kVertex:  return stride;
+        case GeometryStreamType::kIndex16: return 2;
+        case GeometryStreamType::kIndex32: return 4;
+        default:                           return 1;
+        }
+    }
+
+    void AppendUint32(std::vector<uint8_t>& out, uint32_t value)
+    {
+        const uint8_t bytes[4] = { uint8_t(value), uint8_t(value >> 8), uint8_t(value >> 16), uint8_t(value >> 24) };
+        out.insert(out.end(), bytes, bytes + 4);
+    }
+
+    struct Reader
+    {
+        const uint8_t* pos;
+        const uint8_t* end;
+
+        bool Read(uint8_t& value)
+        {
+            if (pos == end)
+                return false;
+            value = *pos++;
+            return true;
+        }
+
+        bool Read(uint32_t& value)
+        {
+            if (end - pos < 4)
+                return false;
+            value = uint32_t(pos[0]) | uint32_t(pos[1]) << 8 | uint32_t(pos[2]) << 16 | uint32_t(pos[3]) << 24;
+            pos += 4;
+            return true;
+        }
+    };
+
+    uint32_t ReverseBits(uint32_t code, uint32_t length)
+    {
+        code = ((code & 0x5555) << 1) | ((code >> 1) & 0x5555);
+        code = ((code & 0x3333) << 2) | ((code >> 2) & 0x3333);
+        code = ((code & 0x0F0F) << 4) | ((code >> 4) & 0x0F0F);
+        code = ((code & 0x00FF) << 8) | ((code >> 8) & 0x00FF);
+        return code >> (16 - length);
+    }
+
+    // Moffat and Katajainen, "In-Place Calculation of Minimum-Redundancy Codes".  weights are sorted in ascending
+    // order and are replaced by the code lengths.
+    void CalculateMinimumRedundancy(uint32_t* weights, int n)
+    {
+        if (n == 1)
+        {
+            weights[0] = 1;
+            return;
+        }
+
+        weights[0] += weights[1];
+        int root = 0;
+        int leaf = 2;
+        for (int next = 1; next < n - 1; ++next)
+        {
+            if (leaf >= n || weights[root] < weights[leaf])
+            {
+                weights[next] = weights[root];
+                weights[root++] = next;
+            }
+            else
+            {
+                weights[next] = weights[leaf++];
+            }
+
+            if (leaf >= n || (root < next && weights[root] < weights[leaf]))
+            {
+                weights[next] += weights[root];
+                weights[root++] = next;
+            }
+            else
+            {
+                weights[next] += weights[leaf++];
+            }
+        }
+
+        weights[n - 2] = 0;
+        for (int next = n - 3; next >= 0; --next)
+            weights[next] = weights[weights[next]] + 1;
+
+        int available = 1;
+        int used = 0;
+        uint32_t depth = 0;
+        int root2 = n - 2;
+        int next = n - 1;
+        while (available > 0)
+        {
+            while (root2 >= 0 && weights[root2] == depth)
+            {
+                ++used;
+                --root2;
+            }
+            while (available > used)
+            {
+                weights[next--] = depth;
+                --available;
+            }
+            available = 2 * used;
+            ++depth;
+            used = 0;
+        }
+    }
+
+    // Code lengths of at most kMaxCodeLength for the symbols with nonzero counts
+    void BuildCodeLengths(const uint32_t (&counts)[256], uint8_t (&lengths)[256])
+    {
+        uint32_t symbols[256];
+        uint32_t weights[256] = {};
+        int n = 0;
+        for (uint32_t s = 0; s < 256; ++s)
+        {
+            if (counts[s] > 0)
+                symbols[n++] = s;
+        }
+
+        std::sort(symbols, symbols + n, [&](uint32_t a, uint32_t b)
+        {
+            return counts[a] != counts[b] ? counts[a] < counts[b] : a < b;
+        });
+
+        for (int i = 0; i < n; ++i)
+            weights[i] = counts[symbols[i]];
+        CalculateMinimumRedundancy(weights, n);
+
+        // Clamp the lengths, then lengthen codes one at a time until the Kraft sum is one again
+        uint32_t lengthCounts[32] = {};
+        for (int i = 0; i < n; ++i)
+            ++lengthCounts[std::min(weights[i], kMaxCodeLength)];
+
+        uint32_t kraft = 0;
+        for (uint32_t length = 1; length <= kMaxCodeLength; ++length)
+            kraft += lengthCounts[length] << (kMaxCodeLength - length);
+
+        while (kraft > (1u << kMaxCodeLength))
+        {
+            --lengthCounts[kMaxCodeLength];
+            for (uint32_t length = kMaxCodeLength - 1; length > 0; --length)
+            {
+                if (lengthCounts[length] > 0)
+                {
+                    --lengthCounts[length];
+                    lengthCounts[length + 1] += 2;
+                    break;
+                }
+            }
+            --kraft;
+        }
+
+        // The most frequent symbols take the shortest codes
+        std::memset(lengths, 0, sizeof(lengths));
+        int i = n;
+        for (uint32_t length = 1; length <= kMaxCodeLength; ++length)
+        {
+            for (uint32_t k = 0; k < lengthCounts[length]; ++k)
+                lengths[symbols[--i]] = uint8_t(length);
+        }
+    }
+
+    // Canonical codes in symbol order, bit reversed for the LSB-first bitstream
+    void BuildCodes(const uint8_t (&lengths)[256], uint16_t (&codes)[256])
+    {
+        uint32_t lengthCounts[kMaxCodeLength + 1] = {};
+        for (uint32_t s = 0; s < 256; ++s)
+            ++lengthCounts[lengths[s]];
+        lengthCounts[0] = 0;
+
+        uint32_t nextCode[kMaxCodeLength + 1] = {};
+        uint32_t code = 0;
+        for (uint32_t length = 1; length <= kMaxCodeLength; ++length)
+        {
+            code = (code + lengthCounts[length - 1]) << 1;
+            nextCode[length] = code;
+        }
+
+        for (uint32_t s = 0; s < 256; ++s)
+        {
+            if (lengths[s] > 0)
+                codes[s] = uint16_t(ReverseBits(nextCode[lengths[s]]++, lengths[s]));
+        }
+    }
+
+    // Plane i of kHuffmanStreams holds symbols [i * segment, (i + 1) * segment) and the last one the rest
+    size_t SegmentSize(size_t size)
+    {
+        return (size + kHuffmanStreams - 1) / kHuffmanStreams;
+    }
+
+    void EncodePlane(const uint8_t* plane, size_t size, std::vector<uint8_t>& out)
+    {
+        uint32_t counts[256] = {};
+        for (size_t i = 0; i < size; ++i)
+            ++counts[plane[i]];
+
+        uint32_t symbolCount = 0;
+        for (uint32_t s = 0; s < 256; ++s)
+            symbolCount += counts[s] > 0 ? 1 : 0;
+
+        if (symbolCount <= 1)
+        {
+            out.push_back(kPlaneConstant);
+            AppendUint32(out, uint32_t(size));
+            out.push_back(size > 0 ? plane[0] : 0);
+            return;
+        }
+
+        uint8_t lengths[256] = {};
+        uint16_t codes[256] = {};
+        size_t streamSizes[kHuffmanStreams] = {};
+        size_t encodedSize = size;
+
+        if (size >= kMinHuffmanPlaneSize)
+        {
+            BuildCodeLengths(counts, lengths);
+            BuildCodes(lengths, codes);
+
+            const size_t segment = SegmentSize(size);
+            encodedSize = 4 * kHuffmanStreams + 1 + (symbolCount <= kMaxSparseSymbols ? 2 * symbolCount : 128);
+            for (uint32_t stream = 0; stream < kHuffmanStreams; ++stream)
+            {
+                uint64_t bitCount = 0;
+                for (size_t i = stream * segment; i < std::min(size, (stream + 1) * segment); ++i)
+                    bitCount += lengths[plane[i]];
+                streamSizes[stream] = size_t((bitCount + 7) / 8);
+                encodedSize += streamSizes[stream];
+            }
+        }
+
+        if (encodedSize >= size - size / 8)
+        {
+            out.push_back(kPlaneStored);
+            AppendUint32(out, uint32_t(size));
+            out.insert(out.end(), plane, plane + size);
+            return;
+        }
+
+        out.push_back(kPlaneHuffman);
+        AppendUint32(out, uint32_t(size));
+        for (uint32_t stream = 0; stream < kHuffmanStreams; ++stream)
+            AppendUint32(out, uint32_t(streamSizes[stream]));
+        out.push_back(uint8_t(symbolCount - 1));
+
+        if (symbolCount <= kMaxSparseSymbols)
+        {
+            for (uint32_t s = 0; s < 256; ++s)
+            {
+                if (lengths[s] > 0)
+                {
+                    out.push_back(uint8_t(s));
+                    out.push_back(lengths[s]);
+                }
+            }
+        }
+        else
+        {
+            for (uint32_t s = 0; s < 256; s += 2)
+                out.push_back(uint8_t(lengths[s] | lengths[s + 1] << 4));
+        }
+
+        const size_t segment = SegmentSize(size);
+        for (uint32_t stream = 0; stream < kHuffmanStreams; ++stream)
+        {
+            const size_t streamOffset = out.size();
+            out.resize(streamOffset + streamSizes[stream]);
+            uint8_t* dest = out.data() + streamOffset;
+
+            uint64_t bitBuffer = 0;
+            uint32_t bufferedBits = 0;
+            for (size_t i = stream * segment; i < std::min(size, (stream + 1) * segment); ++i)
+            {
+                bitBuffer |= uint64_t(codes[plane[i]]) << bufferedBits;
+                bufferedBits += lengths[plane[i]];
+                while (bufferedBits >= 8)
+                {
+                    *dest++ = uint8_t(bitBuffer);
+                    bitBuffer >>= 8;
+                    bufferedBits -= 8;
+                }
+            }
+            if (bufferedBits > 0)
+                *dest++ = uint8_t(bitBuffer);
+
+            assert(dest == out.data() + out.size());
+        }
+    }
+
+    struct BitReader
+    {
+        const uint8_t* in;
+        const uint8_t* end;
+        uint64_t bitBuffer;
+        uint32_t bitCount;
+
+        // Tops the buffer up to at least 56 bits, a byte at a time near the end of the stream
+        void Refill()
+        {
+            if (end - in >= 8)
+            {
+                uint64_t bytes;
+                std::memcpy(&bytes, in, sizeof(bytes));
+                bitBuffer |= bytes << bitCount;
+                in += (63 - bitCount) >> 3;
+                bitCount |= 56;
+            }
+            else
+            {
+                while (bitCount <= 56 && in < end)
+                {
+                    bitBuffer |= uint64_t(*in++) << bitCount;
+                    bitCount += 8;
+                }
+            }
+        }
+
+        uint8_t Decode(const uint16_t* table, uint64_t mask)
+        {
+            const uint16_t entry = table[bitBuffer & mask];
+            bitBuffer >>= entry >> 8;
+            bitCount -= entry >> 8;
+            return uint8_t(entry);
+        }
+
+        // Decodes the remaining symbols one at a time, checking that the stream does not run out
+        bool DecodeTail(const uint16_t* table, uint64_t mask, uint8_t* out, uint8_t* outEnd)
+        {
+            while (out < outEnd)
+            {
+                Refill();
+                if ((table[bitBuffer & mask] >> 8) > bitCount)
+                    return false;
+                *out++ = Decode(table, mask);
+            }
+            return true;
+        }
+    };
+
+    bool DecodeHuffman(Reader& reader, uint8_t* out, size_t size)
+    {
+        uint32_t streamSizes[kHuffmanStreams];
+        for (uint32_t stream = 0; stream < kHuffmanStreams; ++stream)
+        {
+            if (!reader.Read(streamSizes[stream]))
+                return false;
+        }
+
+        uint8_t lastSymbol;
+        if (!reader.Read(lastSymbol))
+            return false;
+
+        const uint32_t symbolCount = uint32_t(lastSymbol) + 1;
+        uint8_t lengths[256] = {};
+        if (symbolCount <= kMaxSparseSymbols)
+        {
+            for (uint32_t i = 0; i < symbolCount; ++i)
+            {
+                uint8_t symbol, length;
+                if (!reader.Read(symbol) || !reader.Read(length))
+                    return false;
+                lengths[symbol] = length;
+            }
+        }
+        else
+        {
+            for (uint32_t s = 0; s < 256; s += 2)
+            {
+                uint8_t pair;
+                if (!reader.Read(pair))
+                    return false;
+                lengths[s] = pair & 0xF;
+                lengths[s + 1] = pair >> 4;
+            }
+        }
+
+        // The table is indexed by the next tableBits bits of the stream, which is as many as the longest code
+        uint32_t tableBits = 0;
+        uint32_t kraft = 0;
+        for (uint32_t s = 0; s < 256; ++s)
+        {
+            if (lengths[s] > kMaxCodeLength)
+                return false;
+            tableBits = std::max<uint32_t>(tableBits, lengths[s]);
+            kraft += lengths[s] > 0 ? 1u << (kMaxCodeLength - lengths[s]) : 0;
+        }
+        if (kraft != (1u << kMaxCodeLength) || size < kHuffmanStreams)
+            return false;
+
+        uint16_t codes[256];
+        BuildCodes(lengths, codes);
+
+        uint16_t table[1 << kMaxCodeLength];
+        for (uint32_t s = 0; s < 256; ++s)
+        {
+            if (lengths[s] == 0)
+                continue;
+            const uint16_t entry = uint16_t(s | lengths[s] << 8);
+            for (uint32_t k = codes[s]; k < (1u << tableBits); k += 1u << lengths[s])
+                table[k] = entry;
+        }
+        const uint64_t mask = (1ull << tableBits) - 1;
+
+        BitReader readers[kHuffmanStreams];
+        uint8_t* outs[kHuffmanStreams];
+        uint8_t* outEnds[kHuffmanStreams];
+        const size_t segment = SegmentSize(size);
+        for (uint32_t stream = 0; stream < kHuffmanStreams; ++stream)
+        {
+            if (size_t(reader.end - reader.pos) < streamSizes[stream])
+                return false;
+            readers[stream] = { reader.pos, reader.pos + streamSizes[stream], 0, 0 };
+            reader.pos += streamSizes[stream];
+            outs[stream] = out + std::min(size, stream * segment);
+            outEnds[stream] = out + std::min(size, (stream + 1) * segment);
+        }
+
+        // The streams are independent, so their table lookups overlap instead of each waiting for the previous
+        // code length.  The last stream is the shortest.
+        static_assert(kHuffmanStreams == 4, "The lockstep loop decodes four streams");
+        const size_t lastCount = size_t(outEnds[3] - outs[3]);
+        BitReader r0 = readers[0], r1 = readers[1], r2 = readers[2], r3 = readers[3];
+        size_t done = 0;
+        while (lastCount - done >= 4)
+        {
+            r0.Refill();
+            r1.Refill();
+            r2.Refill();
+            r3.Refill();
+            if (std::min(std::min(r0.bitCount, r1.bitCount), std::min(r2.bitCount, r3.bitCount)) < 4 * kMaxCodeLength)
+                break;
+
+            for (uint32_t k = 0; k < 4; ++k)
+            {
+                outs[0][done + k] = r0.Decode(table, mask);
+                outs[1][done + k] = r1.Decode(table, mask);
+                outs[2][done + k] = r2.Decode(table, mask);
+                outs[3][done + k] = r3.Decode(table, mask);
+            }
+            done += 4;
+        }
+        readers[0] = r0;
+        readers[1] = r1;
+        readers[2] = r2;
+        readers[3] = r3;
+
+        for (uint32_t stream = 0; stream < kHuffmanStreams; ++stream)
+        {
+            if (!readers[stream].DecodeTail(table, mask, outs[stream] + done, outEnds[stream]))
+                return false;
+        }
+
+        return true;
+    }
+    // Decodes the next plane into out, which has room for maxSize bytes
+    bool DecodePlane(Reader& reader, uint8_t* out, size_t maxSize, size_t& size)
+    {
+        uint8_t mode;
+        uint32_t planeSize;
+        if (!reader.Read(mode) || !reader.Read(planeSize) || planeSize > maxSize)
+            return false;
+        size = planeSize;
+
+        switch (mode)
+        {
+        case kPlaneStored:
+            if (size_t(reader.end - reader.pos) < planeSize)
+                return false;
+            std::memcpy(out, reader.pos, planeSize);
+            reader.pos += planeSize;
+            return true;
+
+        case kPlaneConstant:
+        {
+            uint8_t value;
+            if (!reader.Read(value))
+                return false;
+            std::memset(out, value, planeSize);
+            return true;
+        }
+
+        case kPlaneHuffman:
+            return DecodeHuffman(reader, out, planeSize);
+
+        default:
+            return false;
+        }
+    }
+
+    void EncodeVertices(const uint8_t* vertices, uint32_t vertexCount, uint32_t stride, std::vector<uint8_t>& out)
+    {
+        std::vector<uint8_t> plane(vertexCount);
+        for (uint32_t b = 0; b < stride; ++b)
+        {
+            uint8_t previous = 0;
+            for (uint32_t v = 0; v < vertexCount; ++v)
+            {
+                const uint8_t value = vertices[size_t(v) * stride + b];
+                plane[v] = uint8_t(value - previous);
+                previous = value;
+            }
+            EncodePlane(plane.data(), vertexCount, out);
+        }
+    }
+
+    // Undoes the delta coding of planes [firstPlane, firstPlane + 4) and interleaves them into the vertices.  planes
+    // holds the vertexCount bytes of each plane back to back.
+#ifdef GEOMETRY_CODEC_SSE2
+    inline __m128i PrefixSum(__m128i x, __m128i carry)
+    {
+        x = _mm_add_epi8(x, _mm_slli_si128(x, 1));
+        x = _mm_add_epi8(x, _mm_slli_si128(x, 2));
+        x = _mm_add_epi8(x, _mm_slli_si128(x, 4));
+        x = _mm_add_epi8(x, _mm_slli_si128(x, 8));
+        return _mm_add_epi8(x, carry);
+    }
+
+    // All 16 bytes set to the last byte of x
+    inline __m128i BroadcastLastByte(__m128i x)
+    {
+        const __m128i high = _mm_unpackhi_epi8(x, x);
+        const __m128i word = _mm_shufflehi_epi16(high, 0xFF);
+        return _mm_unpackhi_epi64(word, word);
+    }
+
+    inline void StoreVertexWords(__m128i words, uint8_t* dest, size_t stride)
+    {
+        for (uint32_t i = 0; i < 4; ++i)
+        {
+            const uint32_t word = uint32_t(_mm_cvtsi128_si32(words));
+            std::memcpy(dest + i * stride, &word, sizeof(word));
+            words = _mm_srli_si128(words, 4);
+        }
+    }
+
+    uint32_t InterleavePlanes4(const uint8_t* planes, uint32_t vertexCount, uint32_t stride, uint32_t firstPlane,
+        uint8_t* vertices, uint8_t (&previous)[4])
+    {
+        const uint8_t* p[4];
+        __m128i carry[4];
+        for (uint32_t k = 0; k < 4; ++k)
+        {
+            p[k] = planes + size_t(firstPlane + k) * vertexCount;
+            carry[k] = _mm_set1_epi8(char(previous[k]));
+        }
+
+        uint32_t v = 0;
+        for (; v + 16 <= vertexCount; v += 16)
+        {
+            __m128i x[4];
+            for (uint32_t k = 0; k < 4; ++k)
+            {
+                x[k] = PrefixSum(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p[k] + v)), carry[k]);
+                carry[k] = BroadcastLastByte(x[k]);
+            }
+
+            const __m128i t0 = _mm_unpacklo_epi8(x[0], x[1]);
+            const __m128i t1 = _mm_unpackhi_epi8(x[0], x[1]);
+            const __m128i t2 = _mm_unpacklo_epi8(x[2], x[3]);
+            const __m128i t3 = _mm_unpackhi_epi8(x[2], x[3]);
+
+            uint8_t* dest = vertices + size_t(v) * stride + firstPlane;
+            StoreVertexWords(_mm_unpacklo_epi16(t0, t2), dest, stride);
+            StoreVertexWords(_mm_unpackhi_epi16(t0, t2), dest + 4 * stride, stride);
+            StoreVertexWords(_mm_unpacklo_epi16(t1, t3), dest + 8 * stride, stride);
+            StoreVertexWords(_mm_unpackhi_epi16(t1, t3), dest + 12 * stride, stride);
+        }
+
+        for (uint32_t k = 0; k < 4; ++k)
+            previous[k] = uint8_t(_mm_cvtsi128_si32(carry[k]));
+
+        return v;
+    }
+#endif
+
+    bool DecodeVertices(Reader& reader, uint32_t vertexCount, uint32_t stride, uint8_t* planes, uint8_t* vertices)
+    {
+        for (uint32_t b = 0; b < stride; ++b)
+        {
+            size_t size;
+            if (!DecodePlane(reader, planes + size_t(b) * vertexCount, vertexCount, size) || size != vertexCount)
+                return false;
+        }
+
+        uint32_t b = 0;
+#ifdef GEOMETRY_CODEC_SSE2
+        // Four planes at a time, so that every store writes four bytes of a vertex
+        for (; b + 4 <= stride; b += 4)
+        {
+            uint8_t previous[4] = {};
+            const uint32_t first = InterleavePlanes4(planes, vertexCount, stride, b, vertices, previous);
+            for (uint32_t v = first; v < vertexCount; ++v)
+            {
+                for (uint32_t k = 0; k < 4; ++k)
+                {
+                    previous[k] = uint8_t(previous[k] + planes[size_t(b + k) * vertexCount + v]);
+                    vertices[size_t(v) * stride + b + k] = previous[k];
+                }
+            }
+        }
+#endif
+        for (; b < stride; ++b)
+        {
+            uint8_t previous = 0;
+            const uint8_t* plane = planes + size_t(b) * vertexCount;
+            for (uint32_t v = 0; v < vertexCount; ++v)
+            {
+                previous = uint8_t(previous + plane[v]);
+                vertices[size_t(v) * stride + b] = previous;
+            }
+        }
+
+        return true;
+    }
+
+    template <typename IndexType>
+    void EncodeIndices(const uint8_t* data, uint32_t indexCount, std::vector<uint8_t>& out)
+    {
+        std::vector<uint8_t> varints;
+        varints.reserve(indexCount + indexCount / 4);
+
+        uint32_t previous = 0;
+        for (uint32_t i = 0; i < indexCount; ++i)
+        {
+            IndexType index;
+            std::memcpy(&index, data + i * sizeof(IndexType), sizeof(IndexType));
+
+            // Deltas wrap around, so that every 32-bit index round trips
+            const int32_t delta = int32_t(uint32_t(index) - previous);
+            uint32_t zigzag = (uint32_t(delta) << 1) ^ uint32_t(delta >> 31);
+            previous = index;
+
+            while (zigzag >= 0x80)
+            {
+                varints.push_back(uint8_t(zigzag | 0x80));
+                zigzag >>= 7;
+            }
+            varints.push_back(uint8_t(zigzag));
+        }
+
+        EncodePlane(varints.data(), varints.size(), out);
+    }
+
+    template <typename IndexType>
+    bool DecodeIndices(Reader& reader, uint32_t indexCount, uint8_t* varints, uint8_t* indices)
+    {
+        size_t size;
+        if (!DecodePlane(reader, varints, size_t(indexCount) * 5, size))
+            return false;
+
+        const uint8_t* in = varints;
+        const uint8_t* const inEnd = varints + size;
+        uint32_t previous = 0;
+        for (uint32_t i = 0; i < indexCount; ++i)
+        {
+            uint32_t zigzag = 0;
+            uint32_t shift = 0;
+            uint8_t byte;
+            do
+            {
+                if (in == inEnd || shift > 28)
+                    return false;
+                byte = *in++;
+                zigzag |= uint32_t(byte & 0x7F) << shift;
+                shift += 7;
+            } while (byte & 0x80);
+
+            previous += (zigzag >> 1) ^ (0u - (zigzag & 1));
+            const IndexType index = IndexType(previous);
+            std::memcpy(indices + i * sizeof(IndexType), &index, sizeof(IndexType));
+        }
+
+        return in == inEnd;
+    }
+
+    // Per thread, so that decoding allocates once per thread rather than once per chunk
+    thread_local std::vector<uint8_t> s_Scratch;
+}
+
+void SplitGeometryChunks(size_t geometrySize, std::vector<GeometryRegion> regions, std::vector<GeometryChunk>& chunks)
+{
+    chunks.clear();
+
+    std::stable_sort(regions.begin(), regions.end(), [](const GeometryRegion& a, const GeometryRegion& b)
+    {
+        return a.offset < b.offset;
+    });
+
+    auto AddChunks = [&](size_t offset, size_t size, uint32_t stride, GeometryStreamType type)
+    {
+        const uint32_t unit = UnitSize(type, stride);
+        const size_t maxChunkSize = std::max<size_t>(kMaxGeometryChunkSize / unit, 1) * unit;
+        while (size > 0)
+        {
+            GeometryChunk chunk = {};
+            chunk.offset = uint32_t(offset);
+            chunk.size = uint32_t(std::min(size, maxChunkSize));
+            chunk.stride = uint16_t(type == GeometryStreamType::kVertex ? stride : unit);
+            chunk.type = uint8_t(type);
+            chunks.push_back(chunk);
+            offset += chunk.size;
+            size -= chunk.size;
+        }
+    };
+
+    size_t cursor = 0;
+    for (const GeometryRegion& region : regions)
+    {
+        const size_t begin = region.offset;
+        const size_t end = std::min<size_t>(begin + region.size, geometrySize);
+        if (end <= cursor)
+            continue;
+
+        const uint32_t unit = UnitSize(region.type, region.stride);
+        const bool whole = begin >= cursor && end == size_t(begin) + region.size && unit > 0 && unit <= 0xFFFF &&
+            region.size % unit == 0;
+        if (!whole)
+        {
+            // Leave what is left of it to the raw chunks
+            continue;
+        }
+
+        AddChunks(cursor, begin - cursor, 1, GeometryStreamType::kRaw);
+        AddChunks(begin, region.size, region.stride, region.type);
+        cursor = end;
+    }
+
+    AddChunks(cursor, geometrySize - cursor, 1, GeometryStreamType::kRaw);
+}
+
+void EncodeGeometryChunk(const GeometryChunk& chunk, const uint8_t* geometry, std::vector<uint8_t>& encoded)
+{
+    encoded.clear();
+    const uint8_t* data = geometry + chunk.offset;
+
+    switch (GeometryStreamType(chunk.type))
+    {
+    case GeometryStreamType::kVertex:
+        EncodeVertices(data, chunk.size / chunk.stride, chunk.stride, encoded);
+        break;
+    case GeometryStreamType::kIndex16:
+        EncodeIndices<uint16_t>(data, chunk.size / 2, encoded);
+        break;
+    case GeometryStreamType::kIndex32:
+        EncodeIndices<uint32_t>(data, chunk.size / 4, encoded);
+        break;
+    default:
+        EncodePlane(data, chunk.size, encoded);
+        break;
+    }
+}
+
+bool DecodeGeometryChunk(const GeometryChunk& chunk, const uint8_t* payload, size_t payloadSize, uint8_t* geometry)
+{
+    if (size_t(chunk.encodedOffset) + chunk.encodedSize > payloadSize || chunk.size > kMaxGeometryChunkSize)
+        return false;
+
+    Reader reader = { payload + chunk.encodedOffset, payload + chunk.encodedOffset + chunk.encodedSize };
+    uint8_t* dest = geometry + chunk.offset;
+    bool succeeded = false;
+
+    switch (GeometryStreamType(chunk.type))
+    {
+    case GeometryStreamType::kVertex:
+        if (chunk.stride > 0 && chunk.size % chunk.stride == 0)
+        {
+            s_Scratch.resize(kMaxGeometryChunkSize);
+            succeeded = DecodeVertices(reader, chunk.size / chunk.stride, chunk.stride, s_Scratch.data(), dest);
+        }
+        break;
+
+    case GeometryStreamType::kIndex16:
+        if (chunk.size % 2 == 0)
+        {
+            s_Scratch.resize(size_t(kMaxGeometryChunkSize / 2) * 5);
+            succeeded = DecodeIndices<uint16_t>(reader, chunk.size / 2, s_Scratch.data(), dest);
+        }
+        break;
+
+    case GeometryStreamType::kIndex32:
+        if (chunk.size % 4 == 0)
+        {
+            s_Scratch.resize(size_t(kMaxGeometryChunkSize / 4) * 5);
+            succeeded = DecodeIndices<uint32_t>(reader, chunk.size / 4, s_Scratch.data(), dest);
+        }
+        break;
+
+    case GeometryStreamType::kRaw:
+    {
+        size_t size;
+        succeeded = DecodePlane(reader, dest, chunk.size, size) && size == chunk.size;
+        break;
+    }
+
+    default:
+        break;
+    }
+
+    return succeeded && reader.pos == reader.end;
+}
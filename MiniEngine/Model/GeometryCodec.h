@@ -0,0 +1,83 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+
+#pragma once
+
+// Lossless compression of the geometry blob of .mini files.  The blob is split into independent chunks of at most
+// kMaxGeometryChunkSize bytes, each of a single vertex or index buffer, so that they can be encoded and decoded on
+// any number of threads.  A chunk is transformed by the kind of data it holds, and every resulting byte plane is
+// entropy coded on its own with a length-limited canonical Huffman code:
+//      vertices    byte-plane transposed (byte k of every vertex together) and delta coded per plane
+//      indices     zigzag coded deltas against the previous index as LEB128 varints, which are mostly a single byte
+//                  for vertex cache optimized triangle lists
+//      raw         as is (alignment padding or anything not described by a mesh)
+// This header does not depend on pch.h so that it can be shared with portable (non-D3D12) tools.
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+enum class GeometryStreamType : uint8_t
+{
+    kRaw,
+    kVertex,
+    kIndex16,
+    kIndex32,
+};
+
+const uint32_t kMaxGeometryChunkSize = 256 * 1024;
+
+// A buffer of the geometry blob, as described by a mesh
+struct GeometryRegion
+{
+    uint32_t offset;
+    uint32_t size;
+    uint32_t stride;    // Vertex stride for kVertex
+    GeometryStreamType type;
+};
+
+// Stored in .mini files.  offset and size locate the decoded bytes in the geometry blob and encodedOffset and
+// encodedSize the encoded bytes in the payload that follows the chunk table.
+struct GeometryChunk
+{
+    uint32_t offset;
+    uint32_t size;
+    uint32_t encodedOffset;
+    uint32_t encodedSize;
+    uint16_t stride;
+    uint8_t  type;      // GeometryStreamType
+    uint8_t  reserved;
+};
+
+static_assert(sizeof(GeometryChunk) == 20, "GeometryChunk is tightly packed");
+
+//-----------------------------------------------------------------------------
+//  SplitGeometryChunks
+//-----------------------------------------------------------------------------
+//  Covers the geometry blob with chunks.  Regions may come in any order and
+//  may be repeated; bytes that no region covers, and regions that overlap
+//  one that starts before them, go into raw chunks.  Vertex and index chunks
+//  hold whole vertices and indices.  The encoded ranges are left at zero.
+//  Parameters:
+//      geometrySize
+//          the size of the geometry blob in bytes
+//      regions
+//          the vertex and index buffers of the blob
+//      chunks
+//          receives the chunks in ascending offset order
+//-----------------------------------------------------------------------------
+void SplitGeometryChunks(size_t geometrySize, std::vector<GeometryRegion> regions, std::vector<GeometryChunk>& chunks);
+
+// Replaces encoded with the encoded bytes of the chunk.  The output only depends on the chunk and the geometry.
+void EncodeGeometryChunk(const GeometryChunk& chunk, const uint8_t* geometry, std::vector<uint8_t>& encoded);
+
+// Decodes a chunk into its range of geometry, which is only written to so that it can be write-combined upload
+// memory.  payload is the whole encoded payload the chunk table refers to.  Returns false if the encoded bytes are
+// malformed, leaving the range of the chunk undefined.
+bool DecodeGeometryChunk(const GeometryChunk& chunk, const uint8_t* payload, size_t payloadSize, uint8_t* geometry);
@@ -0,0 +1,311 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Developed by Minigraph
+//
+// Author:  Alex Nankervis
+//
+
+#include "H3DData.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cctype>
+#include <cmath>
+#include <cfloat>
+#include <cstring>
+#include <string>
+
+namespace
+{
+    void ResetBoundingBox(H3DData::BoundingBox& bbox)
+    {
+        for (int i = 0; i < 3; ++i)
+        {
+            bbox.min[i] = FLT_MAX;
+            bbox.max[i] = -FLT_MAX;
+        }
+        bbox.min[3] = 0.0f;
+        bbox.max[3] = 0.0f;
+    }
+
+    // The vertices [byteOffset, byteOffset + vertexCount * stride) lie within a section of sectionSize bytes.
+    bool IsRangeInSection(uint32_t byteOffset, uint32_t vertexCount, uint32_t stride, uint32_t sectionSize)
+    {
+        return (uint64_t)byteOffset + (uint64_t)vertexCount * stride <= sectionSize;
+    }
+
+    bool AreIndicesBelow(const uint16_t* indices, uint32_t indexCount, uint32_t vertexCount)
+    {
+        for (uint32_t i = 0; i < indexCount; ++i)
+        {
+            if (indices[i] >= vertexCount)
+                return false;
+        }
+        return true;
+    }
+
+    void AddPoint(H3DData::BoundingBox& bbox, const float* point)
+    {
+        for (int i = 0; i < 3; ++i)
+        {
+            bbox.min[i] = std::min(bbox.min[i], point[i]);
+            bbox.max[i] = std::max(bbox.max[i], point[i]);
+        }
+    }
+}
+
+H3DData::H3DData()
+    : m_pMesh(nullptr)
+    , m_pMaterial(nullptr)
+    , m_pVertexData(nullptr)
+    , m_pIndexData(nullptr)
+    , m_pVertexDataDepth(nullptr)
+    , m_pIndexDataDepth(nullptr)
+{
+    Clear();
+}
+
+void H3DData::Clear()
+{
+    m_File.Close();
+
+    m_pMesh = nullptr;
+    m_Header.meshCount = 0;
+
+    m_pMaterial = nullptr;
+    m_Header.materialCount = 0;
+
+    m_pVertexData = nullptr;
+    m_Header.vertexDataByteSize = 0;
+    m_pIndexData = nullptr;
+    m_Header.indexDataByteSize = 0;
+    m_pVertexDataDepth = nullptr;
+    m_Header.vertexDataByteSizeDepth = 0;
+    m_pIndexDataDepth = nullptr;
+
+    ResetBoundingBox(m_Header.boundingBox);
+}
+
+const H3DData::Mesh& H3DData::GetMesh(uint32_t meshIdx) const
+{
+    assert(meshIdx < m_Header.meshCount);
+    return m_pMesh[meshIdx];
+}
+
+const H3DData::Material& H3DData::GetMaterial(uint32_t materialIdx) const
+{
+    assert(materialIdx < m_Header.materialCount);
+    return m_pMaterial[materialIdx];
+}
+
+bool H3DData::IsAlphaTested(uint32_t materialIdx) const
+{
+    std::string diffusePath = GetMaterial(materialIdx).texDiffusePath;
+    std::transform(diffusePath.begin(), diffusePath.end(), diffusePath.begin(), [](char c) { return (char)std::tolower((unsigned char)c); });
+
+    return diffusePath.find("thorn") != std::string::npos ||
+        diffusePath.find("plant") != std::string::npos ||
+        diffusePath.find("chain") != std::string::npos;
+}
+
+size_t H3DData::GetGeometryDataByteSize() const
+{
+    return (size_t)m_Header.vertexDataByteSize + m_Header.indexDataByteSize + m_Header.vertexDataByteSizeDepth + GetIndexDataByteSizeDepth();
+}
+
+uint32_t H3DData::GetTriangleCount() const
+{
+    uint32_t triangleCount = 0;
+    for (uint32_t meshIndex = 0; meshIndex < m_Header.meshCount; ++meshIndex)
+        triangleCount += m_pMesh[meshIndex].indexCount / 3;
+    return triangleCount;
+}
+
+bool H3DData::HasFloatVertexLayout(uint32_t meshIndex) const
+{
+    const Mesh& mesh = GetMesh(meshIndex);
+    const uint32_t attribs[] = { attrib_position, attrib_texcoord0, attrib_normal, attrib_tangent, attrib_bitangent };
+    const uint16_t components[] = { 3, 2, 3, 3, 3 };
+
+    if (mesh.vertexStride != 56)
+        return false;
+
+    uint16_t offset = 0;
+    for (uint32_t i = 0; i < 5; ++i)
+    {
+        const Attrib& attrib = mesh.attrib[attribs[i]];
+        if ((mesh.attribsEnabled & (1 << attribs[i])) == 0 || attrib.format != attrib_format_float ||
+            attrib.components != components[i] || attrib.offset != offset)
+            return false;
+        offset += components[i] * sizeof(float);
+    }
+
+    return true;
+}
+
+float H3DData::ComputeTexcoordDensity(uint32_t meshIndex) const
+{
+    const Mesh& mesh = GetMesh(meshIndex);
+    const Attrib& position = mesh.attrib[attrib_position];
+    const Attrib& texcoord = mesh.attrib[attrib_texcoord0];
+
+    if ((mesh.attribsEnabled & attrib_mask_texcoord0) == 0 || texcoord.format != attrib_format_float || texcoord.components < 2)
+        return 0.0f;
+
+    const uint8_t* vertices = m_pVertexData + mesh.vertexDataByteOffset;
+    const uint16_t* indices = GetIndexData() + mesh.indexDataByteOffset / sizeof(uint16_t);
+    double worldArea = 0.0;
+    double texcoordArea = 0.0;
+
+    for (uint32_t i = 0; i + 2 < mesh.indexCount; i += 3)
+    {
+        float p[3][3];
+        float uv[3][2];
+        for (uint32_t j = 0; j < 3; ++j)
+        {
+            const uint8_t* vertex = vertices + (size_t)indices[i + j] * mesh.vertexStride;
+            std::memcpy(p[j], vertex + position.offset, sizeof(p[j]));
+            std::memcpy(uv[j], vertex + texcoord.offset, sizeof(uv[j]));
+        }
+
+        const float e1[3] = { p[1][0] - p[0][0], p[1][1] - p[0][1], p[1][2] - p[0][2] };
+        const float e2[3] = { p[2][0] - p[0][0], p[2][1] - p[0][1], p[2][2] - p[0][2] };
+        const float cross[3] = { e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0] };
+        worldArea += std::sqrt((double)cross[0] * cross[0] + (double)cross[1] * cross[1] + (double)cross[2] * cross[2]);
+        texcoordArea += std::abs((double)(uv[1][0] - uv[0][0]) * (uv[2][1] - uv[0][1]) - (double)(uv[2][0] - uv[0][0]) * (uv[1][1] - uv[0][1]));
+    }
+
+    return worldArea > 0.0 ? (float)std::sqrt(texcoordArea / worldArea) : 0.0f;
+}
+
+void H3DData::ComputeMeshBoundingBox(uint32_t meshIndex, BoundingBox& bbox) const
+{
+    const Mesh& mesh = GetMesh(meshIndex);
+
+    ResetBoundingBox(bbox);
+
+    const uint8_t* p = m_pVertexData + mesh.vertexDataByteOffset + mesh.attrib[attrib_position].offset;
+    const uint8_t* pEnd = p + (size_t)mesh.vertexCount * mesh.vertexStride;
+
+    for (; p < pEnd; p += mesh.vertexStride)
+    {
+        float pos[3];
+        std::memcpy(pos, p, sizeof(pos));
+        AddPoint(bbox, pos);
+    }
+}
+
+void H3DData::ComputeGlobalBoundingBox(BoundingBox& bbox) const
+{
+    ResetBoundingBox(bbox);
+
+    for (uint32_t meshIndex = 0; meshIndex < m_Header.meshCount; meshIndex++)
+    {
+        const Mesh& mesh = m_pMesh[meshIndex];
+        AddPoint(bbox, mesh.boundingBox.min);
+        AddPoint(bbox, mesh.boundingBox.max);
+    }
+}
+
+void H3DData::ComputeAllBoundingBoxes()
+{
+    for (uint32_t meshIndex = 0; meshIndex < m_Header.meshCount; meshIndex++)
+    {
+        Mesh& mesh = m_pMesh[meshIndex];
+        ComputeMeshBoundingBox(meshIndex, mesh.boundingBox);
+    }
+    ComputeGlobalBoundingBox(m_Header.boundingBox);
+}
+
+bool H3DData::Load(const std::wstring& fileName)
+{
+    Clear();
+
+    return m_File.Open(fileName) && MapSections();
+}
+
+bool H3DData::Load(const std::string& fileName)
+{
+    Clear();
+
+    return m_File.Open(fileName) && MapSections();
+}
+
+bool H3DData::MapSections()
+{
+    if (m_File.GetSize() < sizeof(Header))
+    {
+        Clear();
+        return false;
+    }
+
+    // Sections follow the header in file order: meshes, materials, vertices, indices, depth vertices and depth indices.
+    // The mapping is page aligned and every section size is a multiple of 16 bytes, so the views keep the alignment of BoundingBox.
+    uint8_t* fileData = m_File.GetData();
+    std::memcpy(&m_Header, fileData, sizeof(Header));
+
+    const size_t meshOffset = sizeof(Header);
+    const size_t materialOffset = meshOffset + sizeof(Mesh) * m_Header.meshCount;
+    const size_t vertexDataOffset = materialOffset + sizeof(Material) * m_Header.materialCount;
+    const size_t indexDataOffset = vertexDataOffset + m_Header.vertexDataByteSize;
+    const size_t vertexDataDepthOffset = indexDataOffset + m_Header.indexDataByteSize;
+    const size_t indexDataDepthOffset = vertexDataDepthOffset + m_Header.vertexDataByteSizeDepth;
+    const size_t fileSize = indexDataDepthOffset + GetIndexDataByteSizeDepth();
+
+    if (m_File.GetSize() < fileSize || m_Header.meshCount == 0)
+    {
+        Clear();
+        return false;
+    }
+
+    m_pMesh = reinterpret_cast<Mesh*>(fileData + meshOffset);
+    m_pMaterial = reinterpret_cast<Material*>(fileData + materialOffset);
+    m_pVertexData = fileData + vertexDataOffset;
+    m_pIndexData = fileData + indexDataOffset;
+    m_pVertexDataDepth = fileData + vertexDataDepthOffset;
+    m_pIndexDataDepth = fileData + indexDataDepthOffset;
+
+    if (!ValidateMeshes())
+    {
+        Clear();
+        return false;
+    }
+
+    return true;
+}
+
+bool H3DData::ValidateMeshes() const
+{
+    for (uint32_t meshIndex = 0; meshIndex < m_Header.meshCount; ++meshIndex)
+    {
+        const Mesh& mesh = m_pMesh[meshIndex];
+        const Attrib& position = mesh.attrib[attrib_position];
+        const Attrib& texcoord = mesh.attrib[attrib_texcoord0];
+
+        // ComputeMeshBoundingBox() reads 3 floats of position from every vertex, and ComputeTexcoordDensity() 2 floats of texture coordinates.
+        if (mesh.materialIndex >= m_Header.materialCount ||
+            (uint32_t)position.offset + 3 * sizeof(float) > mesh.vertexStride ||
+            ((mesh.attribsEnabled & attrib_mask_texcoord0) != 0 && (uint32_t)texcoord.offset + 2 * sizeof(float) > mesh.vertexStride))
+            return false;
+
+        // The depth-only indices are at the same offset in their section as the main ones.
+        if (!IsRangeInSection(mesh.vertexDataByteOffset, mesh.vertexCount, mesh.vertexStride, m_Header.vertexDataByteSize) ||
+            !IsRangeInSection(mesh.vertexDataByteOffsetDepth, mesh.vertexCountDepth, mesh.vertexStrideDepth, m_Header.vertexDataByteSizeDepth) ||
+            mesh.indexDataByteOffset % sizeof(uint16_t) != 0 ||
+            !IsRangeInSection(mesh.indexDataByteOffset, mesh.indexCount, sizeof(uint16_t), m_Header.indexDataByteSize))
+            return false;
+
+        const size_t firstIndex = mesh.indexDataByteOffset / sizeof(uint16_t);
+        if (!AreIndicesBelow(GetIndexData() + firstIndex, mesh.indexCount, mesh.vertexCount) ||
+            !AreIndicesBelow(GetIndexDataDepth() + firstIndex, mesh.indexCount, mesh.vertexCountDepth))
+            return false;
+    }
+
+    return true;
+}
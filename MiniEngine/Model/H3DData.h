@@ -0,0 +1,243 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Developed by Minigraph
+//
+// Author(s):   Alex Nankervis
+//              James Stanard
+//
+
+#pragma once
+
+// The CPU side of an H3D model: the file layout, the mesh and material tables and the geometry, with no
+// dependency on D3D12, DirectXMath or pch.h so that it also builds with GCC and Clang for tools and benchmarks.
+// ModelH3D uploads this data to the GPU.
+#include "../Core/MappedFile.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+class H3DData
+{
+public:
+
+    H3DData();
+    H3DData(H3DData&&) = default;
+    H3DData& operator=(H3DData&&) = default;
+
+    void Clear();
+
+    enum
+    {
+        attrib_mask_0 = (1 << 0),
+        attrib_mask_1 = (1 << 1),
+        attrib_mask_2 = (1 << 2),
+        attrib_mask_3 = (1 << 3),
+        attrib_mask_4 = (1 << 4),
+        attrib_mask_5 = (1 << 5),
+        attrib_mask_6 = (1 << 6),
+        attrib_mask_7 = (1 << 7),
+        attrib_mask_8 = (1 << 8),
+        attrib_mask_9 = (1 << 9),
+        attrib_mask_10 = (1 << 10),
+        attrib_mask_11 = (1 << 11),
+        attrib_mask_12 = (1 << 12),
+        attrib_mask_13 = (1 << 13),
+        attrib_mask_14 = (1 << 14),
+        attrib_mask_15 = (1 << 15),
+
+        // friendly name aliases
+        attrib_mask_position = attrib_mask_0,
+        attrib_mask_texcoord0 = attrib_mask_1,
+        attrib_mask_normal = attrib_mask_2,
+        attrib_mask_tangent = attrib_mask_3,
+        attrib_mask_bitangent = attrib_mask_4,
+    };
+
+    enum
+    {
+        attrib_0 = 0,
+        attrib_1 = 1,
+        attrib_2 = 2,
+        attrib_3 = 3,
+        attrib_4 = 4,
+        attrib_5 = 5,
+        attrib_6 = 6,
+        attrib_7 = 7,
+        attrib_8 = 8,
+        attrib_9 = 9,
+        attrib_10 = 10,
+        attrib_11 = 11,
+        attrib_12 = 12,
+        attrib_13 = 13,
+        attrib_14 = 14,
+        attrib_15 = 15,
+
+        // friendly name aliases
+        attrib_position = attrib_0,
+        attrib_texcoord0 = attrib_1,
+        attrib_normal = attrib_2,
+        attrib_tangent = attrib_3,
+        attrib_bitangent = attrib_4,
+
+        maxAttribs = 16
+    };
+
+    enum
+    {
+        attrib_format_none = 0,
+        attrib_format_ubyte,
+        attrib_format_byte,
+        attrib_format_ushort,
+        attrib_format_short,
+        attrib_format_float,
+
+        attrib_formats
+    };
+
+    // Same layout as Math::AxisAlignedBox.  The fourth components are unused.
+    struct BoundingBox
+    {
+        alignas(16) float min[4];
+        alignas(16) float max[4];
+    };
+
+    struct Header
+    {
+        uint32_t meshCount;
+        uint32_t materialCount;
+        uint32_t vertexDataByteSize;
+        uint32_t indexDataByteSize;
+        uint32_t vertexDataByteSizeDepth;
+        BoundingBox boundingBox;
+    };
+
+    struct Attrib
+    {
+        uint16_t offset; // byte offset from the start of the vertex
+        uint16_t normalized; // if true, integer formats are interpreted as [-1, 1] or [0, 1]
+        uint16_t components; // 1-4
+        uint16_t format;
+    };
+
+    struct Mesh
+    {
+        BoundingBox boundingBox;
+
+        uint32_t materialIndex;
+
+        uint32_t attribsEnabled;
+        uint32_t attribsEnabledDepth;
+        uint32_t vertexStride;
+        uint32_t vertexStrideDepth;
+        Attrib attrib[maxAttribs];
+        Attrib attribDepth[maxAttribs];
+
+        uint32_t vertexDataByteOffset;
+        uint32_t vertexCount;
+        uint32_t indexDataByteOffset;
+        uint32_t indexCount;
+
+        uint32_t vertexDataByteOffsetDepth;
+        uint32_t vertexCountDepth;
+    };
+
+    // Colors have the layout of Color (RGBA floats).
+    struct Material
+    {
+        alignas(16) float diffuse[4];
+        alignas(16) float specular[4];
+        alignas(16) float ambient[4];
+        alignas(16) float emissive[4];
+        alignas(16) float transparent[4]; // light passing through a transparent surface is multiplied by this filter color
+        float opacity;
+        float shininess; // specular exponent
+        float specularStrength; // multiplier on top of specular color
+
+        enum {maxTexPath = 128};
+        enum {texCount = 6};
+        char texDiffusePath[maxTexPath];
+        char texSpecularPath[maxTexPath];
+        char texEmissivePath[maxTexPath];
+        char texNormalPath[maxTexPath];
+        char texLightmapPath[maxTexPath];
+        char texReflectionPath[maxTexPath];
+
+        enum {maxMaterialName = 128};
+        char name[maxMaterialName];
+    };
+
+    static_assert(sizeof(Header) == 64, "H3D file layout");
+    static_assert(sizeof(Mesh) == 336, "H3D file layout");
+    static_assert(sizeof(Material) == 992, "H3D file layout");
+
+    // Maps the file.  The tables and the geometry are views into the mapping, so they are paged in on first access.
+    bool Load(const std::wstring& fileName);
+    bool Load(const std::string& fileName); // UTF-8
+
+    const Header& GetHeader() const { return m_Header; }
+
+    uint32_t GetMeshCount() const { return m_Header.meshCount; }
+    const Mesh& GetMesh(uint32_t meshIdx) const;
+
+    uint32_t GetMaterialCount() const { return m_Header.materialCount; }
+    const Material& GetMaterial(uint32_t materialIdx) const;
+
+    // Sponza has no alpha mode in its materials.  Its foliage and chains are recognized by their diffuse texture names.
+    bool IsAlphaTested(uint32_t materialIdx) const;
+
+    // The depth-only index data has no size of its own in the header.  It holds one index per main index
+    // (Mesh::indexCount), so it is exactly as large as the main index data.
+    uint32_t GetIndexDataByteSizeDepth() const { return m_Header.indexDataByteSize; }
+
+    const uint8_t* GetVertexData() const { return m_pVertexData; }
+    const uint16_t* GetIndexData() const { return reinterpret_cast<const uint16_t*>(m_pIndexData); }
+    const uint8_t* GetVertexDataDepth() const { return m_pVertexDataDepth; }
+    const uint16_t* GetIndexDataDepth() const { return reinterpret_cast<const uint16_t*>(m_pIndexDataDepth); }
+
+    // The vertex, index, depth vertex and depth index data, contiguous in this order as in the file.
+    const uint8_t* GetGeometryData() const { return m_pVertexData; }
+    size_t GetGeometryDataByteSize() const;
+
+    uint32_t GetTriangleCount() const;
+
+    // The mesh has float3 positions, float2 texture coordinates and float3 normals, tangents and bitangents, packed
+    // in this order, so that its vertices can be read as FloatVertex (VertexQuantization.h).
+    bool HasFloatVertexLayout(uint32_t meshIndex) const;
+
+    // Texture coordinate units per world unit: the square root of the ratio of the texture coordinate area of the
+    // triangles to their area in world space.  0 if the mesh has no float texture coordinates.  Texture streaming
+    // multiplies it by the texture size to get the texels per world unit.
+    float ComputeTexcoordDensity(uint32_t meshIndex) const;
+
+    // assuming at least 3 floats for position
+    void ComputeMeshBoundingBox(uint32_t meshIndex, BoundingBox& bbox) const;
+    void ComputeGlobalBoundingBox(BoundingBox& bbox) const;
+    void ComputeAllBoundingBoxes();
+
+protected:
+
+    bool MapSections();
+
+    // Every mesh reads its vertices and indices within the sections, and every index is below the vertex count of
+    // its mesh, so that nothing reads past the mapping of a malformed file.
+    bool ValidateMeshes() const;
+
+    Header m_Header;
+    Mesh* m_pMesh;
+    Material* m_pMaterial;
+
+    // Views into m_File, which is mapped copy-on-write so that the data is paged in lazily and never copied.
+    // m_pMesh and m_pMaterial also point into it, so ComputeAllBoundingBoxes() can update the meshes without touching the file.
+    Utility::MappedFile m_File;
+    uint8_t* m_pVertexData;
+    uint8_t* m_pIndexData;
+    uint8_t* m_pVertexDataDepth;
+    uint8_t* m_pIndexDataDepth;
+};
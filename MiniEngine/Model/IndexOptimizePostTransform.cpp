@@ -1,5 +1,5 @@
 //-----------------------------------------------------------------------------
-//  This is an implementation of Tom Forsyth's "Linear-Speed Vertex Cache 
+//  This is an implementation of Tom Forsyth's "Linear-Speed Vertex Cache
 //  Optimization" algorithm as described here:
 //  https://tomforsyth1000.github.io/papers/fast_vert_cache_opt.html
 //
@@ -9,21 +9,24 @@
 //  THIS SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
 //  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
 //  FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
-//  SHALL ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE FOR ANY DAMAGES OR OTHER 
+//  SHALL ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE FOR ANY DAMAGES OR OTHER
 //  LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR
 //  IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 //-----------------------------------------------------------------------------
 
 // modified from original source to improve performance (especially in debug builds), memory allocations, etc.
+//
+// Per-vertex state lives in flat arrays, the triangles of each vertex are stored in one compressed array, vertex
+// scores come from lookup tables only, and a dead end restarts from a stack of recently evicted vertices or a
+// cursor over the input instead of a list of faces kept sorted by valence.  The Tipsify optimizer and the cache
+// analysis share the same adjacency.
 
-#include "../Core/Utility.h"
+#include "IndexOptimizePostTransform.h"
 
-#include <stdint.h>
-#include <ASSERT.h>
-#include <math.h>
 #include <algorithm>
-
-#include "IndexOptimizePostTransform.h"
+#include <cassert>
+#include <cmath>
+#include <memory>
 
 namespace
 {
@@ -52,7 +55,7 @@ namespace
             }
             else
             {
-                ASSERT ( cachePosition < int(vertexCacheSize) );
+                assert ( cachePosition < int(vertexCacheSize) );
                 // Points for being high in the cache.
                 const float scaler = 1.0f / ( vertexCacheSize - 3 );
                 score = 1.0f - ( cachePosition - 3 ) * scaler;
@@ -108,111 +111,101 @@ namespace
     }
     bool s_vertexScoresComputed = ComputeVertexScores();
 
-    inline float FindVertexCacheScore(size_t cachePosition, size_t maxSizeVertexCache)
-    {
-        return s_vertexCacheScores[maxSizeVertexCache][cachePosition];
-    }
+    const uint32_t kNotInCache = ~0u;
+    const uint32_t kNoVertex = ~0u;
+    const uint32_t kNoFace = ~0u;
 
-    inline float FindVertexValenceScore(size_t numActiveTris)
+    // Scores from the tables only.  Vertices with more active faces than the valence table covers score as the
+    // last entry; their boost is small either way and they are rare in practice.
+    inline float FindVertexScore(uint32_t numActiveFaces, uint32_t cachePosition, size_t vertexCacheSize)
     {
-        return s_vertexValenceScores[numActiveTris];
-    }
-
-    float FindVertexScore(size_t numActiveFaces, size_t cachePosition, size_t vertexCacheSize)
-    {
-        //ASSERT(s_vertexScoresComputed);
-
         if (numActiveFaces == 0)
         {
             // No tri needs this vertex!
             return -1.0f;
         }
 
-        float score = 0.0f;
+        float score = s_vertexValenceScores[std::min<uint32_t>(numActiveFaces, kMaxPrecomputedVertexValenceScores - 1)];
         if (cachePosition < vertexCacheSize)
         {
             score += s_vertexCacheScores[vertexCacheSize][cachePosition];
         }
 
-        if (numActiveFaces < kMaxPrecomputedVertexValenceScores)
-        {
-            score += s_vertexValenceScores[numActiveFaces];
-        }
-        else
-        {
-            score += ComputeVertexValenceScore(numActiveFaces);
-        }
-
         return score;
     }
 
-    struct OptimizeVertexData
-    {
-        float   score;
-        size_t  activeFaceListStart;
-        size_t  activeFaceListSize;
-        size_t  cachePos0;
-        size_t  cachePos1;
-        OptimizeVertexData() : score(0.0f), activeFaceListStart(0), activeFaceListSize(0), cachePos0(0), cachePos1(0) { }
-    };
-}
-
-template <typename IndexType>
-struct IndexSortCompareIndexed
-{
-    const IndexType* _indexData;
-
-    IndexSortCompareIndexed(const IndexType* indexData)
-        : _indexData(indexData)
+    template <typename IndexType>
+    size_t CountVertices(const IndexType* indexList, size_t indexCount)
     {
+        uint32_t maxIndex = 0;
+        for (size_t i = 0; i < indexCount; ++i)
+        {
+            maxIndex = std::max<uint32_t>(maxIndex, indexList[i]);
+        }
+        return (size_t)maxIndex + 1;
     }
 
-    bool operator()(size_t a, size_t b) const
+    // The faces that use each vertex in compressed rows: the faces of vertex v are
+    // faces[offsets[v], offsets[v + 1]), and the first activeCounts[v] of them have not been emitted yet
+    // when the optimizer keeps them compacted with RemoveFace().
+    struct VertexFaceAdjacency
     {
-        IndexType indexA = _indexData[a];
-        IndexType indexB = _indexData[b];
+        std::unique_ptr<uint32_t[]> offsets;
+        std::unique_ptr<uint32_t[]> activeCounts;
+        std::unique_ptr<uint32_t[]> faces;
 
-        return indexA < indexB;
-    }
-};
+        template <typename IndexType>
+        void Build(const IndexType* indexList, size_t indexCount, size_t vertexCount)
+        {
+            offsets.reset(new uint32_t[vertexCount + 1]);
+            activeCounts.reset(new uint32_t[vertexCount]());
+            faces.reset(new uint32_t[indexCount]);
 
-struct FaceValenceSort
-{
-    const OptimizeVertexData* _vertexData;
+            for (size_t i = 0; i < indexCount; ++i)
+            {
+                activeCounts[indexList[i]]++;
+            }
 
-    FaceValenceSort(const OptimizeVertexData* vertexData)
-        : _vertexData(vertexData)
-    {
-    }
+            uint32_t offset = 0;
+            for (size_t v = 0; v < vertexCount; ++v)
+            {
+                offsets[v] = offset;
+                offset += activeCounts[v];
+                activeCounts[v] = 0;
+            }
+            offsets[vertexCount] = offset;
 
-    bool operator()(size_t a, size_t b) const
-    {
-        const OptimizeVertexData* vA0 = _vertexData + a * 3 + 0;
-        const OptimizeVertexData* vA1 = _vertexData + a * 3 + 1;
-        const OptimizeVertexData* vA2 = _vertexData + a * 3 + 2;
-        const OptimizeVertexData* vB0 = _vertexData + b * 3 + 0;
-        const OptimizeVertexData* vB1 = _vertexData + b * 3 + 1;
-        const OptimizeVertexData* vB2 = _vertexData + b * 3 + 2;
-
-        size_t aValence = vA0->activeFaceListSize + vA1->activeFaceListSize + vA2->activeFaceListSize;
-        size_t bValence = vB0->activeFaceListSize + vB1->activeFaceListSize + vB2->activeFaceListSize;
-
-        // higher scoring faces are those with lower valence totals
-        // reverse sort (reverse of reverse)
-        return aValence < bValence;
-    }
-};
+            for (size_t i = 0; i < indexCount; ++i)
+            {
+                const uint32_t vertex = indexList[i];
+                faces[offsets[vertex] + activeCounts[vertex]++] = (uint32_t)(i / 3);
+            }
+        }
+
+        const uint32_t* ActiveFacesBegin(uint32_t vertex) const { return faces.get() + offsets[vertex]; }
+        const uint32_t* ActiveFacesEnd(uint32_t vertex) const { return faces.get() + offsets[vertex] + activeCounts[vertex]; }
+
+        // Swaps an emitted face behind the active ones.  A degenerate face is listed once per corner and removed as often.
+        void RemoveFace(uint32_t vertex, uint32_t face)
+        {
+            uint32_t* begin = faces.get() + offsets[vertex];
+            uint32_t* end = begin + activeCounts[vertex];
+            uint32_t* it = std::find(begin, end, face);
+            assert(it != end);
+            std::swap(*it, *(end - 1));
+            --activeCounts[vertex];
+        }
+    };
+}
 
 //-----------------------------------------------------------------------------
-//  OptimizeFaces
+//  OptimizeFacesForsyth
 //-----------------------------------------------------------------------------
 //  Parameters:
 //      indexList
 //          input index list
 //      indexCount
 //          the number of indices in the list
-//      vertexCount
-//          the largest index value in indexList
 //      newIndexList
 //          a pointer to a preallocated buffer the same size as indexList to
 //          hold the optimized index list
@@ -220,94 +213,84 @@ struct FaceValenceSort
 //          the size of the simulated post-transform cache (max:64)
 //-----------------------------------------------------------------------------
 template <typename SrcIndexType, typename DstIndexType>
-void OptimizeFaces(const SrcIndexType* indexList, size_t indexCount, DstIndexType* newIndexList, size_t lruCacheSize)
+void OptimizeFacesForsyth(const SrcIndexType* indexList, size_t indexCount, DstIndexType* newIndexList, size_t lruCacheSize)
 {
-    ASSERT(lruCacheSize <= kMaxVertexCacheSize);
+    assert(lruCacheSize <= kMaxVertexCacheSize);
+    assert(indexCount % 3 == 0);
+
+    const size_t faceCount = indexCount / 3;
+    if (faceCount == 0)
+        return;
 
-    std::unique_ptr<OptimizeVertexData[]> vertexDataList(new OptimizeVertexData[indexCount]); // upper bounds on size is indexCount
-    std::unique_ptr<uint32_t[]> vertexRemap(new uint32_t[indexCount]);
-    std::unique_ptr<uint32_t[]> activeFaceList(new uint32_t[indexCount]);
+    const size_t vertexCount = CountVertices(indexList, indexCount);
 
-    size_t faceCount = indexCount / 3;
-    std::unique_ptr<uint8_t[]> processedFaceList(new uint8_t[faceCount]);
-    memset(processedFaceList.get(), 0, sizeof(uint8_t) * faceCount);
-    std::unique_ptr<uint32_t[]> faceSorted(new uint32_t[faceCount]);
-    std::unique_ptr<uint32_t[]> faceReverseLookup(new uint32_t[faceCount]);
+    VertexFaceAdjacency adjacency;
+    adjacency.Build(indexList, indexCount, vertexCount);
+    const uint32_t* activeCounts = adjacency.activeCounts.get();
 
-    // build the vertex remap table
-    uint32_t uniqueVertexCount = 0;
+    std::unique_ptr<float[]> vertexScores(new float[vertexCount]);
+    for (size_t v = 0; v < vertexCount; ++v)
     {
-        typedef IndexSortCompareIndexed<SrcIndexType> indexSorter;
-        uint32_t* indexSorted = new uint32_t[indexCount];
+        vertexScores[v] = FindVertexScore(activeCounts[v], kNotInCache, lruCacheSize);
+    }
 
-        for (uint32_t i = 0; i < indexCount; i++)
-        {
-            indexSorted[i] = i;
-        }
+    auto FaceScore = [&](uint32_t face)
+    {
+        const SrcIndexType* corners = indexList + face * 3;
+        return vertexScores[corners[0]] + vertexScores[corners[1]] + vertexScores[corners[2]];
+    };
+
+    std::unique_ptr<uint8_t[]> processedFaceList(new uint8_t[faceCount]());
 
-        indexSorter sortFunc(indexList);
-        std::sort(indexSorted, indexSorted + indexCount, sortFunc);
+    // Vertices evicted while they still had active faces.  There are at most three per emitted face.
+    std::unique_ptr<uint32_t[]> deadEndStack(new uint32_t[indexCount]);
+    size_t deadEndStackSize = 0;
+    uint32_t nextInputFace = 0;
 
-        for (uint32_t i = 0; i < indexCount; i++)
+    // no verts in the cache are used by any unprocessed faces, so restart next to the most recently
+    // evicted vertex that still has some, or failing that at the first unprocessed face in input order
+    auto SkipDeadEnd = [&]()
+    {
+        while (deadEndStackSize > 0)
         {
-            if (i == 0 || sortFunc(indexSorted[i - 1], indexSorted[i]))
-            {
-                // it's not a duplicate
-                vertexRemap[indexSorted[i]] = uniqueVertexCount;
-                uniqueVertexCount++;
-            }
-            else
+            const uint32_t vertex = deadEndStack[--deadEndStackSize];
+            uint32_t bestFace = kNoFace;
+            float bestScore = -1.0f;
+            for (const uint32_t* it = adjacency.ActiveFacesBegin(vertex); it != adjacency.ActiveFacesEnd(vertex); ++it)
             {
-                vertexRemap[indexSorted[i]] = vertexRemap[indexSorted[i - 1]];
+                const float faceScore = FaceScore(*it);
+                if (faceScore > bestScore)
+                {
+                    bestScore = faceScore;
+                    bestFace = *it;
+                }
             }
+            if (bestFace != kNoFace)
+                return bestFace;
         }
 
-        delete[] indexSorted;
-    }
-
-    // compute face count per vertex
-    for (size_t i = 0; i < indexCount; ++i)
-    {
-        vertexDataList[vertexRemap[i]].activeFaceListSize++;
-    }
-
-    constexpr size_t kEvictedCacheIndex = std::numeric_limits<DstIndexType>::max();
-    {
-        // allocate face list per vertex
-        size_t curActiveFaceListPos = 0;
-        for (uint32_t i = 0; i < uniqueVertexCount; ++i)
+        for (; nextInputFace < faceCount; ++nextInputFace)
         {
-            OptimizeVertexData& vertexData = vertexDataList[i];
-            vertexData.cachePos0 = kEvictedCacheIndex;
-            vertexData.cachePos1 = kEvictedCacheIndex;
-            vertexData.activeFaceListStart = curActiveFaceListPos;
-            curActiveFaceListPos += vertexData.activeFaceListSize;
-            vertexData.score = FindVertexScore(vertexData.activeFaceListSize, vertexData.cachePos0, lruCacheSize);
-            vertexData.activeFaceListSize = 0;
+            if (processedFaceList[nextInputFace] == 0)
+                return nextInputFace;
         }
-        ASSERT(curActiveFaceListPos == indexCount);
-    }
 
-    // sort unprocessed faces by highest score
-    for (uint32_t f = 0; f < faceCount; f++)
-    {
-        faceSorted[f] = f;
-    }
-    FaceValenceSort faceValenceSort(vertexDataList.get());
-    std::sort(faceSorted.get(), faceSorted.get() + faceCount, faceValenceSort);
-    for (uint32_t f = 0; f < faceCount; f++)
-    {
-        faceReverseLookup[faceSorted[f]] = f;
-    }
+        assert(false);
+        return kNoFace;
+    };
 
-    // fill out face list per vertex
-    for (uint32_t i=0; i<indexCount; i+=3)
+    // start with the best scoring face, which is the one with the lowest valence total
+    uint32_t bestFace = 0;
     {
-        for (size_t j=0; j<3; ++j)
+        float bestScore = -1.0f;
+        for (uint32_t f = 0; f < faceCount; ++f)
         {
-            OptimizeVertexData& vertexData = vertexDataList[vertexRemap[i + j]];
-            activeFaceList[vertexData.activeFaceListStart + vertexData.activeFaceListSize] = i;
-            vertexData.activeFaceListSize++;
+            const float faceScore = FaceScore(f);
+            if (faceScore > bestScore)
+            {
+                bestScore = faceScore;
+                bestFace = f;
+            }
         }
     }
 
@@ -316,135 +299,222 @@ void OptimizeFaces(const SrcIndexType* indexList, size_t indexCount, DstIndexTyp
     uint32_t* cache1 = vertexCacheBuffer + kMaxVertexCacheSize + 3;
     size_t entriesInCache0 = 0;
 
-    uint32_t bestFace = 0;
-    float bestScore = -1.0f;
-
-    //const float maxValenceScore = FindVertexScore(1, kEvictedCacheIndex, lruCacheSize) * 3.0f;
-
-    uint32_t nextBestFace = 0;
-    for (uint32_t i = 0; i < indexCount; i += 3)
+    for (size_t i = 0; i < indexCount; i += 3)
     {
-        if (bestScore < 0.0f)
-        {
-            // no verts in the cache are used by any unprocessed faces so
-            // search all unprocessed faces for a new starting point
-            for (; nextBestFace < faceCount; nextBestFace++)
-            {
-                uint32_t faceIndex = faceSorted[nextBestFace];
-                if (processedFaceList[faceIndex] == 0)
-                {
-                    uint32_t face = faceIndex * 3;
-                    float faceScore = 0.0f;
-                    for (uint32_t k=0; k<3; ++k)
-                    {
-                        //ASSERT(vertexData.activeFaceListSize > 0);
-                        //ASSERT(vertexData.cachePos0 >= lruCacheSize);
+        if (bestFace == kNoFace)
+            bestFace = SkipDeadEnd();
 
-                        float vertexScore = vertexDataList[vertexRemap[face + k]].score;
-                        faceScore += vertexScore; 
-                    }
+        processedFaceList[bestFace] = 1;
 
-                    bestScore = faceScore;
-                    bestFace = face;
+        const SrcIndexType* corners = indexList + bestFace * 3;
+        const uint32_t v0 = corners[0];
+        const uint32_t v1 = corners[1];
+        const uint32_t v2 = corners[2];
 
-                    nextBestFace++;
-                    break; // we're searching a pre-sorted list, first one we find will be the best
-                }
-            }
-            ASSERT(bestScore >= 0.0f);
+        // add bestFace to LRU cache and to newIndexList
+        size_t entriesInCache1 = 0;
+        for (uint32_t v = 0; v < 3; ++v)
+        {
+            const uint32_t vertex = corners[v];
+            newIndexList[i + v] = (DstIndexType)vertex;
+            adjacency.RemoveFace(vertex, bestFace);
+
+            if (std::find(cache1, cache1 + entriesInCache1, vertex) == cache1 + entriesInCache1)
+                cache1[entriesInCache1++] = vertex;
         }
 
-        processedFaceList[bestFace / 3] = 1;
-        size_t entriesInCache1 = 0;
+        // move the rest of the old verts in the cache down
+        for (size_t c0 = 0; c0 < entriesInCache0; ++c0)
+        {
+            const uint32_t vertex = cache0[c0];
+            if (vertex != v0 && vertex != v1 && vertex != v2)
+                cache1[entriesInCache1++] = vertex;
+        }
 
-        // add bestFace to LRU cache and to newIndexList
-        for (uint32_t v = 0; v < 3; ++v)
+        // update the scores of the verts in the cache, and of up to 3 that were just evicted
+        for (size_t c1 = 0; c1 < entriesInCache1; ++c1)
         {
-            uint32_t index = indexList[bestFace + v];
-            newIndexList[i+v] = (DstIndexType)index;
+            const uint32_t vertex = cache1[c1];
+            const uint32_t cachePosition = c1 < lruCacheSize ? (uint32_t)c1 : kNotInCache;
+            vertexScores[vertex] = FindVertexScore(activeCounts[vertex], cachePosition, lruCacheSize);
 
-            OptimizeVertexData& vertexData = vertexDataList[vertexRemap[bestFace + v]];
+            if (cachePosition == kNotInCache && activeCounts[vertex] > 0)
+                deadEndStack[deadEndStackSize++] = vertex;
+        }
 
-            if (vertexData.cachePos1 >= entriesInCache1)
+        // find the best scoring triangle in the current cache (including up to 3 that were just evicted)
+        bestFace = kNoFace;
+        float bestScore = -1.0f;
+        for (size_t c1 = 0; c1 < entriesInCache1; ++c1)
+        {
+            const uint32_t vertex = cache1[c1];
+            for (const uint32_t* it = adjacency.ActiveFacesBegin(vertex); it != adjacency.ActiveFacesEnd(vertex); ++it)
             {
-                vertexData.cachePos1 = entriesInCache1;
-                cache1[entriesInCache1++] = vertexRemap[bestFace + v];
-
-                if (vertexData.activeFaceListSize == 1)
+                const float faceScore = FaceScore(*it);
+                if (faceScore > bestScore)
                 {
-                    --vertexData.activeFaceListSize;
-                    continue;
+                    bestScore = faceScore;
+                    bestFace = *it;
                 }
             }
+        }
 
-            ASSERT(vertexData.activeFaceListSize > 0);
-            uint32_t* begin = activeFaceList.get() + vertexData.activeFaceListStart;
-            uint32_t* end = begin + vertexData.activeFaceListSize;
-            uint32_t* it = std::find(begin, end, bestFace);
-            ASSERT(it != end);
-            std::swap(*it, *(end-1));
-            --vertexData.activeFaceListSize;
-            vertexData.score = FindVertexScore(vertexData.activeFaceListSize, vertexData.cachePos1, lruCacheSize);
-
-            // need to re-sort the faces that use this vertex, as their score will change due to activeFaceListSize shrinking
-            for (uint32_t* fi = begin; fi != end - 1; ++fi)
-            {
-                uint32_t faceIndex = *fi / 3;
+        std::swap(cache0, cache1);
+        entriesInCache0 = std::min(entriesInCache1, lruCacheSize);
+    }
+}
+
+//-----------------------------------------------------------------------------
+//  OptimizeFacesTipsify
+//-----------------------------------------------------------------------------
+//  Emits all remaining faces around a fanning vertex, then moves on to the
+//  vertex of those faces that will still be in the FIFO cache after its own
+//  faces are emitted, preferring the one that entered the cache first.
+//  Faces keep their winding; only their order changes.
+//-----------------------------------------------------------------------------
+template <typename SrcIndexType, typename DstIndexType>
+void OptimizeFacesTipsify(const SrcIndexType* indexList, size_t indexCount, DstIndexType* newIndexList, size_t cacheSize)
+{
+    assert(indexCount % 3 == 0);
 
-                uint32_t n = faceReverseLookup[faceIndex];
-                ASSERT(faceSorted[n] == faceIndex);
+    const size_t faceCount = indexCount / 3;
+    if (faceCount == 0)
+        return;
 
-                // found it, now move it up
-                for (n; n > 0; --n)
-                {
-                    if (!faceValenceSort(n, n - 1))
-                        break;
+    const size_t vertexCount = CountVertices(indexList, indexCount);
 
-                    faceReverseLookup[faceSorted[n]] = n - 1;
-                    faceReverseLookup[faceSorted[n - 1]] = n;
-                    std::swap(faceSorted[n], faceSorted[n - 1]);
-                }
-            }
-        }
+    // Faces are only marked as emitted here, so the rows keep all of their faces and activeCounts are
+    // decremented on their own.
+    VertexFaceAdjacency adjacency;
+    adjacency.Build(indexList, indexCount, vertexCount);
+    uint32_t* activeCounts = adjacency.activeCounts.get();
+
+    std::unique_ptr<uint32_t[]> cacheTimeStamps(new uint32_t[vertexCount]());
+    std::unique_ptr<uint8_t[]> processedFaceList(new uint8_t[faceCount]());
+    std::unique_ptr<uint32_t[]> deadEndStack(new uint32_t[indexCount]);
+    std::unique_ptr<uint32_t[]> candidates(new uint32_t[indexCount]);
+    size_t deadEndStackSize = 0;
+    uint32_t nextInputVertex = 0;
+
+    uint32_t time = (uint32_t)cacheSize + 1;
+    size_t newIndexCount = 0;
 
-        // move the rest of the old verts in the cache down and compute their new scores
-        for (uint32_t c0 = 0; c0 < entriesInCache0; ++c0)
+    uint32_t fanningVertex = indexList[0];
+    while (fanningVertex != kNoVertex)
+    {
+        size_t candidateCount = 0;
+
+        const uint32_t* facesBegin = adjacency.faces.get() + adjacency.offsets[fanningVertex];
+        const uint32_t* facesEnd = adjacency.faces.get() + adjacency.offsets[fanningVertex + 1];
+        for (const uint32_t* it = facesBegin; it != facesEnd; ++it)
         {
-            OptimizeVertexData& vertexData = vertexDataList[cache0[c0]];
+            const uint32_t face = *it;
+            if (processedFaceList[face] != 0)
+                continue;
+
+            processedFaceList[face] = 1;
 
-            if (vertexData.cachePos1 >= entriesInCache1)
+            for (uint32_t v = 0; v < 3; ++v)
             {
-                vertexData.cachePos1 = entriesInCache1;
-                cache1[entriesInCache1++] = cache0[c0];
-                vertexData.score = FindVertexScore(vertexData.activeFaceListSize, vertexData.cachePos1, lruCacheSize);
-                // don't need to re-sort this vertex... once it gets out of the cache, it'll have its original score
+                const uint32_t vertex = indexList[face * 3 + v];
+                newIndexList[newIndexCount++] = (DstIndexType)vertex;
+                deadEndStack[deadEndStackSize++] = vertex;
+                candidates[candidateCount++] = vertex;
+                --activeCounts[vertex];
+
+                if (time - cacheTimeStamps[vertex] > cacheSize)
+                    cacheTimeStamps[vertex] = time++;
             }
         }
 
-        // find the best scoring triangle in the current cache (including up to 3 that were just evicted)
-        bestScore = -1.0f;
-        for (uint32_t c1 = 0; c1 < entriesInCache1; ++c1)
+        // pick the candidate that entered the cache first among those whose remaining faces still hit the cache
+        fanningVertex = kNoVertex;
+        uint32_t bestPriority = 0;
+        for (size_t c = 0; c < candidateCount; ++c)
         {
-            OptimizeVertexData& vertexData = vertexDataList[cache1[c1]];
-            vertexData.cachePos0 = vertexData.cachePos1;
-            vertexData.cachePos1 = kEvictedCacheIndex;
-            for (uint32_t j = 0; j < vertexData.activeFaceListSize; ++j)
+            const uint32_t vertex = candidates[c];
+            if (activeCounts[vertex] == 0)
+                continue;
+
+            const uint32_t age = time - cacheTimeStamps[vertex];
+            const uint32_t priority = age + 2 * activeCounts[vertex] <= cacheSize ? age : 0;
+            if (fanningVertex == kNoVertex || priority > bestPriority)
             {
-                uint32_t face = activeFaceList[vertexData.activeFaceListStart+j];
-                float faceScore = 0.0f;
-                for (uint32_t v = 0; v < 3; ++v)
-                {
-                    faceScore += vertexDataList[vertexRemap[face + v]].score;
-                }
-                if (faceScore > bestScore)
-                {
-                    bestScore = faceScore;
-                    bestFace = face;
-                }
+                bestPriority = priority;
+                fanningVertex = vertex;
             }
         }
 
-        std::swap(cache0, cache1);
-        entriesInCache0 = std::min(entriesInCache1, lruCacheSize);
+        if (fanningVertex != kNoVertex)
+            continue;
+
+        // dead end: the most recently emitted vertex with faces left, or failing that the next one in input order
+        while (deadEndStackSize > 0 && fanningVertex == kNoVertex)
+        {
+            const uint32_t vertex = deadEndStack[--deadEndStackSize];
+            if (activeCounts[vertex] > 0)
+                fanningVertex = vertex;
+        }
+
+        for (; fanningVertex == kNoVertex && nextInputVertex < vertexCount; ++nextInputVertex)
+        {
+            if (activeCounts[nextInputVertex] > 0)
+                fanningVertex = nextInputVertex;
+        }
+    }
+
+    assert(newIndexCount == faceCount * 3);
+}
+
+template <typename SrcIndexType, typename DstIndexType>
+void OptimizeFaces(const SrcIndexType* indexList, size_t indexCount, DstIndexType* newIndexList, size_t lruCacheSize)
+{
+#if INDEX_OPTIMIZE_TIPSIFY
+    OptimizeFacesTipsify(indexList, indexCount, newIndexList, lruCacheSize);
+#else
+    OptimizeFacesForsyth(indexList, indexCount, newIndexList, lruCacheSize);
+#endif
+}
+
+template <typename IndexType>
+VertexCacheStatistics AnalyzeVertexCache(const IndexType* indexList, size_t indexCount, size_t cacheSize)
+{
+    VertexCacheStatistics stats = {};
+    if (indexCount < 3)
+        return stats;
+
+    const size_t vertexCount = CountVertices(indexList, indexCount);
+
+    // A vertex is in the cache while fewer than cacheSize misses have happened since its own.
+    std::unique_ptr<uint32_t[]> cacheTimeStamps(new uint32_t[vertexCount]());
+    uint32_t time = (uint32_t)cacheSize + 1;
+
+    for (size_t i = 0; i < indexCount; ++i)
+    {
+        const uint32_t vertex = indexList[i];
+        if (cacheTimeStamps[vertex] == 0)
+            ++stats.uniqueVertices;
+
+        if (time - cacheTimeStamps[vertex] > cacheSize)
+        {
+            cacheTimeStamps[vertex] = time++;
+            ++stats.vertexTransforms;
+        }
     }
+
+    stats.acmr = (float)stats.vertexTransforms / (float)(indexCount / 3);
+    stats.atvr = (float)stats.vertexTransforms / (float)stats.uniqueVertices;
+    return stats;
 }
+
+template void OptimizeFaces<uint16_t, uint16_t>(const uint16_t* indexList, size_t indexCount, uint16_t* newIndexList, size_t lruCacheSize);
+template void OptimizeFaces<uint32_t, uint16_t>(const uint32_t* indexList, size_t indexCount, uint16_t* newIndexList, size_t lruCacheSize);
+template void OptimizeFaces<uint32_t, uint32_t>(const uint32_t* indexList, size_t indexCount, uint32_t* newIndexList, size_t lruCacheSize);
+template void OptimizeFacesForsyth<uint16_t, uint16_t>(const uint16_t* indexList, size_t indexCount, uint16_t* newIndexList, size_t lruCacheSize);
+template void OptimizeFacesForsyth<uint32_t, uint16_t>(const uint32_t* indexList, size_t indexCount, uint16_t* newIndexList, size_t lruCacheSize);
+template void OptimizeFacesForsyth<uint32_t, uint32_t>(const uint32_t* indexList, size_t indexCount, uint32_t* newIndexList, size_t lruCacheSize);
+template void OptimizeFacesTipsify<uint16_t, uint16_t>(const uint16_t* indexList, size_t indexCount, uint16_t* newIndexList, size_t cacheSize);
+template void OptimizeFacesTipsify<uint32_t, uint16_t>(const uint32_t* indexList, size_t indexCount, uint16_t* newIndexList, size_t cacheSize);
+template void OptimizeFacesTipsify<uint32_t, uint32_t>(const uint32_t* indexList, size_t indexCount, uint32_t* newIndexList, size_t cacheSize);
+template VertexCacheStatistics AnalyzeVertexCache<uint16_t>(const uint16_t* indexList, size_t indexCount, size_t cacheSize);
+template VertexCacheStatistics AnalyzeVertexCache<uint32_t>(const uint32_t* indexList, size_t indexCount, size_t cacheSize);
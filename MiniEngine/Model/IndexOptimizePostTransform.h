@@ -14,6 +14,19 @@
 
 #pragma once
 
+// Post-transform vertex cache optimization of triangle lists.  This header does not depend on pch.h so that
+// the optimizers can be benchmarked by portable (non-D3D12) tools.
+
+#include <cstddef>
+#include <cstdint>
+
+// Selects the algorithm behind OptimizeFaces() at build time.  Forsyth's optimizer models an LRU cache and has been
+// the default for the .mini files built so far.  Tipsify models the FIFO cache that GPUs implement and runs several
+// times faster; use VSGLHeadless bench-vcache to compare the two on a given scene.
+#ifndef INDEX_OPTIMIZE_TIPSIFY
+#define INDEX_OPTIMIZE_TIPSIFY 0
+#endif
+
 //-----------------------------------------------------------------------------
 //  OptimizeFaces
 //-----------------------------------------------------------------------------
@@ -31,6 +44,24 @@
 template <typename SrcIndexType, typename DstIndexType>
 void OptimizeFaces(const SrcIndexType* indexList, size_t indexCount, DstIndexType* newIndexList, size_t lruCacheSize);
 
-template void OptimizeFaces<uint16_t, uint16_t>(const uint16_t* indexList, size_t indexCount, uint16_t* newIndexList, size_t lruCacheSize);
-template void OptimizeFaces<uint32_t, uint16_t>(const uint32_t* indexList, size_t indexCount, uint16_t* newIndexList, size_t lruCacheSize);
-template void OptimizeFaces<uint32_t, uint32_t>(const uint32_t* indexList, size_t indexCount, uint32_t* newIndexList, size_t lruCacheSize);
+// Tom Forsyth's "Linear-Speed Vertex Cache Optimisation", which greedily emits the best scoring triangle
+// among those that use a vertex in a simulated LRU cache.
+template <typename SrcIndexType, typename DstIndexType>
+void OptimizeFacesForsyth(const SrcIndexType* indexList, size_t indexCount, DstIndexType* newIndexList, size_t lruCacheSize);
+
+// Sander, Nehab and Barczak's "Fast Triangle Reordering for Vertex Locality and Reduced Overdraw" (Tipsify),
+// which emits triangle fans around vertices chosen from a simulated FIFO cache.
+template <typename SrcIndexType, typename DstIndexType>
+void OptimizeFacesTipsify(const SrcIndexType* indexList, size_t indexCount, DstIndexType* newIndexList, size_t cacheSize);
+
+struct VertexCacheStatistics
+{
+    size_t vertexTransforms;    // cache misses
+    size_t uniqueVertices;      // vertices referenced at least once
+    float acmr;                 // average cache miss ratio: transforms per triangle (0.5 is ideal for a regular grid)
+    float atvr;                 // average transform to vertex ratio: transforms per unique vertex (1.0 is ideal)
+};
+
+// Simulates a FIFO post-transform cache of the given size over a triangle list.
+template <typename IndexType>
+VertexCacheStatistics AnalyzeVertexCache(const IndexType* indexList, size_t indexCount, size_t cacheSize);
@@ -0,0 +1,643 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+
+#include "JsonTape.h"
+
+#include <cassert>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(_M_X64) || defined(__SSE2__)
+#include <emmintrin.h>
+#define JSON_TAPE_SSE2 1
+#endif
+
+namespace Json
+{
+    namespace
+    {
+        // Nested deeper than any sane manifest; bounds the recursion of the parser.
+        const uint32_t kMaxDepth = 512;
+
+        // Powers of ten that are exact in a double, for the fast path of number parsing.
+        const double kPowersOfTen[] =
+        {
+            1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+            1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+        };
+
+        inline bool IsDigit(char c) { return c >= '0' && c <= '9'; }
+
+        inline bool IsWhitespace(char c) { return c == ' ' || c == '\n' || c == '\r' || c == '\t'; }
+
+        int HexDigit(char c)
+        {
+            if (c >= '0' && c <= '9')
+                return c - '0';
+            if (c >= 'a' && c <= 'f')
+                return c - 'a' + 10;
+            if (c >= 'A' && c <= 'F')
+                return c - 'A' + 10;
+            return -1;
+        }
+
+        void AppendUTF8(std::vector<char>& out, uint32_t codePoint)
+        {
+            if (codePoint < 0x80)
+            {
+                out.push_back((char)codePoint);
+            }
+            else if (codePoint < 0x800)
+            {
+                out.push_back((char)(0xC0 | (codePoint >> 6)));
+                out.push_back((char)(0x80 | (codePoint & 0x3F)));
+            }
+            else if (codePoint < 0x10000)
+            {
+                out.push_back((char)(0xE0 | (codePoint >> 12)));
+                out.push_back((char)(0x80 | ((codePoint >> 6) & 0x3F)));
+                out.push_back((char)(0x80 | (codePoint & 0x3F)));
+            }
+            else
+            {
+                out.push_back((char)(0xF0 | (codePoint >> 18)));
+                out.push_back((char)(0x80 | ((codePoint >> 12) & 0x3F)));
+                out.push_back((char)(0x80 | ((codePoint >> 6) & 0x3F)));
+                out.push_back((char)(0x80 | (codePoint & 0x3F)));
+            }
+        }
+
+        // Converts a number that the parser has already validated.
+        double ConvertNumber(const char* text, size_t length)
+        {
+            const char* p = text;
+            const char* end = text + length;
+            const bool negative = *p == '-';
+            if (negative)
+                ++p;
+
+            // Up to 19 significant digits fit in the mantissa.  Any more force the slow path.
+            uint64_t mantissa = 0;
+            uint32_t digits = 0;
+            int32_t exponent = 0;
+            bool truncated = false;
+
+            for (; p < end && IsDigit(*p); ++p)
+            {
+                if (mantissa == 0 && *p == '0')
+                    continue;
+                if (digits < 19)
+                {
+                    mantissa = mantissa * 10 + (uint64_t)(*p - '0');
+                    ++digits;
+                }
+                else
+                {
+                    truncated = true;
+                    ++exponent;
+                }
+            }
+
+            if (p < end && *p == '.')
+            {
+                for (++p; p < end && IsDigit(*p); ++p)
+                {
+                    if (mantissa == 0 && *p == '0')
+                    {
+                        --exponent;
+                    }
+                    else if (digits < 19)
+                    {
+                        mantissa = mantissa * 10 + (uint64_t)(*p - '0');
+                        ++digits;
+                        --exponent;
+                    }
+                    else
+                    {
+                        truncated = true;
+                    }
+                }
+            }
+
+            if (p < end)
+            {
+                ++p; // 'e' or 'E'
+                bool negativeExponent = false;
+                if (*p == '+' || *p == '-')
+                    negativeExponent = *p++ == '-';
+
+                int32_t explicitExponent = 0;
+                for (; p < end; ++p)
+                {
+                    if (explicitExponent < 100000)
+                        explicitExponent = explicitExponent * 10 + (*p - '0');
+                }
+                exponent += negativeExponent ? -explicitExponent : explicitExponent;
+            }
+
+            if (!truncated && mantissa <= (1ull << 53) && exponent >= -22 && exponent <= 22)
+            {
+                // Both operands are exact, so one correctly rounded operation gives the correctly rounded result.
+                double value = (double)mantissa;
+                value = exponent < 0 ? value / kPowersOfTen[-exponent] : value * kPowersOfTen[exponent];
+                return negative ? -value : value;
+            }
+
+            const std::string copy(text, length);
+            return std::strtod(copy.c_str(), nullptr);
+        }
+    }
+
+    struct Parser
+    {
+        Document& doc;
+        const char* begin;
+        const char* end;
+        const char* p;
+
+        bool Fail()
+        {
+            doc.m_ErrorOffset = (size_t)(p - begin);
+            return false;
+        }
+
+        void Push(Document::Type type, uint64_t payload)
+        {
+            doc.m_Tape.push_back(Document::MakeWord(type, payload));
+        }
+
+        // Pretty-printed manifests are mostly indentation, so whitespace is skipped 16 bytes at a time.
+        void SkipWhitespace()
+        {
+            // Minified text and the single spaces after ':' and ',' take the early outs.
+            if (p == end || !IsWhitespace(*p))
+                return;
+            if (++p == end || !IsWhitespace(*p))
+                return;
+#ifdef JSON_TAPE_SSE2
+            while (end - p >= 16)
+            {
+                const __m128i chars = _mm_loadu_si128((const __m128i*)p);
+                const __m128i ws = _mm_or_si128(
+                    _mm_or_si128(_mm_cmpeq_epi8(chars, _mm_set1_epi8(' ')), _mm_cmpeq_epi8(chars, _mm_set1_epi8('\n'))),
+                    _mm_or_si128(_mm_cmpeq_epi8(chars, _mm_set1_epi8('\r')), _mm_cmpeq_epi8(chars, _mm_set1_epi8('\t'))));
+                const uint32_t nonWhitespace = ~(uint32_t)_mm_movemask_epi8(ws) & 0xFFFF;
+                if (nonWhitespace != 0)
+                {
+                    uint32_t first = 0;
+                    while ((nonWhitespace & (1u << first)) == 0)
+                        ++first;
+                    p += first;
+                    return;
+                }
+                p += 16;
+            }
+#endif
+            while (p < end && IsWhitespace(*p))
+                ++p;
+        }
+
+        // Returns the first '"' or '\\' at or after p, or end.
+        const char* FindQuoteOrEscape(const char* s) const
+        {
+#ifdef JSON_TAPE_SSE2
+            while (end - s >= 16)
+            {
+                const __m128i chars = _mm_loadu_si128((const __m128i*)s);
+                const uint32_t mask = (uint32_t)_mm_movemask_epi8(_mm_or_si128(
+                    _mm_cmpeq_epi8(chars, _mm_set1_epi8('"')), _mm_cmpeq_epi8(chars, _mm_set1_epi8('\\'))));
+                if (mask != 0)
+                {
+                    uint32_t first = 0;
+                    while ((mask & (1u << first)) == 0)
+                        ++first;
+                    return s + first;
+                }
+                s += 16;
+            }
+#endif
+            while (s < end && *s != '"' && *s != '\\')
+                ++s;
+            return s;
+        }
+
+        bool ParseString()
+        {
+            ++p; // opening quote
+            const char* start = p;
+            p = FindQuoteOrEscape(p);
+            if (p == end)
+                return Fail();
+
+            // The common case: no escape, so the string is referenced in place.
+            if (*p == '"')
+            {
+                PushString((uint64_t)(start - doc.m_Source), (uint64_t)(p - start), 0);
+                ++p;
+                return true;
+            }
+
+            std::vector<char>& out = doc.m_Strings;
+            const size_t offset = out.size();
+            out.insert(out.end(), start, p);
+
+            for (;;)
+            {
+                if (p == end)
+                    return Fail();
+
+                if (*p == '"')
+                    break;
+
+                if (*p != '\\')
+                {
+                    const char* next = FindQuoteOrEscape(p);
+                    out.insert(out.end(), p, next);
+                    p = next;
+                    continue;
+                }
+
+                if (++p == end)
+                    return Fail();
+
+                switch (*p++)
+                {
+                case '"': out.push_back('"'); break;
+                case '\\': out.push_back('\\'); break;
+                case '/': out.push_back('/'); break;
+                case 'b': out.push_back('\b'); break;
+                case 'f': out.push_back('\f'); break;
+                case 'n': out.push_back('\n'); break;
+                case 'r': out.push_back('\r'); break;
+                case 't': out.push_back('\t'); break;
+                case 'u':
+                {
+                    uint32_t codePoint;
+                    if (!ParseHex4(codePoint))
+                        return false;
+
+                    // A high surrogate must be followed by an escaped low surrogate.
+                    if (codePoint >= 0xD800 && codePoint < 0xDC00)
+                    {
+                        uint32_t low;
+                        if (end - p < 2 || p[0] != '\\' || p[1] != 'u')
+                            return Fail();
+                        p += 2;
+                        if (!ParseHex4(low) || low < 0xDC00 || low >= 0xE000)
+                            return Fail();
+                        codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (low - 0xDC00);
+                    }
+                    AppendUTF8(out, codePoint);
+                    break;
+                }
+                default:
+                    --p;
+                    return Fail();
+                }
+            }
+
+            PushString(offset, out.size() - offset, Document::kUnescapedString);
+            ++p;
+            return true;
+        }
+
+        void PushString(uint64_t offset, uint64_t length, uint64_t flags)
+        {
+            if (length < (1u << Document::kLengthBits))
+            {
+                Push(Document::kString, flags | Document::MakeSpan(offset, length));
+            }
+            else
+            {
+                Push(Document::kString, flags | Document::kLongString | offset);
+                doc.m_Tape.push_back(length);
+            }
+        }
+
+        bool ParseHex4(uint32_t& value)
+        {
+            if (end - p < 4)
+                return Fail();
+
+            value = 0;
+            for (int i = 0; i < 4; ++i, ++p)
+            {
+                const int digit = HexDigit(*p);
+                if (digit < 0)
+                    return Fail();
+                value = value << 4 | (uint32_t)digit;
+            }
+            return true;
+        }
+
+        // Numbers are only validated here.  Value::GetDouble() converts them.
+        bool ParseNumber()
+        {
+            const char* start = p;
+            if (*p == '-')
+                ++p;
+
+            if (p == end || !IsDigit(*p))
+                return Fail();
+
+            if (*p == '0')
+                ++p;
+            else
+                while (p < end && IsDigit(*p))
+                    ++p;
+
+            if (p < end && *p == '.')
+            {
+                if (++p == end || !IsDigit(*p))
+                    return Fail();
+                while (p < end && IsDigit(*p))
+                    ++p;
+            }
+
+            if (p < end && (*p == 'e' || *p == 'E'))
+            {
+                ++p;
+                if (p < end && (*p == '+' || *p == '-'))
+                    ++p;
+                if (p == end || !IsDigit(*p))
+                    return Fail();
+                while (p < end && IsDigit(*p))
+                    ++p;
+            }
+
+            if (p - start >= (1 << Document::kLengthBits))
+                return Fail();
+
+            Push(Document::kNumber, Document::MakeSpan((uint64_t)(start - doc.m_Source), (uint64_t)(p - start)));
+            return true;
+        }
+
+        bool ParseLiteral(const char* text, size_t length, Document::Type type)
+        {
+            if ((size_t)(end - p) < length || std::memcmp(p, text, length) != 0)
+                return Fail();
+            p += length;
+            Push(type, 0);
+            return true;
+        }
+
+        // The opening word is patched with the tape index of the closing word, and the closing word holds the count.
+        bool ParseContainer(Document::Type beginType, Document::Type endType, char closing, bool isObject, uint32_t depth)
+        {
+            if (depth >= kMaxDepth)
+                return Fail();
+
+            const size_t beginIndex = doc.m_Tape.size();
+            Push(beginType, 0);
+            ++p;
+
+            uint32_t count = 0;
+            SkipWhitespace();
+            if (p < end && *p == closing)
+            {
+                ++p;
+            }
+            else
+            {
+                for (;;)
+                {
+                    if (isObject)
+                    {
+                        if (p == end || *p != '"' || !ParseString())
+                            return Fail();
+                        SkipWhitespace();
+                        if (p == end || *p != ':')
+                            return Fail();
+                        ++p;
+                        SkipWhitespace();
+                    }
+
+                    if (!ParseValue(depth + 1))
+                        return false;
+                    ++count;
+
+                    SkipWhitespace();
+                    if (p == end)
+                        return Fail();
+                    if (*p == ',')
+                    {
+                        ++p;
+                        SkipWhitespace();
+                        continue;
+                    }
+                    if (*p != closing)
+                        return Fail();
+                    ++p;
+                    break;
+                }
+            }
+
+            doc.m_Tape[beginIndex] = Document::MakeWord(beginType, doc.m_Tape.size());
+            Push(endType, count);
+            return true;
+        }
+
+        bool ParseValue(uint32_t depth)
+        {
+            if (p == end)
+                return Fail();
+
+            switch (*p)
+            {
+            case '{': return ParseContainer(Document::kObjectBegin, Document::kObjectEnd, '}', true, depth);
+            case '[': return ParseContainer(Document::kArrayBegin, Document::kArrayEnd, ']', false, depth);
+            case '"': return ParseString();
+            case 't': return ParseLiteral("true", 4, Document::kTrue);
+            case 'f': return ParseLiteral("false", 5, Document::kFalse);
+            case 'n': return ParseLiteral("null", 4, Document::kNull);
+            default: return ParseNumber();
+            }
+        }
+    };
+
+    void Document::Clear()
+    {
+        m_Source = nullptr;
+        m_Tape.clear();
+        m_Strings.clear();
+        m_ErrorOffset = 0;
+    }
+
+    bool Document::Parse(const char* begin, const char* end)
+    {
+        Clear();
+        m_Source = begin;
+
+        // Offsets into the text are 32-bit.  A GLB JSON chunk cannot be larger anyway.
+        Parser parser = { *this, begin, end, begin };
+        if ((uint64_t)(end - begin) > UINT32_MAX)
+            return parser.Fail();
+
+        // Minified glTF takes about one tape word per six bytes, which bounds the tape of pretty-printed files too.
+        // Whatever is left over is given back below.
+        m_Tape.reserve((size_t)(end - begin) / 6 + 16);
+        parser.SkipWhitespace();
+        bool success = parser.ParseValue(0);
+        if (success)
+        {
+            parser.SkipWhitespace();
+            success = parser.p == end || parser.Fail();
+        }
+
+        if (!success)
+        {
+            const size_t errorOffset = m_ErrorOffset;
+            Clear();
+            m_ErrorOffset = errorOffset;
+        }
+        else if (m_Tape.capacity() - m_Tape.size() > m_Tape.size() / 4)
+        {
+            m_Tape.shrink_to_fit();
+        }
+        return success;
+    }
+
+    bool Value::IsNull() const { return IsValid() && Document::GetType(m_Document->m_Tape[m_Index]) == Document::kNull; }
+    bool Value::IsNumber() const { return IsValid() && Document::GetType(m_Document->m_Tape[m_Index]) == Document::kNumber; }
+    bool Value::IsString() const { return IsValid() && Document::GetType(m_Document->m_Tape[m_Index]) == Document::kString; }
+    bool Value::IsArray() const { return IsValid() && Document::GetType(m_Document->m_Tape[m_Index]) == Document::kArrayBegin; }
+    bool Value::IsObject() const { return IsValid() && Document::GetType(m_Document->m_Tape[m_Index]) == Document::kObjectBegin; }
+
+    bool Value::IsBool() const
+    {
+        if (!IsValid())
+            return false;
+        const Document::Type type = Document::GetType(m_Document->m_Tape[m_Index]);
+        return type == Document::kTrue || type == Document::kFalse;
+    }
+
+    uint32_t Value::Next() const
+    {
+        const uint64_t word = m_Document->m_Tape[m_Index];
+        switch (Document::GetType(word))
+        {
+        case Document::kArrayBegin:
+        case Document::kObjectBegin:
+            return (uint32_t)Document::GetPayload(word) + 1;
+        case Document::kString:
+            return (word & Document::kLongString) ? m_Index + 2 : m_Index + 1;
+        default:
+            return m_Index + 1;
+        }
+    }
+
+    uint32_t Value::Size() const
+    {
+        if (!IsArray() && !IsObject())
+            return 0;
+        const uint32_t end = (uint32_t)Document::GetPayload(m_Document->m_Tape[m_Index]);
+        return (uint32_t)Document::GetPayload(m_Document->m_Tape[end]);
+    }
+
+    Value Value::operator[](size_t index) const
+    {
+        if (!IsArray())
+            return Value();
+
+        const uint32_t end = (uint32_t)Document::GetPayload(m_Document->m_Tape[m_Index]);
+        for (uint32_t i = m_Index + 1; i < end; i = Value(m_Document, i).Next(), --index)
+        {
+            if (index == 0)
+                return Value(m_Document, i);
+        }
+        return Value();
+    }
+
+    Value Value::Find(const char* key) const
+    {
+        if (!IsObject())
+            return Value();
+
+        const size_t keyLength = std::strlen(key);
+        const uint32_t end = (uint32_t)Document::GetPayload(m_Document->m_Tape[m_Index]);
+        for (uint32_t i = m_Index + 1; i < end; )
+        {
+            const Value member(m_Document, i);
+            size_t length;
+            const char* data = member.GetStringData(length);
+            const Value value(m_Document, member.Next());
+            if (length == keyLength && std::memcmp(data, key, length) == 0)
+                return value;
+            i = value.Next();
+        }
+        return Value();
+    }
+
+    void Value::GetElements(std::vector<Value>& elements) const
+    {
+        elements.reserve(elements.size() + Size());
+        ForEach([&](Value element) { elements.push_back(element); });
+    }
+
+    bool Value::GetBool() const
+    {
+        assert(IsBool());
+        return IsValid() && Document::GetType(m_Document->m_Tape[m_Index]) == Document::kTrue;
+    }
+
+    double Value::GetDouble() const
+    {
+        assert(IsNumber());
+        if (!IsNumber())
+            return 0.0;
+
+        const uint64_t word = m_Document->m_Tape[m_Index];
+        return ConvertNumber(m_Document->m_Source + Document::GetSpanOffset(word), Document::GetSpanLength(word));
+    }
+
+    const char* Value::GetStringData(size_t& length) const
+    {
+        assert(IsString());
+        if (!IsString())
+        {
+            length = 0;
+            return "";
+        }
+
+        const uint64_t word = m_Document->m_Tape[m_Index];
+        length = (word & Document::kLongString) ? (size_t)m_Document->m_Tape[m_Index + 1] : Document::GetSpanLength(word);
+        const char* base = (word & Document::kUnescapedString) ? m_Document->m_Strings.data() : m_Document->m_Source;
+        return base + Document::GetSpanOffset(word);
+    }
+
+    std::string Value::GetString() const
+    {
+        size_t length;
+        const char* data = GetStringData(length);
+        return std::string(data, length);
+    }
+
+    bool Value::StringEquals(const char* str) const
+    {
+        if (!IsString())
+            return false;
+
+        size_t length;
+        const char* data = GetStringData(length);
+        return std::strlen(str) == length && std::memcmp(data, str, length) == 0;
+    }
+
+    float Value::GetFloat(const char* key, float defaultValue) const
+    {
+        const Value value = Find(key);
+        return value.IsValid() ? value.GetFloat() : defaultValue;
+    }
+
+    uint32_t Value::GetUint32(const char* key, uint32_t defaultValue) const
+    {
+        const Value value = Find(key);
+        return value.IsValid() ? value.GetUint32() : defaultValue;
+    }
+
+} // namespace Json
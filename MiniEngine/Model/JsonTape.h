@@ -0,0 +1,169 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+
+#pragma once
+
+// A read-only JSON document stored as a flat tape, for loaders that walk large manifests such as glTF.
+//
+// Parsing makes one pass over the text and appends one 64-bit word per value, key and closing bracket.  Nothing is
+// allocated per value: strings without escapes and numbers point back into the source text, and an opening bracket
+// records where its container ends, so skipping a whole subtree is a single jump.  Numbers are validated by the parse
+// but only converted when they are read, and object members are found by scanning the keys on demand.  The source
+// text must outlive the document.
+//
+// This header does not depend on pch.h so that it can be shared with portable (non-D3D12) tools.
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Json
+{
+    class Document;
+
+    // A view of one value on the tape.  It is two words wide and cheap to copy.  Looking up a missing member or
+    // element returns an invalid value; reading an invalid or mistyped value asserts and returns zero or empty.
+    class Value
+    {
+    public:
+        Value() : m_Document(nullptr), m_Index(0) {}
+
+        bool IsValid() const { return m_Document != nullptr; }
+        bool IsNull() const;
+        bool IsBool() const;
+        bool IsNumber() const;
+        bool IsString() const;
+        bool IsArray() const;
+        bool IsObject() const;
+
+        // Number of elements of an array or members of an object.
+        uint32_t Size() const;
+
+        // Array element in O(index).  Use ForEach() or GetElements() to visit all elements.
+        Value operator[](size_t index) const;
+
+        // Object member in O(member count).
+        Value Find(const char* key) const;
+        bool Contains(const char* key) const { return Find(key).IsValid(); }
+
+        bool GetBool() const;
+        double GetDouble() const;
+        float GetFloat() const { return (float)GetDouble(); }
+        uint32_t GetUint32() const { return (uint32_t)GetDouble(); }
+        int32_t GetInt32() const { return (int32_t)GetDouble(); }
+        std::string GetString() const;
+        bool StringEquals(const char* str) const;
+
+        // The string bytes, not null-terminated.
+        const char* GetStringData(size_t& length) const;
+
+        // Member lookups with a default for absent keys.
+        float GetFloat(const char* key, float defaultValue) const;
+        uint32_t GetUint32(const char* key, uint32_t defaultValue) const;
+
+        // Calls f(Value) for every array element, or f(const char* key, size_t keyLength, Value) for every object member.
+        template <typename F> void ForEach(F f) const;
+        template <typename F> void ForEachMember(F f) const;
+
+        // Appends the array elements so that they can be processed in parallel.
+        void GetElements(std::vector<Value>& elements) const;
+
+    private:
+        friend class Document;
+
+        Value(const Document* document, uint32_t index) : m_Document(document), m_Index(index) {}
+
+        uint32_t Next() const; // tape index of the following sibling
+
+        const Document* m_Document;
+        uint32_t m_Index;
+    };
+
+    class Document
+    {
+    public:
+        // Parses [begin, end).  On failure the document is empty and GetErrorOffset() gives the byte where parsing stopped.
+        bool Parse(const char* begin, const char* end);
+        void Clear();
+
+        Value GetRoot() const { return m_Tape.empty() ? Value() : Value(this, 0); }
+        size_t GetErrorOffset() const { return m_ErrorOffset; }
+
+        // Heap bytes held by the document, not counting the source text.
+        size_t GetMemoryUsage() const { return m_Tape.capacity() * sizeof(uint64_t) + m_Strings.capacity(); }
+
+        // A tape word holds the type in the top byte and a payload in the rest.  Containers store the tape index of their
+        // closing word, and closing words the element count.  Strings and numbers store their offset and length.
+        enum Type : uint8_t
+        {
+            kNull = 'n',
+            kTrue = 't',
+            kFalse = 'f',
+            kNumber = 'd',
+            kString = '"',
+            kArrayBegin = '[',
+            kArrayEnd = ']',
+            kObjectBegin = '{',
+            kObjectEnd = '}',
+        };
+
+        // String payloads with this bit set index m_Strings (unescaped copies); otherwise they are offsets into the source.
+        // Strings too long for the length field keep their length in a second word.
+        static const uint64_t kUnescapedString = 1ull << 55;
+        static const uint64_t kLongString = 1ull << 54;
+        static const uint32_t kLengthBits = 22;
+
+    private:
+        friend class Value;
+        friend struct Parser;
+
+        static Type GetType(uint64_t word) { return (Type)(word >> 56); }
+        static uint64_t GetPayload(uint64_t word) { return word & ((1ull << 56) - 1); }
+        static uint64_t MakeWord(Type type, uint64_t payload) { return (uint64_t)type << 56 | payload; }
+        static uint64_t MakeSpan(uint64_t offset, uint64_t length) { return length << 32 | offset; }
+        static uint32_t GetSpanOffset(uint64_t word) { return (uint32_t)word; }
+        static uint32_t GetSpanLength(uint64_t word) { return (uint32_t)(word >> 32) & ((1u << kLengthBits) - 1); }
+
+        const char* m_Source = nullptr;
+        std::vector<uint64_t> m_Tape;
+        std::vector<char> m_Strings;
+        size_t m_ErrorOffset = 0;
+    };
+
+    template <typename F>
+    void Value::ForEach(F f) const
+    {
+        if (!IsArray())
+            return;
+
+        const uint32_t end = (uint32_t)Document::GetPayload(m_Document->m_Tape[m_Index]);
+        for (uint32_t i = m_Index + 1; i < end; i = Value(m_Document, i).Next())
+            f(Value(m_Document, i));
+    }
+
+    template <typename F>
+    void Value::ForEachMember(F f) const
+    {
+        if (!IsObject())
+            return;
+
+        const uint32_t end = (uint32_t)Document::GetPayload(m_Document->m_Tape[m_Index]);
+        for (uint32_t i = m_Index + 1; i < end; )
+        {
+            const Value key(m_Document, i);
+            size_t keyLength;
+            const char* keyData = key.GetStringData(keyLength);
+            const Value value(m_Document, key.Next());
+            f(keyData, keyLength, value);
+            i = value.Next();
+        }
+    }
+
+} // namespace Json
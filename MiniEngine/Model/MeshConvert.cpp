@@ -19,6 +19,8 @@
 #include "glTF.h"
 #include "Model.h"
 #include "IndexOptimizePostTransform.h"
+#include "Meshlet.h"
+#include "ModelCache.h"
 #include "../Core/VectorMath.h"
 #include "DirectXMesh.h"
 
@@ -70,7 +72,7 @@ static DXGI_FORMAT AccessorFormat(const Accessor& accessor)
     }
 }
 
-void OptimizeMesh( Renderer::Primitive& outPrim, const glTF::Primitive& inPrim, const Math::Matrix4& localToObject )
+static void ConvertPrimitive( Renderer::Primitive& outPrim, const glTF::Primitive& inPrim, const Math::Matrix4& localToObject )
 {
     ASSERT(inPrim.attributes[0] != nullptr, "Must have POSITION");
     uint32_t vertexCount = inPrim.attributes[0]->count;
@@ -84,8 +86,9 @@ void OptimizeMesh( Renderer::Primitive& outPrim, const glTF::Primitive& inPrim,
     {
         ASSERT(inPrim.mode == 4, "Impossible primitive topology when lacking indices");
 
-        indexCount = vertexCount * 3;
-        maxIndex = indexCount - 1;
+        // Every vertex is used once, in order
+        indexCount = vertexCount;
+        maxIndex = vertexCount - 1;
         if (indexCount > 0xFFFF)
         {
             b32BitIndices = true;
@@ -256,6 +259,24 @@ void OptimizeMesh( Renderer::Primitive& outPrim, const glTF::Primitive& inPrim,
         ASSERT(outPrim.m_BoundsOS.GetRadius() > 0.0f);
     }
 
+    // Cluster the optimized triangles for culling, which reorders them into meshlets.  Two-sided materials show their backfaces.
+    // It also checks the indices, which come from the file, against the vertices before anything else reads through them.
+    const bool validIndices = b32BitIndices ?
+        BuildMeshlets((uint32_t*)indices, indexCount, &position[0].x, sizeof(XMFLOAT3), vertexCount, outPrim.meshlets) :
+        BuildMeshlets((uint16_t*)indices, indexCount, &position[0].x, sizeof(XMFLOAT3), vertexCount, outPrim.meshlets);
+    if (!validIndices)
+    {
+        Utility::Printf("Found a primitive with an index past its vertices or an incomplete triangle\n");
+        outPrim.IB.reset();
+        return;
+    }
+
+    if (material.twoSided)
+    {
+        for (Meshlet& meshlet : outPrim.meshlets)
+            meshlet.coneCutoff = 1.0f;
+    }
+
     if (HasNormals)
     {
         ASSERT_SUCCEEDED(vbr.Read(normal.get(), "NORMAL", 0, vertexCount));
@@ -439,3 +460,165 @@ void OptimizeMesh( Renderer::Primitive& outPrim, const glTF::Primitive& inPrim,
     // TODO:  Generate optimized depth-only streams
 }
 
+// Bump this whenever ConvertPrimitive() or its dependencies produce different output for the same input, so that the
+// cached primitives of the old converter are no longer looked up.
+static const uint64_t kPrimitiveConverterVersion = 3;
+
+static uint32_t AccessorElementSize(const Accessor& accessor)
+{
+    static const uint32_t kComponentSizes[] = { 1, 1, 2, 2, 4, 4, 4 };
+    static const uint32_t kComponentCounts[] = { 1, 2, 3, 4, 4, 9, 16 };
+    return kComponentSizes[accessor.componentType] * kComponentCounts[accessor.type];
+}
+
+static void HashAccessor(ContentHash& hash, const Accessor* accessor)
+{
+    if (accessor == nullptr)
+    {
+        hash.UpdateValue(uint32_t(0));
+        return;
+    }
+
+    const uint32_t elementSize = AccessorElementSize(*accessor);
+    hash.UpdateValue(accessor->count);
+    hash.UpdateValue(accessor->componentType);
+    hash.UpdateValue(accessor->type);
+
+    // Interleaved attributes are hashed element by element so that the other attributes of the vertices do not
+    // count (the stride itself does not change the output)
+    if (accessor->stride == elementSize || accessor->count <= 1)
+    {
+        hash.Update(accessor->dataPtr, size_t(elementSize) * accessor->count);
+    }
+    else
+    {
+        for (uint32_t i = 0; i < accessor->count; ++i)
+            hash.Update(accessor->dataPtr + size_t(i) * accessor->stride, elementSize);
+    }
+}
+
+// Everything ConvertPrimitive() reads except the material index, which only tags the result
+static uint64_t PrimitiveKey( const glTF::Primitive& inPrim, const Math::Matrix4& localToObject )
+{
+    ContentHash hash(kPrimitiveConverterVersion);
+    hash.UpdateValue(localToObject);
+    hash.UpdateValue(inPrim.mode);
+    hash.UpdateValue(inPrim.material->flags);
+    hash.Update(inPrim.minPos, sizeof(inPrim.minPos));
+    hash.Update(inPrim.maxPos, sizeof(inPrim.maxPos));
+    hash.UpdateValue(inPrim.maxIndex);
+    HashAccessor(hash, inPrim.indices);
+    for (uint32_t i = 0; i < glTF::Primitive::kNumAttribs; ++i)
+        HashAccessor(hash, inPrim.attributes[i]);
+    return hash.Finish();
+}
+
+// The fixed-size part of a cached primitive, which is followed by the VB, IB, depth VB and meshlets
+struct CachedPrimitive
+{
+    Math::BoundingSphere boundsLS;
+    Math::BoundingSphere boundsOS;
+    Math::AxisAlignedBox bboxLS;
+    Math::AxisAlignedBox bboxOS;
+    uint64_t vbSize;
+    uint64_t ibSize;
+    uint64_t depthVBSize;
+    uint64_t numMeshlets;
+    uint32_t primCount;
+    uint32_t hash;
+    uint32_t vertexStride;
+};
+
+static void SerializePrimitive( const Renderer::Primitive& prim, std::vector<uint8_t>& entry )
+{
+    CachedPrimitive header;
+    std::memset(&header, 0, sizeof(header));
+    header.boundsLS = prim.m_BoundsLS;
+    header.boundsOS = prim.m_BoundsOS;
+    header.bboxLS = prim.m_BBoxLS;
+    header.bboxOS = prim.m_BBoxOS;
+    header.vbSize = prim.VB->size();
+    header.ibSize = prim.IB->size();
+    header.depthVBSize = prim.DepthVB->size();
+    header.numMeshlets = prim.meshlets.size();
+    header.primCount = prim.primCount;
+    header.hash = prim.hash;
+    header.vertexStride = prim.vertexStride;
+
+    const size_t meshletBytes = prim.meshlets.size() * sizeof(Meshlet);
+    entry.resize(sizeof(header) + prim.VB->size() + prim.IB->size() + prim.DepthVB->size() + meshletBytes);
+    uint8_t* dest = entry.data();
+    std::memcpy(dest, &header, sizeof(header));
+    dest += sizeof(header);
+    std::memcpy(dest, prim.VB->data(), prim.VB->size());
+    dest += prim.VB->size();
+    std::memcpy(dest, prim.IB->data(), prim.IB->size());
+    dest += prim.IB->size();
+    std::memcpy(dest, prim.DepthVB->data(), prim.DepthVB->size());
+    dest += prim.DepthVB->size();
+    if (meshletBytes > 0)
+        std::memcpy(dest, prim.meshlets.data(), meshletBytes);
+}
+
+static bool DeserializePrimitive( Renderer::Primitive& prim, const std::vector<uint8_t>& entry )
+{
+    CachedPrimitive header;
+    if (entry.size() < sizeof(header))
+        return false;
+    std::memcpy(&header, entry.data(), sizeof(header));
+
+    const uint64_t bufferBytes = header.vbSize + header.ibSize + header.depthVBSize;
+    if (header.numMeshlets > entry.size() / sizeof(Meshlet) ||
+        sizeof(header) + bufferBytes + header.numMeshlets * sizeof(Meshlet) != entry.size())
+    {
+        return false;
+    }
+
+    const uint8_t* src = entry.data() + sizeof(header);
+    prim.m_BoundsLS = header.boundsLS;
+    prim.m_BoundsOS = header.boundsOS;
+    prim.m_BBoxLS = header.bboxLS;
+    prim.m_BBoxOS = header.bboxOS;
+    prim.VB = std::make_shared<std::vector<byte>>(src, src + header.vbSize);
+    src += header.vbSize;
+    prim.IB = std::make_shared<std::vector<byte>>(src, src + header.ibSize);
+    src += header.ibSize;
+    prim.DepthVB = std::make_shared<std::vector<byte>>(src, src + header.depthVBSize);
+    src += header.depthVBSize;
+    prim.meshlets.resize((size_t)header.numMeshlets);
+    if (header.numMeshlets > 0)
+        std::memcpy(prim.meshlets.data(), src, (size_t)header.numMeshlets * sizeof(Meshlet));
+    prim.primCount = header.primCount;
+    prim.hash = header.hash;
+    prim.vertexStride = (uint16_t)header.vertexStride;
+    return true;
+}
+
+void OptimizeMesh( Renderer::Primitive& outPrim, const glTF::Primitive& inPrim, const Math::Matrix4& localToObject,
+    const ModelCache* cache )
+{
+    if (cache == nullptr)
+    {
+        ConvertPrimitive(outPrim, inPrim, localToObject);
+        return;
+    }
+
+    const uint64_t key = PrimitiveKey(inPrim, localToObject);
+
+    std::vector<uint8_t> entry;
+    if (cache->Load(key, entry) && DeserializePrimitive(outPrim, entry))
+    {
+        outPrim.materialIdx = inPrim.material->index;
+        return;
+    }
+
+    ConvertPrimitive(outPrim, inPrim, localToObject);
+
+    // Unsupported topologies are skipped without output
+    if (outPrim.VB == nullptr)
+        return;
+
+    SerializePrimitive(outPrim, entry);
+    if (!cache->Store(key, entry.data(), entry.size()))
+        Utility::Printf("Warning: Could not write to the model cache in %s\n", cache->GetDirectory().c_str());
+}
@@ -17,8 +17,13 @@
 #include "../Core/Math/BoundingSphere.h"
 #include "../Core/Math/BoundingBox.h"
 
+#include "Meshlet.h"
+
 #include <cstdint>
 #include <string>
+#include <vector>
+
+class ModelCache;
 
 namespace Renderer
 {
@@ -33,6 +38,7 @@ namespace Renderer
         Utility::ByteArray VB;
         Utility::ByteArray IB;
         Utility::ByteArray DepthVB;
+        std::vector<Meshlet> meshlets;  // of IB, relative to its first triangle
         uint32_t primCount;
         union
         {
@@ -47,4 +53,8 @@ namespace Renderer
     };
 }
 
-void OptimizeMesh( Renderer::Primitive& outPrim, const glTF::Primitive& inPrim, const Math::Matrix4& localToObject );
\ No newline at end of file
+// Converts and vertex cache optimizes a primitive.  With a cache, the result is looked up by a hash of the primitive's
+// vertex and index data, its transform and the material flags that affect it, and is stored there if it was not found,
+// so that only the primitives whose inputs changed are optimized again.
+void OptimizeMesh( Renderer::Primitive& outPrim, const glTF::Primitive& inPrim, const Math::Matrix4& localToObject,
+    const ModelCache* cache = nullptr );
\ No newline at end of file
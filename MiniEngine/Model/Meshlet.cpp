@@ -0,0 +1,360 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+
+#include "Meshlet.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cfloat>
+#include <cstring>
+#include <memory>
+
+namespace
+{
+    const uint8_t kNotInMeshlet = 0xFF;
+
+    // Normals that spread further than this from the average cannot be bounded by a useful cone.
+    const float kMinConeDot = 0.1f;
+
+    // A triangle joins a meshlet only if its normal is within about 37 degrees of the running average, so that the
+    // cones stay narrow enough to reject the meshlet from some views.
+    const float kMinGroupDot = 0.8f;
+
+    // How many new vertices a unit of normal deviation (1 - cos) is worth when the next triangle is chosen
+    const float kConeWeight = 4.0f;
+
+    // The unused triangles after the first one, in the cache-optimized order, that a meshlet also considers
+    const uint32_t kSearchWindow = 32;
+
+    inline void LoadPosition(const float* positions, size_t positionStride, uint32_t index, float (&position)[3])
+    {
+        std::memcpy(position, reinterpret_cast<const uint8_t*>(positions) + index * positionStride, sizeof(position));
+    }
+
+    inline float Dot(const float (&a)[3], const float (&b)[3])
+    {
+        return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+    }
+
+    template <typename IndexType>
+    void ComputeMeshletBounds(const IndexType* indexList, const uint32_t* vertices, const float* positions, size_t positionStride, Meshlet& meshlet)
+    {
+        // Bounding sphere around the center of the bounding box, as OptimizeMesh() computes it for whole primitives
+        float minPos[3] = { FLT_MAX, FLT_MAX, FLT_MAX };
+        float maxPos[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+        for (uint32_t v = 0; v < meshlet.vertexCount; ++v)
+        {
+            float position[3];
+            LoadPosition(positions, positionStride, vertices[v], position);
+            for (int k = 0; k < 3; ++k)
+            {
+                minPos[k] = std::min(minPos[k], position[k]);
+                maxPos[k] = std::max(maxPos[k], position[k]);
+            }
+        }
+
+        float center[3];
+        for (int k = 0; k < 3; ++k)
+        {
+            center[k] = (minPos[k] + maxPos[k]) * 0.5f;
+        }
+
+        float maxRadiusSq = 0.0f;
+        for (uint32_t v = 0; v < meshlet.vertexCount; ++v)
+        {
+            float position[3];
+            LoadPosition(positions, positionStride, vertices[v], position);
+            const float offset[3] = { position[0] - center[0], position[1] - center[1], position[2] - center[2] };
+            maxRadiusSq = std::max(maxRadiusSq, Dot(offset, offset));
+        }
+
+        std::memcpy(meshlet.center, center, sizeof(center));
+        meshlet.radius = std::sqrt(maxRadiusSq);
+
+        // Normal cone: the axis is the average face normal, and the cutoff is the sine of the largest angle between
+        // the axis and a face normal.  Degenerate triangles have no facing and are left out.
+        float normals[Meshlet::kMaxTriangles][3];
+        float corners[Meshlet::kMaxTriangles][3];
+        uint32_t normalCount = 0;
+        float axis[3] = { 0.0f, 0.0f, 0.0f };
+
+        for (uint32_t t = 0; t < meshlet.triangleCount; ++t)
+        {
+            const IndexType* triangle = indexList + (meshlet.startTriangle + t) * 3;
+            float p0[3], p1[3], p2[3];
+            LoadPosition(positions, positionStride, triangle[0], p0);
+            LoadPosition(positions, positionStride, triangle[1], p1);
+            LoadPosition(positions, positionStride, triangle[2], p2);
+
+            const float e1[3] = { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+            const float e2[3] = { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+            float normal[3] = { e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0] };
+            const float length = std::sqrt(Dot(normal, normal));
+            if (length == 0.0f)
+                continue;
+
+            for (int k = 0; k < 3; ++k)
+            {
+                normal[k] /= length;
+                axis[k] += normal[k];
+                normals[normalCount][k] = normal[k];
+                corners[normalCount][k] = p0[k];
+            }
+            ++normalCount;
+        }
+
+        const float axisLength = std::sqrt(Dot(axis, axis));
+        float minDot = 1.0f;
+        if (axisLength > 0.0f)
+        {
+            for (int k = 0; k < 3; ++k)
+            {
+                axis[k] /= axisLength;
+            }
+            for (uint32_t n = 0; n < normalCount; ++n)
+            {
+                minDot = std::min(minDot, Dot(axis, normals[n]));
+            }
+        }
+
+        if (normalCount == 0 || axisLength == 0.0f || minDot <= kMinConeDot)
+        {
+            std::memcpy(meshlet.coneApex, center, sizeof(center));
+            std::memcpy(meshlet.coneAxis, axis, sizeof(axis));
+            meshlet.coneCutoff = 1.0f;
+            return;
+        }
+
+        // Move the apex back along the axis until it is behind the plane of every triangle, so that a viewer
+        // inside the cone is behind all of them.
+        float maxT = 0.0f;
+        for (uint32_t n = 0; n < normalCount; ++n)
+        {
+            const float toCenter[3] = { center[0] - corners[n][0], center[1] - corners[n][1], center[2] - corners[n][2] };
+            maxT = std::max(maxT, Dot(toCenter, normals[n]) / Dot(axis, normals[n]));
+        }
+
+        for (int k = 0; k < 3; ++k)
+        {
+            meshlet.coneApex[k] = center[k] - axis[k] * maxT;
+        }
+        std::memcpy(meshlet.coneAxis, axis, sizeof(axis));
+        meshlet.coneCutoff = std::sqrt(1.0f - minDot * minDot);
+    }
+}
+
+template <typename IndexType>
+bool BuildMeshlets(IndexType* indexList, size_t indexCount, const float* positions, size_t positionStride,
+    size_t vertexCount, std::vector<Meshlet>& meshlets)
+{
+    // The indices come from the file, and every array below is indexed by them.
+    if (indexCount % 3 != 0)
+        return false;
+    for (size_t i = 0; i < indexCount; ++i)
+    {
+        if (indexList[i] >= vertexCount)
+            return false;
+    }
+
+    const uint32_t triangleCount = (uint32_t)(indexCount / 3);
+    if (triangleCount == 0)
+        return true;
+
+    // Unit face normals; degenerate triangles get a zero normal and fit any cone.
+    std::unique_ptr<float[][3]> faceNormals(new float[triangleCount][3]);
+    for (uint32_t t = 0; t < triangleCount; ++t)
+    {
+        const IndexType* triangle = indexList + t * 3;
+        float p0[3], p1[3], p2[3];
+        LoadPosition(positions, positionStride, triangle[0], p0);
+        LoadPosition(positions, positionStride, triangle[1], p1);
+        LoadPosition(positions, positionStride, triangle[2], p2);
+
+        const float e1[3] = { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+        const float e2[3] = { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+        float* normal = faceNormals[t];
+        normal[0] = e1[1] * e2[2] - e1[2] * e2[1];
+        normal[1] = e1[2] * e2[0] - e1[0] * e2[2];
+        normal[2] = e1[0] * e2[1] - e1[1] * e2[0];
+        const float length = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+        const float scale = length > 0.0f ? 1.0f / length : 0.0f;
+        for (int k = 0; k < 3; ++k)
+            normal[k] *= scale;
+    }
+
+    // The triangles of each vertex
+    std::unique_ptr<uint32_t[]> adjacencyOffsets(new uint32_t[vertexCount + 1]());
+    for (size_t i = 0; i < indexCount; ++i)
+        ++adjacencyOffsets[indexList[i] + 1];
+    for (size_t v = 0; v < vertexCount; ++v)
+        adjacencyOffsets[v + 1] += adjacencyOffsets[v];
+
+    std::unique_ptr<uint32_t[]> adjacency(new uint32_t[indexCount]);
+    {
+        std::unique_ptr<uint32_t[]> fill(new uint32_t[vertexCount]);
+        std::memcpy(fill.get(), adjacencyOffsets.get(), vertexCount * sizeof(uint32_t));
+        for (size_t i = 0; i < indexCount; ++i)
+            adjacency[fill[indexList[i]]++] = (uint32_t)(i / 3);
+    }
+
+    // The slot of each vertex in the open meshlet
+    std::unique_ptr<uint8_t[]> vertexSlots(new uint8_t[vertexCount]);
+    std::memset(vertexSlots.get(), kNotInMeshlet, vertexCount);
+
+    std::unique_ptr<bool[]> emitted(new bool[triangleCount]());
+    std::vector<IndexType> output;
+    output.reserve(indexCount);
+    std::vector<uint32_t> candidates;
+
+    uint32_t vertices[Meshlet::kMaxVertices];
+    float axis[3] = { 0.0f, 0.0f, 0.0f };
+    float axisSum[3] = { 0.0f, 0.0f, 0.0f };
+    uint32_t nextUnemitted = 0;
+
+    Meshlet meshlet = {};
+
+    auto CountNewVertices = [&](uint32_t t)
+    {
+        const IndexType* triangle = indexList + t * 3;
+        const uint32_t a = triangle[0];
+        const uint32_t b = triangle[1];
+        const uint32_t c = triangle[2];
+        return (uint32_t)((vertexSlots[a] == kNotInMeshlet) +
+            (vertexSlots[b] == kNotInMeshlet && b != a) +
+            (vertexSlots[c] == kNotInMeshlet && c != a && c != b));
+    };
+
+    // Fewer new vertices first, then the normal closest to the cone axis.  Returns a negative score for triangles
+    // that do not fit or whose normal is at a cosine below kMinGroupDot from the axis.
+    auto Score = [&](uint32_t t)
+    {
+        const uint32_t newVertexCount = CountNewVertices(t);
+        if (meshlet.vertexCount + newVertexCount > Meshlet::kMaxVertices)
+            return -1.0f;
+
+        const float* normal = faceNormals[t];
+        const bool degenerate = normal[0] == 0.0f && normal[1] == 0.0f && normal[2] == 0.0f;
+        const float dot = degenerate ? 1.0f : axis[0] * normal[0] + axis[1] * normal[1] + axis[2] * normal[2];
+        if (dot < kMinGroupDot)
+            return -1.0f;
+
+        return (float)(3 - newVertexCount) + kConeWeight * dot;
+    };
+
+    auto AddTriangle = [&](uint32_t t)
+    {
+        emitted[t] = true;
+        const IndexType* triangle = indexList + t * 3;
+        for (uint32_t v = 0; v < 3; ++v)
+        {
+            const uint32_t vertex = triangle[v];
+            output.push_back(triangle[v]);
+            if (vertexSlots[vertex] == kNotInMeshlet)
+            {
+                vertexSlots[vertex] = (uint8_t)meshlet.vertexCount;
+                vertices[meshlet.vertexCount++] = vertex;
+                for (uint32_t a = adjacencyOffsets[vertex]; a < adjacencyOffsets[vertex + 1]; ++a)
+                {
+                    if (!emitted[adjacency[a]])
+                        candidates.push_back(adjacency[a]);
+                }
+            }
+        }
+
+        for (int k = 0; k < 3; ++k)
+            axisSum[k] += faceNormals[t][k];
+        const float length = std::sqrt(axisSum[0] * axisSum[0] + axisSum[1] * axisSum[1] + axisSum[2] * axisSum[2]);
+        for (int k = 0; k < 3; ++k)
+            axis[k] = length > 0.0f ? axisSum[k] / length : 0.0f;
+
+        ++meshlet.triangleCount;
+    };
+
+    auto CloseMeshlet = [&]()
+    {
+        ComputeMeshletBounds(output.data(), vertices, positions, positionStride, meshlet);
+        meshlets.push_back(meshlet);
+
+        for (uint32_t v = 0; v < meshlet.vertexCount; ++v)
+        {
+            vertexSlots[vertices[v]] = kNotInMeshlet;
+        }
+
+        meshlet.startTriangle += meshlet.triangleCount;
+        meshlet.triangleCount = 0;
+        meshlet.vertexCount = 0;
+        candidates.clear();
+        axisSum[0] = axisSum[1] = axisSum[2] = 0.0f;
+        axis[0] = axis[1] = axis[2] = 0.0f;
+    };
+
+    for (;;)
+    {
+        while (nextUnemitted < triangleCount && emitted[nextUnemitted])
+            ++nextUnemitted;
+        if (nextUnemitted == triangleCount)
+            break;
+
+        // Each meshlet starts at the first triangle left in the cache-optimized order.
+        AddTriangle(nextUnemitted);
+
+        while (meshlet.triangleCount < Meshlet::kMaxTriangles)
+        {
+            // The neighbors of the meshlet, and the next few triangles in the cache-optimized order, which are close
+            // but may share no vertex, as the separate cards of foliage do.
+            uint32_t best = triangleCount;
+            float bestScore = -1.0f;
+            size_t kept = 0;
+            for (size_t c = 0; c < candidates.size(); ++c)
+            {
+                const uint32_t t = candidates[c];
+                if (emitted[t])
+                    continue;
+                candidates[kept++] = t;
+
+                const float score = Score(t);
+                if (score > bestScore)
+                {
+                    bestScore = score;
+                    best = t;
+                }
+            }
+            candidates.resize(kept);
+
+            uint32_t windowCount = 0;
+            for (uint32_t t = nextUnemitted; t < triangleCount && windowCount < kSearchWindow; ++t)
+            {
+                if (emitted[t])
+                    continue;
+                ++windowCount;
+
+                const float score = Score(t);
+                if (score > bestScore)
+                {
+                    bestScore = score;
+                    best = t;
+                }
+            }
+
+            if (best == triangleCount)
+                break;
+            AddTriangle(best);
+        }
+
+        CloseMeshlet();
+    }
+
+    std::memcpy(indexList, output.data(), indexCount * sizeof(IndexType));
+    return true;
+}
+
+template bool BuildMeshlets<uint16_t>(uint16_t* indexList, size_t indexCount, const float* positions, size_t positionStride,
+    size_t vertexCount, std::vector<Meshlet>& meshlets);
+template bool BuildMeshlets<uint32_t>(uint32_t* indexList, size_t indexCount, const float* positions, size_t positionStride,
+    size_t vertexCount, std::vector<Meshlet>& meshlets);
@@ -0,0 +1,87 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+
+#pragma once
+
+// Meshlets (clusters) of a triangle list with the bounds needed to reject whole clusters before triangle setup:
+// a bounding sphere for frustum and occlusion tests and a normal cone for backface tests.  This header does not
+// depend on pch.h so that it can be shared with portable (non-D3D12) tools.
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// A meshlet is a contiguous range of triangles of its draw.  BuildMeshlets() reorders the index buffer, which is
+// already ordered for the post-transform cache, into these ranges, and keeps each range compact.
+// Bounds are in the space of the vertex positions (the local space of the mesh).
+struct Meshlet
+{
+    enum
+    {
+        kMaxVertices = 64,
+        kMaxTriangles = 124,
+    };
+
+    float center[3];        // Bounding sphere
+    float radius;
+
+    // Every triangle faces away from a viewer at v when dot(normalize(coneApex - v), coneAxis) > coneCutoff.
+    // A cutoff of 1 (triangles facing too many ways) disables the test.
+    float coneApex[3];
+    float coneCutoff;
+    float coneAxis[3];
+
+    uint32_t startTriangle; // First triangle, relative to the first index of the draw
+    uint16_t triangleCount;
+    uint16_t vertexCount;   // Unique vertices referenced
+};
+
+static_assert(sizeof(Meshlet) == 52, "Meshlets are serialized in .mini files");
+
+inline bool IsMeshletBackfacing(const Meshlet& meshlet, const float viewerPosition[3])
+{
+    const float dx = meshlet.coneApex[0] - viewerPosition[0];
+    const float dy = meshlet.coneApex[1] - viewerPosition[1];
+    const float dz = meshlet.coneApex[2] - viewerPosition[2];
+    const float d = meshlet.coneAxis[0] * dx + meshlet.coneAxis[1] * dy + meshlet.coneAxis[2] * dz;
+
+    // d > cutoff * |apex - v| without the square root; a positive cutoff needs a positive d
+    return d > 0.0f && meshlet.coneCutoff < 1.0f && d * d > meshlet.coneCutoff * meshlet.coneCutoff * (dx * dx + dy * dy + dz * dz);
+}
+
+//-----------------------------------------------------------------------------
+//  BuildMeshlets
+//-----------------------------------------------------------------------------
+//  Groups the triangles of a triangle list into meshlets, reorders the list
+//  so that each meshlet is a contiguous range, and appends the meshlets to
+//  meshlets.  A meshlet starts at the first triangle left in list order and
+//  grows by the triangle that adds the fewest vertices and whose normal is
+//  closest to the average of the meshlet, among its neighbors and the next
+//  triangles of the list, so that the normal cones stay narrow.  It is
+//  closed at Meshlet::kMaxVertices unique vertices, Meshlet::kMaxTriangles
+//  triangles, or when no triangle within about 37 degrees of its average
+//  normal is left.
+//  Parameters:
+//      indexList
+//          input index list, reordered in place
+//      indexCount
+//          the number of indices in the list
+//      positions
+//          the first vertex position (three floats)
+//      positionStride
+//          the byte distance between consecutive positions
+//      vertexCount
+//          the number of vertices
+//  Returns false, and leaves the list and meshlets as they were, if an
+//  index is not below vertexCount or indexCount is not a multiple of 3.
+//-----------------------------------------------------------------------------
+template <typename IndexType>
+bool BuildMeshlets(IndexType* indexList, size_t indexCount, const float* positions, size_t positionStride,
+    size_t vertexCount, std::vector<Meshlet>& meshlets);
@@ -0,0 +1,396 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+
+#include "MipGenerator.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <thread>
+#include <vector>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+namespace
+{
+    const uint32_t kAlphaBins = 4096;
+    const uint32_t kEncodeTableSize = 16384;
+    const uint32_t kMinParallelTexels = 65536;  // Smaller levels are not worth waking the threads for
+    const uint32_t kBandTexels = 65536;         // Destination texels per band
+
+    struct SRGBTables
+    {
+        float Decode[256];
+        uint8_t Encode[kEncodeTableSize];  // Of linear values quantized to kEncodeTableSize - 1 steps
+
+        SRGBTables()
+        {
+            for (uint32_t i = 0; i < 256; ++i)
+            {
+                const float c = i / 255.0f;
+                Decode[i] = c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+            }
+
+            for (uint32_t i = 0; i < kEncodeTableSize; ++i)
+            {
+                const float l = (float)i / (kEncodeTableSize - 1);
+                const float c = l <= 0.0031308f ? l * 12.92f : 1.055f * std::pow(l, 1.0f / 2.4f) - 0.055f;
+                Encode[i] = (uint8_t)std::lround(std::min(std::max(c, 0.0f), 1.0f) * 255.0f);
+            }
+        }
+    };
+
+    const SRGBTables& GetSRGBTables()
+    {
+        static const SRGBTables tables;
+        return tables;
+    }
+
+    // Taps of the source texels along one axis for each destination texel, with the edges already resolved
+    struct AxisTaps
+    {
+        std::vector<uint32_t> First;    // Per destination texel, into Index and Weight, with one past the last at the end
+        std::vector<uint32_t> Index;
+        std::vector<float> Weight;
+    };
+
+    float BesselI0(float x)
+    {
+        float sum = 1.0f, term = 1.0f;
+        for (uint32_t k = 1; k < 32 && term > sum * 1.0e-8f; ++k)
+        {
+            term *= (x * x) / (4.0f * k * k);
+            sum += term;
+        }
+        return sum;
+    }
+
+    // t is in destination texels from the center of the destination texel
+    float Kaiser(float t)
+    {
+        const float kRadius = 2.0f;
+        const float kAlpha = 4.0f;
+        const float kPi = 3.14159265358979f;
+
+        if (std::abs(t) >= kRadius)
+            return 0.0f;
+
+        const float sinc = t == 0.0f ? 1.0f : std::sin(kPi * t) / (kPi * t);
+        const float r = t / kRadius;
+        return sinc * BesselI0(kAlpha * std::sqrt(1.0f - r * r)) / BesselI0(kAlpha);
+    }
+
+    AxisTaps MakeTaps(uint32_t sourceSize, uint32_t destSize, MipFilter filter, bool wrap)
+    {
+        AxisTaps taps;
+        const float scale = (float)sourceSize / destSize;
+
+        for (uint32_t i = 0; i < destSize; ++i)
+        {
+            taps.First.push_back((uint32_t)taps.Index.size());
+
+            const float lo = i * scale, hi = (i + 1) * scale, center = (i + 0.5f) * scale;
+            const float radius = filter == MipFilter::kBox || scale <= 1.0f ? 0.5f * scale : 2.0f * scale;
+            const int first = (int)std::floor(center - radius);
+            const int last = (int)std::ceil(center + radius) - 1;
+
+            float total = 0.0f;
+            for (int j = first; j <= last; ++j)
+            {
+                // A box covers parts of the texels at its ends when the size is odd.
+                const float weight = filter == MipFilter::kBox || scale <= 1.0f ?
+                    std::max(std::min(hi, j + 1.0f) - std::max(lo, (float)j), 0.0f) :
+                    Kaiser((j + 0.5f - center) / scale);
+                if (weight == 0.0f)
+                    continue;
+
+                const int n = (int)sourceSize;
+                taps.Index.push_back((uint32_t)(wrap ? (j % n + n) % n : std::min(std::max(j, 0), n - 1)));
+                taps.Weight.push_back(weight);
+                total += weight;
+            }
+
+            for (uint32_t k = taps.First.back(); k < taps.Weight.size(); ++k)
+                taps.Weight[k] /= total;
+        }
+        taps.First.push_back((uint32_t)taps.Index.size());
+
+        return taps;
+    }
+
+    // Calls function(index, worker) for every index in [0, count), on up to threadCount threads
+    template <typename Function>
+    void ParallelFor(uint32_t count, uint32_t threadCount, const Function& function)
+    {
+        threadCount = std::max(std::min(threadCount, count), 1u);
+
+        std::atomic<uint32_t> next(0);
+        auto run = [&](uint32_t worker)
+        {
+            for (uint32_t i = next++; i < count; i = next++)
+                function(i, worker);
+        };
+
+        std::vector<std::thread> threads;
+        for (uint32_t worker = 1; worker < threadCount; ++worker)
+            threads.emplace_back(run, worker);
+
+        run(0);
+
+        for (std::thread& thread : threads)
+            thread.join();
+    }
+
+    // The linear RGBA floats of a row of level 0
+    void DecodeRow(const uint8_t* texels, uint32_t width, bool sRGB, float* row)
+    {
+        const float* decode = GetSRGBTables().Decode;
+        for (uint32_t x = 0; x < width; ++x)
+        {
+            for (uint32_t c = 0; c < 3; ++c)
+                row[x * 4 + c] = sRGB ? decode[texels[x * 4 + c]] : texels[x * 4 + c] * (1.0f / 255.0f);
+            row[x * 4 + 3] = texels[x * 4 + 3] * (1.0f / 255.0f);
+        }
+    }
+
+    // row = sum of weights[k] * sources[k], over count floats
+    void FilterVertical(const float* const* sources, const float* weights, uint32_t tapCount, size_t count, float* row)
+    {
+        size_t i = 0;
+
+#if defined(__AVX2__)
+        for (; i + 8 <= count; i += 8)
+        {
+            __m256 sum = _mm256_mul_ps(_mm256_set1_ps(weights[0]), _mm256_loadu_ps(sources[0] + i));
+            for (uint32_t k = 1; k < tapCount; ++k)
+                sum = _mm256_fmadd_ps(_mm256_set1_ps(weights[k]), _mm256_loadu_ps(sources[k] + i), sum);
+            _mm256_storeu_ps(row + i, sum);
+        }
+#endif
+
+        for (; i < count; ++i)
+        {
+            float sum = 0.0f;
+            for (uint32_t k = 0; k < tapCount; ++k)
+                sum += weights[k] * sources[k][i];
+            row[i] = sum;
+        }
+    }
+
+    // dest[x] = sum of the taps of x over source, clamped to [0, 1] against the ringing of the Kaiser filter
+    void FilterHorizontal(const float* source, const AxisTaps& taps, uint32_t width, float* dest)
+    {
+        for (uint32_t x = 0; x < width; ++x)
+        {
+            const uint32_t first = taps.First[x], last = taps.First[x + 1];
+
+#if defined(__AVX2__)
+            __m128 sum = _mm_setzero_ps();
+            for (uint32_t k = first; k < last; ++k)
+                sum = _mm_fmadd_ps(_mm_set1_ps(taps.Weight[k]), _mm_loadu_ps(source + taps.Index[k] * 4), sum);
+            sum = _mm_min_ps(_mm_max_ps(sum, _mm_setzero_ps()), _mm_set1_ps(1.0f));
+            _mm_storeu_ps(dest + x * 4, sum);
+#else
+            float sum[4] = {};
+            for (uint32_t k = first; k < last; ++k)
+                for (uint32_t c = 0; c < 4; ++c)
+                    sum[c] += taps.Weight[k] * source[taps.Index[k] * 4 + c];
+            for (uint32_t c = 0; c < 4; ++c)
+                dest[x * 4 + c] = std::min(std::max(sum[c], 0.0f), 1.0f);
+#endif
+        }
+    }
+
+    // Normals stored as UNORM back to unit length.  Alpha is kept.
+    void RenormalizeRow(float* row, uint32_t width)
+    {
+        for (uint32_t x = 0; x < width; ++x)
+        {
+            float* texel = row + x * 4;
+            const float nx = texel[0] * 2.0f - 1.0f, ny = texel[1] * 2.0f - 1.0f, nz = texel[2] * 2.0f - 1.0f;
+            const float length = std::sqrt(nx * nx + ny * ny + nz * nz);
+            if (length < 1.0e-6f)
+            {
+                texel[0] = 0.5f;
+                texel[1] = 0.5f;
+                texel[2] = 1.0f;
+                continue;
+            }
+
+            const float scale = 0.5f / length;
+            texel[0] = nx * scale + 0.5f;
+            texel[1] = ny * scale + 0.5f;
+            texel[2] = nz * scale + 0.5f;
+        }
+    }
+
+    void EncodeRow(const float* row, uint32_t width, bool sRGB, float alphaScale, uint8_t* texels)
+    {
+        const uint8_t* encode = GetSRGBTables().Encode;
+        for (uint32_t x = 0; x < width; ++x)
+        {
+            for (uint32_t c = 0; c < 3; ++c)
+            {
+                const float value = row[x * 4 + c];
+                texels[x * 4 + c] = sRGB ? encode[(uint32_t)(value * (kEncodeTableSize - 1) + 0.5f)] : (uint8_t)(value * 255.0f + 0.5f);
+            }
+            texels[x * 4 + 3] = (uint8_t)(std::min(row[x * 4 + 3] * alphaScale, 1.0f) * 255.0f + 0.5f);
+        }
+    }
+
+    // The scale of alpha that makes coverageCount texels reach the cutoff, from a histogram of the alpha of a level
+    float GetAlphaScale(const std::vector<uint32_t>& histogram, uint64_t coverageCount, float cutoff)
+    {
+        if (coverageCount == 0)
+            return 1.0f;
+
+        // Down from the top bin to the threshold that lets the nearest count of texels pass.  The small levels have
+        // few texels, and often all of similar alpha.
+        uint64_t count = 0;
+        for (uint32_t bin = kAlphaBins; bin-- > 0;)
+        {
+            const uint64_t next = count + histogram[bin];
+            if (next >= coverageCount)
+            {
+                if (next - coverageCount > coverageCount - count)
+                    return cutoff * kAlphaBins / (bin + 1);
+                return bin == 0 ? 1.0f : cutoff * kAlphaBins / bin;
+            }
+            count = next;
+        }
+        return 1.0f;
+    }
+}
+
+uint32_t GetMipCount(uint32_t width, uint32_t height)
+{
+    uint32_t count = 1;
+    for (uint32_t size = std::max(width, height); size > 1; size >>= 1)
+        ++count;
+    return count;
+}
+
+void GenerateMips(const MipImage* mips, uint32_t mipCount, const MipOptions& options)
+{
+    const uint32_t threadCount = options.ThreadCount != 0 ? options.ThreadCount : std::max(std::thread::hardware_concurrency(), 1u);
+    const bool preserveCoverage = options.AlphaCutoff > 0.0f;
+    const bool isSRGB = options.SRGB && !options.NormalMap;
+
+    // Texels of level 0 that pass the cutoff
+    uint64_t coverageCount = 0;
+    if (preserveCoverage)
+    {
+        const uint32_t cutoff = (uint32_t)std::ceil(options.AlphaCutoff * 255.0f);
+        for (uint32_t y = 0; y < mips[0].Height; ++y)
+        {
+            const uint8_t* row = mips[0].Texels + y * mips[0].RowPitch;
+            for (uint32_t x = 0; x < mips[0].Width; ++x)
+                coverageCount += row[x * 4 + 3] >= cutoff ? 1 : 0;
+        }
+    }
+
+    std::vector<float> source;  // The previous level as floats, from level 1 on
+    for (uint32_t level = 1; level < mipCount; ++level)
+    {
+        const MipImage& src = mips[level - 1];
+        const MipImage& dst = mips[level];
+        const AxisTaps rowTaps = MakeTaps(src.Height, dst.Height, options.Filter, options.Wrap);
+        const AxisTaps columnTaps = MakeTaps(src.Width, dst.Width, options.Filter, options.Wrap);
+        const size_t srcRowFloats = (size_t)src.Width * 4;
+        const size_t dstRowFloats = (size_t)dst.Width * 4;
+
+        const uint32_t bandRows = std::max(kBandTexels / dst.Width, 1u);
+        const uint32_t bandCount = (dst.Height + bandRows - 1) / bandRows;
+        const uint32_t levelThreads = (uint64_t)dst.Width * dst.Height >= kMinParallelTexels ? threadCount : 1;
+
+        std::vector<float> dest(dstRowFloats * dst.Height);
+        std::vector<std::vector<uint32_t>> histograms(preserveCoverage ? levelThreads : 0, std::vector<uint32_t>(kAlphaBins));
+
+        ParallelFor(bandCount, levelThreads, [&](uint32_t band, uint32_t worker)
+        {
+            const uint32_t y0 = band * bandRows, y1 = std::min(y0 + bandRows, dst.Height);
+
+            // Level 0 is decoded to floats for each band, with the rows around it that its taps reach.
+            std::vector<uint32_t> decodedRows;
+            std::vector<float> decoded;
+            if (level == 1)
+            {
+                decodedRows.assign(rowTaps.Index.begin() + rowTaps.First[y0], rowTaps.Index.begin() + rowTaps.First[y1]);
+                std::sort(decodedRows.begin(), decodedRows.end());
+                decodedRows.erase(std::unique(decodedRows.begin(), decodedRows.end()), decodedRows.end());
+
+                decoded.resize(decodedRows.size() * srcRowFloats);
+                for (size_t i = 0; i < decodedRows.size(); ++i)
+                    DecodeRow(src.Texels + decodedRows[i] * src.RowPitch, src.Width, isSRGB, &decoded[i * srcRowFloats]);
+            }
+
+            std::vector<float> row(srcRowFloats);
+            std::vector<const float*> sourceRows;
+            for (uint32_t y = y0; y < y1; ++y)
+            {
+                const uint32_t first = rowTaps.First[y], last = rowTaps.First[y + 1];
+
+                sourceRows.clear();
+                for (uint32_t k = first; k < last; ++k)
+                {
+                    const uint32_t index = rowTaps.Index[k];
+                    if (level == 1)
+                    {
+                        const size_t slot = std::lower_bound(decodedRows.begin(), decodedRows.end(), index) - decodedRows.begin();
+                        sourceRows.push_back(&decoded[slot * srcRowFloats]);
+                    }
+                    else
+                    {
+                        sourceRows.push_back(&source[index * srcRowFloats]);
+                    }
+                }
+
+                float* destRow = &dest[y * dstRowFloats];
+                FilterVertical(sourceRows.data(), &rowTaps.Weight[first], last - first, srcRowFloats, row.data());
+                FilterHorizontal(row.data(), columnTaps, dst.Width, destRow);
+
+                if (options.NormalMap)
+                    RenormalizeRow(destRow, dst.Width);
+
+                if (preserveCoverage)
+                {
+                    std::vector<uint32_t>& histogram = histograms[worker];
+                    for (uint32_t x = 0; x < dst.Width; ++x)
+                        ++histogram[std::min((uint32_t)(destRow[x * 4 + 3] * kAlphaBins), kAlphaBins - 1)];
+                }
+                else
+                {
+                    EncodeRow(destRow, dst.Width, isSRGB, 1.0f, dst.Texels + y * dst.RowPitch);
+                }
+            }
+        });
+
+        if (preserveCoverage)
+        {
+            // The same fraction of the texels of this level as of level 0 should pass the cutoff
+            for (uint32_t worker = 1; worker < histograms.size(); ++worker)
+                for (uint32_t bin = 0; bin < kAlphaBins; ++bin)
+                    histograms[0][bin] += histograms[worker][bin];
+
+            const uint64_t levelCoverage = (uint64_t)std::llround((double)coverageCount * dst.Width * dst.Height / ((double)mips[0].Width * mips[0].Height));
+            const float alphaScale = GetAlphaScale(histograms[0], levelCoverage, options.AlphaCutoff);
+
+            ParallelFor(bandCount, levelThreads, [&](uint32_t band, uint32_t)
+            {
+                for (uint32_t y = band * bandRows; y < std::min((band + 1) * bandRows, dst.Height); ++y)
+                    EncodeRow(&dest[y * dstRowFloats], dst.Width, isSRGB, alphaScale, dst.Texels + y * dst.RowPitch);
+            });
+        }
+
+        // The next level is filtered from this one, before its alpha is scaled
+        source.swap(dest);
+    }
+}
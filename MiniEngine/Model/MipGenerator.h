@@ -0,0 +1,53 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+
+#pragma once
+
+// Mip chain generation of 8-bit textures, so that ConvertToDDS() does not need DirectXTex or a device to generate
+// mips.  Texels are filtered as linear floats: sRGB colors are linearized first and encoded again per level.  Each
+// level is filtered from the previous one, separably, one destination row at a time: the taps of the source rows
+// are summed into a row buffer, 8 floats at a time with AVX2, and the row buffer is filtered horizontally.  Rows of
+// a level are split into bands that the threads take in turn.
+// This header does not depend on pch.h so that it can be shared with portable (non-D3D12) tools.
+
+#include <cstddef>
+#include <cstdint>
+
+enum class MipFilter : uint8_t
+{
+    kBox,       // Average of the texels that a destination texel covers
+    kKaiser,    // Kaiser-windowed sinc of 8 taps at 2:1, which keeps more detail than a box without its aliasing
+};
+
+struct MipOptions
+{
+    MipFilter Filter = MipFilter::kKaiser;
+    bool SRGB = false;          // Filter the colors in linear space.  Alpha is always linear.
+    bool NormalMap = false;     // Renormalize xyz, stored as UNORM (0 is -1), after filtering
+    bool Wrap = false;          // Wrap texels around the edges for tiling textures, or clamp to the edges
+    float AlphaCutoff = 0.0f;   // When positive, scale alpha per level so that as many texels pass the cutoff as in
+                                // level 0.  Without it, the cutouts of alpha-tested textures thin out with distance.
+    uint32_t ThreadCount = 0;   // 0 for one per core
+};
+
+// An R8G8B8A8_UNORM image, sRGB encoded for MipOptions::SRGB.
+struct MipImage
+{
+    uint8_t* Texels;
+    size_t RowPitch;
+    uint32_t Width;
+    uint32_t Height;
+};
+
+// Levels of a full chain down to 1x1, level 0 included.
+uint32_t GetMipCount(uint32_t width, uint32_t height);
+
+// Generates levels 1 to mipCount - 1 from level 0 into mips[1..mipCount).  Each level is half the size of the one
+// above, rounded down, and at least 1.  Level 0 is read only.
+void GenerateMips(const MipImage* mips, uint32_t mipCount, const MipOptions& options);
@@ -14,6 +14,7 @@
 #pragma once
 
 #include "Animation.h"
+#include "Meshlet.h"
 #include "../Core/GpuBuffer.h"
 #include "../Core/VectorMath.h"
 #include "../Core/Camera.h"
@@ -75,6 +76,8 @@ struct Mesh
         uint32_t primCount;   // Number of indices = 3 * number of triangles
         uint32_t startIndex;  // Offset to first index in index buffer 
         uint32_t baseVertex;  // Offset to first vertex in vertex buffer
+        uint32_t firstMeshlet; // Offset to first meshlet in Model::m_Meshlets
+        uint32_t numMeshlets;  // Meshlets covering the primCount indices, in index order
     };
     Draw draw[1];           // Actually 1 or more draws
 };
@@ -117,6 +120,7 @@ public:
     uint32_t m_NumMeshes;
     uint32_t m_NumAnimations;
     uint32_t m_NumJoints;
+    uint32_t m_NumMeshlets;
     std::unique_ptr<uint8_t[]> m_MeshData;
     std::unique_ptr<GraphNode[]> m_SceneGraph;
     std::vector<TextureRef> textures;
@@ -125,6 +129,7 @@ public:
     std::unique_ptr<AnimationSet[]> m_Animations;
     std::unique_ptr<uint16_t[]> m_JointIndices;
     std::unique_ptr<Math::Matrix4[]> m_JointIBMs;
+    std::unique_ptr<Meshlet[]> m_Meshlets;
 
 protected:
     void Destroy();
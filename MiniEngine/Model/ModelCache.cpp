@@ -0,0 +1,169 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+
+#include "ModelCache.h"
+#include "../Core/FileNameEncoding.h"
+#include "../Core/MappedFile.h"
+
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
+#else
+#include <cerrno>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+    // Prefixes every entry file
+    struct EntryHeader
+    {
+        char     id[4];         // "MCEN"
+        uint32_t version;
+        uint64_t key;
+        uint64_t size;          // Of the payload that follows
+        uint64_t payloadHash;
+    };
+
+    static_assert(sizeof(EntryHeader) == 32, "EntryHeader is tightly packed");
+
+    const uint32_t kEntryVersion = 1;
+
+#ifdef _WIN32
+    unsigned long CurrentProcessId()
+    {
+        return GetCurrentProcessId();
+    }
+
+    FILE* OpenForWriting(const std::string& path)
+    {
+        return _wfopen(Utility::ToWideFileName(path).c_str(), L"wb");
+    }
+
+    bool MoveIntoPlace(const std::string& from, const std::string& to)
+    {
+        return MoveFileExW(Utility::ToWideFileName(from).c_str(), Utility::ToWideFileName(to).c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+    }
+
+    void RemoveTempFile(const std::string& path)
+    {
+        _wremove(Utility::ToWideFileName(path).c_str());
+    }
+#else
+    unsigned long CurrentProcessId()
+    {
+        return (unsigned long)getpid();
+    }
+
+    FILE* OpenForWriting(const std::string& path)
+    {
+        return std::fopen(path.c_str(), "wb");
+    }
+
+    bool MoveIntoPlace(const std::string& from, const std::string& to)
+    {
+        return std::rename(from.c_str(), to.c_str()) == 0;
+    }
+
+    void RemoveTempFile(const std::string& path)
+    {
+        std::remove(path.c_str());
+    }
+#endif
+}
+
+ModelCache::ModelCache(const std::string& directory)
+    : m_Directory(directory)
+{
+    if (!m_Directory.empty() && m_Directory.back() != '/' && m_Directory.back() != '\\')
+        m_Directory += '/';
+}
+
+std::string ModelCache::GetFilePath(uint64_t key, const char* extension) const
+{
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx", (unsigned long long)key);
+    return m_Directory + name + extension;
+}
+
+bool ModelCache::MakeDirectory() const
+{
+    if (m_Directory.empty())
+        return true;
+
+    const std::string path = m_Directory.substr(0, m_Directory.size() - 1);
+#ifdef _WIN32
+    return CreateDirectoryW(Utility::ToWideFileName(path).c_str(), nullptr) != 0 || GetLastError() == ERROR_ALREADY_EXISTS;
+#else
+    return mkdir(path.c_str(), 0777) == 0 || errno == EEXIST;
+#endif
+}
+
+bool ModelCache::Load(uint64_t key, std::vector<uint8_t>& data) const
+{
+    Utility::MappedFile file;
+    if (!file.Open(GetFilePath(key, "")) || file.GetSize() < sizeof(EntryHeader))
+        return false;
+
+    EntryHeader header;
+    std::memcpy(&header, file.GetData(), sizeof(EntryHeader));
+    if (std::memcmp(header.id, "MCEN", 4) != 0 || header.version != kEntryVersion || header.key != key ||
+        header.size != file.GetSize() - sizeof(EntryHeader))
+    {
+        return false;
+    }
+
+    const uint8_t* payload = file.GetData() + sizeof(EntryHeader);
+    if (HashBytes(payload, (size_t)header.size) != header.payloadHash)
+        return false;
+
+    data.assign(payload, payload + header.size);
+    return true;
+}
+
+bool ModelCache::Store(uint64_t key, const void* data, size_t size) const
+{
+    if (!MakeDirectory())
+        return false;
+
+    EntryHeader header;
+    std::memcpy(header.id, "MCEN", 4);
+    header.version = kEntryVersion;
+    header.key = key;
+    header.size = size;
+    header.payloadHash = HashBytes(data, size);
+
+    // Writers of the same key are told apart by the process and a process-wide counter
+    static std::atomic<uint32_t> s_TempCounter(0);
+    char suffix[64];
+    std::snprintf(suffix, sizeof(suffix), ".%lx.%x.tmp", CurrentProcessId(), s_TempCounter++);
+
+    const std::string path = GetFilePath(key, "");
+    const std::string tempPath = path + suffix;
+
+    FILE* file = OpenForWriting(tempPath);
+    if (file == nullptr)
+        return false;
+
+    bool written = std::fwrite(&header, sizeof(header), 1, file) == 1 && (size == 0 || std::fwrite(data, size, 1, file) == 1);
+    written = std::fclose(file) == 0 && written;
+
+    if (!written || !MoveIntoPlace(tempPath, path))
+    {
+        RemoveTempFile(tempPath);
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,55 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+
+#pragma once
+
+// Content addressed cache of model conversion results.  Every entry is keyed by a hash of all of the inputs that
+// produced it (the source bytes, the converter version and the conversion options), so an entry is never stale:
+// an edited source simply maps to a new key and the old entry is no longer looked up.  Because keys do not depend
+// on file names or timestamps, touching a file does not cause a rebuild, and identical inputs share one entry.
+// Entries are written to a temporary file and renamed into place, so concurrent writers of the same key (on any
+// thread or in any process) never expose a partial entry.  Entries are not evicted; delete the directory to reclaim
+// the space of old ones.
+// This header does not depend on pch.h so that it can be shared with portable (non-D3D12) tools.
+
+#include "../Core/Hash.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// The content hash of Core, which keys the entries
+using Utility::ContentHash;
+using Utility::HashBytes;
+
+class ModelCache
+{
+public:
+    // directory is UTF-8 and is created when the first entry is stored
+    explicit ModelCache(const std::string& directory);
+
+    const std::string& GetDirectory() const { return m_Directory; }
+
+    // Replaces data with the entry of key.  Returns false if there is no entry or if it is damaged.
+    bool Load(uint64_t key, std::vector<uint8_t>& data) const;
+
+    // Writes the entry of key, replacing an existing one.  Safe to call concurrently.
+    bool Store(uint64_t key, const void* data, size_t size) const;
+
+    // The path of a file keyed by key, for results that other libraries write themselves (e.g. DDS textures).
+    // Such files should be written under another name and moved into place with a rename.
+    std::string GetFilePath(uint64_t key, const char* extension) const;
+
+    // Creates the directory if it does not exist yet.  Store() does this itself.
+    bool MakeDirectory() const;
+
+private:
+    std::string m_Directory;
+};
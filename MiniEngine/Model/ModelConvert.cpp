@@ -21,11 +21,13 @@
 #include "MeshConvert.h"
 #include "TextureManager.h"
 #include "GraphicsCommon.h"
+#include "GeometryCodec.h"
 #include "../Core/Utility.h"
 #include "../Core/Math/Common.h"
 
 #include <fstream>
 #include <map>
+#include <ppl.h>
 #include <unordered_map>
 
 using namespace DirectX;
@@ -42,18 +44,41 @@ static inline Vector3 SafeNormalize(Vector3 x)
 void Renderer::CompileMesh(
     std::vector<Mesh*>& meshList,
     std::vector<byte>& bufferMemory,
+    std::vector<Meshlet>& meshletList,
     glTF::Mesh& srcMesh,
     uint32_t matrixIdx,
     const Matrix4& localToObject,
     BoundingSphere& boundingSphere,
     AxisAlignedBox& boundingBox
     )
+{
+    std::vector<Primitive> primitives(srcMesh.primitives.size());
+    concurrency::parallel_for(size_t(0), primitives.size(), [&](size_t i)
+    {
+        OptimizeMesh(primitives[i], srcMesh.primitives[i], localToObject);
+    });
+
+    CompileMesh(meshList, bufferMemory, meshletList, srcMesh, matrixIdx, primitives.data(), boundingSphere, boundingBox);
+}
+
+void Renderer::CompileMesh(
+    std::vector<Mesh*>& meshList,
+    std::vector<byte>& bufferMemory,
+    std::vector<Meshlet>& meshletList,
+    const glTF::Mesh& srcMesh,
+    uint32_t matrixIdx,
+    Primitive* primitives,
+    BoundingSphere& boundingSphere,
+    AxisAlignedBox& boundingBox
+    )
 {
     // We still have a lot of work to do.  Now that we know about all of the primitives in this mesh
     // and have standardized their vertex buffer streams, we must set out to identify which primitives
     // have the same vertex format and material.  These can share a PSO and Vertex/Index buffer views.
     // There may be more than one draw call per group due to 16-bit indices.
 
+    const size_t numPrimitives = srcMesh.primitives.size();
+
     size_t totalVertexSize = 0;
     size_t totalDepthVertexSize = 0;
     size_t totalIndexSize = 0;
@@ -61,10 +86,8 @@ void Renderer::CompileMesh(
     BoundingSphere sphereOS(kZero);
     AxisAlignedBox bboxOS(kZero);
 
-    std::vector<Primitive> primitives(srcMesh.primitives.size());
-    for (uint32_t i = 0; i < primitives.size(); ++i)
+    for (size_t i = 0; i < numPrimitives; ++i)
     {
-        OptimizeMesh(primitives[i], srcMesh.primitives[i], localToObject);
         sphereOS = sphereOS.Union(primitives[i].m_BoundsOS);
         bboxOS.AddBoundingBox(primitives[i].m_BBoxOS);
     }
@@ -73,8 +96,9 @@ void Renderer::CompileMesh(
     boundingBox = bboxOS;
 
     std::map<uint32_t, std::vector<Primitive*>> renderMeshes;
-    for (auto& prim : primitives)
+    for (size_t i = 0; i < numPrimitives; ++i)
     {
+        Primitive& prim = primitives[i];
         uint32_t hash = prim.hash;
         renderMeshes[hash].push_back(&prim);
         totalVertexSize += prim.VB->size();
@@ -84,9 +108,11 @@ void Renderer::CompileMesh(
 
     uint32_t totalBufferSize = (uint32_t)(totalVertexSize + totalDepthVertexSize + totalIndexSize);
 
-    Utility::ByteArray stagingBuffer;
-    stagingBuffer.reset(new std::vector<byte>(totalBufferSize));
-    uint8_t* uploadMem = stagingBuffer->data();
+    // Write straight into the tail of the geometry blob.  Like the zero-filled staging buffer this replaces,
+    // resize() clears the alignment padding, so the output bytes do not change.
+    const uint32_t baseOffset = (uint32_t)bufferMemory.size();
+    bufferMemory.resize(bufferMemory.size() + totalBufferSize);
+    uint8_t* uploadMem = bufferMemory.data() + baseOffset;
 
     uint32_t curVBOffset = 0;
     uint32_t curDepthVBOffset = (uint32_t)totalVertexSize;
@@ -95,7 +121,11 @@ void Renderer::CompileMesh(
     for (auto& iter : renderMeshes)
     {
         size_t numDraws = iter.second.size();
-        Mesh* mesh = (Mesh*)malloc(sizeof(Mesh) + sizeof(Mesh::Draw) * (numDraws - 1));
+        // Zeroed because the descriptor table offsets are only assigned at load time, and the whole
+        // allocation (including padding) is written to the .mini file, which must be reproducible.
+        const size_t meshSize = sizeof(Mesh) + sizeof(Mesh::Draw) * (numDraws - 1);
+        Mesh* mesh = (Mesh*)malloc(meshSize);
+        std::memset(mesh, 0, meshSize);
         size_t vbSize = 0;
         size_t vbDepthSize = 0;
         size_t ibSize = 0;
@@ -115,11 +145,11 @@ void Renderer::CompileMesh(
         mesh->bounds[1] = collectiveSphere.GetCenter().GetY();
         mesh->bounds[2] = collectiveSphere.GetCenter().GetZ();
         mesh->bounds[3] = collectiveSphere.GetRadius();
-        mesh->vbOffset = (uint32_t)bufferMemory.size() + curVBOffset;
+        mesh->vbOffset = baseOffset + curVBOffset;
         mesh->vbSize = (uint32_t)vbSize;
-        mesh->vbDepthOffset = (uint32_t)bufferMemory.size() + curDepthVBOffset;
+        mesh->vbDepthOffset = baseOffset + curDepthVBOffset;
         mesh->vbDepthSize = (uint32_t)vbDepthSize;
-        mesh->ibOffset = (uint32_t)bufferMemory.size() + curIBOffset;
+        mesh->ibOffset = baseOffset + curIBOffset;
         mesh->ibSize = (uint32_t)ibSize;
         mesh->vbStride = (uint8_t)iter.second[0]->vertexStride;
         mesh->ibFormat = uint8_t(iter.second[0]->index32 ? DXGI_FORMAT_R32_UINT : DXGI_FORMAT_R16_UINT);
@@ -149,6 +179,9 @@ void Renderer::CompileMesh(
             d.primCount = draw->primCount;
             d.baseVertex = curVertOffset;
             d.startIndex = curIndexOffset;
+            d.firstMeshlet = (uint32_t)meshletList.size();
+            d.numMeshlets = (uint32_t)draw->meshlets.size();
+            meshletList.insert(meshletList.end(), draw->meshlets.begin(), draw->meshlets.end());
             std::memcpy(uploadMem + curVBOffset + curVertOffset, draw->VB->data(), draw->VB->size());
             curVertOffset += (uint32_t)draw->VB->size() / draw->vertexStride;
             std::memcpy(uploadMem + curDepthVBOffset, draw->DepthVB->data(), draw->DepthVB->size());
@@ -163,17 +196,21 @@ void Renderer::CompileMesh(
 
         meshList.push_back(mesh);
     }
-
-    bufferMemory.insert(bufferMemory.end(), stagingBuffer->begin(), stagingBuffer->end());
 }
 
 
+// A mesh referenced by a node of the scene graph, with the transform that places it in the model.
+struct MeshInstance
+{
+    Matrix4 localToObject;
+    const glTF::Mesh* mesh;
+    uint32_t matrixIdx;
+    uint32_t firstPrimitive; // index into the primitives of all instances, in scene graph order
+};
+
 static uint32_t WalkGraph(
     std::vector<GraphNode>& sceneGraph,
-    BoundingSphere& modelBSphere,
-    AxisAlignedBox& modelBBox,
-    std::vector<Mesh*>& meshList,
-    std::vector<byte>& bufferMemory,
+    std::vector<MeshInstance>& meshInstances,
     const std::vector<glTF::Node*>& siblings,
     uint32_t curPos,
     const Matrix4& xform
@@ -212,11 +249,12 @@ static uint32_t WalkGraph(
 
         if (!curNode->pointsToCamera && curNode->mesh != nullptr)
         {
-            BoundingSphere sphereOS;
-            AxisAlignedBox boxOS;
-            CompileMesh(meshList, bufferMemory, *curNode->mesh, curPos, LocalXform, sphereOS, boxOS);
-            modelBSphere = modelBSphere.Union(sphereOS);
-            modelBBox.AddBoundingBox(boxOS);
+            MeshInstance instance;
+            instance.localToObject = LocalXform;
+            instance.mesh = curNode->mesh;
+            instance.matrixIdx = curPos;
+            instance.firstPrimitive = 0;
+            meshInstances.push_back(instance);
         }
 
         uint32_t nextPos = curPos + 1;
@@ -224,7 +262,7 @@ static uint32_t WalkGraph(
         if (curNode->children.size() > 0)
         {
             thisGraphNode.hasChildren = 1;
-            nextPos = WalkGraph(sceneGraph, modelBSphere, modelBBox, meshList, bufferMemory, curNode->children, nextPos, LocalXform);
+            nextPos = WalkGraph(sceneGraph, meshInstances, curNode->children, nextPos, LocalXform);
         }
 
         // Are there more siblings?
@@ -239,11 +277,6 @@ static uint32_t WalkGraph(
     return curPos;
 }
 
-inline void CompileTexture(const std::wstring& basePath, const std::string& fileName, uint8_t flags)
-{
-    CompileTextureOnDemand(basePath + Utility::UTF8ToWideString(fileName), flags);
-}
-
 inline void SetTextureOptions(std::map<std::string, uint8_t>& optionsMap, glTF::Texture* texture, uint8_t options)
 {
     if (texture && texture->source && optionsMap.find(texture->source->path) == optionsMap.end())
@@ -313,7 +346,7 @@ void BuildMaterials(ModelData& model, const glTF::Asset& asset)
             }
         }
 
-        SetTextureOptions(textureOptions, srcMat.textures[kBaseColor], TextureOptions(true, srcMat.alphaBlend | srcMat.alphaTest));
+        SetTextureOptions(textureOptions, srcMat.textures[kBaseColor], TextureOptions(true, srcMat.alphaBlend | srcMat.alphaTest, false, srcMat.alphaTest));
         SetTextureOptions(textureOptions, srcMat.textures[kMetallicRoughness], TextureOptions(false));
         SetTextureOptions(textureOptions, srcMat.textures[kOcclusion], TextureOptions(false));
         SetTextureOptions(textureOptions, srcMat.textures[kEmissive], TextureOptions(true));
@@ -325,10 +358,7 @@ void BuildMaterials(ModelData& model, const glTF::Asset& asset)
     {
         auto iter = textureOptions.find(name);
         if (iter != textureOptions.end())
-        {
             model.m_TextureOptions.push_back(iter->second);
-            CompileTextureOnDemand(asset.m_basePath + Utility::UTF8ToWideString(iter->first), iter->second);
-        }
         else
             model.m_TextureOptions.push_back(0xFF);
     }
@@ -441,7 +471,7 @@ void BuildSkins(ModelData& model, const glTF::Asset& asset)
     }
 }
 
-bool Renderer::BuildModel(ModelData& model, const glTF::Asset& asset, int sceneIdx)
+bool Renderer::BuildModel(ModelData& model, const glTF::Asset& asset, int sceneIdx, const ModelCache* cache)
 {
     BuildMaterials(model, asset);
 
@@ -451,13 +481,65 @@ bool Renderer::BuildModel(ModelData& model, const glTF::Asset& asset, int sceneI
     if (scene == nullptr)
         return false;
 
-    // Aggregate all of the vertex and index buffers in this unified buffer
+    // Flatten the scene graph and collect the mesh instances in traversal order
+    std::vector<MeshInstance> meshInstances;
+    uint32_t numNodes = WalkGraph(model.m_SceneGraph, meshInstances, scene->nodes, 0, Matrix4(kIdentity));
+    model.m_SceneGraph.resize(numNodes);
+
+    uint32_t numPrimitives = 0;
+    for (MeshInstance& instance : meshInstances)
+    {
+        instance.firstPrimitive = numPrimitives;
+        numPrimitives += (uint32_t)instance.mesh->primitives.size();
+    }
+
+    std::vector<const MeshInstance*> primitiveInstances(numPrimitives);
+    for (const MeshInstance& instance : meshInstances)
+    {
+        for (uint32_t i = 0; i < (uint32_t)instance.mesh->primitives.size(); ++i)
+            primitiveInstances[instance.firstPrimitive + i] = &instance;
+    }
+
+    // Converting and vertex cache optimizing the primitives is where the time goes, and every primitive
+    // is independent, so they all go to the worker threads at once, each into buffers of its own.  Those
+    // found in the cache are only read back.
+    std::vector<Primitive> primitives(numPrimitives);
+    concurrency::parallel_for(uint32_t(0), numPrimitives, [&](uint32_t primIdx)
+    {
+        const MeshInstance& instance = *primitiveInstances[primIdx];
+        OptimizeMesh(primitives[primIdx], instance.mesh->primitives[primIdx - instance.firstPrimitive], instance.localToObject, cache);
+    });
+
+    // Aggregate all of the vertex and index buffers in this unified buffer.  Packing is serial and in scene
+    // graph order, so the layout does not depend on how the work above was scheduled.
     std::vector<byte>& bufferMemory = model.m_GeometryData;
 
+    size_t geometrySize = bufferMemory.size();
+    for (const Primitive& prim : primitives)
+        geometrySize += prim.VB->size() + prim.DepthVB->size() + Math::AlignUp(prim.IB->size(), 4);
+    bufferMemory.reserve(geometrySize);
+
     model.m_BoundingSphere = BoundingSphere(kZero);
     model.m_BoundingBox = AxisAlignedBox(kZero);
-    uint32_t numNodes = WalkGraph(model.m_SceneGraph, model.m_BoundingSphere, model.m_BoundingBox, model.m_Meshes, bufferMemory, scene->nodes, 0, Matrix4(kIdentity));
-    model.m_SceneGraph.resize(numNodes);
+    for (const MeshInstance& instance : meshInstances)
+    {
+        Primitive* meshPrimitives = primitives.data() + instance.firstPrimitive;
+
+        BoundingSphere sphereOS;
+        AxisAlignedBox boxOS;
+        CompileMesh(model.m_Meshes, bufferMemory, model.m_Meshlets, *instance.mesh, instance.matrixIdx, meshPrimitives, sphereOS, boxOS);
+        model.m_BoundingSphere = model.m_BoundingSphere.Union(sphereOS);
+        model.m_BoundingBox.AddBoundingBox(boxOS);
+
+        // The packed copies are all that is needed from here on
+        for (size_t i = 0; i < instance.mesh->primitives.size(); ++i)
+        {
+            meshPrimitives[i].VB.reset();
+            meshPrimitives[i].IB.reset();
+            meshPrimitives[i].DepthVB.reset();
+            std::vector<Meshlet>().swap(meshPrimitives[i].meshlets);
+        }
+    }
 
     BuildAnimations(model, asset);
     BuildSkins(model, asset);
@@ -465,7 +547,44 @@ bool Renderer::BuildModel(ModelData& model, const glTF::Asset& asset, int sceneI
     return true;
 }
 
-bool Renderer::SaveModel(const std::wstring& filePath, const ModelData& data)
+// Splits the geometry into chunks of the vertex and index buffers of the meshes and encodes them in parallel
+static void CompressGeometry(const ModelData& data, std::vector<GeometryChunk>& chunks, std::vector<byte>& payload)
+{
+    std::vector<GeometryRegion> regions;
+    regions.reserve(data.m_Meshes.size() * 3);
+    for (const Mesh* mesh : data.m_Meshes)
+    {
+        const uint32_t vertexCount = mesh->vbStride > 0 ? mesh->vbSize / mesh->vbStride : 0;
+        regions.push_back({ mesh->vbOffset, mesh->vbSize, mesh->vbStride, GeometryStreamType::kVertex });
+        if (vertexCount > 0)
+            regions.push_back({ mesh->vbDepthOffset, mesh->vbDepthSize, mesh->vbDepthSize / vertexCount, GeometryStreamType::kVertex });
+        regions.push_back({ mesh->ibOffset, mesh->ibSize, 0,
+            mesh->ibFormat == DXGI_FORMAT_R32_UINT ? GeometryStreamType::kIndex32 : GeometryStreamType::kIndex16 });
+    }
+
+    SplitGeometryChunks(data.m_GeometryData.size(), std::move(regions), chunks);
+
+    std::vector<std::vector<uint8_t>> encodedChunks(chunks.size());
+    concurrency::parallel_for(size_t(0), chunks.size(), [&](size_t i)
+    {
+        EncodeGeometryChunk(chunks[i], data.m_GeometryData.data(), encodedChunks[i]);
+    });
+
+    size_t payloadSize = 0;
+    for (const std::vector<uint8_t>& encoded : encodedChunks)
+        payloadSize += encoded.size();
+    payload.clear();
+    payload.reserve(payloadSize);
+
+    for (size_t i = 0; i < chunks.size(); ++i)
+    {
+        chunks[i].encodedOffset = (uint32_t)payload.size();
+        chunks[i].encodedSize = (uint32_t)encodedChunks[i].size();
+        payload.insert(payload.end(), encodedChunks[i].begin(), encodedChunks[i].end());
+    }
+}
+
+bool Renderer::SaveModel(const std::wstring& filePath, const ModelData& data, bool compressGeometry)
 {
     std::ofstream outFile(filePath, std::ios::out | std::ios::binary);
     if (!outFile)
@@ -474,6 +593,7 @@ bool Renderer::SaveModel(const std::wstring& filePath, const ModelData& data)
     FileHeader header;
     std::memcpy(header.id, "MINI", 4);
     header.version = CURRENT_MINI_FILE_VERSION;
+    header.sourceKey = data.m_SourceKey;
     header.numNodes = (uint32_t)data.m_SceneGraph.size();
     header.numMeshes = (uint32_t)data.m_Meshes.size();
     header.numMaterials = (uint32_t)data.m_MaterialConstants.size();
@@ -489,6 +609,9 @@ bool Renderer::SaveModel(const std::wstring& filePath, const ModelData& data)
     header.numAnimationCurves = (uint32_t)data.m_AnimationCurves.size();
     header.numAnimations = (uint32_t)data.m_Animations.size();
     header.numJoints = (uint32_t)data.m_JointIndices.size();
+    header.numMeshlets = (uint32_t)data.m_Meshlets.size();
+    header.numGeometryChunks = 0;
+    header.encodedGeometrySize = 0;
     header.boundingSphere[0] = data.m_BoundingSphere.GetCenter().GetX();
     header.boundingSphere[1] = data.m_BoundingSphere.GetCenter().GetY();
     header.boundingSphere[2] = data.m_BoundingSphere.GetCenter().GetZ();
@@ -500,8 +623,25 @@ bool Renderer::SaveModel(const std::wstring& filePath, const ModelData& data)
     header.maxPos[1] = data.m_BoundingBox.GetMax().GetY();
     header.maxPos[2] = data.m_BoundingBox.GetMax().GetZ();
 
+    std::vector<GeometryChunk> geometryChunks;
+    std::vector<byte> encodedGeometry;
+    if (compressGeometry && header.geometrySize > 0)
+    {
+        CompressGeometry(data, geometryChunks, encodedGeometry);
+        header.numGeometryChunks = (uint32_t)geometryChunks.size();
+        header.encodedGeometrySize = (uint32_t)encodedGeometry.size();
+    }
+
     outFile.write((char*)&header, sizeof(FileHeader));
-    outFile.write((char*)data.m_GeometryData.data(), header.geometrySize);
+    if (header.numGeometryChunks > 0)
+    {
+        outFile.write((char*)geometryChunks.data(), header.numGeometryChunks * sizeof(GeometryChunk));
+        outFile.write((char*)encodedGeometry.data(), header.encodedGeometrySize);
+    }
+    else
+    {
+        outFile.write((char*)data.m_GeometryData.data(), header.geometrySize);
+    }
     outFile.write((char*)data.m_SceneGraph.data(), header.numNodes * sizeof(GraphNode));
     for (const Mesh* mesh : data.m_Meshes)
         outFile.write((char*)mesh, sizeof(Mesh) + (mesh->numDraws - 1) * sizeof(Mesh::Draw));
@@ -530,5 +670,7 @@ bool Renderer::SaveModel(const std::wstring& filePath, const ModelData& data)
         outFile.write((char*)data.m_JointIBMs.data(), header.numJoints * sizeof(Matrix4));
     }
 
+    outFile.write((char*)data.m_Meshlets.data(), header.numMeshlets * sizeof(Meshlet));
+
     return true;
 }
@@ -34,12 +34,6 @@ namespace Renderer
 }
 
 ModelH3D::ModelH3D()
-    : m_pMesh(nullptr)
-    , m_pMaterial(nullptr)
-    , m_pVertexData(nullptr)
-    , m_pIndexData(nullptr)
-    , m_pVertexDataDepth(nullptr)
-    , m_pIndexDataDepth(nullptr)
 {
     Clear();
 }
@@ -53,105 +47,18 @@ void ModelH3D::Clear()
 {
     m_GeometryBuffer.Destroy();
 
-    delete [] m_pMesh;
-    m_pMesh = nullptr;
-    m_Header.meshCount = 0;
-
-    delete [] m_pMaterial;
-    m_pMaterial = nullptr;
-    m_Header.materialCount = 0;
-
-    delete [] m_pVertexData;
-    delete [] m_pIndexData;
-    delete [] m_pVertexDataDepth;
-    delete [] m_pIndexDataDepth;
-
-    m_pVertexData = nullptr;
-    m_Header.vertexDataByteSize = 0;
-    m_pIndexData = nullptr;
-    m_Header.indexDataByteSize = 0;
-    m_pVertexDataDepth = nullptr;
-    m_Header.vertexDataByteSizeDepth = 0;
-    m_pIndexDataDepth = nullptr;
+    H3DData::Clear();
 
     m_TextureReferences.clear();
-
-    m_Header.boundingBox = AxisAlignedBox();
-}
-
-// assuming at least 3 floats for position
-void ModelH3D::ComputeMeshBoundingBox(uint32_t meshIndex, AxisAlignedBox& bbox) const
-{
-    const Mesh *mesh = m_pMesh + meshIndex;
-
-    bbox = AxisAlignedBox();
-
-    if (mesh->vertexCount > 0)
-    {
-        uint32_t vertexStride = mesh->vertexStride;
-
-        const float *p = (float*)(m_pVertexData + mesh->vertexDataByteOffset + mesh->attrib[attrib_position].offset);
-        const float *pEnd = (float*)(m_pVertexData + mesh->vertexDataByteOffset + mesh->vertexCount * mesh->vertexStride + mesh->attrib[attrib_position].offset);
-
-        while (p < pEnd)
-        {
-            Vector3 pos(*(p + 0), *(p + 1), *(p + 2));
-
-            bbox.AddPoint(pos);
-
-            (*(uint8_t**)&p) += vertexStride;
-        }
-    }
-}
-
-void ModelH3D::ComputeGlobalBoundingBox(AxisAlignedBox &bbox) const
-{
-    bbox = AxisAlignedBox();
-
-    if (m_Header.meshCount > 0)
-    {
-        for (uint32_t meshIndex = 0; meshIndex < m_Header.meshCount; meshIndex++)
-        {
-            const Mesh *mesh = m_pMesh + meshIndex;
-            bbox.AddBoundingBox(mesh->boundingBox);
-        }
-    }
-}
-
-void ModelH3D::ComputeAllBoundingBoxes()
-{
-    for (uint32_t meshIndex = 0; meshIndex < m_Header.meshCount; meshIndex++)
-    {
-        Mesh *mesh = m_pMesh + meshIndex;
-        ComputeMeshBoundingBox(meshIndex, mesh->boundingBox);
-    }
-    ComputeGlobalBoundingBox(m_Header.boundingBox);
 }
 
 bool ModelH3D::LoadH3D(const wstring& filename)
 {
-    std::ifstream file(filename, ios::in | ios::binary);
+    Clear();
 
-    file.read((char*)&m_Header, sizeof(Header));
-    if (!file)
+    if (!H3DData::Load(filename))
         return false;
 
-    m_pMesh = new Mesh[m_Header.meshCount];
-    m_pMaterial = new Material[m_Header.materialCount];
-
-    if (m_Header.meshCount > 0)
-    {
-        file.read((char*)m_pMesh, sizeof(Mesh) * m_Header.meshCount);
-        if (!file)
-            return false;
-    }
-    if (m_Header.materialCount > 0)
-    {
-        file.read((char*)m_pMaterial, sizeof(Material) * m_Header.materialCount);
-        if (!file)
-            return false;
-    }
-
     m_VertexStride = m_pMesh[0].vertexStride;
     m_VertexStrideDepth = m_pMesh[0].vertexStrideDepth;
 #if _DEBUG
@@ -179,53 +86,20 @@ bool ModelH3D::LoadH3D(const wstring& filename)
     }
 #endif
 
-    UploadBuffer geomBuffer;
-
-    uint32_t totalBinarySize = m_Header.vertexDataByteSize
-        + m_Header.indexDataByteSize
-        + m_Header.vertexDataByteSizeDepth
-        + m_Header.indexDataByteSize;
+    // The four geometry sections are contiguous in the file, so they are uploaded with a single copy straight from the mapping.
+    const uint32_t totalBinarySize = static_cast<uint32_t>(GetGeometryDataByteSize());
 
+    UploadBuffer geomBuffer;
     geomBuffer.Create(L"Geometry Upload Buffer", totalBinarySize);
-    uint8_t* uploadMem = (uint8_t*)geomBuffer.Map();
-
-    m_pVertexData = uploadMem;
-    m_pIndexData = m_pVertexData + m_Header.vertexDataByteSize;
-    m_pVertexDataDepth = m_pIndexData + m_Header.indexDataByteSize;
-    m_pIndexDataDepth = m_pVertexDataDepth + m_Header.vertexDataByteSizeDepth;
-
-    if (m_Header.vertexDataByteSize > 0 && !file.read((char*)m_pVertexData, m_Header.vertexDataByteSize))
-        return false;
-    if (m_Header.indexDataByteSize > 0 && !file.read((char*)m_pIndexData, m_Header.indexDataByteSize))
-        return false;
-
-    if (m_Header.vertexDataByteSizeDepth > 0 && !file.read((char*)m_pVertexDataDepth, m_Header.vertexDataByteSizeDepth))
-        return false;
-    if (m_Header.indexDataByteSize > 0 && !file.read((char*)m_pIndexDataDepth, m_Header.indexDataByteSize))
-        return false;
+    std::memcpy(geomBuffer.Map(), GetGeometryData(), totalBinarySize);
+    geomBuffer.Unmap();
 
     m_GeometryBuffer.Create(L"Geometry Buffer", totalBinarySize, 1, geomBuffer);
 
     m_VertexBuffer = m_GeometryBuffer.VertexBufferView(0, m_Header.vertexDataByteSize, m_VertexStride);
     m_IndexBuffer = m_GeometryBuffer.IndexBufferView(m_pIndexData - m_pVertexData, m_Header.indexDataByteSize, false);
-    m_VertexBufferDepth = m_GeometryBuffer.VertexBufferView(m_pVertexDataDepth - m_pVertexData, m_Header.vertexDataByteSizeDepth, m_VertexStride);
-    m_IndexBufferDepth = m_GeometryBuffer.IndexBufferView(m_pIndexDataDepth - m_pVertexData, m_Header.indexDataByteSize, false);
-
-    m_pVertexData = new unsigned char[m_Header.vertexDataByteSize];
-    m_pIndexData = new unsigned char[m_Header.indexDataByteSize];
-    m_pVertexDataDepth = new unsigned char[m_Header.vertexDataByteSizeDepth];
-    m_pIndexDataDepth = new unsigned char[m_Header.indexDataByteSize];
-
-    std::memcpy(m_pVertexData, uploadMem, m_Header.vertexDataByteSize);
-    uploadMem += m_Header.vertexDataByteSize;
-    std::memcpy(m_pIndexData, uploadMem, m_Header.indexDataByteSize);
-    uploadMem += m_Header.indexDataByteSize;
-    std::memcpy(m_pVertexDataDepth, uploadMem, m_Header.vertexDataByteSizeDepth);
-    uploadMem += m_Header.vertexDataByteSizeDepth;
-    std::memcpy(m_pIndexDataDepth, uploadMem, m_Header.indexDataByteSize);
-
-    geomBuffer.Unmap();
-
+    m_VertexBufferDepth = m_GeometryBuffer.VertexBufferView(m_pVertexDataDepth - m_pVertexData, m_Header.vertexDataByteSizeDepth, m_VertexStrideDepth);
+    m_IndexBufferDepth = m_GeometryBuffer.IndexBufferView(m_pIndexDataDepth - m_pVertexData, GetIndexDataByteSizeDepth(), false);
 
     LoadTextures(Utility::GetBasePath(filename));
 
@@ -264,7 +138,7 @@ bool ModelH3D::SaveH3D(const wstring& filename) const
     if (!file)
         return false;
 
-    if (!file.write((char*)&m_Header, sizeof(Header)))
+    if (!file.write((const char*)&m_Header, sizeof(Header)))
         return false;
 
     if (m_Header.meshCount > 0 && !file.write((const char*)m_pMesh, sizeof(Mesh) * m_Header.meshCount))
@@ -274,19 +148,19 @@ bool ModelH3D::SaveH3D(const wstring& filename) const
         return false;
 
     if (m_pVertexData != nullptr && m_Header.vertexDataByteSize > 0 &&
-        !file.write((char*)m_pVertexData, m_Header.vertexDataByteSize))
+        !file.write((const char*)m_pVertexData, m_Header.vertexDataByteSize))
         return false;
 
     if (m_pIndexData != nullptr && m_Header.indexDataByteSize > 0 &&
-        !file.write((char*)m_pIndexData, m_Header.indexDataByteSize))
+        !file.write((const char*)m_pIndexData, m_Header.indexDataByteSize))
         return false;
 
     if (m_pVertexDataDepth != nullptr && m_Header.vertexDataByteSizeDepth > 0 &&
-        !file.write((char*)m_pVertexDataDepth, m_Header.vertexDataByteSizeDepth))
+        !file.write((const char*)m_pVertexDataDepth, m_Header.vertexDataByteSizeDepth))
         return false;
 
-    if (m_pIndexDataDepth != nullptr && m_Header.indexDataByteSize > 0 &&
-        !file.write((char*)m_pIndexDataDepth, m_Header.indexDataByteSize))
+    if (m_pIndexDataDepth != nullptr && GetIndexDataByteSizeDepth() > 0 &&
+        !file.write((const char*)m_pIndexDataDepth, GetIndexDataByteSizeDepth()))
         return false;
 
     return true;
@@ -22,8 +22,13 @@
 #include "TextureManager.h"
 #include "TextureConvert.h"
 #include "GraphicsCommon.h"
+#include "GeometryCodec.h"
+#include "ModelCache.h"
+#include "../Core/MappedFile.h"
 
-#include <fstream>
+#include <atomic>
+#include <istream>
+#include <ppl.h>
 #include <unordered_map>
 
 using namespace Renderer;
@@ -43,21 +48,31 @@ void LoadMaterials(Model& model,
     const std::vector<MaterialTextureData>& materialTextures,
     const std::vector<std::wstring>& textureNames,
     const std::vector<uint8_t>& textureOptions,
-    const std::wstring& basePath)
+    const std::wstring& basePath,
+    const ModelCache& cache)
 {
     static_assert((_alignof(MaterialConstants) & 255) == 0, "CBVs need 256 byte alignment");
 
-    // Load textures
+    // Textures are independent cache entries, so the ones that need converting are converted in parallel.
+    // The worker threads join the multithreaded apartment of the main thread (see GameCore), which WIC needs.
     const uint32_t numTextures = (uint32_t)textureNames.size();
-    model.textures.resize(numTextures);
-    for (size_t ti = 0; ti < numTextures; ++ti)
+    std::vector<std::wstring> ddsFiles(numTextures);
+    concurrency::parallel_for(uint32_t(0), numTextures, [&](uint32_t ti)
     {
-        std::wstring originalFile = basePath + textureNames[ti];
-        CompileTextureOnDemand(originalFile, textureOptions[ti]);
+        ddsFiles[ti] = CompileTextureOnDemand(basePath + textureNames[ti], textureOptions[ti], cache);
+    });
 
-        std::wstring ddsFile = Utility::RemoveExtension(originalFile) + L".dds";
-        model.textures[ti] = TextureManager::LoadDDSFromFile(ddsFile);
-    }
+    // Load textures.  The texture cache does not serialize loads, so they run in parallel, and the files of the
+    // textures that are not loaded yet are read ahead so that the I/O threads stay busy while the loaders create
+    // resources.
+    for (uint32_t ti = 0; ti < numTextures; ++ti)
+        TextureManager::ReadAhead(ddsFiles[ti]);
+
+    model.textures.resize(numTextures);
+    concurrency::parallel_for(uint32_t(0), numTextures, [&](uint32_t ti)
+    {
+        model.textures[ti] = TextureManager::LoadDDSFromFile(ddsFiles[ti]);
+    });
 
     // Generate descriptor tables and record offsets for each material
     const uint32_t numMaterials = (uint32_t)materialTextures.size();
@@ -134,18 +149,85 @@ void LoadMaterials(Model& model,
     }
 }
 
+// Reads a .mini file from memory.  The whole file comes from ReadFileSync(), so a "<name>.mini.gz" is loaded when
+// there is no .mini file.
+struct MiniFileBuffer : std::streambuf
+{
+    void Load(const std::wstring& fileName)
+    {
+        m_Data = Utility::ReadFileSync(fileName);
+        char* begin = (char*)m_Data->data();
+        setg(begin, begin, begin + m_Data->size());
+    }
+
+    Utility::ByteArray m_Data;
+};
+
+// Hashes the source files of a model along with the converter, which is versioned by the .mini file format
+static uint64_t SourceKey(const Utility::MappedFile* files, size_t numFiles)
+{
+    ContentHash hash(CURRENT_MINI_FILE_VERSION);
+    for (size_t i = 0; i < numFiles; ++i)
+    {
+        hash.UpdateValue((uint64_t)files[i].GetSize());
+        hash.Update(files[i].GetData(), files[i].GetSize());
+    }
+    return hash.Finish();
+}
+
 std::shared_ptr<Model> Renderer::LoadModel(const std::wstring& filePath, bool forceRebuild)
 {
     const std::wstring miniFileName = Utility::RemoveExtension(filePath) + L".mini";
     const std::wstring fileName = Utility::RemoveBasePath(filePath);
+    const std::wstring fileExt = Utility::ToLower(Utility::GetFileExtension(filePath));
+    const std::wstring basePath = Utility::GetBasePath(filePath);
+    const ModelCache cache(Utility::ToUTF8FileName(basePath + L"ModelCache"));
 
-    struct _stat64 sourceFileStat;
-    struct _stat64 miniFileStat;
-    std::ifstream inFile;
+    MiniFileBuffer miniFile;
+    std::istream inFile(&miniFile);
     FileHeader header;
 
+    auto readMiniFileHeader = [&]()
+    {
+        miniFile.Load(miniFileName);
+        inFile.clear();
+        inFile.read((char*)&header, sizeof(FileHeader));
+    };
+
+    // The .mini file is keyed by the content of the source files rather than by their timestamps, so that it is
+    // rebuilt when a buffer file of a glTF changes and not when a file is merely touched.  The source files are
+    // only mapped and hashed here; the asset is parsed when the .mini file has to be rebuilt.
+    struct _stat64 sourceFileStat;
+    struct _stat64 miniFileStat;
     bool sourceFileMissing = _wstat64(filePath.c_str(), &sourceFileStat) == -1;
-    bool miniFileMissing = _wstat64(miniFileName.c_str(), &miniFileStat) == -1;
+    bool miniFileMissing = _wstat64(miniFileName.c_str(), &miniFileStat) == -1 &&
+        _wstat64((miniFileName + L".gz").c_str(), &miniFileStat) == -1;
+    const bool isGLTF = fileExt == L"gltf" || fileExt == L"glb";
+    const bool isH3D = fileExt == L"h3d";
+
+    uint64_t sourceKey = 0;
+
+    if (!sourceFileMissing && isGLTF)
+    {
+        std::vector<Utility::MappedFile> sourceFiles;
+        if (glTF::Asset::MapSourceFiles(filePath, sourceFiles))
+            sourceKey = SourceKey(sourceFiles.data(), sourceFiles.size());
+        else
+            sourceFileMissing = true;
+    }
+    else if (!sourceFileMissing && isH3D)
+    {
+        Utility::MappedFile sourceFile;
+        if (sourceFile.Open(filePath))
+            sourceKey = SourceKey(&sourceFile, 1);
+        else
+            sourceFileMissing = true;
+    }
+    else if (!sourceFileMissing && !miniFileMissing)
+    {
+        // Not a source format (e.g. the .mini file itself), so the .mini file is used as it is
+        sourceFileMissing = true;
+    }
 
     if (sourceFileMissing)
         forceRebuild = false;
@@ -156,22 +238,21 @@ std::shared_ptr<Model> Renderer::LoadModel(const std::wstring& filePath, bool fo
         return nullptr;
     }
 
-    bool needBuild = forceRebuild;
-
-    // Check if .mini file exists and it is newer than source file
-    if (miniFileMissing || !sourceFileMissing && sourceFileStat.st_mtime > miniFileStat.st_mtime)
-        needBuild = true;
+    bool needBuild = forceRebuild || miniFileMissing;
 
-    // Check if it's an older version of .mini
+    // Check if it's an older version of .mini or if it was built from other source data
     if (!needBuild)
     {
-        inFile = std::ifstream(miniFileName, std::ios::in | std::ios::binary);
-        inFile.read((char*)&header, sizeof(FileHeader));
+        readMiniFileHeader();
         if (strncmp(header.id, "MINI", 4) != 0 || header.version != CURRENT_MINI_FILE_VERSION)
         {
             Utility::Printf("Model version deprecated.  Rebuilding %ws...\n", fileName.c_str());
             needBuild = true;
-            inFile.close();
+        }
+        else if (!sourceFileMissing && header.sourceKey != sourceKey)
+        {
+            Utility::Printf("Model source changed.  Rebuilding %ws...\n", fileName.c_str());
+            needBuild = true;
         }
     }
 
@@ -185,19 +266,16 @@ std::shared_ptr<Model> Renderer::LoadModel(const std::wstring& filePath, bool fo
 
         ModelData modelData;
 
-        const std::wstring fileExt = Utility::ToLower(Utility::GetFileExtension(filePath));
-
-        if (fileExt == L"gltf" || fileExt == L"glb")
+        if (isGLTF)
         {
             glTF::Asset asset(filePath);
-            if (!BuildModel(modelData, asset))
+            if (!BuildModel(modelData, asset, -1, &cache))
                 return nullptr;
         }
-        else if (fileExt == L"h3d")
+        else if (isH3D)
         {
             ModelH3D modelh3d;
-            const std::wstring basePath = Utility::GetBasePath(filePath);
-            if (!modelh3d.Load(filePath) || !modelh3d.BuildModel(modelData, basePath))
+            if (!modelh3d.Load(filePath) || !modelh3d.BuildModel(modelData, basePath, &cache))
                 return nullptr;
         }
         else
@@ -206,11 +284,11 @@ std::shared_ptr<Model> Renderer::LoadModel(const std::wstring& filePath, bool fo
             return nullptr;
         }
 
+        modelData.m_SourceKey = sourceKey;
         if (!SaveModel(miniFileName, modelData))
             return nullptr;
 
-        inFile = std::ifstream(miniFileName, std::ios::in | std::ios::binary);
-        inFile.read((char*)&header, sizeof(FileHeader));
+        readMiniFileHeader();
     }
 
     if (!inFile)
@@ -218,8 +296,6 @@ std::shared_ptr<Model> Renderer::LoadModel(const std::wstring& filePath, bool fo
 
     ASSERT(strncmp(header.id, "MINI", 4) == 0 && header.version == CURRENT_MINI_FILE_VERSION);
 
-    std::wstring basePath = Utility::GetBasePath(filePath);
-
     std::shared_ptr<Model> model(new Model);
 
     model->m_NumNodes = header.numNodes;
@@ -231,8 +307,38 @@ std::shared_ptr<Model> Renderer::LoadModel(const std::wstring& filePath, bool fo
 	{
 		UploadBuffer modelData;
 		modelData.Create(L"Model Data Upload", header.geometrySize);
-		inFile.read((char*)modelData.Map(), header.geometrySize);
-		modelData.Unmap();
+		if (header.numGeometryChunks > 0)
+		{
+			std::vector<GeometryChunk> chunks(header.numGeometryChunks);
+			std::vector<byte> payload(header.encodedGeometrySize);
+			inFile.read((char*)chunks.data(), header.numGeometryChunks * sizeof(GeometryChunk));
+			inFile.read((char*)payload.data(), header.encodedGeometrySize);
+
+			// Chunks decode straight into the upload heap, which they only write to
+			byte* geometry = (byte*)modelData.Map();
+			std::atomic<bool> decoded(!!inFile);
+			concurrency::parallel_for(uint32_t(0), header.numGeometryChunks, [&](uint32_t i)
+			{
+				const GeometryChunk& chunk = chunks[i];
+				if (size_t(chunk.offset) + chunk.size > header.geometrySize ||
+					!DecodeGeometryChunk(chunk, payload.data(), payload.size(), geometry))
+				{
+					decoded = false;
+				}
+			});
+			modelData.Unmap();
+
+			if (!decoded)
+			{
+				Utility::Printf("Error: Corrupt geometry in %ws\n", miniFileName.c_str());
+				return nullptr;
+			}
+		}
+		else
+		{
+			inFile.read((char*)modelData.Map(), header.geometrySize);
+			modelData.Unmap();
+		}
 		model->m_DataBuffer.Create(L"Model Data", header.geometrySize, 1, modelData);
 	}
 
@@ -268,7 +374,7 @@ std::shared_ptr<Model> Renderer::LoadModel(const std::wstring& filePath, bool fo
     std::vector<uint8_t> textureOptions(header.numTextures);
     inFile.read((char*)textureOptions.data(), header.numTextures * sizeof(uint8_t));
 
-    LoadMaterials(*model, materialTextures, textureNames, textureOptions, basePath);
+    LoadMaterials(*model, materialTextures, textureNames, textureOptions, basePath, cache);
 
     model->m_BoundingSphere = BoundingSphere(*(XMFLOAT4*)header.boundingSphere);
     model->m_BoundingBox = AxisAlignedBox(Vector3(*(XMFLOAT3*)header.minPos), Vector3(*(XMFLOAT3*)header.maxPos));
@@ -297,5 +403,13 @@ std::shared_ptr<Model> Renderer::LoadModel(const std::wstring& filePath, bool fo
         inFile.read((char*)model->m_JointIBMs.get(), header.numJoints * sizeof(Matrix4));
     }
 
+    model->m_NumMeshlets = header.numMeshlets;
+
+    if (header.numMeshlets > 0)
+    {
+        model->m_Meshlets.reset(new Meshlet[header.numMeshlets]);
+        inFile.read((char*)model->m_Meshlets.get(), header.numMeshlets * sizeof(Meshlet));
+    }
+
     return model;
 }
@@ -23,8 +23,9 @@
 #include <vector>
 
 namespace glTF { class Asset; struct Mesh; }
+class ModelCache;
 
-#define CURRENT_MINI_FILE_VERSION 13
+#define CURRENT_MINI_FILE_VERSION 17
 
 namespace Renderer
 {
@@ -62,15 +63,18 @@ namespace Renderer
         std::vector<MaterialTextureData> m_MaterialTextures;
         std::vector<MaterialConstantData> m_MaterialConstants;
         std::vector<Mesh*> m_Meshes;
+        std::vector<Meshlet> m_Meshlets;
         std::vector<GraphNode> m_SceneGraph;
         std::vector<std::string> m_TextureNames;
         std::vector<uint8_t> m_TextureOptions;
+        uint64_t m_SourceKey = 0;   // Content hash of the source files and the converter, see LoadModel()
     };
 
     struct FileHeader
     {
         char     id[4];   // "MINI"
         uint32_t version; // CURRENT_MINI_FILE_VERSION
+        uint64_t sourceKey;     // ModelData::m_SourceKey; the file is rebuilt when it no longer matches
         uint32_t numNodes;
         uint32_t numMeshes;
         uint32_t numMaterials;
@@ -82,14 +86,20 @@ namespace Renderer
         uint32_t numAnimationCurves;
         uint32_t numAnimations;
         uint32_t numJoints;     // All joints for all skins
+        uint32_t numMeshlets;   // All meshlets for all draws
+        uint32_t numGeometryChunks;     // 0 if the geometry is stored uncompressed
+        uint32_t encodedGeometrySize;   // Payload that follows the GeometryChunk table
         float    boundingSphere[4];
         float    minPos[3];
         float    maxPos[3];
     };
 
+    struct Primitive;
+
     void CompileMesh(
         std::vector<Mesh*>& meshList,
         std::vector<byte>& bufferMemory,
+        std::vector<Meshlet>& meshletList,
         glTF::Mesh& srcMesh,
         uint32_t matrixIdx,
         const Matrix4& localToObject,
@@ -97,8 +107,27 @@ namespace Renderer
         Math::AxisAlignedBox& boundingBox
     );
 
-    bool BuildModel( ModelData& model, const glTF::Asset& asset, int sceneIdx = -1 );
-    bool SaveModel( const std::wstring& filePath, const ModelData& model );
+    // Packs primitives that OptimizeMesh() has already converted (one per srcMesh.primitives entry, in order)
+    // into meshes and appends their vertex and index data to bufferMemory.  This is the serial half of CompileMesh()
+    // so that the primitives of a whole scene can be optimized in parallel beforehand.
+    void CompileMesh(
+        std::vector<Mesh*>& meshList,
+        std::vector<byte>& bufferMemory,
+        std::vector<Meshlet>& meshletList,
+        const glTF::Mesh& srcMesh,
+        uint32_t matrixIdx,
+        Primitive* primitives,
+        Math::BoundingSphere& boundingSphere,
+        Math::AxisAlignedBox& boundingBox
+    );
+
+    // With a cache, primitives whose inputs have not changed since they were last optimized are read back from it
+    bool BuildModel( ModelData& model, const glTF::Asset& asset, int sceneIdx = -1, const ModelCache* cache = nullptr );
+    // Unless compressGeometry is false, the geometry is stored in GeometryCodec chunks, which LoadModel() decodes in parallel
+    bool SaveModel( const std::wstring& filePath, const ModelData& model, bool compressGeometry = true );
     
+    // The .mini file next to filePath is rebuilt when the content of the source files changes, and the converted
+    // primitives and textures are cached by content in the ModelCache directory next to it, so that a rebuild
+    // only converts what changed.
     std::shared_ptr<Model> LoadModel( const std::wstring& filePath, bool forceRebuild = false );
 }
\ No newline at end of file
@@ -15,37 +15,62 @@
 //
 
 #include "TextureConvert.h"
+#include "BlockCompressor.h"
+#include "MipGenerator.h"
+#include "ModelCache.h"
 #include "../Core/Utility.h"
+#include "../Core/MappedFile.h"
 #include "DirectXTex.h"
 
 using namespace DirectX;
 
 #define GetFlag(f) ((Flags & f) != 0)
 
-void CompileTextureOnDemand(const std::wstring& originalFile, uint32_t flags)
+// Bump this whenever ConvertToDDS() produces different output for the same input, so that the textures
+// converted by the old version are no longer looked up.
+static const uint64_t kTextureConverterVersion = 3;
+
+std::wstring CompileTextureOnDemand(const std::wstring& originalFile, uint32_t flags, const ModelCache& cache)
 {
-    std::wstring ddsFile = Utility::RemoveExtension(originalFile) + L".dds";
+    Utility::MappedFile srcFile;
+    if (!srcFile.Open(originalFile))
+    {
+        std::wstring ddsFile = Utility::RemoveExtension(originalFile) + L".dds";
+        struct _stat64 ddsFileStat;
+        if (_wstat64(ddsFile.c_str(), &ddsFileStat) == -1)
+            Utility::Printf("Texture %ws is missing.\n", Utility::RemoveBasePath(originalFile).c_str());
+        return ddsFile;
+    }
 
-    struct _stat64 ddsFileStat, srcFileStat;
+    ContentHash hash(kTextureConverterVersion);
+    hash.UpdateValue(flags);
+    hash.Update(srcFile.GetData(), srcFile.GetSize());
+    srcFile.Close();
 
-    bool srcFileMissing = _wstat64(originalFile.c_str(), &srcFileStat) == -1;
-    bool ddsFileMissing = _wstat64(ddsFile.c_str(), &ddsFileStat) == -1;
+    const uint64_t key = hash.Finish();
+    const std::wstring ddsFile = Utility::UTF8ToWideString(cache.GetFilePath(key, ".dds"));
 
-    if (srcFileMissing && ddsFileMissing)
-    {
-        Utility::Printf("Texture %ws is missing.\n", Utility::RemoveBasePath(originalFile).c_str());
-        return;
-    }
+    struct _stat64 ddsFileStat;
+    if (_wstat64(ddsFile.c_str(), &ddsFileStat) == 0)
+        return ddsFile;
+
+    Utility::Printf("DDS texture %ws not in the cache.  Rebuilding.\n", Utility::RemoveBasePath(originalFile).c_str());
 
-    // If we can find the source texture and the DDS file is older, reconvert.
-    if (ddsFileMissing || !srcFileMissing && ddsFileStat.st_mtime < srcFileStat.st_mtime)
+    // Textures with the same content may be converted by several threads, in this or another process, at once, so
+    // each writes a file of its own and moves it into place
+    const std::wstring tempFile = ddsFile + L"." + std::to_wstring(GetCurrentProcessId()) + L"." +
+        std::to_wstring(GetCurrentThreadId()) + L".tmp";
+    if (!cache.MakeDirectory() || !ConvertToDDS(originalFile, flags, tempFile) ||
+        !MoveFileExW(tempFile.c_str(), ddsFile.c_str(), MOVEFILE_REPLACE_EXISTING))
     {
-        Utility::Printf("DDS texture %ws missing or older than source.  Rebuilding.\n", Utility::RemoveBasePath(originalFile).c_str());
-        ConvertToDDS(originalFile, flags);
+        _wremove(tempFile.c_str());
+        Utility::Printf("Could not add texture %ws to the cache.\n", Utility::RemoveBasePath(originalFile).c_str());
     }
+
+    return ddsFile;
 }
 
-bool ConvertToDDS( const std::wstring& filePath, uint32_t Flags )
+bool ConvertToDDS( const std::wstring& filePath, uint32_t Flags, const std::wstring& destFile )
 {
     bool bInterpretAsSRGB =	GetFlag(kSRGB);
     bool bPreserveAlpha =	GetFlag(kPreserveAlpha);
@@ -54,6 +79,7 @@ bool ConvertToDDS( const std::wstring& filePath, uint32_t Flags )
     bool bBlockCompress =	GetFlag(kDefaultBC);
     bool bUseBestBC =		GetFlag(kQualityBC);
     bool bFlipImage =       GetFlag(kFlipVertical);
+    bool bAlphaTest =       GetFlag(kAlphaTest);
 
     // Can't be both
     ASSERT(!bInterpretAsSRGB || !bContainsNormals);
@@ -167,12 +193,7 @@ bool ConvertToDDS( const std::wstring& filePath, uint32_t Flags )
     else if (bBlockCompress)
     {
         tformat = bInterpretAsSRGB ? DXGI_FORMAT_R8G8B8A8_UNORM_SRGB : DXGI_FORMAT_R8G8B8A8_UNORM;
-        if (bUseBestBC)
-            cformat = bInterpretAsSRGB ? DXGI_FORMAT_BC7_UNORM_SRGB : DXGI_FORMAT_BC7_UNORM;
-        else if (bPreserveAlpha)
-            cformat = bInterpretAsSRGB ? DXGI_FORMAT_BC3_UNORM_SRGB : DXGI_FORMAT_BC3_UNORM;
-        else
-            cformat = bInterpretAsSRGB ? DXGI_FORMAT_BC1_UNORM_SRGB : DXGI_FORMAT_BC1_UNORM;
+        cformat = GetBlockCompressedFormat(Flags);
     }
     else
     {
@@ -214,8 +235,48 @@ bool ConvertToDDS( const std::wstring& filePath, uint32_t Flags )
         }
     }
 
-    // Handle mipmaps
-    if (info.mipLevels == 1)
+    // Handle mipmaps.  8-bit 2D textures get theirs from MipGenerator, which preserves alpha-test coverage and
+    // renormalizes normals.
+    if (info.mipLevels == 1 && image->GetMetadata().format == tformat && !isHDR &&
+        image->GetMetadata().dimension == TEX_DIMENSION_TEXTURE2D)
+    {
+        std::unique_ptr<ScratchImage> timage(new ScratchImage);
+
+        TexMetadata minfo = image->GetMetadata();
+        minfo.mipLevels = GetMipCount((uint32_t)minfo.width, (uint32_t)minfo.height);
+
+        HRESULT hr = timage->Initialize( minfo );
+        if (FAILED(hr))
+        {
+            Utility::Printf( "Failing generating mimaps for \"%ws\" (%08X).\n", filePath.c_str(), hr );
+        }
+        else
+        {
+            // Model textures mostly tile, so the filter wraps around the edges.
+            MipOptions options;
+            options.SRGB = bInterpretAsSRGB;
+            options.NormalMap = bContainsNormals || bBumpMap;
+            options.Wrap = true;
+            options.AlphaCutoff = bAlphaTest ? 0.5f : 0.0f;
+
+            std::vector<MipImage> mips(minfo.mipLevels);
+            for (size_t item = 0; item < minfo.arraySize; ++item)
+            {
+                const Image& source = *image->GetImage(0, item, 0);
+                std::memcpy(timage->GetImage(0, item, 0)->pixels, source.pixels, source.slicePitch);
+
+                for (size_t level = 0; level < minfo.mipLevels; ++level)
+                {
+                    const Image& mip = *timage->GetImage(level, item, 0);
+                    mips[level] = { mip.pixels, mip.rowPitch, (uint32_t)mip.width, (uint32_t)mip.height };
+                }
+                GenerateMips(mips.data(), (uint32_t)mips.size(), options);
+            }
+
+            image.swap(timage);
+        }
+    }
+    else if (info.mipLevels == 1)
     {
         std::unique_ptr<ScratchImage> timage(new ScratchImage);
 
@@ -238,11 +299,46 @@ bool ConvertToDDS( const std::wstring& filePath, uint32_t Flags )
         {
             Utility::Printf( "Texture size (%Iux%Iu) not a multiple of 4 \"%ws\", so skipping compress\n", info.width, info.height, filePath.c_str() );
         }
-        else
+        else if (!IsBlockCompressorFormat(cformat))
         {
+            // BC6H for HDR textures
             std::unique_ptr<ScratchImage> timage(new ScratchImage);
 
             HRESULT hr = Compress( image->GetImages(), image->GetImageCount(), image->GetMetadata(), cformat, TEX_COMPRESS_DEFAULT, 0.5f, *timage );
+
+            if (FAILED(hr))
+            {
+                Utility::Printf( "Failing compressing \"%ws\" (WIC: %08X).\n", filePath.c_str(), hr );
+            }
+            else
+            {
+                image.swap(timage);
+            }
+        }
+        else
+        {
+            std::unique_ptr<ScratchImage> timage(new ScratchImage);
+
+            TexMetadata cinfo = image->GetMetadata();
+            cinfo.format = cformat;
+
+            // The same images in the same order, so every mip level is compressed into its counterpart
+            HRESULT hr = timage->Initialize( cinfo );
+            if (SUCCEEDED(hr))
+            {
+                const BCQuality quality = bUseBestBC ? BCQuality::kQuality : BCQuality::kFast;
+                for (size_t i = 0; i < image->GetImageCount() && SUCCEEDED(hr); ++i)
+                {
+                    const Image& source = image->GetImages()[i];
+                    const Image& dest = timage->GetImages()[i];
+                    if (!CompressImage( cformat, source.pixels, source.rowPitch, (uint32_t)source.width, (uint32_t)source.height,
+                        quality, dest.pixels, dest.rowPitch ))
+                    {
+                        hr = E_INVALIDARG;
+                    }
+                }
+            }
+
             if (FAILED(hr))
             {
                 Utility::Printf( "Failing compressing \"%ws\" (WIC: %08X).\n", filePath.c_str(), hr );
@@ -255,7 +351,7 @@ bool ConvertToDDS( const std::wstring& filePath, uint32_t Flags )
     }
 
     // Rename file extension to DDS
-    const std::wstring wDest = Utility::RemoveExtension(filePath) + L".dds";
+    const std::wstring wDest = destFile.empty() ? Utility::RemoveExtension(filePath) + L".dds" : destFile;
     
     // Save DDS
     HRESULT hr = SaveToDDSFile( image->GetImages(), image->GetImageCount(), image->GetMetadata(), DDS_FLAGS_NONE, wDest.c_str() );
@@ -16,6 +16,8 @@
 #include <cstdint>
 #include <string>
 
+class ModelCache;
+
 enum TexConversionFlags
 {
     kSRGB = 1,          // Texture contains sRGB colors
@@ -25,20 +27,24 @@ enum TexConversionFlags
     kDefaultBC = 16,    // Apply standard block compression (BC1-5)
     kQualityBC = 32,    // Apply quality block compression (BC6H/7)
     kFlipVertical = 64,
+    kAlphaTest = 128,   // Alpha is compared with 0.5, so mips keep the fraction of texels that pass
 };
 
-inline uint8_t TextureOptions(bool sRGB, bool hasAlpha=false, bool invertY=false)
+inline uint8_t TextureOptions(bool sRGB, bool hasAlpha=false, bool invertY=false, bool alphaTest=false)
 {
-    return (sRGB ? kSRGB : 0) | (hasAlpha ? kPreserveAlpha : 0) | (invertY ? kFlipVertical : 0);
+    return (sRGB ? kSRGB : 0) | (hasAlpha ? kPreserveAlpha : 0) | (invertY ? kFlipVertical : 0) | (alphaTest ? kAlphaTest : 0);
 }
 
-// If the DDS version of the texture specified does not exist or is older than the source texture, reconvert it.
-void CompileTextureOnDemand(const std::wstring& originalFile, uint32_t flags);
+// Returns the DDS file to load for the texture specified.  It is the cache entry keyed by the content of the
+// source texture and the flags, which is converted first if the cache does not have it yet.  Without the source
+// texture, it is the DDS file next to it with the same name.  Safe to call concurrently.
+std::wstring CompileTextureOnDemand(const std::wstring& originalFile, uint32_t flags, const ModelCache& cache);
 
 // Loads a non-DDS texture such as TGA, PNG, or JPG, then converts it to a more optimal
-// DDS format with a full mip chain.  Resultant file has the same path with the file extension
-// changed to "DDS".
+// DDS format with a full mip chain.  Resultant file is destFile, or if it is empty, the same
+// path with the file extension changed to "DDS".
 bool ConvertToDDS(
     const std::wstring& filePath,	// UTF8-encoded path to source file
-    uint32_t Flags                  // flags ORed together
+    uint32_t Flags,                 // flags ORed together
+    const std::wstring& destFile = L""
 );
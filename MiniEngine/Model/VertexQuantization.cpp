@@ -0,0 +1,339 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+
+#include "VertexQuantization.h"
+
+#include <algorithm>
+#include <cstring>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+namespace
+{
+    const float kUnormScale = 65535.0f;
+    const float kSnormScale = 32767.0f;
+
+    // 2^112 rebiases the exponent of a half shifted into the position of a float's
+    const uint32_t kHalfToFloatScaleBits = 0x77800000;
+
+    inline float SnormToFloat(int32_t value)
+    {
+        return std::max(value * (1.0f / kSnormScale), -1.0f);
+    }
+
+    inline int16_t FloatToSnorm(float value)
+    {
+        return (int16_t)std::min(std::max(value, -kSnormScale), kSnormScale);
+    }
+
+    inline float Dot(const float a[3], const float b[3])
+    {
+        return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+    }
+
+    inline void Cross(const float a[3], const float b[3], float c[3])
+    {
+        c[0] = a[1] * b[2] - a[2] * b[1];
+        c[1] = a[2] * b[0] - a[0] * b[2];
+        c[2] = a[0] * b[1] - a[1] * b[0];
+    }
+
+    // The octahedral projection rounded to the nearest code is not always the code that decodes closest to the
+    // direction, so the four codes around the projection are tried.
+    void EncodeOctSnorm(const float dir[3], int16_t code[2])
+    {
+        float n[3] = { 0.0f, 0.0f, 1.0f };
+        const float length = std::sqrt(Dot(dir, dir));
+        if (length > 0.0f)
+        {
+            n[0] = dir[0] / length;
+            n[1] = dir[1] / length;
+            n[2] = dir[2] / length;
+        }
+
+        float p[2];
+        EncodeOct(n, p);
+
+        const float base[2] = { std::floor(p[0] * kSnormScale), std::floor(p[1] * kSnormScale) };
+        float bestDot = -2.0f;
+
+        for (int i = 0; i < 4; ++i)
+        {
+            const int16_t candidate[2] = { FloatToSnorm(base[0] + (i & 1)), FloatToSnorm(base[1] + (i >> 1)) };
+            const float q[2] = { SnormToFloat(candidate[0]), SnormToFloat(candidate[1]) };
+            float decoded[3];
+            DecodeOct(q, decoded);
+
+            const float d = Dot(decoded, n);
+            if (d > bestDot)
+            {
+                bestDot = d;
+                code[0] = candidate[0];
+                code[1] = candidate[1];
+            }
+        }
+    }
+
+    inline void DequantizeVertex(const QuantizedVertex& quantized, const PositionQuantization& quantization, FloatVertex& vertex)
+    {
+        for (int k = 0; k < 3; ++k)
+        {
+            vertex.position[k] = quantized.position[k] * quantization.scale[k] + quantization.bias[k];
+        }
+
+        vertex.texcoord[0] = HalfToFloat(quantized.texcoord[0]);
+        vertex.texcoord[1] = HalfToFloat(quantized.texcoord[1]);
+
+        const float normal[2] = { SnormToFloat(quantized.normal[0]), SnormToFloat(quantized.normal[1]) };
+        const float tangent[2] = { SnormToFloat(quantized.tangent[0]), SnormToFloat(quantized.tangent[1]) };
+        DecodeOct(normal, vertex.normal);
+        DecodeOct(tangent, vertex.tangent);
+
+        const float sign = quantized.position[3] >= 0x8000 ? 1.0f : -1.0f;
+        Cross(vertex.normal, vertex.tangent, vertex.bitangent);
+        for (int k = 0; k < 3; ++k)
+        {
+            vertex.bitangent[k] *= sign;
+        }
+    }
+
+#if defined(__AVX2__)
+    inline __m256 HalfToFloat8(__m256i half)
+    {
+        const __m256i magnitude = _mm256_slli_epi32(_mm256_and_si256(half, _mm256_set1_epi32(0x7FFF)), 13);
+        const __m256i sign = _mm256_slli_epi32(_mm256_and_si256(half, _mm256_set1_epi32(0x8000)), 16);
+        const __m256 value = _mm256_mul_ps(_mm256_castsi256_ps(magnitude), _mm256_castsi256_ps(_mm256_set1_epi32(kHalfToFloatScaleBits)));
+        return _mm256_or_ps(value, _mm256_castsi256_ps(sign));
+    }
+
+    inline __m256 SnormToFloat8(__m256i snorm)
+    {
+        return _mm256_max_ps(_mm256_mul_ps(_mm256_cvtepi32_ps(snorm), _mm256_set1_ps(1.0f / kSnormScale)), _mm256_set1_ps(-1.0f));
+    }
+
+    // Two R16G16_SNORM codes per lane
+    inline void DecodeOct8(__m256i code, __m256& x, __m256& y, __m256& z)
+    {
+        const __m256 signMask = _mm256_set1_ps(-0.0f);
+        const __m256 px = SnormToFloat8(_mm256_srai_epi32(_mm256_slli_epi32(code, 16), 16));
+        const __m256 py = SnormToFloat8(_mm256_srai_epi32(code, 16));
+
+        const __m256 nz = _mm256_sub_ps(_mm256_sub_ps(_mm256_set1_ps(1.0f), _mm256_andnot_ps(signMask, px)), _mm256_andnot_ps(signMask, py));
+        const __m256 t = _mm256_max_ps(_mm256_sub_ps(_mm256_setzero_ps(), nz), _mm256_setzero_ps());
+        const __m256 nx = _mm256_sub_ps(px, _mm256_or_ps(t, _mm256_and_ps(px, signMask)));
+        const __m256 ny = _mm256_sub_ps(py, _mm256_or_ps(t, _mm256_and_ps(py, signMask)));
+
+        const __m256 lengthSq = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(nx, nx), _mm256_mul_ps(ny, ny)), _mm256_mul_ps(nz, nz));
+        const __m256 invLength = _mm256_div_ps(_mm256_set1_ps(1.0f), _mm256_sqrt_ps(lengthSq));
+        x = _mm256_mul_ps(nx, invLength);
+        y = _mm256_mul_ps(ny, invLength);
+        z = _mm256_mul_ps(nz, invLength);
+    }
+
+    // Rows become columns
+    inline void Transpose8x8(__m256 (&r)[8])
+    {
+        const __m256 t0 = _mm256_unpacklo_ps(r[0], r[1]);
+        const __m256 t1 = _mm256_unpackhi_ps(r[0], r[1]);
+        const __m256 t2 = _mm256_unpacklo_ps(r[2], r[3]);
+        const __m256 t3 = _mm256_unpackhi_ps(r[2], r[3]);
+        const __m256 t4 = _mm256_unpacklo_ps(r[4], r[5]);
+        const __m256 t5 = _mm256_unpackhi_ps(r[4], r[5]);
+        const __m256 t6 = _mm256_unpacklo_ps(r[6], r[7]);
+        const __m256 t7 = _mm256_unpackhi_ps(r[6], r[7]);
+        const __m256 s0 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0));
+        const __m256 s1 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2));
+        const __m256 s2 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0));
+        const __m256 s3 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2));
+        const __m256 s4 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(1, 0, 1, 0));
+        const __m256 s5 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(3, 2, 3, 2));
+        const __m256 s6 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(1, 0, 1, 0));
+        const __m256 s7 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(3, 2, 3, 2));
+        r[0] = _mm256_permute2f128_ps(s0, s4, 0x20);
+        r[1] = _mm256_permute2f128_ps(s1, s5, 0x20);
+        r[2] = _mm256_permute2f128_ps(s2, s6, 0x20);
+        r[3] = _mm256_permute2f128_ps(s3, s7, 0x20);
+        r[4] = _mm256_permute2f128_ps(s0, s4, 0x31);
+        r[5] = _mm256_permute2f128_ps(s1, s5, 0x31);
+        r[6] = _mm256_permute2f128_ps(s2, s6, 0x31);
+        r[7] = _mm256_permute2f128_ps(s3, s7, 0x31);
+    }
+
+    // Each member of QuantizedVertex is gathered into the lanes of its own register, decoded, and the attributes are
+    // transposed back into vertices.
+    size_t DequantizeVertices8(const QuantizedVertex* quantizedVertices, size_t vertexCount, const PositionQuantization& quantization,
+        FloatVertex* vertices)
+    {
+        const __m256i offsets = _mm256_mullo_epi32(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7), _mm256_set1_epi32(sizeof(QuantizedVertex)));
+        const __m256i lowMask = _mm256_set1_epi32(0xFFFF);
+        const __m256i tangentStoreMask = _mm256_setr_epi32(-1, -1, -1, -1, -1, -1, 0, 0);
+        const __m256 scale[3] = { _mm256_set1_ps(quantization.scale[0]), _mm256_set1_ps(quantization.scale[1]), _mm256_set1_ps(quantization.scale[2]) };
+        const __m256 bias[3] = { _mm256_set1_ps(quantization.bias[0]), _mm256_set1_ps(quantization.bias[1]), _mm256_set1_ps(quantization.bias[2]) };
+
+        size_t i = 0;
+        for (; i + 8 <= vertexCount; i += 8)
+        {
+            const uint8_t* base = reinterpret_cast<const uint8_t*>(quantizedVertices + i);
+            const __m256i positionXY = _mm256_i32gather_epi32(reinterpret_cast<const int*>(base + 0), offsets, 1);
+            const __m256i positionZW = _mm256_i32gather_epi32(reinterpret_cast<const int*>(base + 4), offsets, 1);
+            const __m256i normal = _mm256_i32gather_epi32(reinterpret_cast<const int*>(base + 8), offsets, 1);
+            const __m256i tangent = _mm256_i32gather_epi32(reinterpret_cast<const int*>(base + 12), offsets, 1);
+            const __m256i texcoord = _mm256_i32gather_epi32(reinterpret_cast<const int*>(base + 16), offsets, 1);
+
+            __m256 first[8];   // position, texcoord and normal
+            __m256 second[8];  // tangent and bitangent
+
+            first[0] = _mm256_fmadd_ps(_mm256_cvtepi32_ps(_mm256_and_si256(positionXY, lowMask)), scale[0], bias[0]);
+            first[1] = _mm256_fmadd_ps(_mm256_cvtepi32_ps(_mm256_srli_epi32(positionXY, 16)), scale[1], bias[1]);
+            first[2] = _mm256_fmadd_ps(_mm256_cvtepi32_ps(_mm256_and_si256(positionZW, lowMask)), scale[2], bias[2]);
+            first[3] = HalfToFloat8(texcoord);
+            first[4] = HalfToFloat8(_mm256_srli_epi32(texcoord, 16));
+            DecodeOct8(normal, first[5], first[6], first[7]);
+            DecodeOct8(tangent, second[0], second[1], second[2]);
+
+            // -0.0 for a negative bitangent sign (w < 0x8000), which flips the sign of the cross product
+            const __m256 sign = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_andnot_si256(_mm256_srli_epi32(positionZW, 31), _mm256_set1_epi32(1)), 31));
+            second[3] = _mm256_xor_ps(_mm256_fmsub_ps(first[6], second[2], _mm256_mul_ps(first[7], second[1])), sign);
+            second[4] = _mm256_xor_ps(_mm256_fmsub_ps(first[7], second[0], _mm256_mul_ps(first[5], second[2])), sign);
+            second[5] = _mm256_xor_ps(_mm256_fmsub_ps(first[5], second[1], _mm256_mul_ps(first[6], second[0])), sign);
+            second[6] = _mm256_setzero_ps();
+            second[7] = _mm256_setzero_ps();
+
+            Transpose8x8(first);
+            Transpose8x8(second);
+
+            for (int k = 0; k < 8; ++k)
+            {
+                _mm256_storeu_ps(vertices[i + k].position, first[k]);
+                _mm256_maskstore_ps(vertices[i + k].tangent, tangentStoreMask, second[k]);
+            }
+        }
+
+        return i;
+    }
+#endif
+}
+
+PositionQuantization MakePositionQuantization(const float minPos[3], const float maxPos[3])
+{
+    PositionQuantization quantization;
+
+    for (int k = 0; k < 3; ++k)
+    {
+        quantization.scale[k] = std::max(maxPos[k] - minPos[k], 0.0f) / kUnormScale;
+        quantization.bias[k] = minPos[k];
+    }
+
+    return quantization;
+}
+
+uint16_t FloatToHalf(float value)
+{
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+
+    const uint16_t sign = (uint16_t)((bits >> 16) & 0x8000);
+    const uint32_t magnitude = bits & 0x7FFFFFFF;
+
+    if (magnitude > 0x7F800000)
+        return 0;                                   // NaN
+    if (magnitude >= 0x477FF000)
+        return sign | 0x7BFF;                       // Rounds to infinity: saturate to 65504
+
+    if (magnitude < 0x38800000)
+    {
+        // Subnormal half: the value in units of 2^-24, rounded to nearest even by the default rounding mode
+        float absValue;
+        std::memcpy(&absValue, &magnitude, sizeof(absValue));
+        return sign | (uint16_t)std::nearbyint(absValue * 16777216.0f);
+    }
+
+    // Rebias the exponent from 127 to 15 and round the mantissa from 23 to 10 bits to nearest even
+    uint32_t half = (magnitude - 0x38000000) >> 13;
+    const uint32_t remainder = magnitude & 0x1FFF;
+    if (remainder > 0x1000 || (remainder == 0x1000 && (half & 1)))
+        ++half;
+
+    return sign | (uint16_t)half;
+}
+
+float HalfToFloat(uint16_t value)
+{
+    const uint32_t magnitudeBits = (uint32_t)(value & 0x7FFF) << 13;
+    const uint32_t signBits = (uint32_t)(value & 0x8000) << 16;
+
+    float magnitude, scale;
+    std::memcpy(&magnitude, &magnitudeBits, sizeof(magnitude));
+    std::memcpy(&scale, &kHalfToFloatScaleBits, sizeof(scale));
+
+    // Exact for normal and subnormal halves
+    uint32_t bits;
+    const float result = magnitude * scale;
+    std::memcpy(&bits, &result, sizeof(bits));
+    bits |= signBits;
+
+    float signedResult;
+    std::memcpy(&signedResult, &bits, sizeof(signedResult));
+    return signedResult;
+}
+
+void QuantizeVertices(const FloatVertex* vertices, size_t vertexCount, const PositionQuantization& quantization,
+    QuantizedVertex* quantizedVertices)
+{
+    float invScale[3];
+    for (int k = 0; k < 3; ++k)
+    {
+        invScale[k] = quantization.scale[k] > 0.0f ? 1.0f / quantization.scale[k] : 0.0f;
+    }
+
+    for (size_t i = 0; i < vertexCount; ++i)
+    {
+        const FloatVertex& vertex = vertices[i];
+        QuantizedVertex& quantized = quantizedVertices[i];
+
+        for (int k = 0; k < 3; ++k)
+        {
+            const float unorm = std::nearbyint((vertex.position[k] - quantization.bias[k]) * invScale[k]);
+            quantized.position[k] = (uint16_t)std::min(std::max(unorm, 0.0f), kUnormScale);
+        }
+
+        EncodeOctSnorm(vertex.normal, quantized.normal);
+        EncodeOctSnorm(vertex.tangent, quantized.tangent);
+
+        float crossProduct[3];
+        Cross(vertex.normal, vertex.tangent, crossProduct);
+        quantized.position[3] = Dot(crossProduct, vertex.bitangent) < 0.0f ? 0 : 0xFFFF;
+
+        quantized.texcoord[0] = FloatToHalf(vertex.texcoord[0]);
+        quantized.texcoord[1] = FloatToHalf(vertex.texcoord[1]);
+    }
+}
+
+void DequantizeVertices(const QuantizedVertex* quantizedVertices, size_t vertexCount, const PositionQuantization& quantization,
+    FloatVertex* vertices)
+{
+    size_t i = 0;
+
+#if defined(__AVX2__)
+    i = DequantizeVertices8(quantizedVertices, vertexCount, quantization, vertices);
+#endif
+
+    DequantizeVerticesScalar(quantizedVertices + i, vertexCount - i, quantization, vertices + i);
+}
+
+void DequantizeVerticesScalar(const QuantizedVertex* quantizedVertices, size_t vertexCount, const PositionQuantization& quantization,
+    FloatVertex* vertices)
+{
+    for (size_t i = 0; i < vertexCount; ++i)
+    {
+        DequantizeVertex(quantizedVertices[i], quantization, vertices[i]);
+    }
+}
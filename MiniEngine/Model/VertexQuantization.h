@@ -0,0 +1,118 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+
+#pragma once
+
+// A compact vertex format for the float vertices of H3D models and its encoder and decoder.  This header does not
+// depend on pch.h so that it can be shared with portable (non-D3D12) tools.
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+// The full precision vertex of the H3D models (H3DData::HasFloatVertexLayout()).
+struct FloatVertex
+{
+    float position[3];
+    float texcoord[2];
+    float normal[3];
+    float tangent[3];
+    float bitangent[3];
+};
+
+static_assert(sizeof(FloatVertex) == 56, "FloatVertex matches the H3D vertex layout");
+
+// Every member maps to a DXGI format so that the input assembler could read the vertex as well:
+//      position        R16G16B16A16_UNORM  position in the mesh bounding box (PositionQuantization); w is the bitangent sign,
+//                                          0 for -cross(normal, tangent) and 65535 for +cross(normal, tangent)
+//      normal          R16G16_SNORM        EncodeOct() of OctahedralMapping.hlsli
+//      tangent         R16G16_SNORM        EncodeOct()
+//      texcoord        R16G16_FLOAT
+struct QuantizedVertex
+{
+    uint16_t position[4];
+    int16_t normal[2];
+    int16_t tangent[2];
+    uint16_t texcoord[2];
+};
+
+static_assert(sizeof(QuantizedVertex) == 20, "QuantizedVertex is tightly packed");
+
+// position = unorm * scale + bias
+struct PositionQuantization
+{
+    float scale[3];
+    float bias[3];
+};
+
+PositionQuantization MakePositionQuantization(const float minPos[3], const float maxPos[3]);
+
+// Same as EncodeOct() and DecodeOct() in OctahedralMapping.hlsli.  dir must not be zero.
+inline void EncodeOct(const float dir[3], float p[2])
+{
+    const float invL1Norm = 1.0f / (std::abs(dir[0]) + std::abs(dir[1]) + std::abs(dir[2]));
+    const float s[2] = { dir[0] * invL1Norm, dir[1] * invL1Norm };
+
+    if (dir[2] < 0.0f)
+    {
+        p[0] = std::copysign(1.0f - std::abs(s[1]), s[0]);
+        p[1] = std::copysign(1.0f - std::abs(s[0]), s[1]);
+    }
+    else
+    {
+        p[0] = s[0];
+        p[1] = s[1];
+    }
+}
+
+inline void DecodeOct(const float p[2], float dir[3])
+{
+    const float z = 1.0f - std::abs(p[0]) - std::abs(p[1]);
+    const float t = z < 0.0f ? -z : 0.0f;
+    const float n[3] = { p[0] - std::copysign(t, p[0]), p[1] - std::copysign(t, p[1]), z };
+    const float invLength = 1.0f / std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+
+    dir[0] = n[0] * invLength;
+    dir[1] = n[1] * invLength;
+    dir[2] = n[2] * invLength;
+}
+
+// IEEE half conversions.  FloatToHalf() rounds to nearest even and saturates to the largest finite half (NaN becomes 0),
+// so HalfToFloat() only has finite values to expand.
+uint16_t FloatToHalf(float value);
+float HalfToFloat(uint16_t value);
+
+//-----------------------------------------------------------------------------
+//  QuantizeVertices
+//-----------------------------------------------------------------------------
+//  Encodes vertices into QuantizedVertex.  Positions are rounded to the
+//  nearest step of the quantization, and normals and tangents are normalized
+//  and take the most accurate of the four codes around their octahedral
+//  projection.
+//  Parameters:
+//      vertices
+//          input vertices, positions within the box of quantization
+//      vertexCount
+//          the number of vertices
+//      quantization
+//          MakePositionQuantization() of the bounding box of the positions
+//      quantizedVertices
+//          a pointer to a preallocated array of vertexCount vertices
+//-----------------------------------------------------------------------------
+void QuantizeVertices(const FloatVertex* vertices, size_t vertexCount, const PositionQuantization& quantization,
+    QuantizedVertex* quantizedVertices);
+
+// Decodes vertices, eight at a time with AVX2 when the build targets it.  The bitangent is the signed cross product
+// of the decoded normal and tangent.
+void DequantizeVertices(const QuantizedVertex* quantizedVertices, size_t vertexCount, const PositionQuantization& quantization,
+    FloatVertex* vertices);
+
+// One vertex at a time, as a reference for DequantizeVertices().
+void DequantizeVerticesScalar(const QuantizedVertex* quantizedVertices, size_t vertexCount, const PositionQuantization& quantization,
+    FloatVertex* vertices);
@@ -19,6 +19,7 @@
 #include "../Core/GraphicsCore.h"
 #include "../Core/FileUtility.h"
 
+#include <algorithm>
 #include <fstream>
 #include <iostream>
 
@@ -26,65 +27,60 @@ using namespace glTF;
 using namespace Graphics;
 using namespace Utility;
 
-void ReadFloats( json& list, float flt_array[] )
+void ReadFloats( Json::Value list, float flt_array[] )
 {
     uint32_t i = 0;
-    for (auto& flt : list)
-        flt_array[i++] = flt;
+    list.ForEach([&](Json::Value flt) { flt_array[i++] = flt.GetFloat(); });
 }
 
-void glTF::Asset::ProcessNodes( json& nodes )
+void glTF::Asset::ProcessNodes( Json::Value nodes )
 {
-    m_nodes.resize(nodes.size());
-
     uint32_t nodeIdx = 0;
 
-    for (json::iterator it = nodes.begin(); it != nodes.end(); ++it)
+    nodes.ForEach([&](Json::Value thisNode)
     {
         glTF::Node& node = m_nodes[nodeIdx++];
-        json& thisNode = it.value();
 
         node.flags = 0;
         node.mesh = nullptr;
         node.linearIdx = -1;
 
-        if (thisNode.find("camera") != thisNode.end())
+        if (thisNode.Contains("camera"))
         {
-            node.camera = &m_cameras[thisNode.at("camera")];
+            node.camera = &m_cameras[thisNode.Find("camera").GetUint32()];
             node.pointsToCamera = true;
         }
-        else if (thisNode.find("mesh") != thisNode.end())
+        else if (thisNode.Contains("mesh"))
         {
-            node.mesh = &m_meshes[thisNode.at("mesh")];
+            node.mesh = &m_meshes[thisNode.Find("mesh").GetUint32()];
         }
 
-        if (thisNode.find("skin") != thisNode.end())
+        if (thisNode.Contains("skin"))
         {
             ASSERT(node.mesh != nullptr);
-            node.mesh->skin = thisNode.at("skin");
+            node.mesh->skin = thisNode.Find("skin").GetInt32();
         }
 
-        if (thisNode.find("children") != thisNode.end())
+        Json::Value children = thisNode.Find("children");
+        if (children.IsValid())
         {
-            json& children = thisNode["children"];
-            node.children.reserve(children.size());
-            for (auto& child : children)
-                node.children.push_back(&m_nodes[child]);
+            node.children.reserve(children.Size());
+            children.ForEach([&](Json::Value child) { node.children.push_back(&m_nodes[child.GetUint32()]); });
         }
 
-        if (thisNode.find("matrix") != thisNode.end())
+        if (thisNode.Contains("matrix"))
         {
             // TODO:  Should check for negative determinant to reverse triangle winding
-            ReadFloats(thisNode["matrix"], node.matrix);
+            ReadFloats(thisNode.Find("matrix"), node.matrix);
             node.hasMatrix = true;
         }
         else
         {
             // TODO:  Should check scale for 1 or 3 negative values to reverse triangle winding
-            json::iterator scale = thisNode.find("scale");
-            if (scale != thisNode.end())
+            Json::Value scale = thisNode.Find("scale");
+            if (scale.IsValid())
             {
-                ReadFloats(scale.value(), node.scale);
+                ReadFloats(scale, node.scale);
             }
             else
             {
@@ -93,10 +89,10 @@ void glTF::Asset::ProcessNodes( json& nodes )
                 node.scale[2] = 1.0f;
             }
 
-            json::iterator rotation = thisNode.find("rotation");
-            if (rotation != thisNode.end())
+            Json::Value rotation = thisNode.Find("rotation");
+            if (rotation.IsValid())
             {
-                ReadFloats(rotation.value(), node.rotation);
+                ReadFloats(rotation, node.rotation);
             }
             else
             {
@@ -106,10 +102,10 @@ void glTF::Asset::ProcessNodes( json& nodes )
                 node.rotation[3] = 1.0f;
             }
 
-            json::iterator translation = thisNode.find("translation");
-            if (translation != thisNode.end())
+            Json::Value translation = thisNode.Find("translation");
+            if (translation.IsValid())
             {
-                ReadFloats(translation.value(), node.translation);
+                ReadFloats(translation, node.translation);
             }
             else
             {
@@ -118,65 +114,58 @@ void glTF::Asset::ProcessNodes( json& nodes )
                 node.translation[2] = 0.0f;
             }
         }
-    }
+    });
 }
 
-void glTF::Asset::ProcessScenes( json& scenes )
+void glTF::Asset::ProcessScenes( Json::Value scenes )
 {
-    m_scenes.reserve(scenes.size());
+    m_scenes.reserve(scenes.Size());
 
-    for (json::iterator it = scenes.begin(); it != scenes.end(); ++it)
+    scenes.ForEach([&](Json::Value thisScene)
     {
         glTF::Scene scene;
-        json& thisScene = it.value();
 
-        if (thisScene.find("nodes") != thisScene.end())
+        Json::Value nodes = thisScene.Find("nodes");
+        if (nodes.IsValid())
         {
-            json& nodes = thisScene["nodes"];
-            scene.nodes.reserve(nodes.size());
-            for (auto& node : nodes)
-                scene.nodes.push_back(&m_nodes[node]);
+            scene.nodes.reserve(nodes.Size());
+            nodes.ForEach([&](Json::Value node) { scene.nodes.push_back(&m_nodes[node.GetUint32()]); });
         }
 
         m_scenes.push_back(scene);
-    }
+    });
 }
 
-void glTF::Asset::ProcessCameras( json& cameras )
+void glTF::Asset::ProcessCameras( Json::Value cameras )
 {
-    m_cameras.reserve(cameras.size());
+    m_cameras.reserve(cameras.Size());
 
-    for (json::iterator it = cameras.begin(); it != cameras.end(); ++it)
+    cameras.ForEach([&](Json::Value thisCamera)
     {
         glTF::Camera camera;
-        json& thisCamera = it.value();
 
-        if (thisCamera["type"] == "perspective")
+        if (thisCamera.Find("type").StringEquals("perspective"))
         {
-            json& perspective = thisCamera["perspective"];
+            Json::Value perspective = thisCamera.Find("perspective");
             camera.type = Camera::kPerspective;
-            camera.aspectRatio = 0.0f;
-            if (perspective.find("aspectRatio") != perspective.end())
-                camera.aspectRatio = perspective.at("aspectRatio");
-            camera.yfov = perspective["yfov"];
-            camera.znear = perspective["znear"];
-            camera.zfar = 0.0f;
-            if (perspective.find("zfar") != perspective.end())
-                camera.zfar = perspective.at("zfar");
+            camera.aspectRatio = perspective.GetFloat("aspectRatio", 0.0f);
+            camera.yfov = perspective.Find("yfov").GetFloat();
+            camera.znear = perspective.Find("znear").GetFloat();
+            camera.zfar = perspective.GetFloat("zfar", 0.0f);
         }
         else
         {
             camera.type = Camera::kOrthographic;
-            json& orthographic = thisCamera["orthographic"];
-            camera.xmag = orthographic["xmag"];
-            camera.ymag = orthographic["ymag"];
-            camera.znear = orthographic["znear"];
-            camera.zfar = orthographic["zfar"];
+            Json::Value orthographic = thisCamera.Find("orthographic");
+            camera.xmag = orthographic.Find("xmag").GetFloat();
+            camera.ymag = orthographic.Find("ymag").GetFloat();
+            camera.znear = orthographic.Find("znear").GetFloat();
+            camera.zfar = orthographic.Find("zfar").GetFloat();
             ASSERT(camera.zfar > camera.znear);
         }
 
         m_cameras.push_back(camera);
-    }
+    });
 }
 
 uint16_t TypeToEnum( const char type[] )
@@ -189,39 +178,38 @@ uint16_t TypeToEnum( const char type[] )
         return Accessor::kScalar;
 }
 
-void glTF::Asset::ProcessAccessors( json& accessors )
+void glTF::Asset::ProcessAccessors( const std::vector<Json::Value>& accessors )
 {
-    m_accessors.reserve(accessors.size());
+    m_accessors.resize(accessors.size());
 
-    for (json::iterator it = accessors.begin(); it != accessors.end(); ++it)
+    concurrency::parallel_for(size_t(0), accessors.size(), [&](size_t accessorIdx)
     {
-        glTF::Accessor accessor;
-        json& thisAccessor = it.value();
+        glTF::Accessor& accessor = m_accessors[accessorIdx];
+        Json::Value thisAccessor = accessors[accessorIdx];
 
-        glTF::BufferView& bufferView = m_bufferViews[thisAccessor.at("bufferView")];
-        accessor.dataPtr = m_buffers[bufferView.buffer]->data() + bufferView.byteOffset;
+        glTF::BufferView& bufferView = m_bufferViews[thisAccessor.Find("bufferView").GetUint32()];
+        accessor.dataPtr = m_buffers[bufferView.buffer].data + bufferView.byteOffset;
         accessor.stride = bufferView.byteStride;
-        if (thisAccessor.find("byteOffset") != thisAccessor.end())
-            accessor.dataPtr += thisAccessor.at("byteOffset");
-        accessor.count = thisAccessor.at("count");
-        accessor.componentType = thisAccessor.at("componentType").get<uint16_t>() - 5120;
+        accessor.dataPtr += thisAccessor.GetUint32("byteOffset", 0);
+        accessor.count = thisAccessor.Find("count").GetUint32();
+        accessor.componentType = (uint16_t)(thisAccessor.Find("componentType").GetUint32() - 5120);
 
-        char type[8];
-        strcpy_s(type, thisAccessor.at("type").get<std::string>().c_str());
+        char type[8] = {};
+        size_t typeLength;
+        const char* typeData = thisAccessor.Find("type").GetStringData(typeLength);
+        memcpy(type, typeData, std::min(typeLength, sizeof(type) - 1));
 
         accessor.type = TypeToEnum(type);
-
-        m_accessors.push_back(accessor);
-    }
+    });
 }
 
-void glTF::Asset::FindAttribute( Primitive& prim, json& attributes, Primitive::eAttribType type, const string& name )
+void glTF::Asset::FindAttribute( Primitive& prim, Json::Value attributes, Primitive::eAttribType type, const char* name )
 {
-    json::iterator attrib = attributes.find(name);
-    if (attrib != attributes.end())
+    Json::Value attrib = attributes.Find(name);
+    if (attrib.IsValid())
     {
         prim.attribMask |= 1 << type;
-        prim.attributes[type] = &m_accessors[attrib.value()];
+        prim.attributes[type] = &m_accessors[attrib.GetUint32()];
     }
     else
     {
@@ -229,27 +217,26 @@ void glTF::Asset::FindAttribute( Primitive& prim, json& attributes, Primitive::e
     }
 }
 
-void glTF::Asset::ProcessMeshes( json& meshes, json& accessors )
+void glTF::Asset::ProcessMeshes( Json::Value meshes, const std::vector<Json::Value>& accessors )
 {
-    m_meshes.resize(meshes.size());
+    std::vector<Json::Value> meshValues;
+    meshes.GetElements(meshValues);
+    m_meshes.resize(meshValues.size());
 
-    uint32_t curMesh = 0;
-    for (json::iterator meshIt = meshes.begin(); meshIt != meshes.end(); ++meshIt, ++curMesh)
+    concurrency::parallel_for(size_t(0), meshValues.size(), [&](size_t curMesh)
     {
-        json& thisMesh = meshIt.value();
-        json& primitives = thisMesh.at("primitives");
+        Json::Value primitives = meshValues[curMesh].Find("primitives");
 
-        m_meshes[curMesh].primitives.resize(primitives.size());
+        m_meshes[curMesh].primitives.resize(primitives.Size());
         m_meshes[curMesh].skin = -1;
 
         uint32_t curSubMesh = 0;
-        for (json::iterator primIt = primitives.begin(); primIt != primitives.end(); ++primIt, ++curSubMesh)
+        primitives.ForEach([&](Json::Value thisPrim)
         {
-            glTF::Primitive& prim = m_meshes[curMesh].primitives[curSubMesh];
-            json& thisPrim = primIt.value();
+            glTF::Primitive& prim = m_meshes[curMesh].primitives[curSubMesh++];
 
             prim.attribMask = 0;
-            json& attributes = thisPrim.at("attributes");
+            Json::Value attributes = thisPrim.Find("attributes");
 
             FindAttribute(prim, attributes, Primitive::kPosition, "POSITION");
             FindAttribute(prim, attributes, Primitive::kNormal, "NORMAL");
@@ -261,9 +248,9 @@ void glTF::Asset::ProcessMeshes( json& meshes, json& accessors )
             FindAttribute(prim, attributes, Primitive::kWeights0, "WEIGHTS_0");
 
             // Read position AABB
-            json& positionAccessor = accessors[attributes.at("POSITION").get<uint32_t>()];
-            ReadFloats(positionAccessor.at("min"), prim.minPos);
-            ReadFloats(positionAccessor.at("max"), prim.maxPos);
+            Json::Value positionAccessor = accessors[attributes.Find("POSITION").GetUint32()];
+            ReadFloats(positionAccessor.Find("min"), prim.minPos);
+            ReadFloats(positionAccessor.Find("max"), prim.maxPos);
 
             prim.mode = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
             prim.indices = nullptr;
@@ -272,56 +259,53 @@ void glTF::Asset::ProcessMeshes( json& meshes, json& accessors )
             prim.maxIndex = 0;
             prim.mode = 4;
 
-            if (thisPrim.find("mode") != thisPrim.end())
-                prim.mode = thisPrim.at("mode");
+            prim.mode = (uint16_t)thisPrim.GetUint32("mode", prim.mode);
 
-            if (thisPrim.find("indices") != thisPrim.end())
+            Json::Value indices = thisPrim.Find("indices");
+            if (indices.IsValid())
             {
-                uint32_t accessorIndex = thisPrim.at("indices");
-                json& indicesAccessor = accessors[accessorIndex];
+                uint32_t accessorIndex = indices.GetUint32();
+                Json::Value indicesAccessor = accessors[accessorIndex];
                 prim.indices = &m_accessors[accessorIndex];
-                if (indicesAccessor.find("max") != indicesAccessor.end())
-                    prim.maxIndex = indicesAccessor.at("max")[0];
-                if (indicesAccessor.find("min") != indicesAccessor.end())
-                    prim.minIndex = indicesAccessor.at("min")[0];
+                if (indicesAccessor.Contains("max"))
+                    prim.maxIndex = indicesAccessor.Find("max")[0].GetUint32();
+                if (indicesAccessor.Contains("min"))
+                    prim.minIndex = indicesAccessor.Find("min")[0].GetUint32();
             }
 
-            if (thisPrim.find("material") != thisPrim.end())
-                prim.material = &m_materials[thisPrim.at("material")];
+            if (thisPrim.Contains("material"))
+                prim.material = &m_materials[thisPrim.Find("material").GetUint32()];
 
             // TODO:  Add morph targets
-            //if (thisPrim.find("targets") != thisPrim.end())
-        }
-    }
+            //if (thisPrim.Contains("targets"))
+        });
+    });
 }
 
-void glTF::Asset::ProcessSkins( json& skins )
+void glTF::Asset::ProcessSkins( Json::Value skins )
 {
     uint32_t skinIdx = 0;
 
-    for (json::iterator it = skins.begin(); it != skins.end(); ++it)
+    skins.ForEach([&](Json::Value thisSkin)
     {
         glTF::Skin& skin = m_skins[skinIdx++];
 
-        json& thisSkin = it.value();
-
         skin.inverseBindMatrices = nullptr;
         skin.skeleton = nullptr;
 
-        if (thisSkin.find("inverseBindMatrices") != thisSkin.end())
-            skin.inverseBindMatrices = &m_accessors[thisSkin.at("inverseBindMatrices")];
+        if (thisSkin.Contains("inverseBindMatrices"))
+            skin.inverseBindMatrices = &m_accessors[thisSkin.Find("inverseBindMatrices").GetUint32()];
 
-        if (thisSkin.find("skeleton") != thisSkin.end())
+        if (thisSkin.Contains("skeleton"))
         {
-            skin.skeleton = &m_nodes[thisSkin.at("skeleton")];
+            skin.skeleton = &m_nodes[thisSkin.Find("skeleton").GetUint32()];
             skin.skeleton->skeletonRoot = true;
         }
 
-        json& joints = thisSkin.at("joints");
-        skin.joints.reserve(joints.size());
-        for (auto& joint : joints)
-            skin.joints.push_back(&m_nodes[joint]);
-    }
+        Json::Value joints = thisSkin.Find("joints");
+        skin.joints.reserve(joints.Size());
+        joints.ForEach([&](Json::Value joint) { skin.joints.push_back(&m_nodes[joint.GetUint32()]); });
+    });
 }
 
 inline uint32_t floatToHalf( float f )
@@ -332,53 +316,50 @@ inline uint32_t floatToHalf( float f )
     return x.u >> 13;
 }
 
-uint32_t glTF::Asset::ReadTextureInfo( json& info_json, glTF::Texture* &info )
+uint32_t glTF::Asset::ReadTextureInfo( Json::Value info_json, glTF::Texture* &info )
 {
     info = nullptr;
 
-    if (info_json.find("index") != info_json.end())
-        info = &m_textures[info_json.at("index")];
+    if (info_json.Contains("index"))
+        info = &m_textures[info_json.Find("index").GetUint32()];
 
-    if (info_json.find("texCoord") != info_json.end())
-        return info_json.at("texCoord");
-    else
-        return 0;
+    return info_json.GetUint32("texCoord", 0);
 }
 
-void glTF::Asset::ProcessMaterials( json& materials )
+void glTF::Asset::ProcessMaterials( Json::Value materials )
 {
-    m_materials.reserve(materials.size());
+    std::vector<Json::Value> materialValues;
+    materials.GetElements(materialValues);
 
-    uint32_t materialIdx = 0;
-
-    for (json::iterator it = materials.begin(); it != materials.end(); ++it)
+    // m_materials is sized by Parse() because meshes point into it while this runs.
+    concurrency::parallel_for(size_t(0), materialValues.size(), [&](size_t materialIdx)
     {
-        glTF::Material material;
-        json& thisMaterial = it.value();
+        glTF::Material& material = m_materials[materialIdx];
+        Json::Value thisMaterial = materialValues[materialIdx];
 
-        material.index = materialIdx++;
+        material.index = (uint32_t)materialIdx;
         material.flags = 0;
         material.alphaCutoff = floatToHalf(0.5f);
         material.normalTextureScale = 1.0f;
 
-        if (thisMaterial.find("alphaMode") != thisMaterial.end())
+        Json::Value alphaMode = thisMaterial.Find("alphaMode");
+        if (alphaMode.IsValid())
         {
-            string alphaMode = thisMaterial.at("alphaMode");
-            if (alphaMode == "BLEND")
+            if (alphaMode.StringEquals("BLEND"))
                 material.alphaBlend = true;
-            else if (alphaMode == "MASK")
+            else if (alphaMode.StringEquals("MASK"))
                 material.alphaTest = true;
         }
 
-        if (thisMaterial.find("alphaCutoff") != thisMaterial.end())
+        if (thisMaterial.Contains("alphaCutoff"))
         {
-            material.alphaCutoff = floatToHalf(thisMaterial.at("alphaCutoff"));
+            material.alphaCutoff = floatToHalf(thisMaterial.Find("alphaCutoff").GetFloat());
             //material.alphaTest = true;  // Should we alpha test and alpha blend?
         }
 
-        if (thisMaterial.find("pbrMetallicRoughness") != thisMaterial.end())
+        Json::Value metallicRoughness = thisMaterial.Find("pbrMetallicRoughness");
+        if (metallicRoughness.IsValid())
         {
-            json& metallicRoughness = thisMaterial.at("pbrMetallicRoughness");
 
             material.baseColorFactor[0] = 1.0f;
             material.baseColorFactor[1] = 1.0f;
@@ -389,47 +370,41 @@ void glTF::Asset::ProcessMaterials( json& materials )
             for (uint32_t i = 0; i < Material::kNumTextures; ++i)
                 material.textures[i] = nullptr;
 
-            if (metallicRoughness.find("baseColorFactor") != metallicRoughness.end())
-                ReadFloats(metallicRoughness.at("baseColorFactor"), material.baseColorFactor);
-
-            if (metallicRoughness.find("metallicFactor") != metallicRoughness.end())
-                material.metallicFactor = metallicRoughness.at("metallicFactor");
+            if (metallicRoughness.Contains("baseColorFactor"))
+                ReadFloats(metallicRoughness.Find("baseColorFactor"), material.baseColorFactor);
 
-            if (metallicRoughness.find("roughnessFactor") != metallicRoughness.end())
-                material.roughnessFactor = metallicRoughness.at("roughnessFactor");
+            material.metallicFactor = metallicRoughness.GetFloat("metallicFactor", material.metallicFactor);
+            material.roughnessFactor = metallicRoughness.GetFloat("roughnessFactor", material.roughnessFactor);
 
-            if (metallicRoughness.find("baseColorTexture") != metallicRoughness.end())
-                material.baseColorUV = ReadTextureInfo(metallicRoughness.at("baseColorTexture"),
+            if (metallicRoughness.Contains("baseColorTexture"))
+                material.baseColorUV = ReadTextureInfo(metallicRoughness.Find("baseColorTexture"),
                     material.textures[Material::kBaseColor]);
 
-            if (metallicRoughness.find("metallicRoughnessTexture") != metallicRoughness.end())
-                material.metallicRoughnessUV = ReadTextureInfo(metallicRoughness.at("metallicRoughnessTexture"),
+            if (metallicRoughness.Contains("metallicRoughnessTexture"))
+                material.metallicRoughnessUV = ReadTextureInfo(metallicRoughness.Find("metallicRoughnessTexture"),
                     material.textures[Material::kMetallicRoughness]);
         }
 
-        if (thisMaterial.find("doubleSided") != thisMaterial.end())
-            material.twoSided = thisMaterial.at("doubleSided");
+        if (thisMaterial.Contains("doubleSided"))
+            material.twoSided = thisMaterial.Find("doubleSided").GetBool();
 
-        if (thisMaterial.find("normalTextureScale") != thisMaterial.end())
-            material.normalTextureScale = thisMaterial.at("normalTextureScale");
+        material.normalTextureScale = thisMaterial.GetFloat("normalTextureScale", material.normalTextureScale);
 
-        if (thisMaterial.find("emissiveFactor") != thisMaterial.end())
-            ReadFloats(thisMaterial.at("emissiveFactor"), material.emissiveFactor);
+        if (thisMaterial.Contains("emissiveFactor"))
+            ReadFloats(thisMaterial.Find("emissiveFactor"), material.emissiveFactor);
 
-        if (thisMaterial.find("occlusionTexture") != thisMaterial.end())
-            material.occlusionUV = ReadTextureInfo(thisMaterial.at("occlusionTexture"),
+        if (thisMaterial.Contains("occlusionTexture"))
+            material.occlusionUV = ReadTextureInfo(thisMaterial.Find("occlusionTexture"),
                 material.textures[Material::kOcclusion]);
 
-        if (thisMaterial.find("emissiveTexture") != thisMaterial.end())
-            material.emissiveUV = ReadTextureInfo(thisMaterial.at("emissiveTexture"),
+        if (thisMaterial.Contains("emissiveTexture"))
+            material.emissiveUV = ReadTextureInfo(thisMaterial.Find("emissiveTexture"),
                 material.textures[Material::kEmissive]);
 
-        if (thisMaterial.find("normalTexture") != thisMaterial.end())
-            material.normalUV = ReadTextureInfo(thisMaterial.at("normalTexture"),
+        if (thisMaterial.Contains("normalTexture"))
+            material.normalUV = ReadTextureInfo(thisMaterial.Find("normalTexture"),
                 material.textures[Material::kNormal]);
-
-        m_materials.push_back(material);
-    }
+    });
 }
 
 bool ReadFile(const wstring& fileName, void* Dest, size_t Size)
@@ -450,83 +425,78 @@ bool ReadFile(const wstring& fileName, void* Dest, size_t Size)
     return true;
 }
 
-void glTF::Asset::ProcessBuffers( json& buffers, ByteArray chunk1bin )
+void glTF::Asset::ProcessBuffers( Json::Value buffers, Buffer chunk1bin )
 {
-    m_buffers.reserve(buffers.size());
+    std::vector<Json::Value> bufferValues;
+    buffers.GetElements(bufferValues);
+    m_buffers.resize(bufferValues.size());
+    m_files.resize(bufferValues.size() + 1);
 
-    for (json::iterator it = buffers.begin(); it != buffers.end(); ++it)
+    // External buffers are mapped rather than read, so their pages are only loaded when the mesh compiler touches them.
+    concurrency::parallel_for(size_t(0), bufferValues.size(), [&](size_t bufferIdx)
     {
-        json& thisBuffer = it.value();
+        Json::Value uriValue = bufferValues[bufferIdx].Find("uri");
 
-        if (thisBuffer.find("uri") != thisBuffer.end())
+        if (uriValue.IsValid())
         {
-            const string& uri = thisBuffer.at("uri");
+            const string uri = uriValue.GetString();
             wstring filepath = m_basePath + wstring(uri.begin(), uri.end());
 
-            ByteArray ba = ReadFileSync(filepath);
-            ASSERT(ba->size() > 0, "Missing bin file %ws", filepath.c_str());
-            m_buffers.push_back(ba);
+            Utility::MappedFile& file = m_files[bufferIdx + 1];
+            file.Open(filepath);
+            ASSERT(file.GetSize() > 0, "Missing bin file %ws", filepath.c_str());
+            m_buffers[bufferIdx] = { (byte*)file.GetData(), file.GetSize() };
         }
         else
         {
-            ASSERT(it == buffers.begin(), "Only the 1st buffer allowed to be internal");
-            ASSERT(chunk1bin->size() > 0, "GLB chunk1 missing data or not a GLB file");
-            m_buffers.push_back(chunk1bin);
+            ASSERT(bufferIdx == 0, "Only the 1st buffer allowed to be internal");
+            ASSERT(chunk1bin.byteLength > 0, "GLB chunk1 missing data or not a GLB file");
+            m_buffers[bufferIdx] = chunk1bin;
         }
-    }
+    });
 }
 
-void glTF::Asset::ProcessBufferViews( json& bufferViews )
+void glTF::Asset::ProcessBufferViews( Json::Value bufferViews )
 {
-    m_bufferViews.reserve(bufferViews.size());
+    m_bufferViews.reserve(bufferViews.Size());
 
-    for (json::iterator it = bufferViews.begin(); it != bufferViews.end(); ++it)
+    bufferViews.ForEach([&](Json::Value thisBufferView)
     {
         glTF::BufferView bufferView;
-        json& thisBufferView = it.value();
-
-        bufferView.buffer = thisBufferView.at("buffer");
-        bufferView.byteLength = thisBufferView.at("byteLength");
-        bufferView.byteOffset = 0;
-        bufferView.byteStride = 0;
-        bufferView.elementArrayBuffer = false;
 
-        if (thisBufferView.find("byteOffset") != thisBufferView.end())
-            bufferView.byteOffset = thisBufferView.at("byteOffset");
-
-        if (thisBufferView.find("byteStride") != thisBufferView.end())
-            bufferView.byteStride = thisBufferView.at("byteStride");
+        bufferView.buffer = thisBufferView.Find("buffer").GetUint32();
+        bufferView.byteLength = thisBufferView.Find("byteLength").GetUint32();
+        bufferView.byteOffset = thisBufferView.GetUint32("byteOffset", 0);
+        bufferView.byteStride = (uint16_t)thisBufferView.GetUint32("byteStride", 0);
 
         // 34962 = ARRAY_BUFFER;  34963 = ELEMENT_ARRAY_BUFFER
-        if (thisBufferView.find("target") != thisBufferView.end() && thisBufferView.at("target") == 34963)
-            bufferView.elementArrayBuffer = true;
+        bufferView.elementArrayBuffer = thisBufferView.GetUint32("target", 0) == 34963;
 
         m_bufferViews.push_back(bufferView);
-    }
+    });
 }
 
-void glTF::Asset::ProcessImages( json& images )
+void glTF::Asset::ProcessImages( Json::Value images )
 {
-    m_images.resize(images.size());
-
     uint32_t imageIdx = 0;
 
-    for (json::iterator it = images.begin(); it != images.end(); ++it)
+    // m_images is sized by Parse() because textures point into it while this runs.
+    images.ForEach([&](Json::Value thisImage)
     {
-        json& thisImage = it.value();
-        if (thisImage.find("uri") != thisImage.end())
+        if (thisImage.Contains("uri"))
         {
-            m_images[imageIdx++].path = thisImage.at("uri").get<string>();
+            m_images[imageIdx].path = thisImage.Find("uri").GetString();
         }
-        else if (thisImage.find("bufferView") != thisImage.end())
+        else if (thisImage.Contains("bufferView"))
         {
-            Utility::Printf("GLB image at buffer view %d with mime type %s\n", thisImage.at("bufferView").get<uint32_t>(), thisImage.at("mimeType").get<string>().c_str());
+            Utility::Printf("GLB image at buffer view %d with mime type %s\n", thisImage.Find("bufferView").GetUint32(), thisImage.Find("mimeType").GetString().c_str());
         }
         else
         {
             ASSERT(0);
         }
-    }
+        ++imageIdx;
+    });
 }
 
 D3D12_TEXTURE_ADDRESS_MODE GLtoD3DTextureAddressMode( int32_t glWrapMode )
@@ -556,16 +526,12 @@ D3D12_FILTER GLtoD3DTextureFilterMode( int32_t magFilter, int32_t minFilter )
 }
 */
 
-void glTF::Asset::ProcessSamplers( json& samplers )
+void glTF::Asset::ProcessSamplers( Json::Value samplers )
 {
-    m_samplers.resize(samplers.size());
-
     uint32_t samplerIdx = 0;
 
-    for (json::iterator it = samplers.begin(); it != samplers.end(); ++it)
+    samplers.ForEach([&](Json::Value thisSampler)
     {
-        json& thisSampler = it.value();
-
         glTF::Sampler& sampler = m_samplers[samplerIdx++];
         sampler.filter = D3D12_FILTER_ANISOTROPIC;
         sampler.wrapS = D3D12_TEXTURE_ADDRESS_MODE_WRAP;
@@ -577,215 +543,303 @@ void glTF::Asset::ProcessSamplers( json& samplers )
         // the asset dictate that.  And AF isn't represented in WebGL, so blech.
         int32_t magFilter = 9729;
         int32_t minFilter = 9987;
-        if (thisSampler.find("magFilter") != thisSampler.end())
-            magFilter = thisSampler.at("magFilter");
-        if (thisSampler.find("minFilter") != thisSampler.end())
-            minFilter = thisSampler.at("minFilter");
+        magFilter = thisSampler.GetUint32("magFilter", magFilter);
+        minFilter = thisSampler.GetUint32("minFilter", minFilter);
         sampler.filter = GLtoD3DTextureFilterMode(magFilter, minFilter);
         */
 
         // But these could matter for correctness.  Though, where is border mode?
-        if (thisSampler.find("wrapS") != thisSampler.end())
-            sampler.wrapS = GLtoD3DTextureAddressMode(thisSampler.at("wrapS"));
-        if (thisSampler.find("wrapT") != thisSampler.end())
-            sampler.wrapT = GLtoD3DTextureAddressMode(thisSampler.at("wrapT"));
-    }
+        if (thisSampler.Contains("wrapS"))
+            sampler.wrapS = GLtoD3DTextureAddressMode(thisSampler.Find("wrapS").GetInt32());
+        if (thisSampler.Contains("wrapT"))
+            sampler.wrapT = GLtoD3DTextureAddressMode(thisSampler.Find("wrapT").GetInt32());
+    });
 }
 
-void glTF::Asset::ProcessTextures( json& textures )
+void glTF::Asset::ProcessTextures( Json::Value textures )
 {
-    m_textures.resize(textures.size());
-
     uint32_t texIdx = 0;
 
-    for (json::iterator it = textures.begin(); it != textures.end(); ++it)
+    textures.ForEach([&](Json::Value thisTexture)
     {
         glTF::Texture& texture = m_textures[texIdx++];
-        json& thisTexture = it.value();
 
         texture.source = nullptr;
         texture.sampler = nullptr;
 
-        if (thisTexture.find("source") != thisTexture.end())
-            texture.source = &m_images[thisTexture.at("source")];
+        if (thisTexture.Contains("source"))
+            texture.source = &m_images[thisTexture.Find("source").GetUint32()];
 
-        if (thisTexture.find("sampler") != thisTexture.end())
-            texture.sampler = &m_samplers[thisTexture.at("sampler")];
-    }
+        if (thisTexture.Contains("sampler"))
+            texture.sampler = &m_samplers[thisTexture.Find("sampler").GetUint32()];
+    });
 }
 
-void glTF::Asset::ProcessAnimations(json& animations)
+void glTF::Asset::ProcessAnimations(Json::Value animations)
 {
-    m_animations.resize(animations.size());
-    uint32_t animIdx = 0;
+    std::vector<Json::Value> animationValues;
+    animations.GetElements(animationValues);
+    m_animations.resize(animationValues.size());
 
-    // Process all animations
-    for (json::iterator it = animations.begin(); it != animations.end(); ++it)
+    // Process all animations.  m_nodes is sized by Parse(), so the channels can point at nodes that are not processed yet.
+    concurrency::parallel_for(size_t(0), animationValues.size(), [&](size_t animIdx)
     {
-        json& thisAnimation = it.value();
-        glTF::Animation& animation = m_animations[animIdx++];
+        Json::Value thisAnimation = animationValues[animIdx];
+        glTF::Animation& animation = m_animations[animIdx];
 
         // Process this animation's samplers
-        json& samplers = thisAnimation.at("samplers");
-        animation.m_samplers.resize(samplers.size());
+        Json::Value samplers = thisAnimation.Find("samplers");
+        animation.m_samplers.resize(samplers.Size());
         uint32_t samplerIdx = 0;
 
-        for (json::iterator it2 = samplers.begin(); it2 != samplers.end(); ++it2)
+        samplers.ForEach([&](Json::Value thisSampler)
         {
-            json& thisSampler = it2.value();
             glTF::AnimSampler& sampler = animation.m_samplers[samplerIdx++];
-            sampler.m_input = &m_accessors[thisSampler.at("input")];
-            sampler.m_output = &m_accessors[thisSampler.at("output")];
+            sampler.m_input = &m_accessors[thisSampler.Find("input").GetUint32()];
+            sampler.m_output = &m_accessors[thisSampler.Find("output").GetUint32()];
             sampler.m_interpolation = AnimSampler::kLinear;
-            if (thisSampler.find("interpolation") != thisSampler.end())
+            Json::Value interpolation = thisSampler.Find("interpolation");
+            if (interpolation.IsValid())
             {
-                const std::string& interpolation = thisSampler.at("interpolation");
-                if (interpolation == "LINEAR")
+                if (interpolation.StringEquals("LINEAR"))
                     sampler.m_interpolation = AnimSampler::kLinear;
-                else if (interpolation == "STEP")
+                else if (interpolation.StringEquals("STEP"))
                     sampler.m_interpolation = AnimSampler::kStep;
-                else if (interpolation == "CATMULLROMSPLINE")
+                else if (interpolation.StringEquals("CATMULLROMSPLINE"))
                     sampler.m_interpolation = AnimSampler::kCatmullRomSpline;
-                else if (interpolation == "CUBICSPLINE")
+                else if (interpolation.StringEquals("CUBICSPLINE"))
                     sampler.m_interpolation = AnimSampler::kCubicSpline;
             }
-        }
+        });
 
         // Process this animation's channels
-        json& channels = thisAnimation.at("channels");
-        animation.m_channels.resize(channels.size());
+        Json::Value channels = thisAnimation.Find("channels");
+        animation.m_channels.resize(channels.Size());
         uint32_t channelIdx = 0;
 
-        for (json::iterator it2 = channels.begin(); it2 != channels.end(); ++it2)
+        channels.ForEach([&](Json::Value thisChannel)
         {
-            json& thisChannel = it2.value();
             glTF::AnimChannel& channel = animation.m_channels[channelIdx++];
-            channel.m_sampler = &animation.m_samplers[thisChannel.at("sampler")];
-            json& thisTarget = thisChannel.at("target");
-            channel.m_target = &m_nodes[thisTarget.at("node")];
-            const std::string& path = thisTarget.at("path");
-            if (path == "translation")
+            channel.m_sampler = &animation.m_samplers[thisChannel.Find("sampler").GetUint32()];
+            Json::Value thisTarget = thisChannel.Find("target");
+            channel.m_target = &m_nodes[thisTarget.Find("node").GetUint32()];
+            Json::Value path = thisTarget.Find("path");
+            if (path.StringEquals("translation"))
                 channel.m_path = AnimChannel::kTranslation;
-            else if (path == "rotation")
+            else if (path.StringEquals("rotation"))
                 channel.m_path = AnimChannel::kRotation;
-            else if (path == "scale")
+            else if (path.StringEquals("scale"))
                 channel.m_path = AnimChannel::kScale;
-            else if (path == "weights")
+            else if (path.StringEquals("weights"))
                 channel.m_path = AnimChannel::kWeights;
-        }
-    }
+        });
+    });
 }
 
-void glTF::Asset::Parse(const std::wstring& filepath)
+// Finds the JSON text of a .gltf or .glb file and, in a .glb file, the optional BIN chunk.  Both are views into
+// fileData.
+static bool FindChunks(const std::wstring& filepath, const uint8_t* fileData, size_t fileSize,
+    const char*& jsonBegin, const char*& jsonEnd, Buffer& chunk1Bin)
 {
-    // TODO:  add GLB support by extracting JSON section and BIN sections
     //https://github.com/KhronosGroup/glTF/blob/master/specification/2.0/README.md#glb-file-format-specification
 
-    ByteArray gltfFile;
-    ByteArray chunk1Bin;
+    jsonBegin = (const char*)fileData;
+    jsonEnd = jsonBegin + fileSize;
+    chunk1Bin = { nullptr, 0 };
 
     std::wstring fileExt = Utility::ToLower(Utility::GetFileExtension(filepath));
 
     if (fileExt == L"glb")
     {
-        ifstream glbFile(filepath, ios::in | ios::binary);
         struct GLBHeader
         {
             char magic[4];
             uint32_t version;
             uint32_t length;
-        } header;
-        glbFile.read((char*)&header, sizeof(GLBHeader));
+        };
+        struct GLBChunkHeader
+        {
+            uint32_t length;
+            char type[4];
+        };
+
+        GLBHeader header;
+        GLBChunkHeader chunk0;
+        if (fileSize < sizeof(GLBHeader) + sizeof(GLBChunkHeader))
+        {
+            Utility::Printf("Error:  Invalid glTF binary format\n");
+            return false;
+        }
+        memcpy(&header, fileData, sizeof(GLBHeader));
         if (strncmp(header.magic, "glTF", 4) != 0)
         {
             Utility::Printf("Error:  Invalid glTF binary format\n");
-            return;
+            return false;
         }
         if (header.version != 2)
         {
             Utility::Printf("Error:  Only glTF 2.0 is supported\n");
-            return;
+            return false;
         }
 
-        uint32_t chunk0Length;
-        char chunk0Type[4];
-        glbFile.read((char*)&chunk0Length, 4);
-        glbFile.read((char*)&chunk0Type, 4);
-        if (strncmp(chunk0Type, "JSON", 4) != 0)
+        size_t offset = sizeof(GLBHeader);
+        memcpy(&chunk0, fileData + offset, sizeof(GLBChunkHeader));
+        offset += sizeof(GLBChunkHeader);
+        if (strncmp(chunk0.type, "JSON", 4) != 0)
         {
             Utility::Printf("Error: Expected chunk0 to contain JSON\n");
-            return;
+            return false;
         }
-        gltfFile = make_shared<vector<byte>>( chunk0Length + 1 );
-        glbFile.read((char*)gltfFile->data(), chunk0Length);
-        (*gltfFile)[chunk0Length] = '\0';
-
-        uint32_t chunk1Length;
-        char chunk1Type[4];
-        glbFile.read((char*)&chunk1Length, 4);
-        glbFile.read((char*)&chunk1Type, 4);
-        if (strncmp(chunk1Type, "BIN", 3) != 0)
+        if (chunk0.length > fileSize - offset)
         {
-            Utility::Printf("Error: Expected chunk1 to contain BIN\n");
-            return;
-       }
+            Utility::Printf("Error:  Truncated glTF binary file\n");
+            return false;
+        }
+        jsonBegin = (const char*)fileData + offset;
+        jsonEnd = jsonBegin + chunk0.length;
+        offset += chunk0.length;
 
-        chunk1Bin = make_shared<vector<byte>>(chunk1Length);
-        glbFile.read((char*)chunk1Bin->data(), chunk1Length);
+        // The BIN chunk is optional.  Chunks are 4-byte aligned, which keeps the accessors aligned within the mapping.
+        if (fileSize - offset >= sizeof(GLBChunkHeader))
+        {
+            GLBChunkHeader chunk1;
+            memcpy(&chunk1, fileData + offset, sizeof(GLBChunkHeader));
+            offset += sizeof(GLBChunkHeader);
+            if (strncmp(chunk1.type, "BIN", 3) != 0)
+            {
+                Utility::Printf("Error: Expected chunk1 to contain BIN\n");
+                return false;
+            }
+            if (chunk1.length > fileSize - offset)
+            {
+                Utility::Printf("Error:  Truncated glTF binary file\n");
+                return false;
+            }
+            chunk1Bin = { (byte*)fileData + offset, chunk1.length };
+        }
     }
     else 
     {
         ASSERT(fileExt == L"gltf");
+    }
+
+    return true;
+}
 
-        // Null terminate the string (just in case)
-        gltfFile = ReadFileSync(filepath);
-        if (gltfFile->size() == 0)
-            return;
+bool glTF::Asset::MapSourceFiles(const std::wstring& filepath, std::vector<Utility::MappedFile>& files)
+{
+    files.clear();
+    files.resize(1);
+    if (!files[0].Open(filepath) || files[0].GetSize() == 0)
+        return false;
+
+    const char* jsonBegin;
+    const char* jsonEnd;
+    Buffer chunk1Bin;
+    if (!FindChunks(filepath, files[0].GetData(), files[0].GetSize(), jsonBegin, jsonEnd, chunk1Bin))
+        return false;
 
-        gltfFile->push_back('\0');
-        chunk1Bin = make_shared<vector<byte>>(0);
+    // Only the buffers are read, so the cost is the tape of the JSON and none of the Process*() functions.
+    Json::Document document;
+    if (!document.Parse(jsonBegin, jsonEnd) || !document.GetRoot().IsObject())
+        return false;
+
+    // The same paths as ProcessBuffers(), in the same order, so that files matches m_files of the parsed asset.
+    const std::wstring basePath = Utility::GetBasePath(filepath);
+    std::vector<Json::Value> bufferValues;
+    document.GetRoot().Find("buffers").GetElements(bufferValues);
+    files.resize(bufferValues.size() + 1);
+    for (size_t bufferIdx = 0; bufferIdx < bufferValues.size(); ++bufferIdx)
+    {
+        Json::Value uriValue = bufferValues[bufferIdx].Find("uri");
+        if (uriValue.IsValid())
+        {
+            const string uri = uriValue.GetString();
+            if (!files[bufferIdx + 1].Open(basePath + wstring(uri.begin(), uri.end())))
+                return false;
+        }
+    }
+    return true;
+}
+
+void glTF::Asset::Parse(const std::wstring& filepath)
+{
+    // The file is mapped rather than read.  The JSON is parsed straight out of the mapping, and the BIN chunk of
+    // a GLB file is used in place as buffer 0, so neither is copied onto the heap.
+    // ProcessBuffers() adds the buffer files to m_files, which moves this one, so only its mapping is kept here.
+    m_files.resize(1);
+    if (!m_files[0].Open(filepath) || m_files[0].GetSize() == 0)
+    {
+        Utility::Printf(L"Error:  Cannot read %ws\n", filepath.c_str());
+        return;
     }
+    const uint8_t* fileData = m_files[0].GetData();
+    const size_t fileSize = m_files[0].GetSize();
+
+    const char* jsonBegin;
+    const char* jsonEnd;
+    Buffer chunk1Bin;
+    if (!FindChunks(filepath, fileData, fileSize, jsonBegin, jsonEnd, chunk1Bin))
+        return;
 
-    json root = json::parse((const char*)gltfFile->data());
-    if (!root.is_object())
+    // The tape references the strings of the mapped file in place.  It is only needed while the sections are processed.
+    Json::Document document;
+    if (!document.Parse(jsonBegin, jsonEnd) || !document.GetRoot().IsObject())
     {
-        Printf("Invalid glTF file: %s\n", filepath.c_str());
+        Printf(L"Invalid glTF file: %ws (JSON error at byte %zu)\n", filepath.c_str(), document.GetErrorOffset());
         return;
     }
+    Json::Value root = document.GetRoot();
 
     // Strip off file name to get root path to other related files
     m_basePath = Utility::GetBasePath(filepath);
 
+    // Absent sections are invalid values, which have no elements.
+    Json::Value buffers = root.Find("buffers");
+    Json::Value bufferViews = root.Find("bufferViews");
+    Json::Value images = root.Find("images");
+    Json::Value samplers = root.Find("samplers");
+    Json::Value textures = root.Find("textures");
+    Json::Value materials = root.Find("materials");
+    Json::Value meshes = root.Find("meshes");
+    Json::Value nodes = root.Find("nodes");
+    Json::Value skins = root.Find("skins");
+    Json::Value cameras = root.Find("cameras");
+    Json::Value animations = root.Find("animations");
+    Json::Value scenes = root.Find("scenes");
+
+    // Meshes look their position bounds up by accessor index, so the accessors are indexed once.
+    std::vector<Json::Value> accessors;
+    root.Find("accessors").GetElements(accessors);
+
     // Parse all state
 
-    if (root.find("buffers") != root.end())
-        ProcessBuffers(root.at("buffers"), chunk1Bin);
-    if (root.find("bufferViews") != root.end())
-        ProcessBufferViews(root.at("bufferViews"));
-    if (root.find("accessors") != root.end())
-        ProcessAccessors(root.at("accessors"));
-    if (root.find("images") != root.end())
-        ProcessImages(root.at("images"));
-    if (root.find("samplers") != root.end())
-        ProcessSamplers(root.at("samplers"));
-    if (root.find("textures") != root.end())
-        ProcessTextures(root.at("textures"));
-    if (root.find("materials") != root.end())
-        ProcessMaterials(root.at("materials"));
-    if (root.find("meshes") != root.end())
-        ProcessMeshes(root.at("meshes"), root.at("accessors"));
-    if (root.find("cameras") != root.end())
-        ProcessCameras(root.at("cameras"));
-    if (root.find("skins") != root.end())
-        m_skins.resize(root.at("skins").size());
-    if (root.find("nodes") != root.end())
-        ProcessNodes(root.at("nodes"));
-    if (root.find("skins") != root.end())
-        ProcessSkins(root.at("skins"));
-    if (root.find("scenes") != root.end())
-        ProcessScenes(root.at("scenes"));
-    if (root.find("animations") != root.end())
-        ProcessAnimations(root.at("animations"));
-    if (root.find("scene") != root.end())
-        m_scene = &m_scenes[root.at("scene")];
+    // Everything else reads through the accessors, so buffers, buffer views and accessors are resolved first.
+    ProcessBuffers(buffers, chunk1Bin);
+    ProcessBufferViews(bufferViews);
+    ProcessAccessors(accessors);
+
+    // The remaining sections only take the addresses of each other's elements, so every array that is pointed
+    // into is sized first.  The independent sections then run concurrently.
+    m_images.resize(images.Size());
+    m_samplers.resize(samplers.Size());
+    m_textures.resize(textures.Size());
+    m_materials.resize(materials.Size());
+    m_nodes.resize(nodes.Size());
+    m_skins.resize(skins.Size());
+
+    concurrency::parallel_invoke(
+        [&] { ProcessImages(images); ProcessSamplers(samplers); ProcessTextures(textures); },
+        [&] { ProcessMaterials(materials); },
+        [&] { ProcessMeshes(meshes, accessors); },
+        [&] { ProcessCameras(cameras); },
+        [&] { ProcessAnimations(animations); }
+    );
+
+    // Nodes set the skin of their meshes, and skins flag their skeleton root nodes.
+    ProcessNodes(nodes);
+    ProcessSkins(skins);
+    ProcessScenes(scenes);
+    if (root.Contains("scene"))
+        m_scene = &m_scenes[root.Find("scene").GetUint32()];
 }
@@ -14,22 +14,21 @@
 #pragma once
 
 #include "../Core/FileUtility.h"
-
-#ifndef _WIN32
-#define _WIN32
-#endif
-#pragma warning(push)
-#pragma warning(disable : 4100) // unreferenced formal parameter
-#include "json.hpp"
-#pragma warning(pop)
+#include "../Core/MappedFile.h"
+#include "JsonTape.h"
 
 #include <string>
 
 namespace glTF
 {
-    using json = nlohmann::json;
     using Utility::ByteArray;
 
+    struct Buffer
+    {
+        byte* data; // view into one of Asset::m_files
+        size_t byteLength;
+    };
+
     struct BufferView
     {
         uint32_t buffer;
@@ -246,6 +245,10 @@ namespace glTF
 
         void Parse(const std::wstring& filepath);
 
+        // Maps the .gltf or .glb file and its external buffer files, as m_files of the parsed asset would hold
+        // them, without processing the asset.  Enough to tell whether the source of a model has changed.
+        static bool MapSourceFiles(const std::wstring& filepath, std::vector<Utility::MappedFile>& files);
+
         Scene* m_scene;
         std::wstring m_basePath;
         std::vector<Scene> m_scenes;
@@ -258,26 +261,30 @@ namespace glTF
         std::vector<Accessor> m_accessors;
         std::vector<Skin> m_skins;
         std::vector<Material> m_materials;
-        std::vector<ByteArray> m_buffers;
+        std::vector<Buffer> m_buffers;
         std::vector<BufferView> m_bufferViews;
         std::vector<Animation> m_animations;
 
+        // The .gltf or .glb file followed by the external buffer files, indexed by buffer + 1.  They stay mapped for
+        // the lifetime of the asset because the JSON is parsed from them and m_buffers and the accessors point into them.
+        std::vector<Utility::MappedFile> m_files;
+
     private:
-        void ProcessBuffers( json& buffers, ByteArray chunk1bin );
-        void ProcessBufferViews( json& bufferViews );
-        void ProcessAccessors( json& accessors );
-        void ProcessMaterials( json& materials );
-        void ProcessTextures( json& textures );
-        void ProcessSamplers( json& samplers );
-        void ProcessImages( json& images );
-        void ProcessSkins( json& skins );
-        void ProcessMeshes( json& meshes, json& accessors );
-        void ProcessNodes( json& nodes );
-        void ProcessAnimations( json& nodes );
-        void ProcessCameras( json& cameras );
-        void ProcessScenes( json& scenes );
-        void FindAttribute( Primitive& prim, json& attributes, Primitive::eAttribType type, const std::string& name);
-        uint32_t ReadTextureInfo( json& info_json, glTF::Texture* &info );
+        void ProcessBuffers( Json::Value buffers, Buffer chunk1bin );
+        void ProcessBufferViews( Json::Value bufferViews );
+        void ProcessAccessors( const std::vector<Json::Value>& accessors );
+        void ProcessMaterials( Json::Value materials );
+        void ProcessTextures( Json::Value textures );
+        void ProcessSamplers( Json::Value samplers );
+        void ProcessImages( Json::Value images );
+        void ProcessSkins( Json::Value skins );
+        void ProcessMeshes( Json::Value meshes, const std::vector<Json::Value>& accessors );
+        void ProcessNodes( Json::Value nodes );
+        void ProcessAnimations( Json::Value animations );
+        void ProcessCameras( Json::Value cameras );
+        void ProcessScenes( Json::Value scenes );
+        void FindAttribute( Primitive& prim, Json::Value attributes, Primitive::eAttribType type, const char* name);
+        uint32_t ReadTextureInfo( Json::Value info_json, glTF::Texture* &info );
     };
 
 
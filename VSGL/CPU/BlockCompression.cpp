@@ -0,0 +1,1053 @@
+#include "BlockCompression.hpp"
+
+#include "SIMD.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <iterator>
+#include <utility>
+
+namespace vsgl::cpu
+{
+namespace
+{
+constexpr uint32_t BLOCK_TEXELS = 16;
+
+// Subset 1 of the 2-subset partitions of BC6H and BC7, one bit per texel.
+constexpr uint16_t PARTITIONS2[64] = {
+	0xCCCC, 0x8888, 0xEEEE, 0xECC8, 0xC880, 0xFEEC, 0xFEC8, 0xEC80, 0xC800, 0xFFEC, 0xFE80, 0xE800, 0xFFE8, 0xFF00, 0xFFF0, 0xF000,
+	0xF710, 0x008E, 0x7100, 0x08CE, 0x008C, 0x7310, 0x3100, 0x8CCE, 0x088C, 0x3110, 0x6666, 0x366C, 0x17E8, 0x0FF0, 0x718E, 0x399C,
+	0xAAAA, 0xF0F0, 0x5A5A, 0x33CC, 0x3C3C, 0x55AA, 0x9696, 0xA55A, 0x73CE, 0x13C8, 0x324C, 0x3BDC, 0x6996, 0xC33C, 0x9966, 0x0660,
+	0x0272, 0x04E4, 0x4E40, 0x2720, 0xC936, 0x936C, 0x39C6, 0x639C, 0x9336, 0x9CC6, 0x817E, 0xE718, 0xCCF0, 0x0FCC, 0x7744, 0xEE22,
+};
+
+// The 3-subset partitions of BC7, two bits per texel.
+constexpr uint32_t PARTITIONS3[64] = {
+	0xAA685050, 0x6A5A5040, 0x5A5A4200, 0x5450A0A8, 0xA5A50000, 0xA0A05050, 0x5555A0A0, 0x5A5A5050,
+	0xAA550000, 0xAA555500, 0xAAAA5500, 0x90909090, 0x94949494, 0xA4A4A4A4, 0xA9A59450, 0x2A0A4250,
+	0xA5945040, 0x0A425054, 0xA5A5A500, 0x55A0A0A0, 0xA8A85454, 0x6A6A4040, 0xA4A45000, 0x1A1A0500,
+	0x0050A4A4, 0xAAA59090, 0x14696914, 0x69691400, 0xA08585A0, 0xAA821414, 0x50A4A450, 0x6A5A0200,
+	0xA9A58000, 0x5090A0A8, 0xA8A09050, 0x24242424, 0x00AA5500, 0x24924924, 0x24499224, 0x50A50A50,
+	0x500AA550, 0xAAAA4444, 0x66660000, 0xA5A0A5A0, 0x50A050A0, 0x69286928, 0x44AAAA44, 0x66666600,
+	0xAA444444, 0x54A854A8, 0x95809580, 0x96969600, 0xA85454A8, 0x80959580, 0xAA141414, 0x96960000,
+	0xAAAA1414, 0xA05050A0, 0xA0A5A5A0, 0x96000000, 0x40804080, 0xA9A8A9A8, 0xAAAAAA44, 0x2A4A5254,
+};
+
+// Anchor texels, whose index drops its most significant bit: subset 1 of the 2-subset partitions and subsets 1 and 2 of the 3-subset partitions.
+// Texel 0 is the anchor of subset 0.
+constexpr uint8_t ANCHORS2[64] = {
+	15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 2, 8, 2, 2, 8, 8, 15, 2, 8, 2, 2, 8, 8, 2, 2,
+	15, 15, 6, 8, 2, 8, 15, 15, 2, 8, 2, 2, 2, 15, 15, 6, 6, 2, 6, 8, 15, 15, 2, 2, 15, 15, 15, 15, 15, 2, 2, 15,
+};
+constexpr uint8_t ANCHORS3[2][64] = {
+	{
+		3, 3, 15, 15, 8, 3, 15, 15, 8, 8, 6, 6, 6, 5, 3, 3, 3, 3, 8, 15, 3, 3, 6, 10, 5, 8, 8, 6, 8, 5, 15, 15,
+		8, 15, 3, 5, 6, 10, 8, 15, 15, 3, 15, 5, 15, 15, 15, 15, 3, 15, 5, 5, 5, 8, 5, 10, 5, 10, 8, 13, 15, 12, 3, 3,
+	},
+	{
+		15, 8, 8, 3, 15, 15, 3, 8, 15, 15, 15, 15, 15, 15, 15, 8, 15, 8, 15, 3, 15, 8, 15, 8, 3, 15, 6, 10, 15, 15, 10, 8,
+		15, 3, 15, 10, 10, 8, 9, 10, 6, 15, 8, 15, 3, 6, 6, 8, 15, 3, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 3, 15, 15, 8,
+	},
+};
+
+// Interpolation weights of 2-, 3- and 4-bit indices in 1/64 units.
+constexpr uint8_t WEIGHTS2[4] = {0, 21, 43, 64};
+constexpr uint8_t WEIGHTS3[8] = {0, 9, 18, 27, 37, 46, 55, 64};
+constexpr uint8_t WEIGHTS4[16] = {0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64};
+
+const uint8_t* GetWeights(const uint32_t indexBits)
+{
+	return indexBits == 2 ? WEIGHTS2 : indexBits == 3 ? WEIGHTS3 : WEIGHTS4;
+}
+
+uint32_t Load16(const uint8_t* p)
+{
+	return p[0] | (p[1] << 8);
+}
+
+uint32_t Load32(const uint8_t* p)
+{
+	uint32_t value;
+	std::memcpy(&value, p, sizeof(value));
+	return value;
+}
+
+uint64_t Load64(const uint8_t* p)
+{
+	uint64_t value;
+	std::memcpy(&value, p, sizeof(value));
+	return value;
+}
+
+uint32_t PackRGBA(const uint32_t r, const uint32_t g, const uint32_t b, const uint32_t a)
+{
+	return r | (g << 8) | (b << 16) | (a << 24);
+}
+
+// Reads the fields of a 128-bit block from the least significant bit.
+class BitReader
+{
+  public:
+	explicit BitReader(const uint8_t* block) : m_low(Load64(block)), m_high(Load64(block + 8)) {}
+
+	uint32_t Read(const uint32_t count) // count <= 32
+	{
+		uint64_t bits;
+
+		if (m_position >= 64)
+		{
+			bits = m_high >> (m_position - 64);
+		}
+		else if (m_position + count <= 64)
+		{
+			bits = m_low >> m_position;
+		}
+		else
+		{
+			bits = (m_low >> m_position) | (m_high << (64 - m_position));
+		}
+
+		m_position += count;
+		return static_cast<uint32_t>(bits & ((uint64_t{1} << count) - 1));
+	}
+
+	void Skip(const uint32_t count) { m_position += count; }
+
+  private:
+	uint64_t m_low;
+	uint64_t m_high;
+	uint32_t m_position = 0;
+};
+
+void StoreBlock(const uint32_t (&texels)[BLOCK_TEXELS], uint8_t* output, const size_t rowPitch)
+{
+	for (uint32_t y = 0; y < 4; ++y)
+	{
+		std::memcpy(output + y * rowPitch, texels + y * 4, 4 * sizeof(uint32_t));
+	}
+}
+
+void StoreBlock(const uint64_t (&texels)[BLOCK_TEXELS], uint8_t* output, const size_t rowPitch)
+{
+	for (uint32_t y = 0; y < 4; ++y)
+	{
+		std::memcpy(output + y * rowPitch, texels + y * 4, 4 * sizeof(uint64_t));
+	}
+}
+
+//
+// BC1-BC5
+//
+
+// The RGB block of BC1-BC3. Only BC1 has the 3-color mode with transparent black when color0 <= color1; BC2 and BC3 always interpolate 4 colors.
+void DecodeColors(const uint8_t* block, const bool bc1, uint32_t (&texels)[BLOCK_TEXELS])
+{
+	const uint32_t c0 = Load16(block);
+	const uint32_t c1 = Load16(block + 2);
+	const uint32_t indices = Load32(block + 4);
+
+	const uint32_t r0 = ((c0 >> 11) << 3) | (c0 >> 13);
+	const uint32_t g0 = (((c0 >> 5) & 63) << 2) | ((c0 >> 9) & 3);
+	const uint32_t b0 = ((c0 & 31) << 3) | ((c0 >> 2) & 7);
+	const uint32_t r1 = ((c1 >> 11) << 3) | (c1 >> 13);
+	const uint32_t g1 = (((c1 >> 5) & 63) << 2) | ((c1 >> 9) & 3);
+	const uint32_t b1 = ((c1 & 31) << 3) | ((c1 >> 2) & 7);
+
+	uint32_t palette[4] = {PackRGBA(r0, g0, b0, 255), PackRGBA(r1, g1, b1, 255)};
+
+	if (c0 > c1 || !bc1)
+	{
+		palette[2] = PackRGBA((2 * r0 + r1 + 1) / 3, (2 * g0 + g1 + 1) / 3, (2 * b0 + b1 + 1) / 3, 255);
+		palette[3] = PackRGBA((r0 + 2 * r1 + 1) / 3, (g0 + 2 * g1 + 1) / 3, (b0 + 2 * b1 + 1) / 3, 255);
+	}
+	else
+	{
+		palette[2] = PackRGBA((r0 + r1 + 1) / 2, (g0 + g1 + 1) / 2, (b0 + b1 + 1) / 2, 255);
+		palette[3] = 0;
+	}
+
+	for (uint32_t i = 0; i < BLOCK_TEXELS; ++i)
+	{
+		texels[i] = palette[(indices >> (2 * i)) & 3];
+	}
+}
+
+// The 4-bit alpha of BC2.
+void DecodeExplicitAlpha(const uint8_t* block, uint32_t (&texels)[BLOCK_TEXELS])
+{
+	const uint64_t alpha = Load64(block);
+
+	for (uint32_t i = 0; i < BLOCK_TEXELS; ++i)
+	{
+		texels[i] = (texels[i] & 0x00ffffffu) | (static_cast<uint32_t>((alpha >> (4 * i)) & 15) * 17 << 24);
+	}
+}
+
+// One channel of BC3 (alpha), BC4 and BC5: two 8-bit endpoints and 3-bit indices. The result is 8-bit, two's complement for SNORM.
+void DecodeChannel(const uint8_t* block, const bool snorm, uint32_t (&values)[BLOCK_TEXELS])
+{
+	int32_t palette[8];
+
+	if (snorm)
+	{
+		const int32_t a = std::max<int32_t>(static_cast<int8_t>(block[0]), -127);
+		const int32_t b = std::max<int32_t>(static_cast<int8_t>(block[1]), -127);
+		const auto divide = [](const int32_t x, const int32_t d) { return (x + (x < 0 ? -d / 2 : d / 2)) / d; };
+		palette[0] = a;
+		palette[1] = b;
+
+		if (a > b)
+		{
+			for (int32_t i = 2; i < 8; ++i)
+			{
+				palette[i] = divide((8 - i) * a + (i - 1) * b, 7);
+			}
+		}
+		else
+		{
+			for (int32_t i = 2; i < 6; ++i)
+			{
+				palette[i] = divide((6 - i) * a + (i - 1) * b, 5);
+			}
+			palette[6] = -127;
+			palette[7] = 127;
+		}
+	}
+	else
+	{
+		const int32_t a = block[0];
+		const int32_t b = block[1];
+		palette[0] = a;
+		palette[1] = b;
+
+		if (a > b)
+		{
+			for (int32_t i = 2; i < 8; ++i)
+			{
+				palette[i] = ((8 - i) * a + (i - 1) * b + 3) / 7;
+			}
+		}
+		else
+		{
+			for (int32_t i = 2; i < 6; ++i)
+			{
+				palette[i] = ((6 - i) * a + (i - 1) * b + 2) / 5;
+			}
+			palette[6] = 0;
+			palette[7] = 255;
+		}
+	}
+
+	const uint64_t indices = Load64(block) >> 16;
+
+	for (uint32_t i = 0; i < BLOCK_TEXELS; ++i)
+	{
+		values[i] = static_cast<uint32_t>(palette[(indices >> (3 * i)) & 7]) & 0xff;
+	}
+}
+
+//
+// BC6H
+//
+
+enum BC6H_FIELD : uint8_t
+{
+	BC6H_W, // Endpoints 0 and 1 of region 0 and 0 and 1 of region 1, as named by the specification.
+	BC6H_X,
+	BC6H_Y,
+	BC6H_Z,
+	BC6H_D, // Partition.
+};
+
+// A run of the bits of a field: bits [lowBit, lowBit + bitCount) of one channel of a field, in the order of the block, or from the highest bit down
+// when reversed.
+struct BC6HBits
+{
+	uint8_t field;
+	uint8_t channel;
+	uint8_t lowBit;
+	uint8_t bitCount;
+	bool reversed = false;
+};
+
+struct BC6HMode
+{
+	uint8_t regionCount;
+	bool transformed; // x, y and z are deltas from w.
+	uint8_t endpointBits;
+	uint8_t deltaBits[3];
+	BC6HBits layout[26]; // Terminated by bitCount == 0.
+};
+
+// The 14 modes in the order of the specification, each after its 2- or 5-bit mode field.
+constexpr BC6HMode BC6H_MODES[14] = {
+	{2, true, 10, {5, 5, 5}, {{BC6H_Y, 1, 4, 1}, {BC6H_Y, 2, 4, 1}, {BC6H_Z, 2, 4, 1}, {BC6H_W, 0, 0, 10}, {BC6H_W, 1, 0, 10}, {BC6H_W, 2, 0, 10}, {BC6H_X, 0, 0, 5},
+	                          {BC6H_Z, 1, 4, 1}, {BC6H_Y, 1, 0, 4}, {BC6H_X, 1, 0, 5}, {BC6H_Z, 2, 0, 1}, {BC6H_Z, 1, 0, 4}, {BC6H_X, 2, 0, 5}, {BC6H_Z, 2, 1, 1},
+	                          {BC6H_Y, 2, 0, 4}, {BC6H_Y, 0, 0, 5}, {BC6H_Z, 2, 2, 1}, {BC6H_Z, 0, 0, 5}, {BC6H_Z, 2, 3, 1}, {BC6H_D, 0, 0, 5}}},
+	{2, true, 7, {6, 6, 6}, {{BC6H_Y, 1, 5, 1}, {BC6H_Z, 1, 4, 1}, {BC6H_Z, 1, 5, 1}, {BC6H_W, 0, 0, 7}, {BC6H_Z, 2, 0, 1}, {BC6H_Z, 2, 1, 1}, {BC6H_Y, 2, 4, 1},
+	                         {BC6H_W, 1, 0, 7}, {BC6H_Y, 2, 5, 1}, {BC6H_Z, 2, 2, 1}, {BC6H_Y, 1, 4, 1}, {BC6H_W, 2, 0, 7}, {BC6H_Z, 2, 3, 1}, {BC6H_Z, 2, 5, 1},
+	                         {BC6H_Z, 2, 4, 1}, {BC6H_X, 0, 0, 6}, {BC6H_Y, 1, 0, 4}, {BC6H_X, 1, 0, 6}, {BC6H_Z, 1, 0, 4}, {BC6H_X, 2, 0, 6}, {BC6H_Y, 2, 0, 4},
+	                         {BC6H_Y, 0, 0, 6}, {BC6H_Z, 0, 0, 6}, {BC6H_D, 0, 0, 5}}},
+	{2, true, 11, {5, 4, 4}, {{BC6H_W, 0, 0, 10}, {BC6H_W, 1, 0, 10}, {BC6H_W, 2, 0, 10}, {BC6H_X, 0, 0, 5}, {BC6H_W, 0, 10, 1}, {BC6H_Y, 1, 0, 4}, {BC6H_X, 1, 0, 4},
+	                          {BC6H_W, 1, 10, 1}, {BC6H_Z, 2, 0, 1}, {BC6H_Z, 1, 0, 4}, {BC6H_X, 2, 0, 4}, {BC6H_W, 2, 10, 1}, {BC6H_Z, 2, 1, 1}, {BC6H_Y, 2, 0, 4},
+	                          {BC6H_Y, 0, 0, 5}, {BC6H_Z, 2, 2, 1}, {BC6H_Z, 0, 0, 5}, {BC6H_Z, 2, 3, 1}, {BC6H_D, 0, 0, 5}}},
+	{2, true, 11, {4, 5, 4}, {{BC6H_W, 0, 0, 10}, {BC6H_W, 1, 0, 10}, {BC6H_W, 2, 0, 10}, {BC6H_X, 0, 0, 4}, {BC6H_W, 0, 10, 1}, {BC6H_Z, 1, 4, 1}, {BC6H_Y, 1, 0, 4},
+	                          {BC6H_X, 1, 0, 5}, {BC6H_W, 1, 10, 1}, {BC6H_Z, 1, 0, 4}, {BC6H_X, 2, 0, 4}, {BC6H_W, 2, 10, 1}, {BC6H_Z, 2, 1, 1}, {BC6H_Y, 2, 0, 4},
+	                          {BC6H_Y, 0, 0, 4}, {BC6H_Z, 2, 0, 1}, {BC6H_Z, 2, 2, 1}, {BC6H_Z, 0, 0, 4}, {BC6H_Y, 1, 4, 1}, {BC6H_Z, 2, 3, 1}, {BC6H_D, 0, 0, 5}}},
+	{2, true, 11, {4, 4, 5}, {{BC6H_W, 0, 0, 10}, {BC6H_W, 1, 0, 10}, {BC6H_W, 2, 0, 10}, {BC6H_X, 0, 0, 4}, {BC6H_W, 0, 10, 1}, {BC6H_Y, 2, 4, 1}, {BC6H_Y, 1, 0, 4},
+	                          {BC6H_X, 1, 0, 4}, {BC6H_W, 1, 10, 1}, {BC6H_Z, 2, 0, 1}, {BC6H_Z, 1, 0, 4}, {BC6H_X, 2, 0, 5}, {BC6H_W, 2, 10, 1}, {BC6H_Y, 2, 0, 4},
+	                          {BC6H_Y, 0, 0, 4}, {BC6H_Z, 2, 1, 1}, {BC6H_Z, 2, 2, 1}, {BC6H_Z, 0, 0, 4}, {BC6H_Z, 2, 4, 1}, {BC6H_Z, 2, 3, 1}, {BC6H_D, 0, 0, 5}}},
+	{2, true, 9, {5, 5, 5}, {{BC6H_W, 0, 0, 9}, {BC6H_Y, 2, 4, 1}, {BC6H_W, 1, 0, 9}, {BC6H_Y, 1, 4, 1}, {BC6H_W, 2, 0, 9}, {BC6H_Z, 2, 4, 1}, {BC6H_X, 0, 0, 5},
+	                         {BC6H_Z, 1, 4, 1}, {BC6H_Y, 1, 0, 4}, {BC6H_X, 1, 0, 5}, {BC6H_Z, 2, 0, 1}, {BC6H_Z, 1, 0, 4}, {BC6H_X, 2, 0, 5}, {BC6H_Z, 2, 1, 1},
+	                         {BC6H_Y, 2, 0, 4}, {BC6H_Y, 0, 0, 5}, {BC6H_Z, 2, 2, 1}, {BC6H_Z, 0, 0, 5}, {BC6H_Z, 2, 3, 1}, {BC6H_D, 0, 0, 5}}},
+	{2, true, 8, {6, 5, 5}, {{BC6H_W, 0, 0, 8}, {BC6H_Z, 1, 4, 1}, {BC6H_Y, 2, 4, 1}, {BC6H_W, 1, 0, 8}, {BC6H_Z, 2, 2, 1}, {BC6H_Y, 1, 4, 1}, {BC6H_W, 2, 0, 8},
+	                         {BC6H_Z, 2, 3, 1}, {BC6H_Z, 2, 4, 1}, {BC6H_X, 0, 0, 6}, {BC6H_Y, 1, 0, 4}, {BC6H_X, 1, 0, 5}, {BC6H_Z, 2, 0, 1}, {BC6H_Z, 1, 0, 4},
+	                         {BC6H_X, 2, 0, 5}, {BC6H_Z, 2, 1, 1}, {BC6H_Y, 2, 0, 4}, {BC6H_Y, 0, 0, 6}, {BC6H_Z, 0, 0, 6}, {BC6H_D, 0, 0, 5}}},
+	{2, true, 8, {5, 6, 5}, {{BC6H_W, 0, 0, 8}, {BC6H_Z, 2, 0, 1}, {BC6H_Y, 2, 4, 1}, {BC6H_W, 1, 0, 8}, {BC6H_Y, 1, 5, 1}, {BC6H_Y, 1, 4, 1}, {BC6H_W, 2, 0, 8},
+	                         {BC6H_Z, 1, 5, 1}, {BC6H_Z, 2, 4, 1}, {BC6H_X, 0, 0, 5}, {BC6H_Z, 1, 4, 1}, {BC6H_Y, 1, 0, 4}, {BC6H_X, 1, 0, 6}, {BC6H_Z, 1, 0, 4},
+	                         {BC6H_X, 2, 0, 5}, {BC6H_Z, 2, 1, 1}, {BC6H_Y, 2, 0, 4}, {BC6H_Y, 0, 0, 5}, {BC6H_Z, 2, 2, 1}, {BC6H_Z, 0, 0, 5}, {BC6H_Z, 2, 3, 1},
+	                         {BC6H_D, 0, 0, 5}}},
+	{2, true, 8, {5, 5, 6}, {{BC6H_W, 0, 0, 8}, {BC6H_Z, 2, 1, 1}, {BC6H_Y, 2, 4, 1}, {BC6H_W, 1, 0, 8}, {BC6H_Y, 2, 5, 1}, {BC6H_Y, 1, 4, 1}, {BC6H_W, 2, 0, 8},
+	                         {BC6H_Z, 2, 5, 1}, {BC6H_Z, 2, 4, 1}, {BC6H_X, 0, 0, 5}, {BC6H_Z, 1, 4, 1}, {BC6H_Y, 1, 0, 4}, {BC6H_X, 1, 0, 5}, {BC6H_Z, 2, 0, 1},
+	                         {BC6H_Z, 1, 0, 4}, {BC6H_X, 2, 0, 6}, {BC6H_Y, 2, 0, 4}, {BC6H_Y, 0, 0, 5}, {BC6H_Z, 2, 2, 1}, {BC6H_Z, 0, 0, 5}, {BC6H_Z, 2, 3, 1},
+	                         {BC6H_D, 0, 0, 5}}},
+	{2, false, 6, {6, 6, 6}, {{BC6H_W, 0, 0, 6}, {BC6H_Z, 1, 4, 1}, {BC6H_Z, 2, 0, 1}, {BC6H_Z, 2, 1, 1}, {BC6H_Y, 2, 4, 1}, {BC6H_W, 1, 0, 6}, {BC6H_Y, 1, 5, 1},
+	                          {BC6H_Y, 2, 5, 1}, {BC6H_Z, 2, 2, 1}, {BC6H_Y, 1, 4, 1}, {BC6H_W, 2, 0, 6}, {BC6H_Z, 1, 5, 1}, {BC6H_Z, 2, 3, 1}, {BC6H_Z, 2, 5, 1},
+	                          {BC6H_Z, 2, 4, 1}, {BC6H_X, 0, 0, 6}, {BC6H_Y, 1, 0, 4}, {BC6H_X, 1, 0, 6}, {BC6H_Z, 1, 0, 4}, {BC6H_X, 2, 0, 6}, {BC6H_Y, 2, 0, 4},
+	                          {BC6H_Y, 0, 0, 6}, {BC6H_Z, 0, 0, 6}, {BC6H_D, 0, 0, 5}}},
+	{1, false, 10, {10, 10, 10}, {{BC6H_W, 0, 0, 10}, {BC6H_W, 1, 0, 10}, {BC6H_W, 2, 0, 10}, {BC6H_X, 0, 0, 10}, {BC6H_X, 1, 0, 10}, {BC6H_X, 2, 0, 10}}},
+	{1, true, 11, {9, 9, 9}, {{BC6H_W, 0, 0, 10}, {BC6H_W, 1, 0, 10}, {BC6H_W, 2, 0, 10}, {BC6H_X, 0, 0, 9}, {BC6H_W, 0, 10, 1}, {BC6H_X, 1, 0, 9}, {BC6H_W, 1, 10, 1},
+	                          {BC6H_X, 2, 0, 9}, {BC6H_W, 2, 10, 1}}},
+	{1, true, 12, {8, 8, 8}, {{BC6H_W, 0, 0, 10}, {BC6H_W, 1, 0, 10}, {BC6H_W, 2, 0, 10}, {BC6H_X, 0, 0, 8}, {BC6H_W, 0, 10, 2, true}, {BC6H_X, 1, 0, 8},
+	                          {BC6H_W, 1, 10, 2, true}, {BC6H_X, 2, 0, 8}, {BC6H_W, 2, 10, 2, true}}},
+	{1, true, 16, {4, 4, 4}, {{BC6H_W, 0, 0, 10}, {BC6H_W, 1, 0, 10}, {BC6H_W, 2, 0, 10}, {BC6H_X, 0, 0, 4}, {BC6H_W, 0, 10, 6, true}, {BC6H_X, 1, 0, 4},
+	                          {BC6H_W, 1, 10, 6, true}, {BC6H_X, 2, 0, 4}, {BC6H_W, 2, 10, 6, true}}},
+};
+
+uint32_t ReverseBits(const uint32_t value, const uint32_t count)
+{
+	uint32_t reversed = 0;
+
+	for (uint32_t i = 0; i < count; ++i)
+	{
+		reversed |= ((value >> i) & 1) << (count - 1 - i);
+	}
+
+	return reversed;
+}
+
+int32_t SignExtend(const uint32_t value, const uint32_t bits)
+{
+	return static_cast<int32_t>(value << (32 - bits)) >> (32 - bits);
+}
+
+int32_t UnquantizeBC6H(int32_t value, const uint32_t bits, const bool isSigned)
+{
+	if (!isSigned)
+	{
+		if (bits >= 15 || value == 0)
+		{
+			return value;
+		}
+
+		return value == (1 << bits) - 1 ? 0xffff : ((value << 16) + 0x8000) >> bits;
+	}
+
+	if (bits >= 16 || value == 0)
+	{
+		return value;
+	}
+
+	const bool negative = value < 0;
+	value = negative ? -value : value;
+	value = value >= (1 << (bits - 1)) - 1 ? 0x7fff : ((value << 15) + 0x4000) >> (bits - 1);
+	return negative ? -value : value;
+}
+
+// The final scaling of the interpolated value to the half float bit pattern.
+uint64_t FinishBC6H(const int32_t value, const bool isSigned)
+{
+	if (!isSigned)
+	{
+		return static_cast<uint64_t>((value * 31) >> 6);
+	}
+
+	return value < 0 ? 0x8000 | static_cast<uint64_t>(((-value) * 31) >> 5) : static_cast<uint64_t>((value * 31) >> 5);
+}
+
+void DecodeBC6H(const uint8_t* block, const bool isSigned, uint64_t (&texels)[BLOCK_TEXELS])
+{
+	constexpr uint64_t ONE = uint64_t{0x3c00} << 48; // Alpha.
+	constexpr int8_t MODE_INDICES[32] = {0, 1, 2, 10, -1, -1, 3, 11, -1, -1, 4, 12, -1, -1, 5, 13, -1, -1, 6, -1, -1, -1, 7, -1, -1, -1, 8, -1, -1, -1, 9, -1};
+
+	BitReader bits{block};
+	uint32_t modeBits = bits.Read(2);
+
+	if (modeBits >= 2)
+	{
+		modeBits |= bits.Read(3) << 2;
+	}
+
+	const int32_t modeIndex = MODE_INDICES[modeBits];
+
+	// Reserved modes decode to black.
+	if (modeIndex < 0)
+	{
+		std::fill(std::begin(texels), std::end(texels), ONE);
+		return;
+	}
+
+	const BC6HMode& mode = BC6H_MODES[modeIndex];
+	uint32_t fields[5][3] = {};
+
+	for (const BC6HBits& run : mode.layout)
+	{
+		if (run.bitCount == 0)
+		{
+			break;
+		}
+
+		uint32_t value = bits.Read(run.bitCount);
+
+		if (run.reversed)
+		{
+			value = ReverseBits(value, run.bitCount);
+		}
+
+		fields[run.field][run.channel] |= value << run.lowBit;
+	}
+
+	const uint32_t partition = fields[BC6H_D][0];
+	const uint32_t endpointCount = mode.regionCount * 2;
+	int32_t endpoints[4][3];
+
+	for (uint32_t c = 0; c < 3; ++c)
+	{
+		const uint32_t mask = (1u << mode.endpointBits) - 1;
+		endpoints[0][c] = isSigned ? SignExtend(fields[BC6H_W][c], mode.endpointBits) : static_cast<int32_t>(fields[BC6H_W][c]);
+
+		for (uint32_t e = 1; e < endpointCount; ++e)
+		{
+			if (mode.transformed)
+			{
+				const uint32_t value = (fields[BC6H_W][c] + SignExtend(fields[e][c], mode.deltaBits[c])) & mask;
+				endpoints[e][c] = isSigned ? SignExtend(value, mode.endpointBits) : static_cast<int32_t>(value);
+			}
+			else
+			{
+				endpoints[e][c] = isSigned ? SignExtend(fields[e][c], mode.endpointBits) : static_cast<int32_t>(fields[e][c]);
+			}
+		}
+
+		for (uint32_t e = 0; e < endpointCount; ++e)
+		{
+			endpoints[e][c] = UnquantizeBC6H(endpoints[e][c], mode.endpointBits, isSigned);
+		}
+	}
+
+	const uint32_t indexBits = mode.regionCount == 2 ? 3 : 4;
+	const uint8_t* weights = GetWeights(indexBits);
+
+	for (uint32_t i = 0; i < BLOCK_TEXELS; ++i)
+	{
+		const uint32_t region = mode.regionCount == 2 ? (PARTITIONS2[partition] >> i) & 1 : 0;
+		const bool anchor = i == 0 || (mode.regionCount == 2 && i == ANCHORS2[partition]);
+		const int32_t weight = weights[bits.Read(indexBits - anchor)];
+		const int32_t* e0 = endpoints[region * 2];
+		const int32_t* e1 = endpoints[region * 2 + 1];
+		uint64_t texel = ONE;
+
+		for (uint32_t c = 0; c < 3; ++c)
+		{
+			texel |= FinishBC6H((e0[c] * (64 - weight) + e1[c] * weight + 32) >> 6, isSigned) << (16 * c);
+		}
+
+		texels[i] = texel;
+	}
+}
+
+//
+// BC7
+//
+
+struct BC7Mode
+{
+	uint8_t subsetCount;
+	uint8_t partitionBits;
+	uint8_t rotationBits;
+	uint8_t indexSelectionBits;
+	uint8_t colorBits;
+	uint8_t alphaBits;
+	uint8_t endpointPBits; // One P-bit per endpoint.
+	uint8_t sharedPBits;   // One P-bit per subset.
+	uint8_t indexBits;
+	uint8_t secondaryIndexBits;
+};
+
+constexpr BC7Mode BC7_MODES[8] = {
+	{3, 4, 0, 0, 4, 0, 1, 0, 3, 0},
+	{2, 6, 0, 0, 6, 0, 0, 1, 3, 0},
+	{3, 6, 0, 0, 5, 0, 0, 0, 2, 0},
+	{2, 6, 0, 0, 7, 0, 1, 0, 2, 0},
+	{1, 0, 2, 1, 5, 6, 0, 0, 2, 3},
+	{1, 0, 2, 0, 7, 8, 0, 0, 2, 2},
+	{1, 0, 0, 0, 7, 7, 1, 0, 4, 0},
+	{2, 6, 0, 0, 5, 5, 1, 0, 2, 0},
+};
+
+uint32_t Interpolate(const uint32_t e0, const uint32_t e1, const uint32_t weight)
+{
+	return (e0 * (64 - weight) + e1 * weight + 32) >> 6;
+}
+
+void DecodeBC7(const uint8_t* block, uint32_t (&texels)[BLOCK_TEXELS])
+{
+	// The mode is the number of zeros before the first set bit. Mode 8 is reserved and decodes to transparent black.
+	if (block[0] == 0)
+	{
+		std::fill(std::begin(texels), std::end(texels), 0u);
+		return;
+	}
+
+	const uint32_t modeIndex = static_cast<uint32_t>(std::countr_zero(block[0]));
+	const BC7Mode& mode = BC7_MODES[modeIndex];
+	BitReader bits{block};
+	bits.Skip(modeIndex + 1);
+
+	const uint32_t partition = bits.Read(mode.partitionBits);
+	const uint32_t rotation = bits.Read(mode.rotationBits);
+	const uint32_t indexSelection = bits.Read(mode.indexSelectionBits);
+	const uint32_t endpointCount = mode.subsetCount * 2;
+	uint32_t endpoints[6][4];
+
+	for (uint32_t c = 0; c < 3; ++c)
+	{
+		for (uint32_t e = 0; e < endpointCount; ++e)
+		{
+			endpoints[e][c] = bits.Read(mode.colorBits);
+		}
+	}
+
+	for (uint32_t e = 0; e < endpointCount; ++e)
+	{
+		endpoints[e][3] = mode.alphaBits > 0 ? bits.Read(mode.alphaBits) : 255;
+	}
+
+	const uint32_t channelCount = mode.alphaBits > 0 ? 4 : 3;
+
+	if (mode.endpointPBits > 0 || mode.sharedPBits > 0)
+	{
+		uint32_t pBits[6];
+
+		for (uint32_t e = 0; e < endpointCount; ++e)
+		{
+			pBits[e] = mode.endpointPBits > 0 || e % 2 == 0 ? bits.Read(1) : pBits[e - 1];
+		}
+
+		for (uint32_t e = 0; e < endpointCount; ++e)
+		{
+			for (uint32_t c = 0; c < channelCount; ++c)
+			{
+				endpoints[e][c] = (endpoints[e][c] << 1) | pBits[e];
+			}
+		}
+	}
+
+	const uint32_t pBitCount = mode.endpointPBits + mode.sharedPBits;
+	const uint32_t precisions[4] = {mode.colorBits + pBitCount, mode.colorBits + pBitCount, mode.colorBits + pBitCount, mode.alphaBits > 0 ? mode.alphaBits + pBitCount : 8u};
+
+	for (uint32_t e = 0; e < endpointCount; ++e)
+	{
+		for (uint32_t c = 0; c < 4; ++c)
+		{
+			const uint32_t value = endpoints[e][c] << (8 - precisions[c]);
+			endpoints[e][c] = value | (value >> precisions[c]);
+		}
+	}
+
+	uint32_t subsets[BLOCK_TEXELS];
+	bool anchors[BLOCK_TEXELS] = {true};
+
+	for (uint32_t i = 0; i < BLOCK_TEXELS; ++i)
+	{
+		subsets[i] = mode.subsetCount == 1 ? 0 : mode.subsetCount == 2 ? (PARTITIONS2[partition] >> i) & 1 : (PARTITIONS3[partition] >> (2 * i)) & 3;
+	}
+
+	if (mode.subsetCount == 2)
+	{
+		anchors[ANCHORS2[partition]] = true;
+	}
+	else if (mode.subsetCount == 3)
+	{
+		anchors[ANCHORS3[0][partition]] = true;
+		anchors[ANCHORS3[1][partition]] = true;
+	}
+
+	uint32_t colorIndices[BLOCK_TEXELS];
+	uint32_t alphaIndices[BLOCK_TEXELS];
+
+	for (uint32_t i = 0; i < BLOCK_TEXELS; ++i)
+	{
+		colorIndices[i] = bits.Read(mode.indexBits - anchors[i]);
+	}
+
+	uint32_t colorIndexBits = mode.indexBits;
+	uint32_t alphaIndexBits = mode.indexBits;
+
+	if (mode.secondaryIndexBits > 0)
+	{
+		for (uint32_t i = 0; i < BLOCK_TEXELS; ++i)
+		{
+			alphaIndices[i] = bits.Read(mode.secondaryIndexBits - (i == 0));
+		}
+
+		alphaIndexBits = mode.secondaryIndexBits;
+
+		if (indexSelection != 0)
+		{
+			std::swap(colorIndices, alphaIndices);
+			std::swap(colorIndexBits, alphaIndexBits);
+		}
+	}
+	else
+	{
+		std::copy(std::begin(colorIndices), std::end(colorIndices), alphaIndices);
+	}
+
+	const uint8_t* colorWeights = GetWeights(colorIndexBits);
+	const uint8_t* alphaWeights = GetWeights(alphaIndexBits);
+
+	for (uint32_t i = 0; i < BLOCK_TEXELS; ++i)
+	{
+		const uint32_t* e0 = endpoints[subsets[i] * 2];
+		const uint32_t* e1 = endpoints[subsets[i] * 2 + 1];
+		uint32_t rgba[4];
+
+		for (uint32_t c = 0; c < 3; ++c)
+		{
+			rgba[c] = Interpolate(e0[c], e1[c], colorWeights[colorIndices[i]]);
+		}
+
+		rgba[3] = Interpolate(e0[3], e1[3], alphaWeights[alphaIndices[i]]);
+
+		// Rotation swaps alpha with red, green or blue.
+		if (rotation > 0)
+		{
+			std::swap(rgba[3], rgba[rotation - 1]);
+		}
+
+		texels[i] = PackRGBA(rgba[0], rgba[1], rgba[2], rgba[3]);
+	}
+}
+
+void DecodeBlock(const DXGI_FORMAT format, const uint8_t* block, uint8_t* output, const size_t rowPitch)
+{
+	uint32_t texels[BLOCK_TEXELS];
+	uint32_t values[BLOCK_TEXELS];
+
+	switch (format)
+	{
+	case DXGI_FORMAT_BC1_UNORM:
+	case DXGI_FORMAT_BC1_UNORM_SRGB:
+		DecodeColors(block, true, texels);
+		break;
+
+	case DXGI_FORMAT_BC2_UNORM:
+	case DXGI_FORMAT_BC2_UNORM_SRGB:
+		DecodeColors(block + 8, false, texels);
+		DecodeExplicitAlpha(block, texels);
+		break;
+
+	case DXGI_FORMAT_BC3_UNORM:
+	case DXGI_FORMAT_BC3_UNORM_SRGB:
+		DecodeColors(block + 8, false, texels);
+		DecodeChannel(block, false, values);
+
+		for (uint32_t i = 0; i < BLOCK_TEXELS; ++i)
+		{
+			texels[i] = (texels[i] & 0x00ffffffu) | (values[i] << 24);
+		}
+		break;
+
+	case DXGI_FORMAT_BC4_UNORM:
+	case DXGI_FORMAT_BC4_SNORM:
+	{
+		const bool snorm = format == DXGI_FORMAT_BC4_SNORM;
+		DecodeChannel(block, snorm, values);
+
+		for (uint32_t i = 0; i < BLOCK_TEXELS; ++i)
+		{
+			texels[i] = values[i] | (snorm ? 0x7f000000u : 0xff000000u);
+		}
+		break;
+	}
+
+	case DXGI_FORMAT_BC5_UNORM:
+	case DXGI_FORMAT_BC5_SNORM:
+	{
+		const bool snorm = format == DXGI_FORMAT_BC5_SNORM;
+		DecodeChannel(block, snorm, texels);
+		DecodeChannel(block + 8, snorm, values);
+
+		for (uint32_t i = 0; i < BLOCK_TEXELS; ++i)
+		{
+			texels[i] |= (values[i] << 8) | (snorm ? 0x7f000000u : 0xff000000u);
+		}
+		break;
+	}
+
+	case DXGI_FORMAT_BC6H_UF16:
+	case DXGI_FORMAT_BC6H_SF16:
+	{
+		uint64_t halfTexels[BLOCK_TEXELS];
+		DecodeBC6H(block, format == DXGI_FORMAT_BC6H_SF16, halfTexels);
+		StoreBlock(halfTexels, output, rowPitch);
+		return;
+	}
+
+	case DXGI_FORMAT_BC7_UNORM:
+	case DXGI_FORMAT_BC7_UNORM_SRGB:
+		DecodeBC7(block, texels);
+		break;
+
+	default:
+		return;
+	}
+
+	StoreBlock(texels, output, rowPitch);
+}
+
+#if VSGL_SIMD_AVX2
+//
+// 8 blocks of BC1-BC5 at a time, one per 32-bit lane. texels[i] holds texel i of every block.
+//
+
+// The 32-bit words at offset of 8 consecutive blocks.
+__m256i LoadWords(const uint8_t* blocks, const uint32_t blockSize, const uint32_t offset)
+{
+	const __m256i offsets = _mm256_mullo_epi32(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7), _mm256_set1_epi32(static_cast<int>(blockSize)));
+	return _mm256_i32gather_epi32(reinterpret_cast<const int*>(blocks + offset), offsets, 1);
+}
+
+// Selects b where the most significant bit of each lane of mask is set, otherwise a.
+__m256i Select(const __m256i a, const __m256i b, const __m256i mask)
+{
+	return _mm256_castps_si256(_mm256_blendv_ps(_mm256_castsi256_ps(a), _mm256_castsi256_ps(b), _mm256_castsi256_ps(mask)));
+}
+
+__m256i PackRGBA(const __m256i r, const __m256i g, const __m256i b, const __m256i a)
+{
+	return _mm256_or_si256(_mm256_or_si256(r, _mm256_slli_epi32(g, 8)), _mm256_or_si256(_mm256_slli_epi32(b, 16), _mm256_slli_epi32(a, 24)));
+}
+
+// floor(x / d) for x < 2^14, by a multiplication.
+template <uint32_t D>
+__m256i Divide(const __m256i x)
+{
+	constexpr uint32_t SHIFT = 18;
+	constexpr uint32_t SCALE = ((1u << SHIFT) + D - 1) / D;
+	return _mm256_srli_epi32(_mm256_mullo_epi32(x, _mm256_set1_epi32(SCALE)), SHIFT);
+}
+
+void DecodeColors8(const uint8_t* blocks, const uint32_t blockSize, const uint32_t offset, const bool bc1, __m256i (&texels)[BLOCK_TEXELS])
+{
+	const __m256i endpoints = LoadWords(blocks, blockSize, offset);
+	__m256i indices = LoadWords(blocks, blockSize, offset + 4);
+
+	const __m256i c0 = _mm256_and_si256(endpoints, _mm256_set1_epi32(0xffff));
+	const __m256i c1 = _mm256_srli_epi32(endpoints, 16);
+	const auto expand = [](const __m256i c, __m256i (&rgb)[3]) {
+		const __m256i r = _mm256_srli_epi32(c, 11);
+		const __m256i g = _mm256_and_si256(_mm256_srli_epi32(c, 5), _mm256_set1_epi32(63));
+		const __m256i b = _mm256_and_si256(c, _mm256_set1_epi32(31));
+		rgb[0] = _mm256_or_si256(_mm256_slli_epi32(r, 3), _mm256_srli_epi32(r, 2));
+		rgb[1] = _mm256_or_si256(_mm256_slli_epi32(g, 2), _mm256_srli_epi32(g, 4));
+		rgb[2] = _mm256_or_si256(_mm256_slli_epi32(b, 3), _mm256_srli_epi32(b, 2));
+	};
+
+	__m256i rgb0[3];
+	__m256i rgb1[3];
+	expand(c0, rgb0);
+	expand(c1, rgb1);
+
+	const __m256i one = _mm256_set1_epi32(1);
+	const __m256i opaque = _mm256_set1_epi32(255);
+	__m256i third0[3];
+	__m256i third1[3];
+	__m256i half[3];
+
+	for (uint32_t c = 0; c < 3; ++c)
+	{
+		const __m256i sum = _mm256_add_epi32(_mm256_add_epi32(rgb0[c], rgb1[c]), one);
+		third0[c] = Divide<3>(_mm256_add_epi32(sum, rgb0[c]));
+		third1[c] = Divide<3>(_mm256_add_epi32(sum, rgb1[c]));
+		half[c] = _mm256_srli_epi32(sum, 1);
+	}
+
+	const __m256i palette0 = PackRGBA(rgb0[0], rgb0[1], rgb0[2], opaque);
+	const __m256i palette1 = PackRGBA(rgb1[0], rgb1[1], rgb1[2], opaque);
+	__m256i palette2 = PackRGBA(third0[0], third0[1], third0[2], opaque);
+	__m256i palette3 = PackRGBA(third1[0], third1[1], third1[2], opaque);
+
+	if (bc1)
+	{
+		// The 3-color mode where color0 <= color1, as the sign bit of color0 - color1 - 1.
+		const __m256i threeColors = _mm256_sub_epi32(_mm256_sub_epi32(c0, c1), one);
+		palette2 = Select(palette2, PackRGBA(half[0], half[1], half[2], opaque), threeColors);
+		palette3 = Select(palette3, _mm256_setzero_si256(), threeColors);
+	}
+
+	for (uint32_t i = 0; i < BLOCK_TEXELS; ++i)
+	{
+		const __m256i bit0 = _mm256_slli_epi32(indices, 31);
+		const __m256i bit1 = _mm256_slli_epi32(indices, 30);
+		texels[i] = Select(Select(palette0, palette1, bit0), Select(palette2, palette3, bit0), bit1);
+		indices = _mm256_srli_epi32(indices, 2);
+	}
+}
+
+void DecodeChannels8(const uint8_t* blocks, const uint32_t blockSize, const uint32_t offset, const bool snorm, __m256i (&values)[BLOCK_TEXELS])
+{
+	const __m256i low = LoadWords(blocks, blockSize, offset);
+	const __m256i high = LoadWords(blocks, blockSize, offset + 4);
+
+	__m256i palette[8];
+
+	if (snorm)
+	{
+		const __m256i minimum = _mm256_set1_epi32(-127);
+		const __m256i a = _mm256_max_epi32(_mm256_srai_epi32(_mm256_slli_epi32(low, 24), 24), minimum);
+		const __m256i b = _mm256_max_epi32(_mm256_srai_epi32(_mm256_slli_epi32(low, 16), 24), minimum);
+		const __m256i eightValues = _mm256_cmpgt_epi32(a, b);
+		// Rounds half away from zero like DecodeChannel().
+		const auto divide7 = [](const __m256i x) { return _mm256_sign_epi32(Divide<7>(_mm256_add_epi32(_mm256_abs_epi32(x), _mm256_set1_epi32(3))), x); };
+		const auto divide5 = [](const __m256i x) { return _mm256_sign_epi32(Divide<5>(_mm256_add_epi32(_mm256_abs_epi32(x), _mm256_set1_epi32(2))), x); };
+		palette[0] = a;
+		palette[1] = b;
+
+		for (int32_t i = 2; i < 8; ++i)
+		{
+			const __m256i eight = divide7(_mm256_add_epi32(_mm256_mullo_epi32(a, _mm256_set1_epi32(8 - i)), _mm256_mullo_epi32(b, _mm256_set1_epi32(i - 1))));
+			const __m256i six = i < 6 ? divide5(_mm256_add_epi32(_mm256_mullo_epi32(a, _mm256_set1_epi32(6 - i)), _mm256_mullo_epi32(b, _mm256_set1_epi32(i - 1))))
+			                          : _mm256_set1_epi32(i == 6 ? -127 : 127);
+			palette[i] = Select(six, eight, eightValues);
+		}
+	}
+	else
+	{
+		const __m256i a = _mm256_and_si256(low, _mm256_set1_epi32(0xff));
+		const __m256i b = _mm256_and_si256(_mm256_srli_epi32(low, 8), _mm256_set1_epi32(0xff));
+		const __m256i eightValues = _mm256_cmpgt_epi32(a, b);
+		palette[0] = a;
+		palette[1] = b;
+
+		for (int32_t i = 2; i < 8; ++i)
+		{
+			const __m256i eight = Divide<7>(_mm256_add_epi32(_mm256_add_epi32(_mm256_mullo_epi32(a, _mm256_set1_epi32(8 - i)), _mm256_mullo_epi32(b, _mm256_set1_epi32(i - 1))),
+			                                                 _mm256_set1_epi32(3)));
+			const __m256i six = i < 6 ? Divide<5>(_mm256_add_epi32(_mm256_add_epi32(_mm256_mullo_epi32(a, _mm256_set1_epi32(6 - i)), _mm256_mullo_epi32(b, _mm256_set1_epi32(i - 1))),
+			                                                       _mm256_set1_epi32(2)))
+			                          : _mm256_set1_epi32(i == 6 ? 0 : 255);
+			palette[i] = Select(six, eight, eightValues);
+		}
+	}
+
+	// The 48 index bits as two 24-bit halves of 8 texels.
+	const __m256i halves[2] = {_mm256_or_si256(_mm256_srli_epi32(low, 16), _mm256_slli_epi32(_mm256_and_si256(high, _mm256_set1_epi32(0xff)), 16)), _mm256_srli_epi32(high, 8)};
+
+	for (uint32_t half = 0; half < 2; ++half)
+	{
+		__m256i indices = halves[half];
+
+		for (uint32_t i = 0; i < 8; ++i)
+		{
+			const __m256i bit0 = _mm256_slli_epi32(indices, 31);
+			const __m256i bit1 = _mm256_slli_epi32(indices, 30);
+			const __m256i bit2 = _mm256_slli_epi32(indices, 29);
+			const __m256i low4 = Select(Select(palette[0], palette[1], bit0), Select(palette[2], palette[3], bit0), bit1);
+			const __m256i high4 = Select(Select(palette[4], palette[5], bit0), Select(palette[6], palette[7], bit0), bit1);
+			values[half * 8 + i] = _mm256_and_si256(Select(low4, high4, bit2), _mm256_set1_epi32(0xff));
+			indices = _mm256_srli_epi32(indices, 3);
+		}
+	}
+}
+
+// Transposes the texels of 8 blocks into 4 rows of 32 texels.
+void StoreBlocks8(const __m256i (&texels)[BLOCK_TEXELS], uint8_t* output, const size_t rowPitch)
+{
+	for (uint32_t y = 0; y < 4; ++y)
+	{
+		const __m256i* row = texels + y * 4;
+		const __m256i t01Low = _mm256_unpacklo_epi32(row[0], row[1]); // Blocks 0, 1 | 4, 5.
+		const __m256i t01High = _mm256_unpackhi_epi32(row[0], row[1]); // Blocks 2, 3 | 6, 7.
+		const __m256i t23Low = _mm256_unpacklo_epi32(row[2], row[3]);
+		const __m256i t23High = _mm256_unpackhi_epi32(row[2], row[3]);
+		const __m256i block04 = _mm256_unpacklo_epi64(t01Low, t23Low);
+		const __m256i block15 = _mm256_unpackhi_epi64(t01Low, t23Low);
+		const __m256i block26 = _mm256_unpacklo_epi64(t01High, t23High);
+		const __m256i block37 = _mm256_unpackhi_epi64(t01High, t23High);
+
+		__m256i* destination = reinterpret_cast<__m256i*>(output + y * rowPitch);
+		_mm256_storeu_si256(destination, _mm256_permute2x128_si256(block04, block15, 0x20));
+		_mm256_storeu_si256(destination + 1, _mm256_permute2x128_si256(block26, block37, 0x20));
+		_mm256_storeu_si256(destination + 2, _mm256_permute2x128_si256(block04, block15, 0x31));
+		_mm256_storeu_si256(destination + 3, _mm256_permute2x128_si256(block26, block37, 0x31));
+	}
+}
+
+// Returns false for the formats that are decoded block by block.
+bool DecodeBlocks8(const DXGI_FORMAT format, const uint8_t* blocks, uint8_t* output, const size_t rowPitch)
+{
+	__m256i texels[BLOCK_TEXELS];
+	__m256i values[BLOCK_TEXELS];
+
+	switch (format)
+	{
+	case DXGI_FORMAT_BC1_UNORM:
+	case DXGI_FORMAT_BC1_UNORM_SRGB:
+		DecodeColors8(blocks, 8, 0, true, texels);
+		break;
+
+	case DXGI_FORMAT_BC2_UNORM:
+	case DXGI_FORMAT_BC2_UNORM_SRGB:
+	{
+		DecodeColors8(blocks, 16, 8, false, texels);
+		const __m256i alphas[2] = {LoadWords(blocks, 16, 0), LoadWords(blocks, 16, 4)};
+
+		for (uint32_t i = 0; i < BLOCK_TEXELS; ++i)
+		{
+			const __m256i alpha = _mm256_and_si256(_mm256_srli_epi32(alphas[i / 8], 4 * (i % 8)), _mm256_set1_epi32(15));
+			texels[i] = _mm256_or_si256(_mm256_and_si256(texels[i], _mm256_set1_epi32(0x00ffffff)), _mm256_slli_epi32(_mm256_mullo_epi32(alpha, _mm256_set1_epi32(17)), 24));
+		}
+		break;
+	}
+
+	case DXGI_FORMAT_BC3_UNORM:
+	case DXGI_FORMAT_BC3_UNORM_SRGB:
+		DecodeColors8(blocks, 16, 8, false, texels);
+		DecodeChannels8(blocks, 16, 0, false, values);
+
+		for (uint32_t i = 0; i < BLOCK_TEXELS; ++i)
+		{
+			texels[i] = _mm256_or_si256(_mm256_and_si256(texels[i], _mm256_set1_epi32(0x00ffffff)), _mm256_slli_epi32(values[i], 24));
+		}
+		break;
+
+	case DXGI_FORMAT_BC4_UNORM:
+	case DXGI_FORMAT_BC4_SNORM:
+	{
+		const bool snorm = format == DXGI_FORMAT_BC4_SNORM;
+		DecodeChannels8(blocks, 8, 0, snorm, values);
+
+		for (uint32_t i = 0; i < BLOCK_TEXELS; ++i)
+		{
+			texels[i] = _mm256_or_si256(values[i], _mm256_set1_epi32(snorm ? 0x7f000000 : static_cast<int>(0xff000000u)));
+		}
+		break;
+	}
+
+	case DXGI_FORMAT_BC5_UNORM:
+	case DXGI_FORMAT_BC5_SNORM:
+	{
+		const bool snorm = format == DXGI_FORMAT_BC5_SNORM;
+		DecodeChannels8(blocks, 16, 0, snorm, texels);
+		DecodeChannels8(blocks, 16, 8, snorm, values);
+
+		for (uint32_t i = 0; i < BLOCK_TEXELS; ++i)
+		{
+			texels[i] = _mm256_or_si256(_mm256_or_si256(texels[i], _mm256_slli_epi32(values[i], 8)), _mm256_set1_epi32(snorm ? 0x7f000000 : static_cast<int>(0xff000000u)));
+		}
+		break;
+	}
+
+	default:
+		return false;
+	}
+
+	StoreBlocks8(texels, output, rowPitch);
+	return true;
+}
+#endif
+} // namespace
+
+uint32_t GetBlockSize(const DXGI_FORMAT format)
+{
+	switch (format)
+	{
+	case DXGI_FORMAT_BC1_UNORM:
+	case DXGI_FORMAT_BC1_UNORM_SRGB:
+	case DXGI_FORMAT_BC4_UNORM:
+	case DXGI_FORMAT_BC4_SNORM:
+		return 8;
+
+	case DXGI_FORMAT_BC2_UNORM:
+	case DXGI_FORMAT_BC2_UNORM_SRGB:
+	case DXGI_FORMAT_BC3_UNORM:
+	case DXGI_FORMAT_BC3_UNORM_SRGB:
+	case DXGI_FORMAT_BC5_UNORM:
+	case DXGI_FORMAT_BC5_SNORM:
+	case DXGI_FORMAT_BC6H_UF16:
+	case DXGI_FORMAT_BC6H_SF16:
+	case DXGI_FORMAT_BC7_UNORM:
+	case DXGI_FORMAT_BC7_UNORM_SRGB:
+		return 16;
+
+	default:
+		return 0;
+	}
+}
+
+DXGI_FORMAT GetDecodedFormat(const DXGI_FORMAT format)
+{
+	switch (format)
+	{
+	case DXGI_FORMAT_BC1_UNORM:
+	case DXGI_FORMAT_BC2_UNORM:
+	case DXGI_FORMAT_BC3_UNORM:
+	case DXGI_FORMAT_BC4_UNORM:
+	case DXGI_FORMAT_BC5_UNORM:
+	case DXGI_FORMAT_BC7_UNORM:
+		return DXGI_FORMAT_R8G8B8A8_UNORM;
+
+	case DXGI_FORMAT_BC1_UNORM_SRGB:
+	case DXGI_FORMAT_BC2_UNORM_SRGB:
+	case DXGI_FORMAT_BC3_UNORM_SRGB:
+	case DXGI_FORMAT_BC7_UNORM_SRGB:
+		return DXGI_FORMAT_R8G8B8A8_UNORM_SRGB;
+
+	case DXGI_FORMAT_BC4_SNORM:
+	case DXGI_FORMAT_BC5_SNORM:
+		return DXGI_FORMAT_R8G8B8A8_SNORM;
+
+	case DXGI_FORMAT_BC6H_UF16:
+	case DXGI_FORMAT_BC6H_SF16:
+		return DXGI_FORMAT_R16G16B16A16_FLOAT;
+
+	default:
+		return DXGI_FORMAT_UNKNOWN;
+	}
+}
+
+void DecodeBlockRow(const DXGI_FORMAT format, const uint8_t* blocks, const uint32_t blockCount, uint8_t* texels, const size_t rowPitch)
+{
+	const uint32_t blockSize = GetBlockSize(format);
+	const uint32_t texelSize = GetDecodedFormat(format) == DXGI_FORMAT_R16G16B16A16_FLOAT ? 8 : 4;
+	uint32_t i = 0;
+
+#if VSGL_SIMD_AVX2
+	for (; i + 8 <= blockCount; i += 8)
+	{
+		if (!DecodeBlocks8(format, blocks + size_t{i} * blockSize, texels + size_t{i} * 4 * texelSize, rowPitch))
+		{
+			break;
+		}
+	}
+#endif
+
+	for (; i < blockCount; ++i)
+	{
+		DecodeBlock(format, blocks + size_t{i} * blockSize, texels + size_t{i} * 4 * texelSize, rowPitch);
+	}
+}
+} // namespace vsgl::cpu
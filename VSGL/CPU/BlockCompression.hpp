@@ -0,0 +1,27 @@
+#pragma once
+
+// Decoders of the block-compressed texture formats of D3D12 (BC1-BC7) for the CPU paths, following the decoding rules of the D3D11 functional
+// specification. Blocks decode to 4x4 texels of GetDecodedFormat():
+//   BC1, BC2, BC3, BC7: R8G8B8A8_UNORM or R8G8B8A8_UNORM_SRGB like the source.
+//   BC4, BC5: R8G8B8A8_UNORM or R8G8B8A8_SNORM like the source, with (red, green, 0, 1).
+//   BC6H: R16G16B16A16_FLOAT with (red, green, blue, 1), the exact half floats that the format encodes.
+// Interpolated 8-bit values are rounded to nearest, which the specification allows for UNORM formats (a GPU may differ by 1).
+
+#include "../../MiniEngine/Core/DDSFormat.h"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace vsgl::cpu
+{
+// Bytes of a compressed block, or 0 if format is not a BC format.
+uint32_t GetBlockSize(DXGI_FORMAT format);
+
+// The format of the decoded texels of a BC format.
+DXGI_FORMAT GetDecodedFormat(DXGI_FORMAT format);
+
+// Decodes blockCount consecutive blocks into the 4 texel rows that start at texels, rowPitch bytes apart.
+// With AVX2, BC1-BC5 are decoded 8 blocks at a time, one block per SIMD lane. BC6H and BC7 choose their bit layout per block, so they are decoded block
+// by block.
+void DecodeBlockRow(DXGI_FORMAT format, const uint8_t* blocks, uint32_t blockCount, uint8_t* texels, size_t rowPitch);
+} // namespace vsgl::cpu
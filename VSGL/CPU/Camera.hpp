@@ -0,0 +1,93 @@
+#pragma once
+
+#include "ShadingMath.hpp"
+
+#include <cmath>
+#include <numbers>
+
+namespace vsgl::cpu
+{
+// Portable counterpart of Math::Camera for the headless path.
+// It uses the same right-handed basis and reversed-Z perspective projection so that matrices match those uploaded by MyRenderer.
+class Camera
+{
+  public:
+	void SetEyeAtUp(const Float3& eye, const Float3& at, const Float3& up)
+	{
+		m_position = eye;
+		m_forward = Normalize(at - eye);
+		m_right = Normalize(Cross(m_forward, up));
+		m_up = Cross(m_right, m_forward);
+	}
+
+	void SetFOV(const float verticalFovInRadians) { m_verticalFOV = verticalFovInRadians; }
+	void SetAspectRatio(const float heightOverWidth) { m_aspectRatio = heightOverWidth; }
+	void SetZRange(const float nearZ, const float farZ)
+	{
+		m_nearClip = nearZ;
+		m_farClip = farZ;
+	}
+
+	const Float3& GetPosition() const { return m_position; }
+	const Float3& GetForwardVec() const { return m_forward; }
+	const Float3& GetRightVec() const { return m_right; }
+	const Float3& GetUpVec() const { return m_up; }
+	float GetFOV() const { return m_verticalFOV; }
+	float GetAspectRatio() const { return m_aspectRatio; }
+	float GetNearClip() const { return m_nearClip; }
+	float GetFarClip() const { return m_farClip; }
+
+	// Projection scales: clip.x = X * view.x, clip.y = Y * view.y.
+	float GetProjScaleY() const { return 1.0f / std::tan(m_verticalFOV * 0.5f); }
+	float GetProjScaleX() const { return GetProjScaleY() * m_aspectRatio; }
+
+	// Reversed Z: the near plane maps to 1 and the far plane to 0.
+	float GetQ1() const { return m_nearClip / (m_farClip - m_nearClip); }
+	float GetQ2() const { return GetQ1() * m_farClip; }
+
+	// NDC depth for a point at the given distance along the forward axis.
+	float DistanceToDepth(const float distance) const { return GetQ2() / distance - GetQ1(); }
+
+	// Equivalent of Math::Camera::GetViewProjMatrix() in the XMMATRIX memory layout.
+	Float4x4 GetViewProjMatrix() const
+	{
+		const float x = GetProjScaleX();
+		const float y = GetProjScaleY();
+		const float q1 = GetQ1();
+		const float q2 = GetQ2();
+		const Float3 back = -m_forward;
+
+		Float4x4 m{};
+		const auto setRow = [&](const uint32_t row, const float r, const float u, const float b, const float f) {
+			m.m[row][0] = x * r;
+			m.m[row][1] = y * u;
+			m.m[row][2] = q1 * b;
+			m.m[row][3] = f;
+		};
+		setRow(0, m_right.x, m_up.x, back.x, m_forward.x);
+		setRow(1, m_right.y, m_up.y, back.y, m_forward.y);
+		setRow(2, m_right.z, m_up.z, back.z, m_forward.z);
+		m.m[3][0] = -x * Dot(m_right, m_position);
+		m.m[3][1] = -y * Dot(m_up, m_position);
+		m.m[3][2] = -q1 * Dot(back, m_position) + q2;
+		m.m[3][3] = -Dot(m_forward, m_position);
+		return m;
+	}
+
+	// World-space direction through an NDC position (not normalized).
+	Float3 GetRayDirection(const float ndcX, const float ndcY) const
+	{
+		return m_forward + m_right * (ndcX / GetProjScaleX()) + m_up * (ndcY / GetProjScaleY());
+	}
+
+  private:
+	Float3 m_position = {0.0f, 0.0f, 0.0f};
+	Float3 m_forward = {0.0f, 0.0f, -1.0f};
+	Float3 m_right = {1.0f, 0.0f, 0.0f};
+	Float3 m_up = {0.0f, 1.0f, 0.0f};
+	float m_verticalFOV = std::numbers::pi_v<float> / 4.0f;
+	float m_aspectRatio = 9.0f / 16.0f;
+	float m_nearClip = 1.0f;
+	float m_farClip = 1000.0f;
+};
+} // namespace vsgl::cpu
@@ -0,0 +1,672 @@
+#include "DeferredLighting.hpp"
+#include "ShadowMap.hpp"
+#include "TaskPool.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cmath>
+
+namespace vsgl::cpu
+{
+namespace
+{
+using Vec3f8 = Vec3<Float8>;
+
+// Lane layout of a 4x2 block: lanes 0-3 are the upper row and lanes 4-7 the lower row. Quad 0 = {0, 1, 4, 5}, quad 1 = {2, 3, 6, 7}.
+constexpr uint32_t QUAD_TOP_LEFT[SIMD_WIDTH] = {0, 0, 2, 2, 0, 0, 2, 2};
+constexpr uint32_t QUAD_TOP_RIGHT[SIMD_WIDTH] = {1, 1, 3, 3, 1, 1, 3, 3};
+constexpr uint32_t QUAD_BOTTOM_LEFT[SIMD_WIDTH] = {4, 4, 6, 6, 4, 4, 6, 6};
+
+// Coarse derivatives like ddx/ddy on the GPU: a single difference per quad taken from its upper-left pixel.
+// Unlike helper lanes on the GPU, uncovered G-buffer pixels have no attributes, so the derivative is zero if a neighbor is uncovered.
+Float8 QuadDdx(const Float8 v, const Mask8 covered, const Float8 coveredValue)
+{
+	const Float8 d = v.Permute(QUAD_TOP_RIGHT) - v.Permute(QUAD_TOP_LEFT);
+	const Mask8 valid = (coveredValue.Permute(QUAD_TOP_RIGHT) != Float8(0.0f)) & (coveredValue.Permute(QUAD_TOP_LEFT) != Float8(0.0f)) & covered;
+	return Select(valid, d, Float8(0.0f));
+}
+
+Float8 QuadDdy(const Float8 v, const Mask8 covered, const Float8 coveredValue)
+{
+	const Float8 d = v.Permute(QUAD_BOTTOM_LEFT) - v.Permute(QUAD_TOP_LEFT);
+	const Mask8 valid = (coveredValue.Permute(QUAD_BOTTOM_LEFT) != Float8(0.0f)) & (coveredValue.Permute(QUAD_TOP_LEFT) != Float8(0.0f)) & covered;
+	return Select(valid, d, Float8(0.0f));
+}
+
+Float8 LoadBlock(const GBuffer& gbuffer, const GBUFFER_PLANE plane, const uint32_t x, const uint32_t y)
+{
+	const Image& image = gbuffer.GetPlane(plane);
+	return Float8::Load2x4(image.GetRow(y) + x, image.GetRow(y + 1) + x);
+}
+
+void StoreBlock(const Vec3f8& value, const uint32_t x, const uint32_t y, ColorImage& image)
+{
+	value.x.Store2x4(image.channels[0].GetRow(y) + x, image.channels[0].GetRow(y + 1) + x);
+	value.y.Store2x4(image.channels[1].GetRow(y) + x, image.channels[1].GetRow(y + 1) + x);
+	value.z.Store2x4(image.channels[2].GetRow(y) + x, image.channels[2].GetRow(y + 1) + x);
+}
+
+// Surface attributes of LightingPS after the normal mapping and NDF filtering.
+struct Surface
+{
+	Mask8 covered;
+	Vec3f8 position;
+	Vec3f8 normal;
+	Mat3<Float8> tangentFrame;
+	Vec3f8 viewDir;
+	Vec3f8 wi;
+	Vec3f8 diffuse;
+	Vec3f8 specular;
+	Vec2<Float8> alpha; // Filtered alpha roughness.
+};
+
+Surface LoadSurface(const GBuffer& gbuffer, const LightingConstants& constants, const uint32_t x, const uint32_t y)
+{
+	Surface s;
+	const Float8 depth = LoadBlock(gbuffer, GBUFFER_DEPTH, x, y);
+	s.covered = depth != Float8(GBuffer::CLEAR_DEPTH);
+	const Float8 coveredValue = Select(s.covered, Float8(1.0f), Float8(0.0f));
+
+	s.position = {LoadBlock(gbuffer, GBUFFER_POSITION_X, x, y), LoadBlock(gbuffer, GBUFFER_POSITION_Y, x, y), LoadBlock(gbuffer, GBUFFER_POSITION_Z, x, y)};
+
+	// Keep uncovered lanes finite so that they do not generate NaNs in the shared SIMD code.
+	const Vec3f8 vertexNormal = {LoadBlock(gbuffer, GBUFFER_NORMAL_X, x, y), LoadBlock(gbuffer, GBUFFER_NORMAL_Y, x, y), LoadBlock(gbuffer, GBUFFER_NORMAL_Z, x, y)};
+	const Vec3f8 baseNormal = Normalize(Select(s.covered, vertexNormal, Vec3f8{0.0f, 0.0f, 1.0f}));
+	const Vec3f8 vertexTangent = {LoadBlock(gbuffer, GBUFFER_TANGENT_X, x, y), LoadBlock(gbuffer, GBUFFER_TANGENT_Y, x, y), LoadBlock(gbuffer, GBUFFER_TANGENT_Z, x, y)};
+	const Vec3f8 tangent = Select(s.covered, vertexTangent, Vec3f8{1.0f, 0.0f, 0.0f});
+	const Float8 bitangentSign = Select(s.covered, LoadBlock(gbuffer, GBUFFER_BITANGENT_SIGN, x, y), Float8(1.0f));
+
+	const Mat3<Float8> baseTangentFrame = BuildTangentFrame(baseNormal, tangent, bitangentSign);
+	s.diffuse = {LoadBlock(gbuffer, GBUFFER_DIFFUSE_R, x, y), LoadBlock(gbuffer, GBUFFER_DIFFUSE_G, x, y), LoadBlock(gbuffer, GBUFFER_DIFFUSE_B, x, y)};
+	s.specular = {LoadBlock(gbuffer, GBUFFER_SPECULAR_R, x, y), LoadBlock(gbuffer, GBUFFER_SPECULAR_G, x, y), LoadBlock(gbuffer, GBUFFER_SPECULAR_B, x, y)};
+	const Vec3f8 normalTS = DecodeNormalMap(LoadBlock(gbuffer, GBUFFER_NORMAL_MAP_X, x, y), LoadBlock(gbuffer, GBUFFER_NORMAL_MAP_Y, x, y));
+	s.normal = Mul(normalTS, baseTangentFrame);
+	s.tangentFrame = BuildTangentFrame(s.normal, tangent, bitangentSign);
+	s.viewDir = Normalize(Vec3f8(constants.cameraPosition) - s.position);
+	s.wi = Mul(s.tangentFrame, s.viewDir);
+
+	const Float8 alpha = PerceptualRoughnessToAlpha(Select(s.covered, LoadBlock(gbuffer, GBUFFER_ROUGHNESS, x, y), Float8(1.0f)));
+
+	// Geometric specular antialiasing with NDF filtering.
+	const Vec3f8 dndx = {QuadDdx(baseNormal.x, s.covered, coveredValue), QuadDdx(baseNormal.y, s.covered, coveredValue), QuadDdx(baseNormal.z, s.covered, coveredValue)};
+	const Vec3f8 dndy = {QuadDdy(baseNormal.x, s.covered, coveredValue), QuadDdy(baseNormal.y, s.covered, coveredValue), QuadDdy(baseNormal.z, s.covered, coveredValue)};
+	s.alpha = IsotropicNDFFiltering(dndx, dndy, Vec2<Float8>{alpha, alpha});
+
+	return s;
+}
+
+Vec3f8 DirectIllumination(const Surface& s, const Image& shadowMap, const LightingConstants& constants)
+{
+	const Vec3f8 lightVec = Vec3f8(constants.lightPosition) - s.position;
+	const Float8 lightDistance2 = Dot(lightVec, lightVec);
+	const Vec3f8 lightDir = lightVec * Rsqrt(lightDistance2);
+	const Vec3f8 wo = Mul(s.tangentFrame, lightDir);
+	const Vec3f8 brdf = s.diffuse * Float8(1.0f / M_PI_F) + s.specular * SmithGGXBRDF(s.wi, wo, s.alpha); // Fresnel = 1 in this implementation.
+	const Vec3f8 shadowNDC = NDCTransform(s.position, constants.lightViewProj);
+	const Vec2<Float8> shadowTexcoord = NDCToTexcoord(shadowNDC.x, shadowNDC.y);
+	const Float8 visibility = SampleCmpLevelZero(shadowMap, shadowTexcoord, Saturate(shadowNDC.z));
+	return brdf * (constants.lightIntensity * visibility * Saturate(wo.z) / lightDistance2);
+}
+
+// Diffuse and specular illumination of the SG lights before they are multiplied by the albedos.
+struct IndirectIllumination
+{
+	Vec3f8 diffuse;
+	Vec3f8 specular;
+};
+
+// SGLighting() of LightingPS.hlsl without the albedos.
+template <bool PREVIOUS_SG_LIGHTING>
+IndirectIllumination SGLighting(const Surface& s, const SGLight (&sgLights)[SG_LIGHT_COUNT])
+{
+	const Vec3f8& viewDir = s.viewDir;
+	const Vec3f8& normal = s.normal;
+	const Vec3f8& wi = s.wi;
+	const Vec2<Float8>& alpha = s.alpha;
+
+	ASGLobe<Float8> specularLobe{};
+	Vec3f8 reflecVec;
+	Vec2<Float8> projAlpha2{};
+	Mat2<Float8> jjMat{};
+	Float8 detJJ4;
+
+	if constexpr (PREVIOUS_SG_LIGHTING)
+	{
+		specularLobe = ASGReflectionLobe(viewDir, normal, alpha.x * alpha.y); // Assume alpha.x == alpha.y
+		reflecVec = specularLobe.z * ASGSharpnessToSGSharpness(specularLobe.sharpness);
+	}
+	else
+	{
+		const Vec2<Float8> alpha2 = {alpha.x * alpha.x, alpha.y * alpha.y};
+		projAlpha2 = {alpha2.x / Max(1.0f - alpha2.x, Float8(FLT_MIN_F)), alpha2.y / Max(1.0f - alpha2.y, Float8(FLT_MIN_F))};
+
+		// Jacobian J between halfvectors and reflection vectors at halfvector = normal, and JJ^T for NDF filtering.
+		const Float8 vlen = Sqrt(wi.x * wi.x + wi.y * wi.y);
+		const Mask8 hasDir = vlen != Float8(0.0f);
+		const Float8 vx = Select(hasDir, wi.x / vlen, Float8(1.0f));
+		const Float8 vy = Select(hasDir, wi.y / vlen, Float8(0.0f));
+		const Float8 invZ = 0.5f / wi.z;
+		const Float8 j11 = vx * 0.5f;
+		const Float8 j12 = -vy * invZ;
+		const Float8 j21 = vy * 0.5f;
+		const Float8 j22 = vx * invZ;
+		jjMat = {j11 * j11 + j12 * j12, j11 * j21 + j12 * j22, j21 * j11 + j22 * j12, j21 * j21 + j22 * j22};
+		detJJ4 = 1.0f / (4.0f * wi.z * wi.z);
+
+		// Conservative SG sharpness of the reflection lobe for the visibility.
+		const Float8 alphaMax2 = Max(alpha2.x, alpha2.y);
+		const Float8 reflecSharpness = (1.0f - alphaMax2) / Max(2.0f * alphaMax2, Float8(FLT_MIN_F));
+		const Vec3f8 dominantNormal = Mul(GGXDominantVisibleNormal(wi, alpha), s.tangentFrame);
+		reflecVec = Reflect(-viewDir, dominantNormal) * reflecSharpness;
+	}
+
+	IndirectIllumination result = {{0.0f, 0.0f, 0.0f}, {0.0f, 0.0f, 0.0f}};
+
+	for (const SGLight& sgLight : sgLights)
+	{
+		const Vec3f8 lightVec = Vec3f8{sgLight.position[0], sgLight.position[1], sgLight.position[2]} - s.position;
+		const Float8 squaredDistance = Dot(lightVec, lightVec);
+		const Vec3f8 lightDir = lightVec * Rsqrt(squaredDistance);
+
+		// Clamp the variance for the numerical stability.
+		const Float8 variance = Max(Float8(sgLight.variance), squaredDistance * (1.0f / SGLIGHT_SHARPNESS_MAX));
+		const Float8 invVariance = 1.0f / variance;
+		const Vec3f8 emissive = Vec3f8{sgLight.intensity[0], sgLight.intensity[1], sgLight.intensity[2]} * invVariance;
+		const Float8 lightSharpness = squaredDistance * invVariance;
+		const SGLobe<Float8> lightLobe = SGProduct(Vec3f8{sgLight.axis[0], sgLight.axis[1], sgLight.axis[2]}, Float8(sgLight.sharpness), lightDir, lightSharpness);
+
+		Float8 diffuseIllumination;
+		Float8 specularIllumination;
+
+		if constexpr (PREVIOUS_SG_LIGHTING)
+		{
+			diffuseIllumination = SGClampedCosineProductIntegralOverPi2022(lightLobe, normal);
+			const Vec3f8 dominantDir = Normalize(reflecVec + lightLobe.axis * lightLobe.sharpness);
+			const Float8 coefficient = SmithGGXLobeOverUnnormalizedNDF(viewDir, dominantDir, normal, alpha.x * alpha.y);
+			specularIllumination = coefficient * ASGProductIntegral(specularLobe, lightLobe);
+		}
+		else
+		{
+			// Diffuse SG lighting.
+			const Float8 amplitude = Exp(lightLobe.logAmplitude);
+			const Float8 cosine = Clamp(Dot(lightLobe.axis, normal), Float8(-1.0f), Float8(1.0f));
+			diffuseIllumination = amplitude * SGClampedCosineProductIntegralOverPi2024(cosine, lightLobe.sharpness);
+
+			// Glossy SG lighting with NDF filtering.
+			const Float8 lightLobeVariance = 1.0f / lightLobe.sharpness;
+			const Mat2<Float8> filteredProj = {projAlpha2.x + 2.0f * lightLobeVariance * jjMat.m11, 2.0f * lightLobeVariance * jjMat.m12, 2.0f * lightLobeVariance * jjMat.m21, projAlpha2.y + 2.0f * lightLobeVariance * jjMat.m22};
+			const Float8 det = projAlpha2.x * projAlpha2.y + 2.0f * lightLobeVariance * (projAlpha2.x * jjMat.m11 + projAlpha2.y * jjMat.m22) + lightLobeVariance * lightLobeVariance * detJJ4;
+			const Float8 tr = filteredProj.m11 + filteredProj.m22;
+			const Float8 denom = 1.0f + tr + det;
+			const Mask8 finite = IsFinite(denom);
+			const Float8 fallback11 = Min(filteredProj.m11, Float8(FLT_MAX_F)) / Min(filteredProj.m11 + 1.0f, Float8(FLT_MAX_F));
+			const Float8 fallback22 = Min(filteredProj.m22, Float8(FLT_MAX_F)) / Min(filteredProj.m22 + 1.0f, Float8(FLT_MAX_F));
+			const Mat2<Float8> filteredRoughnessMat = {
+				Select(finite, Min(filteredProj.m11 + det, Float8(FLT_MAX_F)) / denom, fallback11),
+				Select(finite, Min(filteredProj.m12, Float8(FLT_MAX_F)) / denom, Float8(0.0f)),
+				Select(finite, Min(filteredProj.m21, Float8(FLT_MAX_F)) / denom, Float8(0.0f)),
+				Select(finite, Min(filteredProj.m22 + det, Float8(FLT_MAX_F)) / denom, fallback22),
+			};
+
+			// Evaluate the filtered reflection lobe.
+			const Vec3f8 halfvecUnormalized = wi + Mul(s.tangentFrame, lightLobe.axis);
+			const Vec3f8 halfvec = halfvecUnormalized / Max(Length(halfvecUnormalized), Float8(FLT_MIN_F));
+			const Float8 lobe = SGGXReflectionPDF(wi, halfvec, filteredRoughnessMat);
+
+			// Visibility of the SG light in the upper hemisphere.
+			const Vec3f8 prodVec = reflecVec + lightLobe.axis * lightLobe.sharpness;
+			const Float8 prodSharpness = Length(prodVec);
+			const Vec3f8 prodDir = prodVec / prodSharpness;
+			const Float8 visibility = VMFHemisphericalIntegral(Dot(prodDir, normal), prodSharpness);
+
+			specularIllumination = amplitude * visibility * lobe * SGIntegral(lightLobe.sharpness);
+		}
+
+		result.diffuse += emissive * diffuseIllumination;
+		result.specular += emissive * specularIllumination;
+	}
+
+	return result;
+}
+
+// Reduced-resolution SG lighting. Sample (i, j) is taken from the full-resolution pixel (SubsampleCoordinate(i), SubsampleCoordinate(j)).
+struct ReducedIndirect
+{
+	uint32_t factor;
+	const GBuffer& gbuffer;
+	const Image& distance;
+	const ColorImage& diffuse;
+	const ColorImage& specular;
+};
+
+constexpr float UPSAMPLE_DEPTH_TOLERANCE = 0.05f; // Relative distance difference where the depth weight reaches zero.
+constexpr float UPSAMPLE_BILINEAR_BIAS = 0.05f;   // Keeps every tap of the 2x2 footprint eligible when the bilinear weight of the nearest one is rejected.
+constexpr float UPSAMPLE_WEIGHT_THRESHOLD = 1.0e-3f;
+
+uint32_t SubsampleCoordinate(const uint32_t i, const uint32_t factor, const uint32_t size)
+{
+	return std::min(i * factor + factor / 2, size - 1);
+}
+
+// Joint bilateral upsampling [Kopf et al. 2007] of the SG lighting with a 2x2 bilinear footprint.
+// The range weights use the relative camera distance and the vertex normal, so that the illumination does not leak across depth discontinuities and creases.
+// Covered lanes whose total weight is too small (e.g., thin geometry missed by the subsampling) are cleared from valid.
+IndirectIllumination UpsampleIndirect(const ReducedIndirect& reduced, const GBuffer& gbuffer, const Surface& s, const LightingConstants& constants, const uint32_t x, const uint32_t y, Mask8& valid)
+{
+	// All the reduced-resolution planes have the same dimensions and thus the same pitch.
+	const uint32_t pitch = reduced.distance.GetPitch();
+	const uint32_t shift = std::countr_zero(reduced.factor);
+	const float invFactor = 1.0f / static_cast<float>(reduced.factor);
+
+	// Footprint along each axis: the first sample is the one at or before the pixel. The 4x2 block has 4 columns and 2 rows.
+	const auto footprint = [&](const uint32_t p, const uint32_t size, uint32_t (&index)[2], float (&weight)[2]) {
+		const int r = static_cast<int>(p) - static_cast<int>(reduced.factor / 2);
+		const int i0 = r >> shift; // Arithmetic shift rounds toward negative infinity.
+		const float f = static_cast<float>(r - (i0 << shift)) * invFactor;
+		index[0] = static_cast<uint32_t>(std::clamp(i0, 0, static_cast<int>(size) - 1));
+		index[1] = static_cast<uint32_t>(std::clamp(i0 + 1, 0, static_cast<int>(size) - 1));
+		weight[0] = 1.0f - f;
+		weight[1] = f;
+	};
+
+	uint32_t columns[4][2];
+	float columnWeights[4][2];
+	uint32_t rows[2][2];
+	float rowWeights[2][2];
+
+	for (uint32_t i = 0; i < 4; ++i)
+	{
+		footprint(x + i, reduced.distance.GetWidth(), columns[i], columnWeights[i]);
+	}
+
+	for (uint32_t j = 0; j < 2; ++j)
+	{
+		footprint(y + j, reduced.distance.GetHeight(), rows[j], rowWeights[j]);
+		rows[j][0] *= pitch;
+		rows[j][1] *= pitch;
+	}
+
+	uint32_t offsets[4][SIMD_WIDTH];
+	float bilinear[4][SIMD_WIDTH];
+
+	for (uint32_t tap = 0; tap < 4; ++tap)
+	{
+		for (uint32_t lane = 0; lane < SIMD_WIDTH; ++lane)
+		{
+			offsets[tap][lane] = rows[lane / 4][tap >> 1] + columns[lane % 4][tap & 1];
+			bilinear[tap][lane] = rowWeights[lane / 4][tap >> 1] * columnWeights[lane % 4][tap & 1] + UPSAMPLE_BILINEAR_BIAS;
+		}
+	}
+
+	const Float8 distance = Length(s.position - Vec3f8(constants.cameraPosition));
+	const Float8 depthScale = 1.0f / Max(UPSAMPLE_DEPTH_TOLERANCE * distance, Float8(FLT_MIN_F));
+	const Vec3f8 normal = {LoadBlock(gbuffer, GBUFFER_NORMAL_X, x, y), LoadBlock(gbuffer, GBUFFER_NORMAL_Y, x, y), LoadBlock(gbuffer, GBUFFER_NORMAL_Z, x, y)};
+	const float* reducedNormal[3] = {reduced.gbuffer.GetPlane(GBUFFER_NORMAL_X).GetData(), reduced.gbuffer.GetPlane(GBUFFER_NORMAL_Y).GetData(), reduced.gbuffer.GetPlane(GBUFFER_NORMAL_Z).GetData()};
+
+	IndirectIllumination sum = {{0.0f, 0.0f, 0.0f}, {0.0f, 0.0f, 0.0f}};
+	Float8 weightSum = 0.0f;
+
+	for (uint32_t tap = 0; tap < 4; ++tap)
+	{
+		const uint32_t(&offset)[SIMD_WIDTH] = offsets[tap];
+		const Float8 sampleDistance = Float8::Gather(reduced.distance.GetData(), offset);
+		const Float8 depthWeight = Select(sampleDistance >= Float8(0.0f), Max(1.0f - Abs(sampleDistance - distance) * depthScale, Float8(0.0f)), Float8(0.0f));
+		const Vec3f8 sampleNormal = {Float8::Gather(reducedNormal[0], offset), Float8::Gather(reducedNormal[1], offset), Float8::Gather(reducedNormal[2], offset)};
+		Float8 normalWeight = Saturate(Dot(normal, sampleNormal));
+		normalWeight *= normalWeight;
+		normalWeight *= normalWeight;
+		normalWeight *= normalWeight; // cos^8
+		const Float8 weight = Float8::Load(bilinear[tap]) * depthWeight * normalWeight;
+
+		const auto gather = [&](const ColorImage& image) {
+			return Vec3f8{Float8::Gather(image.channels[0].GetData(), offset), Float8::Gather(image.channels[1].GetData(), offset), Float8::Gather(image.channels[2].GetData(), offset)};
+		};
+		sum.diffuse += gather(reduced.diffuse) * weight;
+		sum.specular += gather(reduced.specular) * weight;
+		weightSum += weight;
+	}
+
+	valid = (weightSum >= Float8(UPSAMPLE_WEIGHT_THRESHOLD)) | !s.covered;
+	const Float8 invWeightSum = 1.0f / Max(weightSum, Float8(UPSAMPLE_WEIGHT_THRESHOLD));
+	return {sum.diffuse * invWeightSum, sum.specular * invWeightSum};
+}
+
+// Point-subsamples the G-buffer and computes the depth guide of the upsampling.
+void SubsampleGBuffer(TaskPool& taskPool, const GBuffer& gbuffer, const uint32_t factor, const Float3& cameraPosition, GBuffer& reducedGBuffer, Image& reducedDistance)
+{
+	const uint32_t width = reducedGBuffer.GetWidth();
+	const uint32_t height = reducedGBuffer.GetHeight();
+
+	taskPool.ParallelFor(height, [&](const uint32_t j, uint32_t) {
+		const uint32_t sy = SubsampleCoordinate(j, factor, gbuffer.GetHeight());
+
+		for (uint32_t plane = 0; plane < GBUFFER_PLANE_COUNT; ++plane)
+		{
+			const float* src = gbuffer.GetPlane(static_cast<GBUFFER_PLANE>(plane)).GetRow(sy);
+			float* dst = reducedGBuffer.GetPlane(static_cast<GBUFFER_PLANE>(plane)).GetRow(j);
+
+			for (uint32_t i = 0; i < width; ++i)
+			{
+				dst[i] = src[SubsampleCoordinate(i, factor, gbuffer.GetWidth())];
+			}
+		}
+
+		const Image& depth = reducedGBuffer.GetPlane(GBUFFER_DEPTH);
+		const Image& positionX = reducedGBuffer.GetPlane(GBUFFER_POSITION_X);
+		const Image& positionY = reducedGBuffer.GetPlane(GBUFFER_POSITION_Y);
+		const Image& positionZ = reducedGBuffer.GetPlane(GBUFFER_POSITION_Z);
+
+		for (uint32_t i = 0; i < width; ++i)
+		{
+			const Float3 v = Float3{positionX(i, j), positionY(i, j), positionZ(i, j)} - cameraPosition;
+			reducedDistance(i, j) = (depth(i, j) != GBuffer::CLEAR_DEPTH) ? Length(v) : -1.0f;
+		}
+	});
+}
+
+template <bool PREVIOUS_SG_LIGHTING>
+void ShadeIndirectTile(const GBuffer& gbuffer, const LightingConstants& constants, const uint32_t tileX, const uint32_t tileY, ColorImage& diffuse, ColorImage& specular)
+{
+	const uint32_t x0 = tileX * DeferredLighting::TILE_WIDTH;
+	const uint32_t y0 = tileY * DeferredLighting::TILE_HEIGHT;
+	const uint32_t x1 = std::min(x0 + DeferredLighting::TILE_WIDTH, gbuffer.GetWidth());
+	const uint32_t y1 = std::min(y0 + DeferredLighting::TILE_HEIGHT, gbuffer.GetHeight());
+
+	for (uint32_t y = y0; y < y1; y += 2)
+	{
+		for (uint32_t x = x0; x < x1; x += 4)
+		{
+			const Surface surface = LoadSurface(gbuffer, constants, x, y);
+			IndirectIllumination illumination = {{0.0f, 0.0f, 0.0f}, {0.0f, 0.0f, 0.0f}};
+
+			if (Any(surface.covered))
+			{
+				illumination = SGLighting<PREVIOUS_SG_LIGHTING>(surface, constants.sgLights);
+				illumination.diffuse = Select(surface.covered, illumination.diffuse, Vec3f8{0.0f, 0.0f, 0.0f});
+				illumination.specular = Select(surface.covered, illumination.specular, Vec3f8{0.0f, 0.0f, 0.0f});
+			}
+
+			StoreBlock(illumination.diffuse, x, y, diffuse);
+			StoreBlock(illumination.specular, x, y, specular);
+		}
+	}
+}
+
+// Temporal reuse of the SG lighting.
+struct TemporalIndirect
+{
+	const IndirectHistory& previous;
+	IndirectHistory& current;
+	Float4x4 previousViewProj;
+	Float3 previousCameraPosition;
+	bool hasHistory;
+	uint32_t refreshPeriod;
+	uint32_t refreshPhase;
+};
+
+constexpr float REPROJECTION_DEPTH_TOLERANCE = 0.02f; // Relative distance difference to reject a history sample.
+constexpr float REPROJECTION_NORMAL_THRESHOLD = 0.9f; // Minimum cosine between the current and history vertex normals.
+constexpr float REPROJECTION_WEIGHT_THRESHOLD = 1.0e-2f;
+
+// Rotating refresh pattern over 4x2 pixel blocks. Rows of blocks are offset so that the refreshed blocks do not form vertical stripes.
+bool IsRefreshBlock(const TemporalIndirect& temporal, const uint32_t x, const uint32_t y)
+{
+	return (x / 4 + (y / 2) * (temporal.refreshPeriod / 2 + 1)) % temporal.refreshPeriod == temporal.refreshPhase;
+}
+
+// Bilinear reprojection of the previous SG lighting. Taps are rejected individually by the distance from the previous camera and the vertex normal.
+// Covered lanes without any accepted tap (disocclusions and pixels outside the previous view) are cleared from valid.
+IndirectIllumination ReprojectIndirect(const TemporalIndirect& temporal, const Surface& s, const Vec3f8& normal, Mask8& valid)
+{
+	const IndirectHistory& history = temporal.previous;
+	const uint32_t width = history.distance.GetWidth();
+	const uint32_t height = history.distance.GetHeight();
+	const uint32_t pitch = history.distance.GetPitch();
+	const Float4x4& m = temporal.previousViewProj;
+
+	const Float8 w = s.position.x * m.m[0][3] + s.position.y * m.m[1][3] + s.position.z * m.m[2][3] + m.m[3][3];
+	const Vec3f8 ndc = NDCTransform(s.position, m);
+	const Vec2<Float8> texcoord = NDCToTexcoord(ndc.x, ndc.y);
+	const Float8 u = texcoord.x * static_cast<float>(width) - 0.5f;
+	const Float8 v = texcoord.y * static_cast<float>(height) - 0.5f;
+	const Float8 u0 = Floor(u);
+	const Float8 v0 = Floor(v);
+	const Float8 fu = u - u0;
+	const Float8 fv = v - v0;
+
+	uint32_t offsets[4][SIMD_WIDTH];
+	float inside[4][SIMD_WIDTH];
+	const uint32_t frontBits = (w > Float8(0.0f)).Bits();
+
+	for (uint32_t lane = 0; lane < SIMD_WIDTH; ++lane)
+	{
+		// Clamp before the conversion since points behind the previous camera can be projected anywhere.
+		const int x0 = static_cast<int>(std::clamp(u0.Lane(lane), -2.0f, static_cast<float>(width) + 1.0f));
+		const int y0 = static_cast<int>(std::clamp(v0.Lane(lane), -2.0f, static_cast<float>(height) + 1.0f));
+		const bool front = (frontBits & (1u << lane)) != 0;
+
+		for (uint32_t tap = 0; tap < 4; ++tap)
+		{
+			const int x = x0 + static_cast<int>(tap & 1);
+			const int y = y0 + static_cast<int>(tap >> 1);
+			const bool isInside = front && (x >= 0) && (y >= 0) && (x < static_cast<int>(width)) && (y < static_cast<int>(height));
+			offsets[tap][lane] = isInside ? static_cast<uint32_t>(y) * pitch + static_cast<uint32_t>(x) : 0;
+			inside[tap][lane] = isInside ? 1.0f : 0.0f;
+		}
+	}
+
+	const Float8 previousDistance = Length(s.position - Vec3f8(temporal.previousCameraPosition));
+	const Float8 bilinear[4] = {(1.0f - fu) * (1.0f - fv), fu * (1.0f - fv), (1.0f - fu) * fv, fu * fv};
+
+	IndirectIllumination sum = {{0.0f, 0.0f, 0.0f}, {0.0f, 0.0f, 0.0f}};
+	Float8 weightSum = 0.0f;
+
+	for (uint32_t tap = 0; tap < 4; ++tap)
+	{
+		const uint32_t(&offset)[SIMD_WIDTH] = offsets[tap];
+		const auto gather = [&](const ColorImage& image) {
+			return Vec3f8{Float8::Gather(image.channels[0].GetData(), offset), Float8::Gather(image.channels[1].GetData(), offset), Float8::Gather(image.channels[2].GetData(), offset)};
+		};
+
+		const Float8 historyDistance = Float8::Gather(history.distance.GetData(), offset);
+		const Mask8 accepted = (Float8::Load(inside[tap]) != Float8(0.0f)) & (historyDistance >= Float8(0.0f)) & (Abs(historyDistance - previousDistance) <= REPROJECTION_DEPTH_TOLERANCE * previousDistance) &
+		                       (Dot(normal, gather(history.normal)) >= Float8(REPROJECTION_NORMAL_THRESHOLD));
+		const Float8 weight = Select(accepted, bilinear[tap], Float8(0.0f));
+		sum.diffuse += gather(history.diffuse) * weight;
+		sum.specular += gather(history.specular) * weight;
+		weightSum += weight;
+	}
+
+	valid = (weightSum >= Float8(REPROJECTION_WEIGHT_THRESHOLD)) | !s.covered;
+	const Float8 invWeightSum = 1.0f / Max(weightSum, Float8(REPROJECTION_WEIGHT_THRESHOLD));
+	return {sum.diffuse * invWeightSum, sum.specular * invWeightSum};
+}
+
+struct TileStatistics
+{
+	uint32_t coveredBlockCount = 0;
+	uint32_t indirectBlockCount = 0;
+};
+
+template <bool PREVIOUS_SG_LIGHTING>
+TileStatistics ShadeTile(const GBuffer& gbuffer, const Image& shadowMap, const LightingConstants& constants, const ReducedIndirect* reduced, TemporalIndirect* temporal, const uint32_t tileX, const uint32_t tileY, ColorImage& output)
+{
+	const uint32_t x0 = tileX * DeferredLighting::TILE_WIDTH;
+	const uint32_t y0 = tileY * DeferredLighting::TILE_HEIGHT;
+	const uint32_t x1 = std::min(x0 + DeferredLighting::TILE_WIDTH, gbuffer.GetWidth());
+	const uint32_t y1 = std::min(y0 + DeferredLighting::TILE_HEIGHT, gbuffer.GetHeight());
+	TileStatistics statistics;
+
+	for (uint32_t y = y0; y < y1; y += 2)
+	{
+		for (uint32_t x = x0; x < x1; x += 4)
+		{
+			const Surface surface = LoadSurface(gbuffer, constants, x, y);
+			Vec3f8 radiance = {0.0f, 0.0f, 0.0f};
+			IndirectIllumination indirect = {{0.0f, 0.0f, 0.0f}, {0.0f, 0.0f, 0.0f}};
+			Vec3f8 vertexNormal = {0.0f, 0.0f, 0.0f};
+
+			if (Any(surface.covered))
+			{
+				++statistics.coveredBlockCount;
+				bool shadeIndirect = true;
+
+				if (temporal != nullptr)
+				{
+					vertexNormal = {LoadBlock(gbuffer, GBUFFER_NORMAL_X, x, y), LoadBlock(gbuffer, GBUFFER_NORMAL_Y, x, y), LoadBlock(gbuffer, GBUFFER_NORMAL_Z, x, y)};
+
+					if (temporal->hasHistory && !IsRefreshBlock(*temporal, x, y))
+					{
+						Mask8 valid;
+						indirect = ReprojectIndirect(*temporal, surface, vertexNormal, valid);
+						shadeIndirect = !All(valid);
+					}
+				}
+
+				if (shadeIndirect)
+				{
+					++statistics.indirectBlockCount;
+
+					if (reduced != nullptr)
+					{
+						Mask8 valid;
+						indirect = UpsampleIndirect(*reduced, gbuffer, surface, constants, x, y, valid);
+
+						if (!All(valid))
+						{
+							const IndirectIllumination fallback = SGLighting<PREVIOUS_SG_LIGHTING>(surface, constants.sgLights);
+							indirect.diffuse = Select(valid, indirect.diffuse, fallback.diffuse);
+							indirect.specular = Select(valid, indirect.specular, fallback.specular);
+						}
+					}
+					else
+					{
+						indirect = SGLighting<PREVIOUS_SG_LIGHTING>(surface, constants.sgLights);
+					}
+				}
+
+				indirect.diffuse = Select(surface.covered, indirect.diffuse, Vec3f8{0.0f, 0.0f, 0.0f});
+				indirect.specular = Select(surface.covered, indirect.specular, Vec3f8{0.0f, 0.0f, 0.0f});
+				radiance = DirectIllumination(surface, shadowMap, constants) + surface.diffuse * indirect.diffuse + surface.specular * indirect.specular;
+				radiance = Select(surface.covered, radiance, Vec3f8{0.0f, 0.0f, 0.0f});
+			}
+
+			StoreBlock(radiance, x, y, output);
+
+			if (temporal != nullptr)
+			{
+				IndirectHistory& history = temporal->current;
+				const Float8 distance = Select(surface.covered, Length(surface.position - Vec3f8(constants.cameraPosition)), Float8(-1.0f));
+				distance.Store2x4(history.distance.GetRow(y) + x, history.distance.GetRow(y + 1) + x);
+				StoreBlock(indirect.diffuse, x, y, history.diffuse);
+				StoreBlock(indirect.specular, x, y, history.specular);
+				StoreBlock(vertexNormal, x, y, history.normal);
+			}
+		}
+	}
+
+	return statistics;
+}
+} // namespace
+
+void DeferredLighting::Shade(TaskPool& taskPool, const GBuffer& gbuffer, const Image& shadowMap, const LightingConstants& constants, const LightingSettings& settings, ColorImage& output)
+{
+	const uint32_t screenWidth = gbuffer.GetWidth();
+	const uint32_t screenHeight = gbuffer.GetHeight();
+
+	if (output.GetWidth() != screenWidth || output.GetHeight() != screenHeight)
+	{
+		output.Resize(screenWidth, screenHeight);
+	}
+
+	const bool previousSGLighting = settings.previousSGLighting;
+	const uint32_t factor = std::bit_floor(std::max(settings.indirectDownsample, 1u)); // The upsampling assumes a power of two.
+	const ReducedIndirect reduced = {factor, m_indirectGBuffer, m_indirectDistance, m_indirectDiffuse, m_indirectSpecular};
+
+	if (factor > 1)
+	{
+		const uint32_t width = (screenWidth + factor - 1) / factor;
+		const uint32_t height = (screenHeight + factor - 1) / factor;
+
+		if (m_indirectGBuffer.GetWidth() != width || m_indirectGBuffer.GetHeight() != height)
+		{
+			m_indirectGBuffer.Resize(width, height);
+			m_indirectDistance.Resize(width, height);
+			m_indirectDiffuse.Resize(width, height);
+			m_indirectSpecular.Resize(width, height);
+		}
+
+		SubsampleGBuffer(taskPool, gbuffer, factor, constants.cameraPosition, m_indirectGBuffer, m_indirectDistance);
+
+		const uint32_t tileCountX = (width + TILE_WIDTH - 1) / TILE_WIDTH;
+		const uint32_t tileCountY = (height + TILE_HEIGHT - 1) / TILE_HEIGHT;
+
+		taskPool.ParallelFor(tileCountX * tileCountY, [&](const uint32_t tileIndex, uint32_t) {
+			if (previousSGLighting)
+			{
+				ShadeIndirectTile<true>(m_indirectGBuffer, constants, tileIndex % tileCountX, tileIndex / tileCountX, m_indirectDiffuse, m_indirectSpecular);
+			}
+			else
+			{
+				ShadeIndirectTile<false>(m_indirectGBuffer, constants, tileIndex % tileCountX, tileIndex / tileCountX, m_indirectDiffuse, m_indirectSpecular);
+			}
+		});
+	}
+
+	IndirectHistory& previousHistory = m_histories[m_historyIndex];
+	IndirectHistory& currentHistory = m_histories[m_historyIndex ^ 1];
+
+	if (settings.temporalIndirect)
+	{
+		if (currentHistory.distance.GetWidth() != screenWidth || currentHistory.distance.GetHeight() != screenHeight)
+		{
+			for (IndirectHistory& history : m_histories)
+			{
+				history.diffuse.Resize(screenWidth, screenHeight);
+				history.specular.Resize(screenWidth, screenHeight);
+				history.distance.Resize(screenWidth, screenHeight);
+				history.normal.Resize(screenWidth, screenHeight);
+			}
+
+			m_historyValid = false;
+		}
+
+		m_historyValid = m_historyValid && (m_historyPreviousSGLighting == previousSGLighting);
+	}
+
+	const uint32_t refreshPeriod = std::max(settings.temporalRefreshPeriod, 1u);
+	TemporalIndirect temporal = {previousHistory, currentHistory, m_historyViewProj, m_historyCameraPosition, m_historyValid, refreshPeriod, m_frameIndex % refreshPeriod};
+	TemporalIndirect* temporalIndirect = settings.temporalIndirect ? &temporal : nullptr;
+	const ReducedIndirect* reducedIndirect = (factor > 1) ? &reduced : nullptr;
+
+	const uint32_t tileCountX = (screenWidth + TILE_WIDTH - 1) / TILE_WIDTH;
+	const uint32_t tileCountY = (screenHeight + TILE_HEIGHT - 1) / TILE_HEIGHT;
+	std::atomic<uint32_t> coveredBlockCount = 0;
+	std::atomic<uint32_t> indirectBlockCount = 0;
+
+	taskPool.ParallelFor(tileCountX * tileCountY, [&](const uint32_t tileIndex, uint32_t) {
+		const TileStatistics statistics = previousSGLighting ? ShadeTile<true>(gbuffer, shadowMap, constants, reducedIndirect, temporalIndirect, tileIndex % tileCountX, tileIndex / tileCountX, output)
+		                                                     : ShadeTile<false>(gbuffer, shadowMap, constants, reducedIndirect, temporalIndirect, tileIndex % tileCountX, tileIndex / tileCountX, output);
+		coveredBlockCount.fetch_add(statistics.coveredBlockCount, std::memory_order_relaxed);
+		indirectBlockCount.fetch_add(statistics.indirectBlockCount, std::memory_order_relaxed);
+	});
+
+	m_statistics.coveredBlockCount = coveredBlockCount.load(std::memory_order_relaxed);
+	m_statistics.indirectBlockCount = indirectBlockCount.load(std::memory_order_relaxed);
+
+	if (settings.temporalIndirect)
+	{
+		m_historyIndex ^= 1;
+		m_historyValid = true;
+		m_historyPreviousSGLighting = previousSGLighting;
+		m_historyViewProj = constants.viewProj;
+		m_historyCameraPosition = constants.cameraPosition;
+		++m_frameIndex;
+	}
+	else
+	{
+		m_historyValid = false;
+	}
+}
+} // namespace vsgl::cpu
@@ -0,0 +1,87 @@
+#pragma once
+
+#include "Image.hpp"
+#include "SGLight.hpp"
+#include "ShadingMath.hpp"
+
+#include <cstdint>
+
+namespace vsgl::cpu
+{
+class TaskPool;
+
+// Constants of LightingVS and LightingPS.
+struct LightingConstants
+{
+	Float4x4 viewProj; // Only used for the temporal reprojection.
+	Float4x4 lightViewProj;
+	Float3 cameraPosition;
+	Float3 lightPosition;
+	float lightIntensity;
+	SGLight sgLights[SG_LIGHT_COUNT];
+};
+
+struct LightingSettings
+{
+	bool previousSGLighting = false;    // Use the ASG-based method (PREVIOUS_SG_LIGHTING).
+	uint32_t indirectDownsample = 1;    // Resolution divisor of the SG lighting (1, 2 or 4). Direct lighting is always shaded at full resolution.
+	bool temporalIndirect = false;      // Reuse the SG lighting of the previous frame through reprojection.
+	uint32_t temporalRefreshPeriod = 4; // With temporalIndirect, each 4x2 pixel block re-shades its SG lighting once every this many frames.
+};
+
+struct LightingStatistics
+{
+	uint32_t coveredBlockCount = 0;  // 4x2 pixel blocks with at least one covered pixel.
+	uint32_t indirectBlockCount = 0; // Covered blocks whose SG lighting was shaded (or upsampled) instead of reprojected.
+};
+
+// SG lighting (without the albedos) of the previous frame and the attributes to validate its reprojection.
+struct IndirectHistory
+{
+	ColorImage diffuse;
+	ColorImage specular;
+	Image distance;    // Distance from the camera. Negative for uncovered pixels.
+	ColorImage normal; // Vertex normal.
+};
+
+// CPU implementation of LightingPS over a G-buffer.
+// The screen is split into tiles that are distributed over the task pool. Each tile is shaded in 4x2 pixel blocks (two 2x2 quads) across the 8 SIMD lanes,
+// and the screen-space derivatives of the base normal are taken within each quad like ddx/ddy on the GPU.
+// With LightingSettings::indirectDownsample > 1, the SG lighting is shaded on a subsampled G-buffer without the albedos (diffuse and specular illumination)
+// and reconstructed per pixel with a joint bilateral upsampling guided by depth and normal [Kopf et al. 2007]. Pixels without any valid low-resolution sample
+// fall back to the full-resolution SG lighting.
+// With LightingSettings::temporalIndirect, the SG lighting of the previous frame is reprojected with bilinear taps rejected by depth and normal.
+// Each block is re-shaded when its turn in the rotating refresh comes or when any of its pixels is disoccluded.
+class DeferredLighting
+{
+  public:
+	static constexpr uint32_t TILE_WIDTH = 32;
+	static constexpr uint32_t TILE_HEIGHT = 16;
+
+	// shadowMap is the light's D32 depth image (reversed Z). It is sampled like SampleCmpLevelZero with D3D12_FILTER_COMPARISON_MIN_MAG_LINEAR_MIP_POINT,
+	// D3D12_COMPARISON_FUNC_GREATER and a white border.
+	void Shade(TaskPool& taskPool, const GBuffer& gbuffer, const Image& shadowMap, const LightingConstants& constants, const LightingSettings& settings, ColorImage& output);
+
+	// Discards the temporal history, e.g., on camera cuts or scene changes.
+	void ResetHistory() { m_historyValid = false; }
+	const LightingStatistics& GetStatistics() const { return m_statistics; }
+
+  private:
+	// Intermediate buffers of the reduced-resolution SG lighting, kept across frames to avoid reallocation.
+	GBuffer m_indirectGBuffer;
+	Image m_indirectDistance; // Distance from the camera used as the depth guide. Negative for uncovered pixels.
+	ColorImage m_indirectDiffuse;
+	ColorImage m_indirectSpecular;
+
+	// Temporal history, double buffered since it is read while the next one is written.
+	IndirectHistory m_histories[2];
+	uint32_t m_historyIndex = 0; // Index of the history written by the last frame.
+	bool m_historyValid = false;
+	bool m_historyPreviousSGLighting = false;
+	Float4x4 m_historyViewProj = {};
+	Float3 m_historyCameraPosition = {0.0f, 0.0f, 0.0f};
+	uint32_t m_frameIndex = 0;
+
+	LightingStatistics m_statistics;
+};
+} // namespace vsgl::cpu
@@ -0,0 +1,559 @@
+#include "DepthRasterizer.hpp"
+
+#include "SIMD.hpp"
+#include "TaskPool.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <utility>
+
+namespace vsgl::cpu
+{
+namespace
+{
+constexpr int32_t SUBPIXEL_SCALE = 256; // D3D12 snaps vertices to 8-bit subpixels.
+constexpr int32_t HALF_PIXEL = SUBPIXEL_SCALE / 2;
+
+// Guard band in NDC. Triangles inside it are rasterized without clipping. It keeps snapped coordinates of render targets up to 16384 pixels
+// within 25 bits so that the edge functions fit int64 and are exact in double.
+constexpr float GUARD_BAND = 8.0f;
+
+// Clip planes as dot(plane, clip position) >= 0: the near plane (z <= w for reversed Z) and the guard band.
+constexpr float CLIP_PLANES[][4] = {
+	{0.0f, 0.0f, -1.0f, 1.0f},
+	{-1.0f, 0.0f, 0.0f, GUARD_BAND},
+	{1.0f, 0.0f, 0.0f, GUARD_BAND},
+	{0.0f, -1.0f, 0.0f, GUARD_BAND},
+	{0.0f, 1.0f, 0.0f, GUARD_BAND},
+};
+constexpr uint32_t CLIP_PLANE_COUNT = static_cast<uint32_t>(std::size(CLIP_PLANES));
+constexpr uint32_t MAX_CLIPPED_VERTEX_COUNT = 3 + CLIP_PLANE_COUNT;
+
+constexpr uint32_t VERTICES_PER_TASK = 4096;
+constexpr uint32_t TRIANGLES_PER_TASK = 1024;
+
+constexpr float LANE_OFFSETS[SIMD_WIDTH] = {0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f};
+
+struct DrawRange
+{
+	uint32_t drawIndex;
+	uint32_t begin;
+	uint32_t end;
+};
+
+struct SnappedVertex
+{
+	int32_t x; // 1/256 pixel units.
+	int32_t y;
+	double z;
+};
+
+template <typename T>
+float PlaneDistance(const float (&plane)[4], const T& v)
+{
+	return plane[0] * v.x + plane[1] * v.y + plane[2] * v.z + plane[3] * v.w;
+}
+
+// Ranges of vertices or, for triangles, of triangles or meshlets (about as many triangles per task).
+std::vector<DrawRange> SplitDraws(const std::span<const DepthDrawCall> drawCalls, const uint32_t itemsPerTask, const bool triangles)
+{
+	std::vector<DrawRange> ranges;
+
+	for (uint32_t drawIndex = 0; drawIndex < drawCalls.size(); ++drawIndex)
+	{
+		const DepthDrawCall& drawCall = drawCalls[drawIndex];
+		const bool meshlets = triangles && !drawCall.meshlets.empty();
+		const uint32_t count = meshlets ? static_cast<uint32_t>(drawCall.meshlets.size()) : triangles ? drawCall.indexCount / 3 : drawCall.vertexCount;
+		const uint32_t countPerTask = meshlets ? std::max<uint32_t>(itemsPerTask / Meshlet::kMaxTriangles, 1) : itemsPerTask;
+
+		for (uint32_t begin = 0; begin < count; begin += countPerTask)
+		{
+			ranges.push_back({drawIndex, begin, std::min(begin + countPerTask, count)});
+		}
+	}
+
+	return ranges;
+}
+} // namespace
+
+MeshletCuller::MeshletCuller(const Float4x4& viewProj)
+{
+	// Clip coordinates are dot(column, float4(p, 1)), and the frustum is -w <= x <= w, -w <= y <= w and 0 <= z <= w (reversed Z).
+	const auto column = [&](const uint32_t j) { return std::array<float, 4>{viewProj.m[0][j], viewProj.m[1][j], viewProj.m[2][j], viewProj.m[3][j]}; };
+	const std::array<float, 4> x = column(0);
+	const std::array<float, 4> y = column(1);
+	const std::array<float, 4> z = column(2);
+	const std::array<float, 4> w = column(3);
+
+	for (uint32_t k = 0; k < 4; ++k)
+	{
+		m_planes[0][k] = w[k] + x[k];
+		m_planes[1][k] = w[k] - x[k];
+		m_planes[2][k] = w[k] + y[k];
+		m_planes[3][k] = w[k] - y[k];
+		m_planes[4][k] = z[k];
+		m_planes[5][k] = w[k] - z[k];
+	}
+
+	for (float(&plane)[4] : m_planes)
+	{
+		const float length = std::sqrt(plane[0] * plane[0] + plane[1] * plane[1] + plane[2] * plane[2]);
+		const float scale = (length > 0.0f) ? 1.0f / length : 0.0f;
+
+		for (float& value : plane)
+		{
+			value *= scale;
+		}
+	}
+
+	// The eye is the point that projects to x = y = w = 0. Orthographic projections have none (the system is singular).
+	const Float3 a = {x[0], x[1], x[2]};
+	const Float3 b = {y[0], y[1], y[2]};
+	const Float3 c = {w[0], w[1], w[2]};
+	const Float3 bc = Cross(b, c);
+	const float det = Dot(a, bc);
+
+	if (std::abs(det) > 1.0e-6f * Length(a) * Length(b) * Length(c))
+	{
+		const Float3 eye = (bc * -x[3] + Cross(c, a) * -y[3] + Cross(a, b) * -w[3]) * (1.0f / det);
+		m_eye[0] = eye.x;
+		m_eye[1] = eye.y;
+		m_eye[2] = eye.z;
+		m_hasEye = true;
+	}
+}
+
+bool MeshletCuller::IsOutsideFrustum(const Meshlet& meshlet) const
+{
+	for (const float(&plane)[4] : m_planes)
+	{
+		if (plane[0] * meshlet.center[0] + plane[1] * meshlet.center[1] + plane[2] * meshlet.center[2] + plane[3] < -meshlet.radius)
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+bool MeshletCuller::IsBackfacing(const Meshlet& meshlet) const
+{
+	return m_hasEye && IsMeshletBackfacing(meshlet, m_eye);
+}
+
+void DepthRasterizer::Render(TaskPool& taskPool, const Float4x4& viewProj, const std::span<const DepthDrawCall> drawCalls, const DepthBias& bias, Image& depth)
+{
+	m_width = depth.GetWidth();
+	m_height = depth.GetHeight();
+	m_binCountX = (m_width + BIN_SIZE - 1) / BIN_SIZE;
+	m_binCountY = (m_height + BIN_SIZE - 1) / BIN_SIZE;
+	m_blockCountX = (m_width + BLOCK_SIZE - 1) / BLOCK_SIZE;
+	const uint32_t binCount = m_binCountX * m_binCountY;
+	depth.Clear(0.0f);
+	m_blockMinDepth.assign(size_t{m_blockCountX} * ((m_height + BLOCK_SIZE - 1) / BLOCK_SIZE), 0.0f);
+	m_workerBins.resize(taskPool.GetWorkerCount());
+
+	for (Bins& bins : m_workerBins)
+	{
+		bins.triangles.clear();
+		bins.triangleIndices.resize(binCount);
+
+		for (std::vector<uint32_t>& triangleIndices : bins.triangleIndices)
+		{
+			triangleIndices.clear();
+		}
+	}
+
+	// Vertex shading: transform every vertex once into clip space.
+	std::vector<uint32_t> baseVertices(drawCalls.size());
+	uint32_t vertexCount = 0;
+
+	for (uint32_t drawIndex = 0; drawIndex < drawCalls.size(); ++drawIndex)
+	{
+		baseVertices[drawIndex] = vertexCount;
+		vertexCount += drawCalls[drawIndex].vertexCount;
+	}
+
+	m_clipVertices.resize(vertexCount);
+	const std::vector<DrawRange> vertexRanges = SplitDraws(drawCalls, VERTICES_PER_TASK, false);
+	taskPool.ParallelFor(static_cast<uint32_t>(vertexRanges.size()), [&](const uint32_t taskIndex, uint32_t) {
+		const DrawRange& range = vertexRanges[taskIndex];
+		const DepthDrawCall& drawCall = drawCalls[range.drawIndex];
+		const Float4x4& m = viewProj;
+
+		for (uint32_t i = range.begin; i < range.end; ++i)
+		{
+			Float3 p;
+			std::memcpy(&p, drawCall.vertices + size_t{i} * drawCall.vertexStride, sizeof(p));
+			ClipVertex& v = m_clipVertices[baseVertices[range.drawIndex] + i];
+			v.x = p.x * m.m[0][0] + p.y * m.m[1][0] + p.z * m.m[2][0] + m.m[3][0];
+			v.y = p.x * m.m[0][1] + p.y * m.m[1][1] + p.z * m.m[2][1] + m.m[3][1];
+			v.z = p.x * m.m[0][2] + p.y * m.m[1][2] + p.z * m.m[2][2] + m.m[3][2];
+			v.w = p.x * m.m[0][3] + p.y * m.m[1][3] + p.z * m.m[2][3] + m.m[3][3];
+		}
+	});
+
+	// Triangle setup and binning into the bins of the current worker.
+	// Meshlets are culled as a whole first.
+	const MeshletCuller meshletCuller{viewProj};
+	const std::vector<DrawRange> triangleRanges = SplitDraws(drawCalls, TRIANGLES_PER_TASK, true);
+	taskPool.ParallelFor(static_cast<uint32_t>(triangleRanges.size()), [&](const uint32_t taskIndex, const uint32_t workerIndex) {
+		const DrawRange& range = triangleRanges[taskIndex];
+		const DepthDrawCall& drawCall = drawCalls[range.drawIndex];
+		const ClipVertex* vertices = m_clipVertices.data() + baseVertices[range.drawIndex];
+
+		const auto setupTriangles = [&](const uint32_t begin, const uint32_t end) {
+			for (uint32_t i = begin; i < end; ++i)
+			{
+				const uint16_t* indices = drawCall.indices + size_t{i} * 3;
+				const ClipVertex triangle[3] = {vertices[indices[0]], vertices[indices[1]], vertices[indices[2]]};
+				SetupTriangle(triangle, drawCall.cullMode, bias, m_workerBins[workerIndex]);
+			}
+		};
+
+		if (drawCall.meshlets.empty())
+		{
+			setupTriangles(range.begin, range.end);
+			return;
+		}
+
+		for (uint32_t i = range.begin; i < range.end; ++i)
+		{
+			const Meshlet& meshlet = drawCall.meshlets[i];
+
+			if (!meshletCuller.IsOutsideFrustum(meshlet) && !(drawCall.cullMode == CULL_MODE_BACK && meshletCuller.IsBackfacing(meshlet)))
+			{
+				setupTriangles(meshlet.startTriangle, meshlet.startTriangle + meshlet.triangleCount);
+			}
+		}
+	});
+
+	// Rasterization. Each bin is owned by a single task, so the depth test needs no synchronization. The result does not depend on the order of triangles
+	// since GREATER_EQUAL keeps the maximum depth.
+	taskPool.ParallelFor(binCount, [&](const uint32_t binIndex, uint32_t) {
+		const int32_t binX = static_cast<int32_t>(binIndex % m_binCountX);
+		const int32_t binY = static_cast<int32_t>(binIndex / m_binCountX);
+
+		for (const Bins& bins : m_workerBins)
+		{
+			for (const uint32_t triangleIndex : bins.triangleIndices[binIndex])
+			{
+				RasterizeTriangle(bins.triangles[triangleIndex], binX, binY, depth);
+			}
+		}
+	});
+}
+
+uint32_t DepthRasterizer::GetTriangleCount() const
+{
+	size_t count = 0;
+
+	for (const Bins& bins : m_workerBins)
+	{
+		count += bins.triangles.size();
+	}
+
+	return static_cast<uint32_t>(count);
+}
+
+void DepthRasterizer::SetupTriangle(const ClipVertex (&vertices)[3], const CULL_MODE cullMode, const DepthBias& bias, Bins& bins) const
+{
+	// Trivial rejection against the view frustum.
+	const auto outside = [&](const auto& predicate) { return predicate(vertices[0]) && predicate(vertices[1]) && predicate(vertices[2]); };
+
+	if (outside([](const ClipVertex& v) { return v.x > v.w; }) || outside([](const ClipVertex& v) { return v.x < -v.w; }) || outside([](const ClipVertex& v) { return v.y > v.w; }) || outside([](const ClipVertex& v) { return v.y < -v.w; }) || outside([](const ClipVertex& v) { return v.z > v.w; }) || outside([](const ClipVertex& v) { return v.z < 0.0f; }))
+	{
+		return;
+	}
+
+	// Sutherland-Hodgman clipping against the planes that any vertex is behind.
+	ClipVertex polygon[MAX_CLIPPED_VERTEX_COUNT] = {vertices[0], vertices[1], vertices[2]};
+	uint32_t vertexCount = 3;
+
+	for (const auto& plane : CLIP_PLANES)
+	{
+		if (std::all_of(polygon, polygon + vertexCount, [&](const ClipVertex& v) { return PlaneDistance(plane, v) >= 0.0f; }))
+		{
+			continue;
+		}
+
+		ClipVertex clipped[MAX_CLIPPED_VERTEX_COUNT];
+		uint32_t clippedCount = 0;
+
+		for (uint32_t i = 0; i < vertexCount; ++i)
+		{
+			const ClipVertex& a = polygon[i];
+			const ClipVertex& b = polygon[(i + 1) % vertexCount];
+			const float da = PlaneDistance(plane, a);
+			const float db = PlaneDistance(plane, b);
+
+			if (da >= 0.0f)
+			{
+				clipped[clippedCount++] = a;
+			}
+
+			if ((da >= 0.0f) != (db >= 0.0f))
+			{
+				const float t = da / (da - db);
+				clipped[clippedCount++] = {a.x + (b.x - a.x) * t, a.y + (b.y - a.y) * t, a.z + (b.z - a.z) * t, a.w + (b.w - a.w) * t};
+			}
+		}
+
+		if (clippedCount < 3)
+		{
+			return;
+		}
+
+		std::copy_n(clipped, clippedCount, polygon);
+		vertexCount = clippedCount;
+	}
+
+	// Viewport transform and snapping.
+	SnappedVertex snapped[MAX_CLIPPED_VERTEX_COUNT];
+
+	for (uint32_t i = 0; i < vertexCount; ++i)
+	{
+		const double invW = 1.0 / polygon[i].w;
+		const double x = (polygon[i].x * invW * 0.5 + 0.5) * m_width;
+		const double y = (0.5 - polygon[i].y * invW * 0.5) * m_height;
+		snapped[i] = {static_cast<int32_t>(std::nearbyint(x * SUBPIXEL_SCALE)), static_cast<int32_t>(std::nearbyint(y * SUBPIXEL_SCALE)), polygon[i].z * invW};
+	}
+
+	for (uint32_t i = 1; i + 1 < vertexCount; ++i)
+	{
+		SnappedVertex v0 = snapped[0];
+		SnappedVertex v1 = snapped[i];
+		SnappedVertex v2 = snapped[i + 1];
+		int64_t area = int64_t{v1.x - v0.x} * (v2.y - v0.y) - int64_t{v2.x - v0.x} * (v1.y - v0.y);
+
+		// A positive area is clockwise on screen with Y down, which is a back face for FrontCounterClockwise = TRUE.
+		if (area == 0 || (area > 0 && cullMode == CULL_MODE_BACK))
+		{
+			continue;
+		}
+
+		if (area < 0)
+		{
+			std::swap(v1, v2);
+			area = -area;
+		}
+
+		Triangle triangle;
+		const int32_t minX = std::min({v0.x, v1.x, v2.x});
+		const int32_t minY = std::min({v0.y, v1.y, v2.y});
+		const int32_t maxX = std::max({v0.x, v1.x, v2.x});
+		const int32_t maxY = std::max({v0.y, v1.y, v2.y});
+		triangle.minX = std::max(static_cast<int32_t>(std::ceil((minX - HALF_PIXEL) / double{SUBPIXEL_SCALE})), 0);
+		triangle.minY = std::max(static_cast<int32_t>(std::ceil((minY - HALF_PIXEL) / double{SUBPIXEL_SCALE})), 0);
+		triangle.maxX = std::min(static_cast<int32_t>(std::floor((maxX - HALF_PIXEL) / double{SUBPIXEL_SCALE})), static_cast<int32_t>(m_width) - 1);
+		triangle.maxY = std::min(static_cast<int32_t>(std::floor((maxY - HALF_PIXEL) / double{SUBPIXEL_SCALE})), static_cast<int32_t>(m_height) - 1);
+
+		if (triangle.minX > triangle.maxX || triangle.minY > triangle.maxY)
+		{
+			continue;
+		}
+
+		const SnappedVertex* edgeVertices[] = {&v0, &v1, &v2, &v0};
+
+		for (uint32_t k = 0; k < 3; ++k)
+		{
+			const SnappedVertex& a = *edgeVertices[k];
+			const SnappedVertex& b = *edgeVertices[k + 1];
+			triangle.a[k] = a.y - b.y;
+			triangle.b[k] = b.x - a.x;
+			triangle.c[k] = -int64_t{triangle.a[k]} * a.x - int64_t{triangle.b[k]} * a.y;
+
+			// Top-left rule: pixel centers exactly on an edge are covered only for top and left edges. (a, b) points inside.
+			const bool topLeft = triangle.a[k] > 0 || (triangle.a[k] == 0 && triangle.b[k] > 0);
+			triangle.c[k] -= topLeft ? 0 : 1;
+		}
+
+		// Depth plane from the snapped positions in pixel units.
+		const double x0 = v0.x / double{SUBPIXEL_SCALE};
+		const double y0 = v0.y / double{SUBPIXEL_SCALE};
+		const double dx1 = (v1.x - v0.x) / double{SUBPIXEL_SCALE};
+		const double dy1 = (v1.y - v0.y) / double{SUBPIXEL_SCALE};
+		const double dx2 = (v2.x - v0.x) / double{SUBPIXEL_SCALE};
+		const double dy2 = (v2.y - v0.y) / double{SUBPIXEL_SCALE};
+		const double dz1 = v1.z - v0.z;
+		const double dz2 = v2.z - v0.z;
+		const double invArea = double{SUBPIXEL_SCALE} * SUBPIXEL_SCALE / static_cast<double>(area);
+		const double dzdx = (dz1 * dy2 - dz2 * dy1) * invArea;
+		const double dzdy = (dx1 * dz2 - dx2 * dz1) * invArea;
+
+		// Depth bias for floating-point depth: DepthBias * 2^(exponent(max z) - 23) + SlopeScaledDepthBias * MaxDepthSlope.
+		const double maxZ = std::max({v0.z, v1.z, v2.z});
+		int exponent = 0;
+		std::frexp(maxZ, &exponent);
+		const double depthBias = (maxZ > 0.0 ? bias.depthBias * std::ldexp(1.0, exponent - 1 - 23) : 0.0) + bias.slopeScaledDepthBias * std::max(std::abs(dzdx), std::abs(dzdy));
+
+		triangle.z = static_cast<float>(v0.z + dzdx * (triangle.minX + 0.5 - x0) + dzdy * (triangle.minY + 0.5 - y0) + depthBias);
+		triangle.dzdx = static_cast<float>(dzdx);
+		triangle.dzdy = static_cast<float>(dzdy);
+		triangle.maxZ = static_cast<float>(maxZ + depthBias);
+		triangle.bias = static_cast<float>(depthBias);
+
+		const uint32_t triangleIndex = static_cast<uint32_t>(bins.triangles.size());
+		bins.triangles.push_back(triangle);
+
+		for (uint32_t binY = triangle.minY / BIN_SIZE; binY <= triangle.maxY / BIN_SIZE; ++binY)
+		{
+			for (uint32_t binX = triangle.minX / BIN_SIZE; binX <= triangle.maxX / BIN_SIZE; ++binX)
+			{
+				bins.triangleIndices[binY * m_binCountX + binX].push_back(triangleIndex);
+			}
+		}
+	}
+}
+
+void DepthRasterizer::RasterizeTriangle(const Triangle& triangle, const int32_t binX, const int32_t binY, Image& depth)
+{
+	constexpr int32_t BLOCK = static_cast<int32_t>(BLOCK_SIZE);
+	constexpr int32_t BLOCK_EXTENT = (BLOCK - 1) * SUBPIXEL_SCALE;
+	const int32_t minX = std::max(triangle.minX, binX * static_cast<int32_t>(BIN_SIZE)) & ~(BLOCK - 1);
+	const int32_t minY = std::max(triangle.minY, binY * static_cast<int32_t>(BIN_SIZE)) & ~(BLOCK - 1);
+	const int32_t maxX = std::min(triangle.maxX, (binX + 1) * static_cast<int32_t>(BIN_SIZE) - 1);
+	const int32_t maxY = std::min(triangle.maxY, (binY + 1) * static_cast<int32_t>(BIN_SIZE) - 1);
+	const Float8 laneOffsets = Float8::Load(LANE_OFFSETS);
+
+	for (int32_t blockY = minY; blockY <= maxY; blockY += BLOCK)
+	{
+		const int32_t rowCount = std::min(BLOCK, static_cast<int32_t>(m_height) - blockY);
+
+		for (int32_t blockX = minX; blockX <= maxX; blockX += BLOCK)
+		{
+			// Edge functions at the block corners. The block is skipped if it is outside any edge. Edges that cross it are evaluated per row.
+			const int64_t cornerX = int64_t{blockX} * SUBPIXEL_SCALE + HALF_PIXEL;
+			const int64_t cornerY = int64_t{blockY} * SUBPIXEL_SCALE + HALF_PIXEL;
+			uint32_t crossingEdges = 0;
+			bool outside = false;
+
+			for (uint32_t k = 0; k < 3; ++k)
+			{
+				const int64_t e = triangle.a[k] * cornerX + triangle.b[k] * cornerY + triangle.c[k];
+				const int64_t stepX = int64_t{triangle.a[k]} * BLOCK_EXTENT;
+				const int64_t stepY = int64_t{triangle.b[k]} * BLOCK_EXTENT;
+				outside |= e + std::max<int64_t>(stepX, 0) + std::max<int64_t>(stepY, 0) < 0;
+				crossingEdges |= (e + std::min<int64_t>(stepX, 0) + std::min<int64_t>(stepY, 0) < 0) ? 1u << k : 0u;
+			}
+
+			if (outside)
+			{
+				continue;
+			}
+
+			// Early depth rejection: the triangle is behind every pixel of the block.
+			float& blockMinDepth = m_blockMinDepth[size_t{static_cast<uint32_t>(blockY) / BLOCK_SIZE} * m_blockCountX + static_cast<uint32_t>(blockX) / BLOCK_SIZE];
+			const float blockZ = triangle.z + triangle.dzdx * static_cast<float>(blockX - triangle.minX) + triangle.dzdy * static_cast<float>(blockY - triangle.minY);
+			const float blockMaxZ = blockZ + std::max(triangle.dzdx, 0.0f) * (BLOCK - 1) + std::max(triangle.dzdy, 0.0f) * (BLOCK - 1);
+
+			if (std::min(blockMaxZ, triangle.maxZ) < blockMinDepth)
+			{
+				continue;
+			}
+
+			const Float8 x = laneOffsets + static_cast<float>(blockX);
+			const Mask8 insideViewport = x < Float8(static_cast<float>(m_width));
+
+			// Crossing edges whose steps along the row are exact in float are tested as a * 256 * lane >= -E(row start) in SIMD. The test is exact
+			// because float rounding is monotonic and the left side is an integer below 2^24. Longer edges fall back to exact per-row spans.
+			constexpr int64_t MAX_EXACT_STEP = (int64_t{1} << 24) / (BLOCK - 1);
+			uint32_t spanEdges = 0;
+			Float8 edgeSteps[3];
+			int64_t edgeRows[3];
+
+			for (uint32_t k = 0; k < 3; ++k)
+			{
+				if ((crossingEdges & (1u << k)) == 0)
+				{
+					continue;
+				}
+
+				const int64_t step = int64_t{triangle.a[k]} * SUBPIXEL_SCALE;
+				spanEdges |= (std::abs(step) < MAX_EXACT_STEP) ? 0u : 1u << k;
+				edgeSteps[k] = laneOffsets * Float8(static_cast<float>(step));
+				edgeRows[k] = triangle.a[k] * cornerX + triangle.b[k] * cornerY + triangle.c[k];
+			}
+
+			bool written = false;
+
+			for (int32_t row = 0; row < rowCount; ++row)
+			{
+				const int32_t y = blockY + row;
+				Mask8 mask = insideViewport;
+
+				for (uint32_t k = 0; k < 3; ++k)
+				{
+					if ((crossingEdges & ~spanEdges & (1u << k)) != 0)
+					{
+						mask = mask & (edgeSteps[k] >= Float8(static_cast<float>(-(edgeRows[k] + int64_t{triangle.b[k]} * SUBPIXEL_SCALE * row))));
+					}
+				}
+
+				if (spanEdges != 0)
+				{
+					// Covered span of the row. The bounds are exact since the numerators are integers below 2^53.
+					const int64_t sampleY = int64_t{y} * SUBPIXEL_SCALE + HALF_PIXEL;
+					double spanMin = blockX;
+					double spanMax = blockX + BLOCK - 1;
+
+					for (uint32_t k = 0; k < 3; ++k)
+					{
+						if ((spanEdges & (1u << k)) == 0)
+						{
+							continue;
+						}
+
+						const int64_t a = triangle.a[k];
+						const int64_t r = triangle.b[k] * sampleY + triangle.c[k];
+						const double bound = static_cast<double>(-r - a * HALF_PIXEL) / static_cast<double>(a * SUBPIXEL_SCALE);
+						spanMin = (a > 0) ? std::max(spanMin, std::ceil(bound)) : spanMin;
+						spanMax = (a < 0) ? std::min(spanMax, std::floor(bound)) : spanMax;
+					}
+
+					if (spanMin > spanMax)
+					{
+						continue;
+					}
+
+					mask = mask & (x >= Float8(static_cast<float>(spanMin))) & (x <= Float8(static_cast<float>(spanMax)));
+				}
+
+				if (!Any(mask))
+				{
+					continue;
+				}
+
+				// Depth clipping uses the unbiased depth, and the biased depth is clamped to the viewport depth range.
+				const Float8 z = MulAdd(laneOffsets, Float8(triangle.dzdx), Float8(blockZ + triangle.dzdy * static_cast<float>(row)));
+				const Float8 unbiasedZ = z - triangle.bias;
+				mask = mask & (unbiasedZ >= Float8(0.0f)) & (unbiasedZ <= Float8(1.0f));
+				const Float8 outputZ = Clamp(z, Float8(0.0f), Float8(1.0f));
+				float* p = depth.GetRow(static_cast<uint32_t>(y)) + blockX;
+				const Float8 stored = Float8::Load(p);
+				const Mask8 pass = mask & (outputZ >= stored);
+
+				if (Any(pass))
+				{
+					Select(pass, outputZ, stored).Store(p);
+					written = true;
+				}
+			}
+
+			if (written)
+			{
+				Float8 minDepth = Float8::Load(depth.GetRow(static_cast<uint32_t>(blockY)) + blockX);
+
+				for (int32_t row = 1; row < rowCount; ++row)
+				{
+					minDepth = Min(minDepth, Float8::Load(depth.GetRow(static_cast<uint32_t>(blockY + row)) + blockX));
+				}
+
+				blockMinDepth = ReduceMin(minDepth);
+			}
+		}
+	}
+}
+} // namespace vsgl::cpu
@@ -0,0 +1,115 @@
+#pragma once
+
+#include "Image.hpp"
+#include "ShadingMath.hpp"
+
+#include "../../MiniEngine/Model/Meshlet.h"
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace vsgl::cpu
+{
+class TaskPool;
+
+enum CULL_MODE : uint8_t
+{
+	CULL_MODE_NONE,
+	CULL_MODE_BACK,
+};
+
+// Indexed triangle list of a depth-only draw. Only the leading float3 position of each vertex is read.
+// When meshlets (BuildMeshlets() of the indices) are given, they replace the triangle list: those outside the frustum or, with CULL_MODE_BACK, facing away
+// from the viewer are skipped before triangle setup.
+struct DepthDrawCall
+{
+	const uint8_t* vertices;
+	uint32_t vertexStride;
+	uint32_t vertexCount;
+	const uint16_t* indices;
+	uint32_t indexCount;
+	CULL_MODE cullMode;
+	std::span<const Meshlet> meshlets = {};
+};
+
+// Conservative rejection of meshlets whose bounds are in the space that viewProj transforms.
+class MeshletCuller
+{
+  public:
+	explicit MeshletCuller(const Float4x4& viewProj);
+
+	// The bounding sphere is outside one of the planes of the frustum.
+	bool IsOutsideFrustum(const Meshlet& meshlet) const;
+
+	// Every triangle faces away from the eye of the perspective projection. Always false for other projections.
+	bool IsBackfacing(const Meshlet& meshlet) const;
+
+  private:
+	float m_planes[6][4]; // Normalized so that dot(plane, float4(p, 1)) is a distance.
+	float m_eye[3];
+	bool m_hasEye = false;
+};
+
+// Depth bias of D3D12_RASTERIZER_DESC for a D32_FLOAT target without DepthBiasClamp. The defaults are those of Graphics::RasterizerShadow.
+struct DepthBias
+{
+	float depthBias = -100.0f;
+	float slopeScaledDepthBias = -1.5f;
+};
+
+// Depth-only rasterizer for shadow maps. No attributes are interpolated except Z.
+// It follows the D3D12 rules that affect depth: 8-bit subpixel snapping, the top-left fill rule at pixel centers, counterclockwise front faces
+// (Graphics::RasterizerDefault), near-plane and depth clipping, depth bias and D3D12_COMPARISON_FUNC_GREATER_EQUAL for reversed Z.
+// Triangles are set up and binned into BIN_SIZE^2 pixel bins in parallel, and then the bins are rasterized in parallel. Within a bin, each triangle is walked in
+// BLOCK_SIZE^2 pixel blocks that are rejected early by the edge functions at their corners and by the minimum depth of the block (a one-level hierarchical Z).
+class DepthRasterizer
+{
+  public:
+	static constexpr uint32_t BLOCK_SIZE = 8;
+	static constexpr uint32_t BIN_SIZE = 64;
+
+	// Clears depth to 0 (the far plane of reversed Z) and renders the draws.
+	void Render(TaskPool& taskPool, const Float4x4& viewProj, std::span<const DepthDrawCall> drawCalls, const DepthBias& bias, Image& depth);
+
+	// Number of triangles that were binned by the last Render() after culling and clipping.
+	uint32_t GetTriangleCount() const;
+
+  private:
+	struct Triangle
+	{
+		int32_t minX, minY, maxX, maxY; // Inclusive pixel bounds clipped to the viewport.
+		int32_t a[3];                   // Edge functions E = a X + b Y + c in 1/256 pixel units, positive inside.
+		int32_t b[3];
+		int64_t c[3]; // Including the fill-rule bias.
+		float z;      // Biased depth at the center of pixel (minX, minY).
+		float dzdx;
+		float dzdy;
+		float maxZ; // Biased maximum depth of the vertices.
+		float bias;
+	};
+
+	struct Bins
+	{
+		std::vector<Triangle> triangles;
+		std::vector<std::vector<uint32_t>> triangleIndices; // Per bin.
+	};
+
+	struct ClipVertex
+	{
+		float x, y, z, w;
+	};
+
+	void SetupTriangle(const ClipVertex (&vertices)[3], CULL_MODE cullMode, const DepthBias& bias, Bins& bins) const;
+	void RasterizeTriangle(const Triangle& triangle, int32_t binX, int32_t binY, Image& depth);
+
+	uint32_t m_width = 0;
+	uint32_t m_height = 0;
+	uint32_t m_binCountX = 0;
+	uint32_t m_binCountY = 0;
+	uint32_t m_blockCountX = 0;
+	std::vector<ClipVertex> m_clipVertices;
+	std::vector<Bins> m_workerBins;    // Per worker of the task pool so that the binning needs no synchronization.
+	std::vector<float> m_blockMinDepth; // Minimum depth of each block for the early depth rejection.
+};
+} // namespace vsgl::cpu
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstdint>
+#include <vector>
+
+namespace vsgl::cpu
+{
+// Single-channel float image.
+// Rows are padded to a multiple of 8 pixels and the row count to a multiple of 2 so that 4x2 pixel blocks can always be loaded without bounds checks.
+class Image
+{
+  public:
+	static constexpr uint32_t PITCH_ALIGNMENT = 8;
+	static constexpr uint32_t ROW_ALIGNMENT = 2;
+
+	void Resize(const uint32_t width, const uint32_t height, const float clearValue = 0.0f)
+	{
+		m_width = width;
+		m_height = height;
+		m_pitch = (width + PITCH_ALIGNMENT - 1) / PITCH_ALIGNMENT * PITCH_ALIGNMENT;
+		m_data.assign(size_t{m_pitch} * ((height + ROW_ALIGNMENT - 1) / ROW_ALIGNMENT * ROW_ALIGNMENT), clearValue);
+	}
+
+	void Clear(const float value) { std::fill(m_data.begin(), m_data.end(), value); }
+
+	uint32_t GetWidth() const { return m_width; }
+	uint32_t GetHeight() const { return m_height; }
+	uint32_t GetPitch() const { return m_pitch; }
+	float* GetData() { return m_data.data(); }
+	const float* GetData() const { return m_data.data(); }
+	float* GetRow(const uint32_t y) { return m_data.data() + size_t{y} * m_pitch; }
+	const float* GetRow(const uint32_t y) const { return m_data.data() + size_t{y} * m_pitch; }
+
+	float& operator()(const uint32_t x, const uint32_t y)
+	{
+		assert(x < m_pitch);
+		return m_data[size_t{y} * m_pitch + x];
+	}
+
+	float operator()(const uint32_t x, const uint32_t y) const
+	{
+		assert(x < m_pitch);
+		return m_data[size_t{y} * m_pitch + x];
+	}
+
+  private:
+	uint32_t m_width = 0;
+	uint32_t m_height = 0;
+	uint32_t m_pitch = 0;
+	std::vector<float> m_data;
+};
+
+// RGB radiance stored as three planes.
+struct ColorImage
+{
+	std::array<Image, 3> channels;
+
+	void Resize(const uint32_t width, const uint32_t height)
+	{
+		for (Image& channel : channels)
+		{
+			channel.Resize(width, height);
+		}
+	}
+
+	uint32_t GetWidth() const { return channels[0].GetWidth(); }
+	uint32_t GetHeight() const { return channels[0].GetHeight(); }
+};
+
+enum GBUFFER_PLANE : uint8_t
+{
+	GBUFFER_DEPTH, // Hardware depth. Pixels with the clear depth (0 for reversed Z) are not shaded.
+	GBUFFER_POSITION_X,
+	GBUFFER_POSITION_Y,
+	GBUFFER_POSITION_Z,
+	GBUFFER_NORMAL_X, // Interpolated vertex normal, already flipped for back faces of two-sided (cutout) materials.
+	GBUFFER_NORMAL_Y,
+	GBUFFER_NORMAL_Z,
+	GBUFFER_TANGENT_X,
+	GBUFFER_TANGENT_Y,
+	GBUFFER_TANGENT_Z,
+	GBUFFER_BITANGENT_SIGN,
+	GBUFFER_NORMAL_MAP_X, // Two-channel normal map texel.
+	GBUFFER_NORMAL_MAP_Y,
+	GBUFFER_DIFFUSE_R,
+	GBUFFER_DIFFUSE_G,
+	GBUFFER_DIFFUSE_B,
+	GBUFFER_SPECULAR_R,
+	GBUFFER_SPECULAR_G,
+	GBUFFER_SPECULAR_B,
+	GBUFFER_ROUGHNESS, // Perceptual roughness in the alpha channel of the specular map.
+	GBUFFER_PLANE_COUNT,
+};
+
+// Structure-of-arrays G-buffer holding the interpolated LightingPS inputs and the sampled material textures.
+class GBuffer
+{
+  public:
+	static constexpr float CLEAR_DEPTH = 0.0f;
+
+	void Resize(const uint32_t width, const uint32_t height)
+	{
+		for (Image& plane : m_planes)
+		{
+			plane.Resize(width, height);
+		}
+	}
+
+	uint32_t GetWidth() const { return m_planes[0].GetWidth(); }
+	uint32_t GetHeight() const { return m_planes[0].GetHeight(); }
+	uint32_t GetPitch() const { return m_planes[0].GetPitch(); }
+	Image& GetPlane(const GBUFFER_PLANE plane) { return m_planes[plane]; }
+	const Image& GetPlane(const GBUFFER_PLANE plane) const { return m_planes[plane]; }
+
+  private:
+	std::array<Image, GBUFFER_PLANE_COUNT> m_planes;
+};
+} // namespace vsgl::cpu
@@ -0,0 +1,23 @@
+#pragma once
+
+// CPU mirror of Shaders/SGLight.hlsli. The layout matches the GPU structured buffer (12 dwords per light).
+
+#include <cstdint>
+
+namespace vsgl::cpu
+{
+static constexpr float SGLIGHT_SHARPNESS_MAX = 0x1.0p41f; // Clamping threshold to avoid overflow.
+static constexpr uint32_t SG_LIGHT_COUNT = 2;
+
+struct SGLight
+{
+	float position[3];
+	float variance;
+	float intensity[3];
+	float sharpness;
+	float axis[3];
+	uint32_t pad;
+};
+
+static_assert(sizeof(SGLight) == sizeof(uint32_t) * 12);
+} // namespace vsgl::cpu
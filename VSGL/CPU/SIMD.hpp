@@ -0,0 +1,416 @@
+#pragma once
+
+// 8-wide SIMD types for the CPU shading path.
+// With AVX2 (/arch:AVX2 or -mavx2), Float8 maps onto a single __m256 register.
+// Otherwise, it falls back to a plain array that compilers can still auto-vectorize.
+
+#if defined(__AVX2__)
+#define VSGL_SIMD_AVX2 1
+#else
+#define VSGL_SIMD_AVX2 0
+#endif
+
+#if VSGL_SIMD_AVX2
+#include <immintrin.h>
+#endif
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+
+namespace vsgl::cpu
+{
+static constexpr uint32_t SIMD_WIDTH = 8;
+
+#if VSGL_SIMD_AVX2
+class Mask8
+{
+  public:
+	Mask8() = default;
+	explicit Mask8(const __m256 v) : m_v(v) {}
+	Mask8(const bool b) : m_v(_mm256_castsi256_ps(_mm256_set1_epi32(b ? -1 : 0))) {}
+
+	__m256 Get() const { return m_v; }
+	uint32_t Bits() const { return static_cast<uint32_t>(_mm256_movemask_ps(m_v)); }
+
+	friend Mask8 operator&(const Mask8 a, const Mask8 b) { return Mask8{_mm256_and_ps(a.m_v, b.m_v)}; }
+	friend Mask8 operator|(const Mask8 a, const Mask8 b) { return Mask8{_mm256_or_ps(a.m_v, b.m_v)}; }
+	friend Mask8 operator!(const Mask8 a) { return Mask8{_mm256_xor_ps(a.m_v, _mm256_castsi256_ps(_mm256_set1_epi32(-1)))}; }
+
+  private:
+	__m256 m_v;
+};
+
+class Float8
+{
+  public:
+	Float8() = default;
+	explicit Float8(const __m256 v) : m_v(v) {}
+	Float8(const float s) : m_v(_mm256_set1_ps(s)) {} // Implicit broadcast so that templated shading code can mix scalars.
+
+	static Float8 Load(const float* p) { return Float8{_mm256_loadu_ps(p)}; }
+	// Loads 4 floats from each of two rows into lanes [0, 4) and [4, 8).
+	static Float8 Load2x4(const float* row0, const float* row1) { return Float8{_mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(row0)), _mm_loadu_ps(row1), 1)}; }
+	static Float8 Gather(const float* base, const uint32_t (&indices)[SIMD_WIDTH]) { return Float8{_mm256_i32gather_ps(base, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(indices)), 4)}; }
+	// Gather with integral indices held in floats (exact below 2^24).
+	static Float8 Gather(const float* base, const Float8 indices) { return Float8{_mm256_i32gather_ps(base, _mm256_cvttps_epi32(indices.m_v), 4)}; }
+	void Store(float* p) const { _mm256_storeu_ps(p, m_v); }
+	void Store2x4(float* row0, float* row1) const
+	{
+		_mm_storeu_ps(row0, _mm256_castps256_ps128(m_v));
+		_mm_storeu_ps(row1, _mm256_extractf128_ps(m_v, 1));
+	}
+	// Permutes lanes: result[i] = this[indices[i]].
+	Float8 Permute(const uint32_t (&indices)[SIMD_WIDTH]) const { return Float8{_mm256_permutevar8x32_ps(m_v, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(indices)))}; }
+	float Lane(const uint32_t i) const
+	{
+		alignas(32) float v[SIMD_WIDTH];
+		_mm256_store_ps(v, m_v);
+		return v[i];
+	}
+
+	__m256 Get() const { return m_v; }
+
+	friend Float8 operator+(const Float8 a, const Float8 b) { return Float8{_mm256_add_ps(a.m_v, b.m_v)}; }
+	friend Float8 operator-(const Float8 a, const Float8 b) { return Float8{_mm256_sub_ps(a.m_v, b.m_v)}; }
+	friend Float8 operator*(const Float8 a, const Float8 b) { return Float8{_mm256_mul_ps(a.m_v, b.m_v)}; }
+	friend Float8 operator/(const Float8 a, const Float8 b) { return Float8{_mm256_div_ps(a.m_v, b.m_v)}; }
+	friend Float8 operator-(const Float8 a) { return Float8{_mm256_xor_ps(a.m_v, _mm256_set1_ps(-0.0f))}; }
+	Float8& operator+=(const Float8 a) { return *this = *this + a; }
+	Float8& operator-=(const Float8 a) { return *this = *this - a; }
+	Float8& operator*=(const Float8 a) { return *this = *this * a; }
+
+	friend Mask8 operator<(const Float8 a, const Float8 b) { return Mask8{_mm256_cmp_ps(a.m_v, b.m_v, _CMP_LT_OQ)}; }
+	friend Mask8 operator<=(const Float8 a, const Float8 b) { return Mask8{_mm256_cmp_ps(a.m_v, b.m_v, _CMP_LE_OQ)}; }
+	friend Mask8 operator>(const Float8 a, const Float8 b) { return Mask8{_mm256_cmp_ps(a.m_v, b.m_v, _CMP_GT_OQ)}; }
+	friend Mask8 operator>=(const Float8 a, const Float8 b) { return Mask8{_mm256_cmp_ps(a.m_v, b.m_v, _CMP_GE_OQ)}; }
+	friend Mask8 operator==(const Float8 a, const Float8 b) { return Mask8{_mm256_cmp_ps(a.m_v, b.m_v, _CMP_EQ_OQ)}; }
+	friend Mask8 operator!=(const Float8 a, const Float8 b) { return Mask8{_mm256_cmp_ps(a.m_v, b.m_v, _CMP_NEQ_UQ)}; }
+
+  private:
+	__m256 m_v;
+};
+
+inline Float8 Select(const Mask8 m, const Float8 a, const Float8 b) { return Float8{_mm256_blendv_ps(b.Get(), a.Get(), m.Get())}; }
+inline Float8 Min(const Float8 a, const Float8 b) { return Float8{_mm256_min_ps(a.Get(), b.Get())}; }
+inline Float8 Max(const Float8 a, const Float8 b) { return Float8{_mm256_max_ps(a.Get(), b.Get())}; }
+inline Float8 Abs(const Float8 a) { return Float8{_mm256_andnot_ps(_mm256_set1_ps(-0.0f), a.Get())}; }
+inline Float8 Sqrt(const Float8 a) { return Float8{_mm256_sqrt_ps(a.Get())}; }
+inline Float8 Floor(const Float8 a) { return Float8{_mm256_floor_ps(a.Get())}; }
+inline Float8 MulAdd(const Float8 a, const Float8 b, const Float8 c) { return Float8{_mm256_fmadd_ps(a.Get(), b.Get(), c.Get())}; }
+
+// Returns x with the sign of x*y, i.e., asfloat((asuint(y) & 0x80000000) ^ asuint(x)).
+inline Float8 MulSign(const Float8 x, const Float8 y) { return Float8{_mm256_xor_ps(_mm256_and_ps(y.Get(), _mm256_set1_ps(-0.0f)), x.Get())}; }
+
+inline Mask8 IsFinite(const Float8 a)
+{
+	const __m256i exponent = _mm256_and_si256(_mm256_castps_si256(a.Get()), _mm256_set1_epi32(0x7f800000));
+	return !Mask8{_mm256_castsi256_ps(_mm256_cmpeq_epi32(exponent, _mm256_set1_epi32(0x7f800000)))};
+}
+
+// 2^x for x in the float range. Accurate to about 2 ulp.
+inline Float8 Exp2(const Float8 x)
+{
+	const __m256 clamped = _mm256_min_ps(_mm256_max_ps(x.Get(), _mm256_set1_ps(-127.0f)), _mm256_set1_ps(128.0f));
+	const __m256 n = _mm256_round_ps(clamped, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+	const __m256 f = _mm256_sub_ps(clamped, n); // f in [-0.5, 0.5]
+
+	// Minimax polynomial for 2^f on [-0.5, 0.5].
+	__m256 p = _mm256_set1_ps(1.535336188319500e-4f);
+	p = _mm256_fmadd_ps(p, f, _mm256_set1_ps(1.339887440266574e-3f));
+	p = _mm256_fmadd_ps(p, f, _mm256_set1_ps(9.618437357674640e-3f));
+	p = _mm256_fmadd_ps(p, f, _mm256_set1_ps(5.550332471162809e-2f));
+	p = _mm256_fmadd_ps(p, f, _mm256_set1_ps(2.402264791363012e-1f));
+	p = _mm256_fmadd_ps(p, f, _mm256_set1_ps(6.931472028550421e-1f));
+	p = _mm256_fmadd_ps(p, f, _mm256_set1_ps(1.0f));
+
+	// Scale by 2^n in two steps so that n = -127 (denormal) and n = 128 (overflow to infinity) are handled.
+	const __m256i ni = _mm256_cvtps_epi32(n);
+	const __m256i n1 = _mm256_srai_epi32(ni, 1);
+	const __m256i n2 = _mm256_sub_epi32(ni, n1);
+	const __m256 s1 = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_add_epi32(n1, _mm256_set1_epi32(127)), 23));
+	const __m256 s2 = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_add_epi32(n2, _mm256_set1_epi32(127)), 23));
+	const __m256 result = _mm256_mul_ps(_mm256_mul_ps(p, s1), s2);
+
+	// Propagate NaN.
+	return Float8{_mm256_blendv_ps(result, x.Get(), _mm256_cmp_ps(x.Get(), x.Get(), _CMP_UNORD_Q))};
+}
+
+inline Float8 Exp(const Float8 x) { return Exp2(x * 1.4426950408889634f); }
+
+// Natural logarithm. Returns -inf for 0 and NaN for negative inputs.
+inline Float8 Log(const Float8 x)
+{
+	// Normalize denormals.
+	const __m256 isDenormal = _mm256_cmp_ps(x.Get(), _mm256_set1_ps(std::numeric_limits<float>::min()), _CMP_LT_OQ);
+	const __m256 xn = _mm256_blendv_ps(x.Get(), _mm256_mul_ps(x.Get(), _mm256_set1_ps(0x1.0p23f)), isDenormal);
+	const __m256i bits = _mm256_castps_si256(xn);
+	__m256i exponent = _mm256_sub_epi32(_mm256_srli_epi32(bits, 23), _mm256_set1_epi32(127));
+	exponent = _mm256_sub_epi32(exponent, _mm256_and_si256(_mm256_castps_si256(isDenormal), _mm256_set1_epi32(23)));
+
+	// Mantissa in [sqrt(0.5), sqrt(2)).
+	__m256 m = _mm256_castsi256_ps(_mm256_or_si256(_mm256_and_si256(bits, _mm256_set1_epi32(0x007fffff)), _mm256_set1_epi32(0x3f800000)));
+	const __m256 isLarge = _mm256_cmp_ps(m, _mm256_set1_ps(1.41421356f), _CMP_GT_OQ);
+	m = _mm256_blendv_ps(m, _mm256_mul_ps(m, _mm256_set1_ps(0.5f)), isLarge);
+	exponent = _mm256_sub_epi32(exponent, _mm256_castps_si256(isLarge)); // isLarge is -1 for true lanes.
+	const __m256 e = _mm256_cvtepi32_ps(exponent);
+
+	// log(m) = 2 * atanh(s) with s = (m - 1)/(m + 1).
+	const __m256 s = _mm256_div_ps(_mm256_sub_ps(m, _mm256_set1_ps(1.0f)), _mm256_add_ps(m, _mm256_set1_ps(1.0f)));
+	const __m256 s2 = _mm256_mul_ps(s, s);
+	__m256 p = _mm256_set1_ps(0.2371599674224853515625f);
+	p = _mm256_fmadd_ps(p, s2, _mm256_set1_ps(0.285279005765914916992188f));
+	p = _mm256_fmadd_ps(p, s2, _mm256_set1_ps(0.400005519390106201171875f));
+	p = _mm256_fmadd_ps(p, s2, _mm256_set1_ps(0.666666567325592041015625f));
+	p = _mm256_fmadd_ps(p, s2, _mm256_set1_ps(2.0f));
+	__m256 result = _mm256_fmadd_ps(e, _mm256_set1_ps(0.693147180559945286226764f), _mm256_mul_ps(p, s));
+
+	result = _mm256_blendv_ps(result, _mm256_set1_ps(-std::numeric_limits<float>::infinity()), _mm256_cmp_ps(x.Get(), _mm256_setzero_ps(), _CMP_EQ_OQ));
+	result = _mm256_blendv_ps(result, x.Get(), _mm256_cmp_ps(x.Get(), _mm256_set1_ps(std::numeric_limits<float>::infinity()), _CMP_EQ_OQ));
+	return Float8{_mm256_blendv_ps(result, _mm256_set1_ps(std::numeric_limits<float>::quiet_NaN()), _mm256_cmp_ps(x.Get(), _mm256_setzero_ps(), _CMP_NGE_UQ))};
+}
+#else
+class Mask8
+{
+  public:
+	Mask8() = default;
+	Mask8(const bool b)
+	{
+		for (bool& v : m_v)
+		{
+			v = b;
+		}
+	}
+
+	bool operator[](const uint32_t i) const { return m_v[i]; }
+	bool& operator[](const uint32_t i) { return m_v[i]; }
+
+	uint32_t Bits() const
+	{
+		uint32_t bits = 0;
+
+		for (uint32_t i = 0; i < SIMD_WIDTH; ++i)
+		{
+			bits |= static_cast<uint32_t>(m_v[i]) << i;
+		}
+
+		return bits;
+	}
+
+	friend Mask8 operator&(const Mask8 a, const Mask8 b) { return Apply(a, b, [](bool x, bool y) { return x && y; }); }
+	friend Mask8 operator|(const Mask8 a, const Mask8 b) { return Apply(a, b, [](bool x, bool y) { return x || y; }); }
+	friend Mask8 operator!(const Mask8 a) { return Apply(a, a, [](bool x, bool) { return !x; }); }
+
+  private:
+	template <typename F>
+	static Mask8 Apply(const Mask8 a, const Mask8 b, const F f)
+	{
+		Mask8 r;
+
+		for (uint32_t i = 0; i < SIMD_WIDTH; ++i)
+		{
+			r.m_v[i] = f(a.m_v[i], b.m_v[i]);
+		}
+
+		return r;
+	}
+
+	bool m_v[SIMD_WIDTH];
+};
+
+class Float8
+{
+  public:
+	Float8() = default;
+	Float8(const float s)
+	{
+		for (float& v : m_v)
+		{
+			v = s;
+		}
+	}
+
+	static Float8 Load(const float* p)
+	{
+		Float8 r;
+		std::copy(p, p + SIMD_WIDTH, r.m_v);
+		return r;
+	}
+	static Float8 Load2x4(const float* row0, const float* row1)
+	{
+		Float8 r;
+		std::copy(row0, row0 + SIMD_WIDTH / 2, r.m_v);
+		std::copy(row1, row1 + SIMD_WIDTH / 2, r.m_v + SIMD_WIDTH / 2);
+		return r;
+	}
+	static Float8 Gather(const float* base, const uint32_t (&indices)[SIMD_WIDTH])
+	{
+		Float8 r;
+
+		for (uint32_t i = 0; i < SIMD_WIDTH; ++i)
+		{
+			r.m_v[i] = base[indices[i]];
+		}
+
+		return r;
+	}
+	static Float8 Gather(const float* base, const Float8 indices)
+	{
+		Float8 r;
+
+		for (uint32_t i = 0; i < SIMD_WIDTH; ++i)
+		{
+			r.m_v[i] = base[static_cast<uint32_t>(indices.m_v[i])];
+		}
+
+		return r;
+	}
+	void Store(float* p) const { std::copy(m_v, m_v + SIMD_WIDTH, p); }
+	void Store2x4(float* row0, float* row1) const
+	{
+		std::copy(m_v, m_v + SIMD_WIDTH / 2, row0);
+		std::copy(m_v + SIMD_WIDTH / 2, m_v + SIMD_WIDTH, row1);
+	}
+	Float8 Permute(const uint32_t (&indices)[SIMD_WIDTH]) const { return Gather(m_v, indices); }
+	float Lane(const uint32_t i) const { return m_v[i]; }
+
+	float operator[](const uint32_t i) const { return m_v[i]; }
+	float& operator[](const uint32_t i) { return m_v[i]; }
+
+	friend Float8 operator+(const Float8 a, const Float8 b) { return Apply(a, b, [](float x, float y) { return x + y; }); }
+	friend Float8 operator-(const Float8 a, const Float8 b) { return Apply(a, b, [](float x, float y) { return x - y; }); }
+	friend Float8 operator*(const Float8 a, const Float8 b) { return Apply(a, b, [](float x, float y) { return x * y; }); }
+	friend Float8 operator/(const Float8 a, const Float8 b) { return Apply(a, b, [](float x, float y) { return x / y; }); }
+	friend Float8 operator-(const Float8 a) { return Apply(a, a, [](float x, float) { return -x; }); }
+	Float8& operator+=(const Float8 a) { return *this = *this + a; }
+	Float8& operator-=(const Float8 a) { return *this = *this - a; }
+	Float8& operator*=(const Float8 a) { return *this = *this * a; }
+
+	friend Mask8 operator<(const Float8 a, const Float8 b) { return Compare(a, b, [](float x, float y) { return x < y; }); }
+	friend Mask8 operator<=(const Float8 a, const Float8 b) { return Compare(a, b, [](float x, float y) { return x <= y; }); }
+	friend Mask8 operator>(const Float8 a, const Float8 b) { return Compare(a, b, [](float x, float y) { return x > y; }); }
+	friend Mask8 operator>=(const Float8 a, const Float8 b) { return Compare(a, b, [](float x, float y) { return x >= y; }); }
+	friend Mask8 operator==(const Float8 a, const Float8 b) { return Compare(a, b, [](float x, float y) { return x == y; }); }
+	friend Mask8 operator!=(const Float8 a, const Float8 b) { return Compare(a, b, [](float x, float y) { return x != y; }); }
+
+	template <typename F>
+	static Float8 Apply(const Float8 a, const Float8 b, const F f)
+	{
+		Float8 r;
+
+		for (uint32_t i = 0; i < SIMD_WIDTH; ++i)
+		{
+			r.m_v[i] = f(a.m_v[i], b.m_v[i]);
+		}
+
+		return r;
+	}
+
+  private:
+	template <typename F>
+	static Mask8 Compare(const Float8 a, const Float8 b, const F f)
+	{
+		Mask8 r;
+
+		for (uint32_t i = 0; i < SIMD_WIDTH; ++i)
+		{
+			r[i] = f(a.m_v[i], b.m_v[i]);
+		}
+
+		return r;
+	}
+
+	float m_v[SIMD_WIDTH];
+};
+
+inline Float8 Select(const Mask8 m, const Float8 a, const Float8 b)
+{
+	Float8 r;
+
+	for (uint32_t i = 0; i < SIMD_WIDTH; ++i)
+	{
+		r[i] = m[i] ? a[i] : b[i];
+	}
+
+	return r;
+}
+
+inline Float8 Min(const Float8 a, const Float8 b) { return Float8::Apply(a, b, [](float x, float y) { return y < x ? y : x; }); }
+inline Float8 Max(const Float8 a, const Float8 b) { return Float8::Apply(a, b, [](float x, float y) { return x < y ? y : x; }); }
+inline Float8 Abs(const Float8 a) { return Float8::Apply(a, a, [](float x, float) { return std::abs(x); }); }
+inline Float8 Sqrt(const Float8 a) { return Float8::Apply(a, a, [](float x, float) { return std::sqrt(x); }); }
+inline Float8 Floor(const Float8 a) { return Float8::Apply(a, a, [](float x, float) { return std::floor(x); }); }
+inline Float8 MulAdd(const Float8 a, const Float8 b, const Float8 c) { return a * b + c; }
+inline Float8 MulSign(const Float8 x, const Float8 y) { return Float8::Apply(x, y, [](float a, float b) { return std::bit_cast<float>((std::bit_cast<uint32_t>(b) & 0x80000000u) ^ std::bit_cast<uint32_t>(a)); }); }
+inline Float8 Exp2(const Float8 x) { return Float8::Apply(x, x, [](float a, float) { return std::exp2(a); }); }
+inline Float8 Exp(const Float8 x) { return Float8::Apply(x, x, [](float a, float) { return std::exp(a); }); }
+inline Float8 Log(const Float8 x) { return Float8::Apply(x, x, [](float a, float) { return std::log(a); }); }
+
+inline Mask8 IsFinite(const Float8 a)
+{
+	Mask8 r;
+
+	for (uint32_t i = 0; i < SIMD_WIDTH; ++i)
+	{
+		r[i] = std::isfinite(a[i]);
+	}
+
+	return r;
+}
+#endif
+
+inline float ReduceMin(const Float8 a)
+{
+	float v[SIMD_WIDTH];
+	a.Store(v);
+	return *std::min_element(v, v + SIMD_WIDTH);
+}
+
+inline bool Any(const Mask8 m) { return m.Bits() != 0; }
+inline bool All(const Mask8 m) { return m.Bits() == (1u << SIMD_WIDTH) - 1; }
+
+// Scalar overloads so that the shading code can be instantiated for both float and Float8.
+inline bool Any(const bool m) { return m; }
+inline bool All(const bool m) { return m; }
+inline float Select(const bool m, const float a, const float b) { return m ? a : b; }
+inline float Min(const float a, const float b) { return b < a ? b : a; }
+inline float Max(const float a, const float b) { return a < b ? b : a; }
+inline float Abs(const float a) { return std::abs(a); }
+inline float Sqrt(const float a) { return std::sqrt(a); }
+inline float Floor(const float a) { return std::floor(a); }
+inline float MulAdd(const float a, const float b, const float c) { return a * b + c; }
+inline float MulSign(const float x, const float y) { return std::bit_cast<float>((std::bit_cast<uint32_t>(y) & 0x80000000u) ^ std::bit_cast<uint32_t>(x)); }
+inline float Exp2(const float x) { return std::exp2(x); }
+inline float Exp(const float x) { return std::exp(x); }
+inline float Log(const float x) { return std::log(x); }
+inline bool IsFinite(const float a) { return std::isfinite(a); }
+
+template <typename T>
+using MaskOf = decltype(T{} < T{});
+
+template <typename T>
+T Clamp(const T x, const T lo, const T hi)
+{
+	return Min(Max(x, lo), hi);
+}
+
+template <typename T>
+T Saturate(const T x)
+{
+	return Clamp(x, T(0.0f), T(1.0f));
+}
+
+template <typename T>
+T Lerp(const T a, const T b, const T t)
+{
+	return a + (b - a) * t;
+}
+
+template <typename T>
+T Rsqrt(const T x)
+{
+	return T(1.0f) / Sqrt(x);
+}
+} // namespace vsgl::cpu
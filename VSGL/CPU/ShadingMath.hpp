@@ -0,0 +1,455 @@
+#pragma once
+
+// C++ counterparts of the shader math in Shaders/*.hlsli.
+// Every function is a template over the scalar type T (float or Float8) so that the same code runs per pixel and across SIMD lanes.
+// Functions keep the names of their HLSL originals; see the .hlsli files for the references and derivations.
+
+#include "SIMD.hpp"
+
+#include <cstdint>
+#include <numbers>
+
+namespace vsgl::cpu
+{
+static constexpr float M_PI_F = std::numbers::pi_v<float>;
+static constexpr float FLT_MIN_F = std::numeric_limits<float>::min();
+static constexpr float FLT_MAX_F = std::numeric_limits<float>::max();
+static constexpr float FLT_EPSILON_F = std::numeric_limits<float>::epsilon();
+
+template <typename T>
+struct Vec2
+{
+	T x;
+	T y;
+};
+
+template <typename T>
+struct Vec3
+{
+	T x;
+	T y;
+	T z;
+
+	Vec3() = default;
+	Vec3(const T x_, const T y_, const T z_) : x(x_), y(y_), z(z_) {}
+	template <typename U>
+	explicit Vec3(const Vec3<U>& v) : x(v.x), y(v.y), z(v.z) {}
+
+	friend Vec3 operator+(const Vec3& a, const Vec3& b) { return {a.x + b.x, a.y + b.y, a.z + b.z}; }
+	friend Vec3 operator-(const Vec3& a, const Vec3& b) { return {a.x - b.x, a.y - b.y, a.z - b.z}; }
+	friend Vec3 operator*(const Vec3& a, const Vec3& b) { return {a.x * b.x, a.y * b.y, a.z * b.z}; }
+	friend Vec3 operator*(const Vec3& a, const T s) { return {a.x * s, a.y * s, a.z * s}; }
+	friend Vec3 operator*(const T s, const Vec3& a) { return {a.x * s, a.y * s, a.z * s}; }
+	friend Vec3 operator/(const Vec3& a, const T s) { return {a.x / s, a.y / s, a.z / s}; }
+	friend Vec3 operator-(const Vec3& a) { return {-a.x, -a.y, -a.z}; }
+	Vec3& operator+=(const Vec3& a) { return *this = *this + a; }
+};
+
+using Float3 = Vec3<float>;
+
+// Rows of an HLSL float3x3.
+template <typename T>
+struct Mat3
+{
+	Vec3<T> r0;
+	Vec3<T> r1;
+	Vec3<T> r2;
+};
+
+// HLSL float2x2 with entries _11, _12, _21, _22.
+template <typename T>
+struct Mat2
+{
+	T m11;
+	T m12;
+	T m21;
+	T m22;
+};
+
+// Row-major 4x4 matrix with the memory layout of XMMATRIX.
+// A point p is transformed as p.x * m[0] + p.y * m[1] + p.z * m[2] + m[3], which matches mul(matrix, float4(p, 1)) in the shaders.
+struct Float4x4
+{
+	float m[4][4];
+};
+
+template <typename T>
+T Dot(const Vec3<T>& a, const Vec3<T>& b)
+{
+	return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+
+template <typename T>
+Vec3<T> Cross(const Vec3<T>& a, const Vec3<T>& b)
+{
+	return {a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x};
+}
+
+template <typename T>
+T Length(const Vec3<T>& a)
+{
+	return Sqrt(Dot(a, a));
+}
+
+template <typename T>
+Vec3<T> Normalize(const Vec3<T>& a)
+{
+	return a * Rsqrt(Dot(a, a));
+}
+
+template <typename T>
+Vec3<T> Select(const MaskOf<T> m, const Vec3<T>& a, const Vec3<T>& b)
+{
+	return {Select(m, a.x, b.x), Select(m, a.y, b.y), Select(m, a.z, b.z)};
+}
+
+template <typename T>
+Vec3<T> Reflect(const Vec3<T>& i, const Vec3<T>& n)
+{
+	return i - n * (T(2.0f) * Dot(i, n));
+}
+
+// mul(m, v)
+template <typename T>
+Vec3<T> Mul(const Mat3<T>& m, const Vec3<T>& v)
+{
+	return {Dot(m.r0, v), Dot(m.r1, v), Dot(m.r2, v)};
+}
+
+// mul(v, m)
+template <typename T>
+Vec3<T> Mul(const Vec3<T>& v, const Mat3<T>& m)
+{
+	return m.r0 * v.x + m.r1 * v.y + m.r2 * v.z;
+}
+
+// Transform a point and divide by w (NDCTransform in NormalizedDeviceCoordinate.hlsli).
+template <typename T>
+Vec3<T> NDCTransform(const Vec3<T>& p, const Float4x4& m)
+{
+	const T x = p.x * m.m[0][0] + p.y * m.m[1][0] + p.z * m.m[2][0] + m.m[3][0];
+	const T y = p.x * m.m[0][1] + p.y * m.m[1][1] + p.z * m.m[2][1] + m.m[3][1];
+	const T z = p.x * m.m[0][2] + p.y * m.m[1][2] + p.z * m.m[2][2] + m.m[3][2];
+	const T w = p.x * m.m[0][3] + p.y * m.m[1][3] + p.z * m.m[2][3] + m.m[3][3];
+	const T invW = T(1.0f) / w;
+	return {x * invW, y * invW, z * invW};
+}
+
+template <typename T>
+Vec2<T> NDCToTexcoord(const T ndcX, const T ndcY)
+{
+	return {ndcX * 0.5f + 0.5f, -ndcY * 0.5f + 0.5f};
+}
+
+//
+// Math.hlsli
+//
+
+template <typename T>
+T Expm1(const T x)
+{
+	const T u = Exp(x);
+	const T y = u - 1.0f;
+	const T small = y * x / Log(u);
+	return Select(u == T(1.0f), x, Select(Abs(x) < T(1.0f), small, y));
+}
+
+template <typename T>
+T Expm1OverX(const T x)
+{
+	const T u = Exp(x);
+	const T y = u - 1.0f;
+	return Select(u == T(1.0f), T(1.0f), Select(Abs(x) < T(1.0f), y / Log(u), y / x));
+}
+
+template <typename T>
+T Erf(const T x)
+{
+	const T a = Abs(x);
+
+	// |x| > 1
+	const T large = T(1.0f) - Exp2(-((((((((2.58907676e-5f * a - 5.64874616e-4f) * a + 5.66795561e-3f) * a - 3.51759829e-2f) * a + 1.54329389e-1f) * a + 9.15674746e-1f) * a + 1.628459513f) * a)));
+
+	// |x| <= 1
+	const T x2 = x * x;
+	const T small = (((((-5.58853149e-4f * x2 + 4.90735564e-3f) * x2 - 2.67030653e-2f) * x2 + 1.12799220e-1f) * x2 - 3.76123011e-1f) * x2 + 1.128379121f) * x;
+
+	return Select(a >= T(4.0f), MulSign(T(1.0f), x), Select(a > T(1.0f), MulSign(large, x), small));
+}
+
+template <typename T>
+T Erfc(const T x)
+{
+	return T(1.0f) - Erf(x);
+}
+
+//
+// NormalMapUtility.hlsli
+//
+
+template <typename T>
+Vec3<T> DecodeNormalMap(const T nx, const T ny)
+{
+	return {nx, ny, Sqrt(Saturate(T(1.0f) - (nx * nx + ny * ny)))};
+}
+
+template <typename T>
+Mat3<T> BuildTangentFrame(const Vec3<T>& normal, const Vec3<T>& tangent, const T bitangentSign)
+{
+	const Vec3<T> bitangent = Normalize(Cross(normal, tangent));
+	return {Cross(bitangent, normal), bitangent * bitangentSign, normal};
+}
+
+//
+// NDFFiltering.hlsli
+//
+
+template <typename T>
+Vec2<T> IsotropicNDFFiltering(const Vec3<T>& dndu, const Vec3<T>& dndv, const Vec2<T>& alpha)
+{
+	constexpr float SIGMA2 = 0.15915494f; // Variance of pixel filter kernel (1/(2pi)).
+	constexpr float KAPPA = 0.18f;       // User-specified clamping threshold.
+	const T kernelAlpha2 = SIGMA2 * (Dot(dndu, dndu) + Dot(dndv, dndv));
+	const T clampedKernelAlpha2 = Min(kernelAlpha2, T(KAPPA));
+	return {Sqrt(Saturate(alpha.x * alpha.x + clampedKernelAlpha2)), Sqrt(Saturate(alpha.y * alpha.y + clampedKernelAlpha2))};
+}
+
+//
+// GGX.hlsli
+//
+
+template <typename T>
+T SGGX(const Vec3<T>& m, const Vec2<T>& alpha)
+{
+	const Vec3<T> stretched = {m.x / alpha.x, m.y / alpha.y, m.z};
+	const T length2 = Dot(stretched, stretched);
+	return T(1.0f) / (M_PI_F * (alpha.x * alpha.y) * (length2 * length2));
+}
+
+template <typename T>
+T SGGX(const Vec3<T>& m, const Mat2<T>& roughnessMat)
+{
+	const T det = Max(roughnessMat.m11 * roughnessMat.m22 - roughnessMat.m12 * roughnessMat.m21, T(FLT_MIN_F));
+	const T adjX = roughnessMat.m22 * m.x - roughnessMat.m12 * m.y;
+	const T adjY = -roughnessMat.m21 * m.x + roughnessMat.m11 * m.y;
+	const T length2 = (m.x * adjX + m.y * adjY) / det + m.z * m.z;
+	return T(1.0f) / (M_PI_F * Sqrt(det) * (length2 * length2));
+}
+
+template <typename T>
+T GGX(const Vec3<T>& m, const Vec2<T>& alpha)
+{
+	return Select(m.z > T(0.0f), SGGX(m, alpha), T(0.0f));
+}
+
+template <typename T>
+Vec3<T> GGXDominantVisibleNormal(const Vec3<T>& wi, const Vec2<T>& alpha)
+{
+	const T vx = alpha.x * wi.x;
+	const T vy = alpha.y * wi.y;
+	const T len2 = vx * vx + vy * vy;
+	const T t = Sqrt(len2 + wi.z * wi.z);
+	const T z = Select(wi.z >= T(0.0f), t + wi.z, len2 / (t - wi.z));
+	return Normalize(Vec3<T>{alpha.x * alpha.x * wi.x, alpha.y * alpha.y * wi.y, z});
+}
+
+template <typename T>
+T SGGXReflectionPDF(const Vec3<T>& wi, const Vec3<T>& m, const Mat2<T>& roughnessMat)
+{
+	const T rx = roughnessMat.m11 * wi.x + roughnessMat.m12 * wi.y;
+	const T ry = roughnessMat.m21 * wi.x + roughnessMat.m22 * wi.y;
+	return SGGX(m, roughnessMat) / (4.0f * Sqrt(wi.x * rx + wi.y * ry + wi.z * wi.z));
+}
+
+template <typename T>
+T PerceptualRoughnessToAlpha(const T perceptualRoughness)
+{
+	constexpr float ALPHA_MIN = 0x1.0p-31f;
+	return Max(perceptualRoughness * perceptualRoughness, T(ALPHA_MIN));
+}
+
+//
+// SmithGGXBRDF.hlsli
+//
+
+template <typename T>
+T SmithGGXBRDF(const Vec3<T>& wi, const Vec3<T>& wo, const Vec2<T>& alpha)
+{
+	const Vec3<T> m = Normalize(wi + wo);
+	const T ndf = GGX(m, alpha);
+	const T si = Length(Vec3<T>{wi.x * alpha.x, wi.y * alpha.y, wi.z});
+	const T so = Length(Vec3<T>{wo.x * alpha.x, wo.y * alpha.y, wo.z});
+	return Min(ndf / (2.0f * (si * Abs(wo.z) + so * Abs(wi.z))), T(FLT_MAX_F));
+}
+
+template <typename T>
+T SmithGGXLobeOverUnnormalizedNDF(const Vec3<T>& incomingDir, const Vec3<T>& outgoingDir, const Vec3<T>& normal, const T alpha2)
+{
+	const T zi = Dot(normal, incomingDir);
+	const T zo = Dot(normal, outgoingDir);
+	const T si = Sqrt(alpha2 + (T(1.0f) - alpha2) * (zi * zi));
+	const T so = Sqrt(alpha2 + (T(1.0f) - alpha2) * (zo * zo));
+	return Saturate(zo) / Max(2.0f * M_PI_F * alpha2 * (si * Abs(zo) + so * Abs(zi)), T(FLT_MIN_F));
+}
+
+//
+// SphericalGaussian.hlsli
+//
+
+template <typename T>
+struct SGLobe
+{
+	Vec3<T> axis;
+	T sharpness;
+	T logAmplitude;
+};
+
+template <typename T>
+T SGIntegral(const T sharpness)
+{
+	return 4.0f * M_PI_F * Expm1OverX(-2.0f * sharpness);
+}
+
+template <typename T>
+SGLobe<T> SGProduct(const Vec3<T>& axis1, const T sharpness1, const Vec3<T>& axis2, const T sharpness2)
+{
+	const Vec3<T> axis = axis1 * sharpness1 + axis2 * sharpness2;
+	const T sharpness = Length(axis);
+	const Vec3<T> d = axis1 - axis2;
+	const T len2 = Dot(d, d);
+	const T logAmplitude = -sharpness1 * sharpness2 * len2 / Max(sharpness + sharpness1 + sharpness2, T(FLT_MIN_F));
+	return {axis / Max(sharpness, T(FLT_MIN_F)), sharpness, logAmplitude};
+}
+
+template <typename T>
+T SGNormalizedHemisphericalIntegral(const T cosine, const T sharpness)
+{
+	constexpr float A = 0.6517328826907056171791055021459f;
+	constexpr float B = 1.3418280033141287699294252888649f;
+	constexpr float C = 7.2216687798956709087860872386955f;
+	const T steepness = sharpness * Sqrt((0.5f * sharpness + A) / ((sharpness + B) * sharpness + C));
+	return Saturate(0.5f + 0.5f * (Erf(steepness * Clamp(cosine, T(-1.0f), T(1.0f))) / Erf(steepness)));
+}
+
+template <typename T>
+T SGHemisphericalIntegralOverTwoPi(const T cosine, const T sharpness)
+{
+	const T lerpFactor = SGNormalizedHemisphericalIntegral(cosine, sharpness);
+	const T e = Exp(-sharpness);
+	return Lerp(e, T(1.0f), lerpFactor) * Expm1OverX(-sharpness);
+}
+
+template <typename T>
+T VMFHemisphericalIntegral(const T cosine, const T sharpness)
+{
+	const T lerpFactor = SGNormalizedHemisphericalIntegral(cosine, sharpness);
+	const T e = Exp(-sharpness);
+	return Lerp(e, T(1.0f), lerpFactor) / (e + 1.0f);
+}
+
+template <typename T>
+T SGClampedCosineProductIntegralOverPi2022(const SGLobe<T>& sg, const Vec3<T>& normal)
+{
+	constexpr float LAMBDA = 0.00084560872241480124f;
+	constexpr float ALPHA = 1182.2467339678153f;
+	const SGLobe<T> prodLobe = SGProduct(sg.axis, sg.sharpness, normal, T(LAMBDA));
+	const T integral0 = SGHemisphericalIntegralOverTwoPi(Dot(prodLobe.axis, normal), prodLobe.sharpness) * Exp(prodLobe.logAmplitude + LAMBDA);
+	const T integral1 = SGHemisphericalIntegralOverTwoPi(Dot(sg.axis, normal), sg.sharpness);
+	return Exp(sg.logAmplitude) * Max(2.0f * ALPHA * (integral0 - integral1), T(0.0f));
+}
+
+template <typename T>
+T UpperSGClampedCosineIntegralOverTwoPi(const T sharpness)
+{
+	const T s = sharpness;
+	const T taylor = (((((((-1.0f / 362880.0f) * s + 1.0f / 40320.0f) * s - 1.0f / 5040.0f) * s + 1.0f / 720.0f) * s - 1.0f / 120.0f) * s + 1.0f / 24.0f) * s - 1.0f / 6.0f) * s + 0.5f;
+	return Select(s <= T(0.5f), taylor, (T(1.0f) - Expm1OverX(-s)) / s);
+}
+
+template <typename T>
+T LowerSGClampedCosineIntegralOverTwoPi(const T sharpness)
+{
+	const T s = sharpness;
+	const T e = Exp(-s);
+	const T taylor = e * (((((((((1.0f / 403200.0f) * s - 1.0f / 45360.0f) * s + 1.0f / 5760.0f) * s - 1.0f / 840.0f) * s + 1.0f / 144.0f) * s - 1.0f / 30.0f) * s + 1.0f / 8.0f) * s - 1.0f / 3.0f) * s + 0.5f);
+	return Select(s <= T(0.5f), taylor, e * (Expm1OverX(-s) - e) / s);
+}
+
+template <typename T>
+T SGClampedCosineProductIntegralOverPi2024(const T cosine, const T sharpness)
+{
+	constexpr float A = 2.7360831611272558028247203765204f;
+	constexpr float B = 17.02129778174187535455530451145f;
+	constexpr float C = 4.0100826728510421403939290030394f;
+	constexpr float D = 15.219156263147210594866010069381f;
+	constexpr float E = 76.087896272360737270901154261082f;
+	const T t = sharpness * Sqrt(0.5f * ((sharpness + A) * sharpness + B) / (((sharpness + C) * sharpness + D) * sharpness + E));
+	const T tz = t * cosine;
+
+	// Same conservative clamping as the HLSL version since Erfc has the same precision here.
+	constexpr float INV_SQRTPI = 0.56418958354775628694807945156077f;
+	constexpr float CLAMPING_THRESHOLD = 0.5f * FLT_EPSILON_F;
+	const T lerpFactor = Saturate(Max(0.5f * (cosine * Erfc(-tz) + Erfc(t)) - 0.5f * INV_SQRTPI * Exp(-tz * tz) * Expm1(t * t * (cosine * cosine - 1.0f)) / t, T(CLAMPING_THRESHOLD)));
+
+	const T lowerIntegral = LowerSGClampedCosineIntegralOverTwoPi(sharpness);
+	const T upperIntegral = UpperSGClampedCosineIntegralOverTwoPi(sharpness);
+	return 2.0f * Lerp(lowerIntegral, upperIntegral, lerpFactor);
+}
+
+//
+// AnisotropicSphericalGaussian.hlsli
+//
+
+template <typename T>
+struct ASGLobe
+{
+	Vec3<T> x;
+	Vec3<T> y;
+	Vec3<T> z;
+	Vec2<T> sharpness;
+	T logAmplitude;
+};
+
+template <typename T>
+T ASGSharpnessToSGSharpness(const Vec2<T>& sharpness)
+{
+	return 2.0f * Sqrt(sharpness.x * sharpness.y);
+}
+
+template <typename T>
+T SGSharpnessToASGSharpness(const T sharpness)
+{
+	return 0.5f * sharpness;
+}
+
+template <typename T>
+T ASGEvaluate(const Vec3<T>& dir, const ASGLobe<T>& asg)
+{
+	const T smoothing = Saturate(Dot(dir, asg.z));
+	const T vx = Dot(dir, asg.x);
+	const T vy = Dot(dir, asg.y);
+	return smoothing * Exp(asg.logAmplitude - (asg.sharpness.x * vx * vx + asg.sharpness.y * vy * vy));
+}
+
+template <typename T>
+T ASGProductIntegral(const ASGLobe<T>& asg, const SGLobe<T>& sg)
+{
+	const T sharpness = SGSharpnessToASGSharpness(sg.sharpness);
+	const Vec2<T> sharpnessSum = {asg.sharpness.x + sharpness, asg.sharpness.y + sharpness};
+	const ASGLobe<T> lobe = {asg.x, asg.y, asg.z, {asg.sharpness.x * sharpness / sharpnessSum.x, asg.sharpness.y * sharpness / sharpnessSum.y}, sg.logAmplitude};
+	return M_PI_F * ASGEvaluate(sg.axis, lobe) * Rsqrt(sharpnessSum.x * sharpnessSum.y);
+}
+
+template <typename T>
+ASGLobe<T> ASGReflectionLobe(const Vec3<T>& dir, const Vec3<T>& normal, const T alpha2)
+{
+	const T sharpnessNDF = T(1.0f) / alpha2 - 1.0f;
+	const T jacobianX = 2.0f * Dot(dir, normal);
+	const T jacobianY = 2.0f;
+	const Vec2<T> sharpness = {sharpnessNDF / (jacobianX * jacobianX), sharpnessNDF / (jacobianY * jacobianY)};
+	const Vec3<T> axisX = Normalize(Cross(dir, normal));
+	const Vec3<T> axisZ = Reflect(-dir, normal);
+	const Vec3<T> axisY = Cross(axisZ, axisX);
+	return {axisX, axisY, axisZ, sharpness, T(0.0f)};
+}
+} // namespace vsgl::cpu
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "Image.hpp"
+#include "SIMD.hpp"
+#include "ShadingMath.hpp"
+
+namespace vsgl::cpu
+{
+// SampleCmpLevelZero() on a D32 shadow map with D3D12_FILTER_COMPARISON_MIN_MAG_LINEAR_MIP_POINT, D3D12_TEXTURE_ADDRESS_MODE_BORDER
+// and D3D12_COMPARISON_FUNC_GREATER, as set up for the shadow sampler in MyRenderer. Each of the 2x2 texels is compared with the reference first,
+// and the results are bilinearly weighted. Texels outside the image return borderDepth (the white border color by default).
+inline Float8 SampleCmpLevelZero(const Image& shadowMap, const Vec2<Float8>& texcoord, const Float8 reference, const float borderDepth = 1.0f)
+{
+	const float width = static_cast<float>(shadowMap.GetWidth());
+	const float height = static_cast<float>(shadowMap.GetHeight());
+	const float pitch = static_cast<float>(shadowMap.GetPitch());
+
+	// Clamping into [-1, size] keeps the texel indices small without changing the result since any texel outside the image is the border.
+	const Float8 u = Clamp(texcoord.x * width - 0.5f, Float8(-1.0f), Float8(width));
+	const Float8 v = Clamp(texcoord.y * height - 0.5f, Float8(-1.0f), Float8(height));
+	const Float8 x0 = Floor(u);
+	const Float8 y0 = Floor(v);
+	const Float8 fu = u - x0;
+	const Float8 fv = v - y0;
+
+	const Mask8 insideX0 = (x0 >= Float8(0.0f)) & (x0 < Float8(width));
+	const Mask8 insideX1 = x0 + 1.0f < Float8(width); // x0 + 1 >= 0 after the clamp.
+	const Mask8 insideY0 = (y0 >= Float8(0.0f)) & (y0 < Float8(height));
+	const Mask8 insideY1 = y0 + 1.0f < Float8(height);
+	const Float8 row0 = y0 * pitch;
+	const Float8 row1 = row0 + pitch;
+
+	const auto compare = [&](const Mask8 inside, const Float8 index) {
+		// Masked-out lanes (including NaN texcoords) gather the first texel instead of an invalid address.
+		const Float8 depth = Select(inside, Float8::Gather(shadowMap.GetData(), Select(inside, index, Float8(0.0f))), Float8(borderDepth));
+		return Select(reference > depth, Float8(1.0f), Float8(0.0f));
+	};
+
+	const Float8 c00 = compare(insideX0 & insideY0, row0 + x0);
+	const Float8 c10 = compare(insideX1 & insideY0, row0 + x0 + 1.0f);
+	const Float8 c01 = compare(insideX0 & insideY1, row1 + x0);
+	const Float8 c11 = compare(insideX1 & insideY1, row1 + x0 + 1.0f);
+	return Lerp(Lerp(c00, c10, fu), Lerp(c01, c11, fu), fv);
+}
+} // namespace vsgl::cpu
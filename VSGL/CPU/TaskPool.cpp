@@ -0,0 +1,184 @@
+#include "TaskPool.hpp"
+
+#include <algorithm>
+
+namespace vsgl::cpu
+{
+namespace
+{
+thread_local const TaskPool* t_currentPool = nullptr;
+thread_local uint32_t t_workerIndex = 0;
+} // namespace
+
+TaskPool::TaskPool(const uint32_t threadCount)
+{
+	m_workerCount = (threadCount > 0) ? threadCount : std::max(std::thread::hardware_concurrency(), 1u);
+	m_queues = std::make_unique<WorkQueue[]>(m_workerCount);
+	m_threads.reserve(m_workerCount - 1);
+
+	for (uint32_t workerIndex = 1; workerIndex < m_workerCount; ++workerIndex)
+	{
+		m_threads.emplace_back(&TaskPool::WorkerMain, this, workerIndex);
+	}
+}
+
+TaskPool::~TaskPool()
+{
+	{
+		const std::lock_guard lock{m_mutex};
+		m_shutdown = true;
+	}
+
+	m_wakeCondition.notify_all();
+
+	for (std::thread& thread : m_threads)
+	{
+		thread.join();
+	}
+}
+
+void TaskPool::Run(const uint32_t count, const TaskFunction function, void* context)
+{
+	if (count == 0)
+	{
+		return;
+	}
+
+	// Nested loops and single-threaded pools run serially on the current thread.
+	if (t_currentPool != nullptr || m_workerCount == 1)
+	{
+		const uint32_t workerIndex = (t_currentPool == this) ? t_workerIndex : 0;
+
+		for (uint32_t index = 0; index < count; ++index)
+		{
+			function(context, index, workerIndex);
+		}
+
+		return;
+	}
+
+	const std::lock_guard runLock{m_runMutex};
+	m_function.store(function, std::memory_order_relaxed);
+	m_context.store(context, std::memory_order_relaxed);
+	m_remaining.store(count, std::memory_order_relaxed);
+
+	// Distribute contiguous ranges so that each worker starts with neighboring items (e.g., neighboring screen tiles).
+	for (uint32_t workerIndex = 0; workerIndex < m_workerCount; ++workerIndex)
+	{
+		WorkQueue& queue = m_queues[workerIndex];
+		const std::lock_guard lock{queue.mutex};
+		queue.begin = static_cast<uint32_t>(uint64_t{count} * workerIndex / m_workerCount);
+		queue.end = static_cast<uint32_t>(uint64_t{count} * (workerIndex + 1) / m_workerCount);
+	}
+
+	{
+		const std::lock_guard lock{m_mutex};
+		++m_generation;
+	}
+
+	m_wakeCondition.notify_all();
+
+	t_currentPool = this;
+	t_workerIndex = 0;
+	Execute(0);
+	t_currentPool = nullptr;
+
+	std::unique_lock lock{m_mutex};
+	m_doneCondition.wait(lock, [this] { return m_remaining.load(std::memory_order_acquire) == 0; });
+}
+
+void TaskPool::WorkerMain(const uint32_t workerIndex)
+{
+	t_currentPool = this;
+	t_workerIndex = workerIndex;
+	uint64_t generation = 0;
+
+	for (;;)
+	{
+		{
+			std::unique_lock lock{m_mutex};
+			m_wakeCondition.wait(lock, [&] { return m_shutdown || m_generation != generation; });
+
+			if (m_shutdown)
+			{
+				return;
+			}
+
+			generation = m_generation;
+		}
+
+		Execute(workerIndex);
+	}
+}
+
+void TaskPool::Execute(const uint32_t workerIndex)
+{
+	uint32_t index = 0;
+
+	while (Pop(workerIndex, index) || Steal(workerIndex, index))
+	{
+		m_function.load(std::memory_order_relaxed)(m_context.load(std::memory_order_relaxed), index, workerIndex);
+
+		if (m_remaining.fetch_sub(1, std::memory_order_acq_rel) == 1)
+		{
+			// Lock to avoid a lost wakeup between the predicate check and the wait in Run().
+			const std::lock_guard lock{m_mutex};
+			m_doneCondition.notify_one();
+		}
+	}
+}
+
+bool TaskPool::Pop(const uint32_t workerIndex, uint32_t& index)
+{
+	WorkQueue& queue = m_queues[workerIndex];
+	const std::lock_guard lock{queue.mutex};
+
+	if (queue.begin == queue.end)
+	{
+		return false;
+	}
+
+	index = queue.begin++;
+	return true;
+}
+
+bool TaskPool::Steal(const uint32_t workerIndex, uint32_t& index)
+{
+	for (uint32_t i = 1; i < m_workerCount; ++i)
+	{
+		const uint32_t victimIndex = (workerIndex + i) % m_workerCount;
+		WorkQueue& victim = m_queues[victimIndex];
+		uint32_t begin = 0;
+		uint32_t end = 0;
+
+		{
+			const std::lock_guard lock{victim.mutex};
+
+			if (victim.begin == victim.end)
+			{
+				continue;
+			}
+
+			// Take the back half (at least one item) so that the victim keeps its front items.
+			const uint32_t mid = victim.end - (victim.end - victim.begin + 1) / 2;
+			begin = mid;
+			end = victim.end;
+			victim.end = mid;
+		}
+
+		index = begin;
+
+		if (end - begin > 1)
+		{
+			WorkQueue& queue = m_queues[workerIndex];
+			const std::lock_guard lock{queue.mutex};
+			queue.begin = begin + 1;
+			queue.end = end;
+		}
+
+		return true;
+	}
+
+	return false;
+}
+} // namespace vsgl::cpu
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace vsgl::cpu
+{
+// Work-stealing thread pool for data-parallel loops.
+// Each worker owns a contiguous index range and consumes it from the front. An idle worker steals the back half of another worker's range.
+// The calling thread participates as worker 0.
+class TaskPool
+{
+  public:
+	explicit TaskPool(uint32_t threadCount = 0); // 0 uses all hardware threads.
+	~TaskPool();
+	TaskPool(const TaskPool&) = delete;
+	TaskPool(TaskPool&&) = delete;
+	void operator=(const TaskPool&) = delete;
+	void operator=(TaskPool&&) = delete;
+
+	uint32_t GetWorkerCount() const { return m_workerCount; }
+
+	// Calls func(index, workerIndex) for every index in [0, count) and blocks until all calls have returned.
+	// workerIndex is in [0, GetWorkerCount()) and can be used to address per-worker scratch memory.
+	// A nested call from inside func runs serially on the current worker.
+	template <typename F>
+	void ParallelFor(const uint32_t count, F&& func)
+	{
+		using Function = std::remove_reference_t<F>;
+		Run(count, [](void* context, const uint32_t index, const uint32_t workerIndex) { (*static_cast<Function*>(context))(index, workerIndex); }, const_cast<void*>(static_cast<const void*>(&func)));
+	}
+
+  private:
+	using TaskFunction = void (*)(void* context, uint32_t index, uint32_t workerIndex);
+
+	struct alignas(64) WorkQueue
+	{
+		std::mutex mutex;
+		uint32_t begin = 0;
+		uint32_t end = 0;
+	};
+
+	void Run(uint32_t count, TaskFunction function, void* context);
+	void WorkerMain(uint32_t workerIndex);
+	void Execute(uint32_t workerIndex);
+	bool Pop(uint32_t workerIndex, uint32_t& index);
+	bool Steal(uint32_t workerIndex, uint32_t& index);
+
+	uint32_t m_workerCount = 1;
+	std::vector<std::thread> m_threads;
+	std::unique_ptr<WorkQueue[]> m_queues;
+
+	std::mutex m_runMutex; // Serializes ParallelFor calls from different external threads.
+	std::mutex m_mutex;
+	std::condition_variable m_wakeCondition;
+	std::condition_variable m_doneCondition;
+	uint64_t m_generation = 0;
+	bool m_shutdown = false;
+
+	std::atomic<TaskFunction> m_function = nullptr;
+	std::atomic<void*> m_context = nullptr;
+	std::atomic<uint32_t> m_remaining = 0;
+};
+} // namespace vsgl::cpu
@@ -0,0 +1,169 @@
+#include "Texture.hpp"
+
+#include "BlockCompression.hpp"
+#include "TaskPool.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace vsgl::cpu
+{
+namespace
+{
+// Compressed bytes per job. A 1024x1024 BC7 mip is split into 32 jobs, and mips smaller than this are one job each.
+constexpr size_t BAND_SIZE = 32 * 1024;
+
+struct Band
+{
+	uint32_t mip;
+	uint32_t firstRow; // Of blocks, or of texels for uncompressed formats.
+	uint32_t rowCount;
+};
+
+DXGI_FORMAT GetCopiedFormat(const DXGI_FORMAT format)
+{
+	switch (format)
+	{
+	case DXGI_FORMAT_R8G8B8A8_UNORM:
+	case DXGI_FORMAT_R8G8B8A8_UNORM_SRGB:
+	case DXGI_FORMAT_R8G8B8A8_SNORM:
+	case DXGI_FORMAT_R16G16B16A16_FLOAT:
+		return format;
+
+	case DXGI_FORMAT_B8G8R8A8_UNORM:
+	case DXGI_FORMAT_B8G8R8X8_UNORM:
+		return DXGI_FORMAT_R8G8B8A8_UNORM;
+
+	case DXGI_FORMAT_B8G8R8A8_UNORM_SRGB:
+	case DXGI_FORMAT_B8G8R8X8_UNORM_SRGB:
+		return DXGI_FORMAT_R8G8B8A8_UNORM_SRGB;
+
+	default:
+		return DXGI_FORMAT_UNKNOWN;
+	}
+}
+
+void CopyRow(const DXGI_FORMAT format, const uint8_t* source, const uint32_t width, uint8_t* destination)
+{
+	const bool opaque = format == DXGI_FORMAT_B8G8R8X8_UNORM || format == DXGI_FORMAT_B8G8R8X8_UNORM_SRGB;
+
+	if (format != DXGI_FORMAT_B8G8R8A8_UNORM && format != DXGI_FORMAT_B8G8R8A8_UNORM_SRGB && !opaque)
+	{
+		std::memcpy(destination, source, size_t{width} * (format == DXGI_FORMAT_R16G16B16A16_FLOAT ? 8 : 4));
+		return;
+	}
+
+	for (uint32_t x = 0; x < width; ++x)
+	{
+		uint32_t texel;
+		std::memcpy(&texel, source + size_t{x} * 4, sizeof(texel));
+		texel = (texel & 0xff00ff00u) | ((texel >> 16) & 0xffu) | ((texel & 0xffu) << 16);
+		texel |= opaque ? 0xff000000u : 0;
+		std::memcpy(destination + size_t{x} * 4, &texel, sizeof(texel));
+	}
+}
+} // namespace
+
+DXGI_FORMAT GetDecodedTextureFormat(const DXGI_FORMAT format)
+{
+	return GetBlockSize(format) > 0 ? GetDecodedFormat(format) : GetCopiedFormat(format);
+}
+
+void DecodeTexels(const DXGI_FORMAT format, const uint8_t* source, const size_t sourceRowPitch, const uint32_t x, const uint32_t y, const uint32_t width, const uint32_t height, uint8_t* texels,
+                  const size_t rowPitch)
+{
+	const uint32_t blockSize = GetBlockSize(format);
+
+	if (blockSize > 0)
+	{
+		const uint8_t* blocks = source + size_t{x / 4} * blockSize;
+
+		for (uint32_t row = y / 4; row < (y + height + 3) / 4; ++row)
+		{
+			DecodeBlockRow(format, blocks + row * sourceRowPitch, (width + 3) / 4, texels, rowPitch);
+			texels += 4 * rowPitch;
+		}
+
+		return;
+	}
+
+	const size_t sourceTexelSize = format == DXGI_FORMAT_R16G16B16A16_FLOAT ? 8 : 4;
+
+	for (uint32_t row = y; row < y + height; ++row)
+	{
+		CopyRow(format, source + row * sourceRowPitch + x * sourceTexelSize, width, texels);
+		texels += rowPitch;
+	}
+}
+
+bool Texture::Decode(const uint8_t* ddsData, const size_t ddsDataSize, TaskPool& taskPool)
+{
+	m_mips.clear();
+	m_data.clear();
+
+	DDSTextureInfo info;
+
+	if (!GetDDSTextureInfo(ddsData, ddsDataSize, info) || info.depth > 1)
+	{
+		return false;
+	}
+
+	const uint32_t blockSize = GetBlockSize(info.format);
+	const DXGI_FORMAT format = GetDecodedTextureFormat(info.format);
+
+	if (format == DXGI_FORMAT_UNKNOWN)
+	{
+		return false;
+	}
+
+	m_sourceFormat = info.format;
+	m_format = format;
+	m_texelSize = format == DXGI_FORMAT_R16G16B16A16_FLOAT ? 8 : 4;
+
+	// The source mips of slice 0 and their bands. A band covers about BAND_SIZE bytes of whole rows.
+	const uint32_t blockDimension = blockSize > 0 ? 4 : 1;
+	std::vector<const uint8_t*> sources;
+	std::vector<size_t> sourcePitches;
+	std::vector<Band> bands;
+	const uint8_t* source = info.bitData;
+	size_t decodedSize = 0;
+
+	for (uint32_t mip = 0; mip < info.mipCount; ++mip)
+	{
+		const uint32_t width = std::max(info.width >> mip, 1u);
+		const uint32_t height = std::max(info.height >> mip, 1u);
+		size_t numBytes;
+		size_t rowBytes;
+		size_t numRows;
+		GetSurfaceInfo(width, height, info.format, &numBytes, &rowBytes, &numRows);
+
+		const uint32_t paddedWidth = (width + blockDimension - 1) / blockDimension * blockDimension;
+		const uint32_t paddedHeight = (height + blockDimension - 1) / blockDimension * blockDimension;
+		m_mips.push_back({width, height, size_t{paddedWidth} * m_texelSize, decodedSize});
+		decodedSize += m_mips.back().rowPitch * paddedHeight;
+		sources.push_back(source);
+		sourcePitches.push_back(rowBytes);
+		source += numBytes;
+
+		const uint32_t bandRows = static_cast<uint32_t>(std::max<size_t>(BAND_SIZE / std::max<size_t>(rowBytes, 1), 1));
+
+		for (uint32_t row = 0; row < numRows; row += bandRows)
+		{
+			bands.push_back({mip, row, std::min(bandRows, static_cast<uint32_t>(numRows) - row)});
+		}
+	}
+
+	m_sourceSize = static_cast<size_t>(source - info.bitData);
+	m_data.resize(decodedSize);
+
+	taskPool.ParallelFor(static_cast<uint32_t>(bands.size()), [&](const uint32_t i, uint32_t) {
+		const Band& band = bands[i];
+		const Mip& mip = m_mips[band.mip];
+		const uint32_t y = band.firstRow * blockDimension;
+		const uint32_t height = std::min(band.rowCount * blockDimension, mip.height - y);
+		DecodeTexels(info.format, sources[band.mip], sourcePitches[band.mip], 0, y, mip.width, height, m_data.data() + mip.offset + y * mip.rowPitch, mip.rowPitch);
+	});
+
+	return true;
+}
+} // namespace vsgl::cpu
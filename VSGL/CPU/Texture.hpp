@@ -0,0 +1,58 @@
+#pragma once
+
+#include "../../MiniEngine/Core/DDSFormat.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace vsgl::cpu
+{
+class TaskPool;
+
+// The format that DecodeTexels() writes for a DDS format, or DXGI_FORMAT_UNKNOWN if it cannot be decoded.
+DXGI_FORMAT GetDecodedTextureFormat(DXGI_FORMAT format);
+
+// Decodes the texels [x, x + width) x [y, y + height) of a mip whose rows (of blocks for BC formats) are sourceRowPitch bytes apart, as GetSurfaceInfo()
+// lays them out. For BC formats, x and y are multiples of 4, and the rectangle is extended to whole blocks.
+void DecodeTexels(DXGI_FORMAT format, const uint8_t* source, size_t sourceRowPitch, uint32_t x, uint32_t y, uint32_t width, uint32_t height, uint8_t* texels, size_t rowPitch);
+
+// A DDS texture decoded for the CPU paths: every mip of array slice 0 (face +X of a cube) of a 1D or 2D texture.
+// BC formats are decoded to GetDecodedFormat() (see BlockCompression.hpp), and their mips are padded to whole 4x4 blocks. R8G8B8A8 and R16G16B16A16_FLOAT
+// texels are copied as they are, and B8G8R8A8 and B8G8R8X8 ones are swizzled to R8G8B8A8 (X becomes an opaque alpha).
+class Texture
+{
+  public:
+	struct Mip
+	{
+		uint32_t width;
+		uint32_t height;
+		size_t rowPitch; // Bytes.
+		size_t offset;   // Of the first texel in GetData().
+	};
+
+	// Decodes the mips in parallel, split into bands of block rows so that the small mips keep the workers busy along with the large ones.
+	// Returns false if the file is damaged, is a volume texture or has a format that cannot be decoded.
+	bool Decode(const uint8_t* ddsData, size_t ddsDataSize, TaskPool& taskPool);
+
+	DXGI_FORMAT GetSourceFormat() const { return m_sourceFormat; }
+	DXGI_FORMAT GetFormat() const { return m_format; }
+	uint32_t GetTexelSize() const { return m_texelSize; }
+	uint32_t GetWidth() const { return m_mips.empty() ? 0 : m_mips[0].width; }
+	uint32_t GetHeight() const { return m_mips.empty() ? 0 : m_mips[0].height; }
+	uint32_t GetMipCount() const { return static_cast<uint32_t>(m_mips.size()); }
+	const Mip& GetMip(const uint32_t mip) const { return m_mips[mip]; }
+	const uint8_t* GetTexels(const uint32_t mip) const { return m_data.data() + m_mips[mip].offset; }
+	const uint8_t* GetTexel(const uint32_t mip, const uint32_t x, const uint32_t y) const { return GetTexels(mip) + y * m_mips[mip].rowPitch + size_t{x} * m_texelSize; }
+	size_t GetSourceSize() const { return m_sourceSize; } // Bytes of the mips read from the file.
+	size_t GetDecodedSize() const { return m_data.size(); }
+
+  private:
+	DXGI_FORMAT m_sourceFormat = DXGI_FORMAT_UNKNOWN;
+	DXGI_FORMAT m_format = DXGI_FORMAT_UNKNOWN;
+	uint32_t m_texelSize = 0;
+	size_t m_sourceSize = 0;
+	std::vector<Mip> m_mips;
+	std::vector<uint8_t> m_data;
+};
+} // namespace vsgl::cpu
@@ -0,0 +1,231 @@
+#include "TextureCache.hpp"
+
+#include "BlockCompression.hpp"
+#include "Texture.hpp"
+
+#include <algorithm>
+#include <cstdio>
+
+namespace vsgl::cpu
+{
+const uint8_t* CachedTexture::LoadTile(const uint32_t mip, const uint32_t x, const uint32_t y, std::atomic<Tile*>& slot) const
+{
+	// BC mips are decoded in whole blocks, so their tiles are padded like the mips of Texture.
+	const Mip& level = m_mips[mip];
+	const uint32_t blockDimension = GetBlockSize(m_sourceFormat) > 0 ? 4 : 1;
+	const uint32_t x0 = x / TILE_SIZE * TILE_SIZE;
+	const uint32_t y0 = y / TILE_SIZE * TILE_SIZE;
+	const uint32_t width = std::min(TILE_SIZE, (level.width + blockDimension - 1) / blockDimension * blockDimension - x0);
+	const uint32_t height = std::min(TILE_SIZE, (level.height + blockDimension - 1) / blockDimension * blockDimension - y0);
+
+	Tile* tile = new Tile;
+	tile->rowPitch = size_t{width} * m_texelSize;
+	tile->size = tile->rowPitch * height;
+	tile->texels.reset(new uint8_t[tile->size]);
+	tile->lastUse.store(m_cache->m_frame.load(std::memory_order_relaxed), std::memory_order_relaxed);
+	tile->slot = &slot;
+	DecodeTexels(m_sourceFormat, m_sources[mip], m_sourceRowPitches[mip], x0, y0, width, height, tile->texels.get(), tile->rowPitch);
+
+	Tile* published = nullptr;
+
+	if (slot.compare_exchange_strong(published, tile, std::memory_order_acq_rel, std::memory_order_acquire))
+	{
+		m_cache->Insert(tile);
+		published = tile;
+	}
+	else
+	{
+		// Another thread published the tile first.
+		m_cache->CountDiscardedTile(tile->size);
+		delete tile;
+	}
+
+	return published->texels.get() + (y - y0) * published->rowPitch + size_t{x - x0} * m_texelSize;
+}
+
+TextureCache::TextureCache(const std::string& rootPath, const size_t budget) : m_rootPath(rootPath), m_budget(budget)
+{
+}
+
+TextureCache::~TextureCache()
+{
+	Clear();
+}
+
+CachedTexture* TextureCache::Load(const std::string& fileName, const bool forceSRGB)
+{
+	const std::lock_guard<std::mutex> lock(m_mutex);
+	const std::string key = forceSRGB ? fileName + "_sRGB" : fileName;
+
+	// Failed loads are remembered as well, like the fallback textures of TextureManager.
+	const auto it = m_textures.find(key);
+
+	if (it != m_textures.end())
+	{
+		return it->second.get();
+	}
+
+	std::unique_ptr<CachedTexture>& entry = m_textures[key];
+	auto texture = std::make_unique<CachedTexture>();
+	DDSTextureInfo info;
+
+	if (!texture->m_file.Open(m_rootPath + fileName) || !GetDDSTextureInfo(texture->m_file.GetData(), texture->m_file.GetSize(), info) || info.depth > 1)
+	{
+		std::fprintf(stderr, "Cannot read %s%s.\n", m_rootPath.c_str(), fileName.c_str());
+		return nullptr;
+	}
+
+	texture->m_cache = this;
+	texture->m_sourceFormat = forceSRGB ? MakeSRGB(info.format) : info.format;
+	texture->m_format = GetDecodedTextureFormat(texture->m_sourceFormat);
+
+	if (texture->m_format == DXGI_FORMAT_UNKNOWN)
+	{
+		std::fprintf(stderr, "Cannot decode the format of %s%s.\n", m_rootPath.c_str(), fileName.c_str());
+		return nullptr;
+	}
+
+	texture->m_texelSize = texture->m_format == DXGI_FORMAT_R16G16B16A16_FLOAT ? 8 : 4;
+
+	const uint32_t blockDimension = GetBlockSize(info.format) > 0 ? 4 : 1;
+	const uint8_t* source = info.bitData;
+	uint32_t tileCount = 0;
+
+	for (uint32_t mip = 0; mip < info.mipCount; ++mip)
+	{
+		const uint32_t width = std::max(info.width >> mip, 1u);
+		const uint32_t height = std::max(info.height >> mip, 1u);
+		size_t numBytes;
+		size_t rowBytes;
+		size_t numRows;
+		GetSurfaceInfo(width, height, info.format, &numBytes, &rowBytes, &numRows);
+
+		const uint32_t tileCountX = (width + CachedTexture::TILE_SIZE - 1) / CachedTexture::TILE_SIZE;
+		const uint32_t tileCountY = (height + CachedTexture::TILE_SIZE - 1) / CachedTexture::TILE_SIZE;
+		texture->m_mips.push_back({width, height, tileCountX, tileCount});
+		texture->m_sources.push_back(source);
+		texture->m_sourceRowPitches.push_back(rowBytes);
+		texture->m_decodedSize += size_t{(width + blockDimension - 1) / blockDimension * blockDimension} * ((height + blockDimension - 1) / blockDimension * blockDimension) * texture->m_texelSize;
+		tileCount += tileCountX * tileCountY;
+		source += numBytes;
+	}
+
+	texture->m_tiles = std::make_unique<std::atomic<CachedTexture::Tile*>[]>(tileCount);
+	entry = std::move(texture);
+	return entry.get();
+}
+
+void TextureCache::Insert(CachedTexture::Tile* tile)
+{
+	const std::lock_guard<std::mutex> lock(m_mutex);
+	m_residentTiles.push_back(tile);
+	m_stats.residentBytes += tile->size;
+	++m_stats.decodedTiles;
+	m_stats.decodedBytes += tile->size;
+
+	// Second chance for the tiles used in this frame, which a frame-granular LRU cannot order. If the frame touches more than the budget, the oldest
+	// tiles go anyway. The new tile stays since its texel is about to be read.
+	const uint32_t frame = m_frame.load(std::memory_order_relaxed);
+	size_t secondChances = 0;
+
+	while (m_budget > 0 && m_stats.residentBytes > m_budget && m_residentTiles.size() > 1)
+	{
+		CachedTexture::Tile* oldest = m_residentTiles.front();
+		m_residentTiles.pop_front();
+
+		if (oldest == tile || (oldest->lastUse.load(std::memory_order_relaxed) == frame && secondChances < m_residentTiles.size()))
+		{
+			m_residentTiles.push_back(oldest);
+			++secondChances;
+			continue;
+		}
+
+		Evict(oldest);
+		m_evictedTiles.push_back(oldest);
+		m_evictedBytes += oldest->size;
+	}
+
+	m_stats.peakBytes = std::max(m_stats.peakBytes, m_stats.residentBytes + m_evictedBytes);
+}
+
+void TextureCache::CountDiscardedTile(const size_t size)
+{
+	const std::lock_guard<std::mutex> lock(m_mutex);
+	++m_stats.decodedTiles;
+	m_stats.decodedBytes += size;
+}
+
+void TextureCache::Evict(CachedTexture::Tile* tile)
+{
+	// Only the thread that published the tile and the evicting thread write the slot, and the latter holds the lock.
+	tile->slot->store(nullptr, std::memory_order_release);
+	m_stats.residentBytes -= tile->size;
+	++m_stats.evictedTiles;
+}
+
+void TextureCache::EndFrame()
+{
+	const std::lock_guard<std::mutex> lock(m_mutex);
+
+	for (CachedTexture::Tile* tile : m_evictedTiles)
+	{
+		delete tile;
+	}
+
+	m_evictedTiles.clear();
+	m_evictedBytes = 0;
+
+	// Nothing samples now, so the least recently used tiles are freed right away.
+	std::stable_sort(m_residentTiles.begin(), m_residentTiles.end(),
+	                 [](const CachedTexture::Tile* a, const CachedTexture::Tile* b) { return a->lastUse.load(std::memory_order_relaxed) < b->lastUse.load(std::memory_order_relaxed); });
+
+	while (m_budget > 0 && m_stats.residentBytes > m_budget)
+	{
+		CachedTexture::Tile* oldest = m_residentTiles.front();
+		m_residentTiles.pop_front();
+		Evict(oldest);
+		delete oldest;
+	}
+
+	m_frame.fetch_add(1, std::memory_order_relaxed);
+}
+
+void TextureCache::SetBudget(const size_t budget)
+{
+	const std::lock_guard<std::mutex> lock(m_mutex);
+	m_budget = budget;
+}
+
+TextureCache::Stats TextureCache::GetStats() const
+{
+	const std::lock_guard<std::mutex> lock(m_mutex);
+	return m_stats;
+}
+
+void TextureCache::ResetStats()
+{
+	const std::lock_guard<std::mutex> lock(m_mutex);
+	m_stats = {0, 0, 0, m_stats.residentBytes, m_stats.residentBytes + m_evictedBytes};
+}
+
+void TextureCache::Clear()
+{
+	const std::lock_guard<std::mutex> lock(m_mutex);
+
+	for (CachedTexture::Tile* tile : m_residentTiles)
+	{
+		tile->slot->store(nullptr, std::memory_order_relaxed);
+		delete tile;
+	}
+
+	for (CachedTexture::Tile* tile : m_evictedTiles)
+	{
+		delete tile;
+	}
+
+	m_residentTiles.clear();
+	m_evictedTiles.clear();
+	m_evictedBytes = 0;
+	m_stats.residentBytes = 0;
+}
+} // namespace vsgl::cpu
@@ -0,0 +1,149 @@
+#pragma once
+
+#include "../../MiniEngine/Core/DDSFormat.h"
+#include "../../MiniEngine/Core/MappedFile.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace vsgl::cpu
+{
+class TextureCache;
+
+// A DDS texture whose mips are decoded in TILE_SIZE^2 texel tiles on first touch, for sampling without decoding whole mip chains.
+// Tiles hold texels of GetDecodedTextureFormat() like Texture, so TextureSampler reads either.
+class CachedTexture
+{
+  public:
+	static constexpr uint32_t TILE_SIZE = 64;
+
+	struct Mip
+	{
+		uint32_t width;
+		uint32_t height;
+		uint32_t tileCountX;
+		uint32_t firstTile; // Of the mip in the tiles of the texture, row by row.
+	};
+
+	DXGI_FORMAT GetFormat() const { return m_format; }
+	uint32_t GetTexelSize() const { return m_texelSize; }
+	uint32_t GetWidth() const { return m_mips[0].width; }
+	uint32_t GetHeight() const { return m_mips[0].height; }
+	uint32_t GetMipCount() const { return static_cast<uint32_t>(m_mips.size()); }
+	const Mip& GetMip(const uint32_t mip) const { return m_mips[mip]; }
+	size_t GetDecodedSize() const { return m_decodedSize; } // Of all the tiles.
+
+	// Safe to call from any number of threads. A resident tile is found without locks or shared writes except its use stamp once per frame; a missing one
+	// is decoded by the calling thread. If two threads decode the same tile, the first to publish it wins. The texel stays valid until
+	// TextureCache::EndFrame() even if the tile is evicted meanwhile.
+	const uint8_t* GetTexel(uint32_t mip, uint32_t x, uint32_t y) const;
+
+  private:
+	friend class TextureCache;
+
+	struct Tile
+	{
+		std::unique_ptr<uint8_t[]> texels;
+		size_t rowPitch;
+		size_t size;
+		std::atomic<uint32_t> lastUse; // Frame of TextureCache.
+		std::atomic<Tile*>* slot;      // Of CachedTexture that points to this tile while it is resident.
+	};
+
+	const uint8_t* LoadTile(uint32_t mip, uint32_t x, uint32_t y, std::atomic<Tile*>& slot) const;
+
+	TextureCache* m_cache = nullptr;
+	Utility::MappedFile m_file;
+	DXGI_FORMAT m_sourceFormat = DXGI_FORMAT_UNKNOWN;
+	DXGI_FORMAT m_format = DXGI_FORMAT_UNKNOWN;
+	uint32_t m_texelSize = 0;
+	size_t m_decodedSize = 0;
+	std::vector<Mip> m_mips;
+	std::vector<const uint8_t*> m_sources; // Of the mips in the file.
+	std::vector<size_t> m_sourceRowPitches;
+	std::unique_ptr<std::atomic<Tile*>[]> m_tiles;
+};
+
+// Decoded tiles of DDS textures for the CPU shading path, keyed like TextureManager::s_TextureCache: by file name, with "_sRGB" appended when sRGB is
+// forced. Tiles are evicted in least recently used order, at frame granularity, once the decoded bytes exceed the budget.
+// Eviction only unlinks a tile. Its memory is freed by EndFrame(), which must be called while no thread samples (between the parallel loops that
+// shade), so the memory in use can exceed the budget by the tiles evicted during a frame; GetStats() reports the peak.
+class TextureCache
+{
+  public:
+	struct Stats
+	{
+		uint64_t decodedTiles = 0; // Misses, including the tiles that lost a race to publish.
+		uint64_t decodedBytes = 0;
+		uint64_t evictedTiles = 0;
+		size_t residentBytes = 0;
+		size_t peakBytes = 0; // Resident and evicted but not yet freed.
+	};
+
+	// budget is in bytes of decoded texels, 0 for no limit.
+	explicit TextureCache(const std::string& rootPath = "", size_t budget = 0);
+	~TextureCache();
+	TextureCache(const TextureCache&) = delete;
+	void operator=(const TextureCache&) = delete;
+
+	// Opens the texture on the first request of a key. Returns nullptr if the file cannot be read or its format cannot be decoded.
+	CachedTexture* Load(const std::string& fileName, bool forceSRGB = false);
+
+	// Frees the tiles evicted during the frame, evicts down to the budget and starts the next frame.
+	void EndFrame();
+
+	void SetBudget(size_t budget);
+	Stats GetStats() const;
+	void ResetStats(); // Except the resident bytes.
+
+	// Drops every tile but keeps the textures open.
+	void Clear();
+
+  private:
+	friend class CachedTexture;
+
+	void Insert(CachedTexture::Tile* tile);
+	void CountDiscardedTile(size_t size);
+	void Evict(CachedTexture::Tile* tile);
+
+	std::string m_rootPath;
+	size_t m_budget;
+	std::atomic<uint32_t> m_frame = 1;
+
+	mutable std::mutex m_mutex; // Guards everything below. Taken on misses only.
+	std::map<std::string, std::unique_ptr<CachedTexture>> m_textures;
+	std::deque<CachedTexture::Tile*> m_residentTiles; // Oldest first.
+	std::vector<CachedTexture::Tile*> m_evictedTiles;
+	size_t m_evictedBytes = 0;
+	Stats m_stats;
+};
+
+inline const uint8_t* CachedTexture::GetTexel(const uint32_t mip, const uint32_t x, const uint32_t y) const
+{
+	const Mip& level = m_mips[mip];
+	std::atomic<Tile*>& slot = m_tiles[level.firstTile + (y / TILE_SIZE) * level.tileCountX + x / TILE_SIZE];
+	Tile* tile = slot.load(std::memory_order_acquire);
+
+	if (tile == nullptr)
+	{
+		return LoadTile(mip, x, y, slot);
+	}
+
+	// Only the first use in a frame writes to the tile, so hits do not bounce its cache line between threads.
+	const uint32_t frame = m_cache->m_frame.load(std::memory_order_relaxed);
+
+	if (tile->lastUse.load(std::memory_order_relaxed) != frame)
+	{
+		tile->lastUse.store(frame, std::memory_order_relaxed);
+	}
+
+	return tile->texels.get() + (y % TILE_SIZE) * tile->rowPitch + size_t{x % TILE_SIZE} * m_texelSize;
+}
+} // namespace vsgl::cpu
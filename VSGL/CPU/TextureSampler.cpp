@@ -0,0 +1,188 @@
+#include "TextureSampler.hpp"
+
+#include "Texture.hpp"
+#include "TextureCache.hpp"
+#include "../../MiniEngine/Model/VertexQuantization.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+
+namespace vsgl::cpu
+{
+namespace
+{
+// The sRGB to linear conversion of the 256 values of an 8-bit UNORM_SRGB channel.
+const std::array<float, 256>& GetSRGBTable()
+{
+	static const std::array<float, 256> table = [] {
+		std::array<float, 256> values;
+
+		for (uint32_t i = 0; i < 256; ++i)
+		{
+			const float c = static_cast<float>(i) / 255.0f;
+			values[i] = c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+		}
+
+		return values;
+	}();
+
+	return table;
+}
+
+uint32_t Wrap(const int32_t x, const uint32_t size)
+{
+	const int32_t remainder = x % static_cast<int32_t>(size);
+	return static_cast<uint32_t>(remainder < 0 ? remainder + static_cast<int32_t>(size) : remainder);
+}
+
+Float4 Lerp(const Float4& a, const Float4& b, const float t)
+{
+	return {a.x + (b.x - a.x) * t, a.y + (b.y - a.y) * t, a.z + (b.z - a.z) * t, a.w + (b.w - a.w) * t};
+}
+
+float Length(const Vec2<float>& v, const float width, const float height)
+{
+	return std::sqrt(v.x * width * v.x * width + v.y * height * v.y * height);
+}
+} // namespace
+
+template <typename TextureType>
+TextureSampler<TextureType>::TextureSampler(const TextureType& texture, const SamplerDesc& desc) : m_texture(texture), m_desc(desc)
+{
+}
+
+template <typename TextureType>
+SampleFootprint TextureSampler<TextureType>::GetFootprint(const Vec2<float>& ddx, const Vec2<float>& ddy) const
+{
+	const float width = static_cast<float>(m_texture.GetWidth());
+	const float height = static_cast<float>(m_texture.GetHeight());
+	const float lengthX = Length(ddx, width, height);
+	const float lengthY = Length(ddy, width, height);
+	const float lengthMax = std::max(lengthX, lengthY);
+
+	if (m_desc.filter != TEXTURE_FILTER_ANISOTROPIC)
+	{
+		return {std::log2(lengthMax) + m_desc.mipLODBias, 1, {0.0f, 0.0f}};
+	}
+
+	const float lengthMin = std::min(lengthX, lengthY);
+	const float ratio = lengthMin > 0.0f ? lengthMax / lengthMin : FLT_MAX_F;
+	const uint32_t maxAnisotropy = std::max(m_desc.maxAnisotropy, 1u);
+	const uint32_t probeCount = ratio < static_cast<float>(maxAnisotropy) ? std::max(static_cast<uint32_t>(std::ceil(ratio)), 1u) : maxAnisotropy;
+	const Vec2<float>& axis = lengthX >= lengthY ? ddx : ddy;
+	const float scale = 1.0f / static_cast<float>(probeCount);
+	return {std::log2(lengthMax * scale) + m_desc.mipLODBias, probeCount, {axis.x * scale, axis.y * scale}};
+}
+
+template <typename TextureType>
+uint32_t TextureSampler<TextureType>::GetFetchCount(const SampleFootprint& footprint) const
+{
+	const float lastMip = static_cast<float>(m_texture.GetMipCount() - 1);
+	const bool blendsMips = m_desc.filter != TEXTURE_FILTER_BILINEAR && footprint.lod > 0.0f && footprint.lod < lastMip && footprint.lod != std::floor(footprint.lod);
+	return footprint.probeCount * (blendsMips ? 8 : 4);
+}
+
+template <typename TextureType>
+Float4 TextureSampler<TextureType>::SampleLevel(const Vec2<float>& texcoord, const float lod) const
+{
+	const float lastMip = static_cast<float>(m_texture.GetMipCount() - 1);
+	const float level = std::clamp(std::isnan(lod) ? 0.0f : lod, 0.0f, lastMip);
+
+	if (m_desc.filter == TEXTURE_FILTER_BILINEAR)
+	{
+		return SampleBilinear(static_cast<uint32_t>(level + 0.5f), texcoord);
+	}
+
+	const uint32_t mip = static_cast<uint32_t>(level);
+	const float fraction = level - static_cast<float>(mip);
+	const Float4 sample = SampleBilinear(mip, texcoord);
+	return fraction > 0.0f ? Lerp(sample, SampleBilinear(mip + 1, texcoord), fraction) : sample;
+}
+
+template <typename TextureType>
+Float4 TextureSampler<TextureType>::SampleGrad(const Vec2<float>& texcoord, const Vec2<float>& ddx, const Vec2<float>& ddy) const
+{
+	const SampleFootprint footprint = GetFootprint(ddx, ddy);
+
+	if (footprint.probeCount == 1)
+	{
+		return SampleLevel(texcoord, footprint.lod);
+	}
+
+	// Probes are centered on texcoord.
+	const float first = 0.5f - 0.5f * static_cast<float>(footprint.probeCount);
+	Float4 sum = {0.0f, 0.0f, 0.0f, 0.0f};
+
+	for (uint32_t i = 0; i < footprint.probeCount; ++i)
+	{
+		const float offset = first + static_cast<float>(i);
+		const Float4 sample = SampleLevel({texcoord.x + footprint.step.x * offset, texcoord.y + footprint.step.y * offset}, footprint.lod);
+		sum = {sum.x + sample.x, sum.y + sample.y, sum.z + sample.z, sum.w + sample.w};
+	}
+
+	const float weight = 1.0f / static_cast<float>(footprint.probeCount);
+	return {sum.x * weight, sum.y * weight, sum.z * weight, sum.w * weight};
+}
+
+template <typename TextureType>
+Float4 TextureSampler<TextureType>::Fetch(const uint32_t mip, const uint32_t x, const uint32_t y) const
+{
+	const uint8_t* texel = m_texture.GetTexel(mip, x, y);
+
+	switch (m_texture.GetFormat())
+	{
+	case DXGI_FORMAT_R8G8B8A8_UNORM_SRGB:
+	{
+		const std::array<float, 256>& table = GetSRGBTable();
+		return {table[texel[0]], table[texel[1]], table[texel[2]], static_cast<float>(texel[3]) / 255.0f};
+	}
+
+	case DXGI_FORMAT_R8G8B8A8_SNORM:
+	{
+		const auto convert = [](const uint8_t value) { return std::max(static_cast<float>(static_cast<int8_t>(value)) / 127.0f, -1.0f); };
+		return {convert(texel[0]), convert(texel[1]), convert(texel[2]), convert(texel[3])};
+	}
+
+	case DXGI_FORMAT_R16G16B16A16_FLOAT:
+	{
+		uint16_t halves[4];
+		std::memcpy(halves, texel, sizeof(halves));
+		return {HalfToFloat(halves[0]), HalfToFloat(halves[1]), HalfToFloat(halves[2]), HalfToFloat(halves[3])};
+	}
+
+	default:
+		return {static_cast<float>(texel[0]) / 255.0f, static_cast<float>(texel[1]) / 255.0f, static_cast<float>(texel[2]) / 255.0f, static_cast<float>(texel[3]) / 255.0f};
+	}
+}
+
+template <typename TextureType>
+Float4 TextureSampler<TextureType>::SampleBilinear(const uint32_t mip, const Vec2<float>& texcoord) const
+{
+	const auto& level = m_texture.GetMip(mip);
+
+	// Wrapping the texcoord into [0, 1) first keeps the texel indices small.
+	const float u = (texcoord.x - std::floor(texcoord.x)) * static_cast<float>(level.width) - 0.5f;
+	const float v = (texcoord.y - std::floor(texcoord.y)) * static_cast<float>(level.height) - 0.5f;
+
+	if (!std::isfinite(u) || !std::isfinite(v))
+	{
+		return {0.0f, 0.0f, 0.0f, 0.0f};
+	}
+
+	const float x0 = std::floor(u);
+	const float y0 = std::floor(v);
+	const float fu = u - x0;
+	const float fv = v - y0;
+	const uint32_t xs[2] = {Wrap(static_cast<int32_t>(x0), level.width), Wrap(static_cast<int32_t>(x0) + 1, level.width)};
+	const uint32_t ys[2] = {Wrap(static_cast<int32_t>(y0), level.height), Wrap(static_cast<int32_t>(y0) + 1, level.height)};
+
+	const Float4 top = Lerp(Fetch(mip, xs[0], ys[0]), Fetch(mip, xs[1], ys[0]), fu);
+	const Float4 bottom = Lerp(Fetch(mip, xs[0], ys[1]), Fetch(mip, xs[1], ys[1]), fu);
+	return Lerp(top, bottom, fv);
+}
+
+template class TextureSampler<Texture>;
+template class TextureSampler<CachedTexture>;
+} // namespace vsgl::cpu
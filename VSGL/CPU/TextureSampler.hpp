@@ -0,0 +1,69 @@
+#pragma once
+
+#include "ShadingMath.hpp"
+
+#include <cstdint>
+
+namespace vsgl::cpu
+{
+struct Float4
+{
+	float x;
+	float y;
+	float z;
+	float w;
+};
+
+enum TEXTURE_FILTER : uint8_t
+{
+	TEXTURE_FILTER_BILINEAR,    // D3D12_FILTER_MIN_MAG_LINEAR_MIP_POINT.
+	TEXTURE_FILTER_TRILINEAR,   // D3D12_FILTER_MIN_MAG_MIP_LINEAR.
+	TEXTURE_FILTER_ANISOTROPIC, // D3D12_FILTER_ANISOTROPIC.
+};
+
+// The defaults are those of Graphics::SamplerAnisoWrapDesc. The address mode is always D3D12_TEXTURE_ADDRESS_MODE_WRAP.
+struct SamplerDesc
+{
+	TEXTURE_FILTER filter = TEXTURE_FILTER_ANISOTROPIC;
+	uint32_t maxAnisotropy = 4;
+	float mipLODBias = 0.0f;
+};
+
+// Where SampleGrad() reads the mips: probeCount trilinear probes at the mip level lod, step apart along the major axis of the pixel footprint.
+struct SampleFootprint
+{
+	float lod;
+	uint32_t probeCount;
+	Vec2<float> step;
+};
+
+// Filtered sampling of a Texture or a CachedTexture (the instantiations in TextureSampler.cpp) like Texture2D::SampleLevel() and SampleGrad() in the shaders.
+// Texels are converted to float before filtering: sRGB ones to linear, SNORM ones to [-1, 1] and half floats to float, as the texture units do.
+// Anisotropic filtering follows the approximation of EXT_texture_filter_anisotropic, which is what GPUs implement in some form: up to maxAnisotropy
+// trilinear probes along the longer axis of the footprint, at the mip level of its length divided by the probe count. Results may differ from a GPU,
+// whose footprint approximation and weights are not specified, but the texels it reads per sample are comparable.
+template <typename TextureType>
+class TextureSampler
+{
+  public:
+	explicit TextureSampler(const TextureType& texture, const SamplerDesc& desc = {});
+
+	// The footprint of a pixel whose texcoord derivatives are ddx and ddy.
+	SampleFootprint GetFootprint(const Vec2<float>& ddx, const Vec2<float>& ddy) const;
+
+	// Texels that SampleGrad() reads for a footprint.
+	uint32_t GetFetchCount(const SampleFootprint& footprint) const;
+
+	// lod is clamped to the mips of the texture. MipLODBias does not apply, and the bilinear filter reads the nearest mip.
+	Float4 SampleLevel(const Vec2<float>& texcoord, float lod) const;
+
+	Float4 SampleGrad(const Vec2<float>& texcoord, const Vec2<float>& ddx, const Vec2<float>& ddy) const;
+
+  private:
+	Float4 Fetch(uint32_t mip, uint32_t x, uint32_t y) const;
+	Float4 SampleBilinear(uint32_t mip, const Vec2<float>& texcoord) const;
+
+	const TextureType& m_texture;
+	SamplerDesc m_desc;
+};
+} // namespace vsgl::cpu
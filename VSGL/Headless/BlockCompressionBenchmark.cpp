@@ -0,0 +1,276 @@
+#include "Headless.hpp"
+
+#include "../CPU/BlockCompression.hpp"
+#include "../CPU/TaskPool.hpp"
+#include "../CPU/Texture.hpp"
+#include "../../MiniEngine/Core/MappedFile.h"
+#include "../../MiniEngine/Model/BlockCompressor.h"
+#include "../../MiniEngine/Model/TextureConvert.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <limits>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace vsgl::headless
+{
+namespace
+{
+constexpr const char* DEFAULT_TEXTURES = "../Sponza/textures";
+
+#if defined(__AVX2__)
+constexpr const char* ENCODER_NAME = "AVX2 candidate evaluation";
+#else
+constexpr const char* ENCODER_NAME = "scalar build";
+#endif
+
+// R8G8B8A8 texels of one mip of a DDS file, the input of ConvertToDDS() after DirectXTex has converted the image.
+struct SourceImage
+{
+	uint32_t width;
+	uint32_t height;
+	bool isSRGB;
+	bool isNormalMap;
+	std::vector<uint8_t> texels;
+};
+
+struct Target
+{
+	const char* name;
+	uint32_t flags; // TexConversionFlags besides kSRGB, which the source decides.
+	DXGI_FORMAT format; // Instead of the format of flags, if not UNKNOWN: one that ConvertToDDS() does not choose.
+	bool forNormalMaps;
+	uint32_t channelCount; // Channels that the format keeps, and that the PSNR is measured on.
+};
+
+constexpr Target TARGETS[] = {
+    {"BC1", 0, DXGI_FORMAT_UNKNOWN, false, 3},
+    {"BC3", kPreserveAlpha, DXGI_FORMAT_UNKNOWN, false, 4},
+    {"BC7", kQualityBC, DXGI_FORMAT_UNKNOWN, false, 4},
+    {"BC5", 0, DXGI_FORMAT_BC5_SNORM, true, 2},
+};
+
+// The largest mip of a decoded texture that fits in maxSize x maxSize, as R8G8B8A8_UNORM. SNORM normals are mapped back to UNORM as ConvertToDDS() reads them.
+bool GetSourceImage(const cpu::Texture& texture, const uint32_t maxSize, SourceImage& image)
+{
+	uint32_t mip = 0;
+
+	while (mip + 1 < texture.GetMipCount() && (texture.GetMip(mip).width > maxSize || texture.GetMip(mip).height > maxSize))
+	{
+		++mip;
+	}
+
+	const DXGI_FORMAT format = texture.GetFormat();
+
+	if (format != DXGI_FORMAT_R8G8B8A8_UNORM && format != DXGI_FORMAT_R8G8B8A8_UNORM_SRGB && format != DXGI_FORMAT_R8G8B8A8_SNORM)
+	{
+		return false;
+	}
+
+	image.width = texture.GetMip(mip).width;
+	image.height = texture.GetMip(mip).height;
+	image.isSRGB = format == DXGI_FORMAT_R8G8B8A8_UNORM_SRGB;
+	image.isNormalMap = format == DXGI_FORMAT_R8G8B8A8_SNORM;
+	image.texels.resize(size_t{image.width} * image.height * 4);
+
+	for (uint32_t y = 0; y < image.height; ++y)
+	{
+		for (uint32_t x = 0; x < image.width; ++x)
+		{
+			const uint8_t* source = texture.GetTexel(mip, x, y);
+			uint8_t* texel = &image.texels[(size_t{y} * image.width + x) * 4];
+
+			if (image.isNormalMap)
+			{
+				for (uint32_t c = 0; c < 2; ++c)
+				{
+					const int32_t value = std::max<int32_t>(static_cast<int8_t>(source[c]), -127);
+					texel[c] = static_cast<uint8_t>(std::lround((value + 127) * 255.0f / 254.0f));
+				}
+
+				texel[2] = 255;
+				texel[3] = 255;
+			}
+			else
+			{
+				std::copy(source, source + 4, texel);
+			}
+		}
+	}
+
+	return true;
+}
+
+// Sums the squared errors of the first channelCount channels of the decoded blocks against the source texels, and counts them. BC1 cuts out the texels of
+// alpha below 128, so their colors are not counted.
+std::pair<double, size_t> GetSquaredError(const DXGI_FORMAT format, const SourceImage& image, const std::vector<uint8_t>& blocks, const size_t blockRowPitch,
+                                          const uint32_t channelCount)
+{
+	const bool isSigned = cpu::GetDecodedFormat(format) == DXGI_FORMAT_R8G8B8A8_SNORM;
+	const bool isCutout = format == DXGI_FORMAT_BC1_UNORM || format == DXGI_FORMAT_BC1_UNORM_SRGB;
+	const uint32_t blockColumns = (image.width + 3) / 4;
+	const size_t rowPitch = size_t{blockColumns} * 16;
+	std::vector<uint8_t> decoded(rowPitch * 4);
+	double error = 0.0;
+	size_t count = 0;
+
+	for (uint32_t blockRow = 0; blockRow < (image.height + 3) / 4; ++blockRow)
+	{
+		cpu::DecodeBlockRow(format, blocks.data() + blockRow * blockRowPitch, blockColumns, decoded.data(), rowPitch);
+
+		for (uint32_t y = blockRow * 4; y < std::min(blockRow * 4 + 4, image.height); ++y)
+		{
+			for (uint32_t x = 0; x < image.width; ++x)
+			{
+				const uint8_t* texel = &decoded[(y - blockRow * 4) * rowPitch + size_t{x} * 4];
+				const uint8_t* source = &image.texels[(size_t{y} * image.width + x) * 4];
+
+				if (isCutout && source[3] < 128)
+				{
+					continue;
+				}
+
+				for (uint32_t c = 0; c < channelCount; ++c)
+				{
+					const double value = isSigned ? (std::max<int32_t>(static_cast<int8_t>(texel[c]), -127) + 127) * 255.0 / 254.0 : texel[c];
+					error += (value - source[c]) * (value - source[c]);
+				}
+
+				count += channelCount;
+			}
+		}
+	}
+
+	return {error, count};
+}
+} // namespace
+
+// Encode throughput and PSNR of the block compressor of ConvertToDDS() on the textures of a directory, decoded and reduced to a mip of at most --max-size. Color
+// textures are encoded to BC1, BC3 and BC7, the formats that ConvertToDDS() chooses, and normal maps to BC5_SNORM, which only the compressor supports, in the
+// fast and quality modes, on one thread and on --threads. The sources were block compressed already, so the PSNR is that of re-encoding them, which is
+// higher than that of encoding the original images.
+int RunBlockCompressionBenchmark(const Options& options)
+{
+	const std::filesystem::path directory = options.GetString("textures", DEFAULT_TEXTURES);
+	const uint32_t maxSize = std::max(options.GetUint("max-size", 256), 4u);
+	const uint32_t iterations = std::max(options.GetUint("iterations", 1), 1u);
+	const uint32_t threadCount = options.GetUint("threads", 0) != 0 ? options.GetUint("threads", 0) : std::max(std::thread::hardware_concurrency(), 1u);
+	cpu::TaskPool taskPool{threadCount};
+
+	std::vector<SourceImage> images;
+	std::error_code error;
+
+	for (const std::filesystem::directory_entry& entry : std::filesystem::directory_iterator(directory, error))
+	{
+		std::string extension = entry.path().extension().string();
+		std::transform(extension.begin(), extension.end(), extension.begin(), [](const char c) { return static_cast<char>(std::tolower(static_cast<unsigned char>(c))); });
+
+		if (extension != ".dds")
+		{
+			continue;
+		}
+
+		Utility::MappedFile file;
+		cpu::Texture texture;
+		SourceImage image;
+
+		if (!file.Open(entry.path().string()) || !texture.Decode(file.GetData(), file.GetSize(), taskPool) || !GetSourceImage(texture, maxSize, image))
+		{
+			std::fprintf(stderr, "Skipping %s: cannot decode it to 8-bit texels.\n", entry.path().filename().string().c_str());
+			continue;
+		}
+
+		if (image.width >= 4 && image.height >= 4)
+		{
+			images.push_back(std::move(image));
+		}
+	}
+
+	if (images.empty())
+	{
+		std::fprintf(stderr, "No DDS files in %s. Specify --textures directory.\n", directory.string().c_str());
+		return 1;
+	}
+
+	std::printf("%zu textures in %s, mips of at most %ux%u, encoder: %s, best of %u\n", images.size(), directory.string().c_str(), maxSize, maxSize, ENCODER_NAME, iterations);
+	std::printf("  %-16s %-8s %6s %9s %16s %18s %10s\n", "format", "mode", "files", "Mtexels", "1 thread", (std::to_string(threadCount) + " threads").c_str(), "PSNR");
+
+	for (const Target& target : TARGETS)
+	{
+		std::vector<const SourceImage*> sources;
+		size_t texels = 0;
+
+		for (const SourceImage& image : images)
+		{
+			if (image.isNormalMap == target.forNormalMaps)
+			{
+				sources.push_back(&image);
+				texels += size_t{image.width} * image.height;
+			}
+		}
+
+		if (sources.empty())
+		{
+			continue;
+		}
+
+		for (const BCQuality quality : {BCQuality::kFast, BCQuality::kQuality})
+		{
+			std::vector<DXGI_FORMAT> formats;
+			std::vector<std::vector<uint8_t>> blocks;
+			std::vector<size_t> blockRowPitches;
+
+			for (const SourceImage* image : sources)
+			{
+				formats.push_back(target.format != DXGI_FORMAT_UNKNOWN ? target.format : GetBlockCompressedFormat(target.flags | (image->isSRGB ? kSRGB : 0)));
+				blockRowPitches.push_back(size_t{(image->width + 3) / 4} * cpu::GetBlockSize(formats.back()));
+				blocks.emplace_back(blockRowPitches.back() * ((image->height + 3) / 4));
+			}
+
+			const auto encodeAll = [&](const uint32_t encodeThreads) {
+				double seconds = std::numeric_limits<double>::max();
+
+				for (uint32_t iteration = 0; iteration < iterations; ++iteration)
+				{
+					const Stopwatch stopwatch;
+
+					for (size_t i = 0; i < sources.size(); ++i)
+					{
+						CompressImage(formats[i], sources[i]->texels.data(), size_t{sources[i]->width} * 4, sources[i]->width, sources[i]->height, quality, blocks[i].data(), blockRowPitches[i],
+						              encodeThreads);
+					}
+
+					seconds = std::min(seconds, stopwatch.GetSeconds());
+				}
+
+				return seconds;
+			};
+
+			const double serialSeconds = encodeAll(1);
+			const double parallelSeconds = threadCount > 1 ? encodeAll(threadCount) : serialSeconds;
+			double squaredError = 0.0;
+			size_t errorCount = 0;
+
+			for (size_t i = 0; i < sources.size(); ++i)
+			{
+				const auto [error, count] = GetSquaredError(formats[i], *sources[i], blocks[i], blockRowPitches[i], target.channelCount);
+				squaredError += error;
+				errorCount += count;
+			}
+
+			const double meanSquaredError = squaredError / static_cast<double>(std::max<size_t>(errorCount, 1));
+			const double psnr = meanSquaredError > 0.0 ? 10.0 * std::log10(255.0 * 255.0 / meanSquaredError) : std::numeric_limits<double>::infinity();
+			std::printf("  %-16s %-8s %6zu %9.2f %9.2f Mtex/s %11.2f Mtex/s %7.2f dB\n", target.name, quality == BCQuality::kFast ? "fast" : "quality", sources.size(), texels * 1.0e-6,
+			            texels / serialSeconds * 1.0e-6, texels / parallelSeconds * 1.0e-6, psnr);
+		}
+	}
+
+	return 0;
+}
+} // namespace vsgl::headless
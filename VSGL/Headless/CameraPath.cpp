@@ -0,0 +1,125 @@
+#include "CameraPath.hpp"
+#include "SyntheticScene.hpp"
+
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <limits>
+#include <numbers>
+#include <sstream>
+#include <string>
+
+namespace vsgl::headless
+{
+bool LoadCameraPath(const std::filesystem::path& path, std::vector<CameraPathFrame>& frames)
+{
+	std::ifstream file(path);
+
+	if (!file)
+	{
+		std::fprintf(stderr, "Cannot open %s.\n", path.string().c_str());
+		return false;
+	}
+
+	frames.clear();
+	std::string line;
+	uint32_t lineNumber = 0;
+
+	while (std::getline(file, line))
+	{
+		++lineNumber;
+		std::istringstream stream{line.substr(0, line.find('#'))};
+		float values[12];
+		uint32_t count = 0;
+
+		while (count < 12 && stream >> values[count])
+		{
+			++count;
+		}
+
+		if (count == 0 && stream.eof())
+		{
+			continue;
+		}
+
+		std::string rest;
+
+		if ((count != 6 && count != 12) || (stream >> rest))
+		{
+			std::fprintf(stderr, "%s(%u): expected 6 or 12 numbers.\n", path.string().c_str(), lineNumber);
+			return false;
+		}
+
+		CameraPathFrame& frame = frames.emplace_back();
+		frame.eye = {values[0], values[1], values[2]};
+		frame.target = {values[3], values[4], values[5]};
+		frame.hasSpotlight = count == 12;
+
+		if (frame.hasSpotlight)
+		{
+			frame.spotlightEye = {values[6], values[7], values[8]};
+			frame.spotlightTarget = {values[9], values[10], values[11]};
+		}
+	}
+
+	return true;
+}
+
+bool SaveCameraPath(const std::filesystem::path& path, const std::vector<CameraPathFrame>& frames)
+{
+	std::ofstream file(path);
+	file.precision(std::numeric_limits<float>::max_digits10);
+	file << "# eye.xyz target.xyz [spotlightEye.xyz spotlightTarget.xyz]\n";
+
+	for (const CameraPathFrame& frame : frames)
+	{
+		file << frame.eye.x << ' ' << frame.eye.y << ' ' << frame.eye.z << ' ' << frame.target.x << ' ' << frame.target.y << ' ' << frame.target.z;
+
+		if (frame.hasSpotlight)
+		{
+			file << ' ' << frame.spotlightEye.x << ' ' << frame.spotlightEye.y << ' ' << frame.spotlightEye.z << ' ' << frame.spotlightTarget.x << ' ' << frame.spotlightTarget.y << ' ' << frame.spotlightTarget.z;
+		}
+
+		file << '\n';
+	}
+
+	return file.good();
+}
+
+std::vector<CameraPathFrame> CreateOrbitPath(const SyntheticScene& scene, const uint32_t frameCount)
+{
+	const cpu::Float3 CENTER = {500.0f, 100.0f, 350.0f};
+	constexpr float RADIUS = 1100.0f;
+	constexpr float HEIGHT = 300.0f;
+
+	std::vector<CameraPathFrame> frames(frameCount);
+	const cpu::Float3 spotlightEye = scene.spotlight.GetPosition();
+	const cpu::Float3 spotlightForward = scene.spotlight.GetForwardVec();
+
+	for (uint32_t i = 0; i < frameCount; ++i)
+	{
+		// Half an orbit on the open side of the wall.
+		const float t = (frameCount > 1) ? static_cast<float>(i) / static_cast<float>(frameCount - 1) : 0.0f;
+		const float angle = std::numbers::pi_v<float> * (0.5f + t);
+		CameraPathFrame& frame = frames[i];
+		frame.eye = CENTER + cpu::Float3{std::cos(angle), 0.0f, std::sin(angle)} * RADIUS + cpu::Float3{0.0f, HEIGHT, 0.0f};
+		frame.target = CENTER;
+		frame.hasSpotlight = true;
+		frame.spotlightEye = spotlightEye;
+		frame.spotlightTarget = spotlightEye + spotlightForward + cpu::Float3{0.0f, 0.0f, 0.3f * (t - 0.5f)};
+	}
+
+	return frames;
+}
+
+void SetCameraPathFrame(const CameraPathFrame& frame, SyntheticScene& scene)
+{
+	const cpu::Float3 UP = {0.0f, 1.0f, 0.0f};
+	scene.camera.SetEyeAtUp(frame.eye, frame.target, UP);
+
+	if (frame.hasSpotlight)
+	{
+		scene.spotlight.SetEyeAtUp(frame.spotlightEye, frame.spotlightTarget, UP);
+	}
+}
+} // namespace vsgl::headless
@@ -0,0 +1,31 @@
+#pragma once
+
+#include "../CPU/ShadingMath.hpp"
+
+#include <filesystem>
+#include <vector>
+
+namespace vsgl::headless
+{
+struct SyntheticScene;
+
+// One frame of a camera/spotlight path. A frame without a spotlight keeps the spotlight of the scene.
+struct CameraPathFrame
+{
+	cpu::Float3 eye;
+	cpu::Float3 target;
+	bool hasSpotlight = false;
+	cpu::Float3 spotlightEye;
+	cpu::Float3 spotlightTarget;
+};
+
+// Path file: one frame per line as "eye.xyz target.xyz [spotlightEye.xyz spotlightTarget.xyz]" separated by spaces, with # comments.
+bool LoadCameraPath(const std::filesystem::path& path, std::vector<CameraPathFrame>& frames);
+bool SaveCameraPath(const std::filesystem::path& path, const std::vector<CameraPathFrame>& frames);
+
+// Orbit around the synthetic scene while the spotlight sweeps across the floor.
+std::vector<CameraPathFrame> CreateOrbitPath(const SyntheticScene& scene, uint32_t frameCount);
+
+// Applies a frame to the camera and spotlight of the scene.
+void SetCameraPathFrame(const CameraPathFrame& frame, SyntheticScene& scene);
+} // namespace vsgl::headless
@@ -0,0 +1,315 @@
+#include "Headless.hpp"
+#include "Platform.hpp"
+
+#include "../../MiniEngine/Core/Compression.h"
+#include "../../MiniEngine/Core/FileUtility.h"
+#include "../../MiniEngine/Core/IOThreadPool.h"
+
+#include <zlib.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <future>
+#include <limits>
+#include <string>
+#include <vector>
+
+namespace vsgl::headless
+{
+namespace
+{
+constexpr const char* DEFAULT_TEXTURES = "../Sponza/textures";
+constexpr const char* DEFAULT_MODEL = "../Sponza/sponza_cutout.h3d";
+constexpr double MB = 1024.0 * 1024.0;
+
+struct Asset
+{
+	std::filesystem::path source;
+	std::vector<uint8_t> data;
+};
+
+struct AssetSet
+{
+	const char* name;
+	bool ioThreadPool; // Loaded as TextureManager loads textures, otherwise with ReadFileSync() as LoadModel() loads .mini files.
+	std::vector<Asset> assets;
+	size_t totalBytes = 0;
+};
+
+bool ReadWhole(const std::filesystem::path& path, std::vector<uint8_t>& data)
+{
+	std::ifstream file(path, std::ios::binary | std::ios::ate);
+
+	if (!file)
+	{
+		return false;
+	}
+
+	data.resize(static_cast<size_t>(file.tellg()));
+	file.seekg(0);
+	return static_cast<bool>(file.read(reinterpret_cast<char*>(data.data()), static_cast<std::streamsize>(data.size())));
+}
+
+bool WriteWhole(const std::filesystem::path& path, const std::vector<uint8_t>& data)
+{
+	std::ofstream file(path, std::ios::binary);
+	return static_cast<bool>(file.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size())));
+}
+
+// One gzip member, as the gzip tool writes it. Decompress() reads it as a single stream.
+std::vector<uint8_t> CompressStream(const std::vector<uint8_t>& data, const int level)
+{
+	z_stream stream = {};
+	std::vector<uint8_t> output;
+
+	if (deflateInit2(&stream, level, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+	{
+		return output;
+	}
+
+	output.resize(deflateBound(&stream, static_cast<uLong>(data.size())));
+	stream.next_in = const_cast<uint8_t*>(data.data());
+	stream.avail_in = static_cast<uInt>(data.size());
+	stream.next_out = output.data();
+	stream.avail_out = static_cast<uInt>(output.size());
+	output.resize(deflate(&stream, Z_FINISH) == Z_STREAM_END ? stream.total_out : 0);
+	deflateEnd(&stream);
+	return output;
+}
+
+// The best time of function in milliseconds. check runs untimed after each iteration, and prepare before it. Returns a negative time if a check fails.
+double MeasureBest(const uint32_t iterations, const std::function<void()>& function, const std::function<bool()>& check, const std::function<void()>& prepare = {})
+{
+	double milliseconds = std::numeric_limits<double>::max();
+
+	for (uint32_t iteration = 0; iteration < iterations; ++iteration)
+	{
+		if (prepare)
+		{
+			prepare();
+		}
+
+		const Stopwatch stopwatch;
+		function();
+		milliseconds = std::min(milliseconds, stopwatch.GetMilliseconds());
+
+		if (!check())
+		{
+			return -1.0;
+		}
+	}
+
+	return milliseconds;
+}
+} // namespace
+
+// Compresses the Sponza DDS textures and the H3D model into chunked gzip files and single-stream gzip files. Reports the decompression GB/s of all of them as
+// one blob against the thread count, then the end-to-end load time of each asset kind through the engine's read path, cold and warm, from plain files, from
+// single-stream .gz files and from chunked .gz files: the textures through IOThreadPool::Read() as TextureManager reads them and the model with ReadFileSync()
+// as LoadModel() reads .mini files. The files are written to --directory and removed afterwards. There is no .mini model in the tree; H3D is the model format.
+int RunDecompressionBenchmark(const Options& options)
+{
+	const std::filesystem::path textureDirectory = options.GetString("textures", DEFAULT_TEXTURES);
+	const std::filesystem::path modelPath = options.GetString("model", DEFAULT_MODEL);
+	const std::filesystem::path directory = options.GetString("directory", (std::filesystem::temp_directory_path() / "vsgl_decompression").string());
+	const uint32_t maxThreads = std::max(options.GetUint("max-threads", 16), 1u);
+	const uint32_t iterations = std::max(options.GetUint("iterations", 3), 1u);
+	Utility::IOThreadPool ioThreadPool;
+
+	Utility::CompressionOptions compressionOptions;
+	compressionOptions.ChunkSize = std::max(options.GetUint("chunk-kb", 256), 1u) * 1024;
+	compressionOptions.Level = static_cast<int>(std::min(std::max(options.GetUint("level", 6), 1u), 9u));
+
+	AssetSet sets[] = {{"DDS", true, {}}, {"H3D", false, {}}};
+	std::error_code error;
+
+	for (const auto& entry : std::filesystem::directory_iterator(textureDirectory, error))
+	{
+		std::string extension = entry.path().extension().string();
+		std::transform(extension.begin(), extension.end(), extension.begin(), [](const unsigned char c) { return static_cast<char>(std::tolower(c)); });
+
+		if (extension == ".dds")
+		{
+			sets[0].assets.push_back({entry.path(), {}});
+		}
+	}
+
+	sets[1].assets.push_back({modelPath, {}});
+	std::vector<uint8_t> blob;
+
+	for (AssetSet& set : sets)
+	{
+		for (Asset& asset : set.assets)
+		{
+			if (!ReadWhole(asset.source, asset.data))
+			{
+				std::fprintf(stderr, "Cannot read %s.\n", asset.source.string().c_str());
+				return 1;
+			}
+
+			set.totalBytes += asset.data.size();
+			blob.insert(blob.end(), asset.data.begin(), asset.data.end());
+		}
+	}
+
+	if (sets[0].assets.empty())
+	{
+		std::fprintf(stderr, "No DDS files in %s.\n", textureDirectory.string().c_str());
+		return 1;
+	}
+
+	// Decompression throughput of every asset as one blob.
+	const Stopwatch compressStopwatch;
+	const Utility::FileData chunked = Utility::CompressChunked(blob.data(), blob.size(), compressionOptions);
+	const double compressMilliseconds = compressStopwatch.GetMilliseconds();
+	const std::vector<uint8_t> stream = CompressStream(blob, compressionOptions.Level);
+
+	if (chunked->empty() || stream.empty())
+	{
+		std::fprintf(stderr, "Cannot compress the assets.\n");
+		return 1;
+	}
+
+	std::printf("Decompression of %.1f MB of assets, zlib level %d, %u KB chunks, best of %u\n", blob.size() / MB, compressionOptions.Level,
+	            compressionOptions.ChunkSize / 1024, iterations);
+	std::printf("  chunked: %.1f MB (%.1f%%), compressed in %.0f ms on every core; single stream: %.1f MB (%.1f%%)\n", chunked->size() / MB,
+	            100.0 * chunked->size() / blob.size(), compressMilliseconds, stream.size() / MB, 100.0 * stream.size() / blob.size());
+	std::printf("  %-16s %10s %8s\n", "decoder", "ms", "GB/s");
+
+	const auto printThroughput = [&](const std::string& name, const double milliseconds) {
+		std::printf("  %-16s %10.1f %8.2f\n", name.c_str(), milliseconds, blob.size() / milliseconds * 1.0e-6);
+	};
+	Utility::FileData decompressed;
+	const auto checkBlob = [&] { return *decompressed == blob; };
+	const double streamMilliseconds = MeasureBest(iterations, [&] { decompressed = Utility::Decompress(stream.data(), stream.size()); }, checkBlob);
+
+	if (streamMilliseconds < 0.0)
+	{
+		std::fprintf(stderr, "The single stream decompressed to the wrong contents.\n");
+		return 1;
+	}
+
+	printThroughput("single stream", streamMilliseconds);
+
+	for (uint32_t threadCount = 1; threadCount <= maxThreads; threadCount *= 2)
+	{
+		const double milliseconds = MeasureBest(iterations, [&] { decompressed = Utility::Decompress(chunked->data(), chunked->size(), threadCount); }, checkBlob);
+
+		if (milliseconds < 0.0)
+		{
+			std::fprintf(stderr, "The chunked file decompressed to the wrong contents.\n");
+			return 1;
+		}
+
+		printThroughput("chunked, " + std::to_string(threadCount) + (threadCount == 1 ? " thread" : " threads"), milliseconds);
+	}
+
+	// End-to-end loads of each asset kind. Each directory holds one form of every asset, so the .gz fallback of the reads finds what is there.
+	const char* forms[] = {"plain", "gzip", "chunked"};
+	size_t diskBytes[2][3] = {};
+
+	for (const char* form : forms)
+	{
+		std::filesystem::create_directories(directory / form, error);
+	}
+
+	for (size_t setIndex = 0; setIndex < std::size(sets); ++setIndex)
+	{
+		for (const Asset& asset : sets[setIndex].assets)
+		{
+			const std::vector<uint8_t> gzip = CompressStream(asset.data, compressionOptions.Level);
+			const Utility::FileData chunkedAsset = Utility::CompressChunked(asset.data.data(), asset.data.size(), compressionOptions);
+			const std::filesystem::path fileName = asset.source.filename();
+
+			if (!WriteWhole(directory / "plain" / fileName, asset.data) || !WriteWhole(directory / "gzip" / (fileName.string() + ".gz"), gzip) ||
+			    !WriteWhole(directory / "chunked" / (fileName.string() + ".gz"), *chunkedAsset))
+			{
+				std::fprintf(stderr, "Cannot write the files to %s.\n", directory.string().c_str());
+				std::filesystem::remove_all(directory, error);
+				return 1;
+			}
+
+			diskBytes[setIndex][0] += asset.data.size();
+			diskBytes[setIndex][1] += gzip.size();
+			diskBytes[setIndex][2] += chunkedAsset->size();
+		}
+	}
+
+	const bool canEvict = EvictFromFileCache(directory / "plain" / sets[1].assets[0].source.filename());
+	std::printf("End-to-end loads, best of %u%s\n", iterations, canEvict ? "" : " (the OS cannot evict files from its cache, so cold runs are warm)");
+	int result = 0;
+
+	for (size_t setIndex = 0; setIndex < std::size(sets); ++setIndex)
+	{
+		const AssetSet& set = sets[setIndex];
+		std::printf("%s: %zu files, %.1f MB, %s\n", set.name, set.assets.size(), set.totalBytes / MB,
+		            set.ioThreadPool ? "IOThreadPool::Read()" : "ReadFileSync()");
+		std::printf("  %-8s %10s %10s %10s\n", "form", "disk MB", "cold ms", "warm ms");
+
+		for (size_t form = 0; form < std::size(forms); ++form)
+		{
+			const std::filesystem::path formDirectory = directory / forms[form];
+			std::vector<Utility::ByteArray> loaded(set.assets.size());
+			const auto load = [&] {
+				if (set.ioThreadPool)
+				{
+					std::vector<std::shared_future<Utility::FileData>> reads(set.assets.size());
+
+					for (size_t i = 0; i < set.assets.size(); ++i)
+					{
+						reads[i] = ioThreadPool.Read((formDirectory / set.assets[i].source.filename()).string());
+					}
+
+					for (size_t i = 0; i < set.assets.size(); ++i)
+					{
+						loaded[i] = reads[i].get();
+					}
+				}
+				else
+				{
+					for (size_t i = 0; i < set.assets.size(); ++i)
+					{
+						loaded[i] = Utility::ReadFileSync((formDirectory / set.assets[i].source.filename()).wstring());
+					}
+				}
+			};
+			const auto check = [&] {
+				for (size_t i = 0; i < set.assets.size(); ++i)
+				{
+					if (*loaded[i] != set.assets[i].data)
+					{
+						return false;
+					}
+				}
+
+				return true;
+			};
+			const auto evict = [&] {
+				for (const auto& entry : std::filesystem::directory_iterator(formDirectory, error))
+				{
+					EvictFromFileCache(entry.path());
+				}
+			};
+
+			const double coldMilliseconds = MeasureBest(iterations, load, check, evict);
+			const double warmMilliseconds = MeasureBest(iterations, load, check);
+
+			if (coldMilliseconds < 0.0 || warmMilliseconds < 0.0)
+			{
+				std::fprintf(stderr, "%s %s files were read back wrong.\n", forms[form], set.name);
+				result = 1;
+				continue;
+			}
+
+			std::printf("  %-8s %10.1f %10.2f %10.2f\n", forms[form], diskBytes[setIndex][form] / MB, coldMilliseconds, warmMilliseconds);
+		}
+	}
+
+	std::filesystem::remove_all(directory, error);
+	return result;
+}
+} // namespace vsgl::headless
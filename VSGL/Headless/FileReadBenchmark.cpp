@@ -0,0 +1,249 @@
+#include "Headless.hpp"
+#include "Platform.hpp"
+
+#include "../../MiniEngine/Core/AsyncFileReader.h"
+#include "../../MiniEngine/Core/IOThreadPool.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <future>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace vsgl::headless
+{
+namespace
+{
+constexpr double MB = 1024.0 * 1024.0;
+constexpr size_t PAGE_SIZE = 4096;
+
+struct Workload
+{
+	const char* name;
+	std::vector<std::string> fileNames;
+	size_t totalBytes;
+};
+
+// Writes count files of size bytes of random data, so that no file system can compress or deduplicate them.
+bool WriteFiles(const std::filesystem::path& directory, const char* prefix, const uint32_t count, const size_t size, Workload& workload)
+{
+	std::mt19937_64 random(count * 31 + size);
+	std::vector<uint64_t> data((size + 7) / 8);
+
+	for (uint32_t i = 0; i < count; ++i)
+	{
+		const std::filesystem::path path = directory / (std::string(prefix) + std::to_string(i) + ".bin");
+		std::generate(data.begin(), data.end(), random);
+		std::ofstream file(path, std::ios::binary);
+
+		if (!file.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(size)))
+		{
+			std::fprintf(stderr, "Cannot write %s.\n", path.string().c_str());
+			return false;
+		}
+
+		workload.fileNames.push_back(path.string());
+		workload.totalBytes += size;
+	}
+
+	return true;
+}
+
+// Reads a byte of every page, as a loader that parses the contents would, so that mapped files are paged in like the others are read.
+uint64_t Touch(const uint8_t* data, const size_t size)
+{
+	uint64_t sum = 0;
+
+	for (size_t offset = 0; offset < size; offset += PAGE_SIZE)
+	{
+		sum += data[offset];
+	}
+
+	return sum + size;
+}
+
+// The ReadFileSync() that this replaces: a stat of the name, then a std::ifstream read.
+uint64_t ReadWithIfstream(const Workload& workload)
+{
+	uint64_t sum = 0;
+
+	for (const std::string& fileName : workload.fileNames)
+	{
+		std::error_code error;
+		const uintmax_t size = std::filesystem::file_size(fileName, error);
+		std::ifstream file(fileName, std::ios::binary);
+
+		if (error || !file)
+		{
+			continue;
+		}
+
+		std::vector<uint8_t> data(size);
+		file.read(reinterpret_cast<char*>(data.data()), static_cast<std::streamsize>(data.size()));
+		sum += Touch(data.data(), data.size());
+	}
+
+	return sum;
+}
+
+uint64_t ReadWithOpen(const Workload& workload)
+{
+	uint64_t sum = 0;
+
+	for (const std::string& fileName : workload.fileNames)
+	{
+		const Utility::FileData data = Utility::IOThreadPool::ReadFile(fileName);
+		sum += Touch(data->data(), data->size());
+	}
+
+	return sum;
+}
+
+// One Read() per file, each consumed as it completes in order.
+uint64_t ReadEach(const Workload& workload, Utility::AsyncFileReader& reader, const Utility::FileReadMode mode)
+{
+	std::vector<std::shared_future<Utility::FileBuffer>> results;
+	results.reserve(workload.fileNames.size());
+
+	for (const std::string& fileName : workload.fileNames)
+	{
+		results.push_back(reader.Read(fileName, mode));
+	}
+
+	uint64_t sum = 0;
+
+	for (const std::shared_future<Utility::FileBuffer>& result : results)
+	{
+		sum += Touch(result.get().GetData(), result.get().GetSize());
+	}
+
+	return sum;
+}
+
+uint64_t ReadBatch(const Workload& workload, Utility::AsyncFileReader& reader, const Utility::FileReadMode mode)
+{
+	std::vector<Utility::FileReadRequest> requests;
+	requests.reserve(workload.fileNames.size());
+
+	for (const std::string& fileName : workload.fileNames)
+	{
+		requests.push_back({fileName, mode});
+	}
+
+	uint64_t sum = 0;
+
+	for (const std::shared_future<Utility::FileBuffer>& result : reader.Submit(requests.data(), requests.size()))
+	{
+		sum += Touch(result.get().GetData(), result.get().GetSize());
+	}
+
+	return sum;
+}
+
+// The best time in milliseconds, with the files evicted from the cache before each iteration when cold. Returns a negative time if a read returned the wrong
+// contents.
+double MeasureBest(const Workload& workload, const bool cold, const uint32_t iterations, const uint64_t expectedSum, const std::function<uint64_t(const Workload&)>& read)
+{
+	double milliseconds = std::numeric_limits<double>::max();
+
+	for (uint32_t iteration = 0; iteration < iterations; ++iteration)
+	{
+		if (cold)
+		{
+			for (const std::string& fileName : workload.fileNames)
+			{
+				EvictFromFileCache(fileName);
+			}
+		}
+
+		const Stopwatch stopwatch;
+		const uint64_t sum = read(workload);
+		milliseconds = std::min(milliseconds, stopwatch.GetMilliseconds());
+
+		if (sum != expectedSum)
+		{
+			return -1.0;
+		}
+	}
+
+	return milliseconds;
+}
+} // namespace
+
+// Reads many small files and a few large ones, cold and warm, with the stat and std::ifstream of the old ReadFileSync(), one open and read per file on the
+// calling thread, and AsyncFileReader with one Read() per file, batched submission, unbuffered reads and mapped files. Every read is consumed a byte per page
+// so that mapped files pay for their page faults. The files are written to --directory and removed afterwards.
+int RunFileReadBenchmark(const Options& options)
+{
+	const std::filesystem::path directory = options.GetString("directory", (std::filesystem::temp_directory_path() / "vsgl_file_read").string());
+	const uint32_t smallCount = std::max(options.GetUint("small-count", 2000), 1u);
+	const size_t smallSize = size_t{std::max(options.GetUint("small-kb", 16), 1u)} * 1024;
+	const uint32_t largeCount = std::max(options.GetUint("large-count", 4), 1u);
+	const size_t largeSize = size_t{std::max(options.GetUint("large-mb", 64), 1u)} * 1024 * 1024;
+	const uint32_t threadCount = std::max(options.GetUint("threads", 4), 1u);
+	const uint32_t iterations = std::max(options.GetUint("iterations", 3), 1u);
+
+	std::error_code error;
+	std::filesystem::create_directories(directory, error);
+	Workload workloads[] = {{"small", {}, 0}, {"large", {}, 0}};
+
+	if (error || !WriteFiles(directory, "small", smallCount, smallSize, workloads[0]) || !WriteFiles(directory, "large", largeCount, largeSize, workloads[1]))
+	{
+		std::fprintf(stderr, "Cannot write the files to %s.\n", directory.string().c_str());
+		std::filesystem::remove_all(directory, error);
+		return 1;
+	}
+
+	const bool canEvict = EvictFromFileCache(workloads[0].fileNames[0]);
+	Utility::AsyncFileReader reader(threadCount);
+	using Utility::FileReadMode;
+
+	const struct
+	{
+		const char* name;
+		std::function<uint64_t(const Workload&)> read;
+	} methods[] = {
+	    {"ifstream", ReadWithIfstream},
+	    {"open+read", ReadWithOpen},
+	    {"reader", [&](const Workload& workload) { return ReadEach(workload, reader, FileReadMode::kBuffered); }},
+	    {"batch", [&](const Workload& workload) { return ReadBatch(workload, reader, FileReadMode::kBuffered); }},
+	    {"unbuffered", [&](const Workload& workload) { return ReadBatch(workload, reader, FileReadMode::kUnbuffered); }},
+	    {"mapped", [&](const Workload& workload) { return ReadBatch(workload, reader, FileReadMode::kMapped); }},
+	};
+
+	std::printf("File reads, %u reader threads, best of %u%s\n", threadCount, iterations, canEvict ? "" : " (the OS cannot evict files from its cache, so cold runs are warm)");
+
+	int result = 0;
+
+	for (const Workload& workload : workloads)
+	{
+		const uint64_t expectedSum = ReadWithOpen(workload);
+		std::printf("%s: %zu files, %.1f MB\n", workload.name, workload.fileNames.size(), workload.totalBytes / MB);
+		std::printf("  %-11s %10s %10s %10s %10s\n", "method", "cold ms", "cold MB/s", "warm ms", "warm MB/s");
+
+		for (const auto& method : methods)
+		{
+			const double coldMilliseconds = MeasureBest(workload, true, iterations, expectedSum, method.read);
+			const double warmMilliseconds = MeasureBest(workload, false, iterations, expectedSum, method.read);
+
+			if (coldMilliseconds < 0.0 || warmMilliseconds < 0.0)
+			{
+				std::fprintf(stderr, "%s read the wrong contents.\n", method.name);
+				result = 1;
+				continue;
+			}
+
+			std::printf("  %-11s %10.2f %10.0f %10.2f %10.0f\n", method.name, coldMilliseconds, workload.totalBytes / MB / coldMilliseconds * 1000.0, warmMilliseconds,
+			            workload.totalBytes / MB / warmMilliseconds * 1000.0);
+		}
+	}
+
+	std::filesystem::remove_all(directory, error);
+	return result;
+}
+} // namespace vsgl::headless
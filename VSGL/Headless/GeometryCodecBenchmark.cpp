@@ -0,0 +1,258 @@
+#include "Headless.hpp"
+
+#include "../CPU/TaskPool.hpp"
+#include "../../MiniEngine/Model/GeometryCodec.h"
+#include "../../MiniEngine/Model/H3DData.h"
+#include "../../MiniEngine/Model/IndexOptimizePostTransform.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace vsgl::headless
+{
+namespace
+{
+constexpr const char* DEFAULT_MODELS = "../Sponza/sponza.h3d;../Sponza/sponza_cutout.h3d";
+constexpr uint32_t DEPTH_VERTEX_STRIDE = 12; // float3 position, as the depth-only vertex buffers of opaque meshes in .mini files.
+
+// The geometry blob of a .mini file: per mesh the vertex buffer, the depth-only vertex buffer and the vertex cache optimized index buffer, padded to 4 bytes.
+struct Geometry
+{
+	std::vector<uint8_t> data;
+	std::vector<GeometryRegion> regions;
+};
+
+void AppendRegion(Geometry& geometry, const void* data, const uint32_t size, const uint32_t stride, const GeometryStreamType type)
+{
+	const uint32_t offset = static_cast<uint32_t>(geometry.data.size());
+	geometry.data.resize(offset + ((size + 3) & ~3u));
+	std::memcpy(geometry.data.data() + offset, data, size);
+	geometry.regions.push_back({offset, size, stride, type});
+}
+
+void AppendModel(Geometry& geometry, const H3DData& model)
+{
+	for (uint32_t meshIndex = 0; meshIndex < model.GetMeshCount(); ++meshIndex)
+	{
+		const H3DData::Mesh& mesh = model.GetMesh(meshIndex);
+		const uint8_t* vertices = model.GetVertexData() + mesh.vertexDataByteOffset;
+		AppendRegion(geometry, vertices, mesh.vertexCount * mesh.vertexStride, mesh.vertexStride, GeometryStreamType::kVertex);
+
+		std::vector<uint8_t> depthVertices(mesh.vertexCount * DEPTH_VERTEX_STRIDE);
+		for (uint32_t i = 0; i < mesh.vertexCount; ++i)
+		{
+			std::memcpy(depthVertices.data() + i * DEPTH_VERTEX_STRIDE, vertices + i * mesh.vertexStride, DEPTH_VERTEX_STRIDE);
+		}
+		AppendRegion(geometry, depthVertices.data(), static_cast<uint32_t>(depthVertices.size()), DEPTH_VERTEX_STRIDE, GeometryStreamType::kVertex);
+
+		std::vector<uint16_t> indices(mesh.indexCount);
+		OptimizeFaces(model.GetIndexData() + mesh.indexDataByteOffset / sizeof(uint16_t), mesh.indexCount, indices.data(), 64);
+		AppendRegion(geometry, indices.data(), mesh.indexCount * sizeof(uint16_t), sizeof(uint16_t), GeometryStreamType::kIndex16);
+	}
+}
+
+struct EncodedGeometry
+{
+	std::vector<GeometryChunk> chunks;
+	std::vector<uint8_t> payload;
+};
+
+// As Renderer::SaveModel(): chunks are encoded in parallel and concatenated in order.
+EncodedGeometry Encode(const Geometry& geometry, cpu::TaskPool& taskPool)
+{
+	EncodedGeometry encoded;
+	SplitGeometryChunks(geometry.data.size(), geometry.regions, encoded.chunks);
+
+	std::vector<std::vector<uint8_t>> chunkBytes(encoded.chunks.size());
+	taskPool.ParallelFor(static_cast<uint32_t>(encoded.chunks.size()), [&](const uint32_t i, uint32_t) { EncodeGeometryChunk(encoded.chunks[i], geometry.data.data(), chunkBytes[i]); });
+
+	for (size_t i = 0; i < encoded.chunks.size(); ++i)
+	{
+		encoded.chunks[i].encodedOffset = static_cast<uint32_t>(encoded.payload.size());
+		encoded.chunks[i].encodedSize = static_cast<uint32_t>(chunkBytes[i].size());
+		encoded.payload.insert(encoded.payload.end(), chunkBytes[i].begin(), chunkBytes[i].end());
+	}
+
+	return encoded;
+}
+
+bool Decode(const EncodedGeometry& encoded, uint8_t* geometry, cpu::TaskPool& taskPool)
+{
+	std::atomic<bool> succeeded = true;
+	taskPool.ParallelFor(static_cast<uint32_t>(encoded.chunks.size()), [&](const uint32_t i, uint32_t) {
+		if (!DecodeGeometryChunk(encoded.chunks[i], encoded.payload.data(), encoded.payload.size(), geometry))
+		{
+			succeeded = false;
+		}
+	});
+	return succeeded;
+}
+
+template <typename Function>
+double BestSeconds(const uint32_t iterations, const Function& function)
+{
+	double seconds = std::numeric_limits<double>::max();
+
+	for (uint32_t iteration = 0; iteration < iterations; ++iteration)
+	{
+		const Stopwatch stopwatch;
+		function();
+		seconds = std::min(seconds, stopwatch.GetSeconds());
+	}
+
+	return seconds;
+}
+
+bool WriteFile(const std::filesystem::path& path, const std::vector<const std::vector<uint8_t>*>& parts)
+{
+	std::ofstream file(path, std::ios::binary);
+
+	for (const std::vector<uint8_t>* part : parts)
+	{
+		file.write(reinterpret_cast<const char*>(part->data()), static_cast<std::streamsize>(part->size()));
+	}
+
+	return static_cast<bool>(file);
+}
+
+bool ReadFile(const std::filesystem::path& path, std::vector<uint8_t>& data)
+{
+	std::ifstream file(path, std::ios::binary);
+	data.resize(static_cast<size_t>(std::filesystem::file_size(path)));
+	file.read(reinterpret_cast<char*>(data.data()), static_cast<std::streamsize>(data.size()));
+	return static_cast<bool>(file);
+}
+
+const char* TypeName(const GeometryStreamType type)
+{
+	switch (type)
+	{
+	case GeometryStreamType::kVertex: return "vertices";
+	case GeometryStreamType::kIndex16: return "indices (16-bit)";
+	case GeometryStreamType::kIndex32: return "indices (32-bit)";
+	default: return "raw";
+	}
+}
+} // namespace
+
+// Compresses the geometry blob that the .mini conversion would write for H3D models and reports the compression ratio per stream type, the encode
+// and decode throughput on one and on all threads, and the time to load the blob from a file with and without compression, measured from the page cache
+// and modelled for a disk of --disk-mbps.
+int RunGeometryCodecBenchmark(const Options& options)
+{
+	const uint32_t iterations = std::max(options.GetUint("iterations", 10), 1u);
+	const std::filesystem::path outputDirectory = options.GetString("output", (std::filesystem::temp_directory_path() / "vsgl_geometry_codec").string());
+	cpu::TaskPool serialPool{1};
+	cpu::TaskPool taskPool{options.GetUint("threads", 0)};
+
+	Geometry geometry;
+	std::stringstream paths{options.GetString("models", DEFAULT_MODELS)};
+	std::string path;
+
+	while (std::getline(paths, path, ';'))
+	{
+		H3DData model;
+
+		if (!model.Load(path))
+		{
+			std::fprintf(stderr, "Skipping %s: cannot load the model.\n", path.c_str());
+			continue;
+		}
+
+		AppendModel(geometry, model);
+		std::printf("Loaded %s: %u meshes\n", path.c_str(), model.GetMeshCount());
+	}
+
+	if (geometry.data.empty())
+	{
+		std::fprintf(stderr, "No geometry to compress. Specify --models path[;path...].\n");
+		return 1;
+	}
+
+	EncodedGeometry encoded;
+	const double encodeSeconds = BestSeconds(iterations, [&] { encoded = Encode(geometry, taskPool); });
+
+	std::vector<uint8_t> decoded(geometry.data.size());
+	bool succeeded = true;
+	const double serialSeconds = BestSeconds(iterations, [&] { succeeded &= Decode(encoded, decoded.data(), serialPool); });
+	const double parallelSeconds = BestSeconds(iterations, [&] { succeeded &= Decode(encoded, decoded.data(), taskPool); });
+
+	if (!succeeded || decoded != geometry.data)
+	{
+		std::fprintf(stderr, "The decoded geometry does not match the original.\n");
+		return 1;
+	}
+
+	size_t rawSizes[4] = {};
+	size_t encodedSizes[4] = {};
+
+	for (const GeometryChunk& chunk : encoded.chunks)
+	{
+		rawSizes[chunk.type] += chunk.size;
+		encodedSizes[chunk.type] += chunk.encodedSize;
+	}
+
+	const double rawBytes = static_cast<double>(geometry.data.size());
+	const size_t tableBytes = encoded.chunks.size() * sizeof(GeometryChunk);
+	const double encodedBytes = static_cast<double>(encoded.payload.size() + tableBytes);
+
+	std::printf("%zu chunks, %.2f MB -> %.2f MB with the chunk table (%.2fx smaller)\n", encoded.chunks.size(), rawBytes * 1.0e-6, encodedBytes * 1.0e-6, rawBytes / encodedBytes);
+
+	for (uint32_t type = 0; type < 4; ++type)
+	{
+		if (rawSizes[type] > 0)
+		{
+			std::printf("  %-18s %10zu -> %10zu bytes (%.2fx)\n", TypeName(static_cast<GeometryStreamType>(type)), rawSizes[type], encodedSizes[type], static_cast<double>(rawSizes[type]) / encodedSizes[type]);
+		}
+	}
+
+	std::printf("  %-18s %10.1f MB/s\n", "encode", rawBytes / encodeSeconds * 1.0e-6);
+	std::printf("  %-18s %10.1f MB/s decoded\n", "decode (1 thread)", rawBytes / serialSeconds * 1.0e-6);
+	std::printf("  %-18s %10.1f MB/s decoded on %u threads\n", "decode", rawBytes / parallelSeconds * 1.0e-6, taskPool.GetWorkerCount());
+
+	// Load: read the file and, when compressed, decode it, as Renderer::LoadModel() does into the upload buffer.
+	std::filesystem::create_directories(outputDirectory);
+	const std::filesystem::path rawPath = outputDirectory / "geometry.raw";
+	const std::filesystem::path compressedPath = outputDirectory / "geometry.compressed";
+	std::vector<uint8_t> table(tableBytes);
+	std::memcpy(table.data(), encoded.chunks.data(), tableBytes);
+
+	if (!WriteFile(rawPath, {&geometry.data}) || !WriteFile(compressedPath, {&table, &encoded.payload}))
+	{
+		std::fprintf(stderr, "Cannot write to %s.\n", outputDirectory.string().c_str());
+		return 1;
+	}
+
+	std::vector<uint8_t> file;
+	const double rawLoadSeconds = BestSeconds(iterations, [&] { succeeded &= ReadFile(rawPath, file); });
+	const double compressedLoadSeconds = BestSeconds(iterations, [&] {
+		succeeded &= ReadFile(compressedPath, file);
+		EncodedGeometry loaded;
+		loaded.chunks.resize(encoded.chunks.size());
+		std::memcpy(loaded.chunks.data(), file.data(), tableBytes);
+		loaded.payload.assign(file.begin() + static_cast<ptrdiff_t>(tableBytes), file.end());
+		succeeded &= Decode(loaded, decoded.data(), taskPool);
+	});
+
+	if (!succeeded)
+	{
+		std::fprintf(stderr, "Cannot load the geometry files.\n");
+		return 1;
+	}
+
+	// A cold load reads the file from the disk before decoding it, without overlapping the two.
+	const double diskBytesPerSecond = options.GetFloat("disk-mbps", 500.0f) * 1.0e6;
+	std::printf("Load from the page cache: uncompressed %.2f ms, compressed %.2f ms (%s)\n", rawLoadSeconds * 1000.0, compressedLoadSeconds * 1000.0, outputDirectory.string().c_str());
+	std::printf("Load from a %.0f MB/s disk (modelled): uncompressed %.2f ms, compressed %.2f ms\n", diskBytesPerSecond * 1.0e-6, rawBytes / diskBytesPerSecond * 1000.0,
+	            (encodedBytes / diskBytesPerSecond + parallelSeconds) * 1000.0);
+	return 0;
+}
+} // namespace vsgl::headless
@@ -0,0 +1,296 @@
+#include "Headless.hpp"
+#include "Platform.hpp"
+
+#include "../../MiniEngine/Model/H3DData.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <span>
+#include <vector>
+
+namespace vsgl::headless
+{
+namespace
+{
+using H3D = H3DData;
+
+constexpr double MIB = 1024.0 * 1024.0;
+
+// Baseline that reads every section into heap buffers with std::ifstream, as ModelH3D::LoadH3D() used to.
+struct CopiedH3D
+{
+	H3D::Header header = {};
+	std::vector<H3D::Mesh> meshes;
+	std::vector<H3D::Material> materials;
+	std::vector<uint8_t> vertexData;
+	std::vector<uint16_t> indexData;
+	std::vector<uint8_t> vertexDataDepth;
+	std::vector<uint16_t> indexDataDepth;
+
+	template <typename T>
+	static bool Read(std::ifstream& file, std::vector<T>& data, const size_t byteSize)
+	{
+		data.resize(byteSize / sizeof(T));
+		return file.read(reinterpret_cast<char*>(data.data()), static_cast<std::streamsize>(byteSize)).good() || byteSize == 0;
+	}
+
+	bool Load(const std::filesystem::path& path)
+	{
+		std::ifstream file(path, std::ios::in | std::ios::binary);
+		return file.read(reinterpret_cast<char*>(&header), sizeof(header)) && Read(file, meshes, size_t{header.meshCount} * sizeof(H3D::Mesh)) && Read(file, materials, size_t{header.materialCount} * sizeof(H3D::Material)) &&
+		       Read(file, vertexData, header.vertexDataByteSize) && Read(file, indexData, header.indexDataByteSize) && Read(file, vertexDataDepth, header.vertexDataByteSizeDepth) && Read(file, indexDataDepth, header.indexDataByteSize);
+	}
+};
+
+// Reads every position and index once, as the geometry upload and CPU geometry processing do.
+double TouchGeometry(const std::span<const H3D::Mesh> meshes, const uint8_t* vertexData, const uint16_t* indexData)
+{
+	double sum = 0.0;
+
+	for (const H3D::Mesh& mesh : meshes)
+	{
+		const uint8_t* vertices = vertexData + mesh.vertexDataByteOffset;
+
+		for (uint32_t i = 0; i < mesh.vertexCount; ++i)
+		{
+			float position[3];
+			std::memcpy(position, vertices + size_t{i} * mesh.vertexStride, sizeof(position));
+			sum += position[0] + position[1] + position[2];
+		}
+
+		const uint16_t* indices = indexData + mesh.indexDataByteOffset / sizeof(uint16_t);
+
+		for (uint32_t i = 0; i < mesh.indexCount; ++i)
+		{
+			sum += indices[i];
+		}
+	}
+
+	return sum;
+}
+
+// Writes a synthetic H3D of about the given size made of 255x255-vertex grid meshes with the attribute layout of Sponza.
+bool GenerateH3D(const std::filesystem::path& path, const uint64_t targetByteSize)
+{
+	constexpr uint32_t GRID_SIZE = 255;
+	constexpr uint32_t VERTEX_COUNT = GRID_SIZE * GRID_SIZE;
+	constexpr uint32_t INDEX_COUNT = (GRID_SIZE - 1) * (GRID_SIZE - 1) * 6;
+	constexpr uint32_t VERTEX_STRIDE = 56;
+	constexpr uint32_t VERTEX_STRIDE_DEPTH = 12;
+	constexpr uint64_t MESH_BYTE_SIZE = uint64_t{VERTEX_COUNT} * (VERTEX_STRIDE + VERTEX_STRIDE_DEPTH) + uint64_t{INDEX_COUNT} * sizeof(uint16_t) * 2;
+
+	// The section sizes are 32-bit in the header.
+	const uint32_t meshCount = static_cast<uint32_t>(std::clamp<uint64_t>(targetByteSize / MESH_BYTE_SIZE, 1, std::numeric_limits<uint32_t>::max() / (uint64_t{VERTEX_COUNT} * VERTEX_STRIDE)));
+
+	H3D::Header header = {};
+	header.meshCount = meshCount;
+	header.materialCount = 1;
+	header.vertexDataByteSize = meshCount * VERTEX_COUNT * VERTEX_STRIDE;
+	header.indexDataByteSize = meshCount * INDEX_COUNT * static_cast<uint32_t>(sizeof(uint16_t));
+	header.vertexDataByteSizeDepth = meshCount * VERTEX_COUNT * VERTEX_STRIDE_DEPTH;
+
+	std::vector<H3D::Mesh> meshes(meshCount);
+
+	for (uint32_t meshIndex = 0; meshIndex < meshCount; ++meshIndex)
+	{
+		H3D::Mesh& mesh = meshes[meshIndex];
+		const float x = static_cast<float>(meshIndex % 32) * GRID_SIZE;
+		const float z = static_cast<float>(meshIndex / 32) * GRID_SIZE;
+		mesh.boundingBox = {{x, 0.0f, z, 0.0f}, {x + GRID_SIZE - 1, 0.0f, z + GRID_SIZE - 1, 0.0f}};
+		mesh.attribsEnabled = 0x1F;
+		mesh.attribsEnabledDepth = 0x01;
+		mesh.vertexStride = VERTEX_STRIDE;
+		mesh.vertexStrideDepth = VERTEX_STRIDE_DEPTH;
+		mesh.attrib[H3D::attrib_position] = {0, 0, 3, H3D::attrib_format_float};
+		mesh.attrib[H3D::attrib_texcoord0] = {12, 0, 2, H3D::attrib_format_float};
+		mesh.attrib[H3D::attrib_normal] = {20, 0, 3, H3D::attrib_format_float};
+		mesh.attrib[H3D::attrib_tangent] = {32, 0, 3, H3D::attrib_format_float};
+		mesh.attrib[H3D::attrib_bitangent] = {44, 0, 3, H3D::attrib_format_float};
+		mesh.attribDepth[H3D::attrib_position] = {0, 0, 3, H3D::attrib_format_float};
+		mesh.vertexDataByteOffset = meshIndex * VERTEX_COUNT * VERTEX_STRIDE;
+		mesh.vertexCount = VERTEX_COUNT;
+		mesh.indexDataByteOffset = meshIndex * INDEX_COUNT * static_cast<uint32_t>(sizeof(uint16_t));
+		mesh.indexCount = INDEX_COUNT;
+		mesh.vertexDataByteOffsetDepth = meshIndex * VERTEX_COUNT * VERTEX_STRIDE_DEPTH;
+		mesh.vertexCountDepth = VERTEX_COUNT;
+	}
+
+	H3D::Material material = {};
+	std::fill_n(material.diffuse, 4, 1.0f);
+	material.opacity = 1.0f;
+	std::strcpy(material.name, "synthetic");
+
+	std::ofstream file(path, std::ios::out | std::ios::binary);
+	file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	file.write(reinterpret_cast<const char*>(meshes.data()), static_cast<std::streamsize>(meshes.size() * sizeof(H3D::Mesh)));
+	file.write(reinterpret_cast<const char*>(&material), sizeof(material));
+
+	// The sections are written mesh by mesh to keep the memory footprint of the generator small.
+	std::vector<float> vertices(size_t{VERTEX_COUNT} * VERTEX_STRIDE / sizeof(float));
+	std::vector<uint16_t> indices(INDEX_COUNT);
+
+	for (uint32_t y = 0, i = 0; y + 1 < GRID_SIZE; ++y)
+	{
+		for (uint32_t x = 0; x + 1 < GRID_SIZE; ++x, i += 6)
+		{
+			const uint16_t v = static_cast<uint16_t>(y * GRID_SIZE + x);
+			const uint16_t quad[6] = {v, static_cast<uint16_t>(v + GRID_SIZE), static_cast<uint16_t>(v + 1), static_cast<uint16_t>(v + 1), static_cast<uint16_t>(v + GRID_SIZE), static_cast<uint16_t>(v + GRID_SIZE + 1)};
+			std::copy_n(quad, 6, indices.data() + i);
+		}
+	}
+
+	const auto writeVertices = [&](const uint32_t floatsPerVertex) {
+		for (const H3D::Mesh& mesh : meshes)
+		{
+			for (uint32_t v = 0; v < VERTEX_COUNT; ++v)
+			{
+				const float position[3] = {mesh.boundingBox.min[0] + static_cast<float>(v % GRID_SIZE), 0.0f, mesh.boundingBox.min[2] + static_cast<float>(v / GRID_SIZE)};
+				const float attributes[11] = {static_cast<float>(v % GRID_SIZE) / GRID_SIZE, static_cast<float>(v / GRID_SIZE) / GRID_SIZE, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f};
+				float* vertex = vertices.data() + size_t{v} * floatsPerVertex;
+				std::copy_n(position, 3, vertex);
+				std::copy_n(attributes, floatsPerVertex - 3, vertex + 3);
+			}
+
+			file.write(reinterpret_cast<const char*>(vertices.data()), static_cast<std::streamsize>(size_t{VERTEX_COUNT} * floatsPerVertex * sizeof(float)));
+		}
+	};
+	const auto writeIndices = [&] {
+		for (uint32_t meshIndex = 0; meshIndex < meshCount; ++meshIndex)
+		{
+			file.write(reinterpret_cast<const char*>(indices.data()), static_cast<std::streamsize>(indices.size() * sizeof(uint16_t)));
+		}
+	};
+
+	writeVertices(VERTEX_STRIDE / sizeof(float));
+	writeIndices();
+	writeVertices(VERTEX_STRIDE_DEPTH / sizeof(float));
+	writeIndices();
+	return file.good();
+}
+
+struct LoadResult
+{
+	double loadMilliseconds;
+	double touchMilliseconds;
+	size_t loadResidentBytes;  // Resident set growth by the load.
+	size_t touchResidentBytes; // Resident set growth by the load and the first pass over the geometry.
+	double checksum;
+};
+
+template <typename Loader>
+LoadResult MeasureLoad(const std::filesystem::path& path, Loader&& loader)
+{
+	LoadResult result = {};
+	const size_t residentBytes = GetMemoryUsage().residentBytes;
+	const auto residentGrowth = [&] { return std::max(GetMemoryUsage().residentBytes, residentBytes) - residentBytes; };
+	const Stopwatch stopwatch;
+	auto model = loader(path);
+	result.loadMilliseconds = stopwatch.GetMilliseconds();
+	result.loadResidentBytes = residentGrowth();
+
+	const Stopwatch touchStopwatch;
+	result.checksum = model.Touch();
+	result.touchMilliseconds = touchStopwatch.GetMilliseconds();
+	result.touchResidentBytes = residentGrowth();
+	return result;
+}
+
+struct MappedLoader
+{
+	H3D model;
+	double Touch() const { return TouchGeometry({&model.GetMesh(0), model.GetMeshCount()}, model.GetVertexData(), model.GetIndexData()); }
+};
+
+struct CopiedLoader
+{
+	CopiedH3D model;
+	double Touch() const { return TouchGeometry(model.meshes, model.vertexData.data(), model.indexData.data()); }
+};
+} // namespace
+
+// Cold and warm load time and memory of the memory-mapped H3D loader against the std::ifstream baseline.
+// --generate-mb writes a synthetic H3D of that size to --model first. The peak resident set is that of the whole process; run one loader per process
+// with --loader mapped or --loader copied to compare peaks.
+int RunH3DLoadBenchmark(const Options& options)
+{
+	const std::filesystem::path path = options.GetString("model", "../Sponza/sponza_cutout.h3d");
+	const uint32_t iterations = options.GetUint("iterations", 5);
+	const std::string loaderName = options.GetString("loader", "both");
+
+	if (options.Has("generate-mb"))
+	{
+		const Stopwatch stopwatch;
+
+		if (!GenerateH3D(path, uint64_t{options.GetUint("generate-mb", 2048)} * 1024 * 1024))
+		{
+			std::fprintf(stderr, "Cannot write %s.\n", path.string().c_str());
+			return 1;
+		}
+
+		std::printf("Generated %s in %.1f s\n", path.string().c_str(), stopwatch.GetSeconds());
+	}
+
+	std::error_code error;
+	const uintmax_t fileSize = std::filesystem::file_size(path, error);
+
+	if (error)
+	{
+		std::fprintf(stderr, "Cannot open %s.\n", path.string().c_str());
+		return 1;
+	}
+
+	if (!H3D{}.Load(path.wstring()))
+	{
+		std::fprintf(stderr, "Cannot load %s.\n", path.string().c_str());
+		return 1;
+	}
+
+	const auto loadMapped = [](const std::filesystem::path& modelPath) {
+		MappedLoader loader;
+		loader.model.Load(modelPath.wstring());
+		return loader;
+	};
+	const auto loadCopied = [](const std::filesystem::path& modelPath) {
+		CopiedLoader loader;
+		loader.model.Load(modelPath);
+		return loader;
+	};
+
+	std::printf("H3D load: %s (%.1f MiB)\n", path.string().c_str(), fileSize / MIB);
+	std::printf("  %-8s %-5s %10s %10s %14s %14s\n", "loader", "cache", "load ms", "touch ms", "RSS load MiB", "RSS touch MiB");
+
+	const auto run = [&](const char* name, const auto& loader) {
+		const bool evicted = EvictFromFileCache(path);
+		const LoadResult cold = MeasureLoad(path, loader);
+		LoadResult warm = MeasureLoad(path, loader);
+
+		for (uint32_t i = 1; i < iterations; ++i)
+		{
+			const LoadResult result = MeasureLoad(path, loader);
+			warm = (result.loadMilliseconds + result.touchMilliseconds < warm.loadMilliseconds + warm.touchMilliseconds) ? result : warm;
+		}
+
+		const auto print = [&](const char* cache, const LoadResult& result) { std::printf("  %-8s %-5s %10.3f %10.3f %14.1f %14.1f\n", name, cache, result.loadMilliseconds, result.touchMilliseconds, result.loadResidentBytes / MIB, result.touchResidentBytes / MIB); };
+		print("cold", evicted ? cold : LoadResult{});
+		print("warm", warm);
+		std::printf("%s", evicted ? "" : "  (the OS cannot evict the file from its cache, so the cold row is empty)\n");
+		return cold.checksum == warm.checksum;
+	};
+
+	bool consistent = true;
+	consistent &= (loaderName == "copied") || run("mapped", loadMapped);
+	consistent &= (loaderName == "mapped") || run("copied", loadCopied);
+	std::printf("  peak RSS of the process: %.1f MiB\n", GetMemoryUsage().peakResidentBytes / MIB);
+
+	// CPU geometry processing straight from the mapping. The updated bounds stay in the private copy of the mesh table.
+	H3D model;
+	model.Load(path.wstring());
+	const Stopwatch stopwatch;
+	model.ComputeAllBoundingBoxes();
+	std::printf("  ComputeAllBoundingBoxes: %.3f ms (%u meshes, %u triangles)\n", stopwatch.GetMilliseconds(), model.GetMeshCount(), model.GetTriangleCount());
+	return consistent ? 0 : 1;
+}
+} // namespace vsgl::headless
@@ -0,0 +1,130 @@
+#include "Headless.hpp"
+
+#include "../../MiniEngine/Core/Hash.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <limits>
+#include <random>
+#include <vector>
+
+namespace vsgl::headless
+{
+namespace
+{
+constexpr uint32_t CHECK_VALUE = 0xE3069283; // CRC32C of "123456789".
+constexpr size_t BYTES_PER_RUN = 256 * 1024 * 1024;
+
+// The loop that HashRange() ran where _mm_crc32_u64 was not compiled in: every compiler but MSVC for x64.
+uint64_t HashWords(const void* data, const size_t size, const uint64_t seed)
+{
+	const uint32_t* words = static_cast<const uint32_t*>(data);
+	size_t hash = static_cast<size_t>(seed);
+
+	for (size_t i = 0; i < size / 4; ++i)
+	{
+		hash = 16777619U * hash ^ words[i];
+	}
+
+	return hash;
+}
+
+// Software and hardware CRC32C agree on every length up to a few interleaved blocks, at every alignment.
+bool CheckCrc32c(const std::vector<uint8_t>& data)
+{
+	if (Utility::Crc32c("123456789", 9) != CHECK_VALUE || Utility::Crc32cSoftware("123456789", 9) != CHECK_VALUE)
+	{
+		return false;
+	}
+
+	for (size_t offset = 0; offset < 8; ++offset)
+	{
+		for (size_t size = 0; size < 10000; size += 1 + size / 16)
+		{
+			if (Utility::Crc32c(data.data() + offset, size, 7) != Utility::Crc32cSoftware(data.data() + offset, size, 7))
+			{
+				return false;
+			}
+		}
+	}
+
+	// Continuing a CRC gives the CRC of the whole.
+	return Utility::Crc32c(data.data() + 5000, 5000, Utility::Crc32c(data.data(), 5000)) == Utility::Crc32c(data.data(), 10000);
+}
+
+// The best GB/s of hashing size bytes over and over, each hash seeding the next so that none can be skipped. Every hash is called through a pointer, so they pay
+// the same call overhead at 16 B.
+double MeasureGigabytesPerSecond(const std::vector<uint8_t>& data, const size_t size, const uint32_t iterations, uint64_t (*const hash)(const void*, size_t, uint64_t))
+{
+	const size_t count = std::max<size_t>(BYTES_PER_RUN / size, 1);
+	const size_t offsets = data.size() / size;
+	double seconds = std::numeric_limits<double>::max();
+	uint64_t result = 0;
+
+	for (uint32_t iteration = 0; iteration < iterations; ++iteration)
+	{
+		const Stopwatch stopwatch;
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			result = hash(data.data() + (i % offsets) * size, size, result);
+		}
+
+		seconds = std::min(seconds, stopwatch.GetSeconds());
+	}
+
+	// Keeps the results alive.
+	if (result == 0x123456789ull)
+	{
+		std::printf(" ");
+	}
+
+	return static_cast<double>(count) * size / seconds * 1.0e-9;
+}
+} // namespace
+
+// GB/s of CRC32C as Crc32c() dispatches it and as the software fallback, of the word loop that HashRange() used to fall back to, and of the 64-bit ContentHash
+// (XXH64), over 16 B, 256 B, 4 KB and 1 MB inputs. Checks CRC32C against its check value and the software path first.
+int RunHashBenchmark(const Options& options)
+{
+	const uint32_t iterations = std::max(options.GetUint("iterations", 3), 1u);
+	std::vector<uint8_t> data(8 * 1024 * 1024);
+	std::mt19937 random(1);
+	std::generate(data.begin(), data.end(), [&] { return static_cast<uint8_t>(random()); });
+
+	if (!CheckCrc32c(data))
+	{
+		std::fprintf(stderr, "CRC32C (%s) does not match the software CRC32C or the check value.\n", Utility::GetCrc32cImplementation());
+		return 1;
+	}
+
+	const struct
+	{
+		const char* name;
+		uint64_t (*hash)(const void*, size_t, uint64_t);
+	} hashes[] = {
+	    {"CRC32C", [](const void* p, const size_t n, const uint64_t seed) -> uint64_t { return Utility::Crc32c(p, n, static_cast<uint32_t>(seed)); }},
+	    {"CRC32C software", [](const void* p, const size_t n, const uint64_t seed) -> uint64_t { return Utility::Crc32cSoftware(p, n, static_cast<uint32_t>(seed)); }},
+	    {"word loop", HashWords},
+	    {"XXH64", [](const void* p, const size_t n, const uint64_t seed) -> uint64_t { return Utility::HashBytes(p, n, seed); }},
+	};
+	const size_t sizes[] = {16, 256, 4 * 1024, 1024 * 1024};
+
+	std::printf("Hash GB/s, CRC32C implementation: %s, best of %u\n", Utility::GetCrc32cImplementation(), iterations);
+	std::printf("  %-16s %10s %10s %10s %10s\n", "hash", "16 B", "256 B", "4 KB", "1 MB");
+
+	for (const auto& hash : hashes)
+	{
+		std::printf("  %-16s", hash.name);
+
+		for (const size_t size : sizes)
+		{
+			std::printf(" %10.2f", MeasureGigabytesPerSecond(data, size, iterations, hash.hash));
+		}
+
+		std::printf("\n");
+	}
+
+	return 0;
+}
+} // namespace vsgl::headless
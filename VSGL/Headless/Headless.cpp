@@ -0,0 +1,111 @@
+// Headless driver for the CPU rendering path. It runs without a D3D12 device and builds with MSVC, GCC and Clang.
+// Usage: VSGLHeadless <command> [--option value ...]
+
+#include "Headless.hpp"
+
+#include <cstdio>
+#include <cstring>
+
+namespace vsgl::headless
+{
+Options::Options(const int argc, char** argv)
+{
+	for (int i = 0; i < argc; ++i)
+	{
+		if (std::strncmp(argv[i], "--", 2) != 0)
+		{
+			continue;
+		}
+
+		const bool hasValue = (i + 1 < argc) && (std::strncmp(argv[i + 1], "--", 2) != 0);
+		m_values[argv[i] + 2] = hasValue ? argv[i + 1] : "";
+		i += hasValue ? 1 : 0;
+	}
+}
+
+std::string Options::GetString(const std::string& name, const std::string& defaultValue) const
+{
+	const auto it = m_values.find(name);
+	return (it != m_values.end()) ? it->second : defaultValue;
+}
+
+uint32_t Options::GetUint(const std::string& name, const uint32_t defaultValue) const
+{
+	const auto it = m_values.find(name);
+	return (it != m_values.end()) ? static_cast<uint32_t>(std::strtoul(it->second.c_str(), nullptr, 10)) : defaultValue;
+}
+
+float Options::GetFloat(const std::string& name, const float defaultValue) const
+{
+	const auto it = m_values.find(name);
+	return (it != m_values.end()) ? std::strtof(it->second.c_str(), nullptr) : defaultValue;
+}
+
+namespace
+{
+struct Command
+{
+	const char* name;
+	const char* description;
+	int (*function)(const Options&);
+};
+
+constexpr Command COMMANDS[] = {
+	{"bench-lighting", "CPU deferred LightingPS throughput. --width --height --threads --iterations", RunLightingBenchmark},
+	{"bench-indirect", "Half/quarter-resolution SG lighting cost and error. --width --height --threads --iterations", RunIndirectBenchmark},
+	{"bench-temporal", "Temporal SG lighting cache under camera motion: cost, and relative RMSE while moving and after stopping. --width --height --threads --moving-frames --static-frames --speed", RunTemporalBenchmark},
+	{"bench-shadow", "SIMD depth-only rasterization of the spotlight shadow map. --models --size --threads --iterations", RunShadowBenchmark},
+	{"render-farm", "Frame-parallel batch rendering of a camera/spotlight path to PFM images and timings.csv. --path --frames --save-path --output --width --height --threads --frame-parallel --indirect-downsample --scaling", RunRenderFarm},
+	{"bench-h3d-load", "Cold/warm H3D load time and resident memory, memory-mapped against std::ifstream. --model --generate-mb --iterations --loader", RunH3DLoadBenchmark},
+	{"bench-json", "glTF manifest parse throughput and memory, tape reader against the nlohmann DOM. --gltf --meshes --compact --iterations --parser", RunJsonBenchmark},
+	{"bench-vcache", "Vertex cache optimizer throughput and FIFO ACMR/ATVR for cache sizes 16-64, Forsyth against Tipsify. --model --grid --iterations", RunVertexCacheBenchmark},
+	{"bench-meshlets", "Meshlet build throughput, the triangles rejected by meshlet frustum and cone culling per Sponza view against the back faces in view, and the depth rasterizer with them. --models --cull-back --width --height --iterations --threads", RunMeshletBenchmark},
+	{"bench-vquant", "Quantized vertex format of the H3D float vertices: bytes per vertex, encode and decode throughput and max errors. --models --iterations", RunVertexQuantizationBenchmark},
+	{"bench-geometry-codec", "Lossless compression of the .mini geometry blob: size per stream type, encode/decode throughput and load time with and without it. --models --output --disk-mbps --iterations --threads", RunGeometryCodecBenchmark},
+	{"bench-model-cache", "Incremental model import through the content-hashed cache: full, no-op, all-meshes-cached and single-mesh-change re-import times. --model --cache --iterations --threads", RunModelCacheBenchmark},
+	{"bench-texture-decode", "CPU BC1-BC7 texture decode MB/s per DDS format on 1 and all threads, and bilinear/trilinear/anisotropic sampling rate. --textures --samples --iterations --threads", RunTextureDecodeBenchmark},
+	{"bench-texture-cache", "CPU shading through the tiled texture cache: texel-fetch hit rate, tiles decoded per frame, evictions, peak MB and Mpixels/s per budget against fully decoded textures. --textures --budgets --width --height --frames --threads", RunTextureCacheBenchmark},
+	{"bench-texture-manager", "TextureManager cache with a global mutex against the sharded cache with futures and I/O threads, loading every DDS file from 1-32 threads. --textures --max-threads --io-threads --requests --iterations", RunTextureManagerBenchmark},
+	{"bench-texture-encode", "Block compressor of ConvertToDDS(): BC1/BC3/BC7 for color textures and BC5_SNORM for normal maps, fast and quality modes, Mtexels/s on 1 and all threads and PSNR. --textures --max-size --iterations --threads", RunBlockCompressionBenchmark},
+	{"bench-mip-generation", "CPU mip chains of 4K color, cutout and normal textures with the box and Kaiser filters on 1 and all threads, and luminance, alpha-test coverage and normal length per level without and with linearization, coverage preservation and renormalization. --textures --color --cutout --normal --size --iterations --threads", RunMipGenerationBenchmark},
+	{"bench-texture-streaming", "Time to the first frame with every mip of the Sponza textures against their mip tails, then mips streamed by screen footprint along a camera path through a mock upload sink: update cost and steady-state and peak memory per budget. --models --textures --tail --upload-mb --budgets --frames --width --height", RunTextureStreamingBenchmark},
+	{"bench-file-read", "Many small files and a few large ones, cold and warm: the stat and std::ifstream of the old ReadFileSync(), one open and read per file, and AsyncFileReader with one request per file, batched, unbuffered and mapped, in ms and MB/s. --directory --small-count --small-kb --large-count --large-mb --threads --iterations", RunFileReadBenchmark},
+	{"bench-decompression", "Chunked gzip files of the Sponza DDS textures and H3D model: decompression GB/s against 1 to --max-threads threads and a single gzip stream, and end-to-end load time through IOThreadPool (textures) and ReadFileSync() (model), cold and warm, of plain, single-stream .gz and chunked .gz files. --textures --model --chunk-kb --level --max-threads --iterations --directory", RunDecompressionBenchmark},
+	{"bench-hash", "GB/s of the runtime-dispatched CRC32C, its software fallback, the old word loop of HashRange() and the 64-bit ContentHash (XXH64) at 16 B, 256 B, 4 KB and 1 MB. --iterations", RunHashBenchmark},
+	{"bench-pipeline-cache", "PSO lookups per second from 1-64 threads, 99% hits, through the cache with a global mutex, the sharded cache and the lock-free DeviceObjectCache, PSOs made by a mock device. --psos --lookups --max-threads --create-us --iterations", RunPipelineCacheBenchmark},
+};
+
+void PrintUsage()
+{
+	std::printf("Usage: VSGLHeadless <command> [--option value ...]\n\nCommands:\n");
+
+	for (const Command& command : COMMANDS)
+	{
+		std::printf("  %-24s %s\n", command.name, command.description);
+	}
+}
+} // namespace
+} // namespace vsgl::headless
+
+int main(const int argc, char** argv)
+{
+	using namespace vsgl::headless;
+
+	if (argc < 2)
+	{
+		PrintUsage();
+		return EXIT_FAILURE;
+	}
+
+	for (const Command& command : COMMANDS)
+	{
+		if (std::strcmp(argv[1], command.name) == 0)
+		{
+			return command.function(Options{argc - 2, argv + 2});
+		}
+	}
+
+	std::fprintf(stderr, "Unknown command: %s\n", argv[1]);
+	PrintUsage();
+	return EXIT_FAILURE;
+}
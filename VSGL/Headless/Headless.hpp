@@ -0,0 +1,60 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <unordered_map>
+
+namespace vsgl::headless
+{
+// Parsed "--name value" command-line options.
+class Options
+{
+  public:
+	Options(int argc, char** argv);
+
+	bool Has(const std::string& name) const { return m_values.contains(name); }
+	std::string GetString(const std::string& name, const std::string& defaultValue) const;
+	uint32_t GetUint(const std::string& name, uint32_t defaultValue) const;
+	float GetFloat(const std::string& name, float defaultValue) const;
+
+  private:
+	std::unordered_map<std::string, std::string> m_values;
+};
+
+class Stopwatch
+{
+  public:
+	Stopwatch() : m_start(std::chrono::steady_clock::now()) {}
+	double GetSeconds() const { return std::chrono::duration<double>(std::chrono::steady_clock::now() - m_start).count(); }
+	double GetMilliseconds() const { return GetSeconds() * 1000.0; }
+
+  private:
+	std::chrono::steady_clock::time_point m_start;
+};
+
+// Commands. Each returns the process exit code.
+int RunLightingBenchmark(const Options& options);
+int RunIndirectBenchmark(const Options& options);
+int RunTemporalBenchmark(const Options& options);
+int RunShadowBenchmark(const Options& options);
+int RunRenderFarm(const Options& options);
+int RunH3DLoadBenchmark(const Options& options);
+int RunJsonBenchmark(const Options& options);
+int RunVertexCacheBenchmark(const Options& options);
+int RunMeshletBenchmark(const Options& options);
+int RunVertexQuantizationBenchmark(const Options& options);
+int RunGeometryCodecBenchmark(const Options& options);
+int RunModelCacheBenchmark(const Options& options);
+int RunTextureDecodeBenchmark(const Options& options);
+int RunTextureCacheBenchmark(const Options& options);
+int RunTextureManagerBenchmark(const Options& options);
+int RunBlockCompressionBenchmark(const Options& options);
+int RunMipGenerationBenchmark(const Options& options);
+int RunTextureStreamingBenchmark(const Options& options);
+int RunFileReadBenchmark(const Options& options);
+int RunDecompressionBenchmark(const Options& options);
+int RunHashBenchmark(const Options& options);
+int RunPipelineCacheBenchmark(const Options& options);
+} // namespace vsgl::headless
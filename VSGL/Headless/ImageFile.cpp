@@ -0,0 +1,39 @@
+#include "ImageFile.hpp"
+
+#include <cstdio>
+#include <vector>
+
+namespace vsgl::headless
+{
+bool WritePFM(const std::filesystem::path& path, const cpu::ColorImage& image)
+{
+	const uint32_t width = image.GetWidth();
+	const uint32_t height = image.GetHeight();
+	std::FILE* file = std::fopen(path.string().c_str(), "wb");
+
+	if (file == nullptr)
+	{
+		return false;
+	}
+
+	bool succeeded = std::fprintf(file, "PF\n%u %u\n-1.0\n", width, height) > 0;
+	std::vector<float> row(size_t{width} * 3);
+
+	// PFM stores rows from bottom to top.
+	for (uint32_t i = 0; i < height && succeeded; ++i)
+	{
+		const uint32_t y = height - 1 - i;
+
+		for (uint32_t x = 0; x < width; ++x)
+		{
+			row[x * 3 + 0] = image.channels[0](x, y);
+			row[x * 3 + 1] = image.channels[1](x, y);
+			row[x * 3 + 2] = image.channels[2](x, y);
+		}
+
+		succeeded = std::fwrite(row.data(), sizeof(float), row.size(), file) == row.size();
+	}
+
+	return (std::fclose(file) == 0) && succeeded;
+}
+} // namespace vsgl::headless
@@ -0,0 +1,11 @@
+#pragma once
+
+#include "../CPU/Image.hpp"
+
+#include <filesystem>
+
+namespace vsgl::headless
+{
+// Writes linear radiance as a little-endian Portable Float Map, which keeps the full range for offline comparisons.
+bool WritePFM(const std::filesystem::path& path, const cpu::ColorImage& image);
+} // namespace vsgl::headless
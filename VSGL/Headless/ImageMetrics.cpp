@@ -0,0 +1,51 @@
+#include "ImageMetrics.hpp"
+
+#include <cmath>
+
+namespace vsgl::headless
+{
+namespace
+{
+double Luminance(const cpu::ColorImage& image, const uint32_t x, const uint32_t y)
+{
+	return 0.2126 * image.channels[0](x, y) + 0.7152 * image.channels[1](x, y) + 0.0722 * image.channels[2](x, y);
+}
+} // namespace
+
+double MeanLuminance(const cpu::ColorImage& image)
+{
+	double sum = 0.0;
+
+	for (uint32_t y = 0; y < image.GetHeight(); ++y)
+	{
+		for (uint32_t x = 0; x < image.GetWidth(); ++x)
+		{
+			sum += Luminance(image, x, y);
+		}
+	}
+
+	return sum / (static_cast<double>(image.GetWidth()) * image.GetHeight());
+}
+
+ImageError CompareImages(const cpu::ColorImage& image, const cpu::ColorImage& reference)
+{
+	const double mean = MeanLuminance(reference);
+	const double epsilon = 0.01 * mean; // Avoids dividing by (nearly) black reference pixels.
+	double squaredError = 0.0;
+	double relativeError = 0.0;
+
+	for (uint32_t y = 0; y < reference.GetHeight(); ++y)
+	{
+		for (uint32_t x = 0; x < reference.GetWidth(); ++x)
+		{
+			const double ref = Luminance(reference, x, y);
+			const double error = Luminance(image, x, y) - ref;
+			squaredError += error * error;
+			relativeError += std::abs(error) / (ref + epsilon);
+		}
+	}
+
+	const double pixelCount = static_cast<double>(reference.GetWidth()) * reference.GetHeight();
+	return {std::sqrt(squaredError / pixelCount) / mean, relativeError / pixelCount};
+}
+} // namespace vsgl::headless
@@ -0,0 +1,15 @@
+#pragma once
+
+#include "../CPU/Image.hpp"
+
+namespace vsgl::headless
+{
+struct ImageError
+{
+	double relativeRMSE;      // RMSE of the luminance divided by the mean luminance of the reference.
+	double meanRelativeError; // Mean of |x - ref| / (ref + 0.01 * mean) over the luminance.
+};
+
+double MeanLuminance(const cpu::ColorImage& image);
+ImageError CompareImages(const cpu::ColorImage& image, const cpu::ColorImage& reference);
+} // namespace vsgl::headless
@@ -0,0 +1,69 @@
+#include "Headless.hpp"
+#include "ImageMetrics.hpp"
+#include "SyntheticScene.hpp"
+
+#include "../CPU/DeferredLighting.hpp"
+#include "../CPU/TaskPool.hpp"
+
+#include <cstdio>
+
+namespace vsgl::headless
+{
+// Cost and error of the reduced-resolution SG lighting against the full-resolution one.
+int RunIndirectBenchmark(const Options& options)
+{
+	const uint32_t width = options.GetUint("width", 1920);
+	const uint32_t height = options.GetUint("height", 1080);
+	const uint32_t iterations = options.GetUint("iterations", 10);
+	cpu::TaskPool taskPool{options.GetUint("threads", 0)};
+
+	const SyntheticScene scene = CreateSyntheticScene(width, height);
+	cpu::GBuffer gbuffer;
+	gbuffer.Resize(width, height);
+	RenderGBuffer(taskPool, scene, gbuffer);
+	cpu::Image shadowMap;
+	shadowMap.Resize(2048, 2048);
+	RenderShadowMap(taskPool, scene, shadowMap);
+	const cpu::LightingConstants constants = GetLightingConstants(scene);
+
+	std::printf("Reduced-resolution SG lighting: %ux%u, %u threads\n", width, height, taskPool.GetWorkerCount());
+
+	for (const bool previousSGLighting : {false, true})
+	{
+		std::printf("%s\n", previousSGLighting ? "ASG lighting (previous)" : "SG lighting (current)");
+		cpu::ColorImage reference;
+
+		for (const uint32_t downsample : {1u, 2u, 4u})
+		{
+			cpu::LightingSettings settings;
+			settings.previousSGLighting = previousSGLighting;
+			settings.indirectDownsample = downsample;
+			cpu::DeferredLighting lighting;
+			cpu::ColorImage output;
+			lighting.Shade(taskPool, gbuffer, shadowMap, constants, settings, output); // Warm up.
+
+			const Stopwatch stopwatch;
+
+			for (uint32_t i = 0; i < iterations; ++i)
+			{
+				lighting.Shade(taskPool, gbuffer, shadowMap, constants, settings, output);
+			}
+
+			const double milliseconds = stopwatch.GetMilliseconds() / iterations;
+
+			if (downsample == 1)
+			{
+				reference = output;
+				std::printf("  1/1 resolution %10.3f ms/frame\n", milliseconds);
+			}
+			else
+			{
+				const ImageError error = CompareImages(output, reference);
+				std::printf("  1/%u resolution %10.3f ms/frame  relative RMSE %.5f  mean relative error %.5f\n", downsample, milliseconds, error.relativeRMSE, error.meanRelativeError);
+			}
+		}
+	}
+
+	return 0;
+}
+} // namespace vsgl::headless
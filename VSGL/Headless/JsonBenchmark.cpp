@@ -0,0 +1,359 @@
+#include "Headless.hpp"
+#include "Platform.hpp"
+
+#include "../../MiniEngine/Core/MappedFile.h"
+#include "../../MiniEngine/Model/JsonTape.h"
+#include "../../MiniEngine/Model/json.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace vsgl::headless
+{
+namespace
+{
+constexpr double MIB = 1024.0 * 1024.0;
+
+// A glTF manifest with the section proportions of a large exported scene: per mesh one node, one primitive and four accessors
+// (positions with bounds, normals, texture coordinates and indices), and one material per 16 meshes.
+std::string GenerateManifest(const uint32_t meshCount, const bool compact)
+{
+	const char* newline = compact ? "" : "\n";
+	const char* indent1 = compact ? "" : "  ";
+	const char* indent2 = compact ? "" : "    ";
+	const char* space = compact ? "" : " ";
+	const uint32_t materialCount = std::max(meshCount / 16, 1u);
+	const uint32_t accessorCount = meshCount * 4;
+
+	std::string text;
+	char line[512];
+	const auto append = [&](const char* format, auto... arguments) {
+		std::snprintf(line, sizeof(line), format, arguments...);
+		text += line;
+	};
+	const auto separator = [&](const uint32_t index, const uint32_t count) { text += (index + 1 < count) ? "," : ""; text += newline; };
+
+	append("{%s%s\"asset\":%s{\"version\":%s\"2.0\",%s\"generator\":%s\"VSGLHeadless \\\"bench-json\\\" \\u00e9\"},%s", newline, indent1, space, space, space, space, newline);
+	append("%s\"scene\":%s0,%s%s\"scenes\":%s[{\"nodes\":%s[", indent1, space, newline, indent1, space, space);
+
+	for (uint32_t i = 0; i < meshCount; ++i)
+	{
+		append(i + 1 < meshCount ? "%u," : "%u", i);
+	}
+
+	append("]}],%s%s\"nodes\":%s[%s", newline, indent1, space, newline);
+
+	for (uint32_t i = 0; i < meshCount; ++i)
+	{
+		append("%s{\"name\":%s\"node_%u\",%s\"mesh\":%s%u,%s\"translation\":%s[%.6g,%s0.0,%s%.6g],%s\"rotation\":%s[0.0,%s0.7071068,%s0.0,%s0.7071068]}", indent2, space, i, space, space, i, space, space, (i % 256) * 2.5, space, space,
+		       (i / 256) * -2.5, space, space, space, space, space);
+		separator(i, meshCount);
+	}
+
+	append("%s],%s%s\"meshes\":%s[%s", indent1, newline, indent1, space, newline);
+
+	for (uint32_t i = 0; i < meshCount; ++i)
+	{
+		append("%s{\"primitives\":%s[{\"attributes\":%s{\"POSITION\":%s%u,%s\"NORMAL\":%s%u,%s\"TEXCOORD_0\":%s%u},%s\"indices\":%s%u,%s\"material\":%s%u,%s\"mode\":%s4}]}", indent2, space, space, space, i * 4, space, space, i * 4 + 1, space, space,
+		       i * 4 + 2, space, space, i * 4 + 3, space, space, i % materialCount, space, space);
+		separator(i, meshCount);
+	}
+
+	append("%s],%s%s\"materials\":%s[%s", indent1, newline, indent1, space, newline);
+
+	for (uint32_t i = 0; i < materialCount; ++i)
+	{
+		append("%s{\"name\":%s\"material_%u\",%s\"pbrMetallicRoughness\":%s{\"baseColorFactor\":%s[0.8,%s0.8,%s0.8,%s1.0],%s\"metallicFactor\":%s0.0,%s\"roughnessFactor\":%s0.5},%s\"doubleSided\":%strue}", indent2, space, i, space, space, space, space,
+		       space, space, space, space, space, space, space, space);
+		separator(i, materialCount);
+	}
+
+	append("%s],%s%s\"accessors\":%s[%s", indent1, newline, indent1, space, newline);
+
+	for (uint32_t i = 0; i < accessorCount; ++i)
+	{
+		const uint32_t kind = i % 4;
+		const uint32_t count = 1024 + (i / 4) % 1024;
+
+		if (kind == 0)
+		{
+			append("%s{\"bufferView\":%s%u,%s\"componentType\":%s5126,%s\"count\":%s%u,%s\"type\":%s\"VEC3\",%s\"min\":%s[%.7g,%s-1.25,%s%.7g],%s\"max\":%s[%.7g,%s1.25,%s%.7g]}", indent2, space, i, space, space, space, space, count, space, space,
+			       space, space, (i % 1000) * -0.125, space, space, (i % 777) * -0.5e-3, space, space, (i % 1000) * 0.125, space, space, (i % 777) * 0.5e-3);
+		}
+		else
+		{
+			const char* type = (kind == 1) ? "VEC3" : (kind == 2) ? "VEC2" : "SCALAR";
+			const uint32_t componentType = (kind == 3) ? 5125 : 5126;
+			append("%s{\"bufferView\":%s%u,%s\"byteOffset\":%s%u,%s\"componentType\":%s%u,%s\"count\":%s%u,%s\"type\":%s\"%s\"}", indent2, space, i, space, space, (i % 4) * 16, space, space, componentType, space, space, count * (kind == 3 ? 3 : 1),
+			       space, space, type);
+		}
+
+		separator(i, accessorCount);
+	}
+
+	append("%s],%s%s\"bufferViews\":%s[%s", indent1, newline, indent1, space, newline);
+
+	for (uint32_t i = 0; i < accessorCount; ++i)
+	{
+		append("%s{\"buffer\":%s0,%s\"byteOffset\":%s%u,%s\"byteLength\":%s%u,%s\"target\":%s%u}", indent2, space, space, space, i * 49152u, space, space, 49152u, space, space, (i % 4 == 3) ? 34963u : 34962u);
+		separator(i, accessorCount);
+	}
+
+	append("%s],%s%s\"buffers\":%s[{\"uri\":%s\"scene.bin\",%s\"byteLength\":%s%llu}]%s}%s", indent1, newline, indent1, space, space, space, space, static_cast<unsigned long long>(accessorCount) * 49152u, newline, newline);
+	return text;
+}
+
+// Absent sections read as empty arrays, as in glTF::Asset::Parse().
+const nlohmann::json& GetSection(const nlohmann::json& root, const char* name)
+{
+	static const nlohmann::json EMPTY = nlohmann::json::array();
+	const auto it = root.find(name);
+	return (it != root.end()) ? *it : EMPTY;
+}
+
+// The reads that glTF::Asset::Parse() makes, folded into a checksum so that both readers can be compared.
+double WalkDOM(const nlohmann::json& root)
+{
+	double sum = 0.0;
+
+	for (const nlohmann::json& accessor : GetSection(root, "accessors"))
+	{
+		sum += accessor.at("bufferView").get<double>() + accessor.value("byteOffset", 0.0) + accessor.at("count").get<double>() + accessor.at("componentType").get<double>();
+		sum += static_cast<double>(accessor.at("type").get<std::string>().size());
+
+		if (accessor.contains("min"))
+		{
+			for (const nlohmann::json& value : accessor.at("min"))
+			{
+				sum += value.get<double>();
+			}
+
+			for (const nlohmann::json& value : accessor.at("max"))
+			{
+				sum += value.get<double>();
+			}
+		}
+	}
+
+	for (const nlohmann::json& bufferView : GetSection(root, "bufferViews"))
+	{
+		sum += bufferView.at("buffer").get<double>() + bufferView.value("byteOffset", 0.0) + bufferView.at("byteLength").get<double>() + bufferView.value("target", 0.0);
+	}
+
+	for (const nlohmann::json& mesh : GetSection(root, "meshes"))
+	{
+		for (const nlohmann::json& primitive : mesh.at("primitives"))
+		{
+			const nlohmann::json& attributes = primitive.at("attributes");
+			sum += attributes.at("POSITION").get<double>() + attributes.value("NORMAL", 0.0) + attributes.value("TEXCOORD_0", 0.0) + primitive.value("indices", 0.0) + primitive.value("material", 0.0);
+		}
+	}
+
+	for (const nlohmann::json& material : GetSection(root, "materials"))
+	{
+		const bool hasPBR = material.contains("pbrMetallicRoughness");
+		const nlohmann::json& pbr = hasPBR ? material.at("pbrMetallicRoughness") : material;
+		sum += (hasPBR ? pbr.value("metallicFactor", 1.0) : 1.0) + (hasPBR ? pbr.value("roughnessFactor", 1.0) : 1.0) + (material.value("doubleSided", false) ? 1.0 : 0.0);
+	}
+
+	for (const nlohmann::json& node : GetSection(root, "nodes"))
+	{
+		sum += node.value("mesh", 0.0);
+
+		for (const nlohmann::json& value : GetSection(node, "translation"))
+		{
+			sum += value.get<double>();
+		}
+	}
+
+	return sum;
+}
+
+double WalkTape(const Json::Value root)
+{
+	double sum = 0.0;
+
+	root.Find("accessors").ForEach([&](const Json::Value accessor) {
+		const Json::Value byteOffset = accessor.Find("byteOffset");
+		sum += accessor.Find("bufferView").GetDouble() + (byteOffset.IsValid() ? byteOffset.GetDouble() : 0.0) + accessor.Find("count").GetDouble() + accessor.Find("componentType").GetDouble();
+		sum += static_cast<double>(accessor.Find("type").GetString().size());
+
+		if (accessor.Contains("min"))
+		{
+			accessor.Find("min").ForEach([&](const Json::Value value) { sum += value.GetDouble(); });
+			accessor.Find("max").ForEach([&](const Json::Value value) { sum += value.GetDouble(); });
+		}
+	});
+
+	root.Find("bufferViews").ForEach([&](const Json::Value bufferView) { sum += bufferView.Find("buffer").GetDouble() + bufferView.GetUint32("byteOffset", 0) + bufferView.Find("byteLength").GetDouble() + bufferView.GetUint32("target", 0); });
+
+	root.Find("meshes").ForEach([&](const Json::Value mesh) {
+		mesh.Find("primitives").ForEach([&](const Json::Value primitive) {
+			const Json::Value attributes = primitive.Find("attributes");
+			sum += attributes.Find("POSITION").GetDouble() + attributes.GetUint32("NORMAL", 0) + attributes.GetUint32("TEXCOORD_0", 0) + primitive.GetUint32("indices", 0) + primitive.GetUint32("material", 0);
+		});
+	});
+
+	root.Find("materials").ForEach([&](const Json::Value material) {
+		const Json::Value pbr = material.Find("pbrMetallicRoughness");
+		const Json::Value doubleSided = material.Find("doubleSided");
+		sum += pbr.GetFloat("metallicFactor", 1.0f) + pbr.GetFloat("roughnessFactor", 1.0f) + ((doubleSided.IsValid() && doubleSided.GetBool()) ? 1.0 : 0.0);
+	});
+
+	root.Find("nodes").ForEach([&](const Json::Value node) {
+		sum += node.GetUint32("mesh", 0);
+		node.Find("translation").ForEach([&](const Json::Value value) { sum += value.GetDouble(); });
+	});
+
+	return sum;
+}
+
+struct ParseResult
+{
+	double parseMilliseconds;     // Best of the iterations.
+	double parseWalkMilliseconds; // Best of the iterations.
+	size_t residentBytes;         // Resident set growth while the first document is alive.
+	size_t documentBytes;         // Heap bytes reported by the reader itself, or 0 if it cannot tell.
+	double checksum;
+};
+
+// Parses the text repeatedly and keeps the best times. The memory is measured on the first parse, before the allocator has recycled any freed document.
+template <typename Reader>
+ParseResult MeasureParse(const uint32_t iterations, Reader&& reader)
+{
+	ParseResult result = {1e30, 1e30, 0, 0, 0.0};
+
+	for (uint32_t i = 0; i < iterations; ++i)
+	{
+		const size_t residentBytes = GetMemoryUsage().residentBytes;
+		Stopwatch stopwatch;
+		auto document = reader.Parse();
+		result.parseMilliseconds = std::min(result.parseMilliseconds, stopwatch.GetMilliseconds());
+
+		if (i == 0)
+		{
+			result.residentBytes = std::max(GetMemoryUsage().residentBytes, residentBytes) - residentBytes;
+			result.documentBytes = reader.GetDocumentBytes(document);
+		}
+
+		result.checksum = reader.Walk(document);
+		result.parseWalkMilliseconds = std::min(result.parseWalkMilliseconds, stopwatch.GetMilliseconds());
+	}
+
+	return result;
+}
+
+struct DOMReader
+{
+	const char* begin;
+	const char* end;
+
+	nlohmann::json Parse() const { return nlohmann::json::parse(begin, end); }
+	size_t GetDocumentBytes(const nlohmann::json&) const { return 0; }
+	double Walk(const nlohmann::json& document) const { return WalkDOM(document); }
+};
+
+struct TapeReader
+{
+	const char* begin;
+	const char* end;
+
+	std::unique_ptr<Json::Document> Parse() const
+	{
+		auto document = std::make_unique<Json::Document>();
+
+		if (!document->Parse(begin, end))
+		{
+			std::fprintf(stderr, "JSON error at byte %zu.\n", document->GetErrorOffset());
+		}
+
+		return document;
+	}
+
+	size_t GetDocumentBytes(const std::unique_ptr<Json::Document>& document) const { return document->GetMemoryUsage(); }
+	double Walk(const std::unique_ptr<Json::Document>& document) const { return WalkTape(document->GetRoot()); }
+};
+} // namespace
+
+// Parse throughput and memory of the tape reader used by glTF::Asset against the nlohmann DOM it replaced.
+// Parses --gltf, or else a synthetic manifest of --meshes meshes (four accessors each), pretty-printed unless --compact is given.
+// "parse+walk" adds the reads that glTF::Asset::Parse() makes. As with bench-h3d-load, run one --parser per process to compare peak memory.
+int RunJsonBenchmark(const Options& options)
+{
+	const uint32_t iterations = std::max(options.GetUint("iterations", 5), 1u);
+	const std::string parserName = options.GetString("parser", "both");
+
+	Utility::MappedFile file;
+	std::string generated;
+	const char* begin;
+	const char* end;
+
+	if (options.Has("gltf"))
+	{
+		const std::string path = options.GetString("gltf", "");
+
+		if (!file.Open(path))
+		{
+			std::fprintf(stderr, "Cannot open %s.\n", path.c_str());
+			return 1;
+		}
+
+		begin = reinterpret_cast<const char*>(file.GetData());
+		end = begin + file.GetSize();
+		std::printf("JSON parse: %s (%.1f MiB)\n", path.c_str(), file.GetSize() / MIB);
+	}
+	else
+	{
+		const uint32_t meshCount = options.GetUint("meshes", 50000);
+		generated = GenerateManifest(meshCount, options.Has("compact"));
+		begin = generated.data();
+		end = begin + generated.size();
+		std::printf("JSON parse: synthetic manifest, %u meshes, %u accessors (%.1f MiB)\n", meshCount, meshCount * 4, generated.size() / MIB);
+	}
+
+	// Fault the text in so that neither reader pays for it.
+	[[maybe_unused]] volatile char sink = 0;
+
+	for (const char* p = begin; p < end; p += 4096)
+	{
+		sink = *p;
+	}
+
+	const double megabytes = static_cast<double>(end - begin) / MIB;
+	std::printf("  %-6s %10s %9s %15s %9s %13s %13s\n", "parser", "parse ms", "MiB/s", "parse+walk ms", "MiB/s", "RSS MiB", "document MiB");
+
+	const auto print = [&](const char* name, const ParseResult& result) {
+		std::printf("  %-6s %10.2f %9.1f %15.2f %9.1f %13.1f %13.1f\n", name, result.parseMilliseconds, megabytes / (result.parseMilliseconds / 1000.0), result.parseWalkMilliseconds, megabytes / (result.parseWalkMilliseconds / 1000.0),
+		            result.residentBytes / MIB, result.documentBytes / MIB);
+	};
+
+	// The tape goes first so that it cannot reuse heap pages freed by the DOM.
+	ParseResult tape = {};
+	ParseResult dom = {};
+
+	if (parserName != "dom")
+	{
+		tape = MeasureParse(iterations, TapeReader{begin, end});
+		print("tape", tape);
+	}
+
+	if (parserName != "tape")
+	{
+		dom = MeasureParse(iterations, DOMReader{begin, end});
+		print("dom", dom);
+	}
+
+	std::printf("  peak RSS of the process: %.1f MiB\n", GetMemoryUsage().peakResidentBytes / MIB);
+
+	if (parserName == "both" && tape.checksum != dom.checksum)
+	{
+		std::fprintf(stderr, "The readers disagree: %.17g (tape) != %.17g (dom).\n", tape.checksum, dom.checksum);
+		return 1;
+	}
+
+	return 0;
+}
+} // namespace vsgl::headless
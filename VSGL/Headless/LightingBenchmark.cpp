@@ -0,0 +1,53 @@
+#include "Headless.hpp"
+#include "ImageMetrics.hpp"
+#include "SyntheticScene.hpp"
+
+#include "../CPU/DeferredLighting.hpp"
+#include "../CPU/TaskPool.hpp"
+
+#include <cstdio>
+
+namespace vsgl::headless
+{
+int RunLightingBenchmark(const Options& options)
+{
+	const uint32_t width = options.GetUint("width", 1920);
+	const uint32_t height = options.GetUint("height", 1080);
+	const uint32_t iterations = options.GetUint("iterations", 20);
+	cpu::TaskPool taskPool{options.GetUint("threads", 0)};
+
+	const SyntheticScene scene = CreateSyntheticScene(width, height);
+	cpu::GBuffer gbuffer;
+	gbuffer.Resize(width, height);
+	RenderGBuffer(taskPool, scene, gbuffer);
+	cpu::Image shadowMap;
+	shadowMap.Resize(2048, 2048);
+	RenderShadowMap(taskPool, scene, shadowMap);
+	const cpu::LightingConstants constants = GetLightingConstants(scene);
+
+	std::printf("CPU deferred lighting: %ux%u, %u threads, SIMD width %u%s\n", width, height, taskPool.GetWorkerCount(), cpu::SIMD_WIDTH, VSGL_SIMD_AVX2 ? " (AVX2)" : " (scalar fallback)");
+
+	cpu::DeferredLighting lighting;
+
+	for (const bool previousSGLighting : {false, true})
+	{
+		cpu::LightingSettings settings;
+		settings.previousSGLighting = previousSGLighting;
+		cpu::ColorImage output;
+		lighting.Shade(taskPool, gbuffer, shadowMap, constants, settings, output); // Warm up.
+
+		const Stopwatch stopwatch;
+
+		for (uint32_t i = 0; i < iterations; ++i)
+		{
+			lighting.Shade(taskPool, gbuffer, shadowMap, constants, settings, output);
+		}
+
+		const double seconds = stopwatch.GetSeconds() / iterations;
+		const double mpixels = static_cast<double>(width) * height / seconds * 1e-6;
+		std::printf("  %-28s %8.3f ms/frame %9.2f Mpixels/s  (mean luminance %.5f)\n", previousSGLighting ? "ASG lighting (previous)" : "SG lighting (current)", seconds * 1000.0, mpixels, MeanLuminance(output));
+	}
+
+	return 0;
+}
+} // namespace vsgl::headless
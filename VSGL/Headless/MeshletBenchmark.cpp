@@ -0,0 +1,315 @@
+#include "Headless.hpp"
+#include "SyntheticScene.hpp"
+
+#include "../../MiniEngine/Model/H3DData.h"
+#include "../../MiniEngine/Model/IndexOptimizePostTransform.h"
+#include "../../MiniEngine/Model/Meshlet.h"
+#include "../CPU/DepthRasterizer.hpp"
+#include "../CPU/TaskPool.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <numbers>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace vsgl::headless
+{
+namespace
+{
+// Same models as ModelViewer. The opaque model is drawn with Graphics::RasterizerShadow and the cutout model with RasterizerShadowTwoSided.
+constexpr const char* DEFAULT_MODELS = "../Sponza/sponza.h3d;../Sponza/sponza_cutout.h3d";
+
+// Directions around each camera position.
+constexpr uint32_t YAW_COUNT = 8;
+
+// A mesh as OptimizeMesh() writes it to a .mini file: vertex cache optimized indices and their meshlets.
+struct ClusteredMesh
+{
+	const uint8_t* vertices;
+	uint32_t vertexStride;
+	uint32_t vertexCount;
+	std::vector<uint16_t> indices;
+	std::vector<Meshlet> meshlets;
+	cpu::CULL_MODE cullMode;
+};
+
+struct View
+{
+	std::string name;
+	cpu::Camera camera;
+};
+
+struct CullStatistics
+{
+	size_t frustumTriangles = 0;  // In meshlets outside the frustum.
+	size_t coneTriangles = 0;     // In meshlets inside the frustum that face away.
+	size_t backfaceTriangles = 0; // Facing away one by one, in the draws that cull back faces.
+	size_t visibleBackfaceTriangles = 0; // The same in meshlets inside the frustum: the most that cones could reject.
+	size_t coneErrors = 0;        // Triangles rejected by a cone that face the eye.
+};
+
+cpu::Float3 LoadPosition(const ClusteredMesh& mesh, const uint32_t index)
+{
+	cpu::Float3 p;
+	std::memcpy(&p, mesh.vertices + size_t{index} * mesh.vertexStride, sizeof(p));
+	return p;
+}
+
+// Counterclockwise front faces: the eye is in front of a triangle when it is on the side that Cross(p1 - p0, p2 - p0) points to.
+bool IsTriangleBackfacing(const ClusteredMesh& mesh, const uint16_t* triangle, const cpu::Float3& eye)
+{
+	const cpu::Float3 p0 = LoadPosition(mesh, triangle[0]);
+	const cpu::Float3 normal = cpu::Cross(LoadPosition(mesh, triangle[1]) - p0, LoadPosition(mesh, triangle[2]) - p0);
+	return cpu::Dot(p0 - eye, normal) > 0.0f;
+}
+
+CullStatistics CullMeshlets(const std::vector<ClusteredMesh>& meshes, const cpu::Camera& camera)
+{
+	const cpu::MeshletCuller culler{camera.GetViewProjMatrix()};
+	const cpu::Float3& eye = camera.GetPosition();
+	CullStatistics statistics;
+
+	for (const ClusteredMesh& mesh : meshes)
+	{
+		for (const Meshlet& meshlet : mesh.meshlets)
+		{
+			const uint16_t* triangles = mesh.indices.data() + size_t{meshlet.startTriangle} * 3;
+
+			const bool outsideFrustum = culler.IsOutsideFrustum(meshlet);
+
+			if (mesh.cullMode == cpu::CULL_MODE_BACK)
+			{
+				for (uint32_t t = 0; t < meshlet.triangleCount; ++t)
+				{
+					const size_t backfacing = IsTriangleBackfacing(mesh, triangles + t * 3, eye) ? 1 : 0;
+					statistics.backfaceTriangles += backfacing;
+					statistics.visibleBackfaceTriangles += outsideFrustum ? 0 : backfacing;
+				}
+			}
+
+			if (outsideFrustum)
+			{
+				statistics.frustumTriangles += meshlet.triangleCount;
+			}
+			else if (mesh.cullMode == cpu::CULL_MODE_BACK && culler.IsBackfacing(meshlet))
+			{
+				statistics.coneTriangles += meshlet.triangleCount;
+
+				for (uint32_t t = 0; t < meshlet.triangleCount; ++t)
+				{
+					statistics.coneErrors += IsTriangleBackfacing(mesh, triangles + t * 3, eye) ? 0 : 1;
+				}
+			}
+		}
+	}
+
+	return statistics;
+}
+
+std::vector<View> CreateViews(const SyntheticScene& scene)
+{
+	// The ModelViewer camera, the nave from the floor and the gallery, each looking around, and the spotlight.
+	const cpu::Float3 POSITIONS[] = {{-500.0f, 200.0f, 400.0f}, {0.0f, 150.0f, 0.0f}, {700.0f, 450.0f, -150.0f}};
+	std::vector<View> views;
+
+	for (uint32_t p = 0; p < std::size(POSITIONS); ++p)
+	{
+		for (uint32_t yaw = 0; yaw < YAW_COUNT; ++yaw)
+		{
+			const float angle = 2.0f * std::numbers::pi_v<float> * static_cast<float>(yaw) / YAW_COUNT;
+			View& view = views.emplace_back();
+			view.name = "camera" + std::to_string(p) + "-" + std::to_string(yaw * 360 / YAW_COUNT);
+			view.camera = scene.camera;
+			view.camera.SetEyeAtUp(POSITIONS[p], POSITIONS[p] + cpu::Float3{std::cos(angle), -0.2f, std::sin(angle)}, {0.0f, 1.0f, 0.0f});
+		}
+	}
+
+	views.push_back({"spotlight", scene.spotlight});
+	return views;
+}
+} // namespace
+
+// Builds the meshlets of Sponza as the .mini conversion does and reports the build throughput, the fraction of triangles that frustum and normal cone
+// culling of meshlets reject per view, with the back faces inside the frustum that bound what the cones can reject, and the effect on the CPU depth rasterizer,
+// whose output must not change.
+int RunMeshletBenchmark(const Options& options)
+{
+	const uint32_t width = options.GetUint("width", 1280);
+	const uint32_t height = options.GetUint("height", 720);
+	const uint32_t iterations = std::max(options.GetUint("iterations", 5), 1u);
+	cpu::TaskPool taskPool{options.GetUint("threads", 0)};
+
+	std::vector<H3DData> models;
+	std::stringstream paths{options.GetString("models", DEFAULT_MODELS)};
+	std::string path;
+
+	while (std::getline(paths, path, ';'))
+	{
+		H3DData& model = models.emplace_back();
+
+		if (!model.Load(path))
+		{
+			std::fprintf(stderr, "Skipping %s: cannot load the model.\n", path.c_str());
+			models.pop_back();
+			continue;
+		}
+
+		std::printf("Loaded %s: %u meshes, %u triangles\n", path.c_str(), model.GetMeshCount(), model.GetTriangleCount());
+	}
+
+	std::vector<ClusteredMesh> meshes;
+	size_t triangleCount = 0;
+
+	for (const H3DData& model : models)
+	{
+		// --cull-back treats every model as opaque, which exercises the cone test when only the cutout model is at hand.
+		const cpu::CULL_MODE cullMode = ((&model == &models.front() && models.size() > 1) || options.Has("cull-back")) ? cpu::CULL_MODE_BACK : cpu::CULL_MODE_NONE;
+
+		for (uint32_t meshIndex = 0; meshIndex < model.GetMeshCount(); ++meshIndex)
+		{
+			const H3DData::Mesh& mesh = model.GetMesh(meshIndex);
+			const uint16_t* indices = model.GetIndexData() + mesh.indexDataByteOffset / sizeof(uint16_t);
+			ClusteredMesh& clusteredMesh = meshes.emplace_back();
+			clusteredMesh = {model.GetVertexData() + mesh.vertexDataByteOffset, mesh.vertexStride, mesh.vertexCount, std::vector<uint16_t>(mesh.indexCount), {}, cullMode};
+			OptimizeFaces(indices, mesh.indexCount, clusteredMesh.indices.data(), 64);
+			triangleCount += mesh.indexCount / 3;
+		}
+	}
+
+	if (meshes.empty())
+	{
+		std::fprintf(stderr, "No model to cluster. Specify --models path[;path...].\n");
+		return 1;
+	}
+
+	// Build throughput, best of the iterations. BuildMeshlets() reorders the indices, so each iteration starts again from the vertex cache order.
+	std::vector<std::vector<uint16_t>> optimizedIndices;
+
+	for (const ClusteredMesh& mesh : meshes)
+	{
+		optimizedIndices.push_back(mesh.indices);
+	}
+
+	double seconds = std::numeric_limits<double>::max();
+
+	for (uint32_t iteration = 0; iteration < iterations; ++iteration)
+	{
+		for (size_t i = 0; i < meshes.size(); ++i)
+		{
+			meshes[i].indices = optimizedIndices[i];
+		}
+
+		const Stopwatch stopwatch;
+
+		for (ClusteredMesh& mesh : meshes)
+		{
+			mesh.meshlets.clear();
+			BuildMeshlets(mesh.indices.data(), mesh.indices.size(), reinterpret_cast<const float*>(mesh.vertices), mesh.vertexStride, mesh.vertexCount, mesh.meshlets);
+		}
+
+		seconds = std::min(seconds, stopwatch.GetSeconds());
+	}
+
+	size_t meshletCount = 0;
+	size_t vertexCount = 0;
+	size_t coneCount = 0;
+
+	for (const ClusteredMesh& mesh : meshes)
+	{
+		meshletCount += mesh.meshlets.size();
+
+		for (const Meshlet& meshlet : mesh.meshlets)
+		{
+			vertexCount += meshlet.vertexCount;
+			coneCount += (meshlet.coneCutoff < 1.0f) ? 1 : 0;
+		}
+	}
+
+	std::printf("Meshlets: %zu for %zu triangles (%.1f triangles and %.1f vertices each, %.1f%% with a normal cone), built at %.2f Mtriangles/s\n", meshletCount, triangleCount,
+	            static_cast<double>(triangleCount) / meshletCount, static_cast<double>(vertexCount) / meshletCount, 100.0 * coneCount / meshletCount, triangleCount / seconds * 1.0e-6);
+
+	// Culling per view, and the depth rasterizer with and without meshlets.
+	const SyntheticScene scene = CreateSyntheticScene(width, height);
+	std::vector<cpu::DepthDrawCall> triangleDraws;
+	std::vector<cpu::DepthDrawCall> meshletDraws;
+
+	for (const ClusteredMesh& mesh : meshes)
+	{
+		triangleDraws.push_back({mesh.vertices, mesh.vertexStride, mesh.vertexCount, mesh.indices.data(), static_cast<uint32_t>(mesh.indices.size()), mesh.cullMode});
+		meshletDraws.push_back(triangleDraws.back());
+		meshletDraws.back().meshlets = mesh.meshlets;
+	}
+
+	const cpu::DepthBias bias;
+	cpu::DepthRasterizer rasterizer;
+	cpu::Image referenceDepth;
+	cpu::Image meshletDepth;
+	referenceDepth.Resize(width, height);
+	meshletDepth.Resize(width, height);
+
+	std::printf("  %-14s %9s %9s %9s %9s %12s %12s %10s %10s %9s\n", "view", "frustum", "cone", "backface", "in view", "triangles", "w/meshlets", "ms", "w/meshlets", "mismatch");
+	const std::vector<View> views = CreateViews(scene);
+	CullStatistics total;
+	size_t mismatchCount = 0;
+
+	for (const View& view : views)
+	{
+		const CullStatistics statistics = CullMeshlets(meshes, view.camera);
+		total.frustumTriangles += statistics.frustumTriangles;
+		total.coneTriangles += statistics.coneTriangles;
+		total.backfaceTriangles += statistics.backfaceTriangles;
+		total.visibleBackfaceTriangles += statistics.visibleBackfaceTriangles;
+		total.coneErrors += statistics.coneErrors;
+
+		const cpu::Float4x4 viewProj = view.camera.GetViewProjMatrix();
+		const auto render = [&](const std::vector<cpu::DepthDrawCall>& drawCalls, cpu::Image& depth) {
+			double best = std::numeric_limits<double>::max();
+
+			for (uint32_t iteration = 0; iteration < iterations; ++iteration)
+			{
+				const Stopwatch stopwatch;
+				rasterizer.Render(taskPool, viewProj, drawCalls, bias, depth);
+				best = std::min(best, stopwatch.GetMilliseconds());
+			}
+
+			return best;
+		};
+
+		const double referenceMilliseconds = render(triangleDraws, referenceDepth);
+		const uint32_t referenceTriangles = rasterizer.GetTriangleCount();
+		const double meshletMilliseconds = render(meshletDraws, meshletDepth);
+		const uint32_t meshletTriangles = rasterizer.GetTriangleCount();
+		size_t mismatches = 0;
+
+		for (uint32_t y = 0; y < height; ++y)
+		{
+			for (uint32_t x = 0; x < width; ++x)
+			{
+				mismatches += (referenceDepth(x, y) != meshletDepth(x, y)) ? 1 : 0;
+			}
+		}
+
+		mismatchCount += mismatches;
+		const double percent = 100.0 / static_cast<double>(triangleCount);
+		std::printf("  %-14s %8.1f%% %8.1f%% %8.1f%% %8.1f%% %12u %12u %10.2f %10.2f %9zu\n", view.name.c_str(), statistics.frustumTriangles * percent,
+		            statistics.coneTriangles * percent, statistics.backfaceTriangles * percent, statistics.visibleBackfaceTriangles * percent, referenceTriangles, meshletTriangles, referenceMilliseconds, meshletMilliseconds, mismatches);
+	}
+
+	const double percent = 100.0 / (static_cast<double>(triangleCount) * static_cast<double>(views.size()));
+	std::printf("  %-14s %8.1f%% %8.1f%% %8.1f%% %8.1f%%\n", "mean", total.frustumTriangles * percent, total.coneTriangles * percent, total.backfaceTriangles * percent,
+	            total.visibleBackfaceTriangles * percent);
+
+	if (total.coneErrors > 0 || mismatchCount > 0)
+	{
+		std::fprintf(stderr, "Meshlet culling rejected %zu front-facing triangles and changed %zu depth pixels.\n", total.coneErrors, mismatchCount);
+		return 1;
+	}
+
+	return 0;
+}
+} // namespace vsgl::headless
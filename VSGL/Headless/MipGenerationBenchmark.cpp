@@ -0,0 +1,276 @@
+#include "Headless.hpp"
+
+#include "../CPU/TaskPool.hpp"
+#include "../CPU/Texture.hpp"
+#include "../../MiniEngine/Core/MappedFile.h"
+#include "../../MiniEngine/Model/MipGenerator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <limits>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace vsgl::headless
+{
+namespace
+{
+constexpr const char* DEFAULT_TEXTURES = "../Sponza/textures";
+constexpr const char* DEFAULT_COLOR = "sponza_curtain_diff.DDS";
+constexpr const char* DEFAULT_CUTOUT = "sponza_thorn_diff.DDS";
+constexpr const char* DEFAULT_NORMAL = "sponza_floor_a_ddn.DDS";
+constexpr float ALPHA_CUTOFF = 0.5f; // Of CutoutDepthPS and DepthCutoutPS.
+
+#if defined(__AVX2__)
+constexpr const char* GENERATOR_NAME = "AVX2";
+#else
+constexpr const char* GENERATOR_NAME = "scalar build";
+#endif
+
+// The mip chain of a texture as MipGenerator writes it.
+struct MipChain
+{
+	std::vector<std::vector<uint8_t>> levels;
+	std::vector<MipImage> images;
+
+	MipChain(const std::vector<uint8_t>& texels, const uint32_t size)
+	{
+		const uint32_t mipCount = GetMipCount(size, size);
+		levels.resize(mipCount);
+		levels[0] = texels;
+
+		for (uint32_t level = 0; level < mipCount; ++level)
+		{
+			const uint32_t levelSize = std::max(size >> level, 1u);
+			levels[level].resize(size_t{levelSize} * levelSize * 4);
+			images.push_back({levels[level].data(), size_t{levelSize} * 4, levelSize, levelSize});
+		}
+	}
+};
+
+// Mip 0 of a DDS file as R8G8B8A8_UNORM, repeated to size x size. The Sponza textures tile, so the repetitions stand in for a texture of that size. SNORM normals
+// are mapped to UNORM.
+bool LoadTiled(const std::filesystem::path& path, const uint32_t size, cpu::TaskPool& taskPool, std::vector<uint8_t>& texels, bool& isSRGB)
+{
+	Utility::MappedFile file;
+	cpu::Texture texture;
+
+	if (!file.Open(path.string()) || !texture.Decode(file.GetData(), file.GetSize(), taskPool))
+	{
+		std::fprintf(stderr, "Cannot decode %s.\n", path.string().c_str());
+		return false;
+	}
+
+	const DXGI_FORMAT format = texture.GetFormat();
+
+	if (format != DXGI_FORMAT_R8G8B8A8_UNORM && format != DXGI_FORMAT_R8G8B8A8_UNORM_SRGB && format != DXGI_FORMAT_R8G8B8A8_SNORM)
+	{
+		std::fprintf(stderr, "%s is not an 8-bit texture.\n", path.string().c_str());
+		return false;
+	}
+
+	isSRGB = format == DXGI_FORMAT_R8G8B8A8_UNORM_SRGB;
+	texels.resize(size_t{size} * size * 4);
+
+	for (uint32_t y = 0; y < size; ++y)
+	{
+		for (uint32_t x = 0; x < size; ++x)
+		{
+			const uint8_t* source = texture.GetTexel(0, x % texture.GetWidth(), y % texture.GetHeight());
+			uint8_t* texel = &texels[(size_t{y} * size + x) * 4];
+
+			if (format == DXGI_FORMAT_R8G8B8A8_SNORM)
+			{
+				for (uint32_t c = 0; c < 3; ++c)
+				{
+					const int32_t value = std::max<int32_t>(static_cast<int8_t>(source[c]), -127);
+					texel[c] = static_cast<uint8_t>(std::lround((value + 127) * 255.0f / 254.0f));
+				}
+
+				// BC5 has no z. Complete it as DecodeNormalMap() does.
+				const float nx = texel[0] / 127.5f - 1.0f;
+				const float ny = texel[1] / 127.5f - 1.0f;
+				texel[2] = static_cast<uint8_t>(std::lround((std::sqrt(std::max(1.0f - nx * nx - ny * ny, 0.0f)) + 1.0f) * 127.5f));
+				texel[3] = 255;
+			}
+			else
+			{
+				std::copy(source, source + 4, texel);
+			}
+		}
+	}
+
+	return true;
+}
+
+double GetMeanLuminance(const MipImage& image, const bool isSRGB)
+{
+	double sum = 0.0;
+
+	for (uint32_t y = 0; y < image.Height; ++y)
+	{
+		for (uint32_t x = 0; x < image.Width; ++x)
+		{
+			const uint8_t* texel = image.Texels + y * image.RowPitch + size_t{x} * 4;
+			double linear[3];
+
+			for (uint32_t c = 0; c < 3; ++c)
+			{
+				const double value = texel[c] / 255.0;
+				linear[c] = !isSRGB ? value : value <= 0.04045 ? value / 12.92 : std::pow((value + 0.055) / 1.055, 2.4);
+			}
+
+			sum += 0.2126 * linear[0] + 0.7152 * linear[1] + 0.0722 * linear[2];
+		}
+	}
+
+	return sum / (static_cast<double>(image.Width) * image.Height);
+}
+
+double GetCoverage(const MipImage& image)
+{
+	size_t count = 0;
+
+	for (uint32_t y = 0; y < image.Height; ++y)
+	{
+		for (uint32_t x = 0; x < image.Width; ++x)
+		{
+			count += image.Texels[y * image.RowPitch + size_t{x} * 4 + 3] >= ALPHA_CUTOFF * 255.0f ? 1 : 0;
+		}
+	}
+
+	return static_cast<double>(count) / (static_cast<double>(image.Width) * image.Height);
+}
+
+double GetMeanNormalLength(const MipImage& image)
+{
+	double sum = 0.0;
+
+	for (uint32_t y = 0; y < image.Height; ++y)
+	{
+		for (uint32_t x = 0; x < image.Width; ++x)
+		{
+			const uint8_t* texel = image.Texels + y * image.RowPitch + size_t{x} * 4;
+			const double nx = texel[0] / 127.5 - 1.0, ny = texel[1] / 127.5 - 1.0, nz = texel[2] / 127.5 - 1.0;
+			sum += std::sqrt(nx * nx + ny * ny + nz * nz);
+		}
+	}
+
+	return sum / (static_cast<double>(image.Width) * image.Height);
+}
+
+// The best time of generating the chain in milliseconds.
+double GenerateBest(MipChain& chain, const MipOptions& options, const uint32_t iterations)
+{
+	double milliseconds = std::numeric_limits<double>::max();
+
+	for (uint32_t iteration = 0; iteration < iterations; ++iteration)
+	{
+		const Stopwatch stopwatch;
+		GenerateMips(chain.images.data(), static_cast<uint32_t>(chain.images.size()), options);
+		milliseconds = std::min(milliseconds, stopwatch.GetMilliseconds());
+	}
+
+	return milliseconds;
+}
+} // namespace
+
+// Generates the mip chains of a color texture, a cutout texture and a normal map of the Sponza textures, repeated to --size x --size, with the box and Kaiser
+// filters on one thread and on --threads. Reports the time, and what each option is for: the drift of the mean luminance down the chain without and with sRGB
+// linearization, the alpha-test coverage per level without and with its preservation, and the length of the normals without and with renormalization.
+int RunMipGenerationBenchmark(const Options& options)
+{
+	const std::filesystem::path directory = options.GetString("textures", DEFAULT_TEXTURES);
+	const uint32_t size = std::max(options.GetUint("size", 4096), 1u);
+	const uint32_t iterations = std::max(options.GetUint("iterations", 3), 1u);
+	const uint32_t threadCount = options.GetUint("threads", 0) != 0 ? options.GetUint("threads", 0) : std::max(std::thread::hardware_concurrency(), 1u);
+	cpu::TaskPool taskPool{threadCount};
+
+	const struct
+	{
+		const char* kind;
+		std::string fileName;
+		bool isCutout;
+		bool isNormalMap;
+	} sources[] = {
+	    {"color", options.GetString("color", DEFAULT_COLOR), false, false},
+	    {"cutout", options.GetString("cutout", DEFAULT_CUTOUT), true, false},
+	    {"normal", options.GetString("normal", DEFAULT_NORMAL), false, true},
+	};
+
+	std::printf("Mip chains of %ux%u textures (%u levels), generator: %s, best of %u\n", size, size, GetMipCount(size, size), GENERATOR_NAME, iterations);
+
+	for (const auto& source : sources)
+	{
+		std::vector<uint8_t> texels;
+		bool isSRGB = false;
+
+		if (!LoadTiled(directory / source.fileName, size, taskPool, texels, isSRGB))
+		{
+			return 1;
+		}
+
+		MipOptions mipOptions;
+		mipOptions.SRGB = isSRGB;
+		mipOptions.NormalMap = source.isNormalMap;
+		mipOptions.AlphaCutoff = source.isCutout ? ALPHA_CUTOFF : 0.0f;
+		mipOptions.Wrap = true;
+
+		MipChain chain(texels, size);
+		std::printf("%s: %s\n", source.kind, source.fileName.c_str());
+		std::printf("  %-8s %14s %22s\n", "filter", "1 thread", (std::to_string(threadCount) + " threads").c_str());
+
+		for (const MipFilter filter : {MipFilter::kBox, MipFilter::kKaiser})
+		{
+			mipOptions.Filter = filter;
+			mipOptions.ThreadCount = 1;
+			const double serialMilliseconds = GenerateBest(chain, mipOptions, iterations);
+			mipOptions.ThreadCount = threadCount;
+			const double parallelMilliseconds = threadCount > 1 ? GenerateBest(chain, mipOptions, iterations) : serialMilliseconds;
+			std::printf("  %-8s %8.1f ms %6.1f Mtex/s %8.1f ms %6.1f Mtex/s\n", filter == MipFilter::kBox ? "box" : "Kaiser", serialMilliseconds,
+			            static_cast<double>(size) * size / serialMilliseconds * 1.0e-3, parallelMilliseconds, static_cast<double>(size) * size / parallelMilliseconds * 1.0e-3);
+		}
+
+		// The option that the texture is for, off and on, with the Kaiser filter. Color textures are filtered in sRGB space without linearization.
+		MipOptions plainOptions = mipOptions;
+		const char* metric = "mean luminance";
+		const char* option = "linearized";
+
+		if (source.isNormalMap)
+		{
+			plainOptions.NormalMap = false;
+			metric = "mean normal length";
+			option = "renormalized";
+		}
+		else if (source.isCutout)
+		{
+			plainOptions.AlphaCutoff = 0.0f;
+			metric = "alpha-test coverage";
+			option = "preserved";
+		}
+		else
+		{
+			plainOptions.SRGB = false;
+		}
+
+		const auto measure = [&](const MipImage& image) {
+			return source.isNormalMap ? GetMeanNormalLength(image) : source.isCutout ? GetCoverage(image) : GetMeanLuminance(image, isSRGB);
+		};
+
+		MipChain plainChain(texels, size);
+		GenerateMips(plainChain.images.data(), static_cast<uint32_t>(plainChain.images.size()), plainOptions);
+		std::printf("  %s of level 0: %.4f\n", metric, measure(chain.images[0]));
+		std::printf("  %-8s %10s %14s\n", "level", "plain", option);
+
+		for (uint32_t level = 2; level < chain.images.size(); level += 2)
+		{
+			std::printf("  %-8u %10.4f %14.4f\n", level, measure(plainChain.images[level]), measure(chain.images[level]));
+		}
+	}
+
+	return 0;
+}
+} // namespace vsgl::headless
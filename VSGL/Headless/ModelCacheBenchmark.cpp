@@ -0,0 +1,266 @@
+#include "Headless.hpp"
+
+#include "../CPU/TaskPool.hpp"
+#include "../../MiniEngine/Model/GeometryCodec.h"
+#include "../../MiniEngine/Model/H3DData.h"
+#include "../../MiniEngine/Model/IndexOptimizePostTransform.h"
+#include "../../MiniEngine/Model/Meshlet.h"
+#include "../../MiniEngine/Model/ModelCache.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <limits>
+#include <string>
+#include <vector>
+
+namespace vsgl::headless
+{
+namespace
+{
+constexpr const char* DEFAULT_MODEL = "../Sponza/sponza_cutout.h3d";
+constexpr uint64_t IMPORTER_VERSION = 1;
+
+// The inputs of the import of one mesh, as OptimizeMesh() takes them from an H3D mesh.
+struct SourceMesh
+{
+	const uint8_t* vertices;
+	uint32_t vertexCount;
+	uint32_t vertexStride;
+	const uint16_t* indices;
+	uint32_t indexCount;
+	uint32_t materialIndex;
+};
+
+struct ImportStats
+{
+	double seconds = 0.0;
+	uint32_t importedMeshes = 0; // Not found in the cache.
+	bool upToDate = false;       // The model key matched, so nothing was looked at.
+};
+
+uint64_t MeshKey(const SourceMesh& mesh)
+{
+	ContentHash hash{IMPORTER_VERSION};
+	hash.UpdateValue(mesh.vertexStride);
+	hash.UpdateValue(mesh.materialIndex);
+	hash.Update(mesh.vertices, size_t{mesh.vertexCount} * mesh.vertexStride);
+	hash.Update(mesh.indices, size_t{mesh.indexCount} * sizeof(uint16_t));
+	return hash.Finish();
+}
+
+// As LoadModel() keys the .mini file: everything the import reads.
+uint64_t ModelKey(const std::vector<SourceMesh>& meshes)
+{
+	ContentHash hash{IMPORTER_VERSION};
+
+	for (const SourceMesh& mesh : meshes)
+	{
+		hash.UpdateValue(mesh.vertexStride);
+		hash.UpdateValue(mesh.materialIndex);
+		hash.UpdateValue(mesh.vertexCount);
+		hash.Update(mesh.vertices, size_t{mesh.vertexCount} * mesh.vertexStride);
+		hash.UpdateValue(mesh.indexCount);
+		hash.Update(mesh.indices, size_t{mesh.indexCount} * sizeof(uint16_t));
+	}
+
+	return hash.Finish();
+}
+
+void AppendBytes(std::vector<uint8_t>& output, const void* data, const size_t size)
+{
+	const uint8_t* bytes = static_cast<const uint8_t*>(data);
+	output.insert(output.end(), bytes, bytes + size);
+}
+
+// The expensive part of OptimizeMesh() and SaveModel() for one mesh: vertex cache optimization, meshlets and the compressed vertex and index buffers.
+std::vector<uint8_t> ImportMesh(const SourceMesh& mesh)
+{
+	std::vector<uint8_t> geometry(size_t{mesh.vertexCount} * mesh.vertexStride + ((size_t{mesh.indexCount} * sizeof(uint16_t) + 3) & ~size_t{3}));
+	std::memcpy(geometry.data(), mesh.vertices, size_t{mesh.vertexCount} * mesh.vertexStride);
+	uint16_t* indices = reinterpret_cast<uint16_t*>(geometry.data() + size_t{mesh.vertexCount} * mesh.vertexStride);
+	OptimizeFaces(mesh.indices, mesh.indexCount, indices, 64);
+
+	std::vector<Meshlet> meshlets;
+	BuildMeshlets(indices, mesh.indexCount, reinterpret_cast<const float*>(mesh.vertices), mesh.vertexStride, mesh.vertexCount, meshlets);
+
+	const uint32_t vertexBytes = mesh.vertexCount * mesh.vertexStride;
+	std::vector<GeometryChunk> chunks;
+	SplitGeometryChunks(geometry.size(),
+	                    {{0, vertexBytes, mesh.vertexStride, GeometryStreamType::kVertex}, {vertexBytes, mesh.indexCount * static_cast<uint32_t>(sizeof(uint16_t)), 0, GeometryStreamType::kIndex16}},
+	                    chunks);
+
+	std::vector<uint8_t> entry;
+	const uint32_t counts[3] = {static_cast<uint32_t>(geometry.size()), static_cast<uint32_t>(chunks.size()), static_cast<uint32_t>(meshlets.size())};
+	AppendBytes(entry, counts, sizeof(counts));
+	AppendBytes(entry, meshlets.data(), meshlets.size() * sizeof(Meshlet));
+
+	std::vector<uint8_t> encoded;
+	for (GeometryChunk& chunk : chunks)
+	{
+		EncodeGeometryChunk(chunk, geometry.data(), encoded);
+		chunk.encodedSize = static_cast<uint32_t>(encoded.size());
+		AppendBytes(entry, &chunk, sizeof(chunk));
+		AppendBytes(entry, encoded.data(), encoded.size());
+	}
+
+	return entry;
+}
+
+// Imports a model into output the way LoadModel() does with the cache: nothing if the model key is unchanged, otherwise every mesh from its cache
+// entry or, for those not found, by importing it and storing the entry, in parallel. The entries are then packed in mesh order.
+ImportStats Import(const std::vector<SourceMesh>& meshes, const ModelCache& cache, uint64_t& modelKey, std::vector<uint8_t>& output, cpu::TaskPool& taskPool)
+{
+	ImportStats stats;
+	const Stopwatch stopwatch;
+	const uint64_t key = ModelKey(meshes);
+
+	if (key == modelKey)
+	{
+		stats.upToDate = true;
+		stats.seconds = stopwatch.GetSeconds();
+		return stats;
+	}
+
+	std::vector<std::vector<uint8_t>> entries(meshes.size());
+	std::atomic<uint32_t> importedMeshes = 0;
+	taskPool.ParallelFor(static_cast<uint32_t>(meshes.size()), [&](const uint32_t i, uint32_t) {
+		const uint64_t meshKey = MeshKey(meshes[i]);
+
+		if (!cache.Load(meshKey, entries[i]))
+		{
+			entries[i] = ImportMesh(meshes[i]);
+			cache.Store(meshKey, entries[i].data(), entries[i].size());
+			++importedMeshes;
+		}
+	});
+
+	output.clear();
+
+	for (const std::vector<uint8_t>& entry : entries)
+	{
+		AppendBytes(output, entry.data(), entry.size());
+	}
+
+	modelKey = key;
+	stats.seconds = stopwatch.GetSeconds();
+	stats.importedMeshes = importedMeshes;
+	return stats;
+}
+
+void PrintStats(const char* name, const ImportStats& stats, const size_t meshCount)
+{
+	if (stats.upToDate)
+	{
+		std::printf("  %-28s %10.2f ms, up to date\n", name, stats.seconds * 1000.0);
+	}
+	else
+	{
+		std::printf("  %-28s %10.2f ms, %u of %zu meshes imported\n", name, stats.seconds * 1000.0, stats.importedMeshes, meshCount);
+	}
+}
+
+// The fastest of the iterations, each of which starts from the state prepare() leaves.
+template <typename Prepare, typename Function>
+ImportStats BestStats(const uint32_t iterations, const Prepare& prepare, const Function& function)
+{
+	ImportStats best;
+	best.seconds = std::numeric_limits<double>::max();
+
+	for (uint32_t iteration = 0; iteration < iterations; ++iteration)
+	{
+		prepare();
+		const ImportStats stats = function();
+
+		if (stats.seconds < best.seconds)
+		{
+			best = stats;
+		}
+	}
+
+	return best;
+}
+} // namespace
+
+// Incremental import of an H3D model through the content-hashed ModelCache, as LoadModel() does: the time of a full import with an empty cache, of a
+// no-op re-import (the model key matches), of a re-import with every mesh cached (the model key differs, e.g. after editing a material) and of a
+// re-import after one vertex of one mesh changes, which imports that mesh only.
+int RunModelCacheBenchmark(const Options& options)
+{
+	const uint32_t iterations = std::max(options.GetUint("iterations", 5), 1u);
+	const std::string path = options.GetString("model", DEFAULT_MODEL);
+	const std::filesystem::path cacheDirectory = options.GetString("cache", (std::filesystem::temp_directory_path() / "vsgl_model_cache").string());
+	cpu::TaskPool taskPool{options.GetUint("threads", 0)};
+
+	H3DData model;
+
+	if (!model.Load(path) || model.GetMeshCount() == 0)
+	{
+		std::fprintf(stderr, "Cannot load %s. Specify --model path.\n", path.c_str());
+		return 1;
+	}
+
+	std::vector<SourceMesh> meshes;
+
+	for (uint32_t meshIndex = 0; meshIndex < model.GetMeshCount(); ++meshIndex)
+	{
+		const H3DData::Mesh& mesh = model.GetMesh(meshIndex);
+		meshes.push_back({model.GetVertexData() + mesh.vertexDataByteOffset, mesh.vertexCount, mesh.vertexStride, model.GetIndexData() + mesh.indexDataByteOffset / sizeof(uint16_t),
+		                  mesh.indexCount, mesh.materialIndex});
+	}
+
+	// The edit moves the first vertex of the largest mesh.
+	const size_t changedMesh = static_cast<size_t>(
+	    std::max_element(meshes.begin(), meshes.end(), [](const SourceMesh& a, const SourceMesh& b) { return a.vertexCount < b.vertexCount; }) - meshes.begin());
+	std::vector<uint8_t> changedVertices(meshes[changedMesh].vertices, meshes[changedMesh].vertices + size_t{meshes[changedMesh].vertexCount} * meshes[changedMesh].vertexStride);
+	float x;
+	std::memcpy(&x, changedVertices.data(), sizeof(float));
+	x += 1.0f;
+	std::memcpy(changedVertices.data(), &x, sizeof(float));
+	std::vector<SourceMesh> changedMeshes = meshes;
+	changedMeshes[changedMesh].vertices = changedVertices.data();
+
+	const ModelCache cache{cacheDirectory.string()};
+	std::vector<uint8_t> reference;
+	std::vector<uint8_t> output;
+	uint64_t modelKey = 0;
+	const auto clearCache = [&] {
+		std::filesystem::remove_all(cacheDirectory);
+		modelKey = 0;
+	};
+
+	const ImportStats full = BestStats(iterations, clearCache, [&] { return Import(meshes, cache, modelKey, reference, taskPool); });
+	const ImportStats noOp = BestStats(iterations, [] {}, [&] { return Import(meshes, cache, modelKey, output, taskPool); });
+	const ImportStats cached = BestStats(iterations, [&] { modelKey = 0; }, [&] { return Import(meshes, cache, modelKey, output, taskPool); });
+	const bool cachedMatches = output == reference;
+
+	// Every iteration starts from the cache of the original model, so only the changed mesh is imported.
+	const ImportStats changed = BestStats(
+	    iterations,
+	    [&] {
+		    std::filesystem::remove(cache.GetFilePath(MeshKey(changedMeshes[changedMesh]), ""));
+		    modelKey = ModelKey(meshes);
+	    },
+	    [&] { return Import(changedMeshes, cache, modelKey, output, taskPool); });
+
+	std::vector<uint8_t> changedReference;
+	uint64_t uncachedKey = 0;
+	Import(changedMeshes, ModelCache{(cacheDirectory / "reference").string()}, uncachedKey, changedReference, taskPool);
+	std::filesystem::remove_all(cacheDirectory / "reference");
+
+	if (!cachedMatches || output != changedReference)
+	{
+		std::fprintf(stderr, "The output built from the cache does not match a full import.\n");
+		return 1;
+	}
+
+	std::printf("%s: %zu meshes, %.2f MB imported, cache in %s, %u threads\n", path.c_str(), meshes.size(), reference.size() * 1.0e-6, cacheDirectory.string().c_str(), taskPool.GetWorkerCount());
+	PrintStats("full import (empty cache)", full, meshes.size());
+	PrintStats("no-op re-import", noOp, meshes.size());
+	PrintStats("re-import, all meshes cached", cached, meshes.size());
+	PrintStats("re-import, one mesh changed", changed, meshes.size());
+	return 0;
+}
+} // namespace vsgl::headless
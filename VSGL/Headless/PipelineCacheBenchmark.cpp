@@ -0,0 +1,330 @@
+#include "Headless.hpp"
+
+#include "../../MiniEngine/Core/DeviceObjectCache.h"
+#include "../../MiniEngine/Core/ShardedCache.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace vsgl::headless
+{
+namespace
+{
+// ID3D12PipelineState without D3D12: a COM-style reference count and the hash of the description it was created from.
+class MockPipelineState
+{
+  public:
+	explicit MockPipelineState(const size_t hash) : m_hash(hash) {}
+
+	size_t GetHash() const { return m_hash; }
+
+	uint32_t Release()
+	{
+		const uint32_t references = m_references.fetch_sub(1, std::memory_order_acq_rel) - 1;
+
+		if (references == 0)
+		{
+			delete this;
+		}
+
+		return references;
+	}
+
+  private:
+	size_t m_hash;
+	std::atomic<uint32_t> m_references = 1;
+};
+
+// The factory of ID3D12Device: counts the pipeline states it creates and busy-waits for each as long as a driver would compile it.
+class MockDevice
+{
+  public:
+	explicit MockDevice(const uint32_t createMicroseconds) : m_createTime(std::chrono::microseconds(createMicroseconds)) {}
+
+	MockPipelineState* CreatePipelineState(const size_t hash)
+	{
+		const auto end = std::chrono::steady_clock::now() + m_createTime;
+
+		while (std::chrono::steady_clock::now() < end)
+		{
+		}
+
+		m_createdCount.fetch_add(1, std::memory_order_relaxed);
+		return new MockPipelineState(hash);
+	}
+
+	uint64_t GetCreatedCount() const { return m_createdCount.load(); }
+
+  private:
+	std::chrono::steady_clock::duration m_createTime;
+	std::atomic<uint64_t> m_createdCount = 0;
+};
+
+// PSO::Finalize() before: one mutex for the map, the entry reserved under it, and the pipeline state created outside of it while the others spin on the entry.
+class GlobalMutexPipelineCache
+{
+  public:
+	explicit GlobalMutexPipelineCache(MockDevice& device) : m_device(device) {}
+
+	~GlobalMutexPipelineCache()
+	{
+		for (auto& [hash, entry] : m_entries)
+		{
+			entry.load()->Release();
+		}
+	}
+
+	MockPipelineState* FindOrCreate(const size_t hash)
+	{
+		std::atomic<MockPipelineState*>* entry;
+		bool mustCreate;
+
+		{
+			const std::lock_guard<std::mutex> lock(m_mutex);
+			const auto [iterator, inserted] = m_entries.try_emplace(hash, nullptr);
+			entry = &iterator->second;
+			mustCreate = inserted;
+		}
+
+		if (mustCreate)
+		{
+			MockPipelineState* pipelineState = m_device.CreatePipelineState(hash);
+			entry->store(pipelineState, std::memory_order_release);
+			return pipelineState;
+		}
+
+		return WaitFor(*entry);
+	}
+
+	size_t GetSize() const { return m_entries.size(); }
+
+  private:
+	static MockPipelineState* WaitFor(const std::atomic<MockPipelineState*>& entry)
+	{
+		MockPipelineState* pipelineState;
+
+		while ((pipelineState = entry.load(std::memory_order_acquire)) == nullptr)
+		{
+			std::this_thread::yield();
+		}
+
+		return pipelineState;
+	}
+
+	MockDevice& m_device;
+	std::mutex m_mutex;
+	std::map<size_t, std::atomic<MockPipelineState*>> m_entries;
+};
+
+// The same with the sharded cache of TextureManager: a lookup locks one of 64 mutexes.
+class ShardedPipelineCache
+{
+  public:
+	explicit ShardedPipelineCache(MockDevice& device) : m_device(device) {}
+
+	~ShardedPipelineCache()
+	{
+		for (const auto& pipelineState : m_created)
+		{
+			pipelineState->Release();
+		}
+	}
+
+	MockPipelineState* FindOrCreate(const size_t hash)
+	{
+		std::atomic<MockPipelineState*>* entry = nullptr;
+		bool mustCreate = false;
+		m_entries.FindOrInsert(hash, [] { return std::make_unique<std::atomic<MockPipelineState*>>(nullptr); },
+		                       [&](std::unique_ptr<std::atomic<MockPipelineState*>>& value, const bool inserted) {
+			                       entry = value.get();
+			                       mustCreate = inserted;
+		                       });
+
+		if (mustCreate)
+		{
+			MockPipelineState* pipelineState = m_device.CreatePipelineState(hash);
+			entry->store(pipelineState, std::memory_order_release);
+			const std::lock_guard<std::mutex> lock(m_createdMutex);
+			m_created.push_back(pipelineState);
+			return pipelineState;
+		}
+
+		MockPipelineState* pipelineState;
+
+		while ((pipelineState = entry->load(std::memory_order_acquire)) == nullptr)
+		{
+			std::this_thread::yield();
+		}
+
+		return pipelineState;
+	}
+
+	size_t GetSize() const { return m_entries.GetSize(); }
+
+  private:
+	MockDevice& m_device;
+	Utility::ShardedCache<size_t, std::unique_ptr<std::atomic<MockPipelineState*>>> m_entries;
+	std::mutex m_createdMutex;
+	std::vector<MockPipelineState*> m_created;
+};
+
+// PSO::Finalize() after: lock-free lookups, and striped inserts that never block them.
+class LockFreePipelineCache
+{
+  public:
+	explicit LockFreePipelineCache(MockDevice& device) : m_device(device) {}
+
+	MockPipelineState* FindOrCreate(const size_t hash)
+	{
+		return m_pipelineStates.FindOrCreate(hash, [&] { return m_device.CreatePipelineState(hash); });
+	}
+
+	size_t GetSize() const { return m_pipelineStates.GetSize(); }
+
+  private:
+	MockDevice& m_device;
+	Utility::DeviceObjectCache<MockPipelineState> m_pipelineStates;
+};
+
+// A bijection of 64-bit integers (the finalizer of SplitMix64), so that distinct indices give distinct hashes of PSO descriptions.
+uint64_t MixBits(uint64_t x)
+{
+	x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+	x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+	return x ^ (x >> 31);
+}
+
+struct RunResult
+{
+	double seconds = 0.0;
+	bool valid = false;
+};
+
+// The PSOs of a scene are created first. Then every thread looks up lookupCount / threadCount hashes: one in 100 a PSO that nobody has seen, as a new
+// material does, and the others a random PSO of the scene, as command recording does. Checks that every lookup returned the PSO of its hash and that each
+// PSO was created once.
+template <typename Cache>
+RunResult RunLookups(const uint32_t sceneCount, const uint32_t lookupCount, const uint32_t threadCount, const uint32_t createMicroseconds)
+{
+	constexpr uint64_t MISS_BIT = 1ull << 63;
+	MockDevice device(createMicroseconds);
+	Cache cache(device);
+
+	for (uint32_t i = 0; i < sceneCount; ++i)
+	{
+		cache.FindOrCreate(MixBits(i));
+	}
+
+	const uint32_t lookupsPerThread = lookupCount / threadCount;
+	std::atomic<uint32_t> readyCount = 0;
+	std::atomic<bool> start = false;
+	std::atomic<bool> valid = true;
+	std::atomic<uint64_t> missCount = 0;
+	std::vector<std::thread> threads;
+
+	for (uint32_t thread = 0; thread < threadCount; ++thread)
+	{
+		threads.emplace_back([&, thread] {
+			uint64_t random = MixBits(thread + 1);
+			uint64_t misses = 0;
+			bool threadValid = true;
+			readyCount.fetch_add(1);
+
+			while (!start.load(std::memory_order_acquire))
+			{
+				std::this_thread::yield();
+			}
+
+			for (uint32_t lookup = 0; lookup < lookupsPerThread; ++lookup)
+			{
+				// xorshift64
+				random ^= random << 13;
+				random ^= random >> 7;
+				random ^= random << 17;
+
+				const uint64_t index = random % 100 == 0 ? MISS_BIT | static_cast<uint64_t>(thread) << 32 | misses++ : (random >> 8) % sceneCount;
+				const size_t hash = MixBits(index);
+				threadValid &= cache.FindOrCreate(hash)->GetHash() == hash;
+			}
+
+			missCount.fetch_add(misses);
+
+			if (!threadValid)
+			{
+				valid.store(false);
+			}
+		});
+	}
+
+	while (readyCount.load() != threadCount)
+	{
+		std::this_thread::yield();
+	}
+
+	const Stopwatch stopwatch;
+	start.store(true, std::memory_order_release);
+
+	for (std::thread& thread : threads)
+	{
+		thread.join();
+	}
+
+	const double seconds = stopwatch.GetSeconds();
+	const uint64_t expectedSize = sceneCount + missCount.load();
+	return {seconds, valid.load() && cache.GetSize() == expectedSize && device.GetCreatedCount() == expectedSize};
+}
+} // namespace
+
+// Looks up PSOs from 1 to --max-threads threads at once, 99% of them hits, through the cache of PSO::Finalize() with a global mutex (as it was), through the
+// sharded cache of TextureManager and through DeviceObjectCache with lock-free lookups. The PSOs come from a mock device, which spins --create-us per PSO.
+int RunPipelineCacheBenchmark(const Options& options)
+{
+	const uint32_t sceneCount = std::max(options.GetUint("psos", 1024), 1u);
+	const uint32_t lookupCount = std::max(options.GetUint("lookups", 4000000), 1u);
+	const uint32_t maxThreadCount = std::max(options.GetUint("max-threads", 64), 1u);
+	const uint32_t createMicroseconds = options.GetUint("create-us", 0);
+	const uint32_t iterations = std::max(options.GetUint("iterations", 3), 1u);
+
+	std::printf("%u PSOs in the scene, %u lookups (99%% hits) split over the threads, %u us to create a PSO, %u hardware threads, best of %u\n", sceneCount,
+	            lookupCount, createMicroseconds, std::thread::hardware_concurrency(), iterations);
+	std::printf("  %8s %17s %17s %17s %10s\n", "threads", "global mutex", "sharded", "lock-free", "speedup");
+
+	for (uint32_t threadCount = 1; threadCount <= maxThreadCount; threadCount *= 2)
+	{
+		double seconds[3] = {1.0e30, 1.0e30, 1.0e30};
+
+		for (uint32_t iteration = 0; iteration < iterations; ++iteration)
+		{
+			const RunResult results[] = {
+			    RunLookups<GlobalMutexPipelineCache>(sceneCount, lookupCount, threadCount, createMicroseconds),
+			    RunLookups<ShardedPipelineCache>(sceneCount, lookupCount, threadCount, createMicroseconds),
+			    RunLookups<LockFreePipelineCache>(sceneCount, lookupCount, threadCount, createMicroseconds),
+			};
+
+			for (size_t cache = 0; cache < std::size(results); ++cache)
+			{
+				if (!results[cache].valid)
+				{
+					std::fprintf(stderr, "A cache returned the wrong PSO or created one twice.\n");
+					return 1;
+				}
+
+				seconds[cache] = std::min(seconds[cache], results[cache].seconds);
+			}
+		}
+
+		const double lookups = static_cast<double>(lookupCount / threadCount * threadCount);
+		std::printf("  %8u %11.2f M/s %11.2f M/s %11.2f M/s %9.2fx\n", threadCount, lookups / seconds[0] * 1.0e-6, lookups / seconds[1] * 1.0e-6,
+		            lookups / seconds[2] * 1.0e-6, seconds[0] / seconds[2]);
+	}
+
+	return 0;
+}
+} // namespace vsgl::headless
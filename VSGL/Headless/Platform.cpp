@@ -0,0 +1,84 @@
+#include "Platform.hpp"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
+#include <Psapi.h>
+#pragma comment(lib, "psapi.lib")
+#else
+#include <cstdio>
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
+
+namespace vsgl::headless
+{
+#ifdef _WIN32
+MemoryUsage GetMemoryUsage()
+{
+	PROCESS_MEMORY_COUNTERS counters = {};
+	GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters));
+	return {counters.WorkingSetSize, counters.PeakWorkingSetSize};
+}
+
+bool EvictFromFileCache(const std::filesystem::path& path)
+{
+	// Opening a file without buffering makes the cache manager flush and purge its cached pages.
+	const HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_NO_BUFFERING, nullptr);
+
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+
+	CloseHandle(file);
+	return true;
+}
+#else
+MemoryUsage GetMemoryUsage()
+{
+	MemoryUsage usage = {};
+	const size_t pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+
+	if (std::FILE* file = std::fopen("/proc/self/statm", "r"))
+	{
+		unsigned long size = 0;
+		unsigned long resident = 0;
+		usage.residentBytes = (std::fscanf(file, "%lu %lu", &size, &resident) == 2) ? resident * pageSize : 0;
+		std::fclose(file);
+	}
+
+	rusage resourceUsage = {};
+	getrusage(RUSAGE_SELF, &resourceUsage);
+#ifdef __APPLE__
+	usage.peakResidentBytes = static_cast<size_t>(resourceUsage.ru_maxrss); // Bytes on macOS.
+#else
+	usage.peakResidentBytes = static_cast<size_t>(resourceUsage.ru_maxrss) * 1024; // Kilobytes on Linux.
+#endif
+	return usage;
+}
+
+bool EvictFromFileCache(const std::filesystem::path& path)
+{
+#ifdef POSIX_FADV_DONTNEED
+	const int file = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+
+	if (file < 0)
+	{
+		return false;
+	}
+
+	// Dirty pages stay cached, so the pages of a file that has just been written are written back first.
+	fsync(file);
+	const bool evicted = posix_fadvise(file, 0, 0, POSIX_FADV_DONTNEED) == 0;
+	close(file);
+	return evicted;
+#else
+	(void)path;
+	return false;
+#endif
+}
+#endif
+} // namespace vsgl::headless
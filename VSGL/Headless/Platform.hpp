@@ -0,0 +1,20 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+
+namespace vsgl::headless
+{
+// Thin wrappers of OS facilities used by the benchmarks.
+
+struct MemoryUsage
+{
+	size_t residentBytes;     // Current resident set (working set on Windows).
+	size_t peakResidentBytes; // Peak resident set since the process started.
+};
+
+MemoryUsage GetMemoryUsage();
+
+// Drops the cached pages of a file so that the next read comes from the storage device. Returns false if the OS does not support it.
+bool EvictFromFileCache(const std::filesystem::path& path);
+} // namespace vsgl::headless
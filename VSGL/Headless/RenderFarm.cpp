@@ -0,0 +1,296 @@
+#include "CameraPath.hpp"
+#include "Headless.hpp"
+#include "ImageFile.hpp"
+#include "SyntheticScene.hpp"
+
+#include "../CPU/DeferredLighting.hpp"
+#include "../CPU/TaskPool.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace vsgl::headless
+{
+namespace
+{
+constexpr uint32_t SHADOW_MAP_SIZE = 2048;
+
+enum PASS : uint8_t
+{
+	PASS_SHADOW_MAP,
+	PASS_GBUFFER,
+	PASS_LIGHTING,
+	PASS_OUTPUT,
+	PASS_COUNT,
+};
+
+constexpr const char* PASS_NAMES[PASS_COUNT] = {"shadow_map", "gbuffer", "lighting", "output"};
+
+struct FrameTiming
+{
+	uint32_t workerIndex;
+	double milliseconds[PASS_COUNT];
+};
+
+// Mutable per-worker state. A worker renders one frame at a time, so the buffers are reused across its frames without any per-frame allocation.
+struct FrameContext
+{
+	SyntheticScene scene;
+	cpu::Image shadowMap;
+	cpu::GBuffer gbuffer;
+	cpu::DeferredLighting lighting;
+	cpu::ColorImage output;
+	bool hasShadowMap = false; // The shadow map is reused while the spotlight stays still.
+	cpu::Float3 shadowMapEye;
+	cpu::Float3 shadowMapForward;
+};
+
+struct FarmSettings
+{
+	uint32_t width;
+	uint32_t height;
+	cpu::LightingSettings lighting;
+	std::filesystem::path outputDirectory; // Empty to skip writing images.
+	bool frameParallel;
+};
+
+// Renders all the frames and returns the wall-clock seconds.
+// Frame-parallel mode runs one frame per worker: passes called from inside the outer ParallelFor run serially on that worker.
+// Otherwise frames are rendered one after another with the passes parallelized over the pool.
+double RenderFrames(cpu::TaskPool& taskPool, const SyntheticScene& sharedScene, const std::vector<CameraPathFrame>& path, const FarmSettings& settings, std::vector<FrameTiming>& timings)
+{
+	std::vector<std::unique_ptr<FrameContext>> contexts(settings.frameParallel ? taskPool.GetWorkerCount() : 1);
+	timings.assign(path.size(), {});
+
+	const auto renderFrame = [&](const uint32_t frameIndex, const uint32_t workerIndex) {
+		std::unique_ptr<FrameContext>& context = contexts[settings.frameParallel ? workerIndex : 0];
+
+		// Allocated on first use by the worker that owns it so that the pages are local to that worker.
+		if (context == nullptr)
+		{
+			context = std::make_unique<FrameContext>();
+			context->scene = sharedScene;
+			context->shadowMap.Resize(SHADOW_MAP_SIZE, SHADOW_MAP_SIZE);
+			context->gbuffer.Resize(settings.width, settings.height);
+		}
+
+		FrameTiming& timing = timings[frameIndex];
+		timing.workerIndex = workerIndex;
+		SyntheticScene& scene = context->scene;
+		SetCameraPathFrame(path[frameIndex], scene);
+
+		Stopwatch stopwatch;
+		const cpu::Float3 spotlightEye = scene.spotlight.GetPosition();
+		const cpu::Float3 spotlightForward = scene.spotlight.GetForwardVec();
+		const bool spotlightMoved = !context->hasShadowMap || spotlightEye.x != context->shadowMapEye.x || spotlightEye.y != context->shadowMapEye.y || spotlightEye.z != context->shadowMapEye.z ||
+		                            spotlightForward.x != context->shadowMapForward.x || spotlightForward.y != context->shadowMapForward.y || spotlightForward.z != context->shadowMapForward.z;
+
+		if (spotlightMoved)
+		{
+			RenderShadowMap(taskPool, scene, context->shadowMap);
+			context->hasShadowMap = true;
+			context->shadowMapEye = spotlightEye;
+			context->shadowMapForward = spotlightForward;
+		}
+
+		timing.milliseconds[PASS_SHADOW_MAP] = stopwatch.GetMilliseconds();
+
+		stopwatch = {};
+		RenderGBuffer(taskPool, scene, context->gbuffer);
+		timing.milliseconds[PASS_GBUFFER] = stopwatch.GetMilliseconds();
+
+		stopwatch = {};
+		context->lighting.Shade(taskPool, context->gbuffer, context->shadowMap, GetLightingConstants(scene), settings.lighting, context->output);
+		timing.milliseconds[PASS_LIGHTING] = stopwatch.GetMilliseconds();
+
+		stopwatch = {};
+
+		if (!settings.outputDirectory.empty())
+		{
+			char fileName[32];
+			std::snprintf(fileName, sizeof(fileName), "frame%05u.pfm", frameIndex);
+
+			if (!WritePFM(settings.outputDirectory / fileName, context->output))
+			{
+				std::fprintf(stderr, "Cannot write %s.\n", (settings.outputDirectory / fileName).string().c_str());
+			}
+		}
+
+		timing.milliseconds[PASS_OUTPUT] = stopwatch.GetMilliseconds();
+	};
+
+	const Stopwatch stopwatch;
+
+	if (settings.frameParallel)
+	{
+		taskPool.ParallelFor(static_cast<uint32_t>(path.size()), renderFrame);
+	}
+	else
+	{
+		for (uint32_t frameIndex = 0; frameIndex < path.size(); ++frameIndex)
+		{
+			renderFrame(frameIndex, 0);
+		}
+	}
+
+	return stopwatch.GetSeconds();
+}
+
+bool WriteTimings(const std::filesystem::path& path, const std::vector<FrameTiming>& timings)
+{
+	std::FILE* file = std::fopen(path.string().c_str(), "w");
+
+	if (file == nullptr)
+	{
+		return false;
+	}
+
+	std::fprintf(file, "frame,worker");
+
+	for (const char* name : PASS_NAMES)
+	{
+		std::fprintf(file, ",%s_ms", name);
+	}
+
+	std::fprintf(file, ",total_ms\n");
+
+	for (uint32_t frameIndex = 0; frameIndex < timings.size(); ++frameIndex)
+	{
+		const FrameTiming& timing = timings[frameIndex];
+		double total = 0.0;
+		std::fprintf(file, "%u,%u", frameIndex, timing.workerIndex);
+
+		for (const double milliseconds : timing.milliseconds)
+		{
+			std::fprintf(file, ",%.3f", milliseconds);
+			total += milliseconds;
+		}
+
+		std::fprintf(file, ",%.3f\n", total);
+	}
+
+	return std::fclose(file) == 0;
+}
+
+void PrintPassSummary(const std::vector<FrameTiming>& timings)
+{
+	for (uint32_t pass = 0; pass < PASS_COUNT; ++pass)
+	{
+		double sum = 0.0;
+		double maximum = 0.0;
+
+		for (const FrameTiming& timing : timings)
+		{
+			sum += timing.milliseconds[pass];
+			maximum = std::max(maximum, timing.milliseconds[pass]);
+		}
+
+		std::printf("  %-12s mean %9.3f ms  max %9.3f ms\n", PASS_NAMES[pass], sum / static_cast<double>(std::max<size_t>(timings.size(), 1)), maximum);
+	}
+}
+
+// Frame throughput over doubling thread counts up to --threads (or all hardware threads), without writing images.
+// Frames share nothing mutable, so the parallel efficiency should stay close to 1 until memory bandwidth saturates.
+void RunScaling(const SyntheticScene& scene, const std::vector<CameraPathFrame>& path, FarmSettings settings, const uint32_t maxThreadCount)
+{
+	settings.outputDirectory.clear();
+	std::vector<uint32_t> threadCounts;
+
+	for (uint32_t threadCount = 1; threadCount < maxThreadCount; threadCount *= 2)
+	{
+		threadCounts.push_back(threadCount);
+	}
+
+	threadCounts.push_back(maxThreadCount);
+	std::printf("  threads  frames/s  speedup  efficiency\n");
+	double baseFramesPerSecond = 0.0;
+
+	for (const uint32_t threadCount : threadCounts)
+	{
+		cpu::TaskPool taskPool{threadCount};
+		std::vector<FrameTiming> timings;
+		const double seconds = RenderFrames(taskPool, scene, path, settings, timings);
+		const double framesPerSecond = static_cast<double>(path.size()) / seconds;
+		baseFramesPerSecond = (threadCount == 1) ? framesPerSecond : baseFramesPerSecond;
+		const double speedup = framesPerSecond / baseFramesPerSecond;
+		std::printf("  %7u  %8.3f  %7.2f  %9.1f%%\n", threadCount, framesPerSecond, speedup, speedup / threadCount * 100.0);
+	}
+}
+} // namespace
+
+// Offline batch rendering of a camera/spotlight path for quality sweeps.
+// Writes frameNNNNN.pfm and timings.csv into --output. Without --path, an orbit of --frames frames is rendered (and saved with --save-path).
+int RunRenderFarm(const Options& options)
+{
+	FarmSettings settings;
+	settings.width = options.GetUint("width", 960);
+	settings.height = options.GetUint("height", 540);
+	settings.lighting.indirectDownsample = options.GetUint("indirect-downsample", 1);
+	settings.outputDirectory = options.GetString("output", "");
+	settings.frameParallel = options.GetUint("frame-parallel", 1) != 0;
+
+	const SyntheticScene scene = CreateSyntheticScene(settings.width, settings.height);
+	std::vector<CameraPathFrame> path;
+
+	if (options.Has("path"))
+	{
+		if (!LoadCameraPath(options.GetString("path", ""), path))
+		{
+			return 1;
+		}
+	}
+	else
+	{
+		path = CreateOrbitPath(scene, options.GetUint("frames", 64));
+	}
+
+	if (options.Has("save-path") && !SaveCameraPath(options.GetString("save-path", ""), path))
+	{
+		std::fprintf(stderr, "Cannot write %s.\n", options.GetString("save-path", "").c_str());
+		return 1;
+	}
+
+	if (path.empty())
+	{
+		std::fprintf(stderr, "The path has no frame.\n");
+		return 1;
+	}
+
+	const uint32_t threadCount = options.GetUint("threads", 0);
+
+	if (options.Has("scaling"))
+	{
+		const uint32_t maxThreadCount = (threadCount > 0) ? threadCount : std::max(std::thread::hardware_concurrency(), 1u);
+		std::printf("Render farm scaling: %zu frames at %ux%u, up to %u threads\n", path.size(), settings.width, settings.height, maxThreadCount);
+		RunScaling(scene, path, settings, maxThreadCount);
+		return 0;
+	}
+
+	if (!settings.outputDirectory.empty())
+	{
+		std::error_code error;
+		std::filesystem::create_directories(settings.outputDirectory, error);
+	}
+
+	cpu::TaskPool taskPool{threadCount};
+	std::printf("Render farm: %zu frames at %ux%u, %u threads, %s\n", path.size(), settings.width, settings.height, taskPool.GetWorkerCount(), settings.frameParallel ? "frame-parallel" : "pass-parallel");
+
+	std::vector<FrameTiming> timings;
+	const double seconds = RenderFrames(taskPool, scene, path, settings, timings);
+	std::printf("  %.3f s, %.3f frames/s\n", seconds, static_cast<double>(path.size()) / seconds);
+	PrintPassSummary(timings);
+
+	if (!settings.outputDirectory.empty() && !WriteTimings(settings.outputDirectory / "timings.csv", timings))
+	{
+		std::fprintf(stderr, "Cannot write the timings.\n");
+		return 1;
+	}
+
+	return 0;
+}
+} // namespace vsgl::headless
@@ -0,0 +1,95 @@
+#include "Headless.hpp"
+#include "SyntheticScene.hpp"
+
+#include "../../MiniEngine/Model/H3DData.h"
+#include "../CPU/DepthRasterizer.hpp"
+#include "../CPU/TaskPool.hpp"
+
+#include <cstdio>
+#include <sstream>
+#include <vector>
+
+namespace vsgl::headless
+{
+namespace
+{
+// Same models as ModelViewer. The opaque model is drawn with Graphics::RasterizerShadow and the cutout model with RasterizerShadowTwoSided.
+constexpr const char* DEFAULT_MODELS = "../Sponza/sponza.h3d;../Sponza/sponza_cutout.h3d";
+} // namespace
+
+int RunShadowBenchmark(const Options& options)
+{
+	const uint32_t size = options.GetUint("size", 2048);
+	const uint32_t iterations = options.GetUint("iterations", 20);
+	cpu::TaskPool taskPool{options.GetUint("threads", 0)};
+
+	std::vector<H3DData> models;
+	std::vector<cpu::DepthDrawCall> drawCalls;
+	std::stringstream paths{options.GetString("models", DEFAULT_MODELS)};
+	std::string path;
+
+	while (std::getline(paths, path, ';'))
+	{
+		H3DData& model = models.emplace_back();
+
+		if (!model.Load(path))
+		{
+			std::fprintf(stderr, "Skipping %s: cannot load the model.\n", path.c_str());
+			models.pop_back();
+			continue;
+		}
+
+		std::printf("Loaded %s: %u meshes, %u triangles\n", path.c_str(), model.GetMeshCount(), model.GetTriangleCount());
+	}
+
+	// Draws reference the models, so they are created after all the loads.
+	for (const H3DData& model : models)
+	{
+		const cpu::CULL_MODE cullMode = (&model == &models.front() && models.size() > 1) ? cpu::CULL_MODE_BACK : cpu::CULL_MODE_NONE;
+
+		for (uint32_t meshIndex = 0; meshIndex < model.GetMeshCount(); ++meshIndex)
+		{
+			const H3DData::Mesh& mesh = model.GetMesh(meshIndex);
+			drawCalls.push_back({model.GetVertexData() + mesh.vertexDataByteOffset, mesh.vertexStride, mesh.vertexCount, model.GetIndexData() + mesh.indexDataByteOffset / sizeof(uint16_t), mesh.indexCount, cullMode});
+		}
+	}
+
+	if (drawCalls.empty())
+	{
+		std::fprintf(stderr, "No model to render. Specify --models path[;path...].\n");
+		return 1;
+	}
+
+	const SyntheticScene scene = CreateSyntheticScene(size, size);
+	const cpu::DepthBias bias;
+	cpu::DepthRasterizer rasterizer;
+	cpu::Image shadowMap;
+	shadowMap.Resize(size, size);
+
+	std::printf("CPU shadow map: %ux%u, %u threads, SIMD width %u%s\n", size, size, taskPool.GetWorkerCount(), cpu::SIMD_WIDTH, VSGL_SIMD_AVX2 ? " (AVX2)" : " (scalar fallback)");
+	rasterizer.Render(taskPool, scene.spotlight.GetViewProjMatrix(), drawCalls, bias, shadowMap); // Warm up.
+
+	const Stopwatch stopwatch;
+
+	for (uint32_t i = 0; i < iterations; ++i)
+	{
+		rasterizer.Render(taskPool, scene.spotlight.GetViewProjMatrix(), drawCalls, bias, shadowMap);
+	}
+
+	const double seconds = stopwatch.GetSeconds() / iterations;
+	uint32_t coveredCount = 0;
+	double depthSum = 0.0;
+
+	for (uint32_t y = 0; y < size; ++y)
+	{
+		for (uint32_t x = 0; x < size; ++x)
+		{
+			coveredCount += (shadowMap(x, y) > 0.0f) ? 1 : 0;
+			depthSum += shadowMap(x, y);
+		}
+	}
+
+	std::printf("  %-28s %8.3f ms/map %9.2f Mtriangles/s  (%u triangles after culling, %.1f%% covered, mean depth %.6f)\n", "Depth-only rasterization", seconds * 1000.0, static_cast<double>(rasterizer.GetTriangleCount()) / seconds * 1e-6, rasterizer.GetTriangleCount(), 100.0 * coveredCount / (static_cast<double>(size) * size), depthSum / (static_cast<double>(size) * size));
+	return 0;
+}
+} // namespace vsgl::headless
@@ -0,0 +1,219 @@
+#include "SyntheticScene.hpp"
+
+#include "../CPU/TaskPool.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace vsgl::headless
+{
+namespace
+{
+using cpu::Float3;
+
+struct Sphere
+{
+	Float3 center;
+	float radius;
+	float roughness;
+	Float3 diffuse;
+};
+
+constexpr float FLOOR_ROUGHNESS = 0.3f;
+constexpr float WALL_X = 1200.0f;
+constexpr float WALL_ROUGHNESS = 0.8f;
+
+const Sphere SPHERES[] = {
+	{{200.0f, 80.0f, 300.0f}, 80.0f, 0.1f, {0.8f, 0.2f, 0.2f}},
+	{{500.0f, 120.0f, 500.0f}, 120.0f, 0.5f, {0.2f, 0.8f, 0.2f}},
+	{{700.0f, 60.0f, 250.0f}, 60.0f, 0.9f, {0.2f, 0.2f, 0.8f}},
+};
+
+struct Hit
+{
+	float t = std::numeric_limits<float>::infinity();
+	Float3 position;
+	Float3 normal;
+	Float3 tangent;
+	Float3 diffuse;
+	float roughness = 1.0f;
+	float u = 0.0f;
+	float v = 0.0f;
+};
+
+Hit Intersect(const Float3& origin, const Float3& dir)
+{
+	Hit hit;
+
+	// Floor (y = 0).
+	if (dir.y < 0.0f)
+	{
+		const float t = -origin.y / dir.y;
+		hit.t = t;
+		hit.position = origin + dir * t;
+		hit.normal = {0.0f, 1.0f, 0.0f};
+		hit.tangent = {1.0f, 0.0f, 0.0f};
+		const bool checker = ((static_cast<int>(std::floor(hit.position.x / 100.0f)) + static_cast<int>(std::floor(hit.position.z / 100.0f))) & 1) != 0;
+		hit.diffuse = checker ? Float3{0.7f, 0.7f, 0.7f} : Float3{0.3f, 0.3f, 0.3f};
+		hit.roughness = FLOOR_ROUGHNESS;
+		hit.u = hit.position.x / 50.0f;
+		hit.v = hit.position.z / 50.0f;
+	}
+
+	// Wall (x = WALL_X).
+	if (dir.x > 0.0f)
+	{
+		const float t = (WALL_X - origin.x) / dir.x;
+
+		if (t > 0.0f && t < hit.t)
+		{
+			hit.t = t;
+			hit.position = origin + dir * t;
+			hit.normal = {-1.0f, 0.0f, 0.0f};
+			hit.tangent = {0.0f, 0.0f, 1.0f};
+			hit.diffuse = {0.6f, 0.5f, 0.4f};
+			hit.roughness = WALL_ROUGHNESS;
+			hit.u = hit.position.z / 30.0f;
+			hit.v = hit.position.y / 30.0f;
+		}
+	}
+
+	for (const Sphere& sphere : SPHERES)
+	{
+		const Float3 oc = origin - sphere.center;
+		const float a = cpu::Dot(dir, dir);
+		const float b = cpu::Dot(oc, dir);
+		const float c = cpu::Dot(oc, oc) - sphere.radius * sphere.radius;
+		const float discriminant = b * b - a * c;
+
+		if (discriminant < 0.0f)
+		{
+			continue;
+		}
+
+		const float t = (-b - std::sqrt(discriminant)) / a;
+
+		if (t > 0.0f && t < hit.t)
+		{
+			hit.t = t;
+			hit.position = origin + dir * t;
+			hit.normal = (hit.position - sphere.center) / sphere.radius;
+			const Float3 tangent = cpu::Cross(Float3{0.0f, 1.0f, 0.0f}, hit.normal);
+			hit.tangent = (cpu::Dot(tangent, tangent) > 1e-6f) ? cpu::Normalize(tangent) : Float3{1.0f, 0.0f, 0.0f};
+			hit.diffuse = sphere.diffuse;
+			hit.roughness = sphere.roughness;
+			hit.u = std::atan2(hit.normal.z, hit.normal.x) * 8.0f;
+			hit.v = std::acos(std::clamp(hit.normal.y, -1.0f, 1.0f)) * 8.0f;
+		}
+	}
+
+	return hit;
+}
+} // namespace
+
+SyntheticScene CreateSyntheticScene(const uint32_t width, const uint32_t height)
+{
+	constexpr float NEAR_Z_CLIP = 1.0f;
+	constexpr float FAR_Z_CLIP = 10000.0f;
+
+	// Same initial camera and spotlight as ModelViewer.
+	SyntheticScene scene;
+	const Float3 cameraPos = {-500.0f, 200.0f, 400.0f};
+	scene.camera.SetEyeAtUp(cameraPos, cameraPos + Float3{1.0f, -0.2f, 0.0f}, {0.0f, 1.0f, 0.0f});
+	scene.camera.SetZRange(NEAR_Z_CLIP, FAR_Z_CLIP);
+	scene.camera.SetAspectRatio(static_cast<float>(height) / static_cast<float>(width));
+
+	const Float3 lightPos = {300.0f, 150.0f, 400.0f};
+	scene.spotlight.SetEyeAtUp(lightPos, lightPos + Float3{1.0f, -0.5f, -1.0f}, {0.0f, 1.0f, 0.0f});
+	scene.spotlight.SetZRange(NEAR_Z_CLIP, FAR_Z_CLIP);
+	scene.spotlight.SetAspectRatio(1.0f);
+
+	// Plausible VSGLs around the spotlight footprint on the floor: a broad diffuse one and a sharper glossy one.
+	scene.sgLights[0] = {{600.0f, 5.0f, 100.0f}, 10000.0f, {200000.0f, 190000.0f, 180000.0f}, 2.0f, {0.0f, 1.0f, 0.0f}, 0};
+	scene.sgLights[1] = {{600.0f, 5.0f, 100.0f}, 2500.0f, {50000.0f, 50000.0f, 50000.0f}, 20.0f, {0.6666667f, 0.3333333f, -0.6666667f}, 0};
+	return scene;
+}
+
+void RenderGBuffer(cpu::TaskPool& taskPool, const SyntheticScene& scene, cpu::GBuffer& gbuffer)
+{
+	const uint32_t width = gbuffer.GetWidth();
+	const uint32_t height = gbuffer.GetHeight();
+
+	taskPool.ParallelFor(height, [&](const uint32_t y, uint32_t) {
+		for (uint32_t x = 0; x < width; ++x)
+		{
+			const float ndcX = (static_cast<float>(x) + 0.5f) / static_cast<float>(width) * 2.0f - 1.0f;
+			const float ndcY = 1.0f - (static_cast<float>(y) + 0.5f) / static_cast<float>(height) * 2.0f;
+			const Float3 dir = scene.camera.GetRayDirection(ndcX, ndcY);
+			const Hit hit = Intersect(scene.camera.GetPosition(), dir);
+			const bool covered = std::isfinite(hit.t) && hit.t < scene.camera.GetFarClip();
+			const auto set = [&](const cpu::GBUFFER_PLANE plane, const float value) { gbuffer.GetPlane(plane)(x, y) = value; };
+
+			if (!covered)
+			{
+				set(cpu::GBUFFER_DEPTH, cpu::GBuffer::CLEAR_DEPTH);
+				continue;
+			}
+
+			// dir has a unit forward component, so t is the view depth.
+			set(cpu::GBUFFER_DEPTH, scene.camera.DistanceToDepth(hit.t));
+			set(cpu::GBUFFER_POSITION_X, hit.position.x);
+			set(cpu::GBUFFER_POSITION_Y, hit.position.y);
+			set(cpu::GBUFFER_POSITION_Z, hit.position.z);
+			set(cpu::GBUFFER_NORMAL_X, hit.normal.x);
+			set(cpu::GBUFFER_NORMAL_Y, hit.normal.y);
+			set(cpu::GBUFFER_NORMAL_Z, hit.normal.z);
+			set(cpu::GBUFFER_TANGENT_X, hit.tangent.x);
+			set(cpu::GBUFFER_TANGENT_Y, hit.tangent.y);
+			set(cpu::GBUFFER_TANGENT_Z, hit.tangent.z);
+			set(cpu::GBUFFER_BITANGENT_SIGN, 1.0f);
+			set(cpu::GBUFFER_NORMAL_MAP_X, 0.25f * std::sin(hit.u));
+			set(cpu::GBUFFER_NORMAL_MAP_Y, 0.25f * std::sin(hit.v));
+			set(cpu::GBUFFER_DIFFUSE_R, hit.diffuse.x);
+			set(cpu::GBUFFER_DIFFUSE_G, hit.diffuse.y);
+			set(cpu::GBUFFER_DIFFUSE_B, hit.diffuse.z);
+			set(cpu::GBUFFER_SPECULAR_R, 0.04f);
+			set(cpu::GBUFFER_SPECULAR_G, 0.04f);
+			set(cpu::GBUFFER_SPECULAR_B, 0.04f);
+			set(cpu::GBUFFER_ROUGHNESS, hit.roughness);
+		}
+	});
+}
+
+void RenderShadowMap(cpu::TaskPool& taskPool, const SyntheticScene& scene, cpu::Image& shadowMap)
+{
+	const uint32_t width = shadowMap.GetWidth();
+	const uint32_t height = shadowMap.GetHeight();
+
+	taskPool.ParallelFor(height, [&](const uint32_t y, uint32_t) {
+		for (uint32_t x = 0; x < width; ++x)
+		{
+			const float ndcX = (static_cast<float>(x) + 0.5f) / static_cast<float>(width) * 2.0f - 1.0f;
+			const float ndcY = 1.0f - (static_cast<float>(y) + 0.5f) / static_cast<float>(height) * 2.0f;
+			const Hit hit = Intersect(scene.spotlight.GetPosition(), scene.spotlight.GetRayDirection(ndcX, ndcY));
+
+			// Push the depth slightly away from the light in place of the depth bias of Graphics::RasterizerShadow.
+			constexpr float DEPTH_BIAS_SCALE = 1.002f;
+			shadowMap(x, y) = std::isfinite(hit.t) ? std::max(scene.spotlight.DistanceToDepth(hit.t * DEPTH_BIAS_SCALE), 0.0f) : 0.0f;
+		}
+	});
+}
+
+cpu::LightingConstants GetLightingConstants(const SyntheticScene& scene)
+{
+	cpu::LightingConstants constants{};
+	constants.viewProj = scene.camera.GetViewProjMatrix();
+	constants.lightViewProj = scene.spotlight.GetViewProjMatrix();
+	constants.cameraPosition = scene.camera.GetPosition();
+	constants.lightPosition = scene.spotlight.GetPosition();
+	constants.lightIntensity = scene.spotlightIntensity;
+
+	for (uint32_t i = 0; i < cpu::SG_LIGHT_COUNT; ++i)
+	{
+		constants.sgLights[i] = scene.sgLights[i];
+	}
+
+	return constants;
+}
+} // namespace vsgl::headless
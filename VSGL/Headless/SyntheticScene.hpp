@@ -0,0 +1,28 @@
+#pragma once
+
+#include "../CPU/Camera.hpp"
+#include "../CPU/DeferredLighting.hpp"
+#include "../CPU/Image.hpp"
+
+namespace vsgl::cpu
+{
+class TaskPool;
+}
+
+namespace vsgl::headless
+{
+// Analytic test scene (floor, wall and spheres) that is ray cast into a G-buffer and shadow map.
+// It provides deterministic LightingPS inputs with varied normals, roughness and shadowing without loading any assets.
+struct SyntheticScene
+{
+	cpu::Camera camera;
+	cpu::Camera spotlight;
+	float spotlightIntensity = 4000000.0f;
+	cpu::SGLight sgLights[cpu::SG_LIGHT_COUNT];
+};
+
+SyntheticScene CreateSyntheticScene(uint32_t width, uint32_t height);
+void RenderGBuffer(cpu::TaskPool& taskPool, const SyntheticScene& scene, cpu::GBuffer& gbuffer);
+void RenderShadowMap(cpu::TaskPool& taskPool, const SyntheticScene& scene, cpu::Image& shadowMap);
+cpu::LightingConstants GetLightingConstants(const SyntheticScene& scene);
+} // namespace vsgl::headless
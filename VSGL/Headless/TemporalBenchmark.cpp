@@ -0,0 +1,116 @@
+#include "Headless.hpp"
+#include "ImageMetrics.hpp"
+#include "SyntheticScene.hpp"
+
+#include "../CPU/DeferredLighting.hpp"
+#include "../CPU/TaskPool.hpp"
+
+#include <algorithm>
+#include <cstdio>
+
+namespace vsgl::headless
+{
+// Amortized cost and convergence of the temporal SG lighting cache.
+// The camera strafes and turns for --moving-frames frames and then stops for --static-frames frames. Each frame is compared against the lighting without reuse,
+// and the error is summarized separately for the frames while the camera moves and after it stops.
+int RunTemporalBenchmark(const Options& options)
+{
+	const uint32_t width = options.GetUint("width", 960);
+	const uint32_t height = options.GetUint("height", 540);
+	const uint32_t movingFrameCount = options.GetUint("moving-frames", 24);
+	const uint32_t staticFrameCount = options.GetUint("static-frames", 8);
+	const float speed = options.GetFloat("speed", 4.0f); // Units per frame.
+	cpu::TaskPool taskPool{options.GetUint("threads", 0)};
+
+	SyntheticScene scene = CreateSyntheticScene(width, height);
+	const cpu::Float3 startPosition = scene.camera.GetPosition();
+	const cpu::Float3 forward = scene.camera.GetForwardVec();
+	const cpu::Float3 right = scene.camera.GetRightVec();
+	const cpu::Float3 up = {0.0f, 1.0f, 0.0f};
+
+	cpu::GBuffer gbuffer;
+	gbuffer.Resize(width, height);
+	cpu::Image shadowMap;
+	shadowMap.Resize(2048, 2048);
+	RenderShadowMap(taskPool, scene, shadowMap);
+
+	cpu::LightingSettings referenceSettings;
+	cpu::LightingSettings temporalSettings;
+	temporalSettings.temporalIndirect = true;
+	cpu::DeferredLighting referenceLighting;
+	cpu::DeferredLighting temporalLighting;
+	cpu::ColorImage reference;
+	cpu::ColorImage output;
+
+	std::printf("Temporal SG lighting: %ux%u, %u threads, refresh period %u, %.1f units/frame\n", width, height, taskPool.GetWorkerCount(), temporalSettings.temporalRefreshPeriod, speed);
+	std::printf("  frame  moving  reference ms  temporal ms  shaded blocks  relative RMSE\n");
+
+	double referenceTotal = 0.0;
+	double temporalTotal = 0.0;
+	double movingErrorTotal = 0.0;
+	double movingErrorMax = 0.0;
+	double staticErrorMax = 0.0;
+	double lastError = 0.0;
+	const uint32_t frameCount = movingFrameCount + staticFrameCount;
+
+	for (uint32_t frame = 0; frame < frameCount; ++frame)
+	{
+		const bool moving = frame < movingFrameCount;
+		const float t = static_cast<float>(std::min(frame, movingFrameCount));
+		const cpu::Float3 eye = startPosition + right * (speed * t);
+		const cpu::Float3 target = eye + forward + right * (0.002f * t); // Slowly turn toward the strafing direction as well.
+		scene.camera.SetEyeAtUp(eye, target, up);
+		RenderGBuffer(taskPool, scene, gbuffer);
+		const cpu::LightingConstants constants = GetLightingConstants(scene);
+
+		const Stopwatch referenceStopwatch;
+		referenceLighting.Shade(taskPool, gbuffer, shadowMap, constants, referenceSettings, reference);
+		const double referenceMilliseconds = referenceStopwatch.GetMilliseconds();
+
+		const Stopwatch temporalStopwatch;
+		temporalLighting.Shade(taskPool, gbuffer, shadowMap, constants, temporalSettings, output);
+		const double temporalMilliseconds = temporalStopwatch.GetMilliseconds();
+
+		const cpu::LightingStatistics& statistics = temporalLighting.GetStatistics();
+		const double shadedRatio = static_cast<double>(statistics.indirectBlockCount) / std::max(statistics.coveredBlockCount, 1u);
+		const ImageError error = CompareImages(output, reference);
+		std::printf("  %5u  %6s  %12.3f  %11.3f  %12.1f%%  %13.5f\n", frame, moving ? "yes" : "no", referenceMilliseconds, temporalMilliseconds, shadedRatio * 100.0, error.relativeRMSE);
+
+		// The first frame has no history and is excluded from the amortized cost and the error while moving.
+		if (frame > 0)
+		{
+			referenceTotal += referenceMilliseconds;
+			temporalTotal += temporalMilliseconds;
+
+			if (moving)
+			{
+				movingErrorTotal += error.relativeRMSE;
+				movingErrorMax = std::max(movingErrorMax, error.relativeRMSE);
+			}
+			else
+			{
+				staticErrorMax = std::max(staticErrorMax, error.relativeRMSE);
+			}
+		}
+
+		lastError = error.relativeRMSE;
+	}
+
+	if (frameCount > 1)
+	{
+		std::printf("Amortized: reference %.3f ms/frame, temporal %.3f ms/frame (%.2fx)\n", referenceTotal / (frameCount - 1), temporalTotal / (frameCount - 1), referenceTotal / temporalTotal);
+	}
+
+	if (movingFrameCount > 1)
+	{
+		std::printf("Relative RMSE while moving: mean %.5f, max %.5f\n", movingErrorTotal / (movingFrameCount - 1), movingErrorMax);
+	}
+
+	if (staticFrameCount > 0)
+	{
+		std::printf("Relative RMSE after stopping: max %.5f, last frame %.5f\n", staticErrorMax, lastError);
+	}
+
+	return 0;
+}
+} // namespace vsgl::headless
@@ -0,0 +1,239 @@
+#include "Headless.hpp"
+
+#include "../CPU/TaskPool.hpp"
+#include "../CPU/Texture.hpp"
+#include "../CPU/TextureCache.hpp"
+#include "../CPU/TextureSampler.hpp"
+#include "../../MiniEngine/Core/MappedFile.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <numeric>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace vsgl::headless
+{
+namespace
+{
+constexpr const char* DEFAULT_TEXTURES = "../Sponza/textures";
+constexpr const char* DEFAULT_BUDGETS = "1;2;4;8;0";
+constexpr float EYE_HEIGHT = 1.7f;     // Above the floor, in meters.
+constexpr float CEILING_HEIGHT = 2.5f; // Above the eye.
+constexpr float CELL_SIZE = 2.0f;      // Each cell of the floor and the ceiling has its own texture, which repeats every meter.
+constexpr float MAX_DISTANCE = 60.0f;
+constexpr float SPEED = 0.5f; // Meters per frame.
+
+struct PixelSample
+{
+	cpu::Vec2<float> texcoord;
+	cpu::Vec2<float> ddx;
+	cpu::Vec2<float> ddy;
+	uint32_t texture;
+};
+
+// A corridor with a floor and a ceiling of textured cells, seen by a camera that walks forward: the pixel's texcoord and its analytic derivatives.
+// Returns false for the pixels that see no surface within MAX_DISTANCE.
+bool GetPixelSample(const uint32_t x, const uint32_t y, const uint32_t width, const uint32_t height, const uint32_t frame, const uint32_t textureCount, PixelSample& sample)
+{
+	const float focal = static_cast<float>(height);
+	const float px = (static_cast<float>(x) + 0.5f - 0.5f * static_cast<float>(width)) / focal;
+	const float py = (static_cast<float>(y) + 0.5f - 0.5f * static_cast<float>(height)) / focal;
+	const float planeHeight = py > 0.0f ? EYE_HEIGHT : CEILING_HEIGHT;
+	const float slope = std::abs(py);
+	const float distance = planeHeight / std::max(slope, 1.0e-6f);
+
+	if (distance > MAX_DISTANCE)
+	{
+		return false;
+	}
+
+	const float lateral = px * distance;
+	const float forward = distance + SPEED * static_cast<float>(frame);
+
+	// d(distance)/dy = -planeHeight / slope^2 / focal, with the sign of py.
+	const float dDistance = -(py > 0.0f ? 1.0f : -1.0f) * distance / slope / focal;
+	sample.texcoord = {lateral, forward};
+	sample.ddx = {distance / focal, 0.0f};
+	sample.ddy = {px * dDistance, dDistance};
+
+	const int32_t cellX = static_cast<int32_t>(std::floor(lateral / CELL_SIZE));
+	const int32_t cellY = static_cast<int32_t>(std::floor(forward / CELL_SIZE)) * 2 + (py > 0.0f ? 0 : 1);
+	uint32_t hash = static_cast<uint32_t>(cellX) * 0x9E3779B1u ^ static_cast<uint32_t>(cellY) * 0x85EBCA77u;
+	hash ^= hash >> 15;
+	hash *= 0x2C1B3C6Du;
+	hash ^= hash >> 12;
+	sample.texture = hash % textureCount;
+	return true;
+}
+
+struct ShadingResult
+{
+	double seconds = 0.0;
+	double checksum = 0.0;
+};
+
+// Shades frames with anisotropic SampleGrad(), rows in parallel, and calls endFrame() between frames as a renderer would.
+template <typename TextureType, typename EndFrame>
+ShadingResult ShadeFrames(const std::vector<cpu::TextureSampler<TextureType>>& samplers, const uint32_t width, const uint32_t height, const uint32_t frameCount, cpu::TaskPool& taskPool,
+                          const EndFrame& endFrame)
+{
+	std::vector<double> sums(taskPool.GetWorkerCount() * 8, 0.0);
+	const Stopwatch stopwatch;
+
+	for (uint32_t frame = 0; frame < frameCount; ++frame)
+	{
+		taskPool.ParallelFor(height, [&](const uint32_t y, const uint32_t worker) {
+			float sum = 0.0f;
+
+			for (uint32_t x = 0; x < width; ++x)
+			{
+				PixelSample sample;
+
+				if (GetPixelSample(x, y, width, height, frame, static_cast<uint32_t>(samplers.size()), sample))
+				{
+					const cpu::Float4 color = samplers[sample.texture].SampleGrad(sample.texcoord, sample.ddx, sample.ddy);
+					sum += color.x + color.y + color.z;
+				}
+			}
+
+			sums[worker * 8] += sum;
+		});
+
+		endFrame();
+	}
+
+	return {stopwatch.GetSeconds(), std::accumulate(sums.begin(), sums.end(), 0.0)};
+}
+} // namespace
+
+// Sampling through the tiled TextureCache against fully decoded textures, for several budgets: the tiles decoded and evicted, the peak memory and the
+// shading throughput of a walk through a corridor textured with every DDS file of the directory.
+int RunTextureCacheBenchmark(const Options& options)
+{
+	const uint32_t width = std::max(options.GetUint("width", 640), 1u);
+	const uint32_t height = std::max(options.GetUint("height", 360), 1u);
+	const uint32_t frameCount = std::max(options.GetUint("frames", 16), 1u);
+	const std::filesystem::path directory = options.GetString("textures", DEFAULT_TEXTURES);
+	const cpu::SamplerDesc samplerDesc;
+	cpu::TaskPool taskPool{options.GetUint("threads", 0)};
+
+	std::vector<std::string> fileNames;
+	std::error_code error;
+
+	for (const std::filesystem::directory_entry& entry : std::filesystem::directory_iterator(directory, error))
+	{
+		std::string extension = entry.path().extension().string();
+		std::transform(extension.begin(), extension.end(), extension.begin(), [](const char c) { return static_cast<char>(std::tolower(static_cast<unsigned char>(c))); });
+
+		if (extension == ".dds")
+		{
+			fileNames.push_back(entry.path().filename().string());
+		}
+	}
+
+	std::sort(fileNames.begin(), fileNames.end());
+
+	// The reference decodes every mip chain up front.
+	std::vector<cpu::Texture> textures;
+	std::vector<std::string> decodedFileNames; // So that both paths shade the same cells.
+	size_t decodedBytes = 0;
+	size_t texelCount = 0;
+
+	for (const std::string& fileName : fileNames)
+	{
+		Utility::MappedFile file;
+		cpu::Texture texture;
+
+		if (!file.Open((directory / fileName).string()) || !texture.Decode(file.GetData(), file.GetSize(), taskPool))
+		{
+			std::fprintf(stderr, "Skipping %s: cannot decode it.\n", fileName.c_str());
+			continue;
+		}
+
+		decodedBytes += texture.GetDecodedSize();
+		texelCount += texture.GetDecodedSize() / texture.GetTexelSize();
+		textures.push_back(std::move(texture));
+		decodedFileNames.push_back(fileName);
+	}
+
+	if (textures.empty())
+	{
+		std::fprintf(stderr, "No DDS files in %s. Specify --textures directory.\n", directory.string().c_str());
+		return 1;
+	}
+
+	std::vector<cpu::TextureSampler<cpu::Texture>> referenceSamplers;
+
+	for (const cpu::Texture& texture : textures)
+	{
+		referenceSamplers.emplace_back(texture, samplerDesc);
+	}
+
+	// Texel fetches of a run, for the hit rate per fetch.
+	uint64_t fetchCount = 0;
+
+	for (uint32_t frame = 0; frame < frameCount; ++frame)
+	{
+		for (uint32_t y = 0; y < height; ++y)
+		{
+			for (uint32_t x = 0; x < width; ++x)
+			{
+				PixelSample sample;
+
+				if (GetPixelSample(x, y, width, height, frame, static_cast<uint32_t>(textures.size()), sample))
+				{
+					const cpu::TextureSampler<cpu::Texture>& sampler = referenceSamplers[sample.texture];
+					fetchCount += sampler.GetFetchCount(sampler.GetFootprint(sample.ddx, sample.ddy));
+				}
+			}
+		}
+	}
+
+	const double pixels = static_cast<double>(width) * height * frameCount;
+	std::printf("%zu textures in %s, %ux%u, %u frames, anisotropic %ux, %u threads\n", textures.size(), directory.string().c_str(), width, height, frameCount, samplerDesc.maxAnisotropy,
+	            taskPool.GetWorkerCount());
+	std::printf("  fully decoded: %.1f MB (%.1f MB as RGBA32F)\n", decodedBytes * 1.0e-6, texelCount * 16.0e-6);
+
+	const ShadingResult reference = ShadeFrames(referenceSamplers, width, height, frameCount, taskPool, [] {});
+	std::printf("  %-12s %10.2f Mpixels/s %37s %10.1f MB\n", "no cache", pixels / reference.seconds * 1.0e-6, "", decodedBytes * 1.0e-6);
+	std::printf("  %-12s %21s %12s %14s %10s %10s\n", "budget", "", "hit rate", "tiles/frame", "evicted", "peak");
+
+	std::stringstream budgets{options.GetString("budgets", DEFAULT_BUDGETS)};
+	std::string budgetText;
+
+	while (std::getline(budgets, budgetText, ';'))
+	{
+		const size_t budget = static_cast<size_t>(std::strtod(budgetText.c_str(), nullptr) * 1.0e6);
+		cpu::TextureCache cache{directory.string() + "/", budget};
+		std::vector<cpu::TextureSampler<cpu::CachedTexture>> samplers;
+
+		for (const std::string& fileName : decodedFileNames)
+		{
+			samplers.emplace_back(*cache.Load(fileName), samplerDesc);
+		}
+
+		const ShadingResult result = ShadeFrames(samplers, width, height, frameCount, taskPool, [&] { cache.EndFrame(); });
+		const cpu::TextureCache::Stats stats = cache.GetStats();
+
+		// The sums of the workers add up in another order.
+		if (std::abs(result.checksum - reference.checksum) > 1.0e-4 * std::abs(reference.checksum))
+		{
+			std::fprintf(stderr, "The cached textures do not sample like the decoded ones.\n");
+			return 1;
+		}
+
+		char name[32];
+		std::snprintf(name, sizeof(name), budget > 0 ? "%g MB" : "unlimited", budget * 1.0e-6);
+		std::printf("  %-12s %10.2f Mpixels/s %10.4f%% %14.1f %10llu %7.1f MB\n", name, pixels / result.seconds * 1.0e-6, 100.0 * (1.0 - static_cast<double>(stats.decodedTiles) / fetchCount),
+		            static_cast<double>(stats.decodedTiles) / frameCount, static_cast<unsigned long long>(stats.evictedTiles), stats.peakBytes * 1.0e-6);
+	}
+
+	return 0;
+}
+} // namespace vsgl::headless
@@ -0,0 +1,271 @@
+#include "Headless.hpp"
+
+#include "../CPU/BlockCompression.hpp"
+#include "../CPU/TaskPool.hpp"
+#include "../CPU/Texture.hpp"
+#include "../CPU/TextureSampler.hpp"
+#include "../../MiniEngine/Core/MappedFile.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <limits>
+#include <map>
+#include <memory>
+#include <numbers>
+#include <numeric>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace vsgl::headless
+{
+namespace
+{
+constexpr const char* DEFAULT_TEXTURES = "../Sponza/textures";
+constexpr uint32_t SAMPLE_BATCH_SIZE = 4096;
+
+#if defined(__AVX2__)
+constexpr const char* DECODER_NAME = "AVX2 for BC1-BC5";
+#else
+constexpr const char* DECODER_NAME = "scalar build";
+#endif
+
+struct TextureFile
+{
+	std::string name;
+	std::unique_ptr<Utility::MappedFile> file;
+	DXGI_FORMAT format;
+};
+
+struct Sample
+{
+	cpu::Vec2<float> texcoord;
+	cpu::Vec2<float> ddx;
+	cpu::Vec2<float> ddy;
+};
+
+const char* FormatName(const DXGI_FORMAT format)
+{
+	switch (format)
+	{
+	case DXGI_FORMAT_BC1_UNORM: return "BC1_UNORM";
+	case DXGI_FORMAT_BC1_UNORM_SRGB: return "BC1_UNORM_SRGB";
+	case DXGI_FORMAT_BC2_UNORM: return "BC2_UNORM";
+	case DXGI_FORMAT_BC2_UNORM_SRGB: return "BC2_UNORM_SRGB";
+	case DXGI_FORMAT_BC3_UNORM: return "BC3_UNORM";
+	case DXGI_FORMAT_BC3_UNORM_SRGB: return "BC3_UNORM_SRGB";
+	case DXGI_FORMAT_BC4_UNORM: return "BC4_UNORM";
+	case DXGI_FORMAT_BC4_SNORM: return "BC4_SNORM";
+	case DXGI_FORMAT_BC5_UNORM: return "BC5_UNORM";
+	case DXGI_FORMAT_BC5_SNORM: return "BC5_SNORM";
+	case DXGI_FORMAT_BC6H_UF16: return "BC6H_UF16";
+	case DXGI_FORMAT_BC6H_SF16: return "BC6H_SF16";
+	case DXGI_FORMAT_BC7_UNORM: return "BC7_UNORM";
+	case DXGI_FORMAT_BC7_UNORM_SRGB: return "BC7_UNORM_SRGB";
+	case DXGI_FORMAT_R8G8B8A8_UNORM: return "R8G8B8A8_UNORM";
+	case DXGI_FORMAT_R8G8B8A8_UNORM_SRGB: return "R8G8B8A8_UNORM_SRGB";
+	case DXGI_FORMAT_B8G8R8A8_UNORM: return "B8G8R8A8_UNORM";
+	case DXGI_FORMAT_B8G8R8X8_UNORM: return "B8G8R8X8_UNORM";
+	default: return "other";
+	}
+}
+
+template <typename Function>
+double BestSeconds(const uint32_t iterations, const Function& function)
+{
+	double seconds = std::numeric_limits<double>::max();
+
+	for (uint32_t iteration = 0; iteration < iterations; ++iteration)
+	{
+		const Stopwatch stopwatch;
+		function();
+		seconds = std::min(seconds, stopwatch.GetSeconds());
+	}
+
+	return seconds;
+}
+
+// Pixels of surfaces seen at random angles and distances: footprints of 1/2 to 16 texels, stretched up to 8 times along a random direction.
+std::vector<Sample> MakeSamples(const uint32_t count, const cpu::Texture& texture)
+{
+	std::mt19937 random(1);
+	std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+	std::vector<Sample> samples(count);
+
+	for (Sample& sample : samples)
+	{
+		const float size = std::exp2(unit(random) * 5.0f - 1.0f);
+		const float stretch = 1.0f + unit(random) * 7.0f;
+		const float angle = unit(random) * 2.0f * std::numbers::pi_v<float>;
+		const float scaleX = size / static_cast<float>(texture.GetWidth());
+		const float scaleY = size / static_cast<float>(texture.GetHeight());
+		sample.texcoord = {unit(random) * 4.0f - 2.0f, unit(random) * 4.0f - 2.0f};
+		sample.ddx = {std::cos(angle) * stretch * scaleX, std::sin(angle) * stretch * scaleY};
+		sample.ddy = {-std::sin(angle) * scaleX, std::cos(angle) * scaleY};
+	}
+
+	return samples;
+}
+} // namespace
+
+// Decode throughput of the CPU texture decoder per DDS format, on one thread and on the pool, and the sampling rate of the decoded texture with the
+// bilinear, trilinear and anisotropic filters of TextureSampler.
+int RunTextureDecodeBenchmark(const Options& options)
+{
+	const uint32_t iterations = std::max(options.GetUint("iterations", 3), 1u);
+	const uint32_t sampleCount = std::max(options.GetUint("samples", 1 << 20), 1u);
+	const std::filesystem::path directory = options.GetString("textures", DEFAULT_TEXTURES);
+	cpu::TaskPool serialPool{1};
+	cpu::TaskPool taskPool{options.GetUint("threads", 0)};
+
+	std::vector<TextureFile> textures;
+	std::error_code error;
+
+	for (const std::filesystem::directory_entry& entry : std::filesystem::directory_iterator(directory, error))
+	{
+		std::string extension = entry.path().extension().string();
+		std::transform(extension.begin(), extension.end(), extension.begin(), [](const char c) { return static_cast<char>(std::tolower(static_cast<unsigned char>(c))); });
+
+		if (extension != ".dds")
+		{
+			continue;
+		}
+
+		TextureFile texture{entry.path().filename().string(), std::make_unique<Utility::MappedFile>(), DXGI_FORMAT_UNKNOWN};
+		DDSTextureInfo info;
+
+		if (!texture.file->Open(entry.path().string()) || !GetDDSTextureInfo(texture.file->GetData(), texture.file->GetSize(), info))
+		{
+			std::fprintf(stderr, "Skipping %s: cannot read the DDS file.\n", texture.name.c_str());
+			continue;
+		}
+
+		texture.format = info.format;
+		textures.push_back(std::move(texture));
+	}
+
+	if (textures.empty())
+	{
+		std::fprintf(stderr, "No DDS files in %s. Specify --textures directory.\n", directory.string().c_str());
+		return 1;
+	}
+
+	std::map<DXGI_FORMAT, std::vector<const TextureFile*>> formats;
+
+	for (const TextureFile& texture : textures)
+	{
+		formats[texture.format].push_back(&texture);
+	}
+
+	std::printf("%zu textures in %s, decoder: %s, %u threads\n", textures.size(), directory.string().c_str(), DECODER_NAME, taskPool.GetWorkerCount());
+	std::printf("  %-20s %6s %10s %12s %12s %14s %12s\n", "format", "files", "MB", "1 thread", "", "all threads", "");
+
+	for (const auto& [format, files] : formats)
+	{
+		cpu::Texture texture;
+		size_t sourceBytes = 0;
+		size_t texels = 0;
+		bool decoded = true;
+
+		for (const TextureFile* file : files)
+		{
+			decoded &= texture.Decode(file->file->GetData(), file->file->GetSize(), taskPool);
+
+			for (uint32_t mip = 0; mip < texture.GetMipCount(); ++mip)
+			{
+				texels += size_t{texture.GetMip(mip).width} * texture.GetMip(mip).height;
+			}
+
+			sourceBytes += texture.GetSourceSize();
+		}
+
+		if (!decoded)
+		{
+			std::printf("  %-20s %6zu %10s cannot be decoded\n", FormatName(format), files.size(), "");
+			continue;
+		}
+
+		const auto decodeAll = [&](cpu::TaskPool& pool) {
+			for (const TextureFile* file : files)
+			{
+				texture.Decode(file->file->GetData(), file->file->GetSize(), pool);
+			}
+		};
+
+		const double serialSeconds = BestSeconds(iterations, [&] { decodeAll(serialPool); });
+		const double parallelSeconds = BestSeconds(iterations, [&] { decodeAll(taskPool); });
+		std::printf("  %-20s %6zu %10.2f %7.1f MB/s %7.1f Mtex/s %9.1f MB/s %7.1f Mtex/s\n", FormatName(format), files.size(), sourceBytes * 1.0e-6, sourceBytes / serialSeconds * 1.0e-6,
+		            texels / serialSeconds * 1.0e-6, sourceBytes / parallelSeconds * 1.0e-6, texels / parallelSeconds * 1.0e-6);
+	}
+
+	// Sampling reads the largest color texture, as the material textures of the G-buffer are read.
+	const TextureFile* sampled = &textures[0];
+
+	for (const TextureFile& texture : textures)
+	{
+		if (cpu::GetDecodedFormat(texture.format) == DXGI_FORMAT_R8G8B8A8_UNORM_SRGB && (cpu::GetDecodedFormat(sampled->format) != DXGI_FORMAT_R8G8B8A8_UNORM_SRGB || texture.file->GetSize() > sampled->file->GetSize()))
+		{
+			sampled = &texture;
+		}
+	}
+
+	cpu::Texture texture;
+
+	if (!texture.Decode(sampled->file->GetData(), sampled->file->GetSize(), taskPool))
+	{
+		std::fprintf(stderr, "Cannot decode %s for sampling.\n", sampled->name.c_str());
+		return 1;
+	}
+
+	const std::vector<Sample> samples = MakeSamples(sampleCount, texture);
+	const uint32_t batchCount = (sampleCount + SAMPLE_BATCH_SIZE - 1) / SAMPLE_BATCH_SIZE;
+	std::printf("Sampling %s (%ux%u, %u mips, %s), %u samples with wrap addressing\n", sampled->name.c_str(), texture.GetWidth(), texture.GetHeight(), texture.GetMipCount(), FormatName(sampled->format),
+	            sampleCount);
+
+	const struct
+	{
+		const char* name;
+		cpu::SamplerDesc desc;
+	} filters[] = {
+	    {"bilinear", {cpu::TEXTURE_FILTER_BILINEAR, 1, 0.0f}},
+	    {"trilinear", {cpu::TEXTURE_FILTER_TRILINEAR, 1, 0.0f}},
+	    {"anisotropic 4x", {cpu::TEXTURE_FILTER_ANISOTROPIC, 4, 0.0f}},
+	};
+
+	for (const auto& filter : filters)
+	{
+		const cpu::TextureSampler sampler{texture, filter.desc};
+		size_t fetches = 0;
+
+		for (const Sample& sample : samples)
+		{
+			fetches += sampler.GetFetchCount(sampler.GetFootprint(sample.ddx, sample.ddy));
+		}
+
+		// Per-worker sums keep the samples from being optimized away.
+		std::vector<float> sums(taskPool.GetWorkerCount() * 16, 0.0f);
+		const double seconds = BestSeconds(iterations, [&] {
+			taskPool.ParallelFor(batchCount, [&](const uint32_t batch, const uint32_t worker) {
+				const uint32_t end = std::min((batch + 1) * SAMPLE_BATCH_SIZE, sampleCount);
+				float sum = 0.0f;
+
+				for (uint32_t i = batch * SAMPLE_BATCH_SIZE; i < end; ++i)
+				{
+					const cpu::Float4 color = sampler.SampleGrad(samples[i].texcoord, samples[i].ddx, samples[i].ddy);
+					sum += color.x + color.y + color.z + color.w;
+				}
+
+				sums[worker * 16] += sum;
+			});
+		});
+
+		std::printf("  %-16s %8.2f Msamples/s %6.1f texels/sample %8.1f Mtexels/s (checksum %.3g)\n", filter.name, sampleCount / seconds * 1.0e-6, static_cast<double>(fetches) / sampleCount,
+		            fetches / seconds * 1.0e-6, std::accumulate(sums.begin(), sums.end(), 0.0));
+	}
+
+	return 0;
+}
+} // namespace vsgl::headless
@@ -0,0 +1,239 @@
+#include "Headless.hpp"
+
+#include "../../MiniEngine/Core/DDSFormat.h"
+#include "../../MiniEngine/Core/IOThreadPool.h"
+#include "../../MiniEngine/Core/ShardedCache.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cstdio>
+#include <filesystem>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace vsgl::headless
+{
+namespace
+{
+constexpr const char* DEFAULT_TEXTURES = "../Sponza/textures";
+
+// ManagedTexture without D3D12: creating it parses the DDS header and copies the texels to an upload buffer, the CPU side of CreateDDSTextureFromMemory().
+struct MockTexture
+{
+	std::atomic<bool> isLoading = true;
+	std::promise<void> loaded;
+	std::shared_future<void> loadedFuture = loaded.get_future().share();
+	std::vector<uint8_t> uploadBuffer;
+	bool isValid = false;
+
+	void CreateFromMemory(const Utility::FileData& data)
+	{
+		DDSTextureInfo info;
+
+		if (!data->empty() && GetDDSTextureInfo(data->data(), data->size(), info))
+		{
+			uploadBuffer.assign(info.bitData, info.bitData + info.bitSize);
+			isValid = true;
+		}
+	}
+};
+
+// TextureManager before: one mutex for the map, a hit that is still loading is waited for with the mutex held, and the loading thread reads the file.
+class GlobalMutexTextureManager
+{
+  public:
+	explicit GlobalMutexTextureManager(const std::string& rootPath) : m_rootPath(rootPath) {}
+
+	const MockTexture* FindOrLoad(const std::string& fileName)
+	{
+		MockTexture* texture;
+
+		{
+			const std::lock_guard<std::mutex> lock(m_mutex);
+			std::unique_ptr<MockTexture>& entry = m_textures[fileName];
+
+			if (entry != nullptr)
+			{
+				while (entry->isLoading.load(std::memory_order_acquire))
+				{
+					std::this_thread::yield();
+				}
+
+				return entry.get();
+			}
+
+			entry = std::make_unique<MockTexture>();
+			texture = entry.get();
+		}
+
+		texture->CreateFromMemory(Utility::IOThreadPool::ReadFile(m_rootPath + fileName));
+		texture->isLoading.store(false, std::memory_order_release);
+		return texture;
+	}
+
+  private:
+	std::string m_rootPath;
+	std::mutex m_mutex;
+	std::map<std::string, std::unique_ptr<MockTexture>> m_textures;
+};
+
+// TextureManager after: a sharded map, loads waited for outside of the locks, and files read by the I/O threads, ahead of the requests.
+class ShardedTextureManager
+{
+  public:
+	ShardedTextureManager(const std::string& rootPath, const uint32_t ioThreadCount, const std::vector<std::string>& readAheads)
+	    : m_rootPath(rootPath), m_ioThreadPool(ioThreadCount, static_cast<uint32_t>(readAheads.size()))
+	{
+		for (const std::string& fileName : readAheads)
+		{
+			m_ioThreadPool.ReadAhead(m_rootPath + fileName);
+		}
+	}
+
+	const MockTexture* FindOrLoad(const std::string& fileName)
+	{
+		MockTexture* texture = nullptr;
+		bool mustLoad = false;
+		m_textures.FindOrInsert(fileName, [] { return std::make_unique<MockTexture>(); },
+		                        [&](std::unique_ptr<MockTexture>& entry, const bool inserted) {
+			                        texture = entry.get();
+			                        mustLoad = inserted;
+		                        });
+
+		if (!mustLoad)
+		{
+			texture->loadedFuture.wait();
+			return texture;
+		}
+
+		texture->CreateFromMemory(m_ioThreadPool.Read(m_rootPath + fileName).get());
+		texture->loaded.set_value();
+		return texture;
+	}
+
+  private:
+	std::string m_rootPath;
+	Utility::IOThreadPool m_ioThreadPool;
+	Utility::ShardedCache<std::string, std::unique_ptr<MockTexture>> m_textures;
+};
+
+// Every thread requests every texture requestsPerTexture times in its own order, as material loaders that share textures do. Returns the seconds,
+// including the creation of the manager which starts the read-aheads, and whether every request got a valid texture.
+template <typename CreateTextureManager>
+std::pair<double, bool> LoadTextures(const CreateTextureManager& createTextureManager, const std::vector<std::string>& fileNames, const uint32_t threadCount,
+                                     const uint32_t requestsPerTexture)
+{
+	std::vector<std::vector<uint32_t>> orders(threadCount);
+
+	for (uint32_t thread = 0; thread < threadCount; ++thread)
+	{
+		std::mt19937 random{thread};
+
+		for (uint32_t request = 0; request < requestsPerTexture; ++request)
+		{
+			for (uint32_t texture = 0; texture < fileNames.size(); ++texture)
+			{
+				orders[thread].push_back(texture);
+			}
+		}
+
+		std::shuffle(orders[thread].begin(), orders[thread].end(), random);
+	}
+
+	std::atomic<bool> valid = true;
+	std::vector<std::thread> threads;
+	const Stopwatch stopwatch;
+	const auto textureManager = createTextureManager();
+
+	for (uint32_t thread = 0; thread < threadCount; ++thread)
+	{
+		threads.emplace_back([&, thread] {
+			for (const uint32_t texture : orders[thread])
+			{
+				if (!textureManager->FindOrLoad(fileNames[texture])->isValid)
+				{
+					valid.store(false, std::memory_order_relaxed);
+				}
+			}
+		});
+	}
+
+	for (std::thread& thread : threads)
+	{
+		thread.join();
+	}
+
+	return {stopwatch.GetSeconds(), valid.load()};
+}
+} // namespace
+
+// Loads every DDS file of a directory from 1 to --max-threads threads at once through a TextureManager with a global mutex (as it was) and with the
+// sharded cache, futures and I/O threads. Only the CPU side of texture creation is modeled. The files are in the OS cache after the first run.
+int RunTextureManagerBenchmark(const Options& options)
+{
+	const std::filesystem::path directory = options.GetString("textures", DEFAULT_TEXTURES);
+	const uint32_t maxThreadCount = std::max(options.GetUint("max-threads", 32), 1u);
+	const uint32_t ioThreadCount = std::max(options.GetUint("io-threads", 4), 1u);
+	const uint32_t requestsPerTexture = std::max(options.GetUint("requests", 4), 1u);
+	const uint32_t iterations = std::max(options.GetUint("iterations", 3), 1u);
+	const std::string rootPath = directory.string() + "/";
+
+	std::vector<std::string> fileNames;
+	std::error_code error;
+
+	for (const std::filesystem::directory_entry& entry : std::filesystem::directory_iterator(directory, error))
+	{
+		std::string extension = entry.path().extension().string();
+		std::transform(extension.begin(), extension.end(), extension.begin(), [](const char c) { return static_cast<char>(std::tolower(static_cast<unsigned char>(c))); });
+
+		if (extension == ".dds")
+		{
+			fileNames.push_back(entry.path().filename().string());
+		}
+	}
+
+	if (fileNames.empty())
+	{
+		std::fprintf(stderr, "No DDS files in %s. Specify --textures directory.\n", directory.string().c_str());
+		return 1;
+	}
+
+	std::sort(fileNames.begin(), fileNames.end());
+	std::printf("%zu textures in %s, %u requests per texture and thread, %u I/O threads, best of %u\n", fileNames.size(), directory.string().c_str(), requestsPerTexture,
+	            ioThreadCount, iterations);
+	std::printf("  %8s %14s %14s %10s\n", "threads", "global mutex", "sharded", "speedup");
+
+	for (uint32_t threadCount = 1; threadCount <= maxThreadCount; threadCount *= 2)
+	{
+		double globalSeconds = 1.0e30;
+		double shardedSeconds = 1.0e30;
+
+		for (uint32_t iteration = 0; iteration < iterations; ++iteration)
+		{
+			const auto [seconds, valid] = LoadTextures([&] { return std::make_unique<GlobalMutexTextureManager>(rootPath); }, fileNames, threadCount, requestsPerTexture);
+			const auto [shardedRunSeconds, shardedValid] =
+			    LoadTextures([&] { return std::make_unique<ShardedTextureManager>(rootPath, ioThreadCount, fileNames); }, fileNames, threadCount, requestsPerTexture);
+
+			if (!valid || !shardedValid)
+			{
+				std::fprintf(stderr, "Some textures failed to load.\n");
+				return 1;
+			}
+
+			globalSeconds = std::min(globalSeconds, seconds);
+			shardedSeconds = std::min(shardedSeconds, shardedRunSeconds);
+		}
+
+		std::printf("  %8u %11.2f ms %11.2f ms %9.2fx\n", threadCount, globalSeconds * 1.0e3, shardedSeconds * 1.0e3, globalSeconds / shardedSeconds);
+	}
+
+	return 0;
+}
+} // namespace vsgl::headless
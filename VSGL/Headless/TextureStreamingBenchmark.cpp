@@ -0,0 +1,469 @@
+#include "Headless.hpp"
+#include "Platform.hpp"
+
+#include "../CPU/Camera.hpp"
+#include "../../MiniEngine/Core/IOThreadPool.h"
+#include "../../MiniEngine/Core/TextureStreamer.h"
+#include "../../MiniEngine/Model/H3DData.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <map>
+#include <numbers>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace vsgl::headless
+{
+namespace
+{
+constexpr const char* DEFAULT_MODELS = "../Sponza/sponza.h3d;../Sponza/sponza_cutout.h3d";
+constexpr const char* DEFAULT_BUDGETS = "0;4;2";
+constexpr size_t UPLOAD_RING_BYTES = 64 * 1024 * 1024; // Of the mock sink, like the upload heap pages of DynAlloc.
+constexpr double MB = 1024.0 * 1024.0;
+
+// Copies mips into an upload ring, as UpdateSubresources() copies them into an upload heap, and keeps nothing else. It stands in for the GPU, so the times
+// include the CPU copies of uploads but no transfer.
+class MockUploadSink : public Utility::TextureUploadSink
+{
+  public:
+	MockUploadSink() : m_ring(UPLOAD_RING_BYTES) {}
+
+	bool CreateTexture(const uint32_t textureIndex, const DDSTextureInfo& info) override
+	{
+		m_infos.resize(std::max<size_t>(m_infos.size(), textureIndex + 1));
+		m_infos[textureIndex] = info;
+		return true;
+	}
+
+	void UploadMips(const uint32_t textureIndex, const uint32_t firstMip, const uint32_t mipCount, const DDSSubresourceData* subresources) override
+	{
+		const DDSTextureInfo& info = m_infos[textureIndex];
+
+		for (uint32_t slice = 0; slice < info.arraySize; ++slice)
+		{
+			for (uint32_t mip = firstMip; mip < firstMip + mipCount; ++mip)
+			{
+				const DDSSubresourceData& subresource = *subresources++;
+				Copy(subresource.pData, subresource.SlicePitch * std::max(info.depth >> mip, 1u));
+			}
+		}
+	}
+
+	void EvictMips(uint32_t, uint32_t) override {}
+
+  private:
+	void Copy(const uint8_t* data, size_t size)
+	{
+		while (size > 0)
+		{
+			if (m_offset == m_ring.size())
+			{
+				m_offset = 0;
+			}
+
+			const size_t chunk = std::min(size, m_ring.size() - m_offset);
+			std::memcpy(m_ring.data() + m_offset, data, chunk);
+			m_offset += chunk;
+			data += chunk;
+			size -= chunk;
+		}
+	}
+
+	std::vector<DDSTextureInfo> m_infos;
+	std::vector<uint8_t> m_ring;
+	size_t m_offset = 0;
+};
+
+struct Scene
+{
+	std::vector<H3DData> models;
+	std::vector<std::string> texturePaths;
+	std::vector<std::vector<uint32_t>> materialTextures; // Indices into texturePaths of the diffuse, specular and normal textures, per material of all models.
+	std::vector<uint32_t> materialOffsets;               // Of each model in materialTextures.
+	std::vector<std::vector<float>> texcoordDensities;   // Per mesh of each model.
+};
+
+// The file that ModelH3D::LoadTextures() opens for a texture path of a material: the path without its extension and with ".dds". File systems that are case
+// sensitive need the ".DDS" of the Sponza files as well.
+std::string FindTexture(const std::filesystem::path& basePath, const std::string& path)
+{
+	if (path.empty())
+	{
+		return {};
+	}
+
+	const std::filesystem::path stem = (basePath / path).replace_extension();
+
+	for (const char* extension : {".dds", ".DDS"})
+	{
+		std::filesystem::path file = stem;
+		file += extension;
+
+		if (std::filesystem::exists(file))
+		{
+			return file.string();
+		}
+	}
+
+	return {};
+}
+
+// The textures of the materials, with the fallbacks of ModelH3D::LoadTextures(): <diffuse>_specular.dds and <diffuse>_normal.dds.
+bool LoadScene(const Options& options, Scene& scene)
+{
+	std::stringstream paths{options.GetString("models", DEFAULT_MODELS)};
+	std::string path;
+	std::map<std::string, uint32_t> textureIndices;
+
+	const auto addTexture = [&](const std::string& file) {
+		const auto [it, inserted] = textureIndices.emplace(file, static_cast<uint32_t>(scene.texturePaths.size()));
+
+		if (inserted)
+		{
+			scene.texturePaths.push_back(file);
+		}
+
+		return it->second;
+	};
+
+	while (std::getline(paths, path, ';'))
+	{
+		H3DData& model = scene.models.emplace_back();
+
+		if (!model.Load(path))
+		{
+			std::fprintf(stderr, "Skipping %s: cannot load the model.\n", path.c_str());
+			scene.models.pop_back();
+			continue;
+		}
+
+		const std::filesystem::path basePath = std::filesystem::path{path}.parent_path();
+		scene.materialOffsets.push_back(static_cast<uint32_t>(scene.materialTextures.size()));
+
+		for (uint32_t materialIndex = 0; materialIndex < model.GetMaterialCount(); ++materialIndex)
+		{
+			const H3DData::Material& material = model.GetMaterial(materialIndex);
+			const std::string diffuse = FindTexture(basePath, material.texDiffusePath);
+			std::string specular = FindTexture(basePath, material.texSpecularPath);
+			std::string normal = FindTexture(basePath, material.texNormalPath);
+
+			if (specular.empty() && material.texDiffusePath[0] != '\0')
+			{
+				specular = FindTexture(basePath, std::string{material.texDiffusePath} + "_specular");
+			}
+
+			if (normal.empty() && material.texDiffusePath[0] != '\0')
+			{
+				normal = FindTexture(basePath, std::string{material.texDiffusePath} + "_normal");
+			}
+
+			std::vector<uint32_t>& textures = scene.materialTextures.emplace_back();
+
+			for (const std::string& file : {diffuse, specular, normal})
+			{
+				if (!file.empty())
+				{
+					textures.push_back(addTexture(file));
+				}
+			}
+		}
+
+		std::vector<float>& densities = scene.texcoordDensities.emplace_back();
+
+		for (uint32_t meshIndex = 0; meshIndex < model.GetMeshCount(); ++meshIndex)
+		{
+			densities.push_back(model.ComputeTexcoordDensity(meshIndex));
+		}
+	}
+
+	// Files that no material references stay at their tails. Without sponza.h3d they stand in for its textures at startup.
+	if (options.Has("textures"))
+	{
+		std::error_code error;
+
+		for (const std::filesystem::directory_entry& entry : std::filesystem::directory_iterator(options.GetString("textures", ""), error))
+		{
+			std::string extension = entry.path().extension().string();
+			std::transform(extension.begin(), extension.end(), extension.begin(), [](const char c) { return static_cast<char>(std::tolower(static_cast<unsigned char>(c))); });
+
+			if (extension == ".dds" && !textureIndices.contains(entry.path().string()))
+			{
+				addTexture(entry.path().string());
+			}
+		}
+	}
+
+	return !scene.models.empty() && !scene.texturePaths.empty();
+}
+
+// The camera walks through the ModelViewer camera, the nave and the gallery and back, turning around twice.
+cpu::Camera GetCamera(const uint32_t frame, const uint32_t frameCount, const uint32_t width, const uint32_t height)
+{
+	const cpu::Float3 POSITIONS[] = {{-500.0f, 200.0f, 400.0f}, {0.0f, 150.0f, 0.0f}, {700.0f, 450.0f, -150.0f}, {-500.0f, 200.0f, 400.0f}};
+	const float t = static_cast<float>(frame) / static_cast<float>(std::max(frameCount - 1, 1u));
+	const float segment = t * static_cast<float>(std::size(POSITIONS) - 1);
+	const uint32_t index = std::min(static_cast<uint32_t>(segment), static_cast<uint32_t>(std::size(POSITIONS) - 2));
+	const float s = segment - static_cast<float>(index);
+	const cpu::Float3 eye = POSITIONS[index] * (1.0f - s) + POSITIONS[index + 1] * s;
+	const float angle = 4.0f * std::numbers::pi_v<float> * t;
+
+	cpu::Camera camera;
+	camera.SetZRange(1.0f, 10000.0f);
+	camera.SetAspectRatio(static_cast<float>(height) / static_cast<float>(width));
+	camera.SetEyeAtUp(eye, eye + cpu::Float3{std::cos(angle), -0.2f, std::sin(angle)}, {0.0f, 1.0f, 0.0f});
+	return camera;
+}
+
+// All eight corners of the box are outside one of the side planes of the frustum, or behind the eye.
+bool IsOutsideFrustum(const H3DData::BoundingBox& box, const cpu::Float4x4& viewProj)
+{
+	uint32_t outside[5] = {};
+
+	for (uint32_t corner = 0; corner < 8; ++corner)
+	{
+		const float p[3] = {(corner & 1) ? box.max[0] : box.min[0], (corner & 2) ? box.max[1] : box.min[1], (corner & 4) ? box.max[2] : box.min[2]};
+		float clip[4];
+
+		for (uint32_t c = 0; c < 4; ++c)
+		{
+			clip[c] = p[0] * viewProj.m[0][c] + p[1] * viewProj.m[1][c] + p[2] * viewProj.m[2][c] + viewProj.m[3][c];
+		}
+
+		outside[0] += clip[0] < -clip[3] ? 1 : 0;
+		outside[1] += clip[0] > clip[3] ? 1 : 0;
+		outside[2] += clip[1] < -clip[3] ? 1 : 0;
+		outside[3] += clip[1] > clip[3] ? 1 : 0;
+		outside[4] += clip[3] <= 0.0f ? 1 : 0;
+	}
+
+	return std::any_of(std::begin(outside), std::end(outside), [](const uint32_t count) { return count == 8; });
+}
+
+// Requests the mips of the textures of the meshes in view.
+void RequestVisibleTextures(const Scene& scene, const std::vector<uint32_t>& textureIndices, const cpu::Camera& camera, const Utility::StreamingView& view,
+                            Utility::TextureStreamer& streamer)
+{
+	const cpu::Float4x4 viewProj = camera.GetViewProjMatrix();
+
+	for (size_t modelIndex = 0; modelIndex < scene.models.size(); ++modelIndex)
+	{
+		const H3DData& model = scene.models[modelIndex];
+
+		for (uint32_t meshIndex = 0; meshIndex < model.GetMeshCount(); ++meshIndex)
+		{
+			const H3DData::Mesh& mesh = model.GetMesh(meshIndex);
+
+			if (IsOutsideFrustum(mesh.boundingBox, viewProj))
+			{
+				continue;
+			}
+
+			for (const uint32_t texture : scene.materialTextures[scene.materialOffsets[modelIndex] + mesh.materialIndex])
+			{
+				if (textureIndices[texture] != Utility::TextureStreamer::kInvalidTexture)
+				{
+					streamer.RequestForBounds(textureIndices[texture], mesh.boundingBox.min, mesh.boundingBox.max, view, scene.texcoordDensities[modelIndex][meshIndex]);
+				}
+			}
+		}
+	}
+}
+
+void EvictTextures(const Scene& scene, bool& evicted)
+{
+	evicted = true;
+
+	for (const std::string& path : scene.texturePaths)
+	{
+		evicted = EvictFromFileCache(path) && evicted;
+	}
+}
+
+struct StartupResult
+{
+	double milliseconds = 0.0;
+	size_t residentBytes = 0;
+};
+
+// What TextureManager::LoadDDSFromFile() does for each texture: read the whole file and upload every mip.
+StartupResult LoadAllMips(const Scene& scene)
+{
+	MockUploadSink sink;
+	StartupResult result;
+	const Stopwatch stopwatch;
+
+	for (uint32_t textureIndex = 0; textureIndex < scene.texturePaths.size(); ++textureIndex)
+	{
+		const Utility::FileData file = Utility::IOThreadPool::ReadFile(scene.texturePaths[textureIndex]);
+		DDSTextureInfo info;
+
+		if (!GetDDSTextureInfo(file->data(), file->size(), info))
+		{
+			continue;
+		}
+
+		std::vector<DDSSubresourceData> subresources(size_t{info.mipCount} * info.arraySize);
+		size_t width = 0, height = 0, depth = 0, skipMip = 0;
+
+		if (FillDDSSubresourceData(info.width, info.height, info.depth, info.mipCount, info.arraySize, info.format, 0, info.bitSize, info.bitData, width, height, depth, skipMip,
+		                           subresources.data()) &&
+		    sink.CreateTexture(textureIndex, info))
+		{
+			sink.UploadMips(textureIndex, 0, info.mipCount, subresources.data());
+
+			for (size_t i = 0; i < subresources.size(); ++i)
+			{
+				result.residentBytes += subresources[i].SlicePitch * std::max(info.depth >> (i % info.mipCount), 1u);
+			}
+		}
+	}
+
+	result.milliseconds = stopwatch.GetMilliseconds();
+	return result;
+}
+
+struct StreamingResult
+{
+	StartupResult startup;
+	size_t totalBytes = 0;
+	uint32_t firstViewFrames = 0;    // Until the requests of the first view are met.
+	double firstViewMilliseconds = 0.0; // Of the updates until then.
+	uint32_t unsettledFrames = 0;
+	double meanUpdateMilliseconds = 0.0;
+	double maxUpdateMilliseconds = 0.0;
+	double maxUploadBytes = 0.0;
+	double steadyResidentBytes = 0.0; // Mean over the second half of the path.
+	size_t peakResidentBytes = 0;
+};
+
+// Loads the tails of the textures, then waits for the first view to be met, and then walks the camera path with one Update() per frame.
+StreamingResult StreamTextures(const Scene& scene, const Utility::TextureStreamerOptions& streamerOptions, const uint32_t frameCount, const uint32_t width,
+                               const uint32_t height)
+{
+	MockUploadSink sink;
+	Utility::TextureStreamer streamer{sink, streamerOptions};
+	StreamingResult result;
+	std::vector<uint32_t> textureIndices;
+
+	{
+		const Stopwatch stopwatch;
+
+		for (const std::string& path : scene.texturePaths)
+		{
+			textureIndices.push_back(streamer.AddTexture(path));
+		}
+
+		result.startup.milliseconds = stopwatch.GetMilliseconds();
+		result.startup.residentBytes = streamer.GetResidentBytes();
+		result.totalBytes = streamer.GetTotalBytes();
+	}
+
+	const auto update = [&](const uint32_t frame) {
+		const cpu::Camera camera = GetCamera(frame, frameCount, width, height);
+		const cpu::Float3& eye = camera.GetPosition();
+		const Utility::StreamingView view = {{eye.x, eye.y, eye.z}, 0.5f * static_cast<float>(height) * camera.GetProjScaleY(), static_cast<float>(width) * static_cast<float>(height)};
+		RequestVisibleTextures(scene, textureIndices, camera, view, streamer);
+
+		const Stopwatch stopwatch;
+		const size_t uploadedBytes = streamer.Update();
+		const double milliseconds = stopwatch.GetMilliseconds();
+		result.maxUploadBytes = std::max(result.maxUploadBytes, static_cast<double>(uploadedBytes));
+		result.peakResidentBytes = std::max(result.peakResidentBytes, streamer.GetResidentBytes());
+		return milliseconds;
+	};
+
+	do
+	{
+		result.firstViewMilliseconds += update(0);
+		++result.firstViewFrames;
+	} while (!streamer.IsSettled() && result.firstViewFrames < 1000);
+
+	for (uint32_t frame = 0; frame < frameCount; ++frame)
+	{
+		const double milliseconds = update(frame);
+		result.meanUpdateMilliseconds += milliseconds / frameCount;
+		result.maxUpdateMilliseconds = std::max(result.maxUpdateMilliseconds, milliseconds);
+		result.unsettledFrames += streamer.IsSettled() ? 0 : 1;
+
+		if (frame >= frameCount / 2)
+		{
+			result.steadyResidentBytes += static_cast<double>(streamer.GetResidentBytes()) / (frameCount - frameCount / 2);
+		}
+	}
+
+	return result;
+}
+} // namespace
+
+// Startup with every mip of every texture, as ModelH3D::LoadTextures() loads them through TextureManager, against streaming: the mip tails at startup and the
+// larger mips on demand while the camera walks through Sponza, with mips and priorities from the screen footprints of the mesh bounds. Uploads go to a mock sink
+// that copies them into an upload ring. Reports the time to the first frame cold and warm, the frames until the first view has its mips, the update cost per
+// frame and the steady-state and peak resident memory for each --budgets (MB, 0 for no budget).
+int RunTextureStreamingBenchmark(const Options& options)
+{
+	const uint32_t width = options.GetUint("width", 1920);
+	const uint32_t height = options.GetUint("height", 1080);
+	const uint32_t frameCount = std::max(options.GetUint("frames", 600), 2u);
+	Utility::TextureStreamerOptions streamerOptions;
+	streamerOptions.TailSize = std::max(options.GetUint("tail", 64), 1u);
+	streamerOptions.UploadBytesPerFrame = static_cast<size_t>(options.GetFloat("upload-mb", 4.0f) * MB);
+
+	Scene scene;
+
+	if (!LoadScene(options, scene))
+	{
+		std::fprintf(stderr, "No textures to stream. Specify --models model.h3d;... and optionally --textures directory.\n");
+		return 1;
+	}
+
+	std::printf("%zu textures of %zu models, %ux%u, mip tails of at most %ux%u, %.1f MB uploaded per frame at most, mock upload sink\n", scene.texturePaths.size(),
+	            scene.models.size(), width, height, streamerOptions.TailSize, streamerOptions.TailSize, static_cast<double>(streamerOptions.UploadBytesPerFrame) / MB);
+
+	// Time to the first frame: cold, with the files evicted from the OS cache, and warm.
+	bool evicted = false;
+	EvictTextures(scene, evicted);
+	const StartupResult coldAll = LoadAllMips(scene);
+	const StartupResult warmAll = LoadAllMips(scene);
+	EvictTextures(scene, evicted);
+	const StreamingResult coldStreaming = StreamTextures(scene, streamerOptions, frameCount, width, height);
+
+	std::printf("  %-28s %12s %12s %14s\n", "first frame", "cold", "warm", "resident");
+	const auto printStartup = [&](const char* name, const StartupResult& cold, const StartupResult& warm) {
+		std::printf("  %-28s %9.2f ms %9.2f ms %11.2f MB\n", name, evicted ? cold.milliseconds : 0.0, warm.milliseconds, static_cast<double>(warm.residentBytes) / MB);
+	};
+
+	printStartup("all mips (TextureManager)", coldAll, warmAll);
+
+	std::stringstream budgets{options.GetString("budgets", DEFAULT_BUDGETS)};
+	std::string budget;
+	bool first = true;
+
+	while (std::getline(budgets, budget, ';'))
+	{
+		streamerOptions.MemoryBudget = static_cast<size_t>(std::stof(budget) * MB);
+		const StreamingResult result = StreamTextures(scene, streamerOptions, frameCount, width, height);
+
+		if (first)
+		{
+			printStartup("mip tails (TextureStreamer)", coldStreaming.startup, result.startup);
+			std::printf("%s", evicted ? "" : "  (the OS cannot evict the files from its cache, so the cold column is empty)\n");
+			std::printf("  %.2f MB of mips in all. Streaming along %u frames, warm:\n", static_cast<double>(result.totalBytes) / MB, frameCount);
+			std::printf("  %-10s %14s %10s %12s %12s %12s %12s %10s\n", "budget", "first view", "", "update", "max update", "max upload", "steady", "peak");
+			first = false;
+		}
+
+		std::printf("  %-10s %7u frames %7.2f ms %9.3f ms %9.3f ms %9.2f MB %9.2f MB %7.2f MB%s\n", streamerOptions.MemoryBudget > 0 ? (budget + " MB").c_str() : "none",
+		            result.firstViewFrames, result.firstViewMilliseconds, result.meanUpdateMilliseconds, result.maxUpdateMilliseconds, result.maxUploadBytes / MB,
+		            result.steadyResidentBytes / MB, static_cast<double>(result.peakResidentBytes) / MB,
+		            result.unsettledFrames > 0 ? (", " + std::to_string(result.unsettledFrames) + " frames short of mips").c_str() : "");
+	}
+
+	return 0;
+}
+} // namespace vsgl::headless
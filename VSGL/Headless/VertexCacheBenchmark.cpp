@@ -0,0 +1,239 @@
+#include "Headless.hpp"
+
+#include "../../MiniEngine/Model/H3DData.h"
+#include "../../MiniEngine/Model/IndexOptimizePostTransform.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <filesystem>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace vsgl::headless
+{
+namespace
+{
+constexpr uint32_t CACHE_SIZES[] = {16, 24, 32, 48, 64};
+
+// Triangle lists of one scene. Each list is optimized on its own, as OptimizeMesh() does per primitive.
+struct MeshSet
+{
+	std::string name;
+	std::vector<std::vector<uint32_t>> indexLists;
+};
+
+enum class Optimizer
+{
+	NONE,
+	FORSYTH,
+	TIPSIFY,
+};
+
+MeshSet LoadH3DMeshes(const H3DData& model, const std::string& name)
+{
+	MeshSet meshSet{name, {}};
+
+	for (uint32_t meshIndex = 0; meshIndex < model.GetMeshCount(); ++meshIndex)
+	{
+		const H3DData::Mesh& mesh = model.GetMesh(meshIndex);
+		const uint16_t* indices = model.GetIndexData() + mesh.indexDataByteOffset / sizeof(uint16_t);
+		meshSet.indexLists.emplace_back(indices, indices + mesh.indexCount);
+	}
+
+	return meshSet;
+}
+
+// A gridSize x gridSize vertex grid in row order, which is how tessellators and heightfields emit it.
+MeshSet GenerateGrid(const uint32_t gridSize)
+{
+	MeshSet meshSet{"grid" + std::to_string(gridSize), {{}}};
+	std::vector<uint32_t>& indices = meshSet.indexLists[0];
+
+	for (uint32_t y = 0; y + 1 < gridSize; ++y)
+	{
+		for (uint32_t x = 0; x + 1 < gridSize; ++x)
+		{
+			const uint32_t v = y * gridSize + x;
+			indices.insert(indices.end(), {v, v + gridSize, v + 1, v + 1, v + gridSize, v + gridSize + 1});
+		}
+	}
+
+	return meshSet;
+}
+
+// The same triangles in a random order, the worst case for the dead-end restart.
+MeshSet Shuffle(const MeshSet& source)
+{
+	MeshSet meshSet{source.name + "-shuffled", {}};
+	std::mt19937 random(1);
+
+	for (const std::vector<uint32_t>& sourceIndices : source.indexLists)
+	{
+		std::vector<uint32_t> order(sourceIndices.size() / 3);
+
+		for (uint32_t i = 0; i < order.size(); ++i)
+		{
+			order[i] = i;
+		}
+
+		std::shuffle(order.begin(), order.end(), random);
+		std::vector<uint32_t>& indices = meshSet.indexLists.emplace_back();
+
+		for (const uint32_t triangle : order)
+		{
+			indices.insert(indices.end(), sourceIndices.begin() + triangle * 3, sourceIndices.begin() + triangle * 3 + 3);
+		}
+	}
+
+	return meshSet;
+}
+
+void Optimize(const Optimizer optimizer, const std::vector<uint32_t>& indices, std::vector<uint32_t>& optimized, const uint32_t cacheSize)
+{
+	switch (optimizer)
+	{
+	case Optimizer::NONE:
+		optimized = indices;
+		break;
+	case Optimizer::FORSYTH:
+		OptimizeFacesForsyth(indices.data(), indices.size(), optimized.data(), cacheSize);
+		break;
+	case Optimizer::TIPSIFY:
+		OptimizeFacesTipsify(indices.data(), indices.size(), optimized.data(), cacheSize);
+		break;
+	}
+}
+
+// Both optimizers only reorder whole triangles and keep their winding.
+bool IsTrianglePermutation(const std::vector<uint32_t>& a, const std::vector<uint32_t>& b)
+{
+	const auto sortedTriangles = [](const std::vector<uint32_t>& indices) {
+		std::vector<std::array<uint32_t, 3>> triangles(indices.size() / 3);
+
+		for (size_t i = 0; i < triangles.size(); ++i)
+		{
+			const uint32_t* corners = indices.data() + i * 3;
+			const size_t first = static_cast<size_t>(std::min_element(corners, corners + 3) - corners);
+			triangles[i] = {corners[first], corners[(first + 1) % 3], corners[(first + 2) % 3]};
+		}
+
+		std::sort(triangles.begin(), triangles.end());
+		return triangles;
+	};
+
+	return a.size() == b.size() && sortedTriangles(a) == sortedTriangles(b);
+}
+
+bool RunMeshSet(const MeshSet& meshSet, const uint32_t iterations)
+{
+	constexpr struct
+	{
+		const char* name;
+		Optimizer optimizer;
+	} OPTIMIZERS[] = {{"input", Optimizer::NONE}, {"forsyth", Optimizer::FORSYTH}, {"tipsify", Optimizer::TIPSIFY}};
+
+	size_t triangleCount = 0;
+
+	for (const std::vector<uint32_t>& indices : meshSet.indexLists)
+	{
+		triangleCount += indices.size() / 3;
+	}
+
+	std::printf("%s: %zu meshes, %zu triangles\n", meshSet.name.c_str(), meshSet.indexLists.size(), triangleCount);
+	std::printf("  %-8s %6s %12s %8s %8s\n", "order", "cache", "Mtri/s", "ACMR", "ATVR");
+
+	std::vector<std::vector<uint32_t>> optimized(meshSet.indexLists.size());
+	bool valid = true;
+
+	for (const auto& [name, optimizer] : OPTIMIZERS)
+	{
+		for (const uint32_t cacheSize : CACHE_SIZES)
+		{
+			double seconds = std::numeric_limits<double>::max();
+
+			for (uint32_t iteration = 0; iteration < iterations; ++iteration)
+			{
+				const Stopwatch stopwatch;
+
+				for (size_t i = 0; i < meshSet.indexLists.size(); ++i)
+				{
+					optimized[i].resize(meshSet.indexLists[i].size());
+					Optimize(optimizer, meshSet.indexLists[i], optimized[i], cacheSize);
+				}
+
+				seconds = std::min(seconds, stopwatch.GetSeconds());
+			}
+
+			// ACMR and ATVR over the whole scene, with the FIFO cache that GPUs implement.
+			size_t vertexTransforms = 0;
+			size_t uniqueVertices = 0;
+
+			for (size_t i = 0; i < optimized.size(); ++i)
+			{
+				const VertexCacheStatistics statistics = AnalyzeVertexCache(optimized[i].data(), optimized[i].size(), cacheSize);
+				vertexTransforms += statistics.vertexTransforms;
+				uniqueVertices += statistics.uniqueVertices;
+				valid = valid && IsTrianglePermutation(meshSet.indexLists[i], optimized[i]);
+			}
+
+			const double acmr = static_cast<double>(vertexTransforms) / static_cast<double>(triangleCount);
+			const double atvr = static_cast<double>(vertexTransforms) / static_cast<double>(uniqueVertices);
+
+			if (optimizer == Optimizer::NONE)
+			{
+				std::printf("  %-8s %6u %12s %8.3f %8.3f\n", name, cacheSize, "-", acmr, atvr);
+			}
+			else
+			{
+				std::printf("  %-8s %6u %12.2f %8.3f %8.3f\n", name, cacheSize, static_cast<double>(triangleCount) / seconds * 1.0e-6, acmr, atvr);
+			}
+		}
+	}
+
+	return valid;
+}
+} // namespace
+
+// Throughput and post-transform cache efficiency of the vertex cache optimizers for cache sizes 16-64, on an H3D model
+// (--model) and on a row-order grid (--grid vertices per side), each also with its triangles shuffled.
+int RunVertexCacheBenchmark(const Options& options)
+{
+	const std::filesystem::path path = options.GetString("model", "../Sponza/sponza_cutout.h3d");
+	const uint32_t gridSize = std::clamp(options.GetUint("grid", 256), 2u, 2048u);
+	const uint32_t iterations = std::max(options.GetUint("iterations", 3), 1u);
+
+	std::vector<MeshSet> meshSets;
+	H3DData model;
+
+	if (model.Load(path.wstring()))
+	{
+		meshSets.push_back(LoadH3DMeshes(model, path.stem().string()));
+		meshSets.push_back(Shuffle(meshSets.back()));
+	}
+	else
+	{
+		std::fprintf(stderr, "Cannot load %s; running the synthetic meshes only.\n", path.string().c_str());
+	}
+
+	meshSets.push_back(GenerateGrid(gridSize));
+	meshSets.push_back(Shuffle(meshSets.back()));
+
+	bool valid = true;
+
+	for (const MeshSet& meshSet : meshSets)
+	{
+		valid = RunMeshSet(meshSet, iterations) && valid;
+	}
+
+	if (!valid)
+	{
+		std::fprintf(stderr, "An optimizer did not output a permutation of the input triangles.\n");
+		return 1;
+	}
+
+	return 0;
+}
+} // namespace vsgl::headless
@@ -0,0 +1,224 @@
+#include "Headless.hpp"
+
+#include "../../MiniEngine/Model/H3DData.h"
+#include "../../MiniEngine/Model/VertexQuantization.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <numbers>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace vsgl::headless
+{
+namespace
+{
+constexpr const char* DEFAULT_MODELS = "../Sponza/sponza.h3d;../Sponza/sponza_cutout.h3d";
+
+#if defined(__AVX2__)
+constexpr const char* DEQUANTIZE_SIMD_NAME = "decode (AVX2)";
+#else
+constexpr const char* DEQUANTIZE_SIMD_NAME = "decode (scalar build)";
+#endif
+
+struct QuantizedMesh
+{
+	std::vector<FloatVertex> vertices;
+	PositionQuantization quantization;
+	std::vector<QuantizedVertex> quantizedVertices;
+	std::vector<FloatVertex> decodedVertices;
+};
+
+struct Errors
+{
+	double position = 0.0;      // Model units.
+	double positionSteps = 0.0; // Quantization steps of the axis.
+	double normal = 0.0;        // Degrees.
+	double tangent = 0.0;
+	double bitangent = 0.0; // Against the stored bitangent, which need not be orthogonal to the normal and the tangent.
+	double texcoord = 0.0;
+	size_t bitangentFlips = 0;
+};
+
+double AngleInDegrees(const float (&a)[3], const float (&b)[3])
+{
+	const double lengthA = std::sqrt(double{a[0]} * a[0] + double{a[1]} * a[1] + double{a[2]} * a[2]);
+	const double lengthB = std::sqrt(double{b[0]} * b[0] + double{b[1]} * b[1] + double{b[2]} * b[2]);
+
+	if (lengthA == 0.0 || lengthB == 0.0)
+	{
+		return 0.0;
+	}
+
+	const double cosine = (double{a[0]} * b[0] + double{a[1]} * b[1] + double{a[2]} * b[2]) / (lengthA * lengthB);
+	return std::acos(std::clamp(cosine, -1.0, 1.0)) * 180.0 / std::numbers::pi;
+}
+
+void AccumulateErrors(const QuantizedMesh& mesh, Errors& errors)
+{
+	for (size_t i = 0; i < mesh.vertices.size(); ++i)
+	{
+		const FloatVertex& source = mesh.vertices[i];
+		const FloatVertex& decoded = mesh.decodedVertices[i];
+
+		for (uint32_t k = 0; k < 3; ++k)
+		{
+			const double error = std::abs(double{decoded.position[k]} - source.position[k]);
+			errors.position = std::max(errors.position, error);
+
+			if (mesh.quantization.scale[k] > 0.0f)
+			{
+				errors.positionSteps = std::max(errors.positionSteps, error / mesh.quantization.scale[k]);
+			}
+		}
+
+		for (uint32_t k = 0; k < 2; ++k)
+		{
+			errors.texcoord = std::max(errors.texcoord, std::abs(double{decoded.texcoord[k]} - source.texcoord[k]));
+		}
+
+		errors.normal = std::max(errors.normal, AngleInDegrees(source.normal, decoded.normal));
+		errors.tangent = std::max(errors.tangent, AngleInDegrees(source.tangent, decoded.tangent));
+
+		const double bitangentAngle = AngleInDegrees(source.bitangent, decoded.bitangent);
+		errors.bitangent = std::max(errors.bitangent, bitangentAngle);
+		errors.bitangentFlips += (bitangentAngle > 90.0) ? 1 : 0;
+	}
+}
+
+template <typename Function>
+double BestSeconds(const uint32_t iterations, const Function& function)
+{
+	double seconds = std::numeric_limits<double>::max();
+
+	for (uint32_t iteration = 0; iteration < iterations; ++iteration)
+	{
+		const Stopwatch stopwatch;
+		function();
+		seconds = std::min(seconds, stopwatch.GetSeconds());
+	}
+
+	return seconds;
+}
+} // namespace
+
+// Quantizes the float vertices of H3D models into QuantizedVertex and reports the size, the encode and decode throughput and the largest errors.
+int RunVertexQuantizationBenchmark(const Options& options)
+{
+	const uint32_t iterations = std::max(options.GetUint("iterations", 20), 1u);
+	std::vector<QuantizedMesh> meshes;
+	std::stringstream paths{options.GetString("models", DEFAULT_MODELS)};
+	std::string path;
+
+	while (std::getline(paths, path, ';'))
+	{
+		H3DData model;
+
+		if (!model.Load(path))
+		{
+			std::fprintf(stderr, "Skipping %s: cannot load the model.\n", path.c_str());
+			continue;
+		}
+
+		for (uint32_t meshIndex = 0; meshIndex < model.GetMeshCount(); ++meshIndex)
+		{
+			if (!model.HasFloatVertexLayout(meshIndex))
+			{
+				std::fprintf(stderr, "Skipping mesh %u of %s: not a float vertex layout.\n", meshIndex, path.c_str());
+				continue;
+			}
+
+			const H3DData::Mesh& mesh = model.GetMesh(meshIndex);
+			QuantizedMesh& quantizedMesh = meshes.emplace_back();
+			quantizedMesh.vertices.resize(mesh.vertexCount);
+			std::memcpy(quantizedMesh.vertices.data(), model.GetVertexData() + mesh.vertexDataByteOffset, mesh.vertexCount * sizeof(FloatVertex));
+
+			float minPos[3] = {std::numeric_limits<float>::max(), std::numeric_limits<float>::max(), std::numeric_limits<float>::max()};
+			float maxPos[3] = {std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest()};
+
+			for (const FloatVertex& vertex : quantizedMesh.vertices)
+			{
+				for (uint32_t k = 0; k < 3; ++k)
+				{
+					minPos[k] = std::min(minPos[k], vertex.position[k]);
+					maxPos[k] = std::max(maxPos[k], vertex.position[k]);
+				}
+			}
+
+			quantizedMesh.quantization = MakePositionQuantization(minPos, maxPos);
+			quantizedMesh.quantizedVertices.resize(mesh.vertexCount);
+			quantizedMesh.decodedVertices.resize(mesh.vertexCount);
+		}
+
+		std::printf("Loaded %s: %u meshes\n", path.c_str(), model.GetMeshCount());
+	}
+
+	size_t vertexCount = 0;
+
+	for (const QuantizedMesh& mesh : meshes)
+	{
+		vertexCount += mesh.vertices.size();
+	}
+
+	if (vertexCount == 0)
+	{
+		std::fprintf(stderr, "No vertices to quantize. Specify --models path[;path...].\n");
+		return 1;
+	}
+
+	const double encodeSeconds = BestSeconds(iterations, [&] {
+		for (QuantizedMesh& mesh : meshes)
+		{
+			QuantizeVertices(mesh.vertices.data(), mesh.vertices.size(), mesh.quantization, mesh.quantizedVertices.data());
+		}
+	});
+
+	// The scalar decoder first, so that the errors and the comparison below are of the SIMD decoder.
+	std::vector<std::vector<FloatVertex>> scalarVertices(meshes.size());
+	const double scalarSeconds = BestSeconds(iterations, [&] {
+		for (size_t i = 0; i < meshes.size(); ++i)
+		{
+			scalarVertices[i].resize(meshes[i].vertices.size());
+			DequantizeVerticesScalar(meshes[i].quantizedVertices.data(), meshes[i].vertices.size(), meshes[i].quantization, scalarVertices[i].data());
+		}
+	});
+
+	const double decodeSeconds = BestSeconds(iterations, [&] {
+		for (QuantizedMesh& mesh : meshes)
+		{
+			DequantizeVertices(mesh.quantizedVertices.data(), mesh.vertices.size(), mesh.quantization, mesh.decodedVertices.data());
+		}
+	});
+
+	Errors errors;
+	double simdDifference = 0.0;
+
+	for (size_t i = 0; i < meshes.size(); ++i)
+	{
+		AccumulateErrors(meshes[i], errors);
+		const float* simd = &meshes[i].decodedVertices[0].position[0];
+		const float* scalar = &scalarVertices[i][0].position[0];
+
+		for (size_t k = 0; k < meshes[i].vertices.size() * sizeof(FloatVertex) / sizeof(float); ++k)
+		{
+			simdDifference = std::max(simdDifference, std::abs(double{simd[k]} - scalar[k]));
+		}
+	}
+
+	const double floatBytes = static_cast<double>(vertexCount * sizeof(FloatVertex));
+	const double quantizedBytes = static_cast<double>(vertexCount * sizeof(QuantizedVertex));
+
+	std::printf("%zu vertices: %zu -> %zu bytes per vertex (%.2fx smaller)\n", vertexCount, sizeof(FloatVertex), sizeof(QuantizedVertex), floatBytes / quantizedBytes);
+	std::printf("  %-22s %10.1f Mvertices/s\n", "encode", vertexCount / encodeSeconds * 1.0e-6);
+	std::printf("  %-22s %10.1f Mvertices/s %8.2f GB/s read %8.2f GB/s written\n", "decode (scalar)", vertexCount / scalarSeconds * 1.0e-6, quantizedBytes / scalarSeconds * 1.0e-9, floatBytes / scalarSeconds * 1.0e-9);
+	std::printf("  %-22s %10.1f Mvertices/s %8.2f GB/s read %8.2f GB/s written\n", DEQUANTIZE_SIMD_NAME, vertexCount / decodeSeconds * 1.0e-6, quantizedBytes / decodeSeconds * 1.0e-9, floatBytes / decodeSeconds * 1.0e-9);
+	std::printf("Max errors: position %.6g (%.3f steps), normal %.4f deg, tangent %.4f deg, texcoord %.6g, bitangent %.4f deg with %zu sign flips\n", errors.position, errors.positionSteps, errors.normal,
+	            errors.tangent, errors.texcoord, errors.bitangent, errors.bitangentFlips);
+	std::printf("SIMD decoder against scalar: max difference %.3g\n", simdDifference);
+	return 0;
+}
+} // namespace vsgl::headless
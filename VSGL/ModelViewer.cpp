@@ -3,13 +3,21 @@
 
 #include "CommandContext.h"
 #include "GameInput.h"
+#include "ModelLoader.h"
 #include "PostEffects.h"
 #include "Renderer.h"
+#include "SystemTime.h"
+#include "Util/CommandLineArg.h"
+#include "glTF.h"
 
 #include <windef.h>
 #include <winuser.h>
 
+#include <algorithm>
+#include <cstdlib>
+#include <limits>
 #include <memory>
+#include <vector>
 
 namespace vsgl
 {
@@ -17,6 +25,88 @@ namespace
 {
 ExpVar g_spotLightIntensity{"Application/Light Intensity", 4000000.0f};
 
+// Parse time of a glTF/GLB file at 1, 4 and 16 threads (-gltf_parse_benchmark <file>).
+// glTF::Asset::Parse() runs its sections on the PPL, so the parallelism is bounded by the current scheduler.
+void BenchmarkGLTFParse(const std::wstring& filePath)
+{
+	constexpr uint32_t THREAD_COUNTS[] = {1, 4, 16};
+	constexpr uint32_t ITERATIONS = 5;
+
+	for (const uint32_t threadCount : THREAD_COUNTS)
+	{
+		concurrency::CurrentScheduler::Create(concurrency::SchedulerPolicy(2, concurrency::MinConcurrency, threadCount, concurrency::MaxConcurrency, threadCount));
+		double seconds = std::numeric_limits<double>::max();
+
+		for (uint32_t i = 0; i < ITERATIONS; ++i)
+		{
+			CpuTimer timer;
+			timer.Start();
+			const glTF::Asset asset{filePath};
+			timer.Stop();
+			seconds = std::min(seconds, timer.GetTime());
+		}
+
+		concurrency::CurrentScheduler::Detach();
+		Utility::Printf(L"glTF parse %ws: %2u threads %9.3f ms\n", filePath.c_str(), threadCount, seconds * 1000.0);
+	}
+}
+
+// Model build time of a glTF/GLB file at 1, 4 and 16 threads (-model_build_benchmark <file>), checking that every
+// thread count produces the same geometry and meshes.
+void BenchmarkModelBuild(const std::wstring& filePath)
+{
+	constexpr uint32_t THREAD_COUNTS[] = {1, 4, 16};
+	constexpr uint32_t ITERATIONS = 3;
+
+	const glTF::Asset asset{filePath};
+	std::vector<uint8_t> referenceGeometry;
+	std::vector<uint8_t> referenceMeshes;
+	std::vector<uint8_t> referenceMeshlets;
+
+	for (const uint32_t threadCount : THREAD_COUNTS)
+	{
+		concurrency::CurrentScheduler::Create(concurrency::SchedulerPolicy(2, concurrency::MinConcurrency, threadCount, concurrency::MaxConcurrency, threadCount));
+		double seconds = std::numeric_limits<double>::max();
+		bool identical = true;
+
+		for (uint32_t i = 0; i < ITERATIONS; ++i)
+		{
+			Renderer::ModelData model;
+			CpuTimer timer;
+			timer.Start();
+			const bool built = Renderer::BuildModel(model, asset);
+			timer.Stop();
+			ASSERT(built, "Failed to build model");
+			seconds = std::min(seconds, timer.GetTime());
+
+			std::vector<uint8_t> meshes;
+			for (Mesh* mesh : model.m_Meshes)
+			{
+				const uint8_t* meshBytes = reinterpret_cast<const uint8_t*>(mesh);
+				meshes.insert(meshes.end(), meshBytes, meshBytes + sizeof(Mesh) + (mesh->numDraws - 1) * sizeof(Mesh::Draw));
+				std::free(mesh);
+			}
+
+			const uint8_t* meshletBytes = reinterpret_cast<const uint8_t*>(model.m_Meshlets.data());
+			const std::vector<uint8_t> meshlets(meshletBytes, meshletBytes + model.m_Meshlets.size() * sizeof(Meshlet));
+
+			if (referenceGeometry.empty())
+			{
+				referenceGeometry = std::move(model.m_GeometryData);
+				referenceMeshes = std::move(meshes);
+				referenceMeshlets = meshlets;
+			}
+			else
+			{
+				identical = identical && model.m_GeometryData == referenceGeometry && meshes == referenceMeshes && meshlets == referenceMeshlets;
+			}
+		}
+
+		concurrency::CurrentScheduler::Detach();
+		Utility::Printf(L"Model build %ws: %2u threads %9.3f ms%ws\n", filePath.c_str(), threadCount, seconds * 1000.0, identical ? L"" : L" (OUTPUT DIFFERS)");
+	}
+}
+
 class ModelViewer : public GameCore::IGameApp
 {
   private:
@@ -47,6 +137,16 @@ void ModelViewer::Startup()
 	m_renderer.Initialize();
 	PostEffects::EnableAdaptation = false;
 
+	if (std::wstring gltfPath; CommandLineArgs::GetString(L"gltf_parse_benchmark", gltfPath))
+	{
+		BenchmarkGLTFParse(gltfPath);
+	}
+
+	if (std::wstring modelPath; CommandLineArgs::GetString(L"model_build_benchmark", modelPath))
+	{
+		BenchmarkModelBuild(modelPath);
+	}
+
 	ASSERT(m_scene.m_opaqueModel.Load(L"../Sponza/sponza.h3d"), "Failed to load model");
 	ASSERT(m_scene.m_opaqueModel.GetMeshCount() > 0, "Model contains no meshes");
 	ASSERT(m_scene.m_cutoutModel.Load(L"../Sponza/sponza_cutout.h3d"), "Failed to load model");